@@ -46,6 +46,25 @@ defmodule Blackgate do
     end
   end
 
+  @doc """
+  Sends a runtime command to the route's running pipeline, for example
+  `%{"command" => "callers-detail", "sink" => 0, "seconds" => 30}`.
+  """
+  @spec send_route_command(String.t(), map()) :: :ok | {:error, term()}
+  def send_route_command(id, command) do
+    with {:ok, supervisor} <- get_route(id),
+         {:ok, handler} <- route_handler(supervisor, id) do
+      :gen_statem.call(handler, {:command, command})
+    end
+  end
+
+  defp route_handler(supervisor, id) do
+    case List.keyfind(Supervisor.which_children(supervisor), {:route_handler, id}, 0) do
+      {_, pid, _, _} when is_pid(pid) -> {:ok, pid}
+      _ -> {:error, :not_running}
+    end
+  end
+
   @spec set_route_status(String.t(), String.t()) :: {:ok, map()} | {:error, term()}
   def set_route_status(id, status) do
     with {:ok, route} <- Db.update_route(id, %{"status" => status}) do
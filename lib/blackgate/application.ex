@@ -46,6 +46,9 @@ defmodule Blackgate.Application do
        child_spec: DynamicSupervisor, strategy: :one_for_one, name: Blackgate.DynamicSupervisor},
       {Registry,
        keys: :unique, name: Blackgate.Registry.MsgHandlers, partitions: runtime_schedulers},
+      # Routes attached to each shared SRT listener, kept apart so a restarted listener finds them
+      {Registry,
+       keys: :duplicate, name: Blackgate.Registry.SharedListenerRoutes, partitions: runtime_schedulers},
       BlackgateWeb.Telemetry,
       # Blackgate.Repo,
       # {Ecto.Migrator,
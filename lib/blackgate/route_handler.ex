@@ -44,6 +44,22 @@ defmodule Blackgate.RouteHandler do
     end
   end
 
+  def handle_event({:call, from}, {:command, command}, :started, %{port: port}) do
+    reply =
+      with {:ok, line} <- Jason.encode(command),
+           true <- Port.command(port, line <> "\n") do
+        :ok
+      else
+        error -> {:error, error}
+      end
+
+    {:keep_state_and_data, [{:reply, from, reply}]}
+  end
+
+  def handle_event({:call, from}, {:command, _command}, _state, _data) do
+    {:keep_state_and_data, [{:reply, from, {:error, :not_started}}]}
+  end
+
   def handle_event(:info, {_port, {:data, info}}, _state, _data) do
     String.split(info, "\n")
     |> Enum.each(fn line ->
@@ -100,7 +116,8 @@ defmodule Blackgate.RouteHandler do
     Port.open({:spawn, cmd}, opts)
   end
 
-  defp get_binary_path do
+  @doc false
+  def get_binary_path do
     if System.get_env("MIX_ENV", "dev") == "dev" do
       "./native/build/blackgate_pipeline"
     else
@@ -143,7 +160,20 @@ defmodule Blackgate.RouteHandler do
     with {:ok, route} <- Db.get_route(route_id, true),
          {:ok, source} <- source_from_record(route),
          {:ok, sinks} <- sinks_from_record(route) do
-      {:ok, %{"source" => source, "sinks" => sinks}}
+      params =
+        %{"source" => source, "sinks" => sinks}
+        |> maybe_add_param(route, "threads")
+        |> maybe_add_param(route, "output")
+        |> maybe_add_param(route, "batch")
+        |> maybe_add_param(route, "admission")
+        |> maybe_add_param(route, "watchdog")
+        |> maybe_add_param(route, "audio-meter")
+        |> maybe_add_param(route, "video-health")
+        |> maybe_add_param(route, "decode")
+        |> maybe_add_param(route, "preview")
+        |> maybe_add_param(route, "delay-ring")
+
+      {:ok, params}
     end
   end
 
@@ -193,6 +223,18 @@ defmodule Blackgate.RouteHandler do
     })
   end
 
+  # "bonding": %{"mode" => "backup", "links" => [...], "stable-timeout-ms" => 80}; the SRT "mode"
+  # (caller/listener) becomes the group's role
+  defp srt_group_props(opts, bonding) do
+    %{"type" => "srtgroup", "links" => Map.get(bonding, "links", [])}
+    |> maybe_add_param(bonding, "mode")
+    |> maybe_add_param(bonding, "stable-timeout-ms")
+    |> Map.put("role", Map.get(opts, "mode", "caller"))
+    |> maybe_add_param(opts, "latency")
+    |> maybe_add_param(opts, "passphrase")
+    |> maybe_add_param(opts, "streamid")
+  end
+
   defp maybe_add_param(params, opts, key) do
     case Map.get(opts, key) do
       nil -> params
@@ -201,6 +243,17 @@ defmodule Blackgate.RouteHandler do
     end
   end
 
+  # Bonded SRT: one socket group over several links (see native/include/srt_group.h)
+  def sink_from_record(%{"schema" => "SRT", "schema_options" => %{"bonding" => bonding} = opts})
+      when is_map(bonding) do
+    props =
+      opts
+      |> Map.take(["filter", "nulls", "pacing", "proxy", "delay"])
+      |> Map.merge(srt_group_props(opts, bonding))
+
+    {:ok, props}
+  end
+
   def sink_from_record(%{"schema" => "SRT", "schema_options" => opts}) do
     props = %{
       "type" => "srtsink",
@@ -218,7 +271,7 @@ defmodule Blackgate.RouteHandler do
         "poll-timeout"
       ])
       |> Enum.filter(fn {key, _} ->
-        key in ["latency"]
+        key in ["latency", "filter", "nulls", "pacing", "proxy", "delay"]
       end)
       |> Enum.into(%{})
 
@@ -228,12 +281,38 @@ defmodule Blackgate.RouteHandler do
   def sink_from_record(%{"schema" => "UDP", "schema_options" => opts}) do
     create_sink("udpsink", opts, [
       "host",
-      "port"
+      "port",
+      "filter",
+      "nulls",
+      "pacing",
+      "fec",
+      "proxy",
+      "delay"
     ])
   end
 
   def sink_from_record(_), do: {:error, :invalid_destination}
 
+  # Shared listener: the caller reaches this route through the per-port listener by stream ID
+  def source_from_record(%{
+        "schema" => "SRT",
+        "schema_options" => %{"shared-listener" => true, "streamid" => stream_id} = opts
+      })
+      when is_binary(stream_id) and stream_id != "" do
+    with {:ok, control} <- Blackgate.SharedListener.ensure_started(opts) do
+      props =
+        %{"type" => "sharedsrt", "control" => control, "streamid" => stream_id}
+        |> maybe_add_param(opts, "passphrase")
+
+      {:ok, props}
+    end
+  end
+
+  def source_from_record(%{"schema" => "SRT", "schema_options" => %{"bonding" => bonding} = opts})
+      when is_map(bonding) do
+    {:ok, srt_group_props(opts, bonding)}
+  end
+
   def source_from_record(%{"schema" => "SRT", "schema_options" => opts}) do
     props = %{
       "type" => "srtsrc",
@@ -258,12 +337,20 @@ defmodule Blackgate.RouteHandler do
     {:ok, Map.merge(props, remaining_props)}
   end
 
+  # Received by the pipeline's own batched UDP/RTP reader ("udpts"); cleared form fields fall back
+  # to its defaults
   def source_from_record(%{"schema" => "UDP", "schema_options" => opts}) do
-    create_source("udpsrc", opts, [
+    opts = opts |> Enum.reject(fn {_, value} -> value in [nil, ""] end) |> Enum.into(%{})
+
+    create_source("udpts", opts, [
       "address",
       "port",
       "buffer-size",
-      "mtu"
+      "mtu",
+      "multicast-iface",
+      "source-address",
+      "reorder-window",
+      "reorder-ms"
     ])
   end
 
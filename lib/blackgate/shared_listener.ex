@@ -0,0 +1,196 @@
+defmodule Blackgate.SharedListener do
+  @moduledoc """
+  One native SRT listener per port, shared by every route whose SRT source sets
+  `"shared-listener" => true`. Routes register their stream ID with it over a Unix control
+  socket and callers are dispatched to them by stream ID during the SRT handshake
+  (see `native/include/srt_listener.h`).
+
+  The listener is started by the first route that needs it and takes its address, latency and
+  `admission` settings from that route's source options. A later route on the same port whose
+  settings differ is refused with `{:error, {:conflicting_listener_options, keys}}` rather than
+  silently getting the first route's. Passphrases are per route: the listener sets each caller's
+  from the route its stream ID selects.
+
+  Each route holds the listener from `ensure_started/1` until its process exits; the listener
+  stops, and its native process with it, when the last route is gone. Attached routes are kept in
+  `Blackgate.Registry.SharedListenerRoutes`, so a listener restarted after its native process
+  exited still knows them.
+  """
+  use GenServer
+
+  require Logger
+
+  alias Blackgate.Helpers
+  alias Blackgate.RouteHandler
+
+  @spec control_path(integer()) :: String.t()
+  def control_path(port), do: "/tmp/blackgate_listener_#{port}.sock"
+
+  @routes Blackgate.Registry.SharedListenerRoutes
+
+  # Source options the listener itself is configured from; every route on the port must agree on them
+  @listener_keys ["localaddress", "latency", "admission"]
+
+  @doc """
+  Starts the listener for `opts["localport"]` if needed and attaches the calling process to it as a
+  route. Returns the control socket path the route registers its stream ID on.
+  """
+  @spec ensure_started(map()) :: {:ok, String.t()} | {:error, term()}
+  def ensure_started(%{"localport" => port} = opts) when is_integer(port) do
+    supervisor = {:via, PartitionSupervisor, {Blackgate.DynamicSupervisor, {:shared_listener, port}}}
+
+    case DynamicSupervisor.start_child(supervisor, {__MODULE__, opts}) do
+      {:ok, pid} -> attach(pid, opts)
+      {:error, {:already_started, pid}} -> attach(pid, opts)
+      error -> error
+    end
+  end
+
+  def ensure_started(_opts), do: {:error, :missing_localport}
+
+  defp attach(pid, opts) do
+    port = opts["localport"]
+
+    case GenServer.call(pid, {:attach, self(), opts}) do
+      :ok ->
+        if Registry.values(@routes, {:shared_listener, port}, self()) == [] do
+          {:ok, _} = Registry.register(@routes, {:shared_listener, port}, nil)
+        end
+
+        {:ok, control_path(port)}
+
+      error ->
+        error
+    end
+  catch
+    # Its last route went away between start_child and the call: start a fresh listener
+    :exit, {reason, _} when reason in [:noproc, :normal] -> ensure_started(opts)
+  end
+
+  @doc false
+  @spec listener_options(map()) :: map()
+  def listener_options(opts) do
+    opts
+    |> Map.take(@listener_keys)
+    |> Map.update("localaddress", "0.0.0.0", fn address ->
+      if address in [nil, ""], do: "0.0.0.0", else: address
+    end)
+  end
+
+  @doc false
+  @spec conflicting_options(map(), map()) :: [String.t()]
+  def conflicting_options(listener_opts, route_opts) do
+    route_opts = listener_options(route_opts)
+    Enum.filter(@listener_keys, &(Map.get(listener_opts, &1) != Map.get(route_opts, &1)))
+  end
+
+  def child_spec(opts) do
+    %{
+      id: {__MODULE__, opts["localport"]},
+      start: {__MODULE__, :start_link, [opts]},
+      restart: :transient
+    }
+  end
+
+  def start_link(opts) do
+    name = {:via, Registry, {Blackgate.Registry.MsgHandlers, {:shared_listener, opts["localport"]}}}
+    GenServer.start_link(__MODULE__, opts, name: name)
+  end
+
+  @impl true
+  def init(opts) do
+    Process.flag(:trap_exit, true)
+
+    port =
+      Port.open({:spawn_executable, RouteHandler.get_binary_path()}, [
+        :binary,
+        :exit_status,
+        :stderr_to_stdout,
+        :use_stdio,
+        args: ["--listener"]
+      ])
+
+    options = listener_options(opts)
+
+    params = %{
+      "listener" =>
+        %{
+          "localaddress" => options["localaddress"],
+          "localport" => opts["localport"],
+          "control" => control_path(opts["localport"])
+        }
+        |> maybe_put("latency", options["latency"])
+        |> maybe_put("admission", options["admission"])
+    }
+
+    Port.command(port, Jason.encode!(params) <> "\n")
+    Logger.info("SharedListener: started on port #{opts["localport"]}")
+
+    # Empty unless restarted after the native listener exited, when its routes are still attached
+    routes =
+      Registry.lookup(@routes, {:shared_listener, opts["localport"]})
+      |> Map.new(fn {pid, _} -> {pid, Process.monitor(pid)} end)
+
+    {:ok, %{port: port, listen_port: opts["localport"], options: options, routes: routes}}
+  end
+
+  @impl true
+  def handle_call({:attach, pid, opts}, _from, state) do
+    case conflicting_options(state.options, opts) do
+      [] ->
+        routes = Map.put_new_lazy(state.routes, pid, fn -> Process.monitor(pid) end)
+        {:reply, :ok, %{state | routes: routes}}
+
+      keys ->
+        Logger.warning(
+          "SharedListener #{state.listen_port}: refused route with conflicting #{Enum.join(keys, ", ")}; " <>
+            "the listener runs with #{inspect(Map.take(state.options, keys))}"
+        )
+
+        {:reply, {:error, {:conflicting_listener_options, keys}}, state}
+    end
+  end
+
+  @impl true
+  def handle_info({port, {:data, data}}, %{port: port} = state) do
+    Logger.info("SharedListener #{state.listen_port}: #{String.trim_trailing(data)}")
+    {:noreply, state}
+  end
+
+  def handle_info({port, {:exit_status, status}}, %{port: port} = state) do
+    Logger.error("SharedListener #{state.listen_port}: exited with status #{status}")
+    {:stop, {:listener_exited, status}, %{state | port: nil}}
+  end
+
+  def handle_info({:DOWN, _ref, :process, pid, _reason}, state) do
+    routes = Map.delete(state.routes, pid)
+
+    if map_size(routes) == 0 do
+      Logger.info("SharedListener #{state.listen_port}: last route gone, stopping")
+      {:stop, :normal, %{state | routes: routes}}
+    else
+      {:noreply, %{state | routes: routes}}
+    end
+  end
+
+  def handle_info(msg, state) do
+    Logger.warning("SharedListener: unexpected message: #{inspect(msg)}")
+    {:noreply, state}
+  end
+
+  @impl true
+  def terminate(_reason, %{port: port}) when is_port(port) do
+    case Port.info(port, :os_pid) do
+      {:os_pid, pid} -> Helpers.sys_kill(pid)
+      _ -> :ok
+    end
+
+    Port.close(port)
+    :ok
+  end
+
+  def terminate(_reason, _state), do: :ok
+
+  defp maybe_put(map, _key, nil), do: map
+  defp maybe_put(map, key, value), do: Map.put(map, key, value)
+end
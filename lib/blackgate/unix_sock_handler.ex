@@ -10,6 +10,10 @@ defmodule Blackgate.UnixSockHandler do
   alias Blackgate.Metrics
   alias Blackgate.Db
   alias Blackgate.RouteStatsRegistry
+
+  # A stats message is a few KB; anything this long without a newline is not a message
+  @max_partial_message 1_048_576
+
   @impl true
   def start_link(ref, transport, opts) do
     Logger.debug(
@@ -51,14 +55,57 @@ defmodule Blackgate.UnixSockHandler do
       trans: trans,
       source_stream_id: nil,
       route_id: nil,
-      route_record: nil
+      route_record: nil,
+      buffer: ""
     }
 
     :gen_statem.enter_loop(__MODULE__, [hibernate_after: 5_000], :exchange, data)
   end
 
+  # The native process frames every message with a trailing newline; one chunk can carry several
+  # messages or end partway through one, which is kept until the rest arrives.
   @impl true
-  def handle_event(:info, {:tcp, _port, "route_id:" <> route_id}, _state, data) do
+  def handle_event(:info, {:tcp, _port, chunk}, _state, data) when is_binary(chunk) do
+    {messages, rest} = split_messages(Map.get(data, :buffer, "") <> chunk)
+    new_data = Enum.reduce(messages, data, &handle_message/2)
+
+    new_data =
+      cond do
+        byte_size(rest) > @max_partial_message ->
+          Logger.error("Route #{data.route_id}: dropping #{byte_size(rest)} bytes without a message end")
+          Map.put(new_data, :buffer, "")
+
+        rest != "" or Map.has_key?(data, :buffer) ->
+          Map.put(new_data, :buffer, rest)
+
+        true ->
+          new_data
+      end
+
+    if new_data == data, do: :keep_state_and_data, else: {:keep_state, new_data}
+  end
+
+  def handle_event(type, content, state, data) do
+    msg = [
+      {"type", type},
+      {"content", content},
+      {"state", state},
+      {"data", data}
+    ]
+
+    Logger.error("SocketHandler: Undefined msg: #{inspect(msg, pretty: true)}")
+
+    :keep_state_and_data
+  end
+
+  # A connection belongs to one route process, which names itself first; a later route_id: can only
+  # be data that got into the stream (stream IDs come from SRT callers) and must not move the stats
+  defp handle_message("route_id:" <> route_id, %{route_id: current} = data) when is_binary(current) do
+    Logger.error("Route #{current}: ignoring route_id:#{inspect(route_id)} on an identified connection")
+    data
+  end
+
+  defp handle_message("route_id:" <> route_id, data) do
     Logger.info("route_id: #{route_id}")
 
     route_record =
@@ -72,15 +119,10 @@ defmodule Blackgate.UnixSockHandler do
           nil
       end
 
-    {:keep_state, %{data | route_id: route_id, route_record: route_record}}
+    %{data | route_id: route_id, route_record: route_record}
   end
 
-  def handle_event(
-        :info,
-        {:tcp, _port, "{" <> _ = message},
-        _,
-        %{route_record: %{"exportStats" => true}} = data
-      ) do
+  defp handle_message("{" <> _ = message, %{route_record: %{"exportStats" => true}} = data) do
     # Handle potentially concatenated source + sink stats messages
     {source_json, sink_json} = split_stats_message(message)
     
@@ -109,11 +151,10 @@ defmodule Blackgate.UnixSockHandler do
       end
     end
 
-    :keep_state_and_data
+    data
   end
 
-  def handle_event(:info, {:tcp, _port, "{" <> _ = message}, _, %{route_id: route_id} = _data)
-      when is_binary(route_id) do
+  defp handle_message("{" <> _ = message, %{route_id: route_id} = data) when is_binary(route_id) do
     # Handle potentially concatenated source + sink stats messages
     {source_json, sink_json} = split_stats_message(message)
     
@@ -135,16 +176,15 @@ defmodule Blackgate.UnixSockHandler do
       end
     end
     
-    :keep_state_and_data
+    data
   end
 
-  def handle_event(:info, {:tcp, _port, "{" <> _}, _, _) do
+  defp handle_message("{" <> _, data) do
     # ignore stats when no route_id
-    :keep_state_and_data
+    data
   end
 
-  def handle_event(:info, {:tcp, _port, "stats_sink:" <> json}, _state, %{route_id: route_id} = _data)
-      when is_binary(route_id) do
+  defp handle_message("stats_sink:" <> json, %{route_id: route_id} = data) when is_binary(route_id) do
     case Jason.decode(json) do
       {:ok, stats} ->
         sink_index = stats["sink-index"] || 0
@@ -152,30 +192,62 @@ defmodule Blackgate.UnixSockHandler do
       _ ->
         :ok
     end
-    :keep_state_and_data
+    data
   end
 
-  def handle_event(:info, {:tcp, _port, "stats_sink:" <> _}, _, _) do
+  defp handle_message("stats_sink:" <> _, data) do
     # ignore sink stats when no route_id
-    :keep_state_and_data
+    data
   end
 
-  def handle_event(:info, {:tcp, _port, "stats_source_stream_id:" <> stream_id}, _state, data) do
+  # Typed events are pushed the moment they happen; subscribers of "route_events:<route_id>" get
+  # {:route_event, route_id, event} without waiting for the next stats poll
+  defp handle_message("event:" <> json, data) do
+    case Jason.decode(String.trim(json)) do
+      {:ok, %{"event" => type} = event} ->
+        Logger.log(event_level(type), "Route #{data.route_id}: #{type} #{inspect(event)}")
+
+        if is_binary(data.route_id) do
+          Phoenix.PubSub.broadcast(
+            Blackgate.PubSub,
+            "route_events:#{data.route_id}",
+            {:route_event, data.route_id, event}
+          )
+        end
+
+      _ ->
+        Logger.error("Route #{data.route_id}: invalid event #{inspect(json)}")
+    end
+
+    data
+  end
+
+  defp handle_message("stats_source_stream_id:" <> stream_id, data) do
     Logger.info("stats_source_stream_id: #{stream_id}")
-    {:keep_state, %{data | source_stream_id: stream_id}}
+    %{data | source_stream_id: stream_id}
   end
 
-  def handle_event(type, content, state, data) do
-    msg = [
-      {"type", type},
-      {"content", content},
-      {"state", state},
-      {"data", data}
-    ]
+  defp handle_message(message, data) do
+    Logger.error("SocketHandler: Undefined msg: #{inspect(message)} for route #{inspect(data.route_id)}")
+    data
+  end
 
-    Logger.error("SocketHandler: Undefined msg: #{inspect(msg, pretty: true)}")
+  defp event_level(type) when type in ["error", "source-restart-failed"], do: :error
 
-    :keep_state_and_data
+  defp event_level(type) when type in ["warning", "input-stall", "source-lost", "caller-rejected"],
+    do: :warning
+
+  defp event_level(_type), do: :info
+
+  defp split_messages(buffer) do
+    case :binary.split(buffer, "\n", [:global]) do
+      [rest] ->
+        {[], rest}
+
+      parts ->
+        {messages, [rest]} = Enum.split(parts, -1)
+        {Enum.reject(messages, &(&1 == "")), rest}
+    end
   end
 
   @impl true
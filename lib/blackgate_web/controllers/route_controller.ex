@@ -133,6 +133,41 @@ defmodule BlackgateWeb.RouteController do
     |> json(%{data: sink_stats})
   end
 
+  # Lists every caller of a listener destination in its stats for a while, however many are connected
+  def callers_detail(conn, %{"route_id" => route_id} = params) do
+    command =
+      params
+      |> Map.take(["sink", "seconds"])
+      |> Map.put("command", "callers-detail")
+
+    case Blackgate.send_route_command(route_id, command) do
+      :ok ->
+        conn
+        |> put_status(:ok)
+        |> data(%{status: "requested", route_id: route_id})
+
+      {:error, reason} ->
+        conn
+        |> put_status(:unprocessable_entity)
+        |> json(%{error: inspect(reason)})
+    end
+  end
+
+  # Switches the audio metering branch of a route with an "audio-meter" config on or off
+  def audio_meter(conn, %{"route_id" => route_id, "enabled" => enabled}) when is_boolean(enabled) do
+    case Blackgate.send_route_command(route_id, %{"command" => "audio-meter", "enabled" => enabled}) do
+      :ok ->
+        conn
+        |> put_status(:ok)
+        |> data(%{status: if(enabled, do: "enabled", else: "disabled"), route_id: route_id})
+
+      {:error, reason} ->
+        conn
+        |> put_status(:unprocessable_entity)
+        |> json(%{error: inspect(reason)})
+    end
+  end
+
   def bulk_action(conn, %{"action" => action, "route_ids" => route_ids})
       when action in ["start", "stop"] and is_list(route_ids) do
     results =
@@ -202,6 +237,37 @@ defmodule BlackgateWeb.RouteController do
     end
   end
 
+  # Continuous MJPEG preview (multipart/x-mixed-replace). Each viewer is one connection to the
+  # pipeline's preview socket, which serves every viewer from the same encoded frames; 204 when the
+  # route is not running or has no preview.
+  def preview_stream(conn, %{"route_id" => route_id}) do
+    socket_path = "/tmp/blackgate_preview_#{route_id}.sock"
+
+    case :gen_tcp.connect({:local, socket_path}, 0, [:binary, active: false], 2_000) do
+      {:ok, socket} ->
+        conn
+        |> put_resp_content_type("multipart/x-mixed-replace; boundary=bgframe", nil)
+        |> put_resp_header("cache-control", "no-cache, no-store, must-revalidate")
+        |> send_chunked(200)
+        |> relay_preview(socket)
+
+      {:error, _} ->
+        send_resp(conn, 204, "")
+    end
+  end
+
+  # Until the viewer goes away or the pipeline stops sending (closing the socket detaches the viewer)
+  defp relay_preview(conn, socket) do
+    with {:ok, data} <- :gen_tcp.recv(socket, 0, 10_000),
+         {:ok, conn} <- chunk(conn, data) do
+      relay_preview(conn, socket)
+    else
+      _ ->
+        :gen_tcp.close(socket)
+        conn
+    end
+  end
+
   defp route_is_running?(id) do
     case Blackgate.get_route(id) do
       {:ok, _pid} -> true
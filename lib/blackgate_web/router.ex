@@ -38,7 +38,10 @@ defmodule BlackgateWeb.Router do
     get "/routes/:route_id/restart", RouteController, :restart
     get "/routes/:route_id/stats", RouteController, :stats
     get "/routes/:route_id/destination-stats", RouteController, :destination_stats
+    post "/routes/:route_id/callers-detail", RouteController, :callers_detail
+    post "/routes/:route_id/audio-meter", RouteController, :audio_meter
     get "/routes/:route_id/preview", RouteController, :preview
+    get "/routes/:route_id/preview/stream", RouteController, :preview_stream
     post "/routes/bulk-action", RouteController, :bulk_action
     post "/routes/:route_id/clone", RouteController, :clone
     get "/routes/:route_id/destinations", DestinationController, :index
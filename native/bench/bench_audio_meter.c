@@ -0,0 +1,81 @@
+// CPU cost of audio metering per stream: `make bench`
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "audio_meter.h"
+
+#define RATE 48000
+#define AUDIO_SECONDS 60
+#define BUFFER_FRAMES 1024 // One AAC frame
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_meter(TsSimdLevel level, guint channels)
+{
+    if (!audio_meter_set_simd_level(level)) return;
+
+    gsize frames = (gsize)RATE * AUDIO_SECONDS;
+    gfloat *samples = malloc(frames * channels * sizeof(gfloat));
+    srand(42);
+    for (gsize i = 0; i < frames * channels; i++) samples[i] = (gfloat)rand() / RAND_MAX - 0.5f;
+
+    AudioMeter *m = audio_meter_new(RATE, channels);
+    AudioMeterStats stats;
+    double start = now_sec();
+    for (gsize i = 0; i < frames; i += BUFFER_FRAMES) {
+        audio_meter_process(m, samples + i * channels, MIN((gsize)BUFFER_FRAMES, frames - i));
+        if (i % RATE < BUFFER_FRAMES) audio_meter_get_stats(m, &stats); // Once per stats report
+    }
+    double elapsed = now_sec() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "%u ch %u Hz (%s)", channels, RATE, audio_meter_simd_name());
+    printf("%-28s %8.1f x realtime  %6.3f%% of a core  (%.1f LUFS)\n", name, AUDIO_SECONDS / elapsed,
+           100.0 * elapsed / AUDIO_SECONDS, stats.short_term_lufs);
+
+    audio_meter_free(m);
+    free(samples);
+}
+
+static void bench_kernels(TsSimdLevel level)
+{
+    if (!audio_meter_set_simd_level(level)) return;
+
+    static gfloat x[4096];
+    for (guint i = 0; i < G_N_ELEMENTS(x); i++) x[i] = (gfloat)sin(i * 0.01);
+    gsize iterations = 256 * 1024;
+    gdouble sink = 0.0;
+
+    double start = now_sec();
+    for (gsize i = 0; i < iterations; i++) {
+        sink += audio_meter_peak(x, G_N_ELEMENTS(x)) + audio_meter_sum_squares(x, G_N_ELEMENTS(x));
+    }
+    double elapsed = now_sec() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "peak + sum^2 (%s)", audio_meter_simd_name());
+    printf("%-28s %8.2f Gsamples/s  (%.0f)\n", name, (double)iterations * G_N_ELEMENTS(x) / elapsed / 1e9, sink);
+}
+
+int main(void)
+{
+    printf("Audio meter benchmark, %d s of audio in %d-frame buffers\n\n", AUDIO_SECONDS, BUFFER_FRAMES);
+
+    bench_kernels(TS_SIMD_SCALAR);
+    bench_kernels(TS_SIMD_SSE2);
+    bench_kernels(TS_SIMD_AVX2);
+
+    printf("\n");
+    bench_meter(TS_SIMD_SCALAR, 2);
+    bench_meter(TS_SIMD_AVX2, 2);
+    bench_meter(TS_SIMD_AVX2, 6);
+
+    return 0;
+}
@@ -0,0 +1,114 @@
+// Fan-out cost with and without the batching stage: `make bench`
+// Pushes SRT-sized buffers into tee -> N x (queue -> fakesink) and reports CPU time per GB,
+// the number the batching stage is meant to bring down as destinations are added.
+#include <stdio.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#include "buffer_batch.h"
+
+#define CHUNK_SIZE 1316 // One SRT message
+#define BUFFERS 200000  // ~263 MB per run
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double cpu_sec(long *csw)
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    *csw = usage.ru_nvcsw + usage.ru_nivcsw;
+    return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec / 1e6 + usage.ru_stime.tv_sec +
+           usage.ru_stime.tv_usec / 1e6;
+}
+
+static void bench_fanout(guint destinations, gboolean batched)
+{
+    GstElement *pipeline = gst_pipeline_new("bench");
+    GstElement *tee = gst_element_factory_make("tee", NULL);
+    GstElement *head = tee;
+    GstElement *batch = NULL;
+    gst_bin_add(GST_BIN(pipeline), tee);
+
+    if (batched) {
+        batch = gst_element_factory_make("bgbatch", NULL);
+        // The producer below never pauses, so lists fill by count well inside the latency bound
+        g_object_set(batch, "max-buffers", 32, NULL);
+        gst_bin_add(GST_BIN(pipeline), batch);
+        gst_element_link(batch, tee);
+        head = batch;
+    }
+
+    for (guint i = 0; i < destinations; i++) {
+        GstElement *queue = gst_element_factory_make("queue", NULL);
+        GstElement *sink = gst_element_factory_make("fakesink", NULL);
+        g_object_set(queue, "max-size-buffers", 0, "max-size-time", (guint64)0, "max-size-bytes", 64 * 1024 * 1024,
+                     NULL);
+        g_object_set(sink, "sync", FALSE, "async", FALSE, NULL);
+        gst_bin_add_many(GST_BIN(pipeline), queue, sink, NULL);
+        gst_element_link_many(tee, queue, sink, NULL);
+    }
+
+    GstPad *src = gst_pad_new("bench-src", GST_PAD_SRC);
+    GstPad *sinkpad = gst_element_get_static_pad(head, "sink");
+    gst_pad_set_active(src, TRUE);
+    gst_pad_link(src, sinkpad);
+    gst_object_unref(sinkpad);
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    gst_pad_push_event(src, gst_event_new_stream_start("bench"));
+    GstSegment segment;
+    gst_segment_init(&segment, GST_FORMAT_BYTES);
+    gst_pad_push_event(src, gst_event_new_segment(&segment));
+
+    GstBuffer *payload = gst_buffer_new_allocate(NULL, CHUNK_SIZE, NULL);
+    gst_buffer_memset(payload, 0, 0x47, CHUNK_SIZE);
+
+    long csw_start, csw_end;
+    double cpu_start = cpu_sec(&csw_start);
+    double wall_start = now_sec();
+
+    for (guint i = 0; i < BUFFERS; i++) {
+        // Fresh buffer sharing the payload memory, as a source would hand over each message
+        gst_pad_push(src, gst_buffer_copy(payload));
+    }
+    gst_pad_push_event(src, gst_event_new_eos());
+
+    GstBus *bus = gst_element_get_bus(pipeline);
+    GstMessage *msg = gst_bus_timed_pop_filtered(bus, GST_CLOCK_TIME_NONE, GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+    if (msg) gst_message_unref(msg);
+    gst_object_unref(bus);
+
+    double wall = now_sec() - wall_start;
+    double cpu = cpu_sec(&csw_end) - cpu_start;
+    double gb = (double)BUFFERS * CHUNK_SIZE / 1e9;
+
+    char name[48];
+    snprintf(name, sizeof(name), "%u destinations, %s", destinations, batched ? "batched" : "per-buffer");
+    printf("%-32s %8.2f CPU-s/GB  %8.2f GB/s  %10ld context switches\n", name, cpu / gb, gb / wall,
+           csw_end - csw_start);
+
+    gst_buffer_unref(payload);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_pad_set_active(src, FALSE);
+    gst_object_unref(src);
+    gst_object_unref(pipeline);
+}
+
+int main(int argc, char *argv[])
+{
+    gst_init(&argc, &argv);
+    buffer_batch_register();
+
+    guint counts[] = {1, 8, 32};
+    for (guint i = 0; i < G_N_ELEMENTS(counts); i++) {
+        bench_fanout(counts[i], FALSE);
+        bench_fanout(counts[i], TRUE);
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+// Throughput benchmark for 2022-1 FEC generation: `make bench`
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fec.h"
+
+#define STREAM_PACKETS (64 * 1024) // ~86 MB of 1316-byte media payloads
+#define ROUNDS 10
+#define OUTPUT_MBPS 20.0
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void count_packet(FecStream stream, const guint8 *packet, gsize len, gpointer user_data)
+{
+    (void)stream;
+    (void)packet;
+    *(gsize *)user_data += len;
+}
+
+static void bench_encode(TsSimdLevel level, guint columns, guint rows, gboolean row_fec)
+{
+    if (!fec_set_simd_level(level)) return;
+
+    guint8 *data = malloc((gsize)STREAM_PACKETS * FEC_MAX_PAYLOAD);
+    srand(42);
+    for (gsize i = 0; i < (gsize)STREAM_PACKETS * FEC_MAX_PAYLOAD; i++) data[i] = (guint8)rand();
+
+    FecEncoder *enc = fec_encoder_new(columns, rows, row_fec, 1);
+    gsize out_bytes = 0;
+
+    double start = now_sec();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (gsize i = 0; i < STREAM_PACKETS; i++) {
+            fec_encoder_push(enc, data + i * FEC_MAX_PAYLOAD, FEC_MAX_PAYLOAD, (guint32)i, count_packet, &out_bytes);
+        }
+    }
+    double elapsed = now_sec() - start;
+
+    double media_bits = (double)STREAM_PACKETS * FEC_MAX_PAYLOAD * 8 * ROUNDS;
+    char name[64];
+    snprintf(name, sizeof(name), "%ux%u%s (%s)", columns, rows, row_fec ? " + rows" : "", fec_simd_name());
+    printf("%-28s %8.2f Gbit/s media  ~%6.0f x %.0f Mbit/s outputs per core  (%.0f%% overhead)\n", name,
+           media_bits / elapsed / 1e9, media_bits / elapsed / 1e6 / OUTPUT_MBPS, OUTPUT_MBPS,
+           100.0 * ((double)out_bytes * 8 * 1.0 / media_bits - 1.0));
+
+    fec_encoder_free(enc);
+    free(data);
+}
+
+static void bench_xor(TsSimdLevel level)
+{
+    if (!fec_set_simd_level(level)) return;
+
+    static guint8 dst[FEC_MAX_PAYLOAD], src[FEC_MAX_PAYLOAD];
+    memset(src, 0x5A, sizeof(src));
+    gsize iterations = 4 * 1024 * 1024;
+
+    double start = now_sec();
+    for (gsize i = 0; i < iterations; i++) fec_xor(dst, src, FEC_MAX_PAYLOAD);
+    double elapsed = now_sec() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "xor 1316 B (%s)", fec_simd_name());
+    printf("%-28s %8.2f GB/s  (%02x)\n", name, (double)iterations * FEC_MAX_PAYLOAD / elapsed / 1e9, dst[0]);
+}
+
+int main(void)
+{
+    printf("2022-1 FEC benchmark, %d-byte media payloads\n\n", FEC_MAX_PAYLOAD);
+
+    bench_xor(TS_SIMD_SCALAR);
+    bench_xor(TS_SIMD_SSE2);
+    bench_xor(TS_SIMD_AVX2);
+
+    printf("\n");
+    bench_encode(TS_SIMD_SCALAR, 10, 10, TRUE);
+    bench_encode(TS_SIMD_SSE2, 10, 10, TRUE);
+    bench_encode(TS_SIMD_AVX2, 10, 10, TRUE);
+    bench_encode(TS_SIMD_AVX2, 20, 5, FALSE);
+    bench_encode(TS_SIMD_AVX2, 5, 20, TRUE);
+
+    return 0;
+}
@@ -0,0 +1,103 @@
+// Throughput benchmark for the TS sync scanner: `make bench`
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "ts_sync.h"
+
+#define STREAM_PACKETS (256 * 1024) // ~48 MB of 188-byte packets
+#define CHUNK_SIZE 1316             // One SRT message
+#define ROUNDS 10
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void count_packet(const guint8 *pkt, guint16 pid, gpointer user_data)
+{
+    (void)pkt;
+    (void)pid;
+    (*(gsize *)user_data)++;
+}
+
+static guint8 *make_stream(guint stride, gsize *size)
+{
+    *size = (gsize)STREAM_PACKETS * stride;
+    guint8 *data = malloc(*size);
+    srand(42);
+    for (gsize i = 0; i < *size; i++) data[i] = (guint8)rand();
+    for (gsize i = 0; i < STREAM_PACKETS; i++) {
+        guint8 *pkt = data + i * stride;
+        guint16 pid = (guint16)(i % 16 == 0 ? 0 : 0x100 + i % 4);
+        pkt[0] = TS_SYNC_BYTE;
+        pkt[1] = (guint8)(pid >> 8);
+        pkt[2] = (guint8)pid;
+    }
+    return data;
+}
+
+static void bench_feed(const char *name, guint stride, gsize start_offset)
+{
+    gsize size;
+    guint8 *data = make_stream(stride, &size);
+    TsSync ts;
+    gsize delivered = 0;
+
+    ts_sync_init(&ts);
+    ts_sync_filter_add(&ts, 0);
+    ts_sync_filter_add(&ts, 0x101);
+
+    double start = now_sec();
+    for (int r = 0; r < ROUNDS; r++) {
+        ts_sync_reset(&ts);
+        for (gsize off = start_offset; off < size; off += CHUNK_SIZE) {
+            ts_sync_feed(&ts, data + off, MIN((gsize)CHUNK_SIZE, size - off), count_packet, &delivered);
+        }
+    }
+    double elapsed = now_sec() - start;
+
+    printf("%-36s %8.2f GB/s  (%zu delivered, %lu sync losses)\n", name,
+           (double)(size - start_offset) * ROUNDS / elapsed / 1e9, delivered, (unsigned long)ts.sync_losses);
+    free(data);
+}
+
+static void bench_find(TsSimdLevel level)
+{
+    if (!ts_sync_set_simd_level(level)) return;
+
+    // Worst case for resync: a long run with no sync byte at all
+    gsize size = 64 * 1024 * 1024;
+    guint8 *data = malloc(size);
+    memset(data, 0xAA, size);
+
+    double start = now_sec();
+    gsize found = 0;
+    for (int r = 0; r < ROUNDS; r++) found += ts_sync_find(data, size);
+    double elapsed = now_sec() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "sync search, no sync (%s)", ts_sync_simd_name());
+    printf("%-36s %8.2f GB/s  (%zu)\n", name, (double)size * ROUNDS / elapsed / 1e9, found / ROUNDS);
+    free(data);
+}
+
+int main(void)
+{
+    printf("TS sync benchmark, %d-byte chunks, sync search: %s\n\n", CHUNK_SIZE, ts_sync_simd_name());
+
+    bench_feed("188, aligned", TS_PACKET_SIZE, 0);
+    bench_feed("188, misaligned (+61)", TS_PACKET_SIZE, 61);
+    bench_feed("192 (M2TS), misaligned (+4)", TS_M2TS_PACKET_SIZE, 4);
+    bench_feed("204 (RS), aligned", TS_RS_PACKET_SIZE, 0);
+
+    printf("\n");
+    bench_find(TS_SIMD_SCALAR);
+    bench_find(TS_SIMD_SSE2);
+    bench_find(TS_SIMD_AVX2);
+
+    return 0;
+}
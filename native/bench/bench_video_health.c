@@ -0,0 +1,58 @@
+// CPU cost of black/freeze detection on the thumbnail frames: `make bench`
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "video_health.h"
+
+#define WIDTH 320
+#define HEIGHT 180
+#define FRAMES 30000 // 20 minutes at 25 fps
+#define VIDEO_SECONDS (FRAMES / 25)
+
+static double now_sec(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_detector(TsSimdLevel level, guint8 *frames[2])
+{
+    if (!video_health_set_simd_level(level)) return;
+
+    VideoHealth *vh = video_health_new(NULL);
+    VideoHealthStats stats;
+    double start = now_sec();
+    for (guint i = 0; i < FRAMES; i++) {
+        video_health_frame(vh, frames[i & 1], WIDTH, HEIGHT, WIDTH, (gint64)i * 40000);
+        if (i % 25 == 0) video_health_get_stats(vh, (gint64)i * 40000, &stats); // Once per stats report
+    }
+    double elapsed = now_sec() - start;
+
+    char name[64];
+    snprintf(name, sizeof(name), "%dx%d (%s)", WIDTH, HEIGHT, video_health_simd_name());
+    printf("%-28s %8.0f frames/s  %6.3f%% of a core at 25 fps  (motion %.1f)\n", name, FRAMES / elapsed,
+           100.0 * elapsed / VIDEO_SECONDS, stats.motion);
+    video_health_free(vh);
+}
+
+int main(void)
+{
+    printf("Video health benchmark, %d frames\n\n", FRAMES);
+
+    guint8 *frames[2];
+    srand(42);
+    for (int f = 0; f < 2; f++) {
+        frames[f] = malloc(WIDTH * HEIGHT);
+        for (int i = 0; i < WIDTH * HEIGHT; i++) frames[f][i] = (guint8)(rand() & 0xff);
+    }
+
+    bench_detector(TS_SIMD_SCALAR, frames);
+    bench_detector(TS_SIMD_SSE2, frames);
+    bench_detector(TS_SIMD_AVX2, frames);
+
+    free(frames[0]);
+    free(frames[1]);
+    return 0;
+}
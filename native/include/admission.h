@@ -0,0 +1,50 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+#include "admission_stats.h"
+
+// Admission control for SRT listeners, decided in the handshake callback before any crypto or
+// buffer setup, so a caller that keeps reconnecting costs a few hash lookups per attempt.
+//
+// Route-level "admission" config (the shared listener reads it from "listener": {"admission": ...}):
+// {"allow-stream-ids": ["cam1"], "allow-ips": ["10.1.0.0/16", "192.0.2.7"], "allow-list-file": "/etc/bg/allow.json",
+//  "rate": 5, "burst": 10, "per-ip-rate": 1, "per-ip-burst": 3, "max-callers": 4}
+// An empty allow-list admits everything. "allow-list-file" holds the same two lists as a JSON object and
+// is added to the inline ones; it is re-read whenever its modification time changes.
+// Rates are handshakes per second (0 disables the limit); the bursts default to the rates.
+
+typedef struct Admission Admission;
+
+// Returns NULL if the config is present but invalid. A NULL config admits every caller;
+// accepted callers are still counted for the stats.
+Admission *admission_new(cJSON *config);
+void admission_free(Admission *adm);
+
+// `ip` is the textual peer address (IPv4-mapped IPv6 is treated as IPv4), `stream_id` may be NULL,
+// `now_us` is a monotonic timestamp. Checks run cheapest-first: per-IP rate, stream ID syntax,
+// allow-lists, max-callers, then the global rate, so callers that are refused anyway never use up
+// global tokens.
+AdmissionResult admission_check(Admission *adm, const char *ip, const char *stream_id, gint64 now_us);
+
+// An accepted caller counts against max-callers from caller_added until caller_removed
+void admission_caller_added(Admission *adm);
+void admission_caller_removed(Admission *adm);
+
+// Re-read allow-list-file if it changed; the current lists stay in force if the new file is invalid
+void admission_reload_if_changed(Admission *adm);
+
+const char *admission_result_name(AdmissionResult result);
+
+// FALSE if a stream ID holds control characters. Stream IDs come from the caller and end up in
+// newline-framed control socket messages, so only IDs that pass may be written there.
+gboolean admission_stream_id_is_safe(const char *stream_id);
+
+void admission_get_stats(Admission *adm, AdmissionStats *stats);
+
+// Adds an "admission" object: accepted, callers, reloads and one rejected-<reason> counter per reason
+void admission_stats_to_json(const AdmissionStats *stats, cJSON *root);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef ADMISSION_STATS_H
+#define ADMISSION_STATS_H
+
+#include <glib.h>
+
+// Admission outcomes and counters, apart from admission.h so the shared-memory ring (shm_ring.h)
+// can carry them without pulling in cJSON or the admission API.
+
+typedef enum {
+    ADMISSION_ACCEPT,
+    ADMISSION_REJECT_IP_RATE,
+    ADMISSION_REJECT_IP,
+    ADMISSION_REJECT_STREAM_ID,
+    ADMISSION_REJECT_MAX_CALLERS,
+    ADMISSION_REJECT_RATE,
+    ADMISSION_REJECT_MALFORMED, // Stream ID with control characters
+    ADMISSION_RESULT_COUNT,
+} AdmissionResult;
+
+// Plain counters, so the shared listener can copy them into the rings it shares with routes
+typedef struct {
+    guint64 accepted;
+    guint64 rejected[ADMISSION_RESULT_COUNT]; // Indexed by AdmissionResult, [ADMISSION_ACCEPT] unused
+    guint callers;
+    guint64 reloads;
+} AdmissionStats;
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef AUDIO_METER_H
+#define AUDIO_METER_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+#include "ts_sync.h"
+
+// Audio presence and loudness metering for one decoded audio stream (route "audio-meter" config).
+//
+// Per channel it keeps the sample peak and RMS since the previous report, and per stream the EBU
+// R128 momentary (400 ms) and short-term (3 s) loudness: each channel is K-weighted (ITU-R BS.1770
+// pre-filter and RLB high-pass, coefficients derived for the actual sample rate), its mean square
+// is collected in 100 ms blocks, and the loudness is the channel-weighted sum over the last 4 or 30
+// blocks. The peak and sum-of-squares kernels are SSE2/AVX2 where available; the K-weighting
+// biquads are recursive and stay scalar.
+//
+// Process and get_stats may be called from different threads.
+
+#define AUDIO_METER_MAX_CHANNELS 8
+#define AUDIO_METER_FLOOR_DB -120.0    // Reported for digital silence instead of -inf
+#define AUDIO_METER_SILENCE_DBFS -60.0 // A 100 ms block with all channels below this counts as silent
+
+typedef struct AudioMeter AudioMeter;
+
+typedef struct {
+    guint rate;
+    guint channels;
+    gdouble peak_dbfs[AUDIO_METER_MAX_CHANNELS]; // Since the previous report
+    gdouble rms_dbfs[AUDIO_METER_MAX_CHANNELS];
+    gdouble momentary_lufs;
+    gdouble short_term_lufs;
+    guint64 frames;   // Since start
+    gint64 silent_ms; // How long every channel has stayed below AUDIO_METER_SILENCE_DBFS
+} AudioMeterStats;
+
+// NULL for an unsupported layout (no channels, more than AUDIO_METER_MAX_CHANNELS, rate below 8 kHz)
+AudioMeter *audio_meter_new(guint rate, guint channels);
+void audio_meter_free(AudioMeter *m);
+
+// Interleaved 32-bit float samples, `frames` per channel
+void audio_meter_process(AudioMeter *m, const gfloat *samples, gsize frames);
+
+// Loudness as of the last completed block; starts a new peak/RMS window
+void audio_meter_get_stats(AudioMeter *m, AudioMeterStats *stats);
+
+// Adds rate, channels, peak-dbfs and rms-dbfs arrays, momentary-lufs, short-term-lufs and silent-ms
+void audio_meter_stats_to_json(const AudioMeterStats *stats, cJSON *obj);
+
+// Kernels, exposed for tests and benchmarks
+gfloat audio_meter_peak(const gfloat *x, gsize n);         // max |x[i]|
+gdouble audio_meter_sum_squares(const gfloat *x, gsize n); // sum of x[i]^2, accumulated in double
+
+// Force a kernel implementation (tests/benchmarks); FALSE if this CPU lacks it
+gboolean audio_meter_set_simd_level(TsSimdLevel level);
+const char *audio_meter_simd_name(void);
+
+#endif
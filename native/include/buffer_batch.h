@@ -0,0 +1,19 @@
+#ifndef BUFFER_BATCH_H
+#define BUFFER_BATCH_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+// "bgbatch": groups buffers from the source into GstBufferLists of up to max-buffers/max-bytes,
+// never holding a buffer longer than max-latency. Downstream (tee, queue2, the pad probes and the
+// output pool) then pays its per-buffer overhead once per list instead of once per SRT message.
+
+#define BG_TYPE_BUFFER_BATCH (bg_buffer_batch_get_type())
+G_DECLARE_FINAL_TYPE(BgBufferBatch, bg_buffer_batch, BG, BUFFER_BATCH, GstElement)
+
+gboolean buffer_batch_register(void);
+
+// Adds "batch-lists", "batch-buffers" and "batch-avg-size" (buffers per list)
+void buffer_batch_add_stats(GstElement *batch, cJSON *root);
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef CALLER_STATS_H
+#define CALLER_STATS_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+// Per-caller aggregation for listener-mode SRT destinations with many pulling callers. Instead of
+// reflecting every field of every caller into the stats record each second, each report carries
+// the totals over all callers, the CALLER_STATS_TOP_K worst callers by loss and by RTT, and how
+// many callers connected and disconnected since the previous report. Full per-caller detail is
+// only listed while it is small (CALLER_STATS_DETAIL_LIMIT callers) or was requested.
+//
+// Callers are identified by an opaque key that stays valid while the caller is connected (the
+// caller's GSocketAddress in the srtsink stats, kept alive with key_ref). The address string is
+// formatted once, when a caller is first seen.
+
+#define CALLER_STATS_TOP_K 5
+#define CALLER_STATS_DETAIL_LIMIT 16
+
+typedef struct {
+    gint64 packets_sent;
+    gint64 packets_lost;
+    gint64 packets_retransmitted;
+    gint64 packets_dropped;
+    guint64 bytes_sent;
+    gdouble rtt_ms;
+    gdouble send_rate_mbps;
+} CallerSample;
+
+typedef struct CallerStats CallerStats;
+
+// Takes a reference on `key` for as long as the caller is tracked (g_object_ref for socket addresses)
+typedef gpointer (*CallerRefFunc)(gpointer key);
+
+// Writes the printable address of `key` into buf
+typedef void (*CallerFormatFunc)(gpointer key, char *buf, gsize size);
+
+// key_ref/key_unref may be NULL for keys that need no reference
+CallerStats *caller_stats_new(CallerRefFunc key_ref, GDestroyNotify key_unref, CallerFormatFunc format);
+void caller_stats_free(CallerStats *cs);
+
+// One report: begin, update every currently connected caller, end
+void caller_stats_begin(CallerStats *cs);
+void caller_stats_update(CallerStats *cs, gpointer key, const CallerSample *sample);
+
+// Forget callers that were not updated since begin, then add to `root`: connected-callers,
+// callers-connected/-disconnected (since the previous report) and their -total counters, a
+// "callers-aggregate" object, "callers-worst-loss" and "callers-worst-rtt" arrays, and "callers"
+// with one entry per caller if `detail` is set or there are at most CALLER_STATS_DETAIL_LIMIT
+// callers (empty otherwise).
+void caller_stats_end(CallerStats *cs, gboolean detail, cJSON *root);
+
+#endif
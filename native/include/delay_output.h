@@ -0,0 +1,37 @@
+#ifndef DELAY_OUTPUT_H
+#define DELAY_OUTPUT_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+#include "delay_ring.h"
+
+// Time-delayed destinations of a route. Every buffer reaching the tee is stored once in the route's
+// delay ring (see delay_ring.h) and one thread hands each delayed destination its buffers when they
+// are due, pushing straight into the destination's sink (or its first stage) the way an output pool
+// worker does. A destination that blocks holds up the others behind it; udpsink and srtsink are
+// set up not to block (no sync, no waiting for a connection).
+//
+// Per-sink "delay" config: {"delay-ms": 10000}, or just the number of milliseconds.
+
+typedef struct DelayOutput DelayOutput;
+
+// `config` is the route's "delay-ring" config and `max_delay_us` the longest destination delay.
+// With `copy_input` buffers are copied before they are stored: buffers of a shared listener source
+// wrap slots of its shared-memory ring, which must not be held for seconds.
+DelayOutput *delay_output_new(cJSON *config, gint64 max_delay_us, gboolean copy_input);
+void delay_output_free(DelayOutput *out);
+
+// Link a delayed destination to `sinkpad`; FALSE if it cannot be linked or there are too many
+gboolean delay_output_add_dest(DelayOutput *out, GstPad *sinkpad, int sink_index, gint64 delay_us);
+
+// Store one buffer, or each buffer of a list, from the tee's sink pad
+void delay_output_push(DelayOutput *out, GstBuffer *buffer);
+void delay_output_push_list(DelayOutput *out, GstBufferList *list);
+
+// Adds a "delay" object: the ring's bytes, max-bytes, buffers, capacity, clock ("pcr" or "arrival"),
+// resyncs and overruns, and a "destinations" array with sink, delay-ms, buffers, bytes, overruns,
+// lateness-max-ms (since the previous call) and push-errors per delayed destination
+void delay_output_add_stats(DelayOutput *out, cJSON *root);
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef DELAY_RING_H
+#define DELAY_RING_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+#include "ts_sync.h"
+
+// One ring of reference-counted source buffers per route, shared by every time-delayed destination.
+// Each buffer is stored once, stamped with its time on the stream clock, and each destination
+// ("reader") takes it back out when that time plus its own delay has come. A buffer is released
+// once the reader with the longest delay has taken it.
+//
+// The stream clock follows the PCR (the first PID seen carrying one): a buffer's time is
+//
+//     PCR time + offset
+//
+// where offset is the smallest arrival-minus-PCR seen so far, slewed up slowly to follow sender
+// clock drift; buffers between PCRs keep the offset of the last one. Arrival jitter and bursts
+// (SRT retransmissions, recovery after a stall) therefore come out at the rate they were encoded
+// at, and a destination's delay holds to the PCR rather than to when the network delivered.
+// Without a PCR, or after one jumps, the arrival time is used until the clock is re-established.
+//
+// Memory is bounded up front: the ring holds at most max-bytes of buffers (and one entry per 512
+// of those bytes). When it is full the oldest buffer is dropped, and every reader that had not
+// taken it yet counts an overrun.
+//
+// Optional route-level "delay-ring" config, sizing the ring for the longest destination delay:
+// {"max-bitrate": 50000000}
+// - max-bitrate: the highest stream bitrate (bit/s) to hold the longest delay for, plus one second
+
+#define DELAY_RING_MAX_READERS 64
+#define DELAY_RING_MAX_DELAY_MS 300000
+#define DELAY_RING_DEFAULT_MAX_BITRATE 50000000
+#define DELAY_RING_BYTES_PER_ENTRY 512
+
+typedef struct DelayRing DelayRing;
+
+// Takes a new reference to a stored item
+typedef gpointer (*DelayRingRefFunc)(gpointer item);
+
+typedef struct {
+    guint64 buffers;   // Taken
+    guint64 bytes;
+    guint64 overruns;  // Dropped by a full ring before this reader took them
+    gint64 delay_ms;
+    gint64 lateness_max_us; // Largest time past due a buffer was taken at, since the previous call
+} DelayReaderStats;
+
+typedef struct {
+    guint entries;
+    guint64 bytes;
+    guint64 max_bytes;
+    guint capacity;
+    gboolean pcr_clock; // FALSE while on arrival time
+    guint64 resyncs;
+    guint64 overruns;   // Buffers dropped by a full ring
+} DelayRingStats;
+
+// `config` is the route's "delay-ring" (may be NULL) and `max_delay_us` the longest delay of its
+// destinations; `ref`/`unref` manage the stored items. NULL (with a message) if the config is invalid.
+DelayRing *delay_ring_new(cJSON *config, gint64 max_delay_us, DelayRingRefFunc ref, GDestroyNotify unref);
+void delay_ring_free(DelayRing *ring);
+
+// A destination's delay in microseconds from its "delay" config: {"delay-ms": 10000}, or -1 (with
+// a message) if it is invalid
+gint64 delay_ring_parse_delay(cJSON *config);
+
+// Add a reader before the first push; returns its index, or -1 when there are too many
+gint delay_ring_add_reader(DelayRing *ring, gint64 delay_us);
+
+// Store `item` (a reference is taken), whose TS payload `data` arrived at `now_us` (monotonic).
+// Thread-safe against the readers.
+void delay_ring_push(DelayRing *ring, gpointer item, const guint8 *data, gsize size, gint64 now_us);
+
+// The reader's next item if it is due by `now_us` (a new reference), else NULL
+gpointer delay_ring_pop(DelayRing *ring, gint reader, gint64 now_us);
+
+// When the earliest reader's next item is due, or -1 if every reader has taken everything stored
+gint64 delay_ring_next_due(DelayRing *ring);
+
+void delay_ring_get_stats(DelayRing *ring, DelayRingStats *stats);
+// Returns the reader's stats and starts a new lateness window
+void delay_ring_get_reader_stats(DelayRing *ring, gint reader, DelayReaderStats *stats);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef FEC_H
+#define FEC_H
+
+#include <glib.h>
+
+#include "ts_sync.h"
+
+// SMPTE 2022-1 (Pro-MPEG COP3) row/column XOR FEC over RTP-encapsulated TS.
+//
+// Media packets are RTP (payload type 33, 90 kHz timestamps) carrying up to 7 TS packets. They
+// are laid out row by row in an L x D matrix (L columns, D rows). Each column's D packets are
+// protected by one column FEC packet (sent to media port + 2) and, optionally, each row's L
+// packets by one row FEC packet (media port + 4). Any single loss per column or row can be
+// rebuilt; with both, most bursts up to L packets long are recoverable.
+//
+// The encoder and decoder are plain code without GStreamer so the benchmark and the loopback test
+// can drive them directly; bgfecenc (fec_sender.h) puts the encoder in front of a udpsink.
+
+#define FEC_RTP_HEADER_SIZE 12
+#define FEC_HEADER_SIZE 16
+#define FEC_TS_PER_PACKET 7
+#define FEC_MAX_PAYLOAD (FEC_TS_PER_PACKET * TS_PACKET_SIZE)
+#define FEC_MAX_PACKET (FEC_RTP_HEADER_SIZE + FEC_HEADER_SIZE + FEC_MAX_PAYLOAD)
+#define FEC_MEDIA_PT 33
+#define FEC_PT 96
+
+// 2022-1 matrix limits
+#define FEC_MIN_COLUMNS 1
+#define FEC_MAX_COLUMNS 20
+#define FEC_MIN_ROWS 4
+#define FEC_MAX_ROWS 20
+#define FEC_MAX_MATRIX 100
+
+typedef enum {
+    FEC_STREAM_MEDIA,
+    FEC_STREAM_COLUMN,
+    FEC_STREAM_ROW,
+} FecStream;
+
+// Receives each packet the encoder produces; `packet` is valid until the callback returns
+typedef void (*FecPacketFunc)(FecStream stream, const guint8 *packet, gsize len, gpointer user_data);
+
+typedef struct FecEncoder FecEncoder;
+
+typedef struct {
+    guint64 media_packets;
+    guint64 column_packets;
+    guint64 row_packets;
+} FecEncoderStats;
+
+// NULL (with a message) if the matrix is outside the 2022-1 limits
+FecEncoder *fec_encoder_new(guint columns, guint rows, gboolean row_fec, guint32 ssrc);
+void fec_encoder_free(FecEncoder *enc);
+
+// Send `len` bytes of TS (at most FEC_MAX_PAYLOAD) as one media packet, followed by the FEC
+// packets it completes
+void fec_encoder_push(FecEncoder *enc, const guint8 *payload, gsize len, guint32 timestamp, FecPacketFunc func,
+                      gpointer user_data);
+
+void fec_encoder_get_stats(FecEncoder *enc, FecEncoderStats *stats);
+
+// Receiver side: collects media and FEC packets and rebuilds lost media packets
+typedef struct FecDecoder FecDecoder;
+
+typedef struct {
+    guint64 media_packets;
+    guint64 fec_packets;
+    guint64 recovered;
+} FecDecoderStats;
+
+FecDecoder *fec_decoder_new(void);
+void fec_decoder_free(FecDecoder *dec);
+
+// Feed one received RTP packet of the given stream; recovery is attempted as FEC arrives
+void fec_decoder_push(FecDecoder *dec, FecStream stream, const guint8 *packet, gsize len);
+
+// The media RTP packet with sequence number `seq`, received or recovered, or NULL. Only the last
+// FEC_DECODER_WINDOW sequence numbers are kept.
+#define FEC_DECODER_WINDOW 1024
+const guint8 *fec_decoder_get(FecDecoder *dec, guint16 seq, gsize *len);
+
+void fec_decoder_get_stats(FecDecoder *dec, FecDecoderStats *stats);
+
+// dst ^= src over len bytes, with the widest instruction set the CPU supports (see ts_sync.h)
+void fec_xor(guint8 *dst, const guint8 *src, gsize len);
+gboolean fec_set_simd_level(TsSimdLevel level);
+const char *fec_simd_name(void);
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef FEC_SENDER_H
+#define FEC_SENDER_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+// "bgfecenc": SMPTE 2022-1 FEC for a UDP destination (see fec.h), placed right in front of the
+// udpsink. Incoming TS is packed seven packets to a media RTP packet on "src"; column and row FEC
+// packets leave on "fec_col" and "fec_row", which the pipeline links to their own udpsinks at
+// port + 2 and port + 4. Every input buffer is sent out in full, so the element adds no latency
+// beyond the XOR work.
+
+#define BG_TYPE_FEC_SENDER (bg_fec_sender_get_type())
+G_DECLARE_FINAL_TYPE(BgFecSender, bg_fec_sender, BG, FEC_SENDER, GstElement)
+
+gboolean fec_sender_register(void);
+
+// Apply the sink's "fec" config, {"columns": 10, "rows": 10, "row": true}; FALSE if it is invalid
+gboolean fec_sender_configure(GstElement *sender, cJSON *config);
+
+// TRUE once configured with row FEC, i.e. when "fec_row" needs a sink
+gboolean fec_sender_has_rows(GstElement *sender);
+
+// Adds the "fec" stats object to `parent`
+void fec_sender_add_stats(GstElement *sender, cJSON *parent);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef GROUP_SINK_H
+#define GROUP_SINK_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+// "bgsrtgroupsink": destination of sink type "srtgroup", sending over a bonded SRT connection
+// (see srt_group.h). The group is dialled or listened on from READY and closed again in NULL.
+// Sends never block: while no link is up, or a link's send buffer is full, messages are dropped
+// and counted, so one stalled destination never holds up the tee.
+
+#define BG_TYPE_SRT_GROUP_SINK (bg_srt_group_sink_get_type())
+G_DECLARE_FINAL_TYPE(BgSrtGroupSink, bg_srt_group_sink, BG, SRT_GROUP_SINK, GstElement)
+
+gboolean group_sink_register(void);
+
+// Apply the whole sink config ("mode", "role", "links", ...); FALSE if it is invalid
+gboolean group_sink_configure(GstElement *sink, cJSON *config);
+
+// Adds the SRT sink stats fields (packets-sent, rtt-ms, ...) and the "bonding" object to `parent`
+void group_sink_add_stats(GstElement *sink, cJSON *parent);
+
+#endif
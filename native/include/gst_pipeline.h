@@ -10,4 +10,7 @@ GstElement *create_pipeline(cJSON *json, const char *route_id);
 void cleanup_pipeline(GstElement *pipeline);
 void print_srt_stats(GstElement *source);
 
+// Runtime commands from the controller, one JSON object per line on stdin after the route config
+void pipeline_handle_command(const char *line);
+
 #endif
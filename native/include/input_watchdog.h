@@ -0,0 +1,60 @@
+#ifndef INPUT_WATCHDOG_H
+#define INPUT_WATCHDOG_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+// Input stall detection: notices a source that stops delivering data without posting an error,
+// so the route can restart just the source element instead of the whole process.
+//
+// Route-level "watchdog" config (or `true` for the defaults):
+// {"stall-ms": 500, "restart": true}
+// The watchdog arms on the first data after the route starts or the source restarts, and fires once
+// no data has reached the tee for stall-ms. It then stays quiet until data flows again, so an idle
+// listener with nobody sending is restarted at most once. "restart": false only reports the stall.
+
+#define INPUT_WATCHDOG_DEFAULT_STALL_MS 1000
+#define INPUT_WATCHDOG_MIN_STALL_MS 50
+#define INPUT_WATCHDOG_MAX_STALL_MS 60000
+
+typedef enum {
+    INPUT_WATCHDOG_NONE,
+    INPUT_WATCHDOG_STALLED, // No data for stall-ms; restart the source if restart is enabled
+    INPUT_WATCHDOG_RESUMED, // First data after a stall
+} InputWatchdogAction;
+
+typedef struct {
+    guint stall_ms;
+    gboolean stalled; // A stall was reported and no data has arrived since
+    guint64 stalls;
+    guint64 restarts;
+    guint64 restart_failures;
+    gint64 last_restart_ms; // How long the last restart took, -1 before the first
+    gint64 last_outage_ms;  // Last data before the last stall to first data after it, -1 before the first
+} InputWatchdogStats;
+
+typedef struct InputWatchdog InputWatchdog;
+
+// NULL (with a message) if the config is invalid; `config` is an object or `true`
+InputWatchdog *input_watchdog_new(cJSON *config);
+void input_watchdog_free(InputWatchdog *wd);
+
+// Called from the streaming thread for every buffer or buffer list; two relaxed atomic accesses
+void input_watchdog_feed(InputWatchdog *wd, gint64 now_us);
+
+// Called periodically from a single thread, every input_watchdog_poll_interval_ms(). `elapsed_ms`
+// receives the silence so far for STALLED and the outage length for RESUMED.
+InputWatchdogAction input_watchdog_poll(InputWatchdog *wd, gint64 now_us, gint64 *elapsed_ms);
+guint input_watchdog_poll_interval_ms(InputWatchdog *wd);
+
+gboolean input_watchdog_restart_enabled(InputWatchdog *wd);
+
+// Record a source restart done after STALLED
+void input_watchdog_restarted(InputWatchdog *wd, gint64 duration_us, gboolean ok);
+
+void input_watchdog_get_stats(InputWatchdog *wd, InputWatchdogStats *stats);
+
+// Adds a "watchdog" object: stall-ms, stalled, stalls, restarts, restart-failures and the last durations
+void input_watchdog_stats_to_json(const InputWatchdogStats *stats, cJSON *root);
+
+#endif
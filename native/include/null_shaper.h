@@ -0,0 +1,21 @@
+#ifndef NULL_SHAPER_H
+#define NULL_SHAPER_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+// "bgnullshaper": per-destination null packet stripping or CBR re-padding placed in front of a
+// sink (see ts_nulls.h). Like bgpidfilter it runs on the destination's own streaming thread.
+
+#define BG_TYPE_NULL_SHAPER (bg_null_shaper_get_type())
+G_DECLARE_FINAL_TYPE(BgNullShaper, bg_null_shaper, BG, NULL_SHAPER, GstElement)
+
+gboolean null_shaper_register(void);
+
+// Apply the sink's "nulls" config; FALSE if it is invalid
+gboolean null_shaper_configure(GstElement *shaper, cJSON *config);
+
+// Adds the "nulls" stats object (see ts_nulls_stats_to_json) to `parent`
+void null_shaper_add_stats(GstElement *shaper, cJSON *parent);
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef OUTPUT_POOL_H
+#define OUTPUT_POOL_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+// Output engine in which a small pool of worker threads services every destination of the route,
+// instead of one queue2 thread per destination. Each destination keeps its own bounded queue;
+// a destination is serviced by at most one worker at a time, so its packet order is preserved.
+// Workers take destinations from their own run queue first and steal from the others when idle.
+// Queuing wakes a sleeping worker only when none is awake or the awake ones are inside a slow push,
+// so fast sinks are drained by one worker. A worker stuck in a blocked sink is left to that
+// destination as its own thread and a new worker takes its place.
+
+typedef struct OutputPool OutputPool;
+typedef struct OutputDest OutputDest;
+
+// Workers start as destinations are added, one per destination up to `workers`. workers == 0
+// caps them at the number of online CPUs or 4, whichever is lower.
+OutputPool *output_pool_new(guint workers);
+void output_pool_free(OutputPool *pool);
+
+// Link a new destination to `sinkpad`. When the queue is full the oldest buffer is dropped,
+// so a stalled destination never blocks the source or the other destinations. NULL if the pool
+// is full or no worker could be started.
+OutputDest *output_pool_add_dest(OutputPool *pool, GstPad *sinkpad, const char *name, guint max_buffers,
+                                 guint64 max_bytes);
+
+// Queue one buffer (a reference is taken per destination) and wake a worker if needed
+void output_pool_push(OutputPool *pool, GstBuffer *buffer);
+
+// Same for a buffer list, which stays one queue entry and is pushed downstream with gst_pad_push_list()
+void output_pool_push_list(OutputPool *pool, GstBufferList *list);
+
+// Adds "output-workers", "output-dedicated-threads" and an "output-queues" array (level, high-water mark
+// since the previous call, drops and whether it has its own thread, per destination)
+void output_pool_add_stats(OutputPool *pool, cJSON *root);
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef PACER_H
+#define PACER_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+// "bgpacer": PCR-paced output for one destination (see ts_pacer.h), placed right in front of the
+// sink. Incoming buffers are scheduled under a lock and a task on the source pad sleeps until
+// each packet's departure, pushing at most max-burst packets per buffer. Upstream never blocks
+// on the pacing, so an output pool worker feeding it is not held up either.
+
+#define BG_TYPE_PACER (bg_pacer_get_type())
+G_DECLARE_FINAL_TYPE(BgPacer, bg_pacer, BG, PACER, GstElement)
+
+gboolean pacer_register(void);
+
+// Apply the sink's "pacing" config; FALSE if it is invalid
+gboolean pacer_configure(GstElement *pacer, cJSON *config);
+
+// Adds the "pacing" stats object (see ts_pacer_stats_to_json) to `parent`
+void pacer_add_stats(GstElement *pacer, cJSON *parent);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef PID_FILTER_H
+#define PID_FILTER_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+// "bgpidfilter": per-destination program/PID filter placed in front of a sink (see ts_filter.h).
+// Runs on the destination's own streaming thread (its queue2 or an output pool worker), so
+// filtering one destination never slows down the others.
+
+#define BG_TYPE_PID_FILTER (bg_pid_filter_get_type())
+G_DECLARE_FINAL_TYPE(BgPidFilter, bg_pid_filter, BG, PID_FILTER, GstElement)
+
+gboolean pid_filter_register(void);
+
+// Apply the sink's "filter" config; FALSE if it is invalid
+gboolean pid_filter_configure(GstElement *filter, cJSON *config);
+
+// Appends {"sink", "programs", "pids", "packets-in", "packets-out", "psi-rewrites", "crc-errors"} to `array`
+void pid_filter_add_stats(GstElement *filter, int sink_index, cJSON *array);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef PREVIEW_SERVER_H
+#define PREVIEW_SERVER_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+// Continuous MJPEG preview of a route, encoded once on the thumbnail branch and served to any
+// number of viewers over a Unix socket. Each frame is published once as a complete
+// multipart/x-mixed-replace part (boundary PREVIEW_SERVER_BOUNDARY) in a reference-counted buffer
+// that every viewer sends from; a viewer still sending an older frame when newer ones arrive skips
+// straight to the newest, so a slow viewer never holds back the others or the pipeline. Viewers
+// attach by connecting and detach by closing; the server thread handles both.
+//
+// Optional route-level "preview" config, all keys optional (false turns the stream off):
+// {"fps": 5, "quality": 70, "max-viewers": 16}
+
+#define PREVIEW_SERVER_BOUNDARY "bgframe"
+#define PREVIEW_SERVER_DEFAULT_FPS 5
+#define PREVIEW_SERVER_MAX_FPS 30
+#define PREVIEW_SERVER_DEFAULT_QUALITY 70
+#define PREVIEW_SERVER_DEFAULT_MAX_VIEWERS 16
+#define PREVIEW_SERVER_MAX_VIEWERS 256
+
+typedef struct {
+    guint viewers;         // Attached now
+    guint64 viewers_total; // Attached since start
+    guint64 viewers_refused; // Over max-viewers
+    guint64 frames;        // Published
+    guint64 frames_sent;   // Summed over viewers
+    guint64 frames_skipped; // Replaced by a newer frame before a viewer got to them
+    guint64 bytes_sent;
+    gint64 frame_age_ms;   // Since the last frame was published, -1 before the first
+} PreviewServerStats;
+
+typedef struct PreviewServer PreviewServer;
+
+// Validate the config, listen on `path` (replacing a stale socket) and start the server thread;
+// NULL (with a message) if the config is invalid or the socket cannot be set up
+PreviewServer *preview_server_new(cJSON *config, const char *path);
+// Disconnects every viewer and removes the socket
+void preview_server_free(PreviewServer *server);
+
+guint preview_server_fps(const PreviewServer *server);
+gint preview_server_quality(const PreviewServer *server);
+
+// Copy one JPEG into a new shared frame and wake the server thread; called from the streaming thread
+void preview_server_publish(PreviewServer *server, const guint8 *jpeg, gsize len);
+
+// The newest JPEG (a reference, free with g_bytes_unref), or NULL before the first
+GBytes *preview_server_latest(PreviewServer *server);
+
+void preview_server_get_stats(PreviewServer *server, PreviewServerStats *stats);
+
+// Adds a "preview" object: fps, viewers, viewers-total, viewers-refused, frames, frames-sent,
+// frames-skipped, bytes-sent and frame-age-ms
+void preview_server_stats_to_json(const PreviewServer *server, const PreviewServerStats *stats, cJSON *root);
+
+#endif
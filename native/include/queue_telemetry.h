@@ -0,0 +1,56 @@
+#ifndef QUEUE_TELEMETRY_H
+#define QUEUE_TELEMETRY_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+// Fill-level telemetry for the queue in front of each branch (the queue2 of every destination and
+// the thumbnail queue). The stats thread samples the queue's current-level-* properties several times
+// per report, keeps high-water marks per report window and since start, and derives how fast the
+// backlog is growing, so a destination that falls behind shows up long before its queue overflows.
+//
+// A full queue2 blocks the tee and with it every destination, so reaching a limit is counted as a
+// "full" event. A leaky queue drops instead; its "overrun" signal is counted as a drop.
+
+#define QUEUE_TELEMETRY_SAMPLES_PER_SEC 10
+
+typedef struct {
+    guint64 bytes;
+    guint64 buffers;
+    guint64 time_ns;
+} QueueLevel;
+
+typedef struct {
+    QueueLevel limit; // Configured maximum per dimension, 0 for unlimited
+    QueueLevel current;
+    QueueLevel high;        // Highest level sampled in the current window
+    QueueLevel window_high; // Highest level sampled in the last completed window
+    QueueLevel peak;        // Highest level sampled since start
+    gboolean full;
+    guint64 full_events; // Times the level reached a limit
+
+    guint64 drops;     // Overrun signals of a leaky queue; incremented from the streaming thread
+    guint64 drops_at_window_start;
+    gdouble drop_rate; // Drops per second over the last window
+    gdouble fill_rate; // Bytes per second the level grew over the last window (negative while draining)
+
+    QueueLevel window_start_level;
+    gint64 window_start_us;
+} QueueTelemetry;
+
+void queue_telemetry_init(QueueTelemetry *t, const QueueLevel *limit, gint64 now_us);
+
+// Record one level sample; only called from the sampling thread
+void queue_telemetry_sample(QueueTelemetry *t, const QueueLevel *level);
+
+// Safe to call from any thread
+void queue_telemetry_drop(QueueTelemetry *t);
+
+// Close the current window: publish its high-water marks and rates and start a new one
+void queue_telemetry_end_window(QueueTelemetry *t, gint64 now_us);
+
+// Adds level-*, high-water-*, peak-*, fill-percent, fill-rate-bytes-per-sec, full-events, drops and
+// drops-per-sec as of the last completed window
+void queue_telemetry_to_json(const QueueTelemetry *t, cJSON *obj);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef RTP_REORDER_H
+#define RTP_REORDER_H
+
+#include <glib.h>
+
+// RTP sequence-number reorder and duplicate window for UDP ingest (see udp_source.h).
+//
+// Packets are released strictly in sequence order. A packet that arrives ahead of a gap is held
+// until the gap fills, the window of `window` sequence numbers overflows, or it has waited
+// `max_delay_us`; the sequence numbers given up on then count as lost, and if they turn up
+// afterwards they are dropped as late. Every sequence number seen in the last half of the
+// 16-bit space is remembered, so duplicates are dropped wherever they fall. A jump back by more
+// than a quarter of the sequence space, or `window` late packets in a row, is taken as a restarted
+// sender and the window starts over there.
+//
+// The in-order case emits straight from the caller's buffer; only held packets are copied.
+
+#define RTP_REORDER_MIN_WINDOW 16
+#define RTP_REORDER_MAX_WINDOW 4096
+
+typedef struct RtpReorder RtpReorder;
+
+typedef struct {
+    guint64 packets;    // Released in order
+    guint64 lost;       // Sequence numbers given up on
+    guint64 reordered;  // Arrived after a higher sequence number and were put back in place
+    guint64 duplicates; // Dropped, already seen
+    guint64 late;       // Dropped, arrived after their sequence number had been given up on
+    guint64 resyncs;    // Sender restarts (jumps back beyond the window) and explicit resets
+    guint held;         // Waiting for a gap to fill
+} RtpReorderStats;
+
+typedef void (*RtpReorderEmitFunc)(const guint8 *payload, gsize len, gpointer user_data);
+
+// `window` is a power of two between RTP_REORDER_MIN_WINDOW and RTP_REORDER_MAX_WINDOW; held
+// payloads longer than `max_payload` are cut short. NULL for an invalid window.
+RtpReorder *rtp_reorder_new(guint window, gsize max_payload, gint64 max_delay_us);
+void rtp_reorder_free(RtpReorder *r);
+
+// Offer one packet; it and anything it unblocks are passed to `emit` in sequence order
+void rtp_reorder_push(RtpReorder *r, guint16 seq, const guint8 *payload, gsize len, gint64 now_us,
+                      RtpReorderEmitFunc emit, gpointer user_data);
+
+// Give up on a gap whose first held successor has waited max_delay_us; call between reads
+void rtp_reorder_expire(RtpReorder *r, gint64 now_us, RtpReorderEmitFunc emit, gpointer user_data);
+
+// Release everything held in order and start over at the next packet (new SSRC)
+void rtp_reorder_reset(RtpReorder *r, RtpReorderEmitFunc emit, gpointer user_data);
+
+void rtp_reorder_get_stats(const RtpReorder *r, RtpReorderStats *stats);
+
+#endif
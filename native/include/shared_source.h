@@ -0,0 +1,25 @@
+#ifndef SHARED_SOURCE_H
+#define SHARED_SOURCE_H
+
+#include <cJSON.h>
+#include <gst/gst.h>
+
+#include "srt_stats.h"
+
+// Route side of the shared SRT listener (source type "sharedsrt"):
+// {"type": "sharedsrt", "control": "/tmp/blackgate_listener_9000.sock", "streamid": "cam1", "passphrase": "..."}
+// Registers the stream ID with the listener, maps the ring it hands back and pushes every payload
+// into `appsrc` as a buffer wrapping the ring slot. Reconnects if the listener restarts.
+
+typedef struct SharedSource SharedSource;
+
+SharedSource *shared_source_new(GstElement *appsrc, cJSON *config);
+void shared_source_free(SharedSource *src);
+
+// The listener's figures for the current caller, receiver side; zero while not registered
+void shared_source_get_stats(SharedSource *src, SrtSocketStats *stats);
+
+// Adds connected-callers and a "shared-listener" object (peer, stream ID, ring overruns)
+void shared_source_add_stats(SharedSource *src, cJSON *root);
+
+#endif
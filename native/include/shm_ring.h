@@ -0,0 +1,63 @@
+#ifndef SHM_RING_H
+#define SHM_RING_H
+
+#include <glib.h>
+
+#include "admission_stats.h"
+
+// Single-producer/single-consumer ring of fixed-size slots in shared memory (memfd), with an eventfd
+// for wakeups. The shared listener receives SRT payloads straight into a slot; the route process
+// wraps the slot as a GstBuffer and releases it when the last reference goes away, so the payload
+// is never copied between the two processes. A slot still held downstream is never overwritten:
+// the producer drops the packet and counts an overrun instead.
+
+#define SHM_RING_DEFAULT_SLOTS 16384
+#define SHM_RING_DEFAULT_SLOT_SIZE 1500 // Largest SRT live payload is 1456 bytes
+
+// Connection state and SRT counters for the caller feeding the ring, published by the listener
+// about once a second. Advisory only: fields are read without synchronisation.
+typedef struct {
+    gint connected;
+    char peer[64];
+    char stream_id[512];
+    guint64 callers_accepted;
+    guint64 packets_received;
+    guint64 bytes_received;
+    gint64 packets_lost;
+    gint64 packets_dropped;
+    gdouble rtt_ms;
+    gdouble receive_rate_mbps;
+    gdouble bandwidth_mbps;
+    gint negotiated_latency_ms;
+    AdmissionStats admission; // Listener-wide, refreshed every second
+} ShmRingStats;
+
+typedef struct ShmRing ShmRing;
+
+ShmRing *shm_ring_create(guint slot_count, guint slot_size);
+// Map a ring created by another process; takes ownership of both descriptors
+ShmRing *shm_ring_attach(int memfd, int eventfd);
+void shm_ring_free(ShmRing *ring);
+
+int shm_ring_memfd(ShmRing *ring);
+int shm_ring_eventfd(ShmRing *ring);
+guint shm_ring_slot_count(ShmRing *ring);
+guint shm_ring_slot_size(ShmRing *ring);
+ShmRingStats *shm_ring_stats(ShmRing *ring);
+guint64 shm_ring_overruns(ShmRing *ring);
+
+// Producer: the next free slot, or NULL while it is still held (read the packet elsewhere and count
+// it with shm_ring_drop()). shm_ring_commit() publishes `len` bytes of the reserved slot; call
+// shm_ring_notify() once per batch of commits.
+guint8 *shm_ring_reserve(ShmRing *ring);
+void shm_ring_drop(ShmRing *ring);
+void shm_ring_commit(ShmRing *ring, guint len);
+void shm_ring_notify(ShmRing *ring);
+
+// Consumer: wait up to timeout_ms for a notification, then take ready slots in order until
+// shm_ring_next() returns NULL. Every slot taken must be given back with shm_ring_release().
+gboolean shm_ring_wait(ShmRing *ring, int timeout_ms);
+guint8 *shm_ring_next(ShmRing *ring, guint *len, guint *slot);
+void shm_ring_release(ShmRing *ring, guint slot);
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef SRT_GROUP_H
+#define SRT_GROUP_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+// SRT connection bonding: one logical connection carried by a libsrt socket group over several links.
+// "broadcast" sends every packet on all links and the receiver keeps the first copy of each; "backup"
+// sends on the highest-weight stable link and moves to the next one as soon as the active link has
+// been silent for stable-timeout-ms, without losing packets (the backup link replays its buffer).
+//
+// Source type "srtgroup", or sink type "srtgroup" (element bgsrtgroupsink, see group_sink.h):
+// {"type": "srtgroup", "mode": "backup", "role": "caller", "latency": 200, "passphrase": "...",
+//  "streamid": "cam1", "stable-timeout-ms": 80,
+//  "links": [{"host": "10.0.1.5", "port": 9000, "weight": 10}, {"host": "10.0.2.5", "port": 9000, "weight": 5}]}
+// As caller, "links" are the remote endpoints; each lost link is redialled every
+// SRT_GROUP_RECONNECT_MS. As listener, "links" are local addresses to listen on and the first
+// bonded (or single-link) caller is accepted; its further links join the group inside libsrt.
+// Needs libsrt built with bonding (ENABLE_BONDING); srt_group_start fails otherwise.
+
+#define SRT_GROUP_MAX_LINKS 8
+#define SRT_GROUP_PAYLOAD_SIZE 1316 // 7 TS packets, the live-mode default
+#define SRT_GROUP_RECONNECT_MS 500
+
+typedef enum {
+    SRT_GROUP_BROADCAST,
+    SRT_GROUP_BACKUP,
+} SrtGroupMode;
+
+typedef enum {
+    SRT_LINK_DOWN,       // No member socket for this link
+    SRT_LINK_CONNECTING, // Handshake in progress
+    SRT_LINK_STANDBY,    // Connected, idle backup
+    SRT_LINK_ACTIVE,     // Connected and carrying traffic
+    SRT_LINK_BROKEN,     // Failed, about to be removed from the group
+} SrtLinkState;
+
+typedef struct {
+    char address[64]; // Configured "host:port"
+    char peer[64];    // Remote "host:port" while connected
+    SrtLinkState state;
+    guint16 weight;
+    gdouble rtt_ms;
+    gdouble rate_mbps; // Send rate for a sender, receive rate for a receiver
+    gdouble bandwidth_mbps;
+    gint64 packets_lost;
+    gint64 packets_retransmitted;
+    gint64 packets_dropped;
+    guint64 connects; // Member connections established on this link
+} SrtLinkStats;
+
+typedef struct {
+    SrtGroupMode mode;
+    gboolean connected;
+    guint64 packets; // Messages delivered to, or accepted from, the application
+    guint64 bytes;
+    guint64 send_drops; // Messages dropped while no link was up or the send buffer was full
+    guint64 switches;   // Backup mode: changes of the active link
+    gint negotiated_latency_ms;
+    guint n_links;
+    SrtLinkStats links[SRT_GROUP_MAX_LINKS];
+} SrtGroupStats;
+
+typedef struct SrtGroup SrtGroup;
+
+// Receives each message of a receiving group on the group's worker thread
+typedef void (*SrtGroupRecvFunc)(const guint8 *data, gsize len, gpointer user_data);
+
+// Validate the config; NULL (with a message) if it is invalid. `recv_func` is NULL for a sender.
+SrtGroup *srt_group_new(cJSON *config, SrtGroupRecvFunc recv_func, gpointer user_data);
+void srt_group_free(SrtGroup *group);
+
+// Open the listeners or dial the links and start the worker thread; FALSE if libsrt refuses
+gboolean srt_group_start(SrtGroup *group);
+void srt_group_stop(SrtGroup *group);
+
+// Send `len` bytes as live messages of at most SRT_GROUP_PAYLOAD_SIZE; never blocks. Messages that
+// cannot be queued are counted as send drops. FALSE while no link is connected.
+gboolean srt_group_send(SrtGroup *group, const guint8 *data, gsize len);
+
+void srt_group_get_stats(SrtGroup *group, SrtGroupStats *stats);
+
+const char *srt_group_mode_name(SrtGroupMode mode);
+const char *srt_link_state_name(SrtLinkState state);
+
+// Adds a "bonding" object: mode, connected, switches, send-drops and a "links" array
+void srt_group_stats_to_json(const SrtGroupStats *stats, cJSON *parent);
+
+#endif
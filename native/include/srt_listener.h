@@ -0,0 +1,28 @@
+#ifndef SRT_LISTENER_H
+#define SRT_LISTENER_H
+
+#include <cJSON.h>
+
+// Shared SRT listener: one listener socket per host port serves every route behind it.
+// Route processes register their stream ID over a Unix control socket and receive a shared-memory
+// ring (see shm_ring.h). Callers are matched to routes by stream ID inside the SRT handshake, so
+// unknown or duplicate stream IDs are rejected before the connection exists, and each caller's
+// payload is received directly into its route's ring.
+//
+// Started as `blackgate_pipeline --listener` with a JSON line on stdin:
+// {"listener": {"localaddress": "0.0.0.0", "localport": 9000, "latency": 200,
+//               "control": "/tmp/blackgate_listener_9000.sock", "ring-slots": 16384, "admission": {...}}}
+// "admission" is checked in the handshake before the stream ID lookup (see admission.h); refused callers
+// get SRT_REJX_FORBIDDEN for the allow-lists and SRT_REJX_OVERLOAD for the rate and caller limits.
+// Route control protocol, one line each way:
+//   -> "register <stream-id> [<passphrase>]"
+//   <- "ok" with the ring memfd and eventfd attached (SCM_RIGHTS), or "error <reason>"
+// The passphrase (10 to 79 characters, as libsrt requires) is set on that route's callers only; a caller
+// it cannot be set on is rejected rather than admitted unencrypted.
+// The route is unregistered, and its caller disconnected, when the control connection closes.
+
+#define SRT_LISTENER_CONTROL_FORMAT "/tmp/blackgate_listener_%d.sock"
+
+int srt_listener_run(cJSON *config);
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef SRT_STATS_H
+#define SRT_STATS_H
+
+#include <cJSON.h>
+#include <glib.h>
+#include <srt/srt.h>
+#include <sys/socket.h>
+
+// Direct libsrt statistics for the srtsrc/srtsink elements of a route. The elements' "stats"
+// property builds a fresh GstStructure (and for listeners a GValueArray of one structure per caller)
+// on every read; here each socket is read with srt_bstats into a plain struct, which is cheap
+// enough to sample several times per report and carries the fields the structure leaves out
+// (flight size, congestion window, send and receive buffer depth).
+//
+// The elements do not expose their sockets, so SrtSocketIndex finds them by address. libsrt has no
+// call to list sockets; the index relies on how libsrt 1.4 and 1.5 allocate socket IDs
+// (CUDTUnited::generateSocketID, not part of the API): descending from a random start, wrapping at
+// 2^30. Every socket created since the last refresh then lies between a fresh probe socket and the
+// previous probe; only that range is scanned, and known sockets are dropped once they are closed.
+// srt_socket_index_new checks that two probes come out in that order and gives up otherwise, and
+// the stats fall back to the elements' "stats" property.
+//
+// A listener is matched by its local port (its callers share it), a caller by the remote port and
+// address, a rendezvous by both ports and the address.
+
+#define SRT_STATS_MAX_SOCKETS 1024 // Per endpoint; a listener destination's callers
+#define SRT_ENDPOINT_MAX_ADDRESSES 8
+
+typedef struct {
+    gint64 packets_sent;
+    gint64 packets_received;
+    gint64 packets_sent_lost;
+    gint64 packets_received_lost;
+    gint64 packets_retransmitted;
+    gint64 packets_sent_dropped;
+    gint64 packets_received_dropped;
+    gint64 packets_belated; // Arrived after their play time
+    guint64 bytes_sent;
+    guint64 bytes_received;
+    guint64 bytes_sent_interval; // Since the previous read that cleared the interval
+    guint64 bytes_received_interval;
+    gdouble send_rate_mbps;
+    gdouble receive_rate_mbps;
+    gdouble rtt_ms;
+    gdouble bandwidth_mbps;
+    gint flight_size; // Packets sent and not yet acknowledged
+    gint congestion_window;
+    gint flow_window;
+    gint send_buffer_packets; // Unacknowledged data held for retransmission
+    gint send_buffer_bytes;
+    gint send_buffer_ms;
+    gint receive_buffer_packets; // Waiting for their play time
+    gint receive_buffer_ms;
+    gint reorder_distance;
+    gint send_latency_ms; // Negotiated TSBPD delays
+    gint receive_latency_ms;
+} SrtSocketStats;
+
+// Cumulative counters, current rates and buffer levels; FALSE if the socket is gone. `clear` starts
+// a new interval; only the once-per-report read should clear.
+gboolean srt_socket_stats_read(SRTSOCKET sock, gboolean clear, SrtSocketStats *stats);
+
+// Adds the sender-side fields with the srtsink "stats" names (packets-sent, rtt-ms, send-rate-mbps, ...)
+// plus flight-size, congestion-window, send-buffer-packets/-bytes/-ms
+void srt_socket_stats_sender_to_json(const SrtSocketStats *stats, cJSON *obj);
+// Adds the receiver-side fields with the srtsrc "stats" names (packets-received, receive-rate-mbps, ...)
+// plus packets-belated, receive-buffer-packets/-ms, reorder-distance
+void srt_socket_stats_receiver_to_json(const SrtSocketStats *stats, cJSON *obj);
+
+// Sum of counters and rates over several sockets (a listener's callers); RTT, latency and
+// buffer levels are the worst, flight size and windows the sum
+void srt_socket_stats_accumulate(SrtSocketStats *total, const SrtSocketStats *stats);
+
+typedef enum {
+    SRT_ENDPOINT_CALLER,
+    SRT_ENDPOINT_LISTENER,
+    SRT_ENDPOINT_RENDEZVOUS,
+} SrtEndpointMode;
+
+// Where an element's sockets are: `port` is the local port of a listener and the remote port
+// of a caller or rendezvous, whose peer must also be one of the addresses `host` resolved to
+typedef struct {
+    SrtEndpointMode mode;
+    char host[256];
+    guint16 port;
+    guint16 local_port; // Rendezvous (and a caller with "localport"), 0 if any
+    struct sockaddr_storage addresses[SRT_ENDPOINT_MAX_ADDRESSES];
+    guint n_addresses;
+} SrtEndpoint;
+
+// Parse "srt://host:port?mode=listener&localport=...", the srtsrc/srtsink URI; caller by default
+gboolean srt_endpoint_from_uri(const char *uri, SrtEndpoint *endpoint);
+
+// Resolve `host` of a caller or rendezvous into `addresses`, once at setup since it may block; FALSE
+// if it does not resolve. A listener needs no address and always succeeds.
+gboolean srt_endpoint_resolve(SrtEndpoint *endpoint);
+
+typedef struct SrtSocketIndex SrtSocketIndex;
+
+// Create before the elements open their sockets (before the pipeline leaves NULL): sockets that
+// already exist are not found. NULL if libsrt does not allocate socket IDs as expected.
+SrtSocketIndex *srt_socket_index_new(void);
+void srt_socket_index_free(SrtSocketIndex *index);
+
+// Pick up sockets created and forget sockets closed since the previous refresh; once per report
+void srt_socket_index_refresh(SrtSocketIndex *index);
+
+// Connected sockets of `endpoint` into `socks` (at most `max`); the count, or -1 if the endpoint
+// has no socket at all (a listener that is not listening, a caller that is not connected) or
+// `index` is NULL. A socket belongs to the first endpoint it is looked up for, so two endpoints with
+// the same address (two destinations to one receiver) never report the same socket; `endpoint`
+// must therefore stay at the same address for as long as the index is used.
+gint srt_socket_index_lookup(SrtSocketIndex *index, const SrtEndpoint *endpoint, SRTSOCKET *socks, guint max);
+
+// "ip:port" of the peer
+void srt_socket_peer_to_string(SRTSOCKET sock, char *buf, gsize size);
+
+#endif
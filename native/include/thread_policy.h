@@ -0,0 +1,35 @@
+#ifndef THREAD_POLICY_H
+#define THREAD_POLICY_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+typedef enum {
+    THREAD_ROLE_SOURCE,   // srtsrc/udpsrc streaming thread, and the bgbatch task that pushes its lists
+    THREAD_ROLE_SINK,     // queue2 thread in front of a destination, and a bgpacer output task
+    THREAD_ROLE_ANALYSIS, // stats, thumbnail and decode threads
+} ThreadRole;
+
+// Route-level "threads" config:
+// {"media-cpus": "2-5", "analysis-cpus": "0-1", "policy": "fifo", "priority": 40, "nice": -10, "analysis-nice": 10}
+// Returns FALSE if the config is present but invalid: a malformed CPU list, a CPU beyond CPU_SETSIZE,
+// an unknown policy or an unknown key.
+gboolean thread_policy_configure(cJSON *config);
+
+// Apply the policy for `role` to the calling thread and remember its placement for the stats. What
+// cannot be applied (CPUs not online, real-time scheduling not permitted) is logged and left as it
+// was, except that a media thread denied SCHED_FIFO/SCHED_RR gets the "nice" value instead.
+void thread_policy_apply_self(ThreadRole role, const char *name);
+
+// Drop the calling thread's placement; call it before the thread exits, so that a later thread given
+// the same tid does not show up under this one's name and role. Entries of threads that exited without
+// it are dropped once their tid is gone from /proc/self/task.
+void thread_policy_forget_self(void);
+
+// Add a "threads" array with the placement each thread actually got, a "thread-policy" object with
+// what was configured, plus process-wide thread and context-switch counts
+void thread_policy_add_stats(cJSON *root);
+
+void thread_policy_reset(void);
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <glib.h>
+
+// USDT (SystemTap SDT) probes under the "blackgate" provider, for bpftrace on a live process
+// (see trace/*.bt). Built in when the Makefile finds <sys/sdt.h> (systemtap-sdt-dev) and defines
+// BG_HAVE_SDT; otherwise every probe compiles to nothing.
+//
+// A probe is a single nop plus an ELF note until a tracer attaches. Probes whose arguments cost
+// something to compute are wrapped in BG_TRACE_ENABLED(), which reads the probe's semaphore: the
+// tracer increments it on attach, so the arguments are only computed while someone listens.
+
+// Every probe needs its semaphore; list new probes here
+#define BG_TRACE_PROBES(X)                                                                                            \
+    X(tee_buffer)                                                                                                     \
+    X(pat_parsed)                                                                                                     \
+    X(pmt_parsed)                                                                                                     \
+    X(video_info)                                                                                                     \
+    X(sink_push)                                                                                                      \
+    X(stats_emit)                                                                                                     \
+    X(thumbnail)                                                                                                      \
+    X(caller_connect)                                                                                                 \
+    X(caller_added)                                                                                                   \
+    X(caller_removed)
+
+#ifdef BG_HAVE_SDT
+
+#define _SDT_HAS_SEMAPHORES 1
+#include <sys/sdt.h>
+
+#define BG_TRACE_DECLARE_SEMAPHORE(name) extern unsigned short blackgate_##name##_semaphore;
+BG_TRACE_PROBES(BG_TRACE_DECLARE_SEMAPHORE)
+
+#define BG_TRACE_AVAILABLE 1
+#define BG_TRACE_ENABLED(name) G_UNLIKELY(blackgate_##name##_semaphore)
+#define BG_TRACE1(name, a) DTRACE_PROBE1(blackgate, name, a)
+#define BG_TRACE2(name, a, b) DTRACE_PROBE2(blackgate, name, a, b)
+#define BG_TRACE3(name, a, b, c) DTRACE_PROBE3(blackgate, name, a, b, c)
+#define BG_TRACE4(name, a, b, c, d) DTRACE_PROBE4(blackgate, name, a, b, c, d)
+#define BG_TRACE5(name, a, b, c, d, e) DTRACE_PROBE5(blackgate, name, a, b, c, d, e)
+
+#else
+
+// Arguments are neither evaluated nor reported as unused
+#define BG_TRACE_AVAILABLE 0
+#define BG_TRACE_ENABLED(name) 0
+static inline void bg_trace_discard(int unused, ...)
+{
+    (void)unused;
+}
+#define BG_TRACE_DISCARD(...)                                                                                         \
+    do {                                                                                                              \
+        if (0) bg_trace_discard(0, __VA_ARGS__);                                                                      \
+    } while (0)
+#define BG_TRACE1(name, a) BG_TRACE_DISCARD(a)
+#define BG_TRACE2(name, a, b) BG_TRACE_DISCARD(a, b)
+#define BG_TRACE3(name, a, b, c) BG_TRACE_DISCARD(a, b, c)
+#define BG_TRACE4(name, a, b, c, d) BG_TRACE_DISCARD(a, b, c, d)
+#define BG_TRACE5(name, a, b, c, d, e) BG_TRACE_DISCARD(a, b, c, d, e)
+
+#endif
+
+#endif
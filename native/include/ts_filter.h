@@ -0,0 +1,49 @@
+#ifndef TS_FILTER_H
+#define TS_FILTER_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+#include "ts_sync.h"
+
+// Raw packet-level program/PID filter for one destination (MPTS splitting). Packets are copied
+// or dropped by PID without demuxing; the PAT and the PMTs of the kept programs are reassembled,
+// rewritten to list only what is kept and re-emitted with a fresh CRC32 wherever the input
+// carried them, so the repetition rate is unchanged.
+//
+// Per-sink "filter" config:
+// {"programs": [1, 3], "pids": [256, 257], "keep-pids": [17]}
+// - programs: program numbers to keep (default: every program that keeps at least one PID)
+// - pids: elementary PIDs to keep; PMTs are rewritten to list only these (default: all of them)
+// - keep-pids: extra PIDs passed untouched, e.g. 17 for the SDT
+// A kept program's PCR PID is always carried; if it is not a kept PID itself, only its PCRs are
+// passed, as adaptation-field-only packets. Null packets and everything else are dropped.
+// Until the PAT and the PMTs have been seen, only keep-pids pass.
+
+#define TS_PSI_MAX_SECTION 1024 // PAT/PMT sections are at most 1021 bytes after the length field
+
+typedef struct TsFilter TsFilter;
+
+typedef struct {
+    guint64 packets_in;
+    guint64 packets_out;
+    guint64 psi_rewrites; // Output PAT/PMT sections regenerated after an input change
+    guint64 crc_errors;   // Input PAT/PMT sections dropped for a bad CRC
+    guint programs;       // Programs currently kept
+    guint pids;           // PIDs currently passed, including PAT and PMTs
+} TsFilterStats;
+
+// NULL (with a message) if the config is invalid or selects nothing
+TsFilter *ts_filter_new(cJSON *config);
+void ts_filter_free(TsFilter *filter);
+
+// Filter one buffer of TS (188/192/204-byte packets, any alignment), appending the kept packets
+// to `out` as 188-byte packets. Returns the number of packets appended.
+guint ts_filter_process(TsFilter *filter, const guint8 *data, gsize size, GByteArray *out);
+
+void ts_filter_get_stats(TsFilter *filter, TsFilterStats *stats);
+
+// MPEG-2 CRC32 (polynomial 0x04C11DB7, no reflection), as used by PSI sections
+guint32 ts_crc32(const guint8 *data, gsize len);
+
+#endif
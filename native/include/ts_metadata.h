@@ -0,0 +1,61 @@
+#ifndef TS_METADATA_H
+#define TS_METADATA_H
+
+#include <glib.h>
+
+#include "ts_sync.h"
+
+// Video format of an MPEG-TS input, tracked for as long as the input runs. An encoder failover can
+// switch codec, resolution or framerate mid-stream, so nothing is parsed once and kept:
+//
+// - PAT and PMT are re-read only when their version_number or CRC changes (the CRC too, because a
+//   restarted encoder starts again at version 0), following the PMT and video PIDs as they move
+// - the video PID is only looked at in packets that start a PES, and only up to the first slice;
+//   the parameter sets found there (H.264 SPS, HEVC VPS + SPS, MPEG-2 sequence header) are
+//   fingerprinted, and parsed only when the fingerprint differs from the last one
+//
+// Every packet outside PAT, PMT and the video PID is dropped by the PID filter before any of this.
+
+#define TS_STREAM_TYPE_MPEG2_VIDEO 0x02
+#define TS_STREAM_TYPE_H264 0x1B
+#define TS_STREAM_TYPE_HEVC 0x24
+
+typedef struct {
+    gboolean valid; // FALSE until the first parameter set is parsed
+    guint8 stream_type;
+    gint width;
+    gint height;
+    gint fps_num;
+    gint fps_den;
+    gboolean interlaced;
+    gboolean fps_inferred; // TRUE if the framerate was inferred, not read from the stream
+} TsVideoFormat;
+
+typedef struct {
+    guint64 pat_changes;    // PAT sections parsed because they differed from the last one
+    guint64 pmt_changes;
+    guint64 header_parses;  // Parameter sets parsed because their fingerprint changed
+    guint64 format_changes; // Including the first detection
+} TsMetadataStats;
+
+// Called on the feeding thread when the format changes, first detection included (old_format->valid
+// is FALSE then)
+typedef void (*TsFormatChangeFunc)(const TsVideoFormat *old_format, const TsVideoFormat *new_format,
+                                   gpointer user_data);
+
+typedef struct TsMetadata TsMetadata;
+
+TsMetadata *ts_metadata_new(TsFormatChangeFunc on_change, gpointer user_data);
+void ts_metadata_free(TsMetadata *meta);
+
+// Feed one buffer of the input (any packet alignment). Only one thread may feed.
+void ts_metadata_feed(TsMetadata *meta, const guint8 *data, gsize size);
+
+// Thread-safe against the feeding thread
+void ts_metadata_get_format(TsMetadata *meta, TsVideoFormat *format);
+void ts_metadata_get_stats(TsMetadata *meta, TsMetadataStats *stats);
+
+// "h264", "hevc", "mpeg2" or "unknown"
+const char *ts_metadata_codec_name(guint8 stream_type);
+
+#endif
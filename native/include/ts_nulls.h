@@ -0,0 +1,56 @@
+#ifndef TS_NULLS_H
+#define TS_NULLS_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+#include "ts_sync.h"
+
+// Per-destination null packet (PID 0x1FFF) handling.
+//
+// Per-sink "nulls" config:
+// {"mode": "strip"}                     - drop null packets (VBR out, saves their bandwidth)
+// {"mode": "pad", "bitrate": 8000000}   - drop the input's nulls and re-pad to a constant bitrate
+//
+// Padding is timed by the stream's own PCRs, not the wall clock: the packets between two PCRs of
+// the PCR PID (the first PID seen carrying one, or "pcr-pid") are held, and nulls are spread
+// evenly among them so that the interval carries exactly bitrate * PCR delta bits. The output
+// stays PCR-accurate at the new rate at the cost of one PCR interval (<= 100 ms) of delay.
+// Intervals whose content already exceeds the bitrate are passed unpadded and counted.
+
+#define TS_NULLS_MAX_HOLD 8192 // Packets held between two PCRs before padding is given up for the interval
+
+typedef enum {
+    TS_NULLS_STRIP,
+    TS_NULLS_PAD,
+} TsNullsMode;
+
+typedef struct TsNulls TsNulls;
+
+typedef struct {
+    guint64 packets_in;
+    guint64 packets_out;
+    guint64 nulls_stripped;
+    guint64 nulls_inserted;
+    guint64 overflows;       // PCR intervals above the configured bitrate, passed unpadded
+    guint64 discontinuities; // PCR jumps (or missing PCRs) that interrupted padding
+} TsNullsStats;
+
+// NULL (with a message) if the config is invalid
+TsNulls *ts_nulls_new(cJSON *config);
+void ts_nulls_free(TsNulls *nulls);
+
+TsNullsMode ts_nulls_get_mode(TsNulls *nulls);
+
+// Process one buffer of TS (188/192/204-byte packets, any alignment), appending the output to
+// `out` as 188-byte packets. In pad mode the output lags the input by one PCR interval.
+// Returns the number of packets appended.
+guint ts_nulls_process(TsNulls *nulls, const guint8 *data, gsize size, GByteArray *out);
+
+void ts_nulls_get_stats(TsNulls *nulls, TsNullsStats *stats);
+
+// Adds a "nulls" object to `parent`: mode, bitrate, packet counters, "bytes-saved" (stripped
+// null bytes) and "bytes-padded"
+void ts_nulls_stats_to_json(TsNulls *nulls, const TsNullsStats *stats, cJSON *parent);
+
+#endif
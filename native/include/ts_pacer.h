@@ -0,0 +1,69 @@
+#ifndef TS_PACER_H
+#define TS_PACER_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+#include "ts_sync.h"
+
+// PCR-paced output scheduling for one destination. A clock is recovered from the PCR of the
+// stream (the first PID seen carrying one, or "pcr-pid"): every packet gets the PCR value
+// interpolated between the PCRs around it, and departs at
+//
+//     local departure = PCR time + offset + delay
+//
+// where offset is the smallest arrival-minus-PCR seen so far, slewed up slowly so sender clock
+// drift is followed. Packets that arrive in a burst (SRT retransmissions, recovery after a
+// stall) are therefore sent at the rate they were encoded at, no later than `delay` after they
+// arrived; packets already past their departure are sent at once and counted as late.
+//
+// Per-sink "pacing" config:
+// {"delay-ms": 100, "max-burst": 7, "pcr-pid": 256}
+// - delay-ms: added delay budget; it must cover one PCR interval plus the arrival jitter
+// - max-burst: most packets sent back to back in one buffer (7 = one 1316-byte datagram)
+//
+// Not thread-safe: the caller serialises push/pop (bgpacer holds its lock around both).
+
+#define TS_PACER_MAX_QUEUE 16384 // Scheduled packets; more are dropped (the sink is not keeping up)
+#define TS_PACER_MAX_HOLD 8192   // Packets waiting for the next PCR; more are sent unpaced
+
+typedef struct TsPacer TsPacer;
+
+typedef struct {
+    guint64 packets_in;
+    guint64 packets_out;
+    guint64 late_packets; // Sent after their departure time (arrived too late for the delay)
+    guint64 unpaced;      // Sent without a PCR clock (no PCR yet, or the PCR PID went quiet)
+    guint64 dropped;      // Queue full
+    guint64 resyncs;      // Clock re-established after a PCR discontinuity
+    guint queued;         // Packets scheduled but not yet sent
+    // Inter-departure gap jitter |actual gap - scheduled gap| over the buffers sent since the
+    // previous ts_pacer_get_stats call
+    gdouble gap_jitter_avg_us;
+    gint64 gap_jitter_max_us;
+} TsPacerStats;
+
+// NULL (with a message) if the config is invalid
+TsPacer *ts_pacer_new(cJSON *config);
+void ts_pacer_free(TsPacer *pacer);
+
+// Schedule one buffer of TS (188/192/204-byte packets, any alignment) that arrived at `now_us`
+// (monotonic). Packets are scheduled once the PCR after them has arrived.
+void ts_pacer_push(TsPacer *pacer, const guint8 *data, gsize size, gint64 now_us);
+
+// Departure time of the next scheduled packet, or -1 if there is none
+gint64 ts_pacer_next_departure(TsPacer *pacer);
+
+// Append to `out` the packets due by `now_us`, at most max-burst of them. Returns their count.
+guint ts_pacer_pop(TsPacer *pacer, GByteArray *out, gint64 now_us);
+
+// Drop everything queued or held and forget the clock (flush, or a pipeline restart)
+void ts_pacer_reset(TsPacer *pacer);
+
+// Returns the stats and starts a new gap jitter window
+void ts_pacer_get_stats(TsPacer *pacer, TsPacerStats *stats);
+
+// Adds a "pacing" object to `parent`
+void ts_pacer_stats_to_json(const TsPacerStats *stats, cJSON *parent);
+
+#endif
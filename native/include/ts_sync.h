@@ -0,0 +1,77 @@
+#ifndef TS_SYNC_H
+#define TS_SYNC_H
+
+#include <glib.h>
+
+#define TS_PACKET_SIZE 188
+#define TS_M2TS_PACKET_SIZE 192 // 4-byte timestamp prefix + 188
+#define TS_RS_PACKET_SIZE 204   // 188 + 16 Reed-Solomon parity bytes
+#define TS_MAX_PACKET_SIZE TS_RS_PACKET_SIZE
+#define TS_SYNC_BYTE 0x47
+#define TS_PID_COUNT 8192
+#define TS_NULL_PID 0x1FFF
+
+#define TS_PID(pkt) ((guint16)((((pkt)[1] & 0x1F) << 8) | (pkt)[2]))
+
+#define TS_PCR_HZ G_GUINT64_CONSTANT(27000000)
+#define TS_PCR_WRAP ((G_GUINT64_CONSTANT(1) << 33) * 300) // 27 MHz PCR wraps with its 33-bit base
+
+typedef enum {
+    TS_SIMD_SCALAR,
+    TS_SIMD_SSE2,
+    TS_SIMD_AVX2,
+} TsSimdLevel;
+
+// Called for every packet that passes the PID filter. `pkt` points at the sync byte and is valid
+// for TS_PACKET_SIZE bytes until the callback returns.
+typedef void (*TsPacketFunc)(const guint8 *pkt, guint16 pid, gpointer user_data);
+
+// Sync state for one TS input. Locks onto 188/192/204-byte cadence, keeps it across buffer
+// boundaries and re-acquires it after a sync loss.
+typedef struct {
+    guint packet_size; // Stride between sync bytes, 0 while unlocked
+    guint last_packet_size;
+    guint8 carry[TS_MAX_PACKET_SIZE];
+    guint carry_len; // Bytes of a partial packet (starting at its sync byte) held from the previous buffer
+    guint64 pid_filter[TS_PID_COUNT / 64];
+
+    guint64 packets;
+    guint64 sync_losses;
+    guint64 bytes_skipped;
+} TsSync;
+
+void ts_sync_init(TsSync *ts);
+void ts_sync_reset(TsSync *ts);
+
+void ts_sync_filter_add(TsSync *ts, guint16 pid);
+void ts_sync_filter_remove(TsSync *ts, guint16 pid);
+void ts_sync_filter_clear(TsSync *ts);
+void ts_sync_filter_all(TsSync *ts);
+
+static inline gboolean ts_sync_filter_has(const TsSync *ts, guint16 pid)
+{
+    return (ts->pid_filter[(pid & 0x1FFF) >> 6] >> (pid & 63)) & 1;
+}
+
+// The PCR of a packet's adaptation field in 27 MHz units, FALSE if it carries none
+static inline gboolean ts_packet_pcr(const guint8 *pkt, guint64 *pcr)
+{
+    if (!(pkt[3] & 0x20) || pkt[4] < 7 || !(pkt[5] & 0x10)) return FALSE;
+    guint64 base = ((guint64)pkt[6] << 25) | ((guint64)pkt[7] << 17) | ((guint64)pkt[8] << 9) |
+                   ((guint64)pkt[9] << 1) | (pkt[10] >> 7);
+    *pcr = base * 300 + (((guint64)(pkt[10] & 0x01) << 8) | pkt[11]);
+    return TRUE;
+}
+
+// The sync search picks the widest instruction set the CPU supports; benchmarks can override it
+gboolean ts_sync_set_simd_level(TsSimdLevel level);
+const char *ts_sync_simd_name(void);
+
+// Offset of the first sync byte in data, or size if there is none (SSE2/AVX2 when available)
+gsize ts_sync_find(const guint8 *data, gsize size);
+
+// Feed one buffer; calls func for every complete packet whose PID is in the filter.
+// Returns the number of packets delivered.
+gsize ts_sync_feed(TsSync *ts, const guint8 *data, gsize size, TsPacketFunc func, gpointer user_data);
+
+#endif
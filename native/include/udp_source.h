@@ -0,0 +1,59 @@
+#ifndef UDP_SOURCE_H
+#define UDP_SOURCE_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+#include "rtp_reorder.h"
+
+// UDP and RTP ingest of MPEG-TS, unicast or multicast (source type "udpts"):
+// {"type": "udpts", "address": "239.1.1.1", "port": 5000, "source-address": "10.0.0.5",
+//  "multicast-iface": "eth1", "buffer-size": 16777216, "mtu": 1500, "reorder-window": 256, "reorder-ms": 20}
+// "address" is a multicast group to join (any-source, or source-specific with "source-address") or a
+// local address to bind; IPv4 or IPv6. Reads are batched with recvmmsg into one buffer per batch on
+// the receiver thread. Each datagram is taken as plain TS when it starts with a sync byte, otherwise
+// as RTP: the header is stripped and the payload goes through the reorder/dedupe window of
+// rtp_reorder.h. The socket asks for "buffer-size" bytes (SO_RCVBUFFORCE with CAP_NET_ADMIN, else
+// capped by net.core.rmem_max) and reports kernel drops (SO_RXQ_OVFL).
+
+#define UDP_SOURCE_BATCH 64
+#define UDP_SOURCE_DEFAULT_BUFFER_SIZE (8 * 1024 * 1024)
+#define UDP_SOURCE_DEFAULT_MTU 1500
+#define UDP_SOURCE_DEFAULT_REORDER_WINDOW 256
+#define UDP_SOURCE_DEFAULT_REORDER_MS 20
+
+typedef struct {
+    gboolean rtp;          // The last datagram was RTP
+    gboolean multicast;
+    gint socket_buffer_bytes; // What the kernel granted
+    guint64 datagrams;
+    guint64 reads;        // recvmmsg calls that returned datagrams
+    guint64 bytes;        // TS bytes delivered
+    guint64 socket_drops; // Datagrams the kernel dropped on a full receive buffer
+    guint64 truncated;    // Datagrams longer than "mtu", dropped
+    guint64 invalid;      // Neither TS nor RTP
+    guint64 ssrc_changes;
+    RtpReorderStats rtp_stats;
+    gdouble receive_rate_mbps; // Since the previous udp_source_get_stats
+} UdpSourceStats;
+
+typedef struct UdpSource UdpSource;
+
+// Receives each batch of TS bytes on the receiver thread
+typedef void (*UdpSourceRecvFunc)(const guint8 *data, gsize len, gpointer user_data);
+
+// Validate the config; NULL (with a message) if it is invalid
+UdpSource *udp_source_new(cJSON *config, UdpSourceRecvFunc recv_func, gpointer user_data);
+void udp_source_free(UdpSource *src);
+
+// Open the socket, join the group and start the receiver thread; FALSE if the socket cannot be set up
+gboolean udp_source_start(UdpSource *src);
+void udp_source_stop(UdpSource *src);
+
+void udp_source_get_stats(UdpSource *src, UdpSourceStats *stats);
+
+// Adds a "udp-ingest" object: address, port, source-address, rtp, socket-buffer-bytes, the
+// datagram, drop and RTP reorder counters
+void udp_source_stats_to_json(UdpSource *src, const UdpSourceStats *stats, cJSON *root);
+
+#endif
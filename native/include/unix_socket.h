@@ -7,6 +7,7 @@
 extern int sock;
 
 void init_unix_socket(const char *socket_path);
+// One message, sent whole; messages end with a newline so the controller can split a read that holds several
 void send_message_to_unix_socket(const char *message);
 void cleanup_socket(void);
 
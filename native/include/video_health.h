@@ -0,0 +1,62 @@
+#ifndef VIDEO_HEALTH_H
+#define VIDEO_HEALTH_H
+
+#include <cJSON.h>
+#include <glib.h>
+
+#include "ts_sync.h"
+
+// Black-frame and frozen-frame detection on the thumbnail branch's 320x180 frames, so it costs no
+// decoding of its own. Each frame's luma plane gives a mean and standard deviation (black: dark and
+// flat) and a sum of absolute differences against the previous frame (frozen: nothing moves).
+// A picture counts as black or frozen once the condition has held for min-duration-ms.
+//
+// Optional route-level "video-health" config, all keys optional:
+// {"black-luma": 32, "black-max-stddev": 8, "freeze-max-diff": 0.5, "min-duration-ms": 2000}
+// freeze-max-diff is the mean absolute luma difference per pixel below which a frame is unchanged.
+
+#define VIDEO_HEALTH_DEFAULT_BLACK_LUMA 32
+#define VIDEO_HEALTH_DEFAULT_BLACK_MAX_STDDEV 8.0
+#define VIDEO_HEALTH_DEFAULT_FREEZE_MAX_DIFF 0.5
+#define VIDEO_HEALTH_DEFAULT_MIN_DURATION_MS 2000
+#define VIDEO_HEALTH_MIN_DURATION_MS_MAX 600000
+
+typedef struct VideoHealth VideoHealth;
+
+typedef struct {
+    gboolean black;       // Black for at least min-duration-ms
+    gboolean frozen;      // Unchanged for at least min-duration-ms
+    gint64 black_ms;      // Length of the current black run, 0 if the last frame was not black
+    gint64 frozen_ms;     // Length of the current unchanged run
+    guint64 black_events; // Times the picture became black
+    guint64 freeze_events;
+    gdouble luma_mean; // Of the last frame
+    gdouble luma_stddev;
+    gdouble motion; // Mean absolute luma difference per pixel between the last two frames
+    guint64 frames;
+    gint64 frame_age_ms; // Since the last frame was analysed, -1 before the first
+} VideoHealthStats;
+
+// `config` may be NULL or `true` for the defaults; NULL (with a message) if it is invalid
+VideoHealth *video_health_new(cJSON *config);
+void video_health_free(VideoHealth *vh);
+
+// Analyse one frame's 8-bit luma plane; called from the streaming thread
+void video_health_frame(VideoHealth *vh, const guint8 *luma, guint width, guint height, guint stride,
+                        gint64 now_us);
+
+void video_health_get_stats(VideoHealth *vh, gint64 now_us, VideoHealthStats *stats);
+
+// Adds a "video-health" object: state (ok, black or frozen), black-ms, frozen-ms, the event
+// counters, luma-mean, luma-stddev, motion, frames and frame-age-ms
+void video_health_stats_to_json(const VideoHealthStats *stats, cJSON *root);
+
+// Kernels, exposed for tests and benchmarks
+void video_health_luma_sums(const guint8 *p, gsize n, guint64 *sum, guint64 *sum_sq);
+guint64 video_health_sad(const guint8 *a, const guint8 *b, gsize n);
+
+// Force a kernel implementation (tests/benchmarks); FALSE if this CPU lacks it
+gboolean video_health_set_simd_level(TsSimdLevel level);
+const char *video_health_simd_name(void);
+
+#endif
@@ -0,0 +1,900 @@
+// Host-scale soak: starts more and more blackgate_pipeline routes on this machine, all fed the same
+// synthetic MPEG-TS over loopback UDP, until delivery or output latency targets are missed, and
+// reports the last step that met them (the knee). `make soak SOAK_ARGS="..."`, or --help.
+//
+// One encoder (videotestsrc ! x264enc ! mpegtsmux, or null packets with --no-video) is shared by all
+// routes, so the harness' own cost barely grows with the route count; it is reported per step anyway.
+// Every 10 ms a probe packet on PID 0x1FF0 carries a sequence number and the send time. Routes pass
+// it through untouched; the receiver thread matches it on every destination for latency and loss.
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <cJSON.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <gst/app/gstappsink.h>
+#include <gst/gst.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/utsname.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TS_PACKET 188
+#define DATAGRAM_PACKETS 7
+#define PROBE_PID 0x1FF0
+#define NULL_PID 0x1FFF
+#define PROBE_INTERVAL_NS 10000000LL
+#define PROBE_MAGIC "BGSOAK"
+#define GRACE_MS 500 // Probes sent at the end of a window may still be in a route's queues
+#define MAX_DESTINATIONS 8
+#define RECV_BUFFER_BYTES (4 * 1024 * 1024)
+
+typedef struct {
+    const char *pipeline_path;
+    const char *label;
+    const char *json_path;
+    int start;
+    int step;
+    int max_routes;
+    int destinations;
+    gboolean thumbnails;
+    gboolean video;
+    gboolean verbose;
+    int bitrate_kbps;
+    int width;
+    int height;
+    int warmup_s;
+    int duration_s;
+    double max_p99_ms;
+    double min_delivery_percent;
+    int base_port;
+} SoakConfig;
+
+typedef enum { FD_DESTINATION, FD_CONTROL_LISTEN, FD_CONTROL_CLIENT } FdKind;
+
+typedef struct Route Route;
+
+// Everything the receiver thread waits on
+typedef struct {
+    FdKind kind;
+    int fd;
+    Route *route;
+    guint64 probes; // Probes of the current window received, guarded by soak.lock
+} Watched;
+
+struct Route {
+    int index;
+    pid_t pid;
+    int stdin_fd;
+    Watched destinations[MAX_DESTINATIONS];
+    GArray *latency_us;  // gdouble, current window, guarded by soak.lock
+    guint64 cpu_ticks;   // At the start of the window
+    gboolean exited;
+};
+
+typedef struct {
+    int routes;
+    int exited;
+    double cpu_route_avg;
+    double cpu_route_max;
+    double cpu_host;
+    double cpu_harness;
+    double rss_mb_avg;
+    double rss_mb_max;
+    double threads_avg;
+    double delivery_min;
+    double p50_ms;
+    double p99_ms;
+    double p999_ms;
+    double worst_route_p99_ms;
+    gboolean pass;
+    const char *limit;
+} StepResult;
+
+static struct {
+    GMutex lock;
+    Route **routes;
+    int n_routes;
+    int epoll_fd;
+    int send_fd;
+    struct sockaddr_in *targets; // Route source addresses, appended before n_targets is raised
+    gint n_targets;
+    gint running;
+    gint stop; // SIGINT/SIGTERM
+    guint32 seq;
+    gboolean counting; // Guarded by lock, with the window's probe range
+    guint32 window_start;
+    guint32 window_end;
+    char socket_path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    int listen_fd;
+    GstElement *encoder;
+} soak;
+
+static gint64 now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (gint64)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    g_atomic_int_set(&soak.stop, 1);
+}
+
+// Sleep that returns early (FALSE) on SIGINT/SIGTERM
+static gboolean soak_sleep_ms(int ms)
+{
+    for (int waited = 0; waited < ms; waited += 100) {
+        if (g_atomic_int_get(&soak.stop)) return FALSE;
+        g_usleep(MIN(100, ms - waited) * 1000);
+    }
+    return !g_atomic_int_get(&soak.stop);
+}
+
+// =============================================================================
+// Sender: one datagram of 7 packets at a time, to every route's source
+// =============================================================================
+
+typedef struct {
+    guint8 data[TS_PACKET * DATAGRAM_PACKETS];
+    int packets;
+    guint8 probe_cc;
+    gint64 last_probe_ns;
+} Datagram;
+
+static void datagram_flush(Datagram *dg)
+{
+    int n = g_atomic_int_get(&soak.n_targets);
+    for (int i = 0; i < n; i++) {
+        sendto(soak.send_fd, dg->data, (size_t)dg->packets * TS_PACKET, 0, (struct sockaddr *)&soak.targets[i],
+               sizeof(soak.targets[i]));
+    }
+    dg->packets = 0;
+}
+
+static void datagram_push(Datagram *dg, const guint8 *packet)
+{
+    memcpy(dg->data + dg->packets * TS_PACKET, packet, TS_PACKET);
+    if (++dg->packets == DATAGRAM_PACKETS) datagram_flush(dg);
+}
+
+// A probe between two stream packets when the last one is PROBE_INTERVAL_NS old
+static void datagram_maybe_probe(Datagram *dg)
+{
+    gint64 now = now_ns();
+    if (now - dg->last_probe_ns < PROBE_INTERVAL_NS) return;
+    dg->last_probe_ns = now;
+
+    guint8 probe[TS_PACKET];
+    memset(probe, 0xff, sizeof(probe));
+    probe[0] = 0x47;
+    probe[1] = PROBE_PID >> 8;
+    probe[2] = PROBE_PID & 0xff;
+    probe[3] = 0x10 | (dg->probe_cc++ & 0x0f); // Payload only
+    guint32 seq = (guint32)g_atomic_int_add((gint *)&soak.seq, 1);
+    memcpy(probe + 4, PROBE_MAGIC, 6);
+    memcpy(probe + 10, &seq, sizeof(seq));
+    memcpy(probe + 14, &now, sizeof(now));
+    datagram_push(dg, probe);
+}
+
+static gpointer encoder_sender(gpointer data)
+{
+    GstAppSink *appsink = data;
+    Datagram dg = {0};
+    while (g_atomic_int_get(&soak.running)) {
+        GstSample *sample = gst_app_sink_try_pull_sample(appsink, 100 * GST_MSECOND);
+        if (!sample) continue;
+        GstBuffer *buffer = gst_sample_get_buffer(sample);
+        GstMapInfo map;
+        if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+            for (gsize off = 0; off + TS_PACKET <= map.size; off += TS_PACKET) {
+                datagram_maybe_probe(&dg);
+                datagram_push(&dg, map.data + off);
+            }
+            gst_buffer_unmap(buffer, &map);
+        }
+        gst_sample_unref(sample);
+    }
+    return NULL;
+}
+
+// --no-video: null packets at the configured bitrate, sent in 1 ms ticks
+static gpointer null_sender(gpointer data)
+{
+    const SoakConfig *config = data;
+    Datagram dg = {0};
+    guint8 null_packet[TS_PACKET];
+    memset(null_packet, 0xff, sizeof(null_packet));
+    null_packet[0] = 0x47;
+    null_packet[1] = NULL_PID >> 8;
+    null_packet[2] = NULL_PID & 0xff;
+    null_packet[3] = 0x10;
+
+    gdouble packets_per_ns = config->bitrate_kbps * 1000.0 / (TS_PACKET * 8) / 1e9;
+    gint64 start = now_ns();
+    guint64 sent = 0;
+    while (g_atomic_int_get(&soak.running)) {
+        guint64 due = (guint64)((now_ns() - start) * packets_per_ns);
+        for (; sent < due; sent++) {
+            datagram_maybe_probe(&dg);
+            datagram_push(&dg, null_packet);
+        }
+        g_usleep(1000);
+    }
+    return NULL;
+}
+
+static GThread *start_sender(const SoakConfig *config)
+{
+    if (config->video) {
+        gchar *description = g_strdup_printf(
+            "videotestsrc is-live=true pattern=ball ! video/x-raw,width=%d,height=%d,framerate=25/1 ! "
+            "x264enc tune=zerolatency speed-preset=ultrafast bitrate=%d key-int-max=50 ! h264parse ! "
+            "mpegtsmux alignment=7 ! appsink name=ts max-buffers=64 sync=false",
+            config->width, config->height, config->bitrate_kbps);
+        GError *error = NULL;
+        soak.encoder = gst_parse_launch(description, &error);
+        g_free(description);
+        if (soak.encoder && !error) {
+            GstElement *appsink = gst_bin_get_by_name(GST_BIN(soak.encoder), "ts");
+            gst_element_set_state(soak.encoder, GST_STATE_PLAYING);
+            GThread *thread = g_thread_new("soak-sender", encoder_sender, appsink);
+            gst_object_unref(appsink);
+            return thread;
+        }
+        g_printerr("Soak: no H.264 encoder (%s); sending null packets, so thumbnails decode nothing\n",
+                   error ? error->message : "unknown error");
+        g_clear_error(&error);
+        if (soak.encoder) gst_object_unref(soak.encoder);
+        soak.encoder = NULL;
+    }
+    return g_thread_new("soak-sender", null_sender, (gpointer)config);
+}
+
+// =============================================================================
+// Receiver: destination sockets and the routes' control socket connections
+// =============================================================================
+
+static void watch_fd(Watched *w)
+{
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = w};
+    epoll_ctl(soak.epoll_fd, EPOLL_CTL_ADD, w->fd, &ev);
+}
+
+static void on_probe(Watched *w, const guint8 *packet, gint64 now)
+{
+    guint32 seq;
+    gint64 sent_ns;
+    memcpy(&seq, packet + 10, sizeof(seq));
+    memcpy(&sent_ns, packet + 14, sizeof(sent_ns));
+
+    g_mutex_lock(&soak.lock);
+    if (soak.counting && seq - soak.window_start < soak.window_end - soak.window_start) {
+        w->probes++;
+        gdouble latency_us = (now - sent_ns) / 1000.0;
+        g_array_append_val(w->route->latency_us, latency_us);
+    }
+    g_mutex_unlock(&soak.lock);
+}
+
+static void read_destination(Watched *w)
+{
+    guint8 buf[65536];
+    for (;;) {
+        ssize_t n = recv(w->fd, buf, sizeof(buf), MSG_DONTWAIT);
+        if (n <= 0) return;
+        gint64 now = now_ns();
+        for (ssize_t off = 0; off + TS_PACKET <= n; off += TS_PACKET) {
+            const guint8 *p = buf + off;
+            if (p[0] == 0x47 && (((p[1] & 0x1f) << 8) | p[2]) == PROBE_PID && memcmp(p + 4, PROBE_MAGIC, 6) == 0) {
+                on_probe(w, p, now);
+            }
+        }
+    }
+}
+
+// Routes write their stats here; they are not needed, but must be drained so the routes never block
+static void read_control(Watched *w)
+{
+    if (w->kind == FD_CONTROL_LISTEN) {
+        int fd;
+        while ((fd = accept4(w->fd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+            Watched *client = g_new0(Watched, 1);
+            client->kind = FD_CONTROL_CLIENT;
+            client->fd = fd;
+            watch_fd(client);
+        }
+        return;
+    }
+
+    char buf[65536];
+    ssize_t n;
+    while ((n = recv(w->fd, buf, sizeof(buf), MSG_DONTWAIT)) > 0) {
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        epoll_ctl(soak.epoll_fd, EPOLL_CTL_DEL, w->fd, NULL);
+        close(w->fd);
+        g_free(w);
+    }
+}
+
+static gpointer receiver(gpointer data)
+{
+    (void)data;
+    struct epoll_event events[64];
+    while (g_atomic_int_get(&soak.running)) {
+        int n = epoll_wait(soak.epoll_fd, events, G_N_ELEMENTS(events), 100);
+        for (int i = 0; i < n; i++) {
+            Watched *w = events[i].data.ptr;
+            if (w->kind == FD_DESTINATION) {
+                read_destination(w);
+            } else {
+                read_control(w);
+            }
+        }
+    }
+    return NULL;
+}
+
+static gboolean open_control_socket(void)
+{
+    snprintf(soak.socket_path, sizeof(soak.socket_path), "/tmp/blackgate_soak_%d.sock", (int)getpid());
+    unlink(soak.socket_path);
+    soak.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    g_strlcpy(addr.sun_path, soak.socket_path, sizeof(addr.sun_path));
+    if (soak.listen_fd < 0 || bind(soak.listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+        listen(soak.listen_fd, 256) < 0) {
+        perror("Soak: control socket");
+        return FALSE;
+    }
+    static Watched listen_watch = {.kind = FD_CONTROL_LISTEN};
+    listen_watch.fd = soak.listen_fd;
+    watch_fd(&listen_watch);
+    // Routes connect to BLACKGATE_SOCKET instead of the controller's socket
+    g_setenv("BLACKGATE_SOCKET", soak.socket_path, TRUE);
+    return TRUE;
+}
+
+// =============================================================================
+// Routes
+// =============================================================================
+
+static int open_destination_socket(int port)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    int size = RECV_BUFFER_BYTES;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        g_printerr("Soak: cannot bind destination port %d: %s\n", port, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static Route *start_route(const SoakConfig *config, int index)
+{
+    int source_port = config->base_port + index * (config->destinations + 1);
+    Route *route = g_new0(Route, 1);
+    route->index = index;
+    route->latency_us = g_array_new(FALSE, FALSE, sizeof(gdouble));
+
+    cJSON *json = cJSON_CreateObject();
+    cJSON *source = cJSON_AddObjectToObject(json, "source");
+    cJSON_AddStringToObject(source, "type", "udpsrc");
+    cJSON_AddNumberToObject(source, "port", source_port);
+    cJSON *sinks = cJSON_AddArrayToObject(json, "sinks");
+    for (int d = 0; d < config->destinations; d++) {
+        Watched *w = &route->destinations[d];
+        w->kind = FD_DESTINATION;
+        w->route = route;
+        w->fd = open_destination_socket(source_port + 1 + d);
+        if (w->fd < 0) {
+            cJSON_Delete(json);
+            return NULL;
+        }
+        watch_fd(w);
+
+        cJSON *sink = cJSON_CreateObject();
+        cJSON_AddStringToObject(sink, "type", "udpsink");
+        cJSON_AddStringToObject(sink, "address", "127.0.0.1");
+        cJSON_AddNumberToObject(sink, "port", source_port + 1 + d);
+        cJSON_AddItemToArray(sinks, sink);
+    }
+    char *line = cJSON_PrintUnformatted(json);
+    cJSON_Delete(json);
+
+    // The thumbnail branch exists only for routes with an ID
+    char route_id[32] = "";
+    if (config->thumbnails) snprintf(route_id, sizeof(route_id), "soak-%d", index);
+
+    int in[2];
+    if (pipe(in) < 0) {
+        free(line);
+        return NULL;
+    }
+    route->pid = fork();
+    if (route->pid == 0) {
+        dup2(in[0], STDIN_FILENO);
+        close(in[0]);
+        close(in[1]);
+        if (!config->verbose) {
+            int null_fd = open("/dev/null", O_WRONLY);
+            dup2(null_fd, STDOUT_FILENO);
+            dup2(null_fd, STDERR_FILENO);
+        }
+        execl(config->pipeline_path, config->pipeline_path, route_id, (char *)NULL);
+        _exit(127);
+    }
+    close(in[0]);
+    route->stdin_fd = in[1];
+    if (route->pid < 0 || write(route->stdin_fd, line, strlen(line)) < 0 || write(route->stdin_fd, "\n", 1) < 0) {
+        g_printerr("Soak: cannot start route %d: %s\n", index, strerror(errno));
+        free(line);
+        return NULL;
+    }
+    free(line);
+
+    struct sockaddr_in *target = &soak.targets[index];
+    target->sin_family = AF_INET;
+    target->sin_port = htons(source_port);
+    target->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    g_atomic_int_inc(&soak.n_targets);
+    return route;
+}
+
+static void stop_routes(const SoakConfig *config)
+{
+    for (int i = 0; i < soak.n_routes; i++) {
+        Route *route = soak.routes[i];
+        if (route->pid > 0 && !route->exited) kill(route->pid, SIGTERM);
+    }
+    for (int i = 0; i < soak.n_routes; i++) {
+        Route *route = soak.routes[i];
+        if (route->pid > 0 && !route->exited) waitpid(route->pid, NULL, 0);
+        close(route->stdin_fd);
+        if (config->thumbnails) {
+            char path[64];
+            snprintf(path, sizeof(path), "/tmp/blackgate_preview_soak-%d.jpg", route->index);
+            unlink(path);
+        }
+    }
+}
+
+// utime + stime in clock ticks
+static gboolean proc_cpu_ticks(const char *pid, guint64 *ticks)
+{
+    char path[64], buf[1024];
+    snprintf(path, sizeof(path), "/proc/%s/stat", pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return FALSE;
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    // The command name may contain spaces; fields 14 and 15 follow its closing parenthesis
+    char *p = strrchr(buf, ')');
+    unsigned long utime, stime;
+    if (!p || sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) {
+        return FALSE;
+    }
+    *ticks = utime + stime;
+    return TRUE;
+}
+
+static void proc_memory(pid_t pid, double *rss_mb, int *threads)
+{
+    char path[64], line[256];
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    FILE *f = fopen(path, "r");
+    *rss_mb = 0.0;
+    *threads = 0;
+    if (!f) return;
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long kb;
+        if (sscanf(line, "VmRSS: %lu kB", &kb) == 1) *rss_mb = kb / 1024.0;
+        sscanf(line, "Threads: %d", threads);
+    }
+    fclose(f);
+}
+
+// =============================================================================
+// Steps
+// =============================================================================
+
+static int compare_double(const void *a, const void *b)
+{
+    gdouble x = *(const gdouble *)a, y = *(const gdouble *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_ms(GArray *sorted, double q)
+{
+    if (sorted->len == 0) return 0.0;
+    return g_array_index(sorted, gdouble, (guint)(q * (sorted->len - 1))) / 1000.0;
+}
+
+static void reap_exited(void)
+{
+    for (int i = 0; i < soak.n_routes; i++) {
+        Route *route = soak.routes[i];
+        if (!route->exited && waitpid(route->pid, NULL, WNOHANG) == route->pid) route->exited = TRUE;
+    }
+}
+
+static void begin_window(guint64 *harness_ticks)
+{
+    char pid[16];
+    g_mutex_lock(&soak.lock);
+    for (int i = 0; i < soak.n_routes; i++) {
+        Route *route = soak.routes[i];
+        g_array_set_size(route->latency_us, 0);
+        for (int d = 0; d < MAX_DESTINATIONS; d++) route->destinations[d].probes = 0;
+        snprintf(pid, sizeof(pid), "%d", (int)route->pid);
+        if (!proc_cpu_ticks(pid, &route->cpu_ticks)) route->cpu_ticks = 0;
+    }
+    soak.window_start = (guint32)g_atomic_int_get((gint *)&soak.seq);
+    soak.window_end = soak.window_start - 1; // Open until end_window
+    soak.counting = TRUE;
+    g_mutex_unlock(&soak.lock);
+    proc_cpu_ticks("self", harness_ticks);
+}
+
+static void end_window(const SoakConfig *config, guint64 harness_ticks, double seconds, StepResult *r)
+{
+    long hz = sysconf(_SC_CLK_TCK);
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    char pid[16];
+    guint64 ticks;
+
+    // CPU over the window, then let the last probes drain out of the routes
+    memset(r, 0, sizeof(*r));
+    r->routes = soak.n_routes;
+    r->delivery_min = 100.0;
+    for (int i = 0; i < soak.n_routes; i++) {
+        Route *route = soak.routes[i];
+        snprintf(pid, sizeof(pid), "%d", (int)route->pid);
+        double cpu = proc_cpu_ticks(pid, &ticks) ? 100.0 * (ticks - route->cpu_ticks) / hz / seconds : 0.0;
+        r->cpu_route_avg += cpu / soak.n_routes;
+        r->cpu_route_max = MAX(r->cpu_route_max, cpu);
+        r->cpu_host += cpu / cpus;
+
+        double rss_mb;
+        int threads;
+        proc_memory(route->pid, &rss_mb, &threads);
+        r->rss_mb_avg += rss_mb / soak.n_routes;
+        r->rss_mb_max = MAX(r->rss_mb_max, rss_mb);
+        r->threads_avg += (double)threads / soak.n_routes;
+    }
+    if (proc_cpu_ticks("self", &ticks)) r->cpu_harness = 100.0 * (ticks - harness_ticks) / hz / seconds;
+
+    g_mutex_lock(&soak.lock);
+    soak.window_end = (guint32)g_atomic_int_get((gint *)&soak.seq);
+    g_mutex_unlock(&soak.lock);
+    g_usleep(GRACE_MS * 1000);
+    g_mutex_lock(&soak.lock);
+    soak.counting = FALSE;
+    guint32 expected = soak.window_end - soak.window_start;
+
+    GArray *all = g_array_new(FALSE, FALSE, sizeof(gdouble));
+    for (int i = 0; i < soak.n_routes; i++) {
+        Route *route = soak.routes[i];
+        if (route->exited) r->exited++;
+        for (int d = 0; d < config->destinations; d++) {
+            double delivery = expected ? 100.0 * route->destinations[d].probes / expected : 0.0;
+            r->delivery_min = MIN(r->delivery_min, delivery);
+        }
+        g_array_sort(route->latency_us, compare_double);
+        r->worst_route_p99_ms = MAX(r->worst_route_p99_ms, percentile_ms(route->latency_us, 0.99));
+        g_array_append_vals(all, route->latency_us->data, route->latency_us->len);
+    }
+    g_mutex_unlock(&soak.lock);
+
+    g_array_sort(all, compare_double);
+    r->p50_ms = percentile_ms(all, 0.50);
+    r->p99_ms = percentile_ms(all, 0.99);
+    r->p999_ms = percentile_ms(all, 0.999);
+    g_array_free(all, TRUE);
+
+    r->limit = r->exited                                       ? "route exited"
+               : r->delivery_min < config->min_delivery_percent ? "delivery"
+               : r->worst_route_p99_ms > config->max_p99_ms     ? "latency"
+                                                                : NULL;
+    r->pass = r->limit == NULL;
+}
+
+static void print_step(const StepResult *r)
+{
+    printf("%6d  %9.1f  %7.1f  %8.1f  %7.1f  %7.1f  %7.1f  %9.3f  %6.2f  %6.2f  %7.2f  %9.2f  %s\n", r->routes,
+           r->cpu_route_avg, r->cpu_route_max, r->cpu_host, r->cpu_harness, r->rss_mb_avg, r->threads_avg,
+           r->delivery_min, r->p50_ms, r->p99_ms, r->p999_ms, r->worst_route_p99_ms, r->pass ? "ok" : r->limit);
+}
+
+static cJSON *step_to_json(const StepResult *r)
+{
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddNumberToObject(obj, "routes", r->routes);
+    cJSON_AddNumberToObject(obj, "cpu-percent-per-route", r->cpu_route_avg);
+    cJSON_AddNumberToObject(obj, "cpu-percent-per-route-max", r->cpu_route_max);
+    cJSON_AddNumberToObject(obj, "cpu-percent-host", r->cpu_host);
+    cJSON_AddNumberToObject(obj, "cpu-percent-harness", r->cpu_harness);
+    cJSON_AddNumberToObject(obj, "rss-mb-per-route", r->rss_mb_avg);
+    cJSON_AddNumberToObject(obj, "rss-mb-per-route-max", r->rss_mb_max);
+    cJSON_AddNumberToObject(obj, "threads-per-route", r->threads_avg);
+    cJSON_AddNumberToObject(obj, "delivery-percent-min", r->delivery_min);
+    cJSON_AddNumberToObject(obj, "latency-ms-p50", r->p50_ms);
+    cJSON_AddNumberToObject(obj, "latency-ms-p99", r->p99_ms);
+    cJSON_AddNumberToObject(obj, "latency-ms-p999", r->p999_ms);
+    cJSON_AddNumberToObject(obj, "latency-ms-p99-worst-route", r->worst_route_p99_ms);
+    cJSON_AddNumberToObject(obj, "exited-routes", r->exited);
+    cJSON_AddBoolToObject(obj, "pass", r->pass);
+    if (r->limit) cJSON_AddStringToObject(obj, "limit", r->limit);
+    return obj;
+}
+
+static cJSON *host_to_json(void)
+{
+    cJSON *host = cJSON_CreateObject();
+    char line[256];
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    while (f && fgets(line, sizeof(line), f)) {
+        char *colon = strchr(line, ':');
+        if (g_str_has_prefix(line, "model name") && colon) {
+            cJSON_AddStringToObject(host, "cpu", g_strstrip(colon + 1));
+            break;
+        }
+    }
+    if (f) fclose(f);
+    cJSON_AddNumberToObject(host, "cpus", sysconf(_SC_NPROCESSORS_ONLN));
+    struct utsname uts;
+    if (uname(&uts) == 0) cJSON_AddStringToObject(host, "kernel", uts.release);
+    return host;
+}
+
+// =============================================================================
+// Main
+// =============================================================================
+
+static void usage(const char *argv0)
+{
+    printf("Usage: %s [options]\n"
+           "  --pipeline PATH        blackgate_pipeline binary (build/blackgate_pipeline)\n"
+           "  --start N --step N --max N  Route counts to try (2, 2, 64)\n"
+           "  --destinations N       UDP destinations per route, up to %d (2)\n"
+           "  --thumbnails           Run each route's thumbnail branch (off)\n"
+           "  --no-video             Null packets instead of H.264, for pure forwarding cost\n"
+           "  --bitrate KBPS         Stream bitrate (4000)\n"
+           "  --size WxH             Encoded picture size (1280x720)\n"
+           "  --warmup S --duration S  Seconds before and of each measurement (5, 15)\n"
+           "  --max-p99-ms MS        Output latency target for the worst route's p99 (20)\n"
+           "  --min-delivery PERCENT Lowest acceptable delivery on any destination (99.9)\n"
+           "  --base-port PORT       First UDP port; each route uses destinations + 1 (20000)\n"
+           "  --label TEXT           Release or hardware label for the report\n"
+           "  --json FILE            Also write the report as JSON\n"
+           "  --verbose              Keep the routes' stdout and stderr\n",
+           argv0, MAX_DESTINATIONS);
+}
+
+static gboolean parse_args(int argc, char *argv[], SoakConfig *config)
+{
+    static const struct option options[] = {
+        {"pipeline", required_argument, NULL, 'p'},  {"start", required_argument, NULL, 's'},
+        {"step", required_argument, NULL, 'i'},      {"max", required_argument, NULL, 'm'},
+        {"destinations", required_argument, NULL, 'd'}, {"thumbnails", no_argument, NULL, 't'},
+        {"no-video", no_argument, NULL, 'n'},        {"bitrate", required_argument, NULL, 'b'},
+        {"size", required_argument, NULL, 'z'},      {"warmup", required_argument, NULL, 'w'},
+        {"duration", required_argument, NULL, 'u'},  {"max-p99-ms", required_argument, NULL, 'l'},
+        {"min-delivery", required_argument, NULL, 'r'}, {"base-port", required_argument, NULL, 'o'},
+        {"label", required_argument, NULL, 'a'},     {"json", required_argument, NULL, 'j'},
+        {"verbose", no_argument, NULL, 'v'},         {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+    int c;
+    while ((c = getopt_long(argc, argv, "", options, NULL)) != -1) {
+        switch (c) {
+            case 'p':
+                config->pipeline_path = optarg;
+                break;
+            case 's':
+                config->start = atoi(optarg);
+                break;
+            case 'i':
+                config->step = atoi(optarg);
+                break;
+            case 'm':
+                config->max_routes = atoi(optarg);
+                break;
+            case 'd':
+                config->destinations = atoi(optarg);
+                break;
+            case 't':
+                config->thumbnails = TRUE;
+                break;
+            case 'n':
+                config->video = FALSE;
+                break;
+            case 'b':
+                config->bitrate_kbps = atoi(optarg);
+                break;
+            case 'z':
+                if (sscanf(optarg, "%dx%d", &config->width, &config->height) != 2) return FALSE;
+                break;
+            case 'w':
+                config->warmup_s = atoi(optarg);
+                break;
+            case 'u':
+                config->duration_s = atoi(optarg);
+                break;
+            case 'l':
+                config->max_p99_ms = atof(optarg);
+                break;
+            case 'r':
+                config->min_delivery_percent = atof(optarg);
+                break;
+            case 'o':
+                config->base_port = atoi(optarg);
+                break;
+            case 'a':
+                config->label = optarg;
+                break;
+            case 'j':
+                config->json_path = optarg;
+                break;
+            case 'v':
+                config->verbose = TRUE;
+                break;
+            default:
+                return FALSE;
+        }
+    }
+    int last_port = config->base_port + config->max_routes * (config->destinations + 1);
+    if (config->start < 1 || config->step < 1 || config->max_routes < config->start || config->destinations < 1 ||
+        config->destinations > MAX_DESTINATIONS || config->bitrate_kbps < 100 || config->width < 16 ||
+        config->height < 16 || config->warmup_s < 0 || config->duration_s < 1 || config->base_port < 1024 ||
+        last_port > 65535) {
+        g_printerr("Soak: invalid options (routes 1..N, destinations 1..%d, ports up to 65535)\n",
+                   MAX_DESTINATIONS);
+        return FALSE;
+    }
+    if (access(config->pipeline_path, X_OK) != 0) {
+        g_printerr("Soak: %s is not executable (make first, or --pipeline)\n", config->pipeline_path);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+int main(int argc, char *argv[])
+{
+    SoakConfig config = {
+        .pipeline_path = "build/blackgate_pipeline",
+        .start = 2,
+        .step = 2,
+        .max_routes = 64,
+        .destinations = 2,
+        .video = TRUE,
+        .bitrate_kbps = 4000,
+        .width = 1280,
+        .height = 720,
+        .warmup_s = 5,
+        .duration_s = 15,
+        .max_p99_ms = 20.0,
+        .min_delivery_percent = 99.9,
+        .base_port = 20000,
+    };
+    if (!parse_args(argc, argv, &config)) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    gst_init(NULL, NULL);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+    g_mutex_init(&soak.lock);
+    soak.epoll_fd = epoll_create1(0);
+    soak.send_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    soak.routes = g_new0(Route *, config.max_routes);
+    soak.targets = g_new0(struct sockaddr_in, config.max_routes);
+    if (!open_control_socket()) return 1;
+
+    g_atomic_int_set(&soak.running, 1);
+    GThread *receiver_thread = g_thread_new("soak-receiver", receiver, NULL);
+    GThread *sender_thread = start_sender(&config);
+
+    cJSON *report = cJSON_CreateObject();
+    if (config.label) cJSON_AddStringToObject(report, "label", config.label);
+    cJSON_AddItemToObject(report, "host", host_to_json());
+    cJSON *settings = cJSON_AddObjectToObject(report, "config");
+    cJSON_AddNumberToObject(settings, "destinations", config.destinations);
+    cJSON_AddBoolToObject(settings, "thumbnails", config.thumbnails);
+    cJSON_AddBoolToObject(settings, "video", soak.encoder != NULL);
+    cJSON_AddNumberToObject(settings, "bitrate-kbps", config.bitrate_kbps);
+    cJSON_AddNumberToObject(settings, "duration-s", config.duration_s);
+    cJSON_AddNumberToObject(settings, "max-p99-ms", config.max_p99_ms);
+    cJSON_AddNumberToObject(settings, "min-delivery-percent", config.min_delivery_percent);
+    cJSON *steps = cJSON_AddArrayToObject(report, "steps");
+
+    printf("Soak: %d destination(s) per route, %d kbit/s %s, thumbnails %s; target p99 <= %.1f ms, delivery >= "
+           "%.2f%%\n\n",
+           config.destinations, config.bitrate_kbps, soak.encoder ? "H.264" : "null packets",
+           config.thumbnails ? "on" : "off", config.max_p99_ms, config.min_delivery_percent);
+    printf("routes  cpu%%/route  cpu%%max  cpu%%host  harness  rss MB  threads  delivery%%  p50 ms  p99 ms  "
+           "p99.9 ms  worst p99  result\n");
+
+    int knee = 0;
+    const char *limit = "max routes";
+    for (int n = config.start; n <= config.max_routes && !g_atomic_int_get(&soak.stop); n += config.step) {
+        gboolean started = TRUE;
+        while (soak.n_routes < n && started) {
+            Route *route = start_route(&config, soak.n_routes);
+            if (route) soak.routes[soak.n_routes++] = route;
+            started = route != NULL;
+        }
+        if (!started) {
+            limit = "route start failed";
+            break;
+        }
+        if (!soak_sleep_ms(config.warmup_s * 1000)) break;
+
+        guint64 harness_ticks = 0;
+        reap_exited();
+        begin_window(&harness_ticks);
+        gint64 window_start_ns = now_ns();
+        if (!soak_sleep_ms(config.duration_s * 1000)) break;
+        reap_exited();
+
+        StepResult result;
+        end_window(&config, harness_ticks, (now_ns() - window_start_ns) / 1e9, &result);
+        print_step(&result);
+        cJSON_AddItemToArray(steps, step_to_json(&result));
+        if (!result.pass) {
+            limit = result.limit;
+            break;
+        }
+        knee = n;
+    }
+
+    printf("\nKnee: %d route(s) met the targets (stopped by: %s)\n", knee,
+           g_atomic_int_get(&soak.stop) ? "interrupted" : limit);
+    cJSON_AddNumberToObject(report, "knee-routes", knee);
+    cJSON_AddStringToObject(report, "limit", g_atomic_int_get(&soak.stop) ? "interrupted" : limit);
+    if (config.json_path) {
+        char *text = cJSON_Print(report);
+        FILE *f = fopen(config.json_path, "w");
+        if (f) {
+            fputs(text, f);
+            fputc('\n', f);
+            fclose(f);
+        } else {
+            perror("Soak: JSON report");
+        }
+        free(text);
+    }
+    cJSON_Delete(report);
+
+    stop_routes(&config);
+    g_atomic_int_set(&soak.running, 0);
+    g_thread_join(sender_thread);
+    g_thread_join(receiver_thread);
+    if (soak.encoder) {
+        gst_element_set_state(soak.encoder, GST_STATE_NULL);
+        gst_object_unref(soak.encoder);
+    }
+    close(soak.listen_fd);
+    unlink(soak.socket_path);
+    return 0;
+}
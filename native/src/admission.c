@@ -0,0 +1,463 @@
+#include "admission.h"
+
+#include <arpa/inet.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+// Per-IP buckets kept at most; beyond this new addresses only go through the global bucket
+#define MAX_TRACKED_IPS 4096
+
+typedef struct {
+    double tokens;
+    gint64 last_us;
+} TokenBucket;
+
+// A network in an allow-list: the address with host bits cleared, plus the prefix length
+typedef struct {
+    guint8 family; // 4 or 6
+    guint8 prefix;
+    guint8 addr[16];
+} NetKey;
+
+// Prefix lengths used by the networks, so a lookup tries at most one mask per length in use
+typedef struct {
+    GHashTable *stream_ids; // Set of strings
+    GHashTable *nets;       // Set of NetKey
+    guint8 v4_prefixes[33];
+    guint8 v6_prefixes[129];
+} AllowList;
+
+struct Admission {
+    GMutex lock;
+
+    AllowList *allow;
+    cJSON *inline_lists; // Copy of the config, merged with the file on every reload
+    char *allow_file;
+    gint64 allow_file_mtime_ns;
+
+    double rate, burst;
+    double ip_rate, ip_burst;
+    guint max_callers;
+    TokenBucket global;
+    GHashTable *per_ip; // ip string -> TokenBucket
+    gint64 last_prune_us;
+
+    AdmissionStats stats;
+};
+
+// =============================================================================
+// Allow-lists
+// =============================================================================
+
+static guint net_key_hash(gconstpointer key)
+{
+    const guint8 *p = key;
+    guint32 h = 2166136261u; // FNV-1a
+    for (gsize i = 0; i < sizeof(NetKey); i++) h = (h ^ p[i]) * 16777619u;
+    return h;
+}
+
+static gboolean net_key_equal(gconstpointer a, gconstpointer b)
+{
+    return memcmp(a, b, sizeof(NetKey)) == 0;
+}
+
+// Parse an address, folding IPv4-mapped IPv6 (::ffff:a.b.c.d) into IPv4
+static gboolean parse_address(const char *text, NetKey *key)
+{
+    memset(key, 0, sizeof(*key));
+    if (inet_pton(AF_INET, text, key->addr) == 1) {
+        key->family = 4;
+        key->prefix = 32;
+        return TRUE;
+    }
+    if (inet_pton(AF_INET6, text, key->addr) != 1) return FALSE;
+
+    static const guint8 mapped[12] = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0xff, 0xff};
+    if (memcmp(key->addr, mapped, sizeof(mapped)) == 0) {
+        memmove(key->addr, key->addr + 12, 4);
+        memset(key->addr + 4, 0, 12);
+        key->family = 4;
+        key->prefix = 32;
+    } else {
+        key->family = 6;
+        key->prefix = 128;
+    }
+    return TRUE;
+}
+
+static void mask_key(NetKey *key, guint prefix)
+{
+    guint bytes = key->family == 4 ? 4 : 16;
+    for (guint i = 0; i < bytes; i++) {
+        guint bits = prefix > i * 8 ? prefix - i * 8 : 0;
+        if (bits < 8) key->addr[i] &= (guint8)(0xff00 >> bits);
+    }
+    key->prefix = (guint8)prefix;
+}
+
+static AllowList *allow_list_new(void)
+{
+    AllowList *list = g_new0(AllowList, 1);
+    list->stream_ids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+    list->nets = g_hash_table_new_full(net_key_hash, net_key_equal, g_free, NULL);
+    return list;
+}
+
+static void allow_list_free(AllowList *list)
+{
+    if (!list) return;
+    g_hash_table_destroy(list->stream_ids);
+    g_hash_table_destroy(list->nets);
+    g_free(list);
+}
+
+// Add "allow-stream-ids" and "allow-ips" from `obj`; FALSE on the first malformed entry
+static gboolean allow_list_add(AllowList *list, cJSON *obj, const char *origin)
+{
+    cJSON *item;
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(obj, "allow-stream-ids"))
+    {
+        if (!cJSON_IsString(item)) {
+            g_printerr("Admission: allow-stream-ids in %s must be strings\n", origin);
+            return FALSE;
+        }
+        g_hash_table_add(list->stream_ids, g_strdup(item->valuestring));
+    }
+
+    cJSON_ArrayForEach(item, cJSON_GetObjectItem(obj, "allow-ips"))
+    {
+        if (!cJSON_IsString(item)) {
+            g_printerr("Admission: allow-ips in %s must be strings\n", origin);
+            return FALSE;
+        }
+
+        const char *slash = strchr(item->valuestring, '/');
+        gchar *addr = slash ? g_strndup(item->valuestring, slash - item->valuestring) : g_strdup(item->valuestring);
+        NetKey key;
+        gboolean valid = parse_address(addr, &key);
+        gboolean written_as_v6 = strchr(addr, ':') != NULL;
+        g_free(addr);
+
+        guint prefix = key.prefix;
+        if (valid && slash) {
+            char *end;
+            guint64 value = g_ascii_strtoull(slash + 1, &end, 10);
+            valid = end != slash + 1 && *end == '\0';
+            // A mapped IPv4 network is written with an IPv6 prefix length
+            if (key.family == 4 && written_as_v6) {
+                valid = valid && value >= 96;
+                value -= 96;
+            }
+            valid = valid && value <= key.prefix;
+            prefix = (guint)value;
+        }
+        if (!valid) {
+            g_printerr("Admission: invalid allow-ips entry '%s' in %s\n", item->valuestring, origin);
+            return FALSE;
+        }
+
+        mask_key(&key, prefix);
+        if (key.family == 4) {
+            list->v4_prefixes[prefix] = 1;
+        } else {
+            list->v6_prefixes[prefix] = 1;
+        }
+        NetKey *copy = g_new(NetKey, 1);
+        *copy = key;
+        g_hash_table_add(list->nets, copy);
+    }
+    return TRUE;
+}
+
+static gboolean allow_list_has_ip(AllowList *list, const char *ip)
+{
+    if (g_hash_table_size(list->nets) == 0) return TRUE;
+
+    NetKey addr;
+    if (!ip || !parse_address(ip, &addr)) return FALSE;
+
+    const guint8 *prefixes = addr.family == 4 ? list->v4_prefixes : list->v6_prefixes;
+    for (gint prefix = addr.prefix; prefix >= 0; prefix--) {
+        if (!prefixes[prefix]) continue;
+        NetKey key = addr;
+        mask_key(&key, (guint)prefix);
+        if (g_hash_table_contains(list->nets, &key)) return TRUE;
+    }
+    return FALSE;
+}
+
+static gboolean allow_list_has_stream_id(AllowList *list, const char *stream_id)
+{
+    if (g_hash_table_size(list->stream_ids) == 0) return TRUE;
+    return stream_id && g_hash_table_contains(list->stream_ids, stream_id);
+}
+
+static gint64 file_mtime_ns(const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0) return -1;
+    return (gint64)st.st_mtim.tv_sec * G_GINT64_CONSTANT(1000000000) + st.st_mtim.tv_nsec;
+}
+
+// Inline lists plus the file's; NULL if either is invalid
+static AllowList *build_allow_list(cJSON *inline_lists, const char *file)
+{
+    AllowList *list = allow_list_new();
+    if (inline_lists && !allow_list_add(list, inline_lists, "config")) {
+        allow_list_free(list);
+        return NULL;
+    }
+    if (!file) return list;
+
+    gchar *contents = NULL;
+    cJSON *json = g_file_get_contents(file, &contents, NULL, NULL) ? cJSON_Parse(contents) : NULL;
+    g_free(contents);
+    if (!cJSON_IsObject(json) || !allow_list_add(list, json, file)) {
+        g_printerr("Admission: cannot load allow-list file %s\n", file);
+        cJSON_Delete(json);
+        allow_list_free(list);
+        return NULL;
+    }
+    cJSON_Delete(json);
+    return list;
+}
+
+// =============================================================================
+// Rate Limits
+// =============================================================================
+
+static gboolean bucket_take(TokenBucket *bucket, double rate, double burst, gint64 now_us)
+{
+    if (now_us > bucket->last_us) {
+        bucket->tokens = MIN(burst, bucket->tokens + (double)(now_us - bucket->last_us) * rate / G_USEC_PER_SEC);
+        bucket->last_us = now_us;
+    }
+    if (bucket->tokens < 1.0) return FALSE;
+    bucket->tokens -= 1.0;
+    return TRUE;
+}
+
+// Forget addresses whose bucket has refilled: they would start full again anyway
+static void prune_ip_buckets(Admission *adm, gint64 now_us)
+{
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, adm->per_ip);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        TokenBucket *bucket = value;
+        double refill = (double)(now_us - bucket->last_us) * adm->ip_rate / G_USEC_PER_SEC;
+        if (bucket->tokens + refill >= adm->ip_burst) g_hash_table_iter_remove(&iter);
+    }
+    adm->last_prune_us = now_us;
+}
+
+static gboolean ip_take(Admission *adm, const char *ip, gint64 now_us)
+{
+    if (adm->ip_rate <= 0 || !ip) return TRUE;
+
+    TokenBucket *bucket = g_hash_table_lookup(adm->per_ip, ip);
+    if (!bucket) {
+        if (g_hash_table_size(adm->per_ip) >= MAX_TRACKED_IPS && now_us - adm->last_prune_us >= G_USEC_PER_SEC) {
+            prune_ip_buckets(adm, now_us);
+        }
+        if (g_hash_table_size(adm->per_ip) >= MAX_TRACKED_IPS) return TRUE; // Left to the global bucket
+
+        bucket = g_new(TokenBucket, 1);
+        bucket->tokens = adm->ip_burst;
+        bucket->last_us = now_us;
+        g_hash_table_insert(adm->per_ip, g_strdup(ip), bucket);
+    }
+    return bucket_take(bucket, adm->ip_rate, adm->ip_burst, now_us);
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+static gboolean read_rate(cJSON *config, const char *key, double *out)
+{
+    cJSON *item = cJSON_GetObjectItem(config, key);
+    if (!item) return TRUE;
+    if (!cJSON_IsNumber(item) || item->valuedouble < 0) {
+        g_printerr("Admission: '%s' must be a non-negative number\n", key);
+        return FALSE;
+    }
+    *out = item->valuedouble;
+    return TRUE;
+}
+
+Admission *admission_new(cJSON *config)
+{
+    if (config && !cJSON_IsObject(config)) {
+        g_printerr("Admission: config must be an object\n");
+        return NULL;
+    }
+
+    Admission *adm = g_new0(Admission, 1);
+    g_mutex_init(&adm->lock);
+    adm->per_ip = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    adm->burst = -1;
+    adm->ip_burst = -1;
+
+    cJSON *file = cJSON_GetObjectItem(config, "allow-list-file");
+    cJSON *max_callers = cJSON_GetObjectItem(config, "max-callers");
+    gboolean ok = read_rate(config, "rate", &adm->rate) && read_rate(config, "burst", &adm->burst) &&
+                  read_rate(config, "per-ip-rate", &adm->ip_rate) && read_rate(config, "per-ip-burst", &adm->ip_burst);
+    if (file && !cJSON_IsString(file)) ok = FALSE;
+    if (max_callers && (!cJSON_IsNumber(max_callers) || max_callers->valueint < 0)) ok = FALSE;
+    if (!ok) {
+        g_printerr("Admission: invalid config\n");
+        admission_free(adm);
+        return NULL;
+    }
+
+    if (adm->burst < 0) adm->burst = MAX(adm->rate, 1.0);
+    if (adm->ip_burst < 0) adm->ip_burst = MAX(adm->ip_rate, 1.0);
+    adm->global.tokens = adm->burst;
+    adm->max_callers = max_callers ? (guint)max_callers->valueint : 0;
+    adm->inline_lists = config ? cJSON_Duplicate(config, 1) : NULL;
+    adm->allow_file = cJSON_IsString(file) ? g_strdup(file->valuestring) : NULL;
+    adm->allow_file_mtime_ns = adm->allow_file ? file_mtime_ns(adm->allow_file) : -1;
+
+    adm->allow = build_allow_list(adm->inline_lists, adm->allow_file);
+    if (!adm->allow) {
+        admission_free(adm);
+        return NULL;
+    }
+
+    if (config) {
+        g_print("Admission: %u stream IDs, %u networks allowed, rate %.1f/s (burst %.0f), per IP %.1f/s "
+                "(burst %.0f), max callers %u\n",
+                g_hash_table_size(adm->allow->stream_ids), g_hash_table_size(adm->allow->nets), adm->rate, adm->burst,
+                adm->ip_rate, adm->ip_burst, adm->max_callers);
+    }
+    return adm;
+}
+
+void admission_free(Admission *adm)
+{
+    if (!adm) return;
+    allow_list_free(adm->allow);
+    g_hash_table_destroy(adm->per_ip);
+    cJSON_Delete(adm->inline_lists);
+    g_free(adm->allow_file);
+    g_mutex_clear(&adm->lock);
+    g_free(adm);
+}
+
+AdmissionResult admission_check(Admission *adm, const char *ip, const char *stream_id, gint64 now_us)
+{
+    AdmissionResult result = ADMISSION_ACCEPT;
+
+    g_mutex_lock(&adm->lock);
+    if (!ip_take(adm, ip, now_us)) {
+        result = ADMISSION_REJECT_IP_RATE;
+    } else if (!admission_stream_id_is_safe(stream_id)) {
+        result = ADMISSION_REJECT_MALFORMED;
+    } else if (!allow_list_has_ip(adm->allow, ip)) {
+        result = ADMISSION_REJECT_IP;
+    } else if (!allow_list_has_stream_id(adm->allow, stream_id)) {
+        result = ADMISSION_REJECT_STREAM_ID;
+    } else if (adm->max_callers && adm->stats.callers >= adm->max_callers) {
+        result = ADMISSION_REJECT_MAX_CALLERS;
+    } else if (adm->rate > 0 && !bucket_take(&adm->global, adm->rate, adm->burst, now_us)) {
+        result = ADMISSION_REJECT_RATE;
+    }
+
+    if (result == ADMISSION_ACCEPT) {
+        adm->stats.accepted++;
+    } else {
+        adm->stats.rejected[result]++;
+    }
+    g_mutex_unlock(&adm->lock);
+    return result;
+}
+
+void admission_caller_added(Admission *adm)
+{
+    g_mutex_lock(&adm->lock);
+    adm->stats.callers++;
+    g_mutex_unlock(&adm->lock);
+}
+
+void admission_caller_removed(Admission *adm)
+{
+    g_mutex_lock(&adm->lock);
+    if (adm->stats.callers > 0) adm->stats.callers--;
+    g_mutex_unlock(&adm->lock);
+}
+
+void admission_reload_if_changed(Admission *adm)
+{
+    if (!adm->allow_file) return;
+
+    gint64 mtime = file_mtime_ns(adm->allow_file);
+    if (mtime == adm->allow_file_mtime_ns) return;
+    adm->allow_file_mtime_ns = mtime;
+
+    // Parse outside the lock; handshakes only wait for the pointer swap
+    AllowList *list = build_allow_list(adm->inline_lists, adm->allow_file);
+    if (!list) return;
+
+    g_mutex_lock(&adm->lock);
+    AllowList *old = adm->allow;
+    adm->allow = list;
+    adm->stats.reloads++;
+    g_mutex_unlock(&adm->lock);
+    allow_list_free(old);
+
+    g_print("Admission: reloaded %s (%u stream IDs, %u networks)\n", adm->allow_file,
+            g_hash_table_size(list->stream_ids), g_hash_table_size(list->nets));
+}
+
+const char *admission_result_name(AdmissionResult result)
+{
+    switch (result) {
+    case ADMISSION_ACCEPT:
+        return "accepted";
+    case ADMISSION_REJECT_IP_RATE:
+        return "ip-rate";
+    case ADMISSION_REJECT_IP:
+        return "ip";
+    case ADMISSION_REJECT_STREAM_ID:
+        return "stream-id";
+    case ADMISSION_REJECT_MAX_CALLERS:
+        return "max-callers";
+    case ADMISSION_REJECT_RATE:
+        return "rate";
+    case ADMISSION_REJECT_MALFORMED:
+        return "malformed-stream-id";
+    default:
+        return "unknown";
+    }
+}
+
+gboolean admission_stream_id_is_safe(const char *stream_id)
+{
+    for (const guchar *p = (const guchar *)stream_id; p && *p; p++) {
+        if (*p < 0x20 || *p == 0x7F) return FALSE;
+    }
+    return TRUE;
+}
+
+void admission_get_stats(Admission *adm, AdmissionStats *stats)
+{
+    g_mutex_lock(&adm->lock);
+    *stats = adm->stats;
+    g_mutex_unlock(&adm->lock);
+}
+
+void admission_stats_to_json(const AdmissionStats *stats, cJSON *root)
+{
+    cJSON *obj = cJSON_AddObjectToObject(root, "admission");
+    cJSON_AddNumberToObject(obj, "accepted", (double)stats->accepted);
+    cJSON_AddNumberToObject(obj, "callers", stats->callers);
+    cJSON_AddNumberToObject(obj, "reloads", (double)stats->reloads);
+    for (int i = ADMISSION_ACCEPT + 1; i < ADMISSION_RESULT_COUNT; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "rejected-%s", admission_result_name((AdmissionResult)i));
+        cJSON_AddNumberToObject(obj, key, (double)stats->rejected[i]);
+    }
+}
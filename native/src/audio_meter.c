@@ -0,0 +1,386 @@
+#include "audio_meter.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define AUDIO_METER_X86 1
+#endif
+
+#define BLOCKS_PER_SEC 10
+#define MOMENTARY_BLOCKS 4   // 400 ms
+#define SHORT_TERM_BLOCKS 30 // 3 s
+#define CHUNK_FRAMES 512     // Frames deinterleaved per channel at a time
+
+// Transposed direct form II; a0 normalised to 1
+typedef struct {
+    gdouble b0, b1, b2, a1, a2;
+} Biquad;
+
+typedef struct {
+    gdouble z1, z2;
+} BiquadState;
+
+struct AudioMeter {
+    GMutex lock;
+    guint rate;
+    guint channels;
+    guint block_frames;
+    Biquad shelf;    // BS.1770 stage 1: +4 dB high shelf (head effects)
+    Biquad highpass; // BS.1770 stage 2: RLB high-pass
+    BiquadState state[AUDIO_METER_MAX_CHANNELS][2];
+    gdouble weight[AUDIO_METER_MAX_CHANNELS];
+
+    // Peak/RMS window since the previous report
+    gfloat window_peak[AUDIO_METER_MAX_CHANNELS];
+    gdouble window_sum[AUDIO_METER_MAX_CHANNELS];
+    guint64 window_frames;
+
+    // 100 ms block being filled
+    gdouble block_sum[AUDIO_METER_MAX_CHANNELS]; // K-weighted
+    gfloat block_peak;                           // Over all channels
+    guint block_fill;
+
+    // Channel-weighted mean square of the last SHORT_TERM_BLOCKS completed blocks
+    gdouble blocks[SHORT_TERM_BLOCKS];
+    guint block_next;
+    guint64 block_count;
+
+    guint64 frames;
+    guint64 silent_frames;
+
+    gfloat raw[CHUNK_FRAMES];
+    gfloat weighted[CHUNK_FRAMES];
+};
+
+// =============================================================================
+// Kernels
+// =============================================================================
+
+static gfloat peak_scalar(const gfloat *x, gsize n)
+{
+    gfloat peak = 0.0f;
+    for (gsize i = 0; i < n; i++) peak = MAX(peak, fabsf(x[i]));
+    return peak;
+}
+
+static gdouble sum_squares_scalar(const gfloat *x, gsize n)
+{
+    gdouble sum = 0.0;
+    for (gsize i = 0; i < n; i++) sum += (gdouble)x[i] * x[i];
+    return sum;
+}
+
+#ifdef AUDIO_METER_X86
+__attribute__((target("sse2"))) static gfloat peak_sse2(const gfloat *x, gsize n)
+{
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 acc = _mm_setzero_ps();
+    gsize i = 0;
+    for (; i + 4 <= n; i += 4) acc = _mm_max_ps(acc, _mm_and_ps(_mm_loadu_ps(x + i), abs_mask));
+    acc = _mm_max_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_max_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return MAX(_mm_cvtss_f32(acc), peak_scalar(x + i, n - i));
+}
+
+__attribute__((target("sse2"))) static gdouble sum_squares_sse2(const gfloat *x, gsize n)
+{
+    __m128d acc0 = _mm_setzero_pd(), acc1 = _mm_setzero_pd();
+    gsize i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128 v = _mm_loadu_ps(x + i);
+        __m128d lo = _mm_cvtps_pd(v);
+        __m128d hi = _mm_cvtps_pd(_mm_movehl_ps(v, v));
+        acc0 = _mm_add_pd(acc0, _mm_mul_pd(lo, lo));
+        acc1 = _mm_add_pd(acc1, _mm_mul_pd(hi, hi));
+    }
+    acc0 = _mm_add_pd(acc0, acc1);
+    acc0 = _mm_add_sd(acc0, _mm_unpackhi_pd(acc0, acc0));
+    return _mm_cvtsd_f64(acc0) + sum_squares_scalar(x + i, n - i);
+}
+
+__attribute__((target("avx2"))) static gfloat peak_avx2(const gfloat *x, gsize n)
+{
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+    gsize i = 0;
+    // Two accumulators hide the max latency
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm256_max_ps(acc0, _mm256_and_ps(_mm256_loadu_ps(x + i), abs_mask));
+        acc1 = _mm256_max_ps(acc1, _mm256_and_ps(_mm256_loadu_ps(x + i + 8), abs_mask));
+    }
+    for (; i + 8 <= n; i += 8) acc0 = _mm256_max_ps(acc0, _mm256_and_ps(_mm256_loadu_ps(x + i), abs_mask));
+    acc0 = _mm256_max_ps(acc0, acc1);
+    __m128 acc = _mm_max_ps(_mm256_castps256_ps128(acc0), _mm256_extractf128_ps(acc0, 1));
+    acc = _mm_max_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_max_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return MAX(_mm_cvtss_f32(acc), peak_scalar(x + i, n - i));
+}
+
+__attribute__((target("avx2"))) static gdouble sum_squares_avx2(const gfloat *x, gsize n)
+{
+    __m256d acc0 = _mm256_setzero_pd(), acc1 = _mm256_setzero_pd();
+    gsize i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        __m256d lo = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+        __m256d hi = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(lo, lo));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(hi, hi));
+    }
+    acc0 = _mm256_add_pd(acc0, acc1);
+    __m128d acc = _mm_add_pd(_mm256_castpd256_pd128(acc0), _mm256_extractf128_pd(acc0, 1));
+    acc = _mm_add_sd(acc, _mm_unpackhi_pd(acc, acc));
+    return _mm_cvtsd_f64(acc) + sum_squares_scalar(x + i, n - i);
+}
+#endif
+
+static gfloat (*peak_impl)(const gfloat *x, gsize n) = peak_scalar;
+static gdouble (*sum_squares_impl)(const gfloat *x, gsize n) = sum_squares_scalar;
+static TsSimdLevel simd_level = TS_SIMD_SCALAR;
+static pthread_once_t simd_once = PTHREAD_ONCE_INIT;
+
+static gboolean apply_simd_level(TsSimdLevel level)
+{
+    switch (level) {
+        case TS_SIMD_SCALAR:
+            peak_impl = peak_scalar;
+            sum_squares_impl = sum_squares_scalar;
+            break;
+#ifdef AUDIO_METER_X86
+        case TS_SIMD_SSE2:
+            if (!__builtin_cpu_supports("sse2")) return FALSE;
+            peak_impl = peak_sse2;
+            sum_squares_impl = sum_squares_sse2;
+            break;
+        case TS_SIMD_AVX2:
+            if (!__builtin_cpu_supports("avx2")) return FALSE;
+            peak_impl = peak_avx2;
+            sum_squares_impl = sum_squares_avx2;
+            break;
+#endif
+        default:
+            return FALSE;
+    }
+    simd_level = level;
+    return TRUE;
+}
+
+static void select_simd_level(void)
+{
+#ifdef AUDIO_METER_X86
+    __builtin_cpu_init();
+    if (!apply_simd_level(TS_SIMD_AVX2)) apply_simd_level(TS_SIMD_SSE2);
+#endif
+}
+
+gboolean audio_meter_set_simd_level(TsSimdLevel level)
+{
+    pthread_once(&simd_once, select_simd_level);
+    return apply_simd_level(level);
+}
+
+const char *audio_meter_simd_name(void)
+{
+    pthread_once(&simd_once, select_simd_level);
+    switch (simd_level) {
+        case TS_SIMD_AVX2:
+            return "avx2";
+        case TS_SIMD_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+gfloat audio_meter_peak(const gfloat *x, gsize n)
+{
+    return peak_impl(x, n);
+}
+
+gdouble audio_meter_sum_squares(const gfloat *x, gsize n)
+{
+    return sum_squares_impl(x, n);
+}
+
+// =============================================================================
+// K-weighting and loudness
+// =============================================================================
+
+// BS.1770 filters re-derived for `rate` from their analog prototypes, so 44.1 kHz and 32 kHz
+// streams are weighted like the 48 kHz reference
+static void k_weighting_init(AudioMeter *m)
+{
+    gdouble f0 = 1681.974450955533, gain_db = 3.999843853973347, q = 0.7071752369554196;
+    gdouble k = tan(G_PI * f0 / m->rate);
+    gdouble vh = pow(10.0, gain_db / 20.0);
+    gdouble vb = pow(vh, 0.4996667741545416);
+    gdouble a0 = 1.0 + k / q + k * k;
+    m->shelf = (Biquad){(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0, (vh - vb * k / q + k * k) / a0,
+                        2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+
+    f0 = 38.13547087602444;
+    q = 0.5003270373238773;
+    k = tan(G_PI * f0 / m->rate);
+    a0 = 1.0 + k / q + k * k;
+    m->highpass = (Biquad){1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0};
+}
+
+static inline gdouble biquad_step(const Biquad *f, BiquadState *s, gdouble x)
+{
+    gdouble y = f->b0 * x + s->z1;
+    s->z1 = f->b1 * x - f->a1 * y + s->z2;
+    s->z2 = f->b2 * x - f->a2 * y;
+    return y;
+}
+
+static void k_weight(AudioMeter *m, guint ch, const gfloat *in, gfloat *out, gsize n)
+{
+    BiquadState *s = m->state[ch];
+    for (gsize i = 0; i < n; i++) {
+        out[i] = (gfloat)biquad_step(&m->highpass, &s[1], biquad_step(&m->shelf, &s[0], in[i]));
+    }
+}
+
+// BS.1770 channel weights for GStreamer's default layouts: LFE (4th of 5.1/7.1) is excluded and
+// surrounds count 1.41
+static void channel_weights_init(AudioMeter *m)
+{
+    for (guint ch = 0; ch < m->channels; ch++) {
+        if (m->channels >= 6 && ch == 3) m->weight[ch] = 0.0;
+        else if (m->channels >= 6 && ch > 3) m->weight[ch] = 1.41;
+        else m->weight[ch] = 1.0;
+    }
+}
+
+static gdouble power_to_db(gdouble power, gdouble offset)
+{
+    return power > 0.0 ? MAX(offset + 10.0 * log10(power), AUDIO_METER_FLOOR_DB) : AUDIO_METER_FLOOR_DB;
+}
+
+static gdouble blocks_loudness(const AudioMeter *m, guint n)
+{
+    n = (guint)MIN((guint64)n, m->block_count);
+    if (n == 0) return AUDIO_METER_FLOOR_DB;
+    gdouble sum = 0.0;
+    for (guint i = 0; i < n; i++) sum += m->blocks[(m->block_next + SHORT_TERM_BLOCKS - 1 - i) % SHORT_TERM_BLOCKS];
+    return power_to_db(sum / n, -0.691);
+}
+
+static void end_block(AudioMeter *m)
+{
+    gdouble power = 0.0;
+    for (guint ch = 0; ch < m->channels; ch++) power += m->weight[ch] * m->block_sum[ch] / m->block_frames;
+    m->blocks[m->block_next] = power;
+    m->block_next = (m->block_next + 1) % SHORT_TERM_BLOCKS;
+    m->block_count++;
+
+    if (20.0 * log10(MAX(m->block_peak, 1e-9f)) < AUDIO_METER_SILENCE_DBFS) m->silent_frames += m->block_frames;
+    else m->silent_frames = 0;
+
+    memset(m->block_sum, 0, sizeof(m->block_sum));
+    m->block_peak = 0.0f;
+    m->block_fill = 0;
+}
+
+// =============================================================================
+// Meter
+// =============================================================================
+
+AudioMeter *audio_meter_new(guint rate, guint channels)
+{
+    if (channels == 0 || channels > AUDIO_METER_MAX_CHANNELS || rate < 8000) {
+        g_printerr("AudioMeter: unsupported layout: %u channels at %u Hz\n", channels, rate);
+        return NULL;
+    }
+    pthread_once(&simd_once, select_simd_level);
+
+    AudioMeter *m = g_new0(AudioMeter, 1);
+    g_mutex_init(&m->lock);
+    m->rate = rate;
+    m->channels = channels;
+    m->block_frames = rate / BLOCKS_PER_SEC;
+    k_weighting_init(m);
+    channel_weights_init(m);
+    return m;
+}
+
+void audio_meter_free(AudioMeter *m)
+{
+    if (!m) return;
+    g_mutex_clear(&m->lock);
+    g_free(m);
+}
+
+void audio_meter_process(AudioMeter *m, const gfloat *samples, gsize frames)
+{
+    g_mutex_lock(&m->lock);
+    while (frames > 0) {
+        gsize n = MIN(MIN(frames, (gsize)CHUNK_FRAMES), (gsize)(m->block_frames - m->block_fill));
+
+        for (guint ch = 0; ch < m->channels; ch++) {
+            for (gsize i = 0; i < n; i++) m->raw[i] = samples[i * m->channels + ch];
+
+            gfloat peak = audio_meter_peak(m->raw, n);
+            m->window_peak[ch] = MAX(m->window_peak[ch], peak);
+            m->block_peak = MAX(m->block_peak, peak);
+            m->window_sum[ch] += audio_meter_sum_squares(m->raw, n);
+
+            k_weight(m, ch, m->raw, m->weighted, n);
+            m->block_sum[ch] += audio_meter_sum_squares(m->weighted, n);
+        }
+
+        samples += n * m->channels;
+        frames -= n;
+        m->block_fill += n;
+        m->window_frames += n;
+        m->frames += n;
+        if (m->block_fill == m->block_frames) end_block(m);
+    }
+    g_mutex_unlock(&m->lock);
+}
+
+void audio_meter_get_stats(AudioMeter *m, AudioMeterStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    g_mutex_lock(&m->lock);
+    stats->rate = m->rate;
+    stats->channels = m->channels;
+    for (guint ch = 0; ch < m->channels; ch++) {
+        stats->peak_dbfs[ch] = power_to_db((gdouble)m->window_peak[ch] * m->window_peak[ch], 0.0);
+        stats->rms_dbfs[ch] = m->window_frames ? power_to_db(m->window_sum[ch] / m->window_frames, 0.0)
+                                               : AUDIO_METER_FLOOR_DB;
+    }
+    stats->momentary_lufs = blocks_loudness(m, MOMENTARY_BLOCKS);
+    stats->short_term_lufs = blocks_loudness(m, SHORT_TERM_BLOCKS);
+    stats->frames = m->frames;
+    stats->silent_ms = (gint64)(m->silent_frames * 1000 / m->rate);
+
+    memset(m->window_peak, 0, sizeof(m->window_peak));
+    memset(m->window_sum, 0, sizeof(m->window_sum));
+    m->window_frames = 0;
+    g_mutex_unlock(&m->lock);
+}
+
+// One decimal is plenty for a meter and keeps the stats line short
+static gdouble round_db(gdouble db)
+{
+    return round(db * 10.0) / 10.0;
+}
+
+void audio_meter_stats_to_json(const AudioMeterStats *stats, cJSON *obj)
+{
+    cJSON_AddNumberToObject(obj, "rate", stats->rate);
+    cJSON_AddNumberToObject(obj, "channels", stats->channels);
+    cJSON *peak = cJSON_AddArrayToObject(obj, "peak-dbfs");
+    cJSON *rms = cJSON_AddArrayToObject(obj, "rms-dbfs");
+    for (guint ch = 0; ch < stats->channels; ch++) {
+        cJSON_AddItemToArray(peak, cJSON_CreateNumber(round_db(stats->peak_dbfs[ch])));
+        cJSON_AddItemToArray(rms, cJSON_CreateNumber(round_db(stats->rms_dbfs[ch])));
+    }
+    cJSON_AddNumberToObject(obj, "momentary-lufs", round_db(stats->momentary_lufs));
+    cJSON_AddNumberToObject(obj, "short-term-lufs", round_db(stats->short_term_lufs));
+    cJSON_AddNumberToObject(obj, "silent-ms", (double)stats->silent_ms);
+}
@@ -0,0 +1,343 @@
+#include "buffer_batch.h"
+
+#define DEFAULT_MAX_BUFFERS 32
+#define DEFAULT_MAX_BYTES (64 * 1024)
+#define DEFAULT_MAX_LATENCY (2 * GST_MSECOND)
+
+enum {
+    PROP_0,
+    PROP_MAX_BUFFERS,
+    PROP_MAX_BYTES,
+    PROP_MAX_LATENCY,
+};
+
+struct _BgBufferBatch {
+    GstElement parent;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+
+    // Held around taking a list out and pushing it, by the streaming thread and the flush task alike,
+    // so lists leave in order. Taken before `lock`, never from anything downstream can call into.
+    GMutex push_lock;
+
+    // Protects everything below and is never held while pushing, so downstream may query the element
+    // or read its properties. `cond` wakes the flush task when a list starts and on flushing.
+    GMutex lock;
+    GCond cond;
+    GstBufferList *pending;
+    gsize pending_bytes;
+    gint64 deadline; // Monotonic time by which the pending list must leave
+    gboolean flushing;
+    GstFlowReturn srcresult; // Of the flush task's last push, returned upstream
+
+    guint max_buffers;
+    guint max_bytes;
+    GstClockTime max_latency;
+
+    guint64 lists_pushed;
+    guint64 buffers_pushed;
+};
+
+G_DEFINE_TYPE(BgBufferBatch, bg_buffer_batch, GST_TYPE_ELEMENT)
+
+static GstStaticPadTemplate sink_template =
+    GST_STATIC_PAD_TEMPLATE("sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate src_template =
+    GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+static GstBufferList *take_pending_locked(BgBufferBatch *self)
+{
+    GstBufferList *list = self->pending;
+    if (!list) return NULL;
+    self->pending = NULL;
+    self->pending_bytes = 0;
+    self->lists_pushed++;
+    self->buffers_pushed += gst_buffer_list_length(list);
+    return list;
+}
+
+static void drop_pending_locked(BgBufferBatch *self)
+{
+    if (self->pending) {
+        gst_buffer_list_unref(self->pending);
+        self->pending = NULL;
+        self->pending_bytes = 0;
+    }
+}
+
+// Errors from the flush task are reported upstream; a missing link is not an error
+static GstFlowReturn upstream_result_locked(BgBufferBatch *self)
+{
+    GstFlowReturn ret = self->flushing ? GST_FLOW_FLUSHING : self->srcresult;
+    return ret == GST_FLOW_NOT_LINKED ? GST_FLOW_OK : ret;
+}
+
+// Source pad task: sleep until the pending list reaches max-latency, then push it
+static void bg_buffer_batch_loop(gpointer user_data)
+{
+    BgBufferBatch *self = BG_BUFFER_BATCH(user_data);
+
+    g_mutex_lock(&self->lock);
+    while (!self->flushing && (!self->pending || self->deadline > g_get_monotonic_time())) {
+        if (self->pending) {
+            g_cond_wait_until(&self->cond, &self->lock, self->deadline);
+        } else {
+            g_cond_wait(&self->cond, &self->lock);
+        }
+    }
+    gboolean flushing = self->flushing;
+    g_mutex_unlock(&self->lock);
+    if (flushing) {
+        gst_pad_pause_task(self->srcpad);
+        return;
+    }
+
+    // The streaming thread may have filled and pushed that list meanwhile: only one still due leaves
+    g_mutex_lock(&self->push_lock);
+    g_mutex_lock(&self->lock);
+    GstBufferList *list = self->deadline <= g_get_monotonic_time() ? take_pending_locked(self) : NULL;
+    g_mutex_unlock(&self->lock);
+    GstFlowReturn ret = list ? gst_pad_push_list(self->srcpad, list) : GST_FLOW_OK;
+    g_mutex_unlock(&self->push_lock);
+
+    if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED) {
+        g_mutex_lock(&self->lock);
+        self->srcresult = ret;
+        g_mutex_unlock(&self->lock);
+        gst_pad_pause_task(self->srcpad);
+    }
+}
+
+// Add buffers (taking ownership) to the pending list, pushing each list that fills up
+static GstFlowReturn add_buffers(BgBufferBatch *self, GstBuffer **buffers, guint n)
+{
+    GstFlowReturn ret = GST_FLOW_OK;
+    guint i = 0;
+
+    g_mutex_lock(&self->push_lock);
+    while (i < n && ret == GST_FLOW_OK) {
+        GstBufferList *full = NULL;
+        g_mutex_lock(&self->lock);
+        ret = upstream_result_locked(self);
+        for (; i < n && ret == GST_FLOW_OK && !full; i++) {
+            if (!self->pending) {
+                self->pending = gst_buffer_list_new_sized(self->max_buffers);
+                self->deadline = g_get_monotonic_time() + (gint64)(self->max_latency / GST_USECOND);
+                g_cond_signal(&self->cond);
+            }
+            self->pending_bytes += gst_buffer_get_size(buffers[i]);
+            gst_buffer_list_add(self->pending, buffers[i]);
+            if (gst_buffer_list_length(self->pending) >= self->max_buffers || self->pending_bytes >= self->max_bytes) {
+                full = take_pending_locked(self);
+            }
+        }
+        g_mutex_unlock(&self->lock);
+        if (full) ret = gst_pad_push_list(self->srcpad, full);
+    }
+    g_mutex_unlock(&self->push_lock);
+
+    for (; i < n; i++) gst_buffer_unref(buffers[i]); // Refused after a flow error
+    return ret;
+}
+
+static GstFlowReturn bg_buffer_batch_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    (void)pad;
+    return add_buffers(BG_BUFFER_BATCH(parent), &buffer, 1);
+}
+
+static GstFlowReturn bg_buffer_batch_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+    (void)pad;
+    guint n = gst_buffer_list_length(list);
+    GstBuffer **buffers = g_newa(GstBuffer *, n);
+    for (guint i = 0; i < n; i++) buffers[i] = gst_buffer_ref(gst_buffer_list_get(list, i));
+    gst_buffer_list_unref(list);
+    return add_buffers(BG_BUFFER_BATCH(parent), buffers, n);
+}
+
+static gboolean bg_buffer_batch_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
+{
+    BgBufferBatch *self = BG_BUFFER_BATCH(parent);
+
+    switch (GST_EVENT_TYPE(event)) {
+        case GST_EVENT_FLUSH_START: {
+            // Out of band, possibly while a push is blocked downstream: push_lock is not taken
+            g_mutex_lock(&self->lock);
+            self->flushing = TRUE;
+            drop_pending_locked(self);
+            g_cond_broadcast(&self->cond);
+            g_mutex_unlock(&self->lock);
+            gboolean res = gst_pad_push_event(self->srcpad, event);
+            gst_pad_pause_task(self->srcpad);
+            return res;
+        }
+        case GST_EVENT_FLUSH_STOP: {
+            g_mutex_lock(&self->lock);
+            drop_pending_locked(self);
+            self->flushing = FALSE;
+            self->srcresult = GST_FLOW_OK;
+            g_mutex_unlock(&self->lock);
+            gboolean res = gst_pad_push_event(self->srcpad, event);
+            gst_pad_start_task(self->srcpad, bg_buffer_batch_loop, self, NULL);
+            return res;
+        }
+        default:
+            break;
+    }
+
+    if (!GST_EVENT_IS_SERIALIZED(event)) return gst_pad_event_default(pad, parent, event);
+
+    // Serialized events (EOS, segment, caps) must not overtake the buffers in front of them
+    g_mutex_lock(&self->push_lock);
+    g_mutex_lock(&self->lock);
+    GstBufferList *list = take_pending_locked(self);
+    g_mutex_unlock(&self->lock);
+    if (list) gst_pad_push_list(self->srcpad, list);
+    gboolean res = gst_pad_event_default(pad, parent, event);
+    g_mutex_unlock(&self->push_lock);
+    return res;
+}
+
+static gboolean bg_buffer_batch_src_activate_mode(GstPad *pad, GstObject *parent, GstPadMode mode, gboolean active)
+{
+    BgBufferBatch *self = BG_BUFFER_BATCH(parent);
+    if (mode != GST_PAD_MODE_PUSH) return FALSE;
+
+    g_mutex_lock(&self->lock);
+    self->flushing = !active;
+    self->srcresult = active ? GST_FLOW_OK : GST_FLOW_FLUSHING;
+    if (!active) drop_pending_locked(self);
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    return active ? gst_pad_start_task(pad, bg_buffer_batch_loop, self, NULL) : gst_pad_stop_task(pad);
+}
+
+static void bg_buffer_batch_set_property(GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
+{
+    BgBufferBatch *self = BG_BUFFER_BATCH(object);
+
+    g_mutex_lock(&self->lock);
+    switch (prop_id) {
+        case PROP_MAX_BUFFERS:
+            self->max_buffers = g_value_get_uint(value);
+            break;
+        case PROP_MAX_BYTES:
+            self->max_bytes = g_value_get_uint(value);
+            break;
+        case PROP_MAX_LATENCY:
+            self->max_latency = g_value_get_uint64(value);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+            break;
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+static void bg_buffer_batch_get_property(GObject *object, guint prop_id, GValue *value, GParamSpec *pspec)
+{
+    BgBufferBatch *self = BG_BUFFER_BATCH(object);
+
+    g_mutex_lock(&self->lock);
+    switch (prop_id) {
+        case PROP_MAX_BUFFERS:
+            g_value_set_uint(value, self->max_buffers);
+            break;
+        case PROP_MAX_BYTES:
+            g_value_set_uint(value, self->max_bytes);
+            break;
+        case PROP_MAX_LATENCY:
+            g_value_set_uint64(value, self->max_latency);
+            break;
+        default:
+            G_OBJECT_WARN_INVALID_PROPERTY_ID(object, prop_id, pspec);
+            break;
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+static void bg_buffer_batch_finalize(GObject *object)
+{
+    BgBufferBatch *self = BG_BUFFER_BATCH(object);
+
+    drop_pending_locked(self);
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->lock);
+    g_mutex_clear(&self->push_lock);
+
+    G_OBJECT_CLASS(bg_buffer_batch_parent_class)->finalize(object);
+}
+
+static void bg_buffer_batch_class_init(BgBufferBatchClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+
+    gobject_class->set_property = bg_buffer_batch_set_property;
+    gobject_class->get_property = bg_buffer_batch_get_property;
+    gobject_class->finalize = bg_buffer_batch_finalize;
+
+    g_object_class_install_property(
+        gobject_class, PROP_MAX_BUFFERS,
+        g_param_spec_uint("max-buffers", "Max buffers", "Buffers per list", 1, G_MAXUINT, DEFAULT_MAX_BUFFERS,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class, PROP_MAX_BYTES,
+        g_param_spec_uint("max-bytes", "Max bytes", "Bytes per list", 1, G_MAXUINT, DEFAULT_MAX_BYTES,
+                          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+    g_object_class_install_property(
+        gobject_class, PROP_MAX_LATENCY,
+        g_param_spec_uint64("max-latency", "Max latency", "Longest time a buffer is held (ns)", 0, G_MAXUINT64,
+                            DEFAULT_MAX_LATENCY, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    gst_element_class_set_static_metadata(element_class, "Buffer batcher", "Generic",
+                                          "Groups buffers into buffer lists within a latency bound", "Blackgate");
+    gst_element_class_add_static_pad_template(element_class, &sink_template);
+    gst_element_class_add_static_pad_template(element_class, &src_template);
+}
+
+static void bg_buffer_batch_init(BgBufferBatch *self)
+{
+    g_mutex_init(&self->push_lock);
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+    self->flushing = TRUE;
+    self->srcresult = GST_FLOW_FLUSHING;
+    self->max_buffers = DEFAULT_MAX_BUFFERS;
+    self->max_bytes = DEFAULT_MAX_BYTES;
+    self->max_latency = DEFAULT_MAX_LATENCY;
+
+    self->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+    gst_pad_set_chain_function(self->sinkpad, bg_buffer_batch_chain);
+    gst_pad_set_chain_list_function(self->sinkpad, bg_buffer_batch_chain_list);
+    gst_pad_set_event_function(self->sinkpad, bg_buffer_batch_sink_event);
+    GST_PAD_SET_PROXY_CAPS(self->sinkpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->sinkpad);
+
+    self->srcpad = gst_pad_new_from_static_template(&src_template, "src");
+    gst_pad_set_activatemode_function(self->srcpad, bg_buffer_batch_src_activate_mode);
+    GST_PAD_SET_PROXY_CAPS(self->srcpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->srcpad);
+}
+
+gboolean buffer_batch_register(void)
+{
+    return gst_element_register(NULL, "bgbatch", GST_RANK_NONE, BG_TYPE_BUFFER_BATCH);
+}
+
+void buffer_batch_add_stats(GstElement *batch, cJSON *root)
+{
+    BgBufferBatch *self = BG_BUFFER_BATCH(batch);
+
+    g_mutex_lock(&self->lock);
+    guint64 lists = self->lists_pushed;
+    guint64 buffers = self->buffers_pushed;
+    g_mutex_unlock(&self->lock);
+
+    cJSON_AddNumberToObject(root, "batch-lists", (double)lists);
+    cJSON_AddNumberToObject(root, "batch-buffers", (double)buffers);
+    cJSON_AddNumberToObject(root, "batch-avg-size", lists ? (double)buffers / lists : 0.0);
+}
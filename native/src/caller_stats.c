@@ -0,0 +1,167 @@
+#include "caller_stats.h"
+
+typedef struct {
+    gpointer key;
+    char address[64]; // Formatted once when the caller is first seen
+    CallerSample sample;
+    gint64 lost_delta; // Since the previous report
+    gdouble loss_percent;
+    guint64 seen; // Report in which the caller was last updated
+} CallerEntry;
+
+struct CallerStats {
+    GHashTable *callers; // key -> CallerEntry
+    CallerRefFunc key_ref;
+    GDestroyNotify key_unref;
+    CallerFormatFunc format;
+
+    guint64 report;
+    guint connected; // Since the previous report
+    guint64 connected_total;
+    guint64 disconnected_total;
+};
+
+CallerStats *caller_stats_new(CallerRefFunc key_ref, GDestroyNotify key_unref, CallerFormatFunc format)
+{
+    CallerStats *cs = g_new0(CallerStats, 1);
+    cs->callers = g_hash_table_new_full(g_direct_hash, g_direct_equal, key_unref, g_free);
+    cs->key_ref = key_ref;
+    cs->key_unref = key_unref;
+    cs->format = format;
+    return cs;
+}
+
+void caller_stats_free(CallerStats *cs)
+{
+    if (!cs) return;
+    g_hash_table_destroy(cs->callers);
+    g_free(cs);
+}
+
+void caller_stats_begin(CallerStats *cs)
+{
+    cs->report++;
+}
+
+void caller_stats_update(CallerStats *cs, gpointer key, const CallerSample *sample)
+{
+    CallerEntry *entry = g_hash_table_lookup(cs->callers, key);
+    if (!entry) {
+        entry = g_new0(CallerEntry, 1);
+        entry->key = cs->key_ref ? cs->key_ref(key) : key;
+        if (cs->format) cs->format(key, entry->address, sizeof(entry->address));
+        entry->sample.packets_sent = sample->packets_sent;
+        entry->sample.packets_lost = sample->packets_lost;
+        g_hash_table_insert(cs->callers, entry->key, entry);
+        cs->connected++;
+        cs->connected_total++;
+    }
+
+    gint64 sent_delta = sample->packets_sent - entry->sample.packets_sent;
+    entry->lost_delta = MAX(sample->packets_lost - entry->sample.packets_lost, 0);
+    entry->loss_percent = sent_delta > 0 ? 100.0 * (gdouble)entry->lost_delta / (gdouble)sent_delta : 0.0;
+    entry->sample = *sample;
+    entry->seen = cs->report;
+}
+
+// Keep the `k` largest entries by `worse` in descending order; returns the new count
+static guint top_k_insert(CallerEntry **top, guint n, guint k, CallerEntry *entry,
+                          gboolean (*worse)(const CallerEntry *, const CallerEntry *))
+{
+    if (n == k && !worse(entry, top[n - 1])) return n;
+    guint i = n < k ? n++ : n - 1;
+    while (i > 0 && worse(entry, top[i - 1])) {
+        top[i] = top[i - 1];
+        i--;
+    }
+    top[i] = entry;
+    return n;
+}
+
+static gboolean worse_loss(const CallerEntry *a, const CallerEntry *b)
+{
+    if (a->loss_percent != b->loss_percent) return a->loss_percent > b->loss_percent;
+    return a->lost_delta > b->lost_delta;
+}
+
+static gboolean worse_rtt(const CallerEntry *a, const CallerEntry *b)
+{
+    return a->sample.rtt_ms > b->sample.rtt_ms;
+}
+
+static cJSON *entry_to_json(const CallerEntry *entry)
+{
+    cJSON *obj = cJSON_CreateObject();
+    cJSON_AddStringToObject(obj, "caller-address", entry->address);
+    cJSON_AddNumberToObject(obj, "packets-sent", (double)entry->sample.packets_sent);
+    cJSON_AddNumberToObject(obj, "packets-sent-lost", (double)entry->sample.packets_lost);
+    cJSON_AddNumberToObject(obj, "packets-retransmitted", (double)entry->sample.packets_retransmitted);
+    cJSON_AddNumberToObject(obj, "packets-sent-dropped", (double)entry->sample.packets_dropped);
+    cJSON_AddNumberToObject(obj, "bytes-sent", (double)entry->sample.bytes_sent);
+    cJSON_AddNumberToObject(obj, "rtt-ms", entry->sample.rtt_ms);
+    cJSON_AddNumberToObject(obj, "send-rate-mbps", entry->sample.send_rate_mbps);
+    cJSON_AddNumberToObject(obj, "loss-percent", entry->loss_percent);
+    return obj;
+}
+
+void caller_stats_end(CallerStats *cs, gboolean detail, cJSON *root)
+{
+    guint disconnected = 0;
+    CallerSample total = {0};
+    gdouble rtt_max = 0.0;
+    CallerEntry *worst_loss[CALLER_STATS_TOP_K], *worst_rtt[CALLER_STATS_TOP_K];
+    guint n_loss = 0, n_rtt = 0;
+
+    GHashTableIter iter;
+    gpointer value;
+    g_hash_table_iter_init(&iter, cs->callers);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) {
+        CallerEntry *entry = value;
+        if (entry->seen != cs->report) {
+            g_hash_table_iter_remove(&iter);
+            disconnected++;
+            continue;
+        }
+
+        total.packets_sent += entry->sample.packets_sent;
+        total.packets_lost += entry->sample.packets_lost;
+        total.packets_retransmitted += entry->sample.packets_retransmitted;
+        total.packets_dropped += entry->sample.packets_dropped;
+        total.bytes_sent += entry->sample.bytes_sent;
+        total.rtt_ms += entry->sample.rtt_ms;
+        total.send_rate_mbps += entry->sample.send_rate_mbps;
+        rtt_max = MAX(rtt_max, entry->sample.rtt_ms);
+
+        if (entry->lost_delta > 0) n_loss = top_k_insert(worst_loss, n_loss, CALLER_STATS_TOP_K, entry, worse_loss);
+        n_rtt = top_k_insert(worst_rtt, n_rtt, CALLER_STATS_TOP_K, entry, worse_rtt);
+    }
+    cs->disconnected_total += disconnected;
+
+    guint n = g_hash_table_size(cs->callers);
+    cJSON_AddNumberToObject(root, "connected-callers", n);
+    cJSON_AddNumberToObject(root, "callers-connected", cs->connected);
+    cJSON_AddNumberToObject(root, "callers-disconnected", disconnected);
+    cJSON_AddNumberToObject(root, "callers-connected-total", (double)cs->connected_total);
+    cJSON_AddNumberToObject(root, "callers-disconnected-total", (double)cs->disconnected_total);
+    cs->connected = 0;
+
+    cJSON *aggregate = cJSON_AddObjectToObject(root, "callers-aggregate");
+    cJSON_AddNumberToObject(aggregate, "packets-sent", (double)total.packets_sent);
+    cJSON_AddNumberToObject(aggregate, "packets-sent-lost", (double)total.packets_lost);
+    cJSON_AddNumberToObject(aggregate, "packets-retransmitted", (double)total.packets_retransmitted);
+    cJSON_AddNumberToObject(aggregate, "packets-sent-dropped", (double)total.packets_dropped);
+    cJSON_AddNumberToObject(aggregate, "bytes-sent", (double)total.bytes_sent);
+    cJSON_AddNumberToObject(aggregate, "send-rate-mbps", total.send_rate_mbps);
+    cJSON_AddNumberToObject(aggregate, "rtt-ms-avg", n ? total.rtt_ms / n : 0.0);
+    cJSON_AddNumberToObject(aggregate, "rtt-ms-max", rtt_max);
+
+    cJSON *loss = cJSON_AddArrayToObject(root, "callers-worst-loss");
+    for (guint i = 0; i < n_loss; i++) cJSON_AddItemToArray(loss, entry_to_json(worst_loss[i]));
+    cJSON *rtt = cJSON_AddArrayToObject(root, "callers-worst-rtt");
+    for (guint i = 0; i < n_rtt; i++) cJSON_AddItemToArray(rtt, entry_to_json(worst_rtt[i]));
+
+    cJSON *callers = cJSON_AddArrayToObject(root, "callers");
+    if (!detail && n > CALLER_STATS_DETAIL_LIMIT) return;
+    g_hash_table_iter_init(&iter, cs->callers);
+    while (g_hash_table_iter_next(&iter, NULL, &value)) cJSON_AddItemToArray(callers, entry_to_json(value));
+}
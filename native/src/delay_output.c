@@ -0,0 +1,223 @@
+#include "delay_output.h"
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "thread_policy.h"
+
+#define MAX_DESTS 32
+#define IDLE_WAIT_US (100 * 1000) // Upper bound on a wait with nothing stored; pushes wake the thread
+
+typedef struct {
+    int sink_index;
+    gint reader;
+    GstPad *pad; // Our src pad, linked to the sink element's sink pad
+    guint64 push_errors;
+} DelayDest;
+
+struct DelayOutput {
+    DelayRing *ring;
+    gboolean copy_input;
+    pthread_t thread;
+
+    GMutex lock;
+    GCond cond;
+    gboolean idle; // The thread is waiting with nothing stored
+    gboolean stopping;
+    DelayDest dests[MAX_DESTS];
+    guint n_dests;
+};
+
+static gpointer buffer_ref(gpointer item)
+{
+    return gst_buffer_ref(GST_BUFFER_CAST(item));
+}
+
+static void buffer_unref(gpointer item)
+{
+    gst_buffer_unref(GST_BUFFER_CAST(item));
+}
+
+static void *delay_main(void *arg)
+{
+    DelayOutput *out = arg;
+    thread_policy_apply_self(THREAD_ROLE_SINK, "delay");
+
+    g_mutex_lock(&out->lock);
+    while (!out->stopping) {
+        guint n_dests = out->n_dests;
+        g_mutex_unlock(&out->lock);
+
+        // Destinations are only added before the pipeline starts, so the first n_dests are stable
+        gint64 now = g_get_monotonic_time();
+        for (guint i = 0; i < n_dests; i++) {
+            DelayDest *dest = &out->dests[i];
+            GstBuffer *buffer;
+            while ((buffer = delay_ring_pop(out->ring, dest->reader, now))) {
+                GstFlowReturn ret = gst_pad_push(dest->pad, buffer);
+                if (ret != GST_FLOW_OK && ret != GST_FLOW_FLUSHING) {
+                    __atomic_add_fetch(&dest->push_errors, 1, __ATOMIC_RELAXED);
+                }
+            }
+        }
+
+        // Under the lock, so a push after this finds the thread idle and wakes it
+        g_mutex_lock(&out->lock);
+        gint64 due = delay_ring_next_due(out->ring);
+        if (out->stopping) break;
+        if (due < 0) {
+            out->idle = TRUE;
+            g_cond_wait_until(&out->cond, &out->lock, g_get_monotonic_time() + IDLE_WAIT_US);
+            out->idle = FALSE;
+        } else if (due > g_get_monotonic_time()) {
+            g_cond_wait_until(&out->cond, &out->lock, due);
+        }
+    }
+    g_mutex_unlock(&out->lock);
+    thread_policy_forget_self();
+    return NULL;
+}
+
+DelayOutput *delay_output_new(cJSON *config, gint64 max_delay_us, gboolean copy_input)
+{
+    DelayRing *ring = delay_ring_new(config, max_delay_us, buffer_ref, buffer_unref);
+    if (!ring) return NULL;
+
+    DelayOutput *out = g_new0(DelayOutput, 1);
+    out->ring = ring;
+    out->copy_input = copy_input;
+    g_mutex_init(&out->lock);
+    g_cond_init(&out->cond);
+    if (pthread_create(&out->thread, NULL, delay_main, out) != 0) {
+        g_printerr("Delay: Failed to create the delay thread\n");
+        delay_ring_free(ring);
+        g_cond_clear(&out->cond);
+        g_mutex_clear(&out->lock);
+        g_free(out);
+        return NULL;
+    }
+
+    DelayRingStats stats;
+    delay_ring_get_stats(ring, &stats);
+    g_print("Delay: Ring of %" G_GUINT64_FORMAT " bytes (%u buffers) for delays up to %" G_GINT64_FORMAT " ms\n",
+            stats.max_bytes, stats.capacity, max_delay_us / 1000);
+    return out;
+}
+
+void delay_output_free(DelayOutput *out)
+{
+    if (!out) return;
+
+    g_mutex_lock(&out->lock);
+    out->stopping = TRUE;
+    g_cond_signal(&out->cond);
+    g_mutex_unlock(&out->lock);
+    pthread_join(out->thread, NULL);
+
+    for (guint i = 0; i < out->n_dests; i++) {
+        GstPad *pad = out->dests[i].pad;
+        GstPad *peer = gst_pad_get_peer(pad);
+        if (peer) {
+            gst_pad_unlink(pad, peer);
+            gst_object_unref(peer);
+        }
+        gst_pad_set_active(pad, FALSE);
+        gst_object_unref(pad);
+    }
+
+    delay_ring_free(out->ring);
+    g_cond_clear(&out->cond);
+    g_mutex_clear(&out->lock);
+    g_free(out);
+}
+
+gboolean delay_output_add_dest(DelayOutput *out, GstPad *sinkpad, int sink_index, gint64 delay_us)
+{
+    char name[32];
+    snprintf(name, sizeof(name), "delay-%d", sink_index);
+    if (out->n_dests >= MAX_DESTS) {
+        g_printerr("Delay: At most %d delayed destinations\n", MAX_DESTS);
+        return FALSE;
+    }
+
+    GstPad *pad = gst_pad_new(name, GST_PAD_SRC);
+    gst_pad_set_active(pad, TRUE);
+    if (gst_pad_link(pad, sinkpad) != GST_PAD_LINK_OK) {
+        g_printerr("Delay: Failed to link %s\n", name);
+        gst_pad_set_active(pad, FALSE);
+        gst_object_unref(pad);
+        return FALSE;
+    }
+
+    // Sticky events stay pending on our pad and reach the sink with the first buffer
+    gst_pad_push_event(pad, gst_event_new_stream_start(name));
+    GstSegment segment;
+    gst_segment_init(&segment, GST_FORMAT_TIME);
+    gst_pad_push_event(pad, gst_event_new_segment(&segment));
+
+    g_mutex_lock(&out->lock);
+    DelayDest *dest = &out->dests[out->n_dests];
+    dest->sink_index = sink_index;
+    dest->reader = delay_ring_add_reader(out->ring, delay_us);
+    dest->pad = pad;
+    dest->push_errors = 0;
+    out->n_dests++;
+    g_mutex_unlock(&out->lock);
+
+    g_print("Sink %d: delayed by %" G_GINT64_FORMAT " ms\n", sink_index, delay_us / 1000);
+    return TRUE;
+}
+
+void delay_output_push(DelayOutput *out, GstBuffer *buffer)
+{
+    GstBuffer *stored = out->copy_input ? gst_buffer_copy_deep(buffer) : buffer;
+    GstMapInfo map;
+    if (gst_buffer_map(stored, &map, GST_MAP_READ)) {
+        delay_ring_push(out->ring, stored, map.data, map.size, g_get_monotonic_time());
+        gst_buffer_unmap(stored, &map);
+    }
+    if (stored != buffer) gst_buffer_unref(stored);
+
+    g_mutex_lock(&out->lock);
+    if (out->idle) g_cond_signal(&out->cond);
+    g_mutex_unlock(&out->lock);
+}
+
+void delay_output_push_list(DelayOutput *out, GstBufferList *list)
+{
+    guint n = gst_buffer_list_length(list);
+    for (guint i = 0; i < n; i++) delay_output_push(out, gst_buffer_list_get(list, i));
+}
+
+void delay_output_add_stats(DelayOutput *out, cJSON *root)
+{
+    DelayRingStats stats;
+    delay_ring_get_stats(out->ring, &stats);
+
+    cJSON *delay = cJSON_AddObjectToObject(root, "delay");
+    cJSON_AddNumberToObject(delay, "bytes", (double)stats.bytes);
+    cJSON_AddNumberToObject(delay, "max-bytes", (double)stats.max_bytes);
+    cJSON_AddNumberToObject(delay, "buffers", stats.entries);
+    cJSON_AddNumberToObject(delay, "capacity", stats.capacity);
+    cJSON_AddStringToObject(delay, "clock", stats.pcr_clock ? "pcr" : "arrival");
+    cJSON_AddNumberToObject(delay, "resyncs", (double)stats.resyncs);
+    cJSON_AddNumberToObject(delay, "overruns", (double)stats.overruns);
+
+    cJSON *dests = cJSON_AddArrayToObject(delay, "destinations");
+    g_mutex_lock(&out->lock);
+    for (guint i = 0; i < out->n_dests; i++) {
+        DelayReaderStats reader;
+        delay_ring_get_reader_stats(out->ring, out->dests[i].reader, &reader);
+        guint64 push_errors = __atomic_load_n(&out->dests[i].push_errors, __ATOMIC_RELAXED);
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddNumberToObject(entry, "sink", out->dests[i].sink_index);
+        cJSON_AddNumberToObject(entry, "delay-ms", (double)reader.delay_ms);
+        cJSON_AddNumberToObject(entry, "buffers", (double)reader.buffers);
+        cJSON_AddNumberToObject(entry, "bytes", (double)reader.bytes);
+        cJSON_AddNumberToObject(entry, "overruns", (double)reader.overruns);
+        cJSON_AddNumberToObject(entry, "lateness-max-ms", (double)reader.lateness_max_us / 1000.0);
+        cJSON_AddNumberToObject(entry, "push-errors", (double)push_errors);
+        cJSON_AddItemToArray(dests, entry);
+    }
+    g_mutex_unlock(&out->lock);
+}
@@ -0,0 +1,288 @@
+#include "delay_ring.h"
+
+#define MIN_CAPACITY 1024
+#define MIN_MAX_BITRATE 100000
+#define MAX_MAX_BITRATE 1000000000
+#define MAX_PCR_GAP (TS_PCR_HZ / 2)            // Longer gaps (spec: 100 ms) or a PCR going backwards: resync
+#define MAX_PCR_SILENCE_US (G_USEC_PER_SEC / 2) // No PCR for this long: back to arrival time
+#define MAX_CLOCK_LAG_US (2 * G_USEC_PER_SEC)   // Arrivals this far behind the clock for good: resync
+#define SLEW_PPM 200                            // How fast the offset may follow a sender clock slower than ours
+
+typedef struct {
+    gpointer item;
+    gint64 time_us; // On the stream clock
+    guint size;
+} DelayEntry;
+
+typedef struct {
+    gint64 delay_us;
+    guint64 next; // Sequence number of the next entry to take
+    DelayReaderStats stats;
+} DelayReader;
+
+struct DelayRing {
+    GMutex lock;
+    DelayRingRefFunc ref;
+    GDestroyNotify unref;
+
+    // Entries [head, tail) by sequence number, at entries[seq % capacity]
+    DelayEntry *entries;
+    guint capacity;
+    guint64 head;
+    guint64 tail;
+    guint64 bytes;
+    guint64 max_bytes;
+
+    DelayReader readers[DELAY_RING_MAX_READERS];
+    guint reader_count;
+
+    // Stream clock
+    TsSync sync;
+    gint pcr_pid; // -1 until a PCR is seen
+    gboolean have_pcr;
+    guint64 last_pcr;     // Unwrapped, 27 MHz
+    gint64 last_pcr_at;   // Arrival of the last PCR
+    gint64 offset_us;     // Arrival minus PCR time of the earliest arrival, slewed
+    gint64 correction_us; // Stream time minus arrival time as of the last PCR
+    gint64 last_time_us;
+    gboolean buffer_has_pcr; // Only valid during delay_ring_push
+    guint64 buffer_pcr;
+
+    guint64 resyncs;
+    guint64 overruns;
+};
+
+// =============================================================================
+// Stream Clock
+// =============================================================================
+
+static void on_packet(const guint8 *pkt, guint16 pid, gpointer user_data)
+{
+    DelayRing *r = user_data;
+
+    guint64 pcr;
+    if (r->buffer_has_pcr || (r->pcr_pid >= 0 && pid != r->pcr_pid) || !ts_packet_pcr(pkt, &pcr)) return;
+    r->pcr_pid = pid;
+    r->buffer_has_pcr = TRUE;
+    r->buffer_pcr = pcr;
+}
+
+static void start_clock(DelayRing *r, guint64 pcr, gint64 now_us)
+{
+    r->have_pcr = TRUE;
+    r->last_pcr = pcr;
+    r->offset_us = now_us - (gint64)(pcr / 27);
+}
+
+// The pushed buffer's time from its first PCR, or its arrival time corrected like the last PCR
+static gint64 stream_time(DelayRing *r, gint64 now_us)
+{
+    if (r->buffer_has_pcr) {
+        guint64 delta = (r->buffer_pcr + TS_PCR_WRAP - r->last_pcr % TS_PCR_WRAP) % TS_PCR_WRAP;
+        if (!r->have_pcr) {
+            start_clock(r, r->buffer_pcr, now_us);
+        } else if (delta == 0 || delta > MAX_PCR_GAP) {
+            r->resyncs++;
+            start_clock(r, r->buffer_pcr, now_us);
+        } else {
+            r->last_pcr += delta;
+            gint64 measured = now_us - (gint64)(r->last_pcr / 27);
+            if (measured < r->offset_us) {
+                r->offset_us = measured;
+            } else if (measured - r->offset_us > MAX_CLOCK_LAG_US) {
+                // Arrivals are far behind the clock for good (sender restarted its clock, long stall)
+                r->resyncs++;
+                r->offset_us = measured;
+            } else {
+                r->offset_us = MIN(measured, r->offset_us + (gint64)(delta / 27) * SLEW_PPM / 1000000);
+            }
+        }
+        r->last_pcr_at = now_us;
+        r->correction_us = (gint64)(r->last_pcr / 27) + r->offset_us - now_us;
+    } else if (r->have_pcr && now_us - r->last_pcr_at > MAX_PCR_SILENCE_US) {
+        // The PCR PID went quiet (or moved): arrival time until a PCR comes back
+        r->have_pcr = FALSE;
+        r->pcr_pid = -1;
+        r->correction_us = 0;
+    }
+    // Never earlier than the buffer before it, so every reader's due times stay in order
+    return MAX(now_us + r->correction_us, r->last_time_us);
+}
+
+// =============================================================================
+// Ring
+// =============================================================================
+
+// Release the entries every reader has taken
+static void trim(DelayRing *r)
+{
+    guint64 oldest_next = r->tail;
+    for (guint i = 0; i < r->reader_count; i++) oldest_next = MIN(oldest_next, r->readers[i].next);
+    while (r->head < oldest_next) {
+        DelayEntry *e = &r->entries[r->head % r->capacity];
+        r->bytes -= e->size;
+        r->unref(e->item);
+        e->item = NULL;
+        r->head++;
+    }
+}
+
+// Make room by dropping the oldest entry, whether or not every reader has taken it
+static void drop_oldest(DelayRing *r)
+{
+    gboolean dropped = FALSE;
+    for (guint i = 0; i < r->reader_count; i++) {
+        if (r->readers[i].next == r->head) {
+            r->readers[i].next++;
+            r->readers[i].stats.overruns++;
+            dropped = TRUE;
+        }
+    }
+    if (dropped) r->overruns++;
+    trim(r);
+}
+
+gint64 delay_ring_parse_delay(cJSON *config)
+{
+    cJSON *item = cJSON_IsObject(config) ? cJSON_GetObjectItem(config, "delay-ms") : config;
+    if (!cJSON_IsNumber(item) || item->valuedouble < 1 || item->valuedouble > DELAY_RING_MAX_DELAY_MS) {
+        g_printerr("DelayRing: 'delay-ms' must be 1-%d\n", DELAY_RING_MAX_DELAY_MS);
+        return -1;
+    }
+    return (gint64)item->valuedouble * 1000;
+}
+
+DelayRing *delay_ring_new(cJSON *config, gint64 max_delay_us, DelayRingRefFunc ref, GDestroyNotify unref)
+{
+    if (config && !cJSON_IsObject(config)) {
+        g_printerr("DelayRing: 'delay-ring' must be an object\n");
+        return NULL;
+    }
+    if (max_delay_us < 0 || max_delay_us > (gint64)DELAY_RING_MAX_DELAY_MS * 1000) {
+        g_printerr("DelayRing: delays must be at most %d ms\n", DELAY_RING_MAX_DELAY_MS);
+        return NULL;
+    }
+
+    gint64 max_bitrate = DELAY_RING_DEFAULT_MAX_BITRATE;
+    cJSON *item = cJSON_GetObjectItem(config, "max-bitrate");
+    if (item) {
+        if (!cJSON_IsNumber(item) || item->valuedouble < MIN_MAX_BITRATE || item->valuedouble > MAX_MAX_BITRATE) {
+            g_printerr("DelayRing: 'max-bitrate' must be %d-%d bit/s\n", MIN_MAX_BITRATE, MAX_MAX_BITRATE);
+            return NULL;
+        }
+        max_bitrate = (gint64)item->valuedouble;
+    }
+
+    DelayRing *r = g_new0(DelayRing, 1);
+    g_mutex_init(&r->lock);
+    r->ref = ref;
+    r->unref = unref;
+    r->max_bytes = (guint64)(max_delay_us + G_USEC_PER_SEC) * (guint64)max_bitrate / 8 / G_USEC_PER_SEC;
+    r->capacity = (guint)MAX(r->max_bytes / DELAY_RING_BYTES_PER_ENTRY, MIN_CAPACITY);
+    r->entries = g_new0(DelayEntry, r->capacity);
+    r->pcr_pid = -1;
+    ts_sync_init(&r->sync);
+    ts_sync_filter_all(&r->sync);
+    return r;
+}
+
+void delay_ring_free(DelayRing *ring)
+{
+    if (!ring) return;
+    ring->reader_count = 0;
+    trim(ring);
+    g_free(ring->entries);
+    g_mutex_clear(&ring->lock);
+    g_free(ring);
+}
+
+gint delay_ring_add_reader(DelayRing *ring, gint64 delay_us)
+{
+    g_mutex_lock(&ring->lock);
+    gint index = -1;
+    if (ring->reader_count < DELAY_RING_MAX_READERS) {
+        index = (gint)ring->reader_count++;
+        DelayReader *reader = &ring->readers[index];
+        reader->delay_us = delay_us;
+        reader->next = ring->tail;
+        reader->stats.delay_ms = delay_us / 1000;
+    }
+    g_mutex_unlock(&ring->lock);
+    return index;
+}
+
+void delay_ring_push(DelayRing *ring, gpointer item, const guint8 *data, gsize size, gint64 now_us)
+{
+    g_mutex_lock(&ring->lock);
+    ring->buffer_has_pcr = FALSE;
+    ts_sync_feed(&ring->sync, data, size, on_packet, ring);
+    ring->last_time_us = stream_time(ring, now_us);
+
+    while (ring->tail - ring->head == ring->capacity ||
+           (ring->tail > ring->head && ring->bytes + size > ring->max_bytes)) {
+        drop_oldest(ring);
+    }
+    DelayEntry *e = &ring->entries[ring->tail % ring->capacity];
+    e->item = ring->ref(item);
+    e->time_us = ring->last_time_us;
+    e->size = (guint)size;
+    ring->tail++;
+    ring->bytes += size;
+    g_mutex_unlock(&ring->lock);
+}
+
+gpointer delay_ring_pop(DelayRing *ring, gint reader, gint64 now_us)
+{
+    gpointer item = NULL;
+    g_mutex_lock(&ring->lock);
+    DelayReader *rd = &ring->readers[reader];
+    if (rd->next < ring->tail) {
+        DelayEntry *e = &ring->entries[rd->next % ring->capacity];
+        gint64 due = e->time_us + rd->delay_us;
+        if (due <= now_us) {
+            item = ring->ref(e->item);
+            rd->next++;
+            rd->stats.buffers++;
+            rd->stats.bytes += e->size;
+            rd->stats.lateness_max_us = MAX(rd->stats.lateness_max_us, now_us - due);
+            trim(ring);
+        }
+    }
+    g_mutex_unlock(&ring->lock);
+    return item;
+}
+
+gint64 delay_ring_next_due(DelayRing *ring)
+{
+    gint64 next_due = -1;
+    g_mutex_lock(&ring->lock);
+    for (guint i = 0; i < ring->reader_count; i++) {
+        DelayReader *rd = &ring->readers[i];
+        if (rd->next == ring->tail) continue;
+        gint64 due = ring->entries[rd->next % ring->capacity].time_us + rd->delay_us;
+        if (next_due < 0 || due < next_due) next_due = due;
+    }
+    g_mutex_unlock(&ring->lock);
+    return next_due;
+}
+
+void delay_ring_get_stats(DelayRing *ring, DelayRingStats *stats)
+{
+    g_mutex_lock(&ring->lock);
+    stats->entries = (guint)(ring->tail - ring->head);
+    stats->bytes = ring->bytes;
+    stats->max_bytes = ring->max_bytes;
+    stats->capacity = ring->capacity;
+    stats->pcr_clock = ring->have_pcr;
+    stats->resyncs = ring->resyncs;
+    stats->overruns = ring->overruns;
+    g_mutex_unlock(&ring->lock);
+}
+
+void delay_ring_get_reader_stats(DelayRing *ring, gint reader, DelayReaderStats *stats)
+{
+    g_mutex_lock(&ring->lock);
+    *stats = ring->readers[reader].stats;
+    ring->readers[reader].stats.lateness_max_us = 0;
+    g_mutex_unlock(&ring->lock);
+}
@@ -0,0 +1,450 @@
+#include "fec.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FEC_X86 1
+#endif
+
+#define FEC_DIRECTION_ROW 0x40
+
+// XOR of the protected fields of the packets one FEC packet covers
+typedef struct {
+    guint16 snbase;
+    guint16 length_recovery;
+    guint8 pt_recovery;
+    guint32 ts_recovery;
+    guint max_len; // payload[max_len..] is always zero
+    guint8 payload[FEC_MAX_PAYLOAD];
+} FecAccum;
+
+struct FecEncoder {
+    guint columns;
+    guint rows;
+    gboolean row_fec;
+    guint32 ssrc;
+
+    guint16 seq;
+    guint16 column_seq;
+    guint16 row_seq;
+    guint position; // Of the next media packet in the matrix, row by row
+
+    FecAccum column_accum[FEC_MAX_COLUMNS];
+    FecAccum row_accum;
+    guint8 packet[FEC_MAX_PACKET];
+    FecEncoderStats stats;
+};
+
+static inline void put_be16(guint8 *p, guint16 v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xFF;
+}
+
+static inline void put_be32(guint8 *p, guint32 v)
+{
+    p[0] = v >> 24;
+    p[1] = (v >> 16) & 0xFF;
+    p[2] = (v >> 8) & 0xFF;
+    p[3] = v & 0xFF;
+}
+
+static inline guint16 get_be16(const guint8 *p)
+{
+    return (guint16)((p[0] << 8) | p[1]);
+}
+
+static inline guint32 get_be32(const guint8 *p)
+{
+    return ((guint32)p[0] << 24) | ((guint32)p[1] << 16) | ((guint32)p[2] << 8) | p[3];
+}
+
+static void put_rtp_header(guint8 *p, guint8 pt, guint16 seq, guint32 timestamp, guint32 ssrc)
+{
+    p[0] = 0x80; // Version 2, no padding, extension or CSRCs
+    p[1] = pt;
+    put_be16(p + 2, seq);
+    put_be32(p + 4, timestamp);
+    put_be32(p + 8, ssrc);
+}
+
+// =============================================================================
+// XOR Kernels
+// =============================================================================
+
+static void xor_scalar(guint8 *dst, const guint8 *src, gsize len)
+{
+    gsize i = 0;
+    for (; i + 8 <= len; i += 8) {
+        guint64 a, b;
+        memcpy(&a, dst + i, 8);
+        memcpy(&b, src + i, 8);
+        a ^= b;
+        memcpy(dst + i, &a, 8);
+    }
+    for (; i < len; i++) dst[i] ^= src[i];
+}
+
+#ifdef FEC_X86
+__attribute__((target("sse2"))) static void xor_sse2(guint8 *dst, const guint8 *src, gsize len)
+{
+    gsize i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(dst + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(a, b));
+    }
+    xor_scalar(dst + i, src + i, len - i);
+}
+
+__attribute__((target("avx2"))) static void xor_avx2(guint8 *dst, const guint8 *src, gsize len)
+{
+    gsize i = 0;
+    // Two vectors per iteration keep both load ports busy
+    for (; i + 64 <= len; i += 64) {
+        __m256i a0 = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i a1 = _mm256_loadu_si256((const __m256i *)(dst + i + 32));
+        __m256i b0 = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i b1 = _mm256_loadu_si256((const __m256i *)(src + i + 32));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(a0, b0));
+        _mm256_storeu_si256((__m256i *)(dst + i + 32), _mm256_xor_si256(a1, b1));
+    }
+    for (; i + 32 <= len; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(dst + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_xor_si256(a, b));
+    }
+    xor_scalar(dst + i, src + i, len - i);
+}
+#endif
+
+static void (*xor_impl)(guint8 *dst, const guint8 *src, gsize len) = xor_scalar;
+static TsSimdLevel simd_level = TS_SIMD_SCALAR;
+static pthread_once_t simd_once = PTHREAD_ONCE_INIT;
+
+static gboolean apply_simd_level(TsSimdLevel level)
+{
+    switch (level) {
+        case TS_SIMD_SCALAR:
+            xor_impl = xor_scalar;
+            break;
+#ifdef FEC_X86
+        case TS_SIMD_SSE2:
+            if (!__builtin_cpu_supports("sse2")) return FALSE;
+            xor_impl = xor_sse2;
+            break;
+        case TS_SIMD_AVX2:
+            if (!__builtin_cpu_supports("avx2")) return FALSE;
+            xor_impl = xor_avx2;
+            break;
+#endif
+        default:
+            return FALSE;
+    }
+    simd_level = level;
+    return TRUE;
+}
+
+static void select_simd_level(void)
+{
+#ifdef FEC_X86
+    __builtin_cpu_init();
+    if (!apply_simd_level(TS_SIMD_AVX2)) apply_simd_level(TS_SIMD_SSE2);
+#endif
+}
+
+gboolean fec_set_simd_level(TsSimdLevel level)
+{
+    pthread_once(&simd_once, select_simd_level);
+    return apply_simd_level(level);
+}
+
+const char *fec_simd_name(void)
+{
+    pthread_once(&simd_once, select_simd_level);
+    switch (simd_level) {
+        case TS_SIMD_AVX2:
+            return "avx2";
+        case TS_SIMD_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+void fec_xor(guint8 *dst, const guint8 *src, gsize len)
+{
+    xor_impl(dst, src, len);
+}
+
+// =============================================================================
+// Encoder
+// =============================================================================
+
+static void accum_reset(FecAccum *acc, guint16 snbase)
+{
+    memset(acc->payload, 0, acc->max_len);
+    acc->snbase = snbase;
+    acc->length_recovery = 0;
+    acc->pt_recovery = 0;
+    acc->ts_recovery = 0;
+    acc->max_len = 0;
+}
+
+static void accum_add(FecAccum *acc, const guint8 *payload, gsize len, guint32 timestamp)
+{
+    xor_impl(acc->payload, payload, len);
+    acc->length_recovery ^= (guint16)len;
+    acc->pt_recovery ^= FEC_MEDIA_PT;
+    acc->ts_recovery ^= timestamp;
+    acc->max_len = MAX(acc->max_len, (guint)len);
+}
+
+static void emit_fec(FecEncoder *enc, FecAccum *acc, FecStream stream, guint32 timestamp, FecPacketFunc func,
+                     gpointer user_data)
+{
+    gboolean row = stream == FEC_STREAM_ROW;
+    guint8 *p = enc->packet;
+
+    put_rtp_header(p, FEC_PT, row ? enc->row_seq++ : enc->column_seq++, timestamp, 0);
+    guint8 *h = p + FEC_RTP_HEADER_SIZE;
+    put_be16(h, acc->snbase);
+    put_be16(h + 2, acc->length_recovery);
+    h[4] = 0x80 | acc->pt_recovery; // E: extended header
+    h[5] = h[6] = h[7] = 0;         // Mask
+    put_be32(h + 8, acc->ts_recovery);
+    h[12] = row ? FEC_DIRECTION_ROW : 0; // X = 0, type XOR, index 0
+    h[13] = row ? 1 : enc->columns;      // Offset
+    h[14] = row ? enc->columns : enc->rows;
+    h[15] = 0; // SNBase extension bits
+    memcpy(h + FEC_HEADER_SIZE, acc->payload, acc->max_len);
+
+    func(stream, p, FEC_RTP_HEADER_SIZE + FEC_HEADER_SIZE + acc->max_len, user_data);
+    if (row) {
+        enc->stats.row_packets++;
+    } else {
+        enc->stats.column_packets++;
+    }
+}
+
+FecEncoder *fec_encoder_new(guint columns, guint rows, gboolean row_fec, guint32 ssrc)
+{
+    if (columns < FEC_MIN_COLUMNS || columns > FEC_MAX_COLUMNS || rows < FEC_MIN_ROWS || rows > FEC_MAX_ROWS ||
+        columns * rows > FEC_MAX_MATRIX) {
+        g_printerr("Fec: %ux%u matrix outside the 2022-1 limits (L 1-20, D 4-20, L x D <= 100)\n", columns, rows);
+        return NULL;
+    }
+
+    pthread_once(&simd_once, select_simd_level);
+    FecEncoder *enc = g_new0(FecEncoder, 1);
+    enc->columns = columns;
+    enc->rows = rows;
+    enc->row_fec = row_fec;
+    enc->ssrc = ssrc;
+    return enc;
+}
+
+void fec_encoder_free(FecEncoder *enc)
+{
+    g_free(enc);
+}
+
+void fec_encoder_push(FecEncoder *enc, const guint8 *payload, gsize len, guint32 timestamp, FecPacketFunc func,
+                      gpointer user_data)
+{
+    len = MIN(len, (gsize)FEC_MAX_PAYLOAD);
+    guint16 seq = enc->seq++;
+
+    put_rtp_header(enc->packet, FEC_MEDIA_PT, seq, timestamp, enc->ssrc);
+    memcpy(enc->packet + FEC_RTP_HEADER_SIZE, payload, len);
+    func(FEC_STREAM_MEDIA, enc->packet, FEC_RTP_HEADER_SIZE + len, user_data);
+    enc->stats.media_packets++;
+
+    guint column = enc->position % enc->columns;
+    guint row = enc->position / enc->columns;
+    FecAccum *col_acc = &enc->column_accum[column];
+
+    if (row == 0) accum_reset(col_acc, seq);
+    accum_add(col_acc, payload, len, timestamp);
+    if (enc->row_fec) {
+        if (column == 0) accum_reset(&enc->row_accum, seq);
+        accum_add(&enc->row_accum, payload, len, timestamp);
+    }
+
+    // Each column's FEC goes out as soon as its last row is in, spreading them over the last row
+    if (row == enc->rows - 1) emit_fec(enc, col_acc, FEC_STREAM_COLUMN, timestamp, func, user_data);
+    if (enc->row_fec && column == enc->columns - 1) {
+        emit_fec(enc, &enc->row_accum, FEC_STREAM_ROW, timestamp, func, user_data);
+    }
+
+    enc->position = (enc->position + 1) % (enc->columns * enc->rows);
+}
+
+void fec_encoder_get_stats(FecEncoder *enc, FecEncoderStats *stats)
+{
+    *stats = enc->stats;
+}
+
+// =============================================================================
+// Decoder
+// =============================================================================
+
+typedef struct {
+    guint16 seq;
+    gboolean present;
+    guint len;
+    guint8 data[FEC_RTP_HEADER_SIZE + FEC_MAX_PAYLOAD];
+} MediaSlot;
+
+typedef struct {
+    guint16 snbase;
+    guint8 offset;
+    guint8 count;
+    guint16 length_recovery;
+    guint8 pt_recovery;
+    guint32 ts_recovery;
+    guint len;
+    guint8 payload[FEC_MAX_PAYLOAD];
+} PendingFec;
+
+struct FecDecoder {
+    MediaSlot *slots;
+    GPtrArray *pending;
+    guint32 ssrc;
+    gboolean have_newest;
+    guint16 newest;
+    FecDecoderStats stats;
+};
+
+static MediaSlot *find_slot(FecDecoder *dec, guint16 seq)
+{
+    MediaSlot *slot = &dec->slots[seq % FEC_DECODER_WINDOW];
+    return slot->present && slot->seq == seq ? slot : NULL;
+}
+
+static void recover(FecDecoder *dec, PendingFec *fec, guint16 missing)
+{
+    guint8 payload[FEC_MAX_PAYLOAD] = {0};
+    memcpy(payload, fec->payload, fec->len);
+    guint16 len = fec->length_recovery;
+    guint8 pt = fec->pt_recovery;
+    guint32 ts = fec->ts_recovery;
+
+    for (guint k = 0; k < fec->count; k++) {
+        guint16 seq = (guint16)(fec->snbase + k * fec->offset);
+        if (seq == missing) continue;
+        MediaSlot *slot = find_slot(dec, seq);
+        guint plen = slot->len - FEC_RTP_HEADER_SIZE;
+        xor_impl(payload, slot->data + FEC_RTP_HEADER_SIZE, plen);
+        len ^= (guint16)plen;
+        pt ^= slot->data[1] & 0x7F;
+        ts ^= get_be32(slot->data + 4);
+    }
+    if (len > FEC_MAX_PAYLOAD) return; // Inconsistent FEC; nothing we can rebuild
+
+    MediaSlot *slot = &dec->slots[missing % FEC_DECODER_WINDOW];
+    put_rtp_header(slot->data, pt & 0x7F, missing, ts, dec->ssrc);
+    memcpy(slot->data + FEC_RTP_HEADER_SIZE, payload, len);
+    slot->seq = missing;
+    slot->len = FEC_RTP_HEADER_SIZE + len;
+    slot->present = TRUE;
+    dec->stats.recovered++;
+}
+
+// Use every pending FEC packet that now lacks exactly one media packet; a recovery may unlock others
+static void try_recover(FecDecoder *dec)
+{
+    gboolean progress = TRUE;
+    while (progress) {
+        progress = FALSE;
+        for (guint i = dec->pending->len; i-- > 0;) {
+            PendingFec *fec = g_ptr_array_index(dec->pending, i);
+            guint missing_count = 0;
+            guint16 missing = 0;
+            for (guint k = 0; k < fec->count; k++) {
+                guint16 seq = (guint16)(fec->snbase + k * fec->offset);
+                if (!find_slot(dec, seq)) {
+                    missing_count++;
+                    missing = seq;
+                }
+            }
+
+            gboolean stale = dec->have_newest && (gint16)(dec->newest - fec->snbase) > FEC_DECODER_WINDOW / 2;
+            if (missing_count == 1) {
+                recover(dec, fec, missing);
+                progress = TRUE;
+            }
+            if (missing_count <= 1 || stale) g_ptr_array_remove_index_fast(dec->pending, i);
+        }
+    }
+}
+
+FecDecoder *fec_decoder_new(void)
+{
+    pthread_once(&simd_once, select_simd_level);
+    FecDecoder *dec = g_new0(FecDecoder, 1);
+    dec->slots = g_new0(MediaSlot, FEC_DECODER_WINDOW);
+    dec->pending = g_ptr_array_new_with_free_func(g_free);
+    return dec;
+}
+
+void fec_decoder_free(FecDecoder *dec)
+{
+    if (!dec) return;
+    g_ptr_array_free(dec->pending, TRUE);
+    g_free(dec->slots);
+    g_free(dec);
+}
+
+void fec_decoder_push(FecDecoder *dec, FecStream stream, const guint8 *packet, gsize len)
+{
+    if (len < FEC_RTP_HEADER_SIZE || (packet[0] & 0xC0) != 0x80) return;
+
+    if (stream == FEC_STREAM_MEDIA) {
+        if (len > FEC_RTP_HEADER_SIZE + FEC_MAX_PAYLOAD) return;
+        guint16 seq = get_be16(packet + 2);
+        MediaSlot *slot = &dec->slots[seq % FEC_DECODER_WINDOW];
+        memcpy(slot->data, packet, len);
+        slot->seq = seq;
+        slot->len = (guint)len;
+        slot->present = TRUE;
+        dec->ssrc = get_be32(packet + 8);
+        if (!dec->have_newest || (gint16)(seq - dec->newest) > 0) dec->newest = seq;
+        dec->have_newest = TRUE;
+        dec->stats.media_packets++;
+    } else {
+        if (len < FEC_RTP_HEADER_SIZE + FEC_HEADER_SIZE) return;
+        const guint8 *h = packet + FEC_RTP_HEADER_SIZE;
+        guint payload_len = (guint)(len - FEC_RTP_HEADER_SIZE - FEC_HEADER_SIZE);
+        if (payload_len > FEC_MAX_PAYLOAD || h[13] == 0 || h[14] == 0) return;
+
+        PendingFec *fec = g_new0(PendingFec, 1);
+        fec->snbase = get_be16(h);
+        fec->length_recovery = get_be16(h + 2);
+        fec->pt_recovery = h[4] & 0x7F;
+        fec->ts_recovery = get_be32(h + 8);
+        fec->offset = h[13];
+        fec->count = h[14];
+        fec->len = payload_len;
+        memcpy(fec->payload, h + FEC_HEADER_SIZE, payload_len);
+        g_ptr_array_add(dec->pending, fec);
+        dec->stats.fec_packets++;
+    }
+
+    try_recover(dec);
+}
+
+const guint8 *fec_decoder_get(FecDecoder *dec, guint16 seq, gsize *len)
+{
+    MediaSlot *slot = find_slot(dec, seq);
+    if (!slot) return NULL;
+    if (len) *len = slot->len;
+    return slot->data;
+}
+
+void fec_decoder_get_stats(FecDecoder *dec, FecDecoderStats *stats)
+{
+    *stats = dec->stats;
+}
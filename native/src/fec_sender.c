@@ -0,0 +1,295 @@
+#include "fec_sender.h"
+
+#include <string.h>
+
+#include "fec.h"
+#include "ts_sync.h"
+
+struct _BgFecSender {
+    GstElement parent;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+    GstPad *colpad;
+    GstPad *rowpad;
+
+    // Held while a buffer is encoded and while the stats thread reads the counters
+    GMutex lock;
+    FecEncoder *encoder;
+    guint columns;
+    guint rows;
+    gboolean row_fec;
+
+    TsSync sync;
+    guint8 payload[FEC_MAX_PAYLOAD];
+    gsize payload_len;
+    guint32 timestamp;
+
+    // Packets produced for the buffer being encoded, one list per source pad
+    GstBufferList *out[3];
+};
+
+G_DEFINE_TYPE(BgFecSender, bg_fec_sender, GST_TYPE_ELEMENT)
+
+static GstStaticPadTemplate sink_template =
+    GST_STATIC_PAD_TEMPLATE("sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate src_template =
+    GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate col_template =
+    GST_STATIC_PAD_TEMPLATE("fec_col", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate row_template =
+    GST_STATIC_PAD_TEMPLATE("fec_row", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+// =============================================================================
+// Streaming
+// =============================================================================
+
+static void on_fec_packet(FecStream stream, const guint8 *packet, gsize len, gpointer user_data)
+{
+    BgFecSender *self = user_data;
+    GstBuffer *buffer = gst_buffer_new_allocate(NULL, len, NULL);
+    gst_buffer_fill(buffer, 0, packet, len);
+    gst_buffer_list_add(self->out[stream], buffer);
+}
+
+static void send_payload(BgFecSender *self)
+{
+    if (self->payload_len == 0) return;
+    fec_encoder_push(self->encoder, self->payload, self->payload_len, self->timestamp, on_fec_packet, self);
+    self->payload_len = 0;
+}
+
+static void on_ts_packet(const guint8 *pkt, guint16 pid, gpointer user_data)
+{
+    (void)pid;
+    BgFecSender *self = user_data;
+    memcpy(self->payload + self->payload_len, pkt, TS_PACKET_SIZE);
+    self->payload_len += TS_PACKET_SIZE;
+    if (self->payload_len == FEC_MAX_PAYLOAD) send_payload(self);
+}
+
+// Encode one buffer; called with the lock held. A short media packet closes the buffer rather
+// than waiting for the next one.
+static void encode_buffer(BgFecSender *self, GstBuffer *buffer)
+{
+    GstMapInfo map;
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return;
+    ts_sync_feed(&self->sync, map.data, map.size, on_ts_packet, self);
+    send_payload(self);
+    gst_buffer_unmap(buffer, &map);
+}
+
+// Push what the last buffers produced; FEC pads that are not linked are not an error
+static GstFlowReturn push_output(BgFecSender *self, GstBufferList **out)
+{
+    GstPad *pads[3] = {self->srcpad, self->colpad, self->rowpad};
+    GstFlowReturn ret = GST_FLOW_OK;
+
+    for (int i = 0; i < 3; i++) {
+        if (gst_buffer_list_length(out[i]) == 0) {
+            gst_buffer_list_unref(out[i]);
+            continue;
+        }
+        GstFlowReturn pad_ret = gst_pad_push_list(pads[i], out[i]);
+        if (i == FEC_STREAM_MEDIA) {
+            ret = pad_ret;
+        } else if (pad_ret != GST_FLOW_OK && pad_ret != GST_FLOW_NOT_LINKED && ret == GST_FLOW_OK) {
+            ret = pad_ret;
+        }
+    }
+    return ret;
+}
+
+static GstFlowReturn encode_and_push(BgFecSender *self, GstBuffer **buffers, guint n)
+{
+    GstBufferList *out[3];
+
+    g_mutex_lock(&self->lock);
+    for (int i = 0; i < 3; i++) self->out[i] = out[i] = gst_buffer_list_new();
+    self->timestamp = (guint32)(g_get_monotonic_time() * 9 / 100); // 90 kHz
+    for (guint i = 0; i < n; i++) encode_buffer(self, buffers[i]);
+    g_mutex_unlock(&self->lock);
+
+    return push_output(self, out);
+}
+
+static GstFlowReturn bg_fec_sender_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    (void)pad;
+    BgFecSender *self = BG_FEC_SENDER(parent);
+    if (!self->encoder) return gst_pad_push(self->srcpad, buffer);
+
+    GstFlowReturn ret = encode_and_push(self, &buffer, 1);
+    gst_buffer_unref(buffer);
+    return ret;
+}
+
+static GstFlowReturn bg_fec_sender_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+    (void)pad;
+    BgFecSender *self = BG_FEC_SENDER(parent);
+    if (!self->encoder) return gst_pad_push_list(self->srcpad, list);
+
+    guint n = gst_buffer_list_length(list);
+    GstBuffer **buffers = g_newa(GstBuffer *, MAX(n, 1));
+    for (guint i = 0; i < n; i++) buffers[i] = gst_buffer_list_get(list, i);
+
+    GstFlowReturn ret = encode_and_push(self, buffers, n);
+    gst_buffer_list_unref(list);
+    return ret;
+}
+
+static gboolean bg_fec_sender_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
+{
+    BgFecSender *self = BG_FEC_SENDER(parent);
+
+    if (GST_EVENT_TYPE(event) == GST_EVENT_FLUSH_STOP) {
+        g_mutex_lock(&self->lock);
+        ts_sync_reset(&self->sync);
+        self->payload_len = 0;
+        g_mutex_unlock(&self->lock);
+    }
+    // The default handler forwards to all three source pads
+    return gst_pad_event_default(pad, parent, event);
+}
+
+// =============================================================================
+// GObject
+// =============================================================================
+
+static void bg_fec_sender_finalize(GObject *object)
+{
+    BgFecSender *self = BG_FEC_SENDER(object);
+
+    fec_encoder_free(self->encoder);
+    g_mutex_clear(&self->lock);
+
+    G_OBJECT_CLASS(bg_fec_sender_parent_class)->finalize(object);
+}
+
+static void bg_fec_sender_class_init(BgFecSenderClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+
+    gobject_class->finalize = bg_fec_sender_finalize;
+
+    gst_element_class_set_static_metadata(element_class, "SMPTE 2022-1 FEC encoder", "Codec/Encoder/Network",
+                                          "Sends MPEG-TS as RTP with row/column XOR FEC streams", "Blackgate");
+    gst_element_class_add_static_pad_template(element_class, &sink_template);
+    gst_element_class_add_static_pad_template(element_class, &src_template);
+    gst_element_class_add_static_pad_template(element_class, &col_template);
+    gst_element_class_add_static_pad_template(element_class, &row_template);
+}
+
+static void bg_fec_sender_init(BgFecSender *self)
+{
+    g_mutex_init(&self->lock);
+    ts_sync_init(&self->sync);
+    ts_sync_filter_all(&self->sync);
+
+    self->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+    gst_pad_set_chain_function(self->sinkpad, bg_fec_sender_chain);
+    gst_pad_set_chain_list_function(self->sinkpad, bg_fec_sender_chain_list);
+    gst_pad_set_event_function(self->sinkpad, bg_fec_sender_sink_event);
+    gst_element_add_pad(GST_ELEMENT(self), self->sinkpad);
+
+    self->srcpad = gst_pad_new_from_static_template(&src_template, "src");
+    gst_element_add_pad(GST_ELEMENT(self), self->srcpad);
+    self->colpad = gst_pad_new_from_static_template(&col_template, "fec_col");
+    gst_element_add_pad(GST_ELEMENT(self), self->colpad);
+    self->rowpad = gst_pad_new_from_static_template(&row_template, "fec_row");
+    gst_element_add_pad(GST_ELEMENT(self), self->rowpad);
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+gboolean fec_sender_register(void)
+{
+    return gst_element_register(NULL, "bgfecenc", GST_RANK_NONE, BG_TYPE_FEC_SENDER);
+}
+
+gboolean fec_sender_configure(GstElement *sender, cJSON *config)
+{
+    BgFecSender *self = BG_FEC_SENDER(sender);
+    if (!cJSON_IsObject(config)) {
+        g_printerr("FecSender: fec config must be an object\n");
+        return FALSE;
+    }
+
+    guint columns = 10, rows = 10;
+    gboolean row_fec = TRUE;
+
+    cJSON *item = cJSON_GetObjectItem(config, "columns");
+    if (item) {
+        if (!cJSON_IsNumber(item) || item->valueint < 1) {
+            g_printerr("FecSender: 'columns' must be a positive number\n");
+            return FALSE;
+        }
+        columns = (guint)item->valueint;
+    }
+    item = cJSON_GetObjectItem(config, "rows");
+    if (item) {
+        if (!cJSON_IsNumber(item) || item->valueint < 1) {
+            g_printerr("FecSender: 'rows' must be a positive number\n");
+            return FALSE;
+        }
+        rows = (guint)item->valueint;
+    }
+    item = cJSON_GetObjectItem(config, "row");
+    if (item) {
+        if (!cJSON_IsBool(item)) {
+            g_printerr("FecSender: 'row' must be a boolean\n");
+            return FALSE;
+        }
+        row_fec = cJSON_IsTrue(item);
+    }
+
+    FecEncoder *encoder = fec_encoder_new(columns, rows, row_fec, g_random_int());
+    if (!encoder) return FALSE;
+
+    g_mutex_lock(&self->lock);
+    FecEncoder *old = self->encoder;
+    self->encoder = encoder;
+    self->columns = columns;
+    self->rows = rows;
+    self->row_fec = row_fec;
+    self->payload_len = 0;
+    g_mutex_unlock(&self->lock);
+    fec_encoder_free(old);
+    return TRUE;
+}
+
+gboolean fec_sender_has_rows(GstElement *sender)
+{
+    BgFecSender *self = BG_FEC_SENDER(sender);
+    g_mutex_lock(&self->lock);
+    gboolean rows = self->encoder && self->row_fec;
+    g_mutex_unlock(&self->lock);
+    return rows;
+}
+
+void fec_sender_add_stats(GstElement *sender, cJSON *parent)
+{
+    BgFecSender *self = BG_FEC_SENDER(sender);
+    FecEncoderStats stats;
+
+    g_mutex_lock(&self->lock);
+    gboolean have = self->encoder != NULL;
+    if (have) fec_encoder_get_stats(self->encoder, &stats);
+    guint columns = self->columns, rows = self->rows;
+    gboolean row_fec = self->row_fec;
+    g_mutex_unlock(&self->lock);
+    if (!have) return;
+
+    cJSON *obj = cJSON_AddObjectToObject(parent, "fec");
+    cJSON_AddNumberToObject(obj, "columns", columns);
+    cJSON_AddNumberToObject(obj, "rows", rows);
+    cJSON_AddBoolToObject(obj, "row", row_fec);
+    cJSON_AddStringToObject(obj, "xor", fec_simd_name());
+    cJSON_AddNumberToObject(obj, "media-packets", (double)stats.media_packets);
+    cJSON_AddNumberToObject(obj, "column-packets", (double)stats.column_packets);
+    cJSON_AddNumberToObject(obj, "row-packets", (double)stats.row_packets);
+}
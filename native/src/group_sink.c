@@ -0,0 +1,159 @@
+#include "group_sink.h"
+
+#include "srt_group.h"
+
+struct _BgSrtGroupSink {
+    GstElement parent;
+
+    GstPad *sinkpad;
+    SrtGroup *group; // Set once by group_sink_configure, before the element leaves NULL
+};
+
+G_DEFINE_TYPE(BgSrtGroupSink, bg_srt_group_sink, GST_TYPE_ELEMENT)
+
+static GstStaticPadTemplate sink_template =
+    GST_STATIC_PAD_TEMPLATE("sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+// =============================================================================
+// Streaming
+// =============================================================================
+
+static void send_buffer(BgSrtGroupSink *self, GstBuffer *buffer)
+{
+    GstMapInfo map;
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return;
+    srt_group_send(self->group, map.data, map.size);
+    gst_buffer_unmap(buffer, &map);
+}
+
+static GstFlowReturn bg_srt_group_sink_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    (void)pad;
+    BgSrtGroupSink *self = BG_SRT_GROUP_SINK(parent);
+    if (self->group) send_buffer(self, buffer);
+    gst_buffer_unref(buffer);
+    return GST_FLOW_OK;
+}
+
+static GstFlowReturn bg_srt_group_sink_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+    (void)pad;
+    BgSrtGroupSink *self = BG_SRT_GROUP_SINK(parent);
+    if (self->group) {
+        guint n = gst_buffer_list_length(list);
+        for (guint i = 0; i < n; i++) send_buffer(self, gst_buffer_list_get(list, i));
+    }
+    gst_buffer_list_unref(list);
+    return GST_FLOW_OK;
+}
+
+static gboolean bg_srt_group_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
+{
+    // No source pad to forward to; EOS is what the bin waits for from its sinks
+    if (GST_EVENT_TYPE(event) == GST_EVENT_EOS) {
+        gst_element_post_message(GST_ELEMENT(parent), gst_message_new_eos(parent));
+    }
+    return gst_pad_event_default(pad, parent, event);
+}
+
+static GstStateChangeReturn bg_srt_group_sink_change_state(GstElement *element, GstStateChange transition)
+{
+    BgSrtGroupSink *self = BG_SRT_GROUP_SINK(element);
+
+    if (transition == GST_STATE_CHANGE_NULL_TO_READY && self->group && !srt_group_start(self->group)) {
+        return GST_STATE_CHANGE_FAILURE;
+    }
+
+    GstStateChangeReturn ret = GST_ELEMENT_CLASS(bg_srt_group_sink_parent_class)->change_state(element, transition);
+
+    if (transition == GST_STATE_CHANGE_READY_TO_NULL && self->group) srt_group_stop(self->group);
+    return ret;
+}
+
+// =============================================================================
+// GObject
+// =============================================================================
+
+static void bg_srt_group_sink_finalize(GObject *object)
+{
+    BgSrtGroupSink *self = BG_SRT_GROUP_SINK(object);
+
+    srt_group_free(self->group);
+
+    G_OBJECT_CLASS(bg_srt_group_sink_parent_class)->finalize(object);
+}
+
+static void bg_srt_group_sink_class_init(BgSrtGroupSinkClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+
+    gobject_class->finalize = bg_srt_group_sink_finalize;
+    element_class->change_state = bg_srt_group_sink_change_state;
+
+    gst_element_class_set_static_metadata(element_class, "Bonded SRT sink", "Sink/Network",
+                                          "Sends over an SRT socket group (broadcast or main/backup links)",
+                                          "Blackgate");
+    gst_element_class_add_static_pad_template(element_class, &sink_template);
+}
+
+static void bg_srt_group_sink_init(BgSrtGroupSink *self)
+{
+    GST_OBJECT_FLAG_SET(self, GST_ELEMENT_FLAG_SINK);
+
+    self->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+    gst_pad_set_chain_function(self->sinkpad, bg_srt_group_sink_chain);
+    gst_pad_set_chain_list_function(self->sinkpad, bg_srt_group_sink_chain_list);
+    gst_pad_set_event_function(self->sinkpad, bg_srt_group_sink_event);
+    gst_element_add_pad(GST_ELEMENT(self), self->sinkpad);
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+gboolean group_sink_register(void)
+{
+    return gst_element_register(NULL, "bgsrtgroupsink", GST_RANK_NONE, BG_TYPE_SRT_GROUP_SINK);
+}
+
+gboolean group_sink_configure(GstElement *sink, cJSON *config)
+{
+    BgSrtGroupSink *self = BG_SRT_GROUP_SINK(sink);
+    if (self->group) return FALSE;
+
+    self->group = srt_group_new(config, NULL, NULL);
+    return self->group != NULL;
+}
+
+void group_sink_add_stats(GstElement *sink, cJSON *parent)
+{
+    BgSrtGroupSink *self = BG_SRT_GROUP_SINK(sink);
+    if (!self->group) return;
+
+    SrtGroupStats stats;
+    srt_group_get_stats(self->group, &stats);
+
+    // Same fields as an srtsink, taken from the active link (the first link up in broadcast mode)
+    const SrtLinkStats *main_link = NULL;
+    gint64 lost = 0, dropped = 0, retransmitted = 0;
+    for (guint i = 0; i < stats.n_links; i++) {
+        const SrtLinkStats *link = &stats.links[i];
+        if (link->state == SRT_LINK_ACTIVE && !main_link) main_link = link;
+        lost += link->packets_lost;
+        dropped += link->packets_dropped;
+        retransmitted += link->packets_retransmitted;
+    }
+
+    cJSON_AddNumberToObject(parent, "bytes-sent-total", (double)stats.bytes);
+    cJSON_AddNumberToObject(parent, "packets-sent", (double)stats.packets);
+    cJSON_AddNumberToObject(parent, "packets-sent-lost", (double)lost);
+    cJSON_AddNumberToObject(parent, "packets-sent-dropped", (double)(dropped + (gint64)stats.send_drops));
+    cJSON_AddNumberToObject(parent, "packets-sent-retransmitted", (double)retransmitted);
+    cJSON_AddNumberToObject(parent, "rtt-ms", main_link ? main_link->rtt_ms : 0);
+    cJSON_AddNumberToObject(parent, "send-rate-mbps", main_link ? main_link->rate_mbps : 0);
+    cJSON_AddNumberToObject(parent, "bandwidth-mbps", main_link ? main_link->bandwidth_mbps : 0);
+    cJSON_AddNumberToObject(parent, "negotiated-latency-ms", stats.negotiated_latency_ms);
+    cJSON_AddNumberToObject(parent, "connected-callers", stats.connected ? 1 : 0);
+    srt_group_stats_to_json(&stats, parent);
+}
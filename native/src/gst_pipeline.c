@@ -3,12 +3,35 @@
 #include <gio/gio.h>
 #include <gst/gst.h>
 #include <gst/app/gstappsink.h>
+#include <gst/app/gstappsrc.h>
 #include <pthread.h>
 #include <srt/srt.h>
 #include <stdio.h>
 #include <string.h>
 
+#include "admission.h"
+#include "audio_meter.h"
+#include "buffer_batch.h"
+#include "caller_stats.h"
+#include "delay_output.h"
+#include "fec_sender.h"
+#include "group_sink.h"
+#include "input_watchdog.h"
+#include "output_pool.h"
+#include "null_shaper.h"
+#include "pacer.h"
+#include "pid_filter.h"
+#include "preview_server.h"
+#include "queue_telemetry.h"
+#include "shared_source.h"
+#include "srt_group.h"
+#include "srt_stats.h"
+#include "thread_policy.h"
+#include "trace.h"
+#include "ts_metadata.h"
+#include "udp_source.h"
 #include "unix_socket.h"
+#include "video_health.h"
 
 #define MAX_SINKS 32
 
@@ -17,198 +40,708 @@ static void set_element_properties(GstElement *element, cJSON *config, const cha
                                    const char *skip_property);
 static void set_srt_mode_property(GstElement *element, const char *mode_str, const char *element_desc);
 static void collect_sink_stats(void);
+static void flush_caller_rejections(void);
 
 static pthread_t stats_thread;
 static GstElement *source_element = NULL;
 static gboolean running = TRUE;
 static GMainLoop *loop = NULL;
 
-// Store SRT sink elements for stats collection
+// Store SRT sink elements (srtsink and bonded bgsrtgroupsink) for stats collection
 static GstElement *sink_elements[MAX_SINKS];
 static int sink_count = 0;
 
+// Caller aggregation of listener-mode srtsinks, indexed by sink index; created on the first stats tick
+static CallerStats *sink_caller_stats[MAX_SINKS];
+// Full per-caller lists are reported until this monotonic time (set by a "callers-detail" command)
+static gint64 caller_detail_until_us[MAX_SINKS];
+
+// srtsrc/srtsink stats read straight from their libsrt sockets (see srt_stats.h), on the stats thread.
+// An element whose sockets are not found (a caller still connecting) falls back to its "stats" property.
+static SrtSocketIndex *srt_index = NULL;
+static SrtEndpoint source_endpoint;
+static gboolean source_endpoint_valid = FALSE;
+static guint64 source_bytes_total = 0;
+static SrtEndpoint sink_endpoints[MAX_SINKS];
+static gboolean sink_endpoint_valid[MAX_SINKS];
+static guint64 sink_bytes_total[MAX_SINKS];
+// Highest send buffer level sampled with the branch queues since the previous report
+static gint sink_send_buffer_peak_ms[MAX_SINKS];
+// sink_caller_stats[i] is keyed by SRT socket rather than by the srtsink's caller address
+static gboolean sink_caller_stats_direct[MAX_SINKS];
+static SRTSOCKET srt_socks[SRT_STATS_MAX_SOCKETS];
+
+// Shared output worker pool (route "output" config); NULL means one queue2 thread per destination
+static OutputPool *output_pool = NULL;
+static guint output_max_buffers = 8192;
+static guint64 output_max_bytes = 50 * 1024 * 1024;
+
+// Shared delay ring feeding the destinations with a "delay" config; NULL when there are none
+static DelayOutput *delay_output = NULL;
+
+// Feeds the appsrc of a "sharedsrt" route from the shared SRT listener; NULL for other sources
+static SharedSource *shared_source = NULL;
+
+// Feeds the appsrc of an "srtgroup" source from a bonded SRT connection; NULL for other sources
+static SrtGroup *group_source = NULL;
+
+// Feeds the appsrc of a "udpts" source from a batched UDP/RTP socket reader; NULL for other sources
+static UdpSource *udp_source = NULL;
+
+// Handshake admission for srtsrc callers (route "admission" config); NULL for other sources
+static Admission *source_admission = NULL;
+
+// Stream IDs of accepted srtsrc callers by "ip:port", from caller-connecting until caller-added
+#define MAX_PENDING_CALLERS 256
+static GHashTable *caller_stream_ids = NULL;
+static GMutex caller_stream_ids_lock;
+
+// Callers refused by admission, counted per reason on libsrt's handshake thread and sent by the stats
+// thread as one "caller-rejected" event per reason and second, so a connection flood neither blocks the
+// handshake on the control socket nor floods the controller
+typedef struct {
+    guint64 count;
+    char address[64];    // Of the last refused caller
+    char stream_id[513]; // Likewise; SRT stream IDs are at most 512 bytes
+    gboolean has_stream_id;
+} CallerRejections;
+static CallerRejections caller_rejections[ADMISSION_RESULT_COUNT];
+static GMutex caller_rejections_lock;
+
+// Connected srtsrc callers and whether the source is currently reported lost (see set_source_lost)
+static gint source_callers = 0;
+static gboolean source_lost = FALSE;
+
+// Input stall watchdog on the tee sink pad (route "watchdog" config), polled from the main loop
+static InputWatchdog *source_watchdog = NULL;
+static guint watchdog_timer = 0;
+
+// Optional batching stage between source and tee (route "batch" config)
+static GstElement *batch_element = NULL;
+
+// queue2 in front of every destination, indexed by sink index (owns the sink's streaming thread)
+static GstElement *sink_queues[MAX_SINKS];
+static int sink_queue_count = 0;
+// Fill-level telemetry of sink_queues, sampled by the stats thread
+static QueueTelemetry sink_queue_telemetry[MAX_SINKS];
+
+// bgpidfilter in front of a destination with a "filter" config, indexed by sink index
+static GstElement *sink_filters[MAX_SINKS];
+// bgfecenc in front of a UDP destination with a "fec" config, indexed by sink index
+static GstElement *sink_fecs[MAX_SINKS];
+// bgnullshaper and bgpacer in front of a destination without sink stats of its own (not SRT), indexed
+// by sink index; the others report theirs in the sink stats
+static GstElement *sink_nulls[MAX_SINKS];
+static GstElement *sink_pacers[MAX_SINKS];
+
 // Store tee element for video caps query
 static GstElement *tee_element = NULL;
 
+// Shared decode tier: one decodebin per route whose raw frames fan out to the thumbnail (and the video
+// health probe on it) and the optional proxy encoder. decode_queue is the leaky queue in front of it.
+static GstElement *decode_queue = NULL;
+static QueueTelemetry decode_queue_telemetry;
+static guint64 decode_frames = 0; // Written on the decode thread, read by the stats thread
+
+// Optional low-bitrate H.264 proxy, "decode": {"proxy": {"width": 640, "height": 360, "bitrate": 500}};
+// destinations with "proxy": true are fed its transport stream from proxy_tee instead of the route tee
+static GstElement *proxy_tee = NULL;
+static GstElement *proxy_queue = NULL;
+static QueueTelemetry proxy_queue_telemetry;
+static gint proxy_width = 0;
+static gint proxy_height = 0;
+static gint proxy_bitrate_kbps = 0;
+
 // Thumbnail capture state
 static GstElement *thumbnail_appsink = NULL;
+// Continuous MJPEG preview of the thumbnail frames for any number of viewers; NULL with "preview": false
+static PreviewServer *preview_server = NULL;
 static pthread_t thumbnail_thread;
 static volatile gboolean thumbnail_running = FALSE;
 static gboolean thumbnail_thread_started = FALSE;
 
-// MPEG-TS parsing structures for video metadata extraction
-#define TS_PACKET_SIZE 188
-#define TS_SYNC_BYTE 0x47
-#define PAT_PID 0x0000
-
-// Video stream types in MPEG-TS PMT
-#define STREAM_TYPE_MPEG2_VIDEO 0x02
-#define STREAM_TYPE_H264 0x1B
-#define STREAM_TYPE_HEVC 0x24
+// The thumbnail branch scales to I420 at this size; its luma plane feeds the black/freeze detector
+#define THUMBNAIL_WIDTH 320
+#define THUMBNAIL_HEIGHT 180
+static VideoHealth *video_health = NULL;
 
-// Parsed video information
+// One decoded audio elementary stream of the audio metering branch
 typedef struct {
-    gint width;
-    gint height;
-    gint fps_num;
-    gint fps_den;
-    gboolean interlaced;
-    gboolean fps_inferred; // TRUE if framerate was inferred, not detected
-    gboolean info_valid;
-    guint16 pmt_pid;
-    guint16 video_pid;
-    guint8 video_stream_type;
-    pthread_mutex_t mutex;
-} VideoInfo;
-
-static VideoInfo video_info = {0, 0, 0, 1, FALSE, FALSE, FALSE, 0, 0, 0, PTHREAD_MUTEX_INITIALIZER};
-
-// Forward declarations for MPEG-TS parsing
-static void parse_pat(const guint8 *data, gsize size);
-static void parse_pmt(const guint8 *data, gsize size);
+    guint16 pid;
+    gchar *codec;
+    guint rate;
+    guint channels;
+    AudioMeter *meter; // Created on the first buffer after new caps or re-enabling
+} AudioStream;
+
+// Audio metering branch (route "audio-meter" config); the valve switches it on and off at runtime
+static GstElement *audio_queue = NULL;
+static GstElement *audio_valve = NULL;
+static GPtrArray *audio_streams = NULL; // AudioStream, guarded by audio_lock
+static GMutex audio_lock;
+// The branch queue's thread runs demux, decoders and meters; its CPU time is the branch's cost
+static pthread_t audio_thread;
+static gboolean audio_thread_known = FALSE;
+static gint64 audio_cpu_last_ns = 0;
+static gint64 audio_wall_last_us = 0;
+
+// Video format of the source, tracked by the tee probe (only touched from the source streaming thread
+// and, read-only, the stats thread)
+static TsMetadata *ts_metadata = NULL;
 
 // Forward declarations for thumbnail
-static void add_thumbnail_branch(GstElement *pipeline, GstElement *tee, const char *route_id);
+static gboolean add_decode_tier(GstElement *pipeline, GstElement *tee, cJSON *decode_config, const char *route_id);
+static void add_audio_meter_branch(GstElement *pipeline, GstElement *tee, gboolean enabled);
+static void audio_branch_add_stats(cJSON *root);
 static void *thumbnail_worker(void *arg);
-static void on_thumbnail_pad_added(GstElement *decodebin, GstPad *pad, gpointer data);
-static void parse_h264_sps(const guint8 *data, gsize size);
-static void parse_mpeg2_sequence(const guint8 *data, gsize size);
+static void on_decode_pad_added(GstElement *decodebin, GstPad *pad, gpointer data);
 static GstPadProbeReturn ts_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data);
 
+// Source types "srtgroup" and "udpts": every message of the bonded connection, or every receive
+// batch of the UDP reader, becomes one appsrc buffer
+static void push_to_appsrc(const guint8 *data, gsize len, gpointer user_data)
+{
+    GstBuffer *buffer = gst_buffer_new_allocate(NULL, len, NULL);
+    gst_buffer_fill(buffer, 0, data, len);
+    gst_app_src_push_buffer(GST_APP_SRC(user_data), buffer);
+}
+
+// Per-link figures come from the active link; loss, drops and retransmissions are summed over all links
+static void group_source_get_stats(const SrtGroupStats *group, SrtSocketStats *stats)
+{
+    const SrtLinkStats *main_link = NULL;
+    *stats = (SrtSocketStats){
+        .packets_received = (gint64)group->packets,
+        .bytes_received = group->bytes,
+        .receive_latency_ms = group->negotiated_latency_ms,
+    };
+    for (guint i = 0; i < group->n_links; i++) {
+        if (group->links[i].state == SRT_LINK_ACTIVE && !main_link) main_link = &group->links[i];
+        stats->packets_received_lost += group->links[i].packets_lost;
+        stats->packets_received_dropped += group->links[i].packets_dropped;
+        stats->packets_retransmitted += group->links[i].packets_retransmitted;
+    }
+    if (main_link) {
+        stats->rtt_ms = main_link->rtt_ms;
+        stats->receive_rate_mbps = main_link->rate_mbps;
+        stats->bandwidth_mbps = main_link->bandwidth_mbps;
+    }
+}
+
+// Lost is RTP sequence numbers given up on, dropped is what the kernel or the reorder window discarded
+static void udp_source_get_socket_stats(const UdpSourceStats *udp, SrtSocketStats *stats)
+{
+    *stats = (SrtSocketStats){
+        .packets_received = (gint64)udp->datagrams,
+        .packets_received_lost = (gint64)udp->rtp_stats.lost,
+        .packets_received_dropped = (gint64)(udp->socket_drops + udp->truncated + udp->rtp_stats.late),
+        .bytes_received = udp->bytes,
+        .receive_rate_mbps = udp->receive_rate_mbps,
+    };
+}
+
+static void sample_queue(GstElement *queue, QueueTelemetry *telemetry)
+{
+    guint bytes = 0, buffers = 0;
+    guint64 time_ns = 0;
+    g_object_get(queue, "current-level-bytes", &bytes, "current-level-buffers", &buffers, "current-level-time",
+                 &time_ns, NULL);
+    QueueLevel level = {bytes, buffers, time_ns};
+    queue_telemetry_sample(telemetry, &level);
+}
+
+static void sample_branch_queues(void)
+{
+    for (int i = 0; i < sink_queue_count; i++) {
+        if (sink_queues[i]) sample_queue(sink_queues[i], &sink_queue_telemetry[i]);
+    }
+    // The send buffer fills and drains within a report; sampling it with the queues catches the peaks
+    for (int i = 0; i < sink_count; i++) {
+        if (!sink_endpoint_valid[i]) continue;
+        gint n = srt_socket_index_lookup(srt_index, &sink_endpoints[i], srt_socks, SRT_STATS_MAX_SOCKETS);
+        for (gint j = 0; j < n; j++) {
+            SrtSocketStats socket_stats;
+            if (!srt_socket_stats_read(srt_socks[j], FALSE, &socket_stats)) continue;
+            sink_send_buffer_peak_ms[i] = MAX(sink_send_buffer_peak_ms[i], socket_stats.send_buffer_ms);
+        }
+    }
+    if (decode_queue) sample_queue(decode_queue, &decode_queue_telemetry);
+    if (proxy_queue) sample_queue(proxy_queue, &proxy_queue_telemetry);
+}
+
+static void end_branch_queue_windows(void)
+{
+    gint64 now_us = g_get_monotonic_time();
+    for (int i = 0; i < sink_queue_count; i++) {
+        if (sink_queues[i]) queue_telemetry_end_window(&sink_queue_telemetry[i], now_us);
+    }
+    if (decode_queue) queue_telemetry_end_window(&decode_queue_telemetry, now_us);
+    if (proxy_queue) queue_telemetry_end_window(&proxy_queue_telemetry, now_us);
+}
+
+// A leaky decode tier queue signals overrun once for every buffer it is about to drop
+static void on_decode_queue_overrun(GstElement *queue, gpointer user_data)
+{
+    (void)queue;
+    queue_telemetry_drop((QueueTelemetry *)user_data);
+}
+
+// The srtsrc "stats" property: top-level fields, and a "callers" array in listener mode
+static void source_structure_to_json(const GstStructure *stats, cJSON *root)
+{
+    guint64 bytes_total = 0;
+    gst_structure_get_uint64(stats, "bytes-received-total", &bytes_total);
+    cJSON_AddNumberToObject(root, "total-bytes-received", (double)bytes_total);
+
+    // Extract top-level stats (available in caller mode and as aggregate in listener mode)
+    gint64 packets_received = 0, packets_lost = 0, packets_dropped = 0;
+    gint64 packets_retransmitted = 0, bytes_received = 0;
+    gdouble rtt_ms = 0.0, receive_rate_mbps = 0.0, bandwidth_mbps = 0.0;
+    gint negotiated_latency_ms = 0;
+
+    gst_structure_get_int64(stats, "packets-received", &packets_received);
+    gst_structure_get_int64(stats, "packets-received-lost", &packets_lost);
+    gst_structure_get_int64(stats, "packets-received-dropped", &packets_dropped);
+    gst_structure_get_int64(stats, "packets-received-retransmitted", &packets_retransmitted);
+    gst_structure_get_int64(stats, "bytes-received", &bytes_received);
+    gst_structure_get_double(stats, "rtt-ms", &rtt_ms);
+    gst_structure_get_double(stats, "receive-rate-mbps", &receive_rate_mbps);
+    gst_structure_get_double(stats, "bandwidth-mbps", &bandwidth_mbps);
+    gst_structure_get_int(stats, "negotiated-latency-ms", &negotiated_latency_ms);
+
+    // Add top-level stats to JSON
+    cJSON_AddNumberToObject(root, "packets-received", (double)packets_received);
+    cJSON_AddNumberToObject(root, "packets-received-lost", (double)packets_lost);
+    cJSON_AddNumberToObject(root, "packets-received-dropped", (double)packets_dropped);
+    cJSON_AddNumberToObject(root, "packets-received-retransmitted", (double)packets_retransmitted);
+    cJSON_AddNumberToObject(root, "bytes-received", (double)bytes_received);
+    cJSON_AddNumberToObject(root, "rtt-ms", rtt_ms);
+    cJSON_AddNumberToObject(root, "receive-rate-mbps", receive_rate_mbps);
+    cJSON_AddNumberToObject(root, "bandwidth-mbps", bandwidth_mbps);
+    cJSON_AddNumberToObject(root, "negotiated-latency-ms", negotiated_latency_ms);
+
+    const GValue *callers_val = gst_structure_get_value(stats, "callers");
+    if (!callers_val) {
+        cJSON_AddNumberToObject(root, "connected-callers", 0);
+        cJSON_AddArrayToObject(root, "callers");
+    } else if (G_VALUE_HOLDS(callers_val, G_TYPE_VALUE_ARRAY)) {
+        GValueArray *callers_array = g_value_get_boxed(callers_val);
+        gint num_callers = callers_array ? callers_array->n_values : 0;
+
+        cJSON_AddNumberToObject(root, "connected-callers", num_callers);
+        cJSON *callers = cJSON_AddArrayToObject(root, "callers");
+
+        for (gint i = 0; i < num_callers; i++) {
+            GValue *caller_val = &callers_array->values[i];
+            if (!G_VALUE_HOLDS(caller_val, GST_TYPE_STRUCTURE)) {
+                continue;
+            }
+
+            const GstStructure *caller_stats = g_value_get_boxed(caller_val);
+            if (!caller_stats) {
+                continue;
+            }
+
+            cJSON *caller = cJSON_CreateObject();
+
+            gint n_fields = gst_structure_n_fields(caller_stats);
+            for (gint j = 0; j < n_fields; j++) {
+                const gchar *field_name = gst_structure_nth_field_name(caller_stats, j);
+                const GValue *value = gst_structure_get_value(caller_stats, field_name);
+
+                if (G_VALUE_HOLDS(value, G_TYPE_INT64)) {
+                    cJSON_AddNumberToObject(caller, field_name, (double)g_value_get_int64(value));
+                } else if (G_VALUE_HOLDS(value, G_TYPE_INT)) {
+                    cJSON_AddNumberToObject(caller, field_name, g_value_get_int(value));
+                } else if (G_VALUE_HOLDS(value, G_TYPE_UINT64)) {
+                    cJSON_AddNumberToObject(caller, field_name, (double)g_value_get_uint64(value));
+                } else if (G_VALUE_HOLDS(value, G_TYPE_DOUBLE)) {
+                    cJSON_AddNumberToObject(caller, field_name, g_value_get_double(value));
+                } else if (G_VALUE_HOLDS(value, G_TYPE_OBJECT) && g_strcmp0(field_name, "caller-address") == 0) {
+                    GObject *addr_obj = g_value_get_object(value);
+                    if (G_IS_INET_SOCKET_ADDRESS(addr_obj)) {
+                        GInetSocketAddress *addr = G_INET_SOCKET_ADDRESS(addr_obj);
+                        GInetAddress *inet_addr = g_inet_socket_address_get_address(addr);
+                        guint16 port = g_inet_socket_address_get_port(addr);
+                        gchar *ip = g_inet_address_to_string(inet_addr);
+                        gchar *addr_str = g_strdup_printf("%s:%d", ip, port);
+                        cJSON_AddStringToObject(caller, field_name, addr_str);
+                        g_free(ip);
+                        g_free(addr_str);
+                    }
+                }
+            }
+
+            cJSON_AddItemToArray(callers, caller);
+        }
+    }
+}
+
+// The srtsrc "stats" fields from a plain struct; `callers` (taken, may be NULL) lists a listener's callers
+static void source_stats_to_json(const SrtSocketStats *stats, guint64 bytes_total, cJSON *callers, cJSON *root)
+{
+    cJSON_AddNumberToObject(root, "total-bytes-received", (double)bytes_total);
+    srt_socket_stats_receiver_to_json(stats, root);
+    if (!callers) callers = cJSON_CreateArray();
+    cJSON_AddNumberToObject(root, "connected-callers", cJSON_GetArraySize(callers));
+    cJSON_AddItemToObject(root, "callers", callers);
+}
+
+// srtsrc read from its sockets: summed over a listener's callers, one "callers" entry each
+static void source_sockets_to_json(const SRTSOCKET *socks, gint n, cJSON *root)
+{
+    SrtSocketStats total = {0};
+    cJSON *callers = cJSON_CreateArray();
+    for (gint i = 0; i < n; i++) {
+        SrtSocketStats socket_stats;
+        if (!srt_socket_stats_read(socks[i], TRUE, &socket_stats)) continue;
+        srt_socket_stats_accumulate(&total, &socket_stats);
+        if (source_endpoint.mode != SRT_ENDPOINT_LISTENER) continue;
+
+        cJSON *caller = cJSON_CreateObject();
+        char peer[64];
+        srt_socket_peer_to_string(socks[i], peer, sizeof(peer));
+        cJSON_AddStringToObject(caller, "caller-address", peer);
+        srt_socket_stats_receiver_to_json(&socket_stats, caller);
+        cJSON_AddItemToArray(callers, caller);
+    }
+
+    source_bytes_total += total.bytes_received_interval;
+    source_stats_to_json(&total, source_bytes_total, callers, root);
+}
+
 static void *print_stats(void *src)
 {
     GstElement *source = (GstElement *)src;
 
+    thread_policy_apply_self(THREAD_ROLE_ANALYSIS, "stats");
+
     while (running) {
-        sleep(1);
+        // Sample the branch queues between reports so short bursts still show in the high-water marks
+        for (int i = 0; i < QUEUE_TELEMETRY_SAMPLES_PER_SEC && running; i++) {
+            g_usleep(G_USEC_PER_SEC / QUEUE_TELEMETRY_SAMPLES_PER_SEC);
+            sample_branch_queues();
+        }
+        end_branch_queue_windows();
+        flush_caller_rejections();
+        gint64 report_start_us = g_get_monotonic_time();
 
+        if (srt_index) srt_socket_index_refresh(srt_index);
+
+        // Only an srtsrc whose sockets the index cannot find still goes through its "stats" GstStructure
         GstStructure *stats = NULL;
-        g_object_get(source, "stats", &stats, NULL);
+        SrtSocketStats source_stats;
+        gboolean have_source_stats = TRUE;
+        SrtGroupStats group_stats;
+        UdpSourceStats udp_stats;
+        gint n_source_socks = -1;
+        if (shared_source) {
+            shared_source_get_stats(shared_source, &source_stats);
+        } else if (group_source) {
+            srt_group_get_stats(group_source, &group_stats);
+            group_source_get_stats(&group_stats, &source_stats);
+        } else if (udp_source) {
+            udp_source_get_stats(udp_source, &udp_stats);
+            udp_source_get_socket_stats(&udp_stats, &source_stats);
+        } else if (source_endpoint_valid && (n_source_socks = srt_socket_index_lookup(
+                                                 srt_index, &source_endpoint, srt_socks, SRT_STATS_MAX_SOCKETS)) >= 0) {
+            // Read from the sockets below
+        } else {
+            have_source_stats = FALSE;
+            g_object_get(source, "stats", &stats, NULL);
+        }
 
-        if (!stats) {
+        if (!have_source_stats && !stats) {
             g_print("Failed to retrieve SRT stats\n");
             continue;
         }
 
         cJSON *root = cJSON_CreateObject();
 
-        guint64 bytes_total = 0;
-        gst_structure_get_uint64(stats, "bytes-received-total", &bytes_total);
-        cJSON_AddNumberToObject(root, "total-bytes-received", (double)bytes_total);
-
-        // Extract top-level stats (available in caller mode and as aggregate in listener mode)
-        gint64 packets_received = 0, packets_lost = 0, packets_dropped = 0;
-        gint64 packets_retransmitted = 0, bytes_received = 0;
-        gdouble rtt_ms = 0.0, receive_rate_mbps = 0.0, bandwidth_mbps = 0.0;
-        gint negotiated_latency_ms = 0;
-
-        gst_structure_get_int64(stats, "packets-received", &packets_received);
-        gst_structure_get_int64(stats, "packets-received-lost", &packets_lost);
-        gst_structure_get_int64(stats, "packets-received-dropped", &packets_dropped);
-        gst_structure_get_int64(stats, "packets-received-retransmitted", &packets_retransmitted);
-        gst_structure_get_int64(stats, "bytes-received", &bytes_received);
-        gst_structure_get_double(stats, "rtt-ms", &rtt_ms);
-        gst_structure_get_double(stats, "receive-rate-mbps", &receive_rate_mbps);
-        gst_structure_get_double(stats, "bandwidth-mbps", &bandwidth_mbps);
-        gst_structure_get_int(stats, "negotiated-latency-ms", &negotiated_latency_ms);
+        if (stats) {
+            source_structure_to_json(stats, root);
+        } else if (n_source_socks >= 0) {
+            source_sockets_to_json(srt_socks, n_source_socks, root);
+        } else {
+            source_stats_to_json(&source_stats, source_stats.bytes_received, NULL, root);
+        }
 
-        // Add top-level stats to JSON
-        cJSON_AddNumberToObject(root, "packets-received", (double)packets_received);
-        cJSON_AddNumberToObject(root, "packets-received-lost", (double)packets_lost);
-        cJSON_AddNumberToObject(root, "packets-received-dropped", (double)packets_dropped);
-        cJSON_AddNumberToObject(root, "packets-received-retransmitted", (double)packets_retransmitted);
-        cJSON_AddNumberToObject(root, "bytes-received", (double)bytes_received);
-        cJSON_AddNumberToObject(root, "rtt-ms", rtt_ms);
-        cJSON_AddNumberToObject(root, "receive-rate-mbps", receive_rate_mbps);
-        cJSON_AddNumberToObject(root, "bandwidth-mbps", bandwidth_mbps);
-        cJSON_AddNumberToObject(root, "negotiated-latency-ms", negotiated_latency_ms);
+        // Add video metadata from MPEG-TS parsing (if available)
+        if (ts_metadata) {
+            TsVideoFormat format;
+            TsMetadataStats meta_stats;
+            ts_metadata_get_format(ts_metadata, &format);
+            ts_metadata_get_stats(ts_metadata, &meta_stats);
+            if (format.valid) {
+                cJSON_AddStringToObject(root, "video-codec", ts_metadata_codec_name(format.stream_type));
+                cJSON_AddNumberToObject(root, "video-width", format.width);
+                cJSON_AddNumberToObject(root, "video-height", format.height);
+                cJSON_AddNumberToObject(root, "video-framerate-num", format.fps_num);
+                cJSON_AddNumberToObject(root, "video-framerate-den", format.fps_den);
+                cJSON_AddBoolToObject(root, "video-framerate-inferred", format.fps_inferred);
+                cJSON_AddStringToObject(root, "video-interlace-mode",
+                                        format.interlaced ? "interleaved" : "progressive");
+            }
+            cJSON_AddNumberToObject(root, "video-format-changes", (double)meta_stats.format_changes);
+        }
 
-        const GValue *callers_val = gst_structure_get_value(stats, "callers");
-        if (!callers_val) {
-            cJSON_AddNumberToObject(root, "connected-callers", 0);
-            cJSON_AddArrayToObject(root, "callers");
-        } else if (G_VALUE_HOLDS(callers_val, G_TYPE_VALUE_ARRAY)) {
-            GValueArray *callers_array = g_value_get_boxed(callers_val);
-            gint num_callers = callers_array ? callers_array->n_values : 0;
-
-            cJSON_AddNumberToObject(root, "connected-callers", num_callers);
-            cJSON *callers = cJSON_AddArrayToObject(root, "callers");
-
-            for (gint i = 0; i < num_callers; i++) {
-                GValue *caller_val = &callers_array->values[i];
-                if (!G_VALUE_HOLDS(caller_val, GST_TYPE_STRUCTURE)) {
-                    continue;
-                }
+        if (shared_source) shared_source_add_stats(shared_source, root);
+        if (group_source) {
+            cJSON_ReplaceItemInObject(root, "connected-callers", cJSON_CreateNumber(group_stats.connected ? 1 : 0));
+            srt_group_stats_to_json(&group_stats, root);
+        }
+        if (udp_source) udp_source_stats_to_json(udp_source, &udp_stats, root);
+        if (source_watchdog) {
+            InputWatchdogStats watchdog_stats;
+            input_watchdog_get_stats(source_watchdog, &watchdog_stats);
+            input_watchdog_stats_to_json(&watchdog_stats, root);
+        }
+        if (source_admission) {
+            AdmissionStats admission_stats;
+            admission_reload_if_changed(source_admission);
+            admission_get_stats(source_admission, &admission_stats);
+            admission_stats_to_json(&admission_stats, root);
+        }
+        thread_policy_add_stats(root);
+        if (audio_valve) audio_branch_add_stats(root);
+        if (output_pool) output_pool_add_stats(output_pool, root);
+        if (delay_output) delay_output_add_stats(delay_output, root);
+        if (batch_element) buffer_batch_add_stats(batch_element, root);
+
+        cJSON *queues = NULL;
+        for (int i = 0; i < sink_queue_count; i++) {
+            if (!sink_queues[i]) continue;
+            if (!queues) queues = cJSON_AddArrayToObject(root, "destination-queues");
+            cJSON *entry = cJSON_CreateObject();
+            cJSON_AddNumberToObject(entry, "sink", i);
+            queue_telemetry_to_json(&sink_queue_telemetry[i], entry);
+            cJSON_AddItemToArray(queues, entry);
+        }
+        if (decode_queue) {
+            cJSON *decode = cJSON_AddObjectToObject(root, "decode");
+            cJSON_AddNumberToObject(decode, "frames", (double)__atomic_load_n(&decode_frames, __ATOMIC_RELAXED));
+            queue_telemetry_to_json(&decode_queue_telemetry, cJSON_AddObjectToObject(decode, "queue"));
+            if (proxy_queue) {
+                cJSON *proxy = cJSON_AddObjectToObject(decode, "proxy");
+                cJSON_AddNumberToObject(proxy, "width", proxy_width);
+                cJSON_AddNumberToObject(proxy, "height", proxy_height);
+                cJSON_AddNumberToObject(proxy, "bitrate", proxy_bitrate_kbps);
+                queue_telemetry_to_json(&proxy_queue_telemetry, cJSON_AddObjectToObject(proxy, "queue"));
+            }
+            if (preview_server) {
+                PreviewServerStats preview_stats;
+                preview_server_get_stats(preview_server, &preview_stats);
+                preview_server_stats_to_json(preview_server, &preview_stats, root);
+            }
+            if (thumbnail_appsink && video_health) {
+                VideoHealthStats health_stats;
+                video_health_get_stats(video_health, g_get_monotonic_time(), &health_stats);
+                video_health_stats_to_json(&health_stats, root);
+            }
+        }
 
-                const GstStructure *caller_stats = g_value_get_boxed(caller_val);
-                if (!caller_stats) {
-                    continue;
-                }
+        cJSON *filters = NULL;
+        for (int i = 0; i < MAX_SINKS; i++) {
+            if (!sink_filters[i]) continue;
+            if (!filters) filters = cJSON_AddArrayToObject(root, "destination-filters");
+            pid_filter_add_stats(sink_filters[i], i, filters);
+        }
 
-                cJSON *caller = cJSON_CreateObject();
-
-                gint n_fields = gst_structure_n_fields(caller_stats);
-                for (gint j = 0; j < n_fields; j++) {
-                    const gchar *field_name = gst_structure_nth_field_name(caller_stats, j);
-                    const GValue *value = gst_structure_get_value(caller_stats, field_name);
-
-                    if (G_VALUE_HOLDS(value, G_TYPE_INT64)) {
-                        cJSON_AddNumberToObject(caller, field_name, (double)g_value_get_int64(value));
-                    } else if (G_VALUE_HOLDS(value, G_TYPE_INT)) {
-                        cJSON_AddNumberToObject(caller, field_name, g_value_get_int(value));
-                    } else if (G_VALUE_HOLDS(value, G_TYPE_UINT64)) {
-                        cJSON_AddNumberToObject(caller, field_name, (double)g_value_get_uint64(value));
-                    } else if (G_VALUE_HOLDS(value, G_TYPE_DOUBLE)) {
-                        cJSON_AddNumberToObject(caller, field_name, g_value_get_double(value));
-                    } else if (G_VALUE_HOLDS(value, G_TYPE_OBJECT) && g_strcmp0(field_name, "caller-address") == 0) {
-                        GObject *addr_obj = g_value_get_object(value);
-                        if (G_IS_INET_SOCKET_ADDRESS(addr_obj)) {
-                            GInetSocketAddress *addr = G_INET_SOCKET_ADDRESS(addr_obj);
-                            GInetAddress *inet_addr = g_inet_socket_address_get_address(addr);
-                            guint16 port = g_inet_socket_address_get_port(addr);
-                            gchar *ip = g_inet_address_to_string(inet_addr);
-                            gchar *addr_str = g_strdup_printf("%s:%d", ip, port);
-                            cJSON_AddStringToObject(caller, field_name, addr_str);
-                            g_free(ip);
-                            g_free(addr_str);
-                        }
-                    }
-                }
+        cJSON *nulls = NULL;
+        for (int i = 0; i < MAX_SINKS; i++) {
+            if (!sink_nulls[i]) continue;
+            if (!nulls) nulls = cJSON_AddArrayToObject(root, "destination-nulls");
+            cJSON *entry = cJSON_CreateObject();
+            cJSON_AddNumberToObject(entry, "sink", i);
+            null_shaper_add_stats(sink_nulls[i], entry);
+            cJSON_AddItemToArray(nulls, entry);
+        }
 
-                cJSON_AddItemToArray(callers, caller);
-            }
+        cJSON *pacing = NULL;
+        for (int i = 0; i < MAX_SINKS; i++) {
+            if (!sink_pacers[i]) continue;
+            if (!pacing) pacing = cJSON_AddArrayToObject(root, "destination-pacing");
+            cJSON *entry = cJSON_CreateObject();
+            cJSON_AddNumberToObject(entry, "sink", i);
+            pacer_add_stats(sink_pacers[i], entry);
+            cJSON_AddItemToArray(pacing, entry);
         }
 
-        // Add video metadata from MPEG-TS parsing (if available)
-        pthread_mutex_lock(&video_info.mutex);
-        if (video_info.info_valid) {
-            cJSON_AddNumberToObject(root, "video-width", video_info.width);
-            cJSON_AddNumberToObject(root, "video-height", video_info.height);
-            cJSON_AddNumberToObject(root, "video-framerate-num", video_info.fps_num);
-            cJSON_AddNumberToObject(root, "video-framerate-den", video_info.fps_den);
-            cJSON_AddBoolToObject(root, "video-framerate-inferred", video_info.fps_inferred);
-            cJSON_AddStringToObject(root, "video-interlace-mode",
-                                    video_info.interlaced ? "interleaved" : "progressive");
+        cJSON *fec = NULL;
+        for (int i = 0; i < MAX_SINKS; i++) {
+            if (!sink_fecs[i]) continue;
+            if (!fec) fec = cJSON_AddArrayToObject(root, "destination-fec");
+            cJSON *entry = cJSON_CreateObject();
+            cJSON_AddNumberToObject(entry, "sink", i);
+            fec_sender_add_stats(sink_fecs[i], entry);
+            cJSON_AddItemToArray(fec, entry);
         }
-        pthread_mutex_unlock(&video_info.mutex);
 
         char *json_str = cJSON_PrintUnformatted(root);
         if (json_str) {
-            send_message_to_unix_socket(json_str);
-            send_message_to_unix_socket("\n"); // Newline separator
+            char *message = g_strdup_printf("%s\n", json_str);
+            send_message_to_unix_socket(message);
+            g_free(message);
+            BG_TRACE2(stats_emit, strlen(json_str), g_get_monotonic_time() - report_start_us);
             free(json_str);
         }
 
         cJSON_Delete(root);
-        gst_structure_free(stats);
+        if (stats) gst_structure_free(stats);
 
         // Also collect and send sink stats
         collect_sink_stats();
     }
 
+    thread_policy_forget_self();
     return NULL;
 }
 
+// Stats of the packet stages in front of a destination and of its queue
+static void add_sink_stage_stats(GstElement *sink, cJSON *root)
+{
+    GstElement *shaper = g_object_get_data(G_OBJECT(sink), "bg-null-shaper");
+    if (shaper) null_shaper_add_stats(shaper, root);
+    GstElement *pacer = g_object_get_data(G_OBJECT(sink), "bg-pacer");
+    if (pacer) pacer_add_stats(pacer, root);
+    QueueTelemetry *queue = g_object_get_data(G_OBJECT(sink), "bg-queue-telemetry");
+    if (queue) queue_telemetry_to_json(queue, cJSON_AddObjectToObject(root, "queue"));
+}
+
+// Send with sink prefix so Elixir can distinguish from source stats; frees root
+static void send_sink_stats(cJSON *root)
+{
+    char *json_str = cJSON_PrintUnformatted(root);
+    if (json_str) {
+        char *message = g_strdup_printf("stats_sink:%s\n", json_str);
+        send_message_to_unix_socket(message);
+        g_free(message);
+        free(json_str);
+    }
+    cJSON_Delete(root);
+}
+
+// Bonded destinations report the srtsink fields plus a "bonding" object with per-link stats
+static void collect_group_sink_stats(GstElement *sink, int index)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "sink-index", index);
+    group_sink_add_stats(sink, root);
+    cJSON_AddArrayToObject(root, "callers");
+    add_sink_stage_stats(sink, root);
+    send_sink_stats(root);
+}
+
+// "ip:port" of a caller, or NULL
+static gchar *socket_address_to_string(GSocketAddress *addr)
+{
+    if (!addr || !G_IS_INET_SOCKET_ADDRESS(addr)) return NULL;
+    GInetSocketAddress *inet_addr = G_INET_SOCKET_ADDRESS(addr);
+    gchar *ip = g_inet_address_to_string(g_inet_socket_address_get_address(inet_addr));
+    gchar *str = g_strdup_printf("%s:%d", ip, g_inet_socket_address_get_port(inet_addr));
+    g_free(ip);
+    return str;
+}
+
+// The srtsink keeps one GSocketAddress per connected caller, so it doubles as the caller's key
+static void format_caller(gpointer key, char *buf, gsize size)
+{
+    gchar *addr = socket_address_to_string(key);
+    g_strlcpy(buf, addr ? addr : "", size);
+    g_free(addr);
+}
+
+// Caller stats fields are int64 in current srtsink versions; accept any numeric type
+static gdouble caller_field(const GstStructure *caller, const char *name)
+{
+    const GValue *value = gst_structure_get_value(caller, name);
+    if (!value) return 0.0;
+    if (G_VALUE_HOLDS(value, G_TYPE_INT64)) return (gdouble)g_value_get_int64(value);
+    if (G_VALUE_HOLDS(value, G_TYPE_INT)) return g_value_get_int(value);
+    if (G_VALUE_HOLDS(value, G_TYPE_UINT64)) return (gdouble)g_value_get_uint64(value);
+    if (G_VALUE_HOLDS(value, G_TYPE_DOUBLE)) return g_value_get_double(value);
+    return 0.0;
+}
+
+// Socket-keyed callers (read from libsrt) need no reference; the socket ID stays valid while connected
+static void format_socket_caller(gpointer key, char *buf, gsize size)
+{
+    srt_socket_peer_to_string(GPOINTER_TO_INT(key), buf, size);
+}
+
+// Caller aggregation keyed the way the current stats path identifies callers; switching paths
+// starts it over
+static CallerStats *sink_callers(int index, gboolean direct)
+{
+    if (sink_caller_stats[index] && sink_caller_stats_direct[index] != direct) {
+        caller_stats_free(sink_caller_stats[index]);
+        sink_caller_stats[index] = NULL;
+    }
+    if (!sink_caller_stats[index]) {
+        sink_caller_stats[index] = direct ? caller_stats_new(NULL, NULL, format_socket_caller)
+                                          : caller_stats_new(g_object_ref, g_object_unref, format_caller);
+        sink_caller_stats_direct[index] = direct;
+    }
+    return sink_caller_stats[index];
+}
+
+// srtsink read from its sockets: the srtsink "stats" fields, summed over a listener's callers, plus
+// flight size, congestion window and send buffer depth
+static void collect_sink_socket_stats(GstElement *sink, int index, const SRTSOCKET *socks, gint n)
+{
+    cJSON *root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "sink-index", index);
+
+    CallerStats *callers = sink_callers(index, TRUE);
+    caller_stats_begin(callers);
+    SrtSocketStats total = {0};
+    for (gint i = 0; i < n; i++) {
+        SrtSocketStats socket_stats;
+        if (!srt_socket_stats_read(socks[i], TRUE, &socket_stats)) continue;
+        srt_socket_stats_accumulate(&total, &socket_stats);
+        if (sink_endpoints[index].mode != SRT_ENDPOINT_LISTENER) continue;
+
+        CallerSample sample = {
+            .packets_sent = socket_stats.packets_sent,
+            .packets_lost = socket_stats.packets_sent_lost,
+            .packets_retransmitted = socket_stats.packets_retransmitted,
+            .packets_dropped = socket_stats.packets_sent_dropped,
+            .bytes_sent = socket_stats.bytes_sent,
+            .rtt_ms = socket_stats.rtt_ms,
+            .send_rate_mbps = socket_stats.send_rate_mbps,
+        };
+        caller_stats_update(callers, GINT_TO_POINTER(socks[i]), &sample);
+    }
+
+    sink_bytes_total[index] += total.bytes_sent_interval;
+    cJSON_AddNumberToObject(root, "bytes-sent-total", (double)sink_bytes_total[index]);
+    srt_socket_stats_sender_to_json(&total, root);
+    cJSON_AddNumberToObject(root, "send-buffer-ms-peak", MAX(sink_send_buffer_peak_ms[index], total.send_buffer_ms));
+    sink_send_buffer_peak_ms[index] = 0;
+
+    add_sink_stage_stats(sink, root);
+    gboolean detail = g_get_monotonic_time() < __atomic_load_n(&caller_detail_until_us[index], __ATOMIC_RELAXED);
+    caller_stats_end(callers, detail, root);
+    send_sink_stats(root);
+}
+
+static void update_caller(CallerStats *cs, const GstStructure *caller)
+{
+    const GValue *addr = gst_structure_get_value(caller, "caller-address");
+    if (!addr || !G_VALUE_HOLDS(addr, G_TYPE_SOCKET_ADDRESS) || !g_value_get_object(addr)) return;
+
+    CallerSample sample = {
+        .packets_sent = (gint64)caller_field(caller, "packets-sent"),
+        .packets_lost = (gint64)caller_field(caller, "packets-sent-lost"),
+        .packets_retransmitted = (gint64)caller_field(caller, "packets-retransmitted"),
+        .packets_dropped = (gint64)caller_field(caller, "packets-sent-dropped"),
+        .bytes_sent = (guint64)caller_field(caller, "bytes-sent"),
+        .rtt_ms = caller_field(caller, "rtt-ms"),
+        .send_rate_mbps = caller_field(caller, "send-rate-mbps"),
+    };
+    caller_stats_update(cs, g_value_get_object(addr), &sample);
+}
+
 // Collect stats from all SRT sink elements (destinations)
 static void collect_sink_stats(void)
 {
@@ -216,6 +749,19 @@ static void collect_sink_stats(void)
         GstElement *sink = sink_elements[i];
         if (!sink) continue;
 
+        if (BG_IS_SRT_GROUP_SINK(sink)) {
+            collect_group_sink_stats(sink, i);
+            continue;
+        }
+
+        gint n_socks = sink_endpoint_valid[i] ? srt_socket_index_lookup(srt_index, &sink_endpoints[i], srt_socks,
+                                                                         SRT_STATS_MAX_SOCKETS)
+                                              : -1;
+        if (n_socks >= 0) {
+            collect_sink_socket_stats(sink, i, srt_socks, n_socks);
+            continue;
+        }
+
         GstStructure *stats = NULL;
         g_object_get(sink, "stats", &stats, NULL);
 
@@ -253,77 +799,147 @@ static void collect_sink_stats(void)
         cJSON_AddNumberToObject(root, "bandwidth-mbps", bandwidth_mbps);
         cJSON_AddNumberToObject(root, "negotiated-latency-ms", negotiated_latency_ms);
 
-        // Check for connected callers (clients pulling from this sink in listener mode)
-        const GValue *callers_val = gst_structure_get_value(stats, "callers");
-        if (!callers_val) {
-            cJSON_AddNumberToObject(root, "connected-callers", 0);
-            cJSON_AddArrayToObject(root, "callers");
-        } else if (G_VALUE_HOLDS(callers_val, G_TYPE_VALUE_ARRAY)) {
-            GValueArray *callers_array = g_value_get_boxed(callers_val);
-            gint num_callers = callers_array ? callers_array->n_values : 0;
-
-            cJSON_AddNumberToObject(root, "connected-callers", num_callers);
-            cJSON *callers = cJSON_AddArrayToObject(root, "callers");
-
-            for (gint j = 0; j < num_callers; j++) {
-                GValue *caller_val = &callers_array->values[j];
-                if (!G_VALUE_HOLDS(caller_val, GST_TYPE_STRUCTURE)) {
-                    continue;
-                }
-
-                const GstStructure *caller_stats = g_value_get_boxed(caller_val);
-                if (!caller_stats) {
-                    continue;
-                }
+        add_sink_stage_stats(sink, root);
 
-                cJSON *caller = cJSON_CreateObject();
-
-                gint n_fields = gst_structure_n_fields(caller_stats);
-                for (gint k = 0; k < n_fields; k++) {
-                    const gchar *field_name = gst_structure_nth_field_name(caller_stats, k);
-                    const GValue *value = gst_structure_get_value(caller_stats, field_name);
-
-                    if (G_VALUE_HOLDS(value, G_TYPE_INT64)) {
-                        cJSON_AddNumberToObject(caller, field_name, (double)g_value_get_int64(value));
-                    } else if (G_VALUE_HOLDS(value, G_TYPE_INT)) {
-                        cJSON_AddNumberToObject(caller, field_name, g_value_get_int(value));
-                    } else if (G_VALUE_HOLDS(value, G_TYPE_UINT64)) {
-                        cJSON_AddNumberToObject(caller, field_name, (double)g_value_get_uint64(value));
-                    } else if (G_VALUE_HOLDS(value, G_TYPE_DOUBLE)) {
-                        cJSON_AddNumberToObject(caller, field_name, g_value_get_double(value));
-                    } else if (G_VALUE_HOLDS(value, G_TYPE_OBJECT) && g_strcmp0(field_name, "caller-address") == 0) {
-                        GObject *addr_obj = g_value_get_object(value);
-                        if (G_IS_INET_SOCKET_ADDRESS(addr_obj)) {
-                            GInetSocketAddress *addr = G_INET_SOCKET_ADDRESS(addr_obj);
-                            GInetAddress *inet_addr = g_inet_socket_address_get_address(addr);
-                            guint16 port = g_inet_socket_address_get_port(addr);
-                            gchar *ip = g_inet_address_to_string(inet_addr);
-                            gchar *addr_str = g_strdup_printf("%s:%d", ip, port);
-                            cJSON_AddStringToObject(caller, field_name, addr_str);
-                            g_free(ip);
-                            g_free(addr_str);
-                        }
-                    }
-                }
-
-                cJSON_AddItemToArray(callers, caller);
-            }
+        // Connected callers (clients pulling from this sink in listener mode), aggregated per report
+        const GValue *callers_val = gst_structure_get_value(stats, "callers");
+        GValueArray *callers_array = NULL;
+        if (callers_val && G_VALUE_HOLDS(callers_val, G_TYPE_VALUE_ARRAY)) {
+            callers_array = g_value_get_boxed(callers_val);
         }
 
-        char *json_str = cJSON_PrintUnformatted(root);
-        if (json_str) {
-            // Send with sink prefix so Elixir can distinguish from source stats
-            send_message_to_unix_socket("stats_sink:");
-            send_message_to_unix_socket(json_str);
-            send_message_to_unix_socket("\n"); // Newline separator
-            free(json_str);
+        CallerStats *callers = sink_callers(i, FALSE);
+        caller_stats_begin(callers);
+        for (guint j = 0; callers_array && j < callers_array->n_values; j++) {
+            GValue *caller_val = &callers_array->values[j];
+            if (!G_VALUE_HOLDS(caller_val, GST_TYPE_STRUCTURE)) continue;
+            const GstStructure *caller = g_value_get_boxed(caller_val);
+            if (caller) update_caller(callers, caller);
         }
+        gboolean detail = g_get_monotonic_time() < __atomic_load_n(&caller_detail_until_us[i], __ATOMIC_RELAXED);
+        caller_stats_end(callers, detail, root);
 
-        cJSON_Delete(root);
+        send_sink_stats(root);
         gst_structure_free(stats);
     }
 }
 
+// Events go out as one "event:" message each the moment they happen, not with the next stats tick,
+// stamped with the wall-clock time they were raised
+static void send_event(cJSON *event)
+{
+    cJSON_AddNumberToObject(event, "time-ms", (double)(g_get_real_time() / 1000));
+    char *json_str = cJSON_PrintUnformatted(event);
+    if (json_str) {
+        char *message = g_strdup_printf("event:%s\n", json_str);
+        send_message_to_unix_socket(message);
+        g_free(message);
+        free(json_str);
+    }
+    cJSON_Delete(event);
+}
+
+// "caller-connected", "caller-disconnected" or "caller-rejected" for a caller of the source listener
+// (sink < 0) or of a listener destination
+static cJSON *caller_event(const char *name, int sink, const char *address, const char *stream_id)
+{
+    cJSON *event = cJSON_CreateObject();
+    cJSON_AddStringToObject(event, "event", name);
+    cJSON_AddStringToObject(event, "side", sink < 0 ? "source" : "sink");
+    if (sink >= 0) cJSON_AddNumberToObject(event, "sink", sink);
+    cJSON_AddStringToObject(event, "address", address ? address : "");
+    if (stream_id) cJSON_AddStringToObject(event, "stream-id", stream_id);
+    return event;
+}
+
+static void send_caller_event(const char *name, int sink, const char *address, const char *stream_id)
+{
+    send_event(caller_event(name, sink, address, stream_id));
+}
+
+// Whether the route has its input, as the control plane sees it: lost when the last caller of a listener
+// source leaves or the watchdog finds the input silent, restored when a caller or data comes back.
+// Only transitions are sent, so the two sources of truth cannot repeat each other.
+static void set_source_lost(gboolean lost, const char *reason)
+{
+    if (__atomic_exchange_n(&source_lost, lost, __ATOMIC_ACQ_REL) == lost) return;
+    cJSON *event = cJSON_CreateObject();
+    cJSON_AddStringToObject(event, "event", lost ? "source-lost" : "source-restored");
+    cJSON_AddStringToObject(event, "reason", reason);
+    send_event(event);
+}
+
+// "error" or "warning" with the posting element, the message and GStreamer's debug detail
+static void send_bus_problem_event(const char *name, GstMessage *msg, const GError *err, const gchar *debug)
+{
+    cJSON *event = cJSON_CreateObject();
+    cJSON_AddStringToObject(event, "event", name);
+    cJSON_AddStringToObject(event, "element", GST_MESSAGE_SRC_NAME(msg) ? GST_MESSAGE_SRC_NAME(msg) : "");
+    cJSON_AddStringToObject(event, "message", err && err->message ? err->message : "");
+    if (debug) cJSON_AddStringToObject(event, "debug", debug);
+    send_event(event);
+}
+
+// Bring the source back without touching the tee or any destination, so sink callers stay connected.
+// srtsrc re-listens or re-calls on its way back to PLAYING; a bonded source redials its links and a
+// UDP source reopens its socket and rejoins its group.
+// Callers of a shared listener belong to the listener process, so there is nothing to restart here.
+static gboolean restart_source(void)
+{
+    if (shared_source) return FALSE;
+    if (group_source) {
+        srt_group_stop(group_source);
+        return srt_group_start(group_source);
+    }
+    if (udp_source) {
+        udp_source_stop(udp_source);
+        return udp_source_start(udp_source);
+    }
+    if (gst_element_set_state(source_element, GST_STATE_NULL) == GST_STATE_CHANGE_FAILURE) return FALSE;
+    return gst_element_sync_state_with_parent(source_element);
+}
+
+static gboolean watchdog_tick(gpointer data)
+{
+    (void)data;
+
+    gint64 elapsed_ms = 0;
+    InputWatchdogAction action = input_watchdog_poll(source_watchdog, g_get_monotonic_time(), &elapsed_ms);
+    if (action == INPUT_WATCHDOG_RESUMED) {
+        g_print("Watchdog: input resumed after %" G_GINT64_FORMAT " ms\n", elapsed_ms);
+        cJSON *event = cJSON_CreateObject();
+        cJSON_AddStringToObject(event, "event", "input-resumed");
+        cJSON_AddNumberToObject(event, "outage-ms", (double)elapsed_ms);
+        send_event(event);
+        set_source_lost(FALSE, "input-resumed");
+        return G_SOURCE_CONTINUE;
+    }
+    if (action != INPUT_WATCHDOG_STALLED) return G_SOURCE_CONTINUE;
+
+    gboolean restart = input_watchdog_restart_enabled(source_watchdog) && !shared_source;
+    g_print("Watchdog: no input for %" G_GINT64_FORMAT " ms%s\n", elapsed_ms,
+            restart ? ", restarting the source" : "");
+    cJSON *event = cJSON_CreateObject();
+    cJSON_AddStringToObject(event, "event", "input-stall");
+    cJSON_AddNumberToObject(event, "silent-ms", (double)elapsed_ms);
+    cJSON_AddBoolToObject(event, "restart", restart);
+    send_event(event);
+    set_source_lost(TRUE, "input-stall");
+    if (!restart) return G_SOURCE_CONTINUE;
+
+    gint64 start_us = g_get_monotonic_time();
+    gboolean ok = restart_source();
+    gint64 duration_us = g_get_monotonic_time() - start_us;
+    input_watchdog_restarted(source_watchdog, duration_us, ok);
+    if (!ok) g_printerr("Watchdog: failed to restart the source\n");
+
+    event = cJSON_CreateObject();
+    cJSON_AddStringToObject(event, "event", ok ? "source-restarted" : "source-restart-failed");
+    cJSON_AddNumberToObject(event, "restart-ms", (double)(duration_us / 1000));
+    send_event(event);
+    return G_SOURCE_CONTINUE;
+}
+
 static gboolean bus_callback(GstBus *bus, GstMessage *msg, gpointer data)
 {
     GstElement *pipeline = GST_ELEMENT(data);
@@ -334,24 +950,47 @@ static gboolean bus_callback(GstBus *bus, GstMessage *msg, gpointer data)
             gchar *debug;
             gst_message_parse_error(msg, &err, &debug);
             g_print("Error: %s\n", err->message);
+            send_bus_problem_event("error", msg, err, debug);
             g_error_free(err);
             g_free(debug);
             if (loop) g_main_loop_quit(loop);
             break;
         }
+        case GST_MESSAGE_WARNING: {
+            GError *err;
+            gchar *debug;
+            gst_message_parse_warning(msg, &err, &debug);
+            g_print("Warning: %s\n", err->message);
+            send_bus_problem_event("warning", msg, err, debug);
+            g_error_free(err);
+            g_free(debug);
+            break;
+        }
         case GST_MESSAGE_STATE_CHANGED: {
             if (GST_MESSAGE_SRC(msg) == GST_OBJECT(pipeline)) {
                 GstState old_state, new_state, pending_state;
                 gst_message_parse_state_changed(msg, &old_state, &new_state, &pending_state);
                 g_print("Pipeline state changed from %s to %s\n", gst_element_state_get_name(old_state),
                         gst_element_state_get_name(new_state));
+                cJSON *event = cJSON_CreateObject();
+                cJSON_AddStringToObject(event, "event", "state-changed");
+                cJSON_AddStringToObject(event, "from", gst_element_state_get_name(old_state));
+                cJSON_AddStringToObject(event, "to", gst_element_state_get_name(new_state));
+                send_event(event);
             }
             break;
         }
         case GST_MESSAGE_ELEMENT: {
             const GstStructure *s = gst_message_get_structure(msg);
             if (s && gst_structure_has_name(s, "GstSRTObject")) {
-                g_print("SRT Event: %s\n", gst_structure_to_string(s));
+                gchar *details = gst_structure_to_string(s);
+                g_print("SRT Event: %s\n", details);
+                cJSON *event = cJSON_CreateObject();
+                cJSON_AddStringToObject(event, "event", "srt");
+                cJSON_AddStringToObject(event, "element", GST_MESSAGE_SRC_NAME(msg) ? GST_MESSAGE_SRC_NAME(msg) : "");
+                cJSON_AddStringToObject(event, "details", details);
+                send_event(event);
+                g_free(details);
             }
             break;
         }
@@ -361,36 +1000,220 @@ static gboolean bus_callback(GstBus *bus, GstMessage *msg, gpointer data)
     return TRUE;
 }
 
+// Runs in the posting thread. Streaming threads post STREAM_STATUS ENTER from inside themselves,
+// which is the one place we can apply the route's CPU and scheduling policy to them.
+static GstBusSyncReply bus_sync_handler(GstBus *bus, GstMessage *msg, gpointer data)
+{
+    (void)bus;
+    (void)data;
+
+    if (GST_MESSAGE_TYPE(msg) != GST_MESSAGE_STREAM_STATUS) return GST_BUS_PASS;
+
+    GstStreamStatusType type;
+    GstElement *owner = NULL;
+    gst_message_parse_stream_status(msg, &type, &owner);
+    // LEAVE is posted from the exiting thread too; its tid may be reused by the next task
+    if (type == GST_STREAM_STATUS_TYPE_LEAVE) {
+        thread_policy_forget_self();
+        return GST_BUS_PASS;
+    }
+    if (type != GST_STREAM_STATUS_TYPE_ENTER || !owner) return GST_BUS_PASS;
+
+    // The batcher's task pushes nearly every list through the tee: it is the source's media path
+    if (owner == source_element || owner == batch_element) {
+        thread_policy_apply_self(THREAD_ROLE_SOURCE, owner == source_element ? "source" : "batch");
+        return GST_BUS_PASS;
+    }
+
+    for (int i = 0; i < sink_queue_count; i++) {
+        if (owner == sink_queues[i]) {
+            char name[32];
+            snprintf(name, sizeof(name), "sink-%d", i);
+            thread_policy_apply_self(THREAD_ROLE_SINK, name);
+            return GST_BUS_PASS;
+        }
+    }
+
+    // Stages with their own output task in front of a destination (bgpacer)
+    const char *sink_thread = g_object_get_data(G_OBJECT(owner), "bg-sink-thread");
+    if (sink_thread) {
+        thread_policy_apply_self(THREAD_ROLE_SINK, sink_thread);
+        return GST_BUS_PASS;
+    }
+
+    if (owner == audio_queue) {
+        audio_thread = pthread_self();
+        __atomic_store_n(&audio_thread_known, TRUE, __ATOMIC_RELEASE);
+    }
+
+    // Everything else (decode tier and audio queues, decodebin's multiqueue) is analysis work
+    thread_policy_apply_self(THREAD_ROLE_ANALYSIS, GST_ELEMENT_NAME(owner));
+    return GST_BUS_PASS;
+}
+
 static void on_caller_connecting(GstElement *element, GSocketAddress *addr, const gchar *stream_id,
                                  gboolean *authenticated, gpointer user_data)
 {
-    g_print("\nIncoming SRT Connection1:\n");
+    (void)element;
+    (void)user_data;
 
+    gchar *ip = NULL;
+    guint16 port = 0;
     if (addr && G_IS_INET_SOCKET_ADDRESS(addr)) {
         GInetSocketAddress *inet_addr = G_INET_SOCKET_ADDRESS(addr);
-        GInetAddress *address = g_inet_socket_address_get_address(inet_addr);
-        guint16 port = g_inet_socket_address_get_port(inet_addr);
-        gchar *ip = g_inet_address_to_string(address);
-        g_print("  From: %s:%d\n", ip, port);
+        ip = g_inet_address_to_string(g_inet_socket_address_get_address(inet_addr));
+        port = g_inet_socket_address_get_port(inet_addr);
+    }
+
+    // Decided before libsrt sets up crypto and buffers for the caller
+    AdmissionResult result =
+        source_admission ? admission_check(source_admission, ip, stream_id, g_get_monotonic_time()) : ADMISSION_ACCEPT;
+    BG_TRACE4(caller_connect, ip, port, stream_id, result == ADMISSION_ACCEPT);
+
+    if (authenticated) {
+        *authenticated = result == ADMISSION_ACCEPT;
+    }
+
+    gchar *address = socket_address_to_string(addr);
+    if (result != ADMISSION_ACCEPT) {
+        // Only counted here; flush_caller_rejections reports them
+        g_mutex_lock(&caller_rejections_lock);
+        CallerRejections *rejections = &caller_rejections[result];
+        rejections->count++;
+        g_strlcpy(rejections->address, address ? address : "", sizeof(rejections->address));
+        rejections->has_stream_id = stream_id != NULL;
+        g_strlcpy(rejections->stream_id, stream_id ? stream_id : "", sizeof(rejections->stream_id));
+        g_mutex_unlock(&caller_rejections_lock);
+        g_free(address);
         g_free(ip);
+        return;
     }
 
+    g_print("\nIncoming SRT Connection1:\n");
+    if (ip) g_print("  From: %s:%d\n", ip, port);
     if (stream_id) {
-        g_print("  Stream ID: '%s'\n", stream_id);
+        gchar *printable = g_strescape(stream_id, NULL);
+        g_print("  Stream ID: '%s'\n", printable);
+        g_free(printable);
     } else {
         g_print("  Stream ID: (none)\n");
     }
 
-    if (authenticated) {
-        *authenticated = TRUE;
+    if (stream_id && address) {
+        // caller-added only carries the address; keep the stream ID until the handshake completes
+        g_mutex_lock(&caller_stream_ids_lock);
+        if (g_hash_table_size(caller_stream_ids) >= MAX_PENDING_CALLERS) g_hash_table_remove_all(caller_stream_ids);
+        g_hash_table_replace(caller_stream_ids, g_strdup(address), g_strdup(stream_id));
+        g_mutex_unlock(&caller_stream_ids_lock);
     }
+    g_free(address);
+    g_free(ip);
+}
 
-    if (stream_id) {
-        send_message_to_unix_socket("stats_source_stream_id:");
-        send_message_to_unix_socket(stream_id);
+// One "caller-rejected" event per reason with callers refused since the last call: the number of them
+// in `count`, and the address and stream ID of the last one. Called once a second by the stats thread.
+static void flush_caller_rejections(void)
+{
+    CallerRejections rejections[ADMISSION_RESULT_COUNT];
+    g_mutex_lock(&caller_rejections_lock);
+    memcpy(rejections, caller_rejections, sizeof(rejections));
+    memset(caller_rejections, 0, sizeof(caller_rejections));
+    g_mutex_unlock(&caller_rejections_lock);
+
+    for (int i = 0; i < ADMISSION_RESULT_COUNT; i++) {
+        if (!rejections[i].count) continue;
+        cJSON *event = caller_event("caller-rejected", -1, rejections[i].address,
+                                    rejections[i].has_stream_id ? rejections[i].stream_id : NULL);
+        cJSON_AddStringToObject(event, "reason", admission_result_name((AdmissionResult)i));
+        cJSON_AddNumberToObject(event, "count", (double)rejections[i].count);
+        send_event(event);
+        g_print("Rejected %" G_GUINT64_FORMAT " caller(s): %s\n", rejections[i].count,
+                admission_result_name((AdmissionResult)i));
     }
 }
 
+static void on_caller_added(GstElement *element, gint unused, GSocketAddress *addr, gpointer user_data)
+{
+    (void)element;
+    (void)unused;
+    (void)user_data;
+    if (source_admission) admission_caller_added(source_admission);
+    gchar *peer = socket_address_to_string(addr);
+    BG_TRACE1(caller_added, peer);
+
+    gchar *stream_id = NULL;
+    if (peer) {
+        gpointer stolen_key = NULL;
+        g_mutex_lock(&caller_stream_ids_lock);
+        if (g_hash_table_steal_extended(caller_stream_ids, peer, &stolen_key, (gpointer *)&stream_id)) {
+            g_free(stolen_key);
+        }
+        g_mutex_unlock(&caller_stream_ids_lock);
+    }
+
+    // Admission already refused IDs with control characters; never let one frame a message of its own
+    if (stream_id && admission_stream_id_is_safe(stream_id)) {
+        char *message = g_strdup_printf("stats_source_stream_id:%s\n", stream_id);
+        send_message_to_unix_socket(message);
+        g_free(message);
+    }
+    send_caller_event("caller-connected", -1, peer, stream_id);
+    if (__atomic_add_fetch(&source_callers, 1, __ATOMIC_ACQ_REL) == 1) set_source_lost(FALSE, "caller-connected");
+    g_free(stream_id);
+    g_free(peer);
+}
+
+static void on_caller_removed(GstElement *element, gint unused, GSocketAddress *addr, gpointer user_data)
+{
+    (void)element;
+    (void)unused;
+    (void)user_data;
+    if (source_admission) admission_caller_removed(source_admission);
+    gchar *peer = socket_address_to_string(addr);
+    BG_TRACE1(caller_removed, peer);
+    send_caller_event("caller-disconnected", -1, peer, NULL);
+    if (__atomic_sub_fetch(&source_callers, 1, __ATOMIC_ACQ_REL) == 0) set_source_lost(TRUE, "caller-disconnected");
+    g_free(peer);
+}
+
+static void on_sink_caller_added(GstElement *element, gint unused, GSocketAddress *addr, gpointer user_data)
+{
+    (void)element;
+    (void)unused;
+    gchar *peer = socket_address_to_string(addr);
+    send_caller_event("caller-connected", GPOINTER_TO_INT(user_data), peer, NULL);
+    g_free(peer);
+}
+
+static void on_sink_caller_removed(GstElement *element, gint unused, GSocketAddress *addr, gpointer user_data)
+{
+    (void)element;
+    (void)unused;
+    gchar *peer = socket_address_to_string(addr);
+    send_caller_event("caller-disconnected", GPOINTER_TO_INT(user_data), peer, NULL);
+    g_free(peer);
+}
+
+// Where an srtsrc/srtsink keeps its sockets: its URI, with the "mode" property (which the route config
+// may set apart from the URI) and, for a listener without a port in the URI, "localport". A caller
+// whose host does not resolve is left to the element's own "stats".
+static gboolean srt_element_endpoint(GstElement *element, SrtEndpoint *endpoint)
+{
+    gchar *uri = NULL;
+    gint mode = 0;
+    guint local_port = 0;
+    g_object_get(element, "uri", &uri, "mode", &mode, "localport", &local_port, NULL);
+    srt_endpoint_from_uri(uri, endpoint);
+    g_free(uri);
+
+    // GStreamer SRT mode values: 0=none, 1=caller, 2=listener, 3=rendezvous
+    if (mode == 1) endpoint->mode = SRT_ENDPOINT_CALLER;
+    if (mode == 2) endpoint->mode = SRT_ENDPOINT_LISTENER;
+    if (mode == 3) endpoint->mode = SRT_ENDPOINT_RENDEZVOUS;
+    if (!endpoint->port && endpoint->mode == SRT_ENDPOINT_LISTENER) endpoint->port = (guint16)local_port;
+    return endpoint->port != 0 && srt_endpoint_resolve(endpoint);
+}
+
 static void set_srt_mode_property(GstElement *element, const char *mode_str, const char *element_desc)
 {
     // GStreamer SRT mode values: 0=none, 1=caller, 2=listener, 3=rendezvous
@@ -425,6 +1248,11 @@ static void set_element_properties(GstElement *element, cJSON *config, const cha
             continue;
         }
 
+        // Routing flags of a sink config, not element properties
+        if (strcmp(property->string, "proxy") == 0 || strcmp(property->string, "delay") == 0) {
+            continue;
+        }
+
         if ((strcmp(element_type, "srtsrc") == 0 || strcmp(element_type, "srtsink") == 0) &&
             strcmp(property->string, "mode") == 0 && cJSON_IsString(property)) {
             set_srt_mode_property(element, property->valuestring, element_type);
@@ -453,457 +1281,171 @@ static void set_element_properties(GstElement *element, cJSON *config, const cha
 }
 
 // =============================================================================
-// MPEG-TS Parsing Functions
+// MPEG-TS Video Metadata
 // =============================================================================
 
-// Parse PAT (Program Association Table) to find PMT PID
-static void parse_pat(const guint8 *data, gsize size)
+static cJSON *video_format_to_json(const TsVideoFormat *format)
+{
+    cJSON *json = cJSON_CreateObject();
+    cJSON_AddStringToObject(json, "codec", ts_metadata_codec_name(format->stream_type));
+    cJSON_AddNumberToObject(json, "width", format->width);
+    cJSON_AddNumberToObject(json, "height", format->height);
+    cJSON_AddNumberToObject(json, "framerate-num", format->fps_num);
+    cJSON_AddNumberToObject(json, "framerate-den", format->fps_den);
+    cJSON_AddBoolToObject(json, "framerate-inferred", format->fps_inferred);
+    cJSON_AddStringToObject(json, "interlace-mode", format->interlaced ? "interleaved" : "progressive");
+    return json;
+}
+
+// "format-changed" with the old format (absent on first detection) and the new one
+static void on_video_format_changed(const TsVideoFormat *old_format, const TsVideoFormat *new_format,
+                                    gpointer user_data)
 {
-    if (size < 8) return;
+    (void)user_data;
+    cJSON *event = cJSON_CreateObject();
+    cJSON_AddStringToObject(event, "event", "format-changed");
+    if (old_format->valid) cJSON_AddItemToObject(event, "old", video_format_to_json(old_format));
+    cJSON_AddItemToObject(event, "new", video_format_to_json(new_format));
+    send_event(event);
+}
 
-    // Skip TS header (4 bytes) and PAT header
-    // table_id(1) + syntax(2) + reserved(1) + section_length(2) + ts_stream_id(2)
-    // + reserved(1) + version(1) + section_number(1) + last_section_number(1) = 8 bytes
+static void feed_ts_buffer(GstBuffer *buffer)
+{
+    GstMapInfo map;
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return;
+    ts_metadata_feed(ts_metadata, map.data, map.size);
+    gst_buffer_unmap(buffer, &map);
+}
 
-    gsize offset = 0;
+// Buffer probe callback to parse MPEG-TS packets (single buffers, or lists from the batching stage)
+static GstPadProbeReturn ts_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    (void)pad;
+    (void)user_data;
 
-    // Find start of PAT data after adaptation field
-    if (data[3] & 0x20) {     // Adaptation field present
-        offset = 5 + data[4]; // Skip adaptation field length
-    } else {
-        offset = 4;
+    // The buffer (or list) pointer lets a tracer match this arrival with the sink_push of each destination
+    if (BG_TRACE_ENABLED(tee_buffer)) {
+        if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+            GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+            BG_TRACE3(tee_buffer, list, gst_buffer_list_calculate_size(list), gst_buffer_list_length(list));
+        } else {
+            GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+            BG_TRACE3(tee_buffer, buffer, gst_buffer_get_size(buffer), 1);
+        }
     }
 
-    if (data[3] & 0x10) { // Payload present
-        // Pointer field
-        offset += 1 + data[offset];
+    // Tracked for as long as the source runs: PSI versions and parameter set fingerprints keep the
+    // per-buffer cost to a PID lookup per packet until something actually changes
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+        guint n = list ? gst_buffer_list_length(list) : 0;
+        for (guint i = 0; i < n; i++) feed_ts_buffer(gst_buffer_list_get(list, i));
+    } else {
+        GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+        if (buffer) feed_ts_buffer(buffer);
     }
+    return GST_PAD_PROBE_OK;
+}
 
-    if (offset + 8 > size) return;
+// Record that data reached the tee; the main loop timer decides whether the input has stalled
+static GstPadProbeReturn watchdog_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    (void)pad;
+    (void)info;
+    (void)user_data;
 
-    // Skip table_id (1 byte), section_syntax_indicator + reserved + section_length (2 bytes)
-    // transport_stream_id (2 bytes), reserved + version + current_next (1 byte)
-    // section_number (1 byte), last_section_number (1 byte)
-    gsize pat_offset = offset + 8;
-
-    // Section length is in bytes 1-2 (offset+1, offset+2)
-    guint16 section_length = ((data[offset + 1] & 0x0F) << 8) | data[offset + 2];
-    gsize section_end = offset + 3 + section_length - 4; // -4 for CRC
-
-    // Parse program entries (each is 4 bytes: program_number(2) + reserved(3 bits) + PMT_PID(13 bits))
-    while (pat_offset + 4 <= section_end && pat_offset + 4 <= size) {
-        guint16 program_number = (data[pat_offset] << 8) | data[pat_offset + 1];
-        guint16 pmt_pid = ((data[pat_offset + 2] & 0x1F) << 8) | data[pat_offset + 3];
-
-        if (program_number != 0) { // 0 is Network PID, skip it
-            pthread_mutex_lock(&video_info.mutex);
-            if (video_info.pmt_pid == 0) {
-                video_info.pmt_pid = pmt_pid;
-                g_print("MPEG-TS: Found PMT PID: %d (program %d)\n", pmt_pid, program_number);
-            }
-            pthread_mutex_unlock(&video_info.mutex);
-            break;
-        }
-        pat_offset += 4;
-    }
+    input_watchdog_feed(source_watchdog, g_get_monotonic_time());
+    return GST_PAD_PROBE_OK;
 }
 
-// Parse PMT (Program Map Table) to find video stream PID and type
-static void parse_pmt(const guint8 *data, gsize size)
+#if BG_TRACE_AVAILABLE
+// On the first element of each destination, i.e. where a buffer leaves the destination's queue. Only
+// installed in builds with USDT support; until a tracer attaches it is one semaphore test per buffer.
+static GstPadProbeReturn sink_trace_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
 {
-    if (size < 12) return;
+    (void)pad;
 
-    gsize offset = 0;
+    if (!BG_TRACE_ENABLED(sink_push)) return GST_PAD_PROBE_OK;
 
-    // Skip adaptation field if present
-    if (data[3] & 0x20) {
-        offset = 5 + data[4];
+    int sink_index = GPOINTER_TO_INT(user_data);
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+        BG_TRACE3(sink_push, sink_index, list, gst_buffer_list_calculate_size(list));
     } else {
-        offset = 4;
-    }
-
-    if (data[3] & 0x10) {           // Payload present
-        offset += 1 + data[offset]; // Pointer field
-    }
-
-    if (offset + 12 > size) return;
-
-    guint16 section_length = ((data[offset + 1] & 0x0F) << 8) | data[offset + 2];
-
-    // Skip: table_id(1) + section_length(2) + program_number(2) + reserved(1)
-    // + section_number(1) + last_section_number(1) + reserved(1) + PCR_PID(2) + reserved(1) + program_info_length(2)
-    guint16 program_info_length = ((data[offset + 10] & 0x0F) << 8) | data[offset + 11];
-
-    gsize stream_offset = offset + 12 + program_info_length;
-    gsize section_end = offset + 3 + section_length - 4; // -4 for CRC
-
-    // Parse elementary stream entries
-    while (stream_offset + 5 <= section_end && stream_offset + 5 <= size) {
-        guint8 stream_type = data[stream_offset];
-        guint16 es_pid = ((data[stream_offset + 1] & 0x1F) << 8) | data[stream_offset + 2];
-        guint16 es_info_length = ((data[stream_offset + 3] & 0x0F) << 8) | data[stream_offset + 4];
-
-        // Check if this is a video stream
-        if (stream_type == STREAM_TYPE_MPEG2_VIDEO || stream_type == STREAM_TYPE_H264 ||
-            stream_type == STREAM_TYPE_HEVC) {
-            pthread_mutex_lock(&video_info.mutex);
-            if (video_info.video_pid == 0) {
-                video_info.video_pid = es_pid;
-                video_info.video_stream_type = stream_type;
-                const char *type_name = stream_type == STREAM_TYPE_H264   ? "H.264"
-                                        : stream_type == STREAM_TYPE_HEVC ? "HEVC"
-                                                                          : "MPEG-2";
-                g_print("MPEG-TS: Found video stream PID: %d (type: %s)\n", es_pid, type_name);
-            }
-            pthread_mutex_unlock(&video_info.mutex);
-            break;
-        }
-
-        stream_offset += 5 + es_info_length;
-    }
-}
-
-// Bit reader helper for H.264 SPS parsing
-typedef struct {
-    const guint8 *data;
-    gsize size;
-    gsize byte_offset;
-    gint bit_offset;
-} BitReader;
-
-static guint32 read_bits(BitReader *br, gint n)
-{
-    guint32 result = 0;
-    for (gint i = 0; i < n; i++) {
-        if (br->byte_offset >= br->size) return result;
-        result <<= 1;
-        result |= (br->data[br->byte_offset] >> (7 - br->bit_offset)) & 1;
-        br->bit_offset++;
-        if (br->bit_offset >= 8) {
-            br->bit_offset = 0;
-            br->byte_offset++;
-        }
+        GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+        BG_TRACE3(sink_push, sink_index, buffer, gst_buffer_get_size(buffer));
     }
-    return result;
-}
-
-// Read 32-bit unsigned integer (byte-aligned read for efficiency)
-static guint32 read_u32(BitReader *br)
-{
-    guint32 result = 0;
-    result |= read_bits(br, 8) << 24;
-    result |= read_bits(br, 8) << 16;
-    result |= read_bits(br, 8) << 8;
-    result |= read_bits(br, 8);
-    return result;
-}
-
-static guint32 read_ue(BitReader *br) // Exp-Golomb unsigned
-{
-    gint leading_zeros = 0;
-    while (read_bits(br, 1) == 0 && leading_zeros < 32) leading_zeros++;
-    return (1 << leading_zeros) - 1 + read_bits(br, leading_zeros);
+    return GST_PAD_PROBE_OK;
 }
+#endif
 
-// Parse H.264 SPS NAL unit to get resolution and framerate
-static void parse_h264_sps(const guint8 *data, gsize size)
+// Hand every buffer to the output pool; its workers push to the destinations
+static GstPadProbeReturn output_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
 {
-    if (size < 5) return;
-
-    // Skip NAL header (1 byte)
-    BitReader br = {data + 1, size - 1, 0, 0};
+    (void)pad;
+    (void)user_data;
 
-    guint8 profile_idc = read_bits(&br, 8);
-    read_bits(&br, 8); // constraint_set flags + reserved
-    read_bits(&br, 8); // level_idc
-    read_ue(&br);      // seq_parameter_set_id
+    if (!output_pool) return GST_PAD_PROBE_OK;
 
-    // Handle high profiles
-    if (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 || profile_idc == 244 || profile_idc == 44 ||
-        profile_idc == 83 || profile_idc == 86 || profile_idc == 118 || profile_idc == 128 || profile_idc == 138 ||
-        profile_idc == 139 || profile_idc == 134) {
-        guint32 chroma_format_idc = read_ue(&br);
-        if (chroma_format_idc == 3) read_bits(&br, 1); // separate_colour_plane_flag
-        read_ue(&br);                                  // bit_depth_luma_minus8
-        read_ue(&br);                                  // bit_depth_chroma_minus8
-        read_bits(&br, 1);                             // qpprime_y_zero_transform_bypass_flag
-        if (read_bits(&br, 1)) {                       // seq_scaling_matrix_present_flag
-            for (int i = 0; i < ((chroma_format_idc != 3) ? 8 : 12); i++) {
-                if (read_bits(&br, 1)) { // seq_scaling_list_present_flag
-                    gint size_list = (i < 6) ? 16 : 64;
-                    gint last_scale = 8, next_scale = 8;
-                    for (int j = 0; j < size_list; j++) {
-                        if (next_scale != 0) {
-                            gint delta = read_ue(&br);
-                            next_scale = (last_scale + delta) % 256;
-                        }
-                        last_scale = (next_scale == 0) ? last_scale : next_scale;
-                    }
-                }
-            }
-        }
-    }
-
-    read_ue(&br); // log2_max_frame_num_minus4
-    guint32 pic_order_cnt_type = read_ue(&br);
-    if (pic_order_cnt_type == 0) {
-        read_ue(&br); // log2_max_pic_order_cnt_lsb_minus4
-    } else if (pic_order_cnt_type == 1) {
-        read_bits(&br, 1); // delta_pic_order_always_zero_flag
-        read_ue(&br);      // offset_for_non_ref_pic
-        read_ue(&br);      // offset_for_top_to_bottom_field
-        guint32 num_ref_frames_in_pic_order_cnt_cycle = read_ue(&br);
-        for (guint32 i = 0; i < num_ref_frames_in_pic_order_cnt_cycle; i++) read_ue(&br);
-    }
-
-    read_ue(&br);      // max_num_ref_frames
-    read_bits(&br, 1); // gaps_in_frame_num_value_allowed_flag
-
-    guint32 pic_width_in_mbs_minus1 = read_ue(&br);
-    guint32 pic_height_in_map_units_minus1 = read_ue(&br);
-    guint32 frame_mbs_only_flag = read_bits(&br, 1);
-
-    gint width = (pic_width_in_mbs_minus1 + 1) * 16;
-    gint height = (pic_height_in_map_units_minus1 + 1) * 16 * (frame_mbs_only_flag ? 1 : 2);
-    gboolean interlaced = !frame_mbs_only_flag;
-
-    // Crop dimensions if needed
-    if (!frame_mbs_only_flag) read_bits(&br, 1); // mb_adaptive_frame_field_flag
-    read_bits(&br, 1);                           // direct_8x8_inference_flag
-
-    if (read_bits(&br, 1)) { // frame_cropping_flag
-        guint32 crop_left = read_ue(&br);
-        guint32 crop_right = read_ue(&br);
-        guint32 crop_top = read_ue(&br);
-        guint32 crop_bottom = read_ue(&br);
-        width -= (crop_left + crop_right) * 2;
-        height -= (crop_top + crop_bottom) * 2 * (frame_mbs_only_flag ? 1 : 2);
-    }
-
-    // Infer framerate from resolution and interlace mode (common broadcast standards)
-    // Note: VUI timing_info parsing is unreliable due to H.264 emulation prevention bytes
-    // Default to 25fps (PAL standard, common for Indonesian/European content)
-    gint fps_num = 25, fps_den = 1;
-    gboolean fps_inferred = TRUE; // All H.264 framerates are inferred (VUI unreliable)
-
-    if (interlaced) {
-        // Interlaced content: typically 25i (PAL) or 30i (NTSC)
-        fps_num = 25;
-        fps_den = 1;
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+        if (list) output_pool_push_list(output_pool, list);
     } else {
-        // Progressive content: 25fps is a reasonable default for broadcast
-        fps_num = 25;
-        fps_den = 1;
-    }
-
-    pthread_mutex_lock(&video_info.mutex);
-    video_info.width = width;
-    video_info.height = height;
-    video_info.interlaced = interlaced;
-    video_info.fps_num = fps_num;
-    video_info.fps_den = fps_den;
-    video_info.fps_inferred = fps_inferred;
-    video_info.info_valid = TRUE;
-    g_print("MPEG-TS/H.264: Resolution: %dx%d, Interlaced: %s, FPS: ~%d (inferred)\n", width, height,
-            interlaced ? "yes" : "no", fps_num);
-    pthread_mutex_unlock(&video_info.mutex);
-}
-
-// Parse MPEG-2 sequence header for resolution/framerate
-static void parse_mpeg2_sequence(const guint8 *data, gsize size)
-{
-    if (size < 8) return;
-
-    // Sequence header: horizontal_size(12) + vertical_size(12) + aspect_ratio(4) + frame_rate_code(4)
-    gint width = (data[0] << 4) | (data[1] >> 4);
-    gint height = ((data[1] & 0x0F) << 8) | data[2];
-    guint8 frame_rate_code = data[3] & 0x0F;
-
-    // Frame rate lookup table (frame_rate_code)
-    static const gint fps_num_table[] = {0, 24000, 24, 25, 30000, 30, 50, 60000, 60};
-    static const gint fps_den_table[] = {1, 1001, 1, 1, 1001, 1, 1, 1001, 1};
-
-    gint fps_num = (frame_rate_code < 9) ? fps_num_table[frame_rate_code] : 0;
-    gint fps_den = (frame_rate_code < 9) ? fps_den_table[frame_rate_code] : 1;
-
-    pthread_mutex_lock(&video_info.mutex);
-    video_info.width = width;
-    video_info.height = height;
-    video_info.fps_num = fps_num;
-    video_info.fps_den = fps_den;
-    video_info.fps_inferred = FALSE; // MPEG-2 framerate is detected from stream header
-    video_info.info_valid = TRUE;
-    g_print("MPEG-TS/MPEG-2: Resolution: %dx%d, FPS: %d/%d\n", width, height, fps_num, fps_den);
-    pthread_mutex_unlock(&video_info.mutex);
-}
-
-// Parse HEVC (H.265) SPS for resolution/framerate
-static void parse_hevc_sps(const guint8 *data, gsize size)
-{
-    // HEVC NAL unit header is 2 bytes, SPS starts after that
-    if (size < 20) return;
-
-    // Skip NAL unit header (2 bytes) for HEVC
-    BitReader br = {data + 2, size - 2, 0, 0};
-
-    read_bits(&br, 4);                             // sps_video_parameter_set_id
-    guint8 max_sub_layers = read_bits(&br, 3) + 1; // sps_max_sub_layers_minus1 + 1
-    read_bits(&br, 1);                             // sps_temporal_id_nesting_flag
-
-    // Skip profile_tier_level - simplified approach
-    // This is complex in full spec, but we can skip fixed bits for common profiles
-    read_bits(&br, 2);  // general_profile_space
-    read_bits(&br, 1);  // general_tier_flag
-    read_bits(&br, 5);  // general_profile_idc
-    read_bits(&br, 32); // general_profile_compatibility_flags (32 bits)
-    read_bits(&br, 1);  // general_progressive_source_flag
-    read_bits(&br, 1);  // general_interlaced_source_flag
-    read_bits(&br, 1);  // general_non_packed_constraint_flag
-    read_bits(&br, 1);  // general_frame_only_constraint_flag
-    // Skip remaining constraint flags (44 bits)
-    read_bits(&br, 32);
-    read_bits(&br, 12);
-    read_bits(&br, 8); // general_level_idc
-
-    // Skip sub_layer_profile/level for each sub-layer
-    if (max_sub_layers > 1) {
-        for (int i = 0; i < max_sub_layers - 1; i++) {
-            read_bits(&br, 2); // sub_layer_profile/level_present_flag
-        }
-        // Padding if max_sub_layers < 8
-        for (int i = max_sub_layers - 1; i < 8; i++) {
-            read_bits(&br, 2); // reserved
-        }
-    }
-
-    read_ue(&br); // sps_seq_parameter_set_id
-    guint32 chroma_format_idc = read_ue(&br);
-    if (chroma_format_idc == 3) {
-        read_bits(&br, 1); // separate_colour_plane_flag
-    }
-
-    // The key info we need!
-    guint32 pic_width = read_ue(&br);  // pic_width_in_luma_samples
-    guint32 pic_height = read_ue(&br); // pic_height_in_luma_samples
-
-    // Check for conformance_window_flag
-    if (read_bits(&br, 1)) { // conformance_window_flag
-        guint32 left = read_ue(&br);
-        guint32 right = read_ue(&br);
-        guint32 top = read_ue(&br);
-        guint32 bottom = read_ue(&br);
-        // Adjust for cropping (simplified)
-        pic_width -= (left + right) * 2;
-        pic_height -= (top + bottom) * 2;
-    }
-
-    // Infer framerate based on resolution
-    // All HEVC framerates are inferred since we don't parse VUI
-    gint fps_num = 25, fps_den = 1; // Default 25fps for non-4K
-    gboolean fps_inferred = TRUE;
-    if (pic_height >= 2160) {
-        fps_num = 50; // 4K typically 50fps in Europe, 60fps in US
-        fps_den = 1;
+        GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+        if (buffer) output_pool_push(output_pool, buffer);
     }
-
-    pthread_mutex_lock(&video_info.mutex);
-    video_info.width = pic_width;
-    video_info.height = pic_height;
-    video_info.fps_num = fps_num;
-    video_info.fps_den = fps_den;
-    video_info.fps_inferred = fps_inferred;
-    video_info.interlaced = FALSE; // HEVC is progressive by design for UHD
-    video_info.info_valid = TRUE;
-    g_print("MPEG-TS/HEVC: Resolution: %dx%d, FPS: ~%d (inferred)\n", pic_width, pic_height, fps_num);
-    pthread_mutex_unlock(&video_info.mutex);
+    return GST_PAD_PROBE_OK;
 }
 
-// Buffer probe callback to parse MPEG-TS packets
-static GstPadProbeReturn ts_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+// Store every buffer once in the delay ring; the delay thread hands it to each delayed destination
+static GstPadProbeReturn delay_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
 {
     (void)pad;
     (void)user_data;
 
-    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
-    if (!buffer) return GST_PAD_PROBE_OK;
-
-    // Only parse until we have valid video info
-    pthread_mutex_lock(&video_info.mutex);
-    gboolean have_info = video_info.info_valid;
-    pthread_mutex_unlock(&video_info.mutex);
-    if (have_info) return GST_PAD_PROBE_OK;
-
-    GstMapInfo map;
-    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return GST_PAD_PROBE_OK;
-
-    // Process each TS packet in the buffer
-    for (gsize i = 0; i + TS_PACKET_SIZE <= map.size; i += TS_PACKET_SIZE) {
-        const guint8 *pkt = map.data + i;
+    if (!delay_output) return GST_PAD_PROBE_OK;
 
-        if (pkt[0] != TS_SYNC_BYTE) continue;
-
-        guint16 pid = ((pkt[1] & 0x1F) << 8) | pkt[2];
+    if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+        GstBufferList *list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+        if (list) delay_output_push_list(delay_output, list);
+    } else {
+        GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+        if (buffer) delay_output_push(delay_output, buffer);
+    }
+    return GST_PAD_PROBE_OK;
+}
 
-        if (pid == PAT_PID) {
-            parse_pat(pkt, TS_PACKET_SIZE);
-        } else {
-            pthread_mutex_lock(&video_info.mutex);
-            guint16 pmt_pid = video_info.pmt_pid;
-            guint16 video_pid = video_info.video_pid;
-            guint8 video_type = video_info.video_stream_type;
-            pthread_mutex_unlock(&video_info.mutex);
-
-            if (pid == pmt_pid && pmt_pid != 0) {
-                parse_pmt(pkt, TS_PACKET_SIZE);
-            } else if (pid == video_pid && video_pid != 0) {
-                // Look for video start codes in PES payload
-                gsize payload_start = 4;
-                if (pkt[3] & 0x20) payload_start += 1 + pkt[4]; // Skip adaptation field
-
-                if (payload_start + 20 < TS_PACKET_SIZE && (pkt[3] & 0x10)) {
-                    const guint8 *payload = pkt + payload_start;
-                    gsize payload_size = TS_PACKET_SIZE - payload_start;
-
-                    // Search for start codes
-                    for (gsize j = 0; j + 4 < payload_size; j++) {
-                        if (payload[j] == 0 && payload[j + 1] == 0 && payload[j + 2] == 1) {
-                            if (video_type == STREAM_TYPE_H264) {
-                                // H.264 NAL unit type in lower 5 bits
-                                guint8 nal_type = payload[j + 3] & 0x1F;
-                                if (nal_type == 7) { // SPS
-                                    parse_h264_sps(payload + j + 3, payload_size - j - 3);
-                                    break;
-                                }
-                            } else if (video_type == STREAM_TYPE_HEVC) {
-                                // HEVC NAL unit type is in bits 1-6 of first byte after start code
-                                // NAL header is 2 bytes: [F(1) Type(6) LayerId(6) TID(3)]
-                                guint8 nal_type = (payload[j + 3] >> 1) & 0x3F;
-                                if (nal_type == 33) { // SPS (NAL_UNIT_SPS = 33)
-                                    parse_hevc_sps(payload + j + 3, payload_size - j - 3);
-                                    break;
-                                }
-                            } else if (video_type == STREAM_TYPE_MPEG2_VIDEO) {
-                                if (payload[j + 3] == 0xB3) { // Sequence header
-                                    parse_mpeg2_sequence(payload + j + 4, payload_size - j - 4);
-                                    break;
-                                }
-                            }
-                        }
-                    }
-                }
+// The longest "delay" of the route's destinations, 0 if none has one, -1 if one is invalid
+static gint64 max_sink_delay_us(cJSON *sinks_array)
+{
+    gint64 max_delay_us = 0;
+    cJSON *sink;
+    int sink_idx = 0;
+    cJSON_ArrayForEach(sink, sinks_array)
+    {
+        cJSON *delay = cJSON_GetObjectItem(sink, "delay");
+        if (delay) {
+            gint64 delay_us = delay_ring_parse_delay(delay);
+            if (delay_us < 0) {
+                g_printerr("Invalid 'delay' config for sink %d\n", sink_idx);
+                return -1;
+            }
+            if (cJSON_IsTrue(cJSON_GetObjectItem(sink, "proxy"))) {
+                g_printerr("Sink %d: 'delay' is not supported on proxy destinations\n", sink_idx);
+                return -1;
             }
+            max_delay_us = MAX(max_delay_us, delay_us);
         }
+        sink_idx++;
     }
-
-    gst_buffer_unmap(buffer, &map);
-    return GST_PAD_PROBE_OK;
+    return max_delay_us;
 }
 
 // =============================================================================
-// Thumbnail Capture Branch
+// Shared Decode Tier: thumbnail, video health and proxy on one decode
 // =============================================================================
 
-static void on_thumbnail_pad_added(GstElement *decodebin, GstPad *pad, gpointer data)
+static void on_decode_pad_added(GstElement *decodebin, GstPad *pad, gpointer data)
 {
     (void)decodebin;
     GstElement *videoconvert = (GstElement *)data;
@@ -922,14 +1464,51 @@ static void on_thumbnail_pad_added(GstElement *decodebin, GstPad *pad, gpointer
     if (!gst_pad_is_linked(sink_pad)) {
         GstPadLinkReturn ret = gst_pad_link(pad, sink_pad);
         if (ret == GST_PAD_LINK_OK) {
-            g_print("Thumbnail: Linked video pad to videoconvert\n");
+            g_print("Decode: Linked video pad to videoconvert\n");
         } else {
-            g_printerr("Thumbnail: Failed to link video pad: %d\n", ret);
+            g_printerr("Decode: Failed to link video pad: %d\n", ret);
         }
     }
     gst_object_unref(sink_pad);
 }
 
+static GstPadProbeReturn decode_frame_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    (void)pad;
+    (void)info;
+    (void)user_data;
+    __atomic_add_fetch(&decode_frames, 1, __ATOMIC_RELAXED);
+    return GST_PAD_PROBE_OK;
+}
+
+static void save_thumbnail(const char *path, const char *tmp_path, const guint8 *data, gsize size,
+                           gint64 pull_start_us)
+{
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) return;
+    fwrite(data, 1, size, f);
+    fclose(f);
+    rename(tmp_path, path); // Atomic replace
+    g_print("Thumbnail: Saved %zu bytes\n", size);
+    BG_TRACE2(thumbnail, size, g_get_monotonic_time() - pull_start_us);
+}
+
+// Every encoded frame goes to the preview viewers; the thumbnail worker reads the newest from there
+static GstFlowReturn on_preview_sample(GstAppSink *appsink, gpointer user_data)
+{
+    (void)user_data;
+    GstSample *sample = gst_app_sink_pull_sample(appsink);
+    if (!sample) return GST_FLOW_OK;
+    GstBuffer *buffer = gst_sample_get_buffer(sample);
+    GstMapInfo map;
+    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        preview_server_publish(preview_server, map.data, map.size);
+        gst_buffer_unmap(buffer, &map);
+    }
+    gst_sample_unref(sample);
+    return GST_FLOW_OK;
+}
+
 static void *thumbnail_worker(void *arg)
 {
     char *route_id = (char *)arg;
@@ -940,6 +1519,8 @@ static void *thumbnail_worker(void *arg)
 
     g_print("Thumbnail: Worker started, saving to %s\n", path);
 
+    thread_policy_apply_self(THREAD_ROLE_ANALYSIS, "thumbnail");
+
     // Give the pipeline a moment to reach PLAYING state
     sleep(3);
 
@@ -949,26 +1530,32 @@ static void *thumbnail_worker(void *arg)
             continue;
         }
 
-        GstSample *sample = gst_app_sink_try_pull_sample(
-            GST_APP_SINK(thumbnail_appsink),
-            GST_SECOND // 1 second timeout
-        );
-
-        if (sample) {
-            GstBuffer *buffer = gst_sample_get_buffer(sample);
-            GstMapInfo map;
-
-            if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
-                FILE *f = fopen(tmp_path, "wb");
-                if (f) {
-                    fwrite(map.data, 1, map.size, f);
-                    fclose(f);
-                    rename(tmp_path, path); // Atomic replace
-                    g_print("Thumbnail: Saved %zu bytes\n", map.size);
+        gint64 pull_start_us = g_get_monotonic_time();
+        if (preview_server) {
+            // The preview already holds the newest frame
+            GBytes *jpeg = preview_server_latest(preview_server);
+            if (jpeg) {
+                gsize size = 0;
+                const guint8 *data = g_bytes_get_data(jpeg, &size);
+                save_thumbnail(path, tmp_path, data, size, pull_start_us);
+                g_bytes_unref(jpeg);
+            }
+        } else {
+            GstSample *sample = gst_app_sink_try_pull_sample(
+                GST_APP_SINK(thumbnail_appsink),
+                GST_SECOND // 1 second timeout
+            );
+
+            if (sample) {
+                GstBuffer *buffer = gst_sample_get_buffer(sample);
+                GstMapInfo map;
+
+                if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+                    save_thumbnail(path, tmp_path, map.data, map.size, pull_start_us);
+                    gst_buffer_unmap(buffer, &map);
                 }
-                gst_buffer_unmap(buffer, &map);
+                gst_sample_unref(sample);
             }
-            gst_sample_unref(sample);
         }
 
         // Sleep 5 seconds in 100ms chunks for responsive shutdown
@@ -982,48 +1569,86 @@ static void *thumbnail_worker(void *arg)
     remove(tmp_path);
     free(route_id);
     g_print("Thumbnail: Worker stopped\n");
+    thread_policy_forget_self();
     return NULL;
 }
 
-static void add_thumbnail_branch(GstElement *pipeline, GstElement *tee, const char *route_id)
+// Runs on the thumbnail branch thread for every scaled frame; the Y plane of I420 comes first with
+// rows padded to 4 bytes
+static GstPadProbeReturn video_health_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    (void)pad;
+    (void)user_data;
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    const guint stride = (THUMBNAIL_WIDTH + 3) & ~3u;
+    GstMapInfo map;
+    if (gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        if (map.size >= (gsize)stride * THUMBNAIL_HEIGHT) {
+            video_health_frame(video_health, map.data, THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, stride,
+                               g_get_monotonic_time());
+        }
+        gst_buffer_unmap(buffer, &map);
+    }
+    return GST_PAD_PROBE_OK;
+}
+
+// A leaky queue per consumer of the raw tee: each gets its own thread, and a slow consumer drops frames
+// instead of holding back the decoder and the other consumers
+static GstElement *add_raw_queue(GstElement *pipeline, GstElement *raw_tee, const char *name, guint max_buffers)
+{
+    GstElement *queue = gst_element_factory_make("queue", name);
+    if (!queue) return NULL;
+    g_object_set(queue,
+        "max-size-buffers", max_buffers,
+        "max-size-bytes",   0,
+        "max-size-time",    (guint64)0,
+        "leaky",            2,  // GST_QUEUE_LEAK_UPSTREAM
+        NULL);
+    gst_bin_add(GST_BIN(pipeline), queue);
+    if (!gst_element_link(raw_tee, queue)) {
+        g_printerr("Decode: Failed to link decode tee → %s\n", name);
+        return NULL;
+    }
+    return queue;
+}
+
+static void add_thumbnail_branch(GstElement *pipeline, GstElement *raw_tee, const char *route_id)
 {
-    GstElement *queue       = gst_element_factory_make("queue",         "thumbnail_queue");
-    GstElement *decodebin   = gst_element_factory_make("decodebin",     "thumbnail_decodebin");
-    GstElement *convert     = gst_element_factory_make("videoconvert",  "thumbnail_convert");
     GstElement *scale       = gst_element_factory_make("videoscale",    "thumbnail_scale");
     GstElement *capsfilter  = gst_element_factory_make("capsfilter",    "thumbnail_capsfilter");
+    GstElement *rate        = gst_element_factory_make("videorate",     "thumbnail_rate");
     GstElement *jpegenc     = gst_element_factory_make("jpegenc",       "thumbnail_jpegenc");
     GstElement *appsink     = gst_element_factory_make("appsink",       "thumbnail_appsink");
 
-    if (!queue || !decodebin || !convert || !scale || !capsfilter || !jpegenc || !appsink) {
+    if (!scale || !capsfilter || !rate || !jpegenc || !appsink) {
         g_printerr("Thumbnail: One or more elements unavailable — skipping thumbnail branch\n");
-        if (queue)      gst_object_unref(queue);
-        if (decodebin)  gst_object_unref(decodebin);
-        if (convert)    gst_object_unref(convert);
         if (scale)      gst_object_unref(scale);
         if (capsfilter) gst_object_unref(capsfilter);
+        if (rate)       gst_object_unref(rate);
         if (jpegenc)    gst_object_unref(jpegenc);
         if (appsink)    gst_object_unref(appsink);
         return;
     }
 
-    // Leaky upstream queue: drops old buffers so thumbnail never blocks main stream
-    g_object_set(queue,
-        "max-size-buffers", 10,
-        "max-size-bytes",   0,
-        "max-size-time",    (guint64)0,
-        "leaky",            2,  // GST_QUEUE_LEAK_UPSTREAM
-        NULL);
-
-    // Scale target: 320x180
+    // Scale target: 320x180 I420, so the luma plane is at a known place for the video health probe
     GstCaps *caps = gst_caps_new_simple("video/x-raw",
-        "width",  G_TYPE_INT, 320,
-        "height", G_TYPE_INT, 180,
+        "format", G_TYPE_STRING, "I420",
+        "width",  G_TYPE_INT, THUMBNAIL_WIDTH,
+        "height", G_TYPE_INT, THUMBNAIL_HEIGHT,
         NULL);
     g_object_set(capsfilter, "caps", caps, NULL);
     gst_caps_unref(caps);
 
-    g_object_set(jpegenc, "quality", 75, NULL);
+    if (video_health) {
+        GstPad *health_pad = gst_element_get_static_pad(capsfilter, "src");
+        gst_pad_add_probe(health_pad, GST_PAD_PROBE_TYPE_BUFFER, video_health_probe_callback, NULL, NULL);
+        gst_object_unref(health_pad);
+    }
+
+    // Video health sees every frame; only the preview rate (one a second for the thumbnail alone) is encoded
+    g_object_set(rate, "drop-only", TRUE, "max-rate", preview_server ? (gint)preview_server_fps(preview_server) : 1,
+                 NULL);
+    g_object_set(jpegenc, "quality", preview_server ? preview_server_quality(preview_server) : 75, NULL);
 
     g_object_set(appsink,
         "emit-signals", FALSE,
@@ -1031,17 +1656,15 @@ static void add_thumbnail_branch(GstElement *pipeline, GstElement *tee, const ch
         "drop",         TRUE,
         "sync",         FALSE,
         NULL);
-
-    gst_bin_add_many(GST_BIN(pipeline), queue, decodebin, convert, scale, capsfilter, jpegenc, appsink, NULL);
-
-    g_signal_connect(decodebin, "pad-added", G_CALLBACK(on_thumbnail_pad_added), convert);
-
-    if (!gst_element_link(tee, queue) || !gst_element_link(queue, decodebin)) {
-        g_printerr("Thumbnail: Failed to link tee → queue → decodebin\n");
-        return;
+    if (preview_server) {
+        GstAppSinkCallbacks callbacks = {.new_sample = on_preview_sample};
+        gst_app_sink_set_callbacks(GST_APP_SINK(appsink), &callbacks, NULL, NULL);
     }
 
-    if (!gst_element_link_many(convert, scale, capsfilter, jpegenc, appsink, NULL)) {
+    gst_bin_add_many(GST_BIN(pipeline), scale, capsfilter, rate, jpegenc, appsink, NULL);
+
+    GstElement *queue = add_raw_queue(pipeline, raw_tee, "thumbnail_queue", 2);
+    if (!queue || !gst_element_link_many(queue, scale, capsfilter, rate, jpegenc, appsink, NULL)) {
         g_printerr("Thumbnail: Failed to link video chain\n");
         return;
     }
@@ -1060,6 +1683,403 @@ static void add_thumbnail_branch(GstElement *pipeline, GstElement *tee, const ch
     }
 }
 
+// "proxy": {"width": 640, "height": 360, "bitrate": 500, "key-interval": 50}: bitrate in kbit/s, key-interval
+// in frames. Even sizes only, for I420.
+static gboolean parse_proxy_config(cJSON *config, gint *key_interval)
+{
+    if (!cJSON_IsObject(config)) return FALSE;
+    cJSON *width = cJSON_GetObjectItem(config, "width");
+    cJSON *height = cJSON_GetObjectItem(config, "height");
+    cJSON *bitrate = cJSON_GetObjectItem(config, "bitrate");
+    cJSON *key = cJSON_GetObjectItem(config, "key-interval");
+
+    proxy_width = cJSON_IsNumber(width) ? width->valueint : 640;
+    proxy_height = cJSON_IsNumber(height) ? height->valueint : 360;
+    proxy_bitrate_kbps = cJSON_IsNumber(bitrate) ? bitrate->valueint : 500;
+    *key_interval = cJSON_IsNumber(key) ? key->valueint : 50;
+
+    if ((width && !cJSON_IsNumber(width)) || (height && !cJSON_IsNumber(height)) ||
+        (bitrate && !cJSON_IsNumber(bitrate)) || (key && !cJSON_IsNumber(key))) {
+        return FALSE;
+    }
+    return proxy_width >= 64 && proxy_width <= 1920 && proxy_width % 2 == 0 && proxy_height >= 36 &&
+           proxy_height <= 1080 && proxy_height % 2 == 0 && proxy_bitrate_kbps >= 64 && proxy_bitrate_kbps <= 20000 &&
+           *key_interval >= 1 && *key_interval <= 600;
+}
+
+// Scaled and encoded to H.264 in MPEG-TS, into proxy_tee for the "proxy" destinations. Realtime settings
+// and a single encoder thread: the proxy is for monitoring and must not take cores from the route.
+static gboolean add_proxy_branch(GstElement *pipeline, GstElement *raw_tee, cJSON *proxy_config)
+{
+    gint key_interval = 0;
+    if (!parse_proxy_config(proxy_config, &key_interval)) {
+        g_printerr("Invalid 'proxy' config in 'decode'\n");
+        return FALSE;
+    }
+
+    GstElement *scale       = gst_element_factory_make("videoscale",    "proxy_scale");
+    GstElement *capsfilter  = gst_element_factory_make("capsfilter",    "proxy_capsfilter");
+    GstElement *encoder     = gst_element_factory_make("x264enc",       "proxy_x264enc");
+    GstElement *parse       = gst_element_factory_make("h264parse",     "proxy_h264parse");
+    GstElement *mux         = gst_element_factory_make("mpegtsmux",     "proxy_mux");
+    GstElement *tee         = gst_element_factory_make("tee",           "proxy_tee");
+
+    if (!scale || !capsfilter || !encoder || !parse || !mux || !tee) {
+        g_printerr("Proxy: One or more elements unavailable (x264enc, h264parse, mpegtsmux)\n");
+        if (scale)      gst_object_unref(scale);
+        if (capsfilter) gst_object_unref(capsfilter);
+        if (encoder)    gst_object_unref(encoder);
+        if (parse)      gst_object_unref(parse);
+        if (mux)        gst_object_unref(mux);
+        if (tee)        gst_object_unref(tee);
+        return FALSE;
+    }
+
+    GstCaps *caps = gst_caps_new_simple("video/x-raw",
+        "format",             G_TYPE_STRING,     "I420",
+        "width",              G_TYPE_INT,        proxy_width,
+        "height",             G_TYPE_INT,        proxy_height,
+        "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+        NULL);
+    g_object_set(capsfilter, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    g_object_set(encoder,
+        "bitrate",      (guint)proxy_bitrate_kbps,
+        "key-int-max",  (guint)key_interval,
+        "threads",      1u,
+        NULL);
+    gst_util_set_object_arg(G_OBJECT(encoder), "speed-preset", "ultrafast");
+    gst_util_set_object_arg(G_OBJECT(encoder), "tune", "zerolatency");
+    g_object_set(parse, "config-interval", -1, NULL); // SPS/PPS with every key frame, so viewers join fast
+    g_object_set(mux, "alignment", 7, NULL);           // Seven TS packets per buffer, one UDP datagram
+    g_object_set(tee, "allow-not-linked", TRUE, NULL);
+
+    gst_bin_add_many(GST_BIN(pipeline), scale, capsfilter, encoder, parse, mux, tee, NULL);
+
+    GstElement *queue = add_raw_queue(pipeline, raw_tee, "proxy_queue", 5);
+    if (!queue || !gst_element_link_many(queue, scale, capsfilter, encoder, parse, mux, tee, NULL)) {
+        g_printerr("Proxy: Failed to link encoder chain\n");
+        return FALSE;
+    }
+
+    proxy_tee = tee;
+    proxy_queue = queue;
+    QueueLevel limit = {0, 5, 0};
+    queue_telemetry_init(&proxy_queue_telemetry, &limit, g_get_monotonic_time());
+    g_signal_connect(queue, "overrun", G_CALLBACK(on_decode_queue_overrun), &proxy_queue_telemetry);
+    g_print("Proxy: %dx%d at %d kbit/s\n", proxy_width, proxy_height, proxy_bitrate_kbps);
+    return TRUE;
+}
+
+// tee → leaky queue → decodebin → videoconvert → raw tee, then one leaky queue per consumer. Built when the
+// route has a thumbnail (a route ID) or a proxy; FALSE only when a configured proxy cannot be built.
+static gboolean add_decode_tier(GstElement *pipeline, GstElement *tee, cJSON *decode_config, const char *route_id)
+{
+    cJSON *proxy_config = cJSON_GetObjectItem(decode_config, "proxy");
+    gboolean thumbnail = route_id && route_id[0] != '\0';
+    if (!thumbnail && !proxy_config) return TRUE;
+
+    GstElement *queue       = gst_element_factory_make("queue",         "decode_queue");
+    GstElement *decodebin   = gst_element_factory_make("decodebin",     "decode_decodebin");
+    GstElement *convert     = gst_element_factory_make("videoconvert",  "decode_convert");
+    GstElement *raw_tee     = gst_element_factory_make("tee",           "decode_tee");
+
+    if (!queue || !decodebin || !convert || !raw_tee) {
+        g_printerr("Decode: One or more elements unavailable — skipping decode tier\n");
+        if (queue)      gst_object_unref(queue);
+        if (decodebin)  gst_object_unref(decodebin);
+        if (convert)    gst_object_unref(convert);
+        if (raw_tee)    gst_object_unref(raw_tee);
+        return !proxy_config;
+    }
+
+    // Leaky upstream queue: drops old buffers so decoding never blocks the main stream
+    g_object_set(queue,
+        "max-size-buffers", 10,
+        "max-size-bytes",   0,
+        "max-size-time",    (guint64)0,
+        "leaky",            2,  // GST_QUEUE_LEAK_UPSTREAM
+        NULL);
+    g_object_set(raw_tee, "allow-not-linked", TRUE, NULL);
+
+    gst_bin_add_many(GST_BIN(pipeline), queue, decodebin, convert, raw_tee, NULL);
+
+    g_signal_connect(decodebin, "pad-added", G_CALLBACK(on_decode_pad_added), convert);
+
+    if (!gst_element_link(tee, queue) || !gst_element_link(queue, decodebin) ||
+        !gst_element_link(convert, raw_tee)) {
+        g_printerr("Decode: Failed to link tee → queue → decodebin\n");
+        return !proxy_config;
+    }
+
+    GstPad *frame_pad = gst_element_get_static_pad(raw_tee, "sink");
+    gst_pad_add_probe(frame_pad, GST_PAD_PROBE_TYPE_BUFFER, decode_frame_probe_callback, NULL, NULL);
+    gst_object_unref(frame_pad);
+
+    decode_queue = queue;
+    __atomic_store_n(&decode_frames, 0, __ATOMIC_RELAXED);
+    QueueLevel limit = {0, 10, 0};
+    queue_telemetry_init(&decode_queue_telemetry, &limit, g_get_monotonic_time());
+    g_signal_connect(queue, "overrun", G_CALLBACK(on_decode_queue_overrun), &decode_queue_telemetry);
+
+    if (proxy_config && !add_proxy_branch(pipeline, raw_tee, proxy_config)) return FALSE;
+    if (thumbnail) add_thumbnail_branch(pipeline, raw_tee, route_id);
+    return TRUE;
+}
+
+// =============================================================================
+// Audio Metering Branch
+// =============================================================================
+
+static void audio_stream_free(gpointer data)
+{
+    AudioStream *stream = data;
+    audio_meter_free(stream->meter);
+    g_free(stream->codec);
+    g_free(stream);
+}
+
+static const char *audio_codec_name(const GstStructure *s)
+{
+    const gchar *name = gst_structure_get_name(s);
+    gint version = 0;
+    if (g_strcmp0(name, "audio/mpeg") == 0 && gst_structure_get_int(s, "mpegversion", &version)) {
+        return version == 1 ? "mpeg-audio" : "aac";
+    }
+    if (g_strcmp0(name, "audio/x-ac3") == 0) return "ac3";
+    if (g_strcmp0(name, "audio/x-eac3") == 0) return "eac3";
+    return name + strlen("audio/");
+}
+
+// Runs on the branch thread for every decoded buffer; new caps (re)start the stream's meter
+static GstPadProbeReturn audio_probe_callback(GstPad *pad, GstPadProbeInfo *info, gpointer user_data)
+{
+    (void)pad;
+    AudioStream *stream = user_data;
+
+    if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+        GstEvent *event = GST_PAD_PROBE_INFO_EVENT(info);
+        if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+            GstCaps *caps = NULL;
+            gst_event_parse_caps(event, &caps);
+            GstStructure *s = gst_caps_get_structure(caps, 0);
+            gint rate = 0, channels = 0;
+            gst_structure_get_int(s, "rate", &rate);
+            gst_structure_get_int(s, "channels", &channels);
+
+            g_mutex_lock(&audio_lock);
+            stream->rate = (guint)MAX(rate, 0);
+            stream->channels = (guint)MAX(channels, 0);
+            audio_meter_free(stream->meter);
+            stream->meter = NULL;
+            g_mutex_unlock(&audio_lock);
+        }
+        return GST_PAD_PROBE_OK;
+    }
+
+    GstBuffer *buffer = GST_PAD_PROBE_INFO_BUFFER(info);
+    GstMapInfo map;
+    g_mutex_lock(&audio_lock);
+    if (!stream->meter && stream->channels) {
+        stream->meter = audio_meter_new(stream->rate, stream->channels);
+        if (!stream->meter) stream->channels = 0; // Unsupported layout; stop trying until the caps change
+    }
+    if (stream->meter && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+        audio_meter_process(stream->meter, (const gfloat *)map.data, map.size / (sizeof(gfloat) * stream->channels));
+        gst_buffer_unmap(buffer, &map);
+    }
+    g_mutex_unlock(&audio_lock);
+    return GST_PAD_PROBE_OK;
+}
+
+static void on_audio_decoded_pad_added(GstElement *decodebin, GstPad *pad, gpointer data)
+{
+    (void)decodebin;
+    GstElement *convert = data;
+    GstPad *sink_pad = gst_element_get_static_pad(convert, "sink");
+    if (!gst_pad_is_linked(sink_pad) && gst_pad_link(pad, sink_pad) != GST_PAD_LINK_OK) {
+        g_printerr("AudioMeter: Failed to link decoded audio\n");
+    }
+    gst_object_unref(sink_pad);
+}
+
+// tsdemux exposes one pad per elementary stream the PMT announces. Audio pads get a decoder and a
+// meter; video and data pads stay unlinked, so nothing but the audio is ever decoded.
+static void on_audio_demux_pad_added(GstElement *demux, GstPad *pad, gpointer data)
+{
+    (void)demux;
+    GstElement *pipeline = data;
+
+    GstCaps *caps = gst_pad_get_current_caps(pad);
+    if (!caps) caps = gst_pad_query_caps(pad, NULL);
+    if (!caps) return;
+    const GstStructure *s = gst_caps_get_structure(caps, 0);
+    if (!g_str_has_prefix(gst_structure_get_name(s), "audio/")) {
+        gst_caps_unref(caps);
+        return;
+    }
+
+    AudioStream *stream = g_new0(AudioStream, 1);
+    stream->codec = g_strdup(audio_codec_name(s));
+    gst_caps_unref(caps);
+    // Pads are named audio_<program>_<pid> with the PID in hex
+    const gchar *pid_str = strrchr(GST_PAD_NAME(pad), '_');
+    if (pid_str) stream->pid = (guint16)g_ascii_strtoull(pid_str + 1, NULL, 16);
+
+    GstElement *decodebin = gst_element_factory_make("decodebin", NULL);
+    GstElement *convert = gst_element_factory_make("audioconvert", NULL);
+    GstElement *capsfilter = gst_element_factory_make("capsfilter", NULL);
+    GstElement *fakesink = gst_element_factory_make("fakesink", NULL);
+    if (!decodebin || !convert || !capsfilter || !fakesink) {
+        g_printerr("AudioMeter: One or more elements unavailable — not metering PID %u\n", stream->pid);
+        if (decodebin) gst_object_unref(decodebin);
+        if (convert) gst_object_unref(convert);
+        if (capsfilter) gst_object_unref(capsfilter);
+        if (fakesink) gst_object_unref(fakesink);
+        audio_stream_free(stream);
+        return;
+    }
+
+    GstCaps *float_caps = gst_caps_from_string("audio/x-raw,format=F32LE,layout=interleaved");
+    g_object_set(capsfilter, "caps", float_caps, NULL);
+    gst_caps_unref(float_caps);
+    g_object_set(fakesink, "sync", FALSE, "async", FALSE, NULL);
+
+    gst_bin_add_many(GST_BIN(pipeline), decodebin, convert, capsfilter, fakesink, NULL);
+    if (!gst_element_link_many(convert, capsfilter, fakesink, NULL)) {
+        g_printerr("AudioMeter: Failed to link audio chain for PID %u\n", stream->pid);
+        audio_stream_free(stream);
+        return;
+    }
+    g_signal_connect(decodebin, "pad-added", G_CALLBACK(on_audio_decoded_pad_added), convert);
+
+    GstPad *meter_pad = gst_element_get_static_pad(fakesink, "sink");
+    gst_pad_add_probe(meter_pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM,
+                      audio_probe_callback, stream, NULL);
+    gst_object_unref(meter_pad);
+
+    gst_element_sync_state_with_parent(fakesink);
+    gst_element_sync_state_with_parent(capsfilter);
+    gst_element_sync_state_with_parent(convert);
+    gst_element_sync_state_with_parent(decodebin);
+
+    GstPad *decode_pad = gst_element_get_static_pad(decodebin, "sink");
+    if (gst_pad_link(pad, decode_pad) != GST_PAD_LINK_OK) {
+        g_printerr("AudioMeter: Failed to link PID %u to its decoder\n", stream->pid);
+    }
+    gst_object_unref(decode_pad);
+
+    g_mutex_lock(&audio_lock);
+    g_ptr_array_add(audio_streams, stream);
+    g_mutex_unlock(&audio_lock);
+    g_print("AudioMeter: Metering %s audio on PID %u\n", stream->codec, stream->pid);
+}
+
+static void add_audio_meter_branch(GstElement *pipeline, GstElement *tee, gboolean enabled)
+{
+    GstElement *queue      = gst_element_factory_make("queue",      "audio_meter_queue");
+    GstElement *valve      = gst_element_factory_make("valve",      "audio_meter_valve");
+    GstElement *capsfilter = gst_element_factory_make("capsfilter", "audio_meter_capsfilter");
+    GstElement *demux      = gst_element_factory_make("tsdemux",    "audio_meter_demux");
+
+    if (!queue || !valve || !capsfilter || !demux) {
+        g_printerr("AudioMeter: One or more elements unavailable — skipping audio metering branch\n");
+        if (queue)      gst_object_unref(queue);
+        if (valve)      gst_object_unref(valve);
+        if (capsfilter) gst_object_unref(capsfilter);
+        if (demux)      gst_object_unref(demux);
+        return;
+    }
+
+    // Leaky like the decode queue: a slow decoder costs meter accuracy, never the main stream
+    g_object_set(queue,
+        "max-size-buffers", 200,
+        "max-size-bytes",   0,
+        "max-size-time",    (guint64)0,
+        "leaky",            2,
+        NULL);
+    g_object_set(valve, "drop", !enabled, NULL);
+
+    // The source has no caps of its own; tsdemux needs to be told it gets a transport stream
+    GstCaps *caps = gst_caps_from_string("video/mpegts,systemstream=(boolean)true");
+    g_object_set(capsfilter, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    gst_bin_add_many(GST_BIN(pipeline), queue, valve, capsfilter, demux, NULL);
+    if (!gst_element_link_many(tee, queue, valve, capsfilter, demux, NULL)) {
+        g_printerr("AudioMeter: Failed to link tee → queue → valve → tsdemux\n");
+        return;
+    }
+    g_signal_connect(demux, "pad-added", G_CALLBACK(on_audio_demux_pad_added), pipeline);
+
+    audio_streams = g_ptr_array_new_with_free_func(audio_stream_free);
+    audio_queue = queue;
+    audio_valve = valve;
+    g_print("AudioMeter: Branch ready (%s)\n", enabled ? "enabled" : "disabled");
+}
+
+// Stopping drops the meters so a re-enabled branch starts its windows from fresh audio
+static void audio_branch_set_enabled(gboolean enabled)
+{
+    g_object_set(audio_valve, "drop", !enabled, NULL);
+    if (enabled) return;
+
+    g_mutex_lock(&audio_lock);
+    for (guint i = 0; i < audio_streams->len; i++) {
+        AudioStream *stream = g_ptr_array_index(audio_streams, i);
+        audio_meter_free(stream->meter);
+        stream->meter = NULL;
+    }
+    g_mutex_unlock(&audio_lock);
+}
+
+// Share of one core the branch thread used since the previous report
+static gdouble audio_branch_cpu_percent(void)
+{
+    clockid_t clock;
+    struct timespec ts;
+    if (!__atomic_load_n(&audio_thread_known, __ATOMIC_ACQUIRE)) return 0.0;
+    if (pthread_getcpuclockid(audio_thread, &clock) != 0 || clock_gettime(clock, &ts) != 0) return 0.0;
+
+    gint64 cpu_ns = (gint64)ts.tv_sec * 1000000000 + ts.tv_nsec;
+    gint64 wall_us = g_get_monotonic_time();
+    gdouble percent = 0.0;
+    if (audio_wall_last_us && wall_us > audio_wall_last_us) {
+        percent = 100.0 * (gdouble)(cpu_ns - audio_cpu_last_ns) / ((gdouble)(wall_us - audio_wall_last_us) * 1000.0);
+    }
+    audio_cpu_last_ns = cpu_ns;
+    audio_wall_last_us = wall_us;
+    return percent;
+}
+
+static void audio_branch_add_stats(cJSON *root)
+{
+    gboolean drop = FALSE;
+    g_object_get(audio_valve, "drop", &drop, NULL);
+
+    cJSON *audio = cJSON_AddObjectToObject(root, "audio-meter");
+    cJSON_AddBoolToObject(audio, "enabled", !drop);
+    cJSON_AddNumberToObject(audio, "cpu-percent", audio_branch_cpu_percent());
+    cJSON_AddStringToObject(audio, "simd", audio_meter_simd_name());
+    cJSON *streams = cJSON_AddArrayToObject(audio, "streams");
+
+    g_mutex_lock(&audio_lock);
+    for (guint i = 0; i < audio_streams->len; i++) {
+        AudioStream *stream = g_ptr_array_index(audio_streams, i);
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddNumberToObject(entry, "pid", stream->pid);
+        cJSON_AddStringToObject(entry, "codec", stream->codec);
+        if (stream->meter) {
+            AudioMeterStats stats;
+            audio_meter_get_stats(stream->meter, &stats);
+            audio_meter_stats_to_json(&stats, entry);
+        }
+        cJSON_AddItemToArray(streams, entry);
+    }
+    g_mutex_unlock(&audio_lock);
+}
+
 // =============================================================================
 // Pipeline Creation
 // =============================================================================
@@ -1082,8 +2102,66 @@ GstElement *create_pipeline(cJSON *json, const char *route_id)
         return NULL;
     }
 
+    // Optional CPU placement and scheduling policy for the route's threads
+    thread_policy_reset();
+    if (!thread_policy_configure(cJSON_GetObjectItem(json, "threads"))) {
+        return NULL;
+    }
+
+    // Optional admission control for callers of an srtsrc source; counted in the stats even without a config
+    admission_free(source_admission);
+    source_admission = NULL;
+    if (!caller_stream_ids) caller_stream_ids = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, g_free);
+    g_hash_table_remove_all(caller_stream_ids);
+    source_callers = 0;
+    source_lost = FALSE;
+    if (g_strcmp0(source_type->valuestring, "srtsrc") == 0) {
+        source_admission = admission_new(cJSON_GetObjectItem(json, "admission"));
+        if (!source_admission) return NULL;
+    }
+
+    // Optional input stall watchdog: "watchdog": {"stall-ms": 500, "restart": true}
+    input_watchdog_free(source_watchdog);
+    source_watchdog = NULL;
+    cJSON *watchdog_obj = cJSON_GetObjectItem(json, "watchdog");
+    if (watchdog_obj && !cJSON_IsFalse(watchdog_obj)) {
+        source_watchdog = input_watchdog_new(watchdog_obj);
+        if (!source_watchdog) return NULL;
+    }
+
+    // Black/frozen picture detection on the thumbnail frames, on unless "video-health": false;
+    // {"black-luma": 32, "black-max-stddev": 8, "freeze-max-diff": 0.5, "min-duration-ms": 2000}
+    video_health_free(video_health);
+    video_health = NULL;
+    cJSON *health_obj = cJSON_GetObjectItem(json, "video-health");
+    if (!cJSON_IsFalse(health_obj)) {
+        video_health = video_health_new(health_obj);
+        if (!video_health) return NULL;
+    }
+
+    // Continuous MJPEG preview of the thumbnail frames on /tmp/blackgate_preview_<route>.sock, on unless
+    // "preview": false; {"fps": 5, "quality": 70, "max-viewers": 16}
+    preview_server_free(preview_server);
+    preview_server = NULL;
+    cJSON *preview_obj = cJSON_GetObjectItem(json, "preview");
+    if (!cJSON_IsFalse(preview_obj) && !cJSON_IsFalse(cJSON_GetObjectItem(json, "decode")) && route_id &&
+        route_id[0] != '\0') {
+        char preview_path[108];
+        snprintf(preview_path, sizeof(preview_path), "/tmp/blackgate_preview_%s.sock", route_id);
+        preview_server = preview_server_new(preview_obj, preview_path);
+        if (!preview_server) return NULL;
+    }
+
+    // "sharedsrt" routes take their callers from the shared SRT listener through an appsrc
+    gboolean shared_listener = g_strcmp0(source_type->valuestring, "sharedsrt") == 0;
+    // "srtgroup" sources receive over a bonded SRT connection (see srt_group.h), also through an appsrc
+    gboolean bonded_source = g_strcmp0(source_type->valuestring, "srtgroup") == 0;
+    // "udpts" sources read UDP/RTP in batches on their own thread (see udp_source.h), also through an appsrc
+    gboolean udp_ingest = g_strcmp0(source_type->valuestring, "udpts") == 0;
+    gboolean appsrc_source = shared_listener || bonded_source || udp_ingest;
+
     pipeline = gst_pipeline_new("test-pipeline");
-    source = gst_element_factory_make(source_type->valuestring, "source");
+    source = gst_element_factory_make(appsrc_source ? "appsrc" : source_type->valuestring, "source");
     tee = gst_element_factory_make("tee", "tee");
 
     if (!pipeline || !source || !tee) {
@@ -1096,7 +2174,9 @@ GstElement *create_pipeline(cJSON *json, const char *route_id)
 
     g_print("Created source element: %s (type: %s)\n", GST_ELEMENT_NAME(source), G_OBJECT_TYPE_NAME(source));
 
-    set_element_properties(source, source_obj, source_type->valuestring, "type");
+    if (!appsrc_source) {
+        set_element_properties(source, source_obj, source_type->valuestring, "type");
+    }
 
     // Use do-timestamp=FALSE for pure MPEG-TS passthrough
     // Regenerating timestamps corrupts PES packet structure causing artifacts
@@ -1104,78 +2184,304 @@ GstElement *create_pipeline(cJSON *json, const char *route_id)
     g_print("Set do-timestamp=FALSE for source element (pure passthrough)\n");
 
     if (g_strcmp0(source_type->valuestring, "srtsrc") == 0) {
-        // Signal for logging incoming connections
+        // Incoming connections are logged and admitted here; added/removed keep the max-callers count
         g_signal_connect(source, "caller-connecting", G_CALLBACK(on_caller_connecting), NULL);
+        g_signal_connect(source, "caller-added", G_CALLBACK(on_caller_added), NULL);
+        g_signal_connect(source, "caller-removed", G_CALLBACK(on_caller_removed), NULL);
+        source_endpoint_valid = srt_element_endpoint(source, &source_endpoint);
     }
 
-    // ULTRA-SIMPLE PIPELINE: source -> tee (no queues, no processing)
-    gst_bin_add_many(GST_BIN(pipeline), source, tee, NULL);
-    if (!gst_element_link(source, tee)) {
-        g_printerr("Elements could not be linked.\n");
-        gst_object_unref(pipeline);
-        return NULL;
+    // Optional batching between source and tee, so the fan-out handles one buffer list per
+    // max-latency window instead of every SRT message:
+    // "batch": {"max-latency-ms": 2, "max-buffers": 32, "max-bytes": 65536}
+    batch_element = NULL;
+    cJSON *batch_obj = cJSON_GetObjectItem(json, "batch");
+    if (cJSON_IsObject(batch_obj) || cJSON_IsTrue(batch_obj)) {
+        if (!buffer_batch_register() || !(batch_element = gst_element_factory_make("bgbatch", "batch"))) {
+            g_printerr("Batch: Failed to create batching element\n");
+            gst_object_unref(pipeline);
+            return NULL;
+        }
+
+        cJSON *latency_ms = cJSON_GetObjectItem(batch_obj, "max-latency-ms");
+        cJSON *max_buffers = cJSON_GetObjectItem(batch_obj, "max-buffers");
+        cJSON *max_bytes = cJSON_GetObjectItem(batch_obj, "max-bytes");
+        if (cJSON_IsNumber(latency_ms) && latency_ms->valuedouble >= 0) {
+            g_object_set(batch_element, "max-latency", (guint64)(latency_ms->valuedouble * GST_MSECOND), NULL);
+        }
+        if (cJSON_IsNumber(max_buffers) && max_buffers->valueint > 0) {
+            g_object_set(batch_element, "max-buffers", (guint)max_buffers->valueint, NULL);
+        }
+        if (cJSON_IsNumber(max_bytes) && max_bytes->valueint > 0) {
+            g_object_set(batch_element, "max-bytes", (guint)max_bytes->valueint, NULL);
+        }
     }
-    g_print("ULTRA-SIMPLE Pipeline: source -> tee (no intermediate processing)\n");
-
-    // Reset video info for new pipeline
-    pthread_mutex_lock(&video_info.mutex);
-    video_info.width = 0;
-    video_info.height = 0;
-    video_info.fps_num = 0;
-    video_info.fps_den = 1;
-    video_info.interlaced = FALSE;
-    video_info.info_valid = FALSE;
-    video_info.pmt_pid = 0;
-    video_info.video_pid = 0;
-    video_info.video_stream_type = 0;
-    pthread_mutex_unlock(&video_info.mutex);
+
+    if (batch_element) {
+        gst_bin_add_many(GST_BIN(pipeline), source, batch_element, tee, NULL);
+        if (!gst_element_link_many(source, batch_element, tee, NULL)) {
+            g_printerr("Elements could not be linked.\n");
+            gst_object_unref(pipeline);
+            batch_element = NULL;
+            return NULL;
+        }
+        g_print("Pipeline: source -> batch -> tee\n");
+    } else {
+        // ULTRA-SIMPLE PIPELINE: source -> tee (no queues, no processing)
+        gst_bin_add_many(GST_BIN(pipeline), source, tee, NULL);
+        if (!gst_element_link(source, tee)) {
+            g_printerr("Elements could not be linked.\n");
+            gst_object_unref(pipeline);
+            return NULL;
+        }
+        g_print("ULTRA-SIMPLE Pipeline: source -> tee (no intermediate processing)\n");
+    }
+
+    // Fresh video metadata for the new pipeline
+    ts_metadata_free(ts_metadata);
+    ts_metadata = ts_metadata_new(on_video_format_changed, NULL);
 
     // Add buffer probe on tee sink pad to parse MPEG-TS packets
     GstPad *tee_sink_pad = gst_element_get_static_pad(tee, "sink");
     if (tee_sink_pad) {
-        gst_pad_add_probe(tee_sink_pad, GST_PAD_PROBE_TYPE_BUFFER, ts_probe_callback, NULL, NULL);
+        gst_pad_add_probe(tee_sink_pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST, ts_probe_callback,
+                          NULL, NULL);
         g_print("MPEG-TS: Installed buffer probe on tee sink pad for video metadata extraction\n");
+        if (source_watchdog) {
+            gst_pad_add_probe(tee_sink_pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                              watchdog_probe_callback, NULL, NULL);
+        }
         gst_object_unref(tee_sink_pad);
     }
 
     // Reset sink counter
     sink_count = 0;
+    memset(sink_endpoint_valid, 0, sizeof(sink_endpoint_valid));
+    sink_queue_count = 0;
+    memset(sink_filters, 0, sizeof(sink_filters));
+    memset(sink_fecs, 0, sizeof(sink_fecs));
+    memset(sink_nulls, 0, sizeof(sink_nulls));
+    memset(sink_pacers, 0, sizeof(sink_pacers));
+    memset(sink_queues, 0, sizeof(sink_queues));
+
+    // Optional shared output pool instead of a queue2 thread per destination:
+    // "output": {"workers": 2, "max-buffers": 8192, "max-bytes": 52428800}
+    cJSON *output_obj = cJSON_GetObjectItem(json, "output");
+    if (cJSON_IsObject(output_obj)) {
+        cJSON *workers = cJSON_GetObjectItem(output_obj, "workers");
+        cJSON *max_buffers = cJSON_GetObjectItem(output_obj, "max-buffers");
+        cJSON *max_bytes = cJSON_GetObjectItem(output_obj, "max-bytes");
+        if (cJSON_IsNumber(max_buffers) && max_buffers->valueint > 0) output_max_buffers = max_buffers->valueint;
+        if (cJSON_IsNumber(max_bytes) && max_bytes->valuedouble > 0) output_max_bytes = (guint64)max_bytes->valuedouble;
+
+        output_pool = output_pool_new(cJSON_IsNumber(workers) ? (guint)MAX(workers->valueint, 0) : 0);
+        if (!output_pool) {
+            gst_object_unref(pipeline);
+            return NULL;
+        }
+
+        GstPad *pool_pad = gst_element_get_static_pad(tee, "sink");
+        gst_pad_add_probe(pool_pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                          output_probe_callback, NULL, NULL);
+        gst_object_unref(pool_pad);
+    }
+
     thumbnail_thread_started = FALSE;
     thumbnail_appsink = NULL;
+    decode_queue = NULL;
+    proxy_tee = NULL;
+    proxy_queue = NULL;
+
+    // One decode for the thumbnail, video health and the optional proxy; built before the sinks so
+    // "proxy" destinations can attach to its encoder. "decode": false leaves it out altogether.
+    // (The thumbnail is gracefully skipped if its elements are unavailable; a configured proxy is not.)
+    cJSON *decode_obj = cJSON_GetObjectItem(json, "decode");
+    if (!cJSON_IsFalse(decode_obj) && !add_decode_tier(pipeline, tee, decode_obj, route_id)) {
+        output_pool_free(output_pool);
+        output_pool = NULL;
+        gst_object_unref(pipeline);
+        return NULL;
+    }
+
+    // Optional time-delayed destinations, all reading from one ring sized for the longest delay:
+    // per-sink "delay": {"delay-ms": 10000}, route "delay-ring": {"max-bitrate": 50000000}
+    gint64 max_delay_us = max_sink_delay_us(sinks_array);
+    if (max_delay_us > 0) {
+        delay_output = delay_output_new(cJSON_GetObjectItem(json, "delay-ring"), max_delay_us, shared_listener);
+    }
+    if (max_delay_us < 0 || (max_delay_us > 0 && !delay_output)) {
+        output_pool_free(output_pool);
+        output_pool = NULL;
+        gst_object_unref(pipeline);
+        return NULL;
+    }
+    if (delay_output) {
+        GstPad *delay_pad = gst_element_get_static_pad(tee, "sink");
+        gst_pad_add_probe(delay_pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST,
+                          delay_probe_callback, NULL, NULL);
+        gst_object_unref(delay_pad);
+    }
 
     cJSON *sink;
     int sink_idx = 0;
     cJSON_ArrayForEach(sink, sinks_array)
     {
-        if (!add_sink_to_pipeline(pipeline, tee, sink, sink_idx)) {
+        // "proxy": true takes the proxy encoder's output instead of the source stream
+        GstElement *upstream = cJSON_IsTrue(cJSON_GetObjectItem(sink, "proxy")) ? proxy_tee : tee;
+        if (!upstream) g_printerr("Sink %d: 'proxy' needs a \"decode\": {\"proxy\": ...} config\n", sink_idx);
+        if (!upstream || !add_sink_to_pipeline(pipeline, upstream, sink, sink_idx)) {
+            output_pool_free(output_pool);
+            output_pool = NULL;
+            delay_output_free(delay_output);
+            delay_output = NULL;
             gst_object_unref(pipeline);
             return NULL;
         }
         sink_idx++;
     }
 
-    // Add thumbnail capture branch (gracefully skipped if elements unavailable)
-    if (route_id && route_id[0] != '\0') {
-        add_thumbnail_branch(pipeline, tee, route_id);
+    // Optional audio metering: "audio-meter": true, or {"enabled": false} to build it switched off
+    // and turn it on later with an "audio-meter" command
+    audio_queue = NULL;
+    audio_valve = NULL;
+    audio_thread_known = FALSE;
+    audio_wall_last_us = 0;
+    cJSON *audio_obj = cJSON_GetObjectItem(json, "audio-meter");
+    if (cJSON_IsTrue(audio_obj) || cJSON_IsObject(audio_obj)) {
+        add_audio_meter_branch(pipeline, tee, !cJSON_IsFalse(cJSON_GetObjectItem(audio_obj, "enabled")));
     }
 
     loop = g_main_loop_new(NULL, FALSE);
 
     GstBus *bus = gst_element_get_bus(pipeline);
+    gst_bus_set_sync_handler(bus, bus_sync_handler, NULL, NULL);
     gst_bus_add_watch(bus, bus_callback, pipeline);
     gst_object_unref(bus);
 
     source_element = source;
     tee_element = tee;
 
+    if (shared_listener) {
+        shared_source = shared_source_new(source, source_obj);
+        if (!shared_source) {
+            output_pool_free(output_pool);
+            output_pool = NULL;
+            delay_output_free(delay_output);
+            delay_output = NULL;
+            g_main_loop_unref(loop);
+            loop = NULL;
+            gst_object_unref(pipeline);
+            return NULL;
+        }
+    }
+
+    if (bonded_source) {
+        g_object_set(source, "is-live", TRUE, "format", GST_FORMAT_BYTES, NULL);
+        group_source = srt_group_new(source_obj, push_to_appsrc, source);
+        if (!group_source || !srt_group_start(group_source)) {
+            srt_group_free(group_source);
+            group_source = NULL;
+            output_pool_free(output_pool);
+            output_pool = NULL;
+            delay_output_free(delay_output);
+            delay_output = NULL;
+            g_main_loop_unref(loop);
+            loop = NULL;
+            gst_object_unref(pipeline);
+            return NULL;
+        }
+    }
+
+    if (udp_ingest) {
+        g_object_set(source, "is-live", TRUE, "format", GST_FORMAT_BYTES, NULL);
+        udp_source = udp_source_new(source_obj, push_to_appsrc, source);
+        if (!udp_source || !udp_source_start(udp_source)) {
+            udp_source_free(udp_source);
+            udp_source = NULL;
+            output_pool_free(output_pool);
+            output_pool = NULL;
+            delay_output_free(delay_output);
+            delay_output = NULL;
+            g_main_loop_unref(loop);
+            loop = NULL;
+            gst_object_unref(pipeline);
+            return NULL;
+        }
+    }
+
+    // Before the pipeline leaves NULL, so the SRT elements' sockets are all created after it
+    gboolean srt_elements = source_endpoint_valid;
+    for (int i = 0; i < sink_count; i++) srt_elements |= sink_endpoint_valid[i];
+    if (srt_elements) srt_index = srt_socket_index_new();
+
     running = TRUE;
     if (pthread_create(&stats_thread, NULL, print_stats, source) != 0) {
         g_printerr("Failed to create stats thread\n");
     }
 
+    if (source_watchdog) {
+        watchdog_timer = g_timeout_add(input_watchdog_poll_interval_ms(source_watchdog), watchdog_tick, NULL);
+    }
+
     return pipeline;
 }
 
+// If the sink config has `key`, create a `factory` element configured from it and link it in front of
+// *head, which then becomes the new head. *stage is the element, or NULL if the key is absent.
+static gboolean add_sink_stage(GstElement *pipeline, cJSON *sink_config, const char *key, const char *factory,
+                               gboolean (*register_fn)(void), gboolean (*configure_fn)(GstElement *, cJSON *),
+                               int sink_index, GstElement **head, GstElement **stage)
+{
+    *stage = NULL;
+    cJSON *config = cJSON_GetObjectItem(sink_config, key);
+    if (!config) return TRUE;
+
+    GstElement *element = register_fn() ? gst_element_factory_make(factory, NULL) : NULL;
+    if (!element || !configure_fn(element, config)) {
+        g_printerr("Invalid '%s' config for sink %d\n", key, sink_index);
+        if (element) gst_object_unref(element);
+        return FALSE;
+    }
+    gst_bin_add(GST_BIN(pipeline), element);
+    if (!gst_element_link_pads(element, "src", *head, "sink")) {
+        g_printerr("Could not link %s for sink %d.\n", factory, sink_index);
+        return FALSE;
+    }
+
+    g_print("Sink %d: '%s' handled by %s\n", sink_index, key, factory);
+    *head = element;
+    *stage = element;
+    return TRUE;
+}
+
+// A udpsink for one of bgfecenc's FEC pads, sending to the media sink's host at its port + `port_offset`
+static gboolean add_fec_sink(GstElement *pipeline, GstElement *fec, const char *pad_name, GstElement *media_sink,
+                             int port_offset, int sink_index)
+{
+    gchar *host = NULL;
+    gint port = 0;
+    g_object_get(media_sink, "host", &host, "port", &port, NULL);
+
+    GstElement *sink = gst_element_factory_make("udpsink", NULL);
+    if (!sink || port + port_offset > 65535) {
+        g_printerr("Could not create the %s sink for sink %d.\n", pad_name, sink_index);
+        if (sink) gst_object_unref(sink);
+        g_free(host);
+        return FALSE;
+    }
+    g_object_set(sink, "host", host, "port", port + port_offset, "sync", FALSE, "async", FALSE, NULL);
+    gst_bin_add(GST_BIN(pipeline), sink);
+
+    if (!gst_element_link_pads(fec, pad_name, sink, "sink")) {
+        g_printerr("Could not link %s for sink %d.\n", pad_name, sink_index);
+        g_free(host);
+        return FALSE;
+    }
+    g_print("Sink %d: %s to %s:%d\n", sink_index, pad_name, host, port + port_offset);
+    g_free(host);
+    return TRUE;
+}
+
 gboolean add_sink_to_pipeline(GstElement *pipeline, GstElement *tee, cJSON *sink_config, int sink_index)
 {
     cJSON *sink_type = cJSON_GetObjectItem(sink_config, "type");
@@ -1185,23 +2491,33 @@ gboolean add_sink_to_pipeline(GstElement *pipeline, GstElement *tee, cJSON *sink
         return FALSE;
     }
 
-    // Use queue2 for better streaming performance (supports ring buffer mode)
-    GstElement *queue = gst_element_factory_make("queue2", NULL);
-    GstElement *sink_element = gst_element_factory_make(sink_type->valuestring, NULL);
-
-    if (!queue || !sink_element) {
+    // "srtgroup": bonded SRT over several links (see srt_group.h), configured from the whole sink object
+    gboolean bonded = strcmp(sink_type->valuestring, "srtgroup") == 0;
+    GstElement *sink_element = NULL;
+    gboolean sink_stats = FALSE; // Reported in its own "stats_sink:" record by collect_sink_stats
+    if (bonded) {
+        sink_element = group_sink_register() ? gst_element_factory_make("bgsrtgroupsink", NULL) : NULL;
+    } else {
+        sink_element = gst_element_factory_make(sink_type->valuestring, NULL);
+    }
+    if (!sink_element) {
         g_printerr("Could not create sink elements.\n");
         return FALSE;
     }
 
-    // Configure queue2 for high-bitrate streaming (up to 50Mbps)
-    // At 20Mbps: 50MB = ~20 seconds buffer, 3s time limit controls actual latency
-    g_object_set(queue, "use-buffering", FALSE, NULL);               // Don't pause for buffering
-    g_object_set(queue, "max-size-buffers", 0, NULL);                // Unlimited buffer count
-    g_object_set(queue, "max-size-bytes", 50 * 1024 * 1024, NULL);   // 50MB max (handles 20Mbps+)
-    g_object_set(queue, "max-size-time", (guint64)3000000000, NULL); // 3 seconds max
-
-    set_element_properties(sink_element, sink_config, sink_type->valuestring, "type");
+    if (bonded) {
+        if (!group_sink_configure(sink_element, sink_config)) {
+            g_printerr("Invalid 'srtgroup' config for sink %d\n", sink_index);
+            gst_object_unref(sink_element);
+            return FALSE;
+        }
+        if (sink_count < MAX_SINKS) {
+            sink_elements[sink_count++] = sink_element;
+            sink_stats = TRUE;
+        }
+    } else {
+        set_element_properties(sink_element, sink_config, sink_type->valuestring, "type");
+    }
 
     if (strcmp(sink_type->valuestring, "udpsink") == 0) {
         g_object_set(sink_element, "sync", FALSE, NULL);
@@ -1214,21 +2530,130 @@ gboolean add_sink_to_pipeline(GstElement *pipeline, GstElement *tee, cJSON *sink
         g_object_set(sink_element, "sync", FALSE, NULL);
         g_object_set(sink_element, "wait-for-connection", FALSE, NULL);
         g_print("Configured SRT sink with async=FALSE, sync=FALSE, wait-for-connection=FALSE\n");
+        g_signal_connect(sink_element, "caller-added", G_CALLBACK(on_sink_caller_added), GINT_TO_POINTER(sink_index));
+        g_signal_connect(sink_element, "caller-removed", G_CALLBACK(on_sink_caller_removed),
+                         GINT_TO_POINTER(sink_index));
 
         // Store this SRT sink element for stats collection
         if (sink_count < MAX_SINKS) {
             sink_elements[sink_count] = sink_element;
+            sink_endpoint_valid[sink_count] = srt_element_endpoint(sink_element, &sink_endpoints[sink_count]);
             sink_count++;
+            sink_stats = TRUE;
             g_print("Stored SRT sink element at index %d for stats collection\n", sink_index);
         }
     }
 
-    gst_bin_add_many(GST_BIN(pipeline), queue, sink_element, NULL);
-    if (!gst_element_link_many(tee, queue, sink_element, NULL)) {
+    gst_bin_add(GST_BIN(pipeline), sink_element);
+
+    // Optional per-destination packet stages, nearest the sink first:
+    // - "fec": {"columns": 10, "rows": 10, "row": true} - SMPTE 2022-1 RTP + FEC (udpsink only)
+    // - "pacing": {"delay-ms": 100, "max-burst": 7} - PCR-paced output
+    // - "nulls": {"mode": "strip"} or {"mode": "pad", "bitrate": 8000000} - null stripping or CBR re-padding
+    // - "filter": {"programs": [1], "pids": [256, 257], "keep-pids": [17]} - program/PID filter (MPTS splitting)
+    GstElement *head = sink_element;
+    GstElement *stage = NULL;
+    if (cJSON_GetObjectItem(sink_config, "fec") && strcmp(sink_type->valuestring, "udpsink") != 0) {
+        g_printerr("Sink %d: 'fec' is only supported on udpsink destinations\n", sink_index);
+        return FALSE;
+    }
+    if (!add_sink_stage(pipeline, sink_config, "fec", "bgfecenc", fec_sender_register, fec_sender_configure,
+                        sink_index, &head, &stage)) {
+        return FALSE;
+    }
+    if (stage) {
+        // Column FEC on port + 2, row FEC on port + 4 (SMPTE 2022-1)
+        if (!add_fec_sink(pipeline, stage, "fec_col", sink_element, 2, sink_index)) return FALSE;
+        if (fec_sender_has_rows(stage) && !add_fec_sink(pipeline, stage, "fec_row", sink_element, 4, sink_index)) {
+            return FALSE;
+        }
+        if (sink_index < MAX_SINKS) sink_fecs[sink_index] = stage;
+    }
+    if (!add_sink_stage(pipeline, sink_config, "pacing", "bgpacer", pacer_register, pacer_configure, sink_index,
+                        &head, &stage)) {
+        return FALSE;
+    }
+    if (stage) {
+        // Its task sends every paced packet of the destination; bus_sync_handler places it as the sink's
+        g_object_set_data_full(G_OBJECT(stage), "bg-sink-thread", g_strdup_printf("sink-%d", sink_index), g_free);
+        g_object_set_data(G_OBJECT(sink_element), "bg-pacer", stage);
+        if (!sink_stats && sink_index < MAX_SINKS) sink_pacers[sink_index] = stage;
+    }
+    if (!add_sink_stage(pipeline, sink_config, "nulls", "bgnullshaper", null_shaper_register, null_shaper_configure,
+                        sink_index, &head, &stage)) {
+        return FALSE;
+    }
+    if (stage) {
+        g_object_set_data(G_OBJECT(sink_element), "bg-null-shaper", stage);
+        if (!sink_stats && sink_index < MAX_SINKS) sink_nulls[sink_index] = stage;
+    }
+    if (!add_sink_stage(pipeline, sink_config, "filter", "bgpidfilter", pid_filter_register, pid_filter_configure,
+                        sink_index, &head, &stage)) {
+        return FALSE;
+    }
+    if (stage && sink_index < MAX_SINKS) sink_filters[sink_index] = stage;
+
+#if BG_TRACE_AVAILABLE
+    GstPad *trace_pad = gst_element_get_static_pad(head, "sink");
+    gst_pad_add_probe(trace_pad, GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST, sink_trace_probe_callback,
+                      GINT_TO_POINTER(sink_index), NULL);
+    gst_object_unref(trace_pad);
+#endif
+
+    // A delayed destination takes its buffers from the delay ring, on the delay thread, instead of the tee
+    cJSON *delay = cJSON_GetObjectItem(sink_config, "delay");
+    if (delay && delay_output && tee != proxy_tee) {
+        GstPad *sink_pad = gst_element_get_static_pad(head, "sink");
+        gboolean added = delay_output_add_dest(delay_output, sink_pad, sink_index, delay_ring_parse_delay(delay));
+        gst_object_unref(sink_pad);
+        if (!added) g_printerr("Could not attach sink %d to the delay ring.\n", sink_index);
+        return added;
+    }
+
+    // The pool carries the source stream; proxy destinations keep a queue2 behind the proxy tee
+    if (output_pool && tee != proxy_tee) {
+        // Pool mode: no queue2 thread, a pool worker pushes straight into the sink (or its first stage)
+        char name[32];
+        snprintf(name, sizeof(name), "sink-%d", sink_index);
+        GstPad *sink_pad = gst_element_get_static_pad(head, "sink");
+        OutputDest *dest = output_pool_add_dest(output_pool, sink_pad, name, output_max_buffers, output_max_bytes);
+        gst_object_unref(sink_pad);
+
+        if (!dest) {
+            g_printerr("Could not attach sink %d to the output pool.\n", sink_index);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    // Use queue2 for better streaming performance (supports ring buffer mode)
+    GstElement *queue = gst_element_factory_make("queue2", NULL);
+    if (!queue) {
+        g_printerr("Could not create sink elements.\n");
+        return FALSE;
+    }
+
+    // Configure queue2 for high-bitrate streaming (up to 50Mbps)
+    // At 20Mbps: 50MB = ~20 seconds buffer, 3s time limit controls actual latency
+    g_object_set(queue, "use-buffering", FALSE, NULL);               // Don't pause for buffering
+    g_object_set(queue, "max-size-buffers", 0, NULL);                // Unlimited buffer count
+    g_object_set(queue, "max-size-bytes", 50 * 1024 * 1024, NULL);   // 50MB max (handles 20Mbps+)
+    g_object_set(queue, "max-size-time", (guint64)3000000000, NULL); // 3 seconds max
+
+    gst_bin_add(GST_BIN(pipeline), queue);
+    if (!gst_element_link_many(tee, queue, head, NULL)) {
         g_printerr("Could not link sink elements.\n");
         return FALSE;
     }
 
+    if (sink_index < MAX_SINKS) {
+        QueueLevel limit = {50 * 1024 * 1024, 0, 3000000000};
+        queue_telemetry_init(&sink_queue_telemetry[sink_index], &limit, g_get_monotonic_time());
+        g_object_set_data(G_OBJECT(sink_element), "bg-queue-telemetry", &sink_queue_telemetry[sink_index]);
+        sink_queues[sink_index] = queue;
+        sink_queue_count = MAX(sink_queue_count, sink_index + 1);
+    }
+
     return TRUE;
 }
 
@@ -1237,22 +2662,123 @@ void cleanup_pipeline(GstElement *pipeline)
     running = FALSE;
     thumbnail_running = FALSE; // Signal thumbnail thread to stop
 
+    // No source restarts while the pipeline is going down
+    if (watchdog_timer) {
+        g_source_remove(watchdog_timer);
+        watchdog_timer = 0;
+    }
+
     // Set pipeline to NULL first — this flushes appsink, unblocking try_pull_sample
     gst_element_set_state(pipeline, GST_STATE_NULL);
 
     pthread_join(stats_thread, NULL);
 
+    // Workers may still hold sink pads; stop them before the sinks go away with the pipeline
+    output_pool_free(output_pool);
+    output_pool = NULL;
+    delay_output_free(delay_output);
+    delay_output = NULL;
+    batch_element = NULL; // Owned by the pipeline
+    ts_metadata_free(ts_metadata);
+    ts_metadata = NULL;
+
+    // Buffers still wrapping ring slots were released when the pipeline went to NULL
+    shared_source_free(shared_source);
+    shared_source = NULL;
+
+    // Stop pushing into the appsrc before it goes away with the pipeline
+    srt_group_free(group_source);
+    group_source = NULL;
+    udp_source_free(udp_source);
+    udp_source = NULL;
+
+    // No more handshakes once the source is in NULL
+    admission_free(source_admission);
+    source_admission = NULL;
+    if (caller_stream_ids) {
+        g_hash_table_destroy(caller_stream_ids);
+        caller_stream_ids = NULL;
+    }
+
+    input_watchdog_free(source_watchdog);
+    source_watchdog = NULL;
+
+    // The stats thread is gone; drop the caller address references
+    for (int i = 0; i < MAX_SINKS; i++) {
+        caller_stats_free(sink_caller_stats[i]);
+        sink_caller_stats[i] = NULL;
+    }
+    srt_socket_index_free(srt_index);
+    srt_index = NULL;
+    source_endpoint_valid = FALSE;
+    source_bytes_total = 0;
+    memset(sink_endpoint_valid, 0, sizeof(sink_endpoint_valid));
+    memset(sink_bytes_total, 0, sizeof(sink_bytes_total));
+    memset(sink_send_buffer_peak_ms, 0, sizeof(sink_send_buffer_peak_ms));
+
     if (thumbnail_thread_started) {
         pthread_join(thumbnail_thread, NULL);
         thumbnail_thread_started = FALSE;
     }
 
     thumbnail_appsink = NULL;
+    decode_queue = NULL;
+    proxy_tee = NULL;
+    proxy_queue = NULL;
 
     gst_object_unref(pipeline);
 
+    // The meter probes went with the pipeline
+    if (audio_streams) {
+        g_ptr_array_free(audio_streams, TRUE);
+        audio_streams = NULL;
+    }
+    audio_queue = NULL;
+    audio_valve = NULL;
+
+    // Its probe went with the pipeline too
+    video_health_free(video_health);
+    video_health = NULL;
+    // As did the appsink publishing to it; this disconnects the viewers
+    preview_server_free(preview_server);
+    preview_server = NULL;
+
     if (loop) {
         g_main_loop_unref(loop);
         loop = NULL;
     }
 }
+
+// {"command":"callers-detail","sink":N,"seconds":S} lists every caller of sink N (all sinks without
+// "sink") in its stats records for S seconds (default 10, at most 300).
+// {"command":"audio-meter","enabled":B} switches the audio metering branch on or off.
+void pipeline_handle_command(const char *line)
+{
+    cJSON *json = cJSON_Parse(line);
+    if (!json) {
+        g_printerr("Command: invalid JSON: %s\n", line);
+        return;
+    }
+
+    const cJSON *command = cJSON_GetObjectItem(json, "command");
+    if (cJSON_IsString(command) && g_strcmp0(command->valuestring, "callers-detail") == 0) {
+        const cJSON *sink = cJSON_GetObjectItem(json, "sink");
+        const cJSON *seconds = cJSON_GetObjectItem(json, "seconds");
+        gint64 duration_s = cJSON_IsNumber(seconds) ? CLAMP((gint64)seconds->valuedouble, 1, 300) : 10;
+        gint64 until_us = g_get_monotonic_time() + duration_s * G_USEC_PER_SEC;
+
+        for (int i = 0; i < MAX_SINKS; i++) {
+            if (cJSON_IsNumber(sink) && sink->valueint != i) continue;
+            __atomic_store_n(&caller_detail_until_us[i], until_us, __ATOMIC_RELAXED);
+        }
+    } else if (cJSON_IsString(command) && g_strcmp0(command->valuestring, "audio-meter") == 0) {
+        if (!audio_valve) {
+            g_printerr("Command: audio-meter: route has no \"audio-meter\" config\n");
+        } else {
+            audio_branch_set_enabled(!cJSON_IsFalse(cJSON_GetObjectItem(json, "enabled")));
+        }
+    } else {
+        g_printerr("Command: unknown command: %s\n", line);
+    }
+    cJSON_Delete(json);
+}
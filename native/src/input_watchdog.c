@@ -0,0 +1,146 @@
+#include "input_watchdog.h"
+
+struct InputWatchdog {
+    gint64 stall_us;
+    gboolean restart;
+
+    // Written by the streaming thread
+    gint64 last_data_us;
+    gint64 first_data_us; // First data since `flowing` was cleared
+    gint flowing;
+
+    // Only touched by the polling thread
+    gboolean armed;
+    gint64 stall_last_data_us;
+
+    GMutex lock; // Protects stats against the stats thread
+    InputWatchdogStats stats;
+};
+
+InputWatchdog *input_watchdog_new(cJSON *config)
+{
+    if (!cJSON_IsObject(config) && !cJSON_IsTrue(config)) {
+        g_printerr("InputWatchdog: config must be an object or true\n");
+        return NULL;
+    }
+
+    cJSON *stall_ms = cJSON_GetObjectItem(config, "stall-ms");
+    cJSON *restart = cJSON_GetObjectItem(config, "restart");
+    if ((stall_ms && (!cJSON_IsNumber(stall_ms) || stall_ms->valueint < INPUT_WATCHDOG_MIN_STALL_MS ||
+                      stall_ms->valueint > INPUT_WATCHDOG_MAX_STALL_MS)) ||
+        (restart && !cJSON_IsBool(restart))) {
+        g_printerr("InputWatchdog: invalid config (stall-ms must be %d..%d)\n", INPUT_WATCHDOG_MIN_STALL_MS,
+                   INPUT_WATCHDOG_MAX_STALL_MS);
+        return NULL;
+    }
+
+    InputWatchdog *wd = g_new0(InputWatchdog, 1);
+    g_mutex_init(&wd->lock);
+    wd->stats.stall_ms = stall_ms ? (guint)stall_ms->valueint : INPUT_WATCHDOG_DEFAULT_STALL_MS;
+    wd->stats.last_restart_ms = -1;
+    wd->stats.last_outage_ms = -1;
+    wd->stall_us = (gint64)wd->stats.stall_ms * 1000;
+    wd->restart = !restart || cJSON_IsTrue(restart);
+
+    g_print("InputWatchdog: stall after %u ms, %s\n", wd->stats.stall_ms,
+            wd->restart ? "restarting the source" : "report only");
+    return wd;
+}
+
+void input_watchdog_free(InputWatchdog *wd)
+{
+    if (!wd) return;
+    g_mutex_clear(&wd->lock);
+    g_free(wd);
+}
+
+void input_watchdog_feed(InputWatchdog *wd, gint64 now_us)
+{
+    __atomic_store_n(&wd->last_data_us, now_us, __ATOMIC_RELAXED);
+    if (G_UNLIKELY(!__atomic_load_n(&wd->flowing, __ATOMIC_RELAXED))) {
+        __atomic_store_n(&wd->first_data_us, now_us, __ATOMIC_RELAXED);
+        __atomic_store_n(&wd->flowing, TRUE, __ATOMIC_RELEASE);
+    }
+}
+
+InputWatchdogAction input_watchdog_poll(InputWatchdog *wd, gint64 now_us, gint64 *elapsed_ms)
+{
+    InputWatchdogAction action = INPUT_WATCHDOG_NONE;
+
+    if (!wd->armed) {
+        if (!__atomic_load_n(&wd->flowing, __ATOMIC_ACQUIRE)) return INPUT_WATCHDOG_NONE;
+        wd->armed = TRUE;
+
+        g_mutex_lock(&wd->lock);
+        if (wd->stats.stalled) {
+            gint64 first_us = __atomic_load_n(&wd->first_data_us, __ATOMIC_RELAXED);
+            wd->stats.stalled = FALSE;
+            wd->stats.last_outage_ms = MAX(first_us - wd->stall_last_data_us, 0) / 1000;
+            *elapsed_ms = wd->stats.last_outage_ms;
+            action = INPUT_WATCHDOG_RESUMED;
+        }
+        g_mutex_unlock(&wd->lock);
+        return action;
+    }
+
+    gint64 last_us = __atomic_load_n(&wd->last_data_us, __ATOMIC_RELAXED);
+    if (now_us - last_us < wd->stall_us) return INPUT_WATCHDOG_NONE;
+
+    // Disarm until the next data, which the streaming thread reports through `flowing`
+    wd->armed = FALSE;
+    wd->stall_last_data_us = last_us;
+    __atomic_store_n(&wd->flowing, FALSE, __ATOMIC_RELEASE);
+
+    g_mutex_lock(&wd->lock);
+    wd->stats.stalled = TRUE;
+    wd->stats.stalls++;
+    g_mutex_unlock(&wd->lock);
+
+    *elapsed_ms = (now_us - last_us) / 1000;
+    return INPUT_WATCHDOG_STALLED;
+}
+
+guint input_watchdog_poll_interval_ms(InputWatchdog *wd)
+{
+    return CLAMP(wd->stats.stall_ms / 4, 10, 250);
+}
+
+gboolean input_watchdog_restart_enabled(InputWatchdog *wd)
+{
+    return wd->restart;
+}
+
+void input_watchdog_restarted(InputWatchdog *wd, gint64 duration_us, gboolean ok)
+{
+    // Buffers that were already in flight while the source went down do not count as recovery
+    wd->armed = FALSE;
+    __atomic_store_n(&wd->flowing, FALSE, __ATOMIC_RELEASE);
+
+    g_mutex_lock(&wd->lock);
+    if (ok) {
+        wd->stats.restarts++;
+    } else {
+        wd->stats.restart_failures++;
+    }
+    wd->stats.last_restart_ms = duration_us / 1000;
+    g_mutex_unlock(&wd->lock);
+}
+
+void input_watchdog_get_stats(InputWatchdog *wd, InputWatchdogStats *stats)
+{
+    g_mutex_lock(&wd->lock);
+    *stats = wd->stats;
+    g_mutex_unlock(&wd->lock);
+}
+
+void input_watchdog_stats_to_json(const InputWatchdogStats *stats, cJSON *root)
+{
+    cJSON *obj = cJSON_AddObjectToObject(root, "watchdog");
+    cJSON_AddNumberToObject(obj, "stall-ms", stats->stall_ms);
+    cJSON_AddBoolToObject(obj, "stalled", stats->stalled);
+    cJSON_AddNumberToObject(obj, "stalls", (double)stats->stalls);
+    cJSON_AddNumberToObject(obj, "restarts", (double)stats->restarts);
+    cJSON_AddNumberToObject(obj, "restart-failures", (double)stats->restart_failures);
+    cJSON_AddNumberToObject(obj, "last-restart-ms", (double)stats->last_restart_ms);
+    cJSON_AddNumberToObject(obj, "last-outage-ms", (double)stats->last_outage_ms);
+}
@@ -1,7 +1,9 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "gst_pipeline.h"
+#include "srt_listener.h"
 #include "unix_socket.h"
 
 //  stdin expects a JSON object:
@@ -33,17 +35,58 @@
 // Example JSON:
 // {\"sinks\":[{\"localaddress\":\"127.0.0.1\",\"localport\":8002,\"mode\":\"listener\",\"type\":\"srtsink\"},{\"address\":\"127.0.0.1\",\"port\":8003,\"type\":\"udpsink\"}],\"source\":{\"auto-reconnect\":true,\"keep-listening\":false,\"localaddress\":\"127.0.0.1\",\"localport\":8000,\"type\":\"srtsrc\"}}
 
+// Lines after the route config are runtime commands, see pipeline_handle_command()
+static gboolean on_stdin(GIOChannel *channel, GIOCondition condition, gpointer user_data)
+{
+    (void)condition;
+    (void)user_data;
+    gchar *line = NULL;
+    GIOStatus status = g_io_channel_read_line(channel, &line, NULL, NULL, NULL);
+    if (status == G_IO_STATUS_NORMAL && line) pipeline_handle_command(g_strstrip(line));
+    g_free(line);
+    // The controller closed our stdin; keep running until it stops us
+    return status == G_IO_STATUS_EOF || status == G_IO_STATUS_ERROR ? G_SOURCE_REMOVE : G_SOURCE_CONTINUE;
+}
+
+// Shared SRT listener mode (`blackgate_pipeline --listener`), see srt_listener.h
+static int run_listener(void)
+{
+    char buffer[1024];
+
+    printf("Waiting for listener JSON input...\n");
+    if (!fgets(buffer, sizeof(buffer), stdin)) return 1;
+
+    cJSON* json = cJSON_Parse(buffer);
+    if (!json) {
+        printf("Error parsing JSON\n");
+        return 1;
+    }
+
+    int ret = srt_listener_run(json);
+    cJSON_Delete(json);
+    return ret;
+}
+
 int main(int argc, char* argv[])
 {
     setvbuf(stdout, NULL, _IONBF, 0);
+    // Unbuffered so fgets leaves any command lines after the config to the stdin watch
+    setvbuf(stdin, NULL, _IONBF, 0);
     char buffer[1024];
 
-    init_unix_socket("/tmp/hydra_unix_sock");
+    if (argc > 1 && strcmp(argv[1], "--listener") == 0) {
+        return run_listener();
+    }
+
+    // BLACKGATE_SOCKET lets tools such as the soak harness run routes beside a live controller
+    const char* socket_path = getenv("BLACKGATE_SOCKET");
+    init_unix_socket(socket_path ? socket_path : "/tmp/hydra_unix_sock");
     atexit(cleanup_socket);
 
     printf("Argument %d: %s\n", argc, argv[1]);
-    send_message_to_unix_socket("route_id:");
-    send_message_to_unix_socket(argv[1]);
+    gchar *route_message = g_strdup_printf("route_id:%s\n", argv[1]);
+    send_message_to_unix_socket(route_message);
+    g_free(route_message);
 
     printf("Waiting for JSON input...\n");
     fgets(buffer, sizeof(buffer), stdin);
@@ -71,10 +114,14 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    GIOChannel* commands = g_io_channel_unix_new(STDIN_FILENO);
+    g_io_add_watch(commands, G_IO_IN | G_IO_HUP, on_stdin, NULL);
+
     GMainLoop* loop = g_main_loop_new(NULL, FALSE);
     g_main_loop_run(loop);
 
     g_main_loop_unref(loop);
+    g_io_channel_unref(commands);
     cleanup_pipeline(pipeline);
     cJSON_Delete(json);
 
@@ -0,0 +1,147 @@
+#include "null_shaper.h"
+
+#include "ts_nulls.h"
+
+struct _BgNullShaper {
+    GstElement parent;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+
+    // Held while a buffer is processed and while the stats thread reads the counters
+    GMutex lock;
+    TsNulls *nulls;
+};
+
+G_DEFINE_TYPE(BgNullShaper, bg_null_shaper, GST_TYPE_ELEMENT)
+
+static GstStaticPadTemplate sink_template =
+    GST_STATIC_PAD_TEMPLATE("sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate src_template =
+    GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+// The output for `in` as a new buffer, or NULL if there is none yet (all nulls, or held for padding)
+static GstBuffer *shape_buffer(BgNullShaper *self, GstBuffer *in)
+{
+    GstMapInfo map;
+    if (!gst_buffer_map(in, &map, GST_MAP_READ)) return NULL;
+
+    GByteArray *out = g_byte_array_sized_new((guint)map.size + TS_PACKET_SIZE);
+    g_mutex_lock(&self->lock);
+    ts_nulls_process(self->nulls, map.data, map.size, out);
+    g_mutex_unlock(&self->lock);
+    gst_buffer_unmap(in, &map);
+
+    if (out->len == 0) {
+        g_byte_array_free(out, TRUE);
+        return NULL;
+    }
+
+    gsize len = out->len;
+    GstBuffer *buffer = gst_buffer_new_wrapped(g_byte_array_free(out, FALSE), len);
+    GST_BUFFER_PTS(buffer) = GST_BUFFER_PTS(in);
+    GST_BUFFER_DTS(buffer) = GST_BUFFER_DTS(in);
+    return buffer;
+}
+
+static GstFlowReturn bg_null_shaper_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    (void)pad;
+    BgNullShaper *self = BG_NULL_SHAPER(parent);
+
+    GstBuffer *out = self->nulls ? shape_buffer(self, buffer) : gst_buffer_ref(buffer);
+    gst_buffer_unref(buffer);
+    return out ? gst_pad_push(self->srcpad, out) : GST_FLOW_OK;
+}
+
+static GstFlowReturn bg_null_shaper_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+    (void)pad;
+    BgNullShaper *self = BG_NULL_SHAPER(parent);
+    if (!self->nulls) return gst_pad_push_list(self->srcpad, list);
+
+    guint n = gst_buffer_list_length(list);
+    GstBufferList *out = gst_buffer_list_new_sized(n);
+    for (guint i = 0; i < n; i++) {
+        GstBuffer *buffer = shape_buffer(self, gst_buffer_list_get(list, i));
+        if (buffer) gst_buffer_list_add(out, buffer);
+    }
+    gst_buffer_list_unref(list);
+
+    if (gst_buffer_list_length(out) == 0) {
+        gst_buffer_list_unref(out);
+        return GST_FLOW_OK;
+    }
+    return gst_pad_push_list(self->srcpad, out);
+}
+
+static void bg_null_shaper_finalize(GObject *object)
+{
+    BgNullShaper *self = BG_NULL_SHAPER(object);
+
+    ts_nulls_free(self->nulls);
+    g_mutex_clear(&self->lock);
+
+    G_OBJECT_CLASS(bg_null_shaper_parent_class)->finalize(object);
+}
+
+static void bg_null_shaper_class_init(BgNullShaperClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+
+    gobject_class->finalize = bg_null_shaper_finalize;
+
+    gst_element_class_set_static_metadata(element_class, "TS null packet shaper", "Filter/Network",
+                                          "Strips MPEG-TS null packets or re-pads to a constant bitrate",
+                                          "Blackgate");
+    gst_element_class_add_static_pad_template(element_class, &sink_template);
+    gst_element_class_add_static_pad_template(element_class, &src_template);
+}
+
+static void bg_null_shaper_init(BgNullShaper *self)
+{
+    g_mutex_init(&self->lock);
+
+    self->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+    gst_pad_set_chain_function(self->sinkpad, bg_null_shaper_chain);
+    gst_pad_set_chain_list_function(self->sinkpad, bg_null_shaper_chain_list);
+    GST_PAD_SET_PROXY_CAPS(self->sinkpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->sinkpad);
+
+    self->srcpad = gst_pad_new_from_static_template(&src_template, "src");
+    GST_PAD_SET_PROXY_CAPS(self->srcpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->srcpad);
+}
+
+gboolean null_shaper_register(void)
+{
+    return gst_element_register(NULL, "bgnullshaper", GST_RANK_NONE, BG_TYPE_NULL_SHAPER);
+}
+
+gboolean null_shaper_configure(GstElement *shaper, cJSON *config)
+{
+    BgNullShaper *self = BG_NULL_SHAPER(shaper);
+    TsNulls *nulls = ts_nulls_new(config);
+    if (!nulls) return FALSE;
+
+    g_mutex_lock(&self->lock);
+    TsNulls *old = self->nulls;
+    self->nulls = nulls;
+    g_mutex_unlock(&self->lock);
+    ts_nulls_free(old);
+    return TRUE;
+}
+
+void null_shaper_add_stats(GstElement *shaper, cJSON *parent)
+{
+    BgNullShaper *self = BG_NULL_SHAPER(shaper);
+    TsNullsStats stats;
+
+    g_mutex_lock(&self->lock);
+    if (self->nulls) {
+        ts_nulls_get_stats(self->nulls, &stats);
+        ts_nulls_stats_to_json(self->nulls, &stats, parent);
+    }
+    g_mutex_unlock(&self->lock);
+}
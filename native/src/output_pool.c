@@ -0,0 +1,530 @@
+#include "output_pool.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "thread_policy.h"
+
+#define MAX_WORKERS 16
+// Default size: one worker per destination up to this; a worker is idle unless its destinations'
+// sinks block, so more only add wakeups and context switches
+#define DEFAULT_MAX_WORKERS 4
+#define MAX_DESTS 32
+// Buffers a worker pushes to one destination before moving on to the next (fairness)
+#define SERVICE_QUANTUM 32
+// A push in progress for longer than this, with work waiting, has a sleeping worker woken to take it
+#define SLOW_PUSH_US 2000
+// A push in progress for longer than this means a blocked sink: the worker in it is left to that
+// destination as its own thread and a new worker takes its place in the pool
+#define BLOCKED_PUSH_US 100000
+#define PUSH_DETACHED G_MININT64
+
+struct OutputDest {
+    char name[32];
+    GstPad *pad; // Our src pad, linked to the sink element's sink pad
+
+    pthread_mutex_t lock;
+    GstMiniObject **ring; // GstBuffer or GstBufferList
+    guint capacity;
+    guint head;
+    guint len;
+    guint64 buffers;
+    guint64 bytes;
+    guint64 max_bytes;
+    guint64 high_buffers; // Highest level since the last stats report
+    guint64 high_bytes;
+    guint64 dropped;
+    guint64 pushed;
+    guint64 push_errors;
+
+    gint scheduled;    // 1 while in a run queue or being serviced (atomic)
+    gint home;         // Worker whose run queue the destination is placed on (atomic)
+    OutputDest *next;  // Run queue link
+
+    // Set once its sink blocked a worker: from then on that thread alone services the destination,
+    // waiting on `cond` (with `lock`) instead of the run queues (atomic)
+    gint dedicated;
+    pthread_cond_t cond;
+};
+
+typedef struct {
+    OutputPool *pool;
+    guint index;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    OutputDest *runq_head;
+    OutputDest *runq_tail;
+
+    OutputDest *current; // Destination being serviced (atomic)
+    // When the push in progress started, 0 outside pushes, PUSH_DETACHED once detach_worker has
+    // claimed the push (atomic)
+    gint64 push_start_us;
+    gint detached; // Left to a blocked destination, no longer part of the pool (atomic)
+} Worker;
+
+struct OutputPool {
+    Worker workers[MAX_WORKERS];
+    gint n_workers; // Started so far, detached ones included; grows while workers run (atomic)
+    guint max_workers;
+    OutputDest *dests[MAX_DESTS];
+    guint n_dests;
+    gboolean full_logged; // No slot left to replace a blocked worker; reported once
+
+    pthread_mutex_t idle_lock;
+    pthread_cond_t idle_cond;
+    gint idle_workers; // Changed under idle_lock, read without it (atomic)
+    gint active;       // Pool workers awake: searching or servicing (atomic)
+    gint spinning;     // Pool workers awake and searching the run queues (atomic)
+    gint pending;      // Destinations sitting in run queues (atomic)
+    gint stopping;     // Set under idle_lock (atomic)
+};
+
+// A queued item is a single buffer or a whole list from the batching stage; a list is queued,
+// dropped and pushed as one unit
+static gsize item_size(GstMiniObject *item)
+{
+    if (GST_IS_BUFFER_LIST(item)) return gst_buffer_list_calculate_size(GST_BUFFER_LIST_CAST(item));
+    return gst_buffer_get_size(GST_BUFFER_CAST(item));
+}
+
+static guint item_buffers(GstMiniObject *item)
+{
+    return GST_IS_BUFFER_LIST(item) ? gst_buffer_list_length(GST_BUFFER_LIST_CAST(item)) : 1;
+}
+
+// =============================================================================
+// Run Queues
+// =============================================================================
+
+static void wake_one(OutputPool *pool)
+{
+    pthread_mutex_lock(&pool->idle_lock);
+    if (pool->idle_workers > 0) pthread_cond_signal(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+}
+
+// Queue the destination for the pool without waking anyone; see wake_workers
+static void schedule_dest(OutputPool *pool, OutputDest *dest)
+{
+    if (g_atomic_int_get(&dest->dedicated)) {
+        pthread_mutex_lock(&dest->lock);
+        pthread_cond_signal(&dest->cond);
+        pthread_mutex_unlock(&dest->lock);
+        return;
+    }
+    if (!g_atomic_int_compare_and_exchange(&dest->scheduled, 0, 1)) return; // Already queued or in service
+
+    Worker *w = &pool->workers[g_atomic_int_get(&dest->home)];
+    pthread_mutex_lock(&w->lock);
+    dest->next = NULL;
+    if (w->runq_tail) {
+        w->runq_tail->next = dest;
+    } else {
+        w->runq_head = dest;
+    }
+    w->runq_tail = dest;
+    pthread_mutex_unlock(&w->lock);
+
+    g_atomic_int_inc(&pool->pending);
+}
+
+static OutputDest *runq_pop(Worker *w)
+{
+    pthread_mutex_lock(&w->lock);
+    OutputDest *dest = w->runq_head;
+    if (dest) {
+        w->runq_head = dest->next;
+        if (!w->runq_head) w->runq_tail = NULL;
+        dest->next = NULL;
+    }
+    pthread_mutex_unlock(&w->lock);
+    return dest;
+}
+
+// Own run queue first, then steal from the others; sleep when there is nothing anywhere. Finding work
+// wakes no one: one worker drains every fast destination in turn, and wake_workers widens the pool
+// only once a push has been slow.
+static OutputDest *take_work(OutputPool *pool, Worker *self)
+{
+    g_atomic_int_inc(&pool->spinning);
+    for (;;) {
+        guint n_workers = (guint)g_atomic_int_get(&pool->n_workers);
+        OutputDest *dest = runq_pop(self);
+        for (guint i = 1; !dest && i < n_workers; i++) {
+            dest = runq_pop(&pool->workers[(self->index + i) % n_workers]);
+        }
+        if (dest) {
+            g_atomic_int_add(&pool->pending, -1);
+            g_atomic_int_add(&pool->spinning, -1);
+            return dest;
+        }
+
+        pthread_mutex_lock(&pool->idle_lock);
+        if (g_atomic_int_get(&pool->stopping)) {
+            pthread_mutex_unlock(&pool->idle_lock);
+            g_atomic_int_add(&pool->spinning, -1);
+            return NULL;
+        }
+        // Leave `active` before looking at `pending`; wake_workers adds to `pending` before it
+        // looks at `active`, so one of the two always sees the other
+        g_atomic_int_add(&pool->active, -1);
+        if (g_atomic_int_get(&pool->pending) == 0) {
+            g_atomic_int_add(&pool->spinning, -1);
+            g_atomic_int_inc(&pool->idle_workers);
+            pthread_cond_wait(&pool->idle_cond, &pool->idle_lock);
+            g_atomic_int_add(&pool->idle_workers, -1);
+            g_atomic_int_inc(&pool->spinning);
+        }
+        g_atomic_int_inc(&pool->active);
+        pthread_mutex_unlock(&pool->idle_lock);
+    }
+}
+
+// =============================================================================
+// Destinations
+// =============================================================================
+
+// Push up to SERVICE_QUANTUM queued items, recording each push's start so a blocked sink is noticed.
+// TRUE if the worker was detached during one of the pushes: `dest` is then its own.
+static gboolean push_quantum(Worker *w, OutputDest *dest)
+{
+    GstMiniObject *batch[SERVICE_QUANTUM];
+    guint n = 0;
+    guint64 buffers = 0;
+
+    pthread_mutex_lock(&dest->lock);
+    while (n < SERVICE_QUANTUM && dest->len > 0) {
+        GstMiniObject *item = dest->ring[dest->head];
+        dest->head = (dest->head + 1) % dest->capacity;
+        dest->len--;
+        dest->buffers -= item_buffers(item);
+        dest->bytes -= item_size(item);
+        buffers += item_buffers(item);
+        batch[n++] = item;
+    }
+    pthread_mutex_unlock(&dest->lock);
+
+    guint64 errors = 0;
+    gboolean detached = FALSE;
+    for (guint i = 0; i < n; i++) {
+        if (!detached) __atomic_store_n(&w->push_start_us, g_get_monotonic_time(), __ATOMIC_SEQ_CST);
+        GstFlowReturn ret = GST_IS_BUFFER_LIST(batch[i])
+                                ? gst_pad_push_list(dest->pad, GST_BUFFER_LIST_CAST(batch[i]))
+                                : gst_pad_push(dest->pad, GST_BUFFER_CAST(batch[i]));
+        if (!detached) detached = __atomic_exchange_n(&w->push_start_us, 0, __ATOMIC_SEQ_CST) == PUSH_DETACHED;
+        if (ret != GST_FLOW_OK) errors++;
+    }
+
+    pthread_mutex_lock(&dest->lock);
+    dest->pushed += buffers;
+    dest->push_errors += errors;
+    pthread_mutex_unlock(&dest->lock);
+    return detached;
+}
+
+// TRUE if the worker now belongs to `dest` (see detach_worker)
+static gboolean service_dest(OutputPool *pool, Worker *w, OutputDest *dest)
+{
+    g_atomic_pointer_set(&w->current, dest);
+    gboolean detached = push_quantum(w, dest);
+    g_atomic_pointer_set(&w->current, NULL);
+
+    // Leave the run queue, then look again: a buffer queued meanwhile must not be stranded
+    g_atomic_int_set(&dest->scheduled, 0);
+    pthread_mutex_lock(&dest->lock);
+    gboolean more = dest->len > 0;
+    pthread_mutex_unlock(&dest->lock);
+    if (more) schedule_dest(pool, dest);
+    return detached;
+}
+
+// A detached worker's remaining life: service only the destination whose sink blocked it
+static void serve_dedicated(OutputPool *pool, Worker *w, OutputDest *dest)
+{
+    for (;;) {
+        pthread_mutex_lock(&dest->lock);
+        while (dest->len == 0 && !g_atomic_int_get(&pool->stopping)) pthread_cond_wait(&dest->cond, &dest->lock);
+        gboolean stop = dest->len == 0;
+        pthread_mutex_unlock(&dest->lock);
+        if (stop) return;
+        push_quantum(w, dest); // Nobody detaches a detached worker
+    }
+}
+
+static void *worker_main(void *arg)
+{
+    Worker *w = arg;
+    char name[32];
+    snprintf(name, sizeof(name), "output-%u", w->index);
+    thread_policy_apply_self(THREAD_ROLE_SINK, name);
+
+    OutputDest *dest;
+    while ((dest = take_work(w->pool, w)) != NULL) {
+        if (service_dest(w->pool, w, dest)) {
+            serve_dedicated(w->pool, w, dest);
+            break;
+        }
+    }
+    thread_policy_forget_self();
+    return NULL;
+}
+
+static void dest_enqueue(OutputDest *dest, GstMiniObject *item)
+{
+    gsize size = item_size(item);
+    guint count = item_buffers(item);
+
+    pthread_mutex_lock(&dest->lock);
+    // Leaky: drop the oldest data rather than stalling the source for every other destination
+    while (dest->len > 0 &&
+           (dest->len == dest->capacity || dest->buffers + count > dest->capacity ||
+            (dest->max_bytes && dest->bytes + size > dest->max_bytes))) {
+        GstMiniObject *old = dest->ring[dest->head];
+        dest->head = (dest->head + 1) % dest->capacity;
+        dest->len--;
+        dest->buffers -= item_buffers(old);
+        dest->bytes -= item_size(old);
+        dest->dropped += item_buffers(old);
+        gst_mini_object_unref(old);
+    }
+    dest->ring[(dest->head + dest->len) % dest->capacity] = item;
+    dest->len++;
+    dest->buffers += count;
+    dest->bytes += size;
+    dest->high_buffers = MAX(dest->high_buffers, dest->buffers);
+    dest->high_bytes = MAX(dest->high_bytes, dest->bytes);
+    pthread_mutex_unlock(&dest->lock);
+}
+
+// =============================================================================
+// Pool
+// =============================================================================
+
+OutputPool *output_pool_new(guint workers)
+{
+    if (workers == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        workers = MIN(cpus > 0 ? (guint)cpus : 1, DEFAULT_MAX_WORKERS);
+    }
+
+    OutputPool *pool = g_new0(OutputPool, 1);
+    pool->max_workers = MIN(workers, MAX_WORKERS);
+    pthread_mutex_init(&pool->idle_lock, NULL);
+    pthread_cond_init(&pool->idle_cond, NULL);
+
+    g_print("Output: Worker pool of up to %u threads\n", pool->max_workers);
+    return pool;
+}
+
+// Published to the running workers only once it is fully set up
+static gboolean start_worker(OutputPool *pool)
+{
+    guint i = (guint)pool->n_workers;
+    Worker *w = &pool->workers[i];
+    w->pool = pool;
+    w->index = i;
+    pthread_mutex_init(&w->lock, NULL);
+    g_atomic_int_inc(&pool->active); // Starts out searching
+    if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+        g_printerr("Output: Failed to start worker %u\n", i);
+        g_atomic_int_add(&pool->active, -1);
+        pthread_mutex_destroy(&w->lock);
+        return FALSE;
+    }
+    g_atomic_int_set(&pool->n_workers, (gint)i + 1);
+    return TRUE;
+}
+
+// Hand the destination `w` is stuck pushing to over to `w` for good, and replace `w` in the pool.
+// `start_us` is the start of that push: the claim only succeeds if the same push is still running,
+// which also makes `current` the destination it is for. Only the thread feeding the pool calls this,
+// so workers are never started concurrently.
+static void detach_worker(OutputPool *pool, Worker *w, gint64 start_us)
+{
+    if ((guint)pool->n_workers >= MAX_WORKERS) {
+        if (!pool->full_logged) g_printerr("Output: A destination is blocked and no worker slot is left\n");
+        pool->full_logged = TRUE;
+        return;
+    }
+    OutputDest *dest = g_atomic_pointer_get(&w->current);
+    if (!dest || !__atomic_compare_exchange_n(&w->push_start_us, &start_us, PUSH_DETACHED, FALSE, __ATOMIC_SEQ_CST,
+                                              __ATOMIC_SEQ_CST)) {
+        return; // That push has returned
+    }
+
+    // The destination is in service (scheduled) by `w`, so it is in no run queue and never will be
+    g_atomic_int_set(&dest->dedicated, 1);
+    g_atomic_int_set(&w->detached, 1);
+    g_atomic_int_add(&pool->active, -1);
+    if (!start_worker(pool)) return;
+
+    // Destinations placed on the detached worker's run queue go to its replacement from now on
+    gint replacement = pool->n_workers - 1;
+    for (guint i = 0; i < pool->n_dests; i++) {
+        OutputDest *other = pool->dests[i];
+        if (g_atomic_int_get(&other->home) == (gint)w->index) g_atomic_int_set(&other->home, replacement);
+    }
+    g_print("Output: %s blocked its worker; it keeps that thread and worker %d takes its place\n", dest->name,
+            replacement);
+}
+
+// After queuing: wake a sleeper only when no pool worker is awake to find the work, or when the
+// awake ones are all inside a slow push; detach workers stuck in a blocked sink
+static void wake_workers(OutputPool *pool)
+{
+    gint64 now_us = g_get_monotonic_time();
+    gboolean slow = FALSE;
+    guint n_workers = (guint)g_atomic_int_get(&pool->n_workers);
+    for (guint i = 0; i < n_workers; i++) {
+        Worker *w = &pool->workers[i];
+        if (g_atomic_int_get(&w->detached)) continue;
+        gint64 start_us = __atomic_load_n(&w->push_start_us, __ATOMIC_SEQ_CST);
+        if (start_us <= 0) continue;
+        if (now_us - start_us > BLOCKED_PUSH_US) {
+            detach_worker(pool, w, start_us);
+        } else if (now_us - start_us > SLOW_PUSH_US) {
+            slow = TRUE;
+        }
+    }
+
+    if (g_atomic_int_get(&pool->active) == 0 || (slow && g_atomic_int_get(&pool->spinning) == 0)) wake_one(pool);
+}
+
+OutputDest *output_pool_add_dest(OutputPool *pool, GstPad *sinkpad, const char *name, guint max_buffers,
+                                 guint64 max_bytes)
+{
+    if (pool->n_dests >= MAX_DESTS) return NULL;
+
+    // One more worker per destination until max_workers; the pool is useless without the first
+    if ((guint)pool->n_workers < pool->max_workers) start_worker(pool);
+    if (pool->n_workers == 0) return NULL;
+
+    OutputDest *dest = g_new0(OutputDest, 1);
+    snprintf(dest->name, sizeof(dest->name), "%s", name);
+    pthread_mutex_init(&dest->lock, NULL);
+    pthread_cond_init(&dest->cond, NULL);
+    dest->capacity = max_buffers > 0 ? max_buffers : 1;
+    dest->ring = g_new0(GstMiniObject *, dest->capacity);
+    dest->max_bytes = max_bytes;
+    dest->home = (gint)(pool->n_dests % (guint)pool->n_workers);
+    while (pool->workers[dest->home].detached) dest->home = (dest->home + 1) % pool->n_workers;
+
+    dest->pad = gst_pad_new(name, GST_PAD_SRC);
+    gst_pad_set_active(dest->pad, TRUE);
+    if (gst_pad_link(dest->pad, sinkpad) != GST_PAD_LINK_OK) {
+        g_printerr("Output: Failed to link %s\n", name);
+        gst_pad_set_active(dest->pad, FALSE);
+        gst_object_unref(dest->pad);
+        g_free(dest->ring);
+        pthread_cond_destroy(&dest->cond);
+        pthread_mutex_destroy(&dest->lock);
+        g_free(dest);
+        return NULL;
+    }
+
+    // Sticky events stay pending on our pad and reach the sink with the first buffer
+    gst_pad_push_event(dest->pad, gst_event_new_stream_start(name));
+    GstSegment segment;
+    gst_segment_init(&segment, GST_FORMAT_TIME);
+    gst_pad_push_event(dest->pad, gst_event_new_segment(&segment));
+
+    pool->dests[pool->n_dests++] = dest;
+    return dest;
+}
+
+// One wakeup decision per buffer for all destinations, not one per destination
+void output_pool_push(OutputPool *pool, GstBuffer *buffer)
+{
+    for (guint i = 0; i < pool->n_dests; i++) {
+        dest_enqueue(pool->dests[i], GST_MINI_OBJECT_CAST(gst_buffer_ref(buffer)));
+        schedule_dest(pool, pool->dests[i]);
+    }
+    wake_workers(pool);
+}
+
+void output_pool_push_list(OutputPool *pool, GstBufferList *list)
+{
+    for (guint i = 0; i < pool->n_dests; i++) {
+        dest_enqueue(pool->dests[i], GST_MINI_OBJECT_CAST(gst_buffer_list_ref(list)));
+        schedule_dest(pool, pool->dests[i]);
+    }
+    wake_workers(pool);
+}
+
+void output_pool_add_stats(OutputPool *pool, cJSON *root)
+{
+    gint n_workers = g_atomic_int_get(&pool->n_workers), dedicated = 0;
+    for (gint i = 0; i < n_workers; i++) dedicated += g_atomic_int_get(&pool->workers[i].detached);
+    cJSON_AddNumberToObject(root, "output-workers", n_workers - dedicated);
+    cJSON_AddNumberToObject(root, "output-dedicated-threads", dedicated);
+    cJSON *queues = cJSON_AddArrayToObject(root, "output-queues");
+
+    for (guint i = 0; i < pool->n_dests; i++) {
+        OutputDest *dest = pool->dests[i];
+        cJSON *queue = cJSON_CreateObject();
+
+        pthread_mutex_lock(&dest->lock);
+        cJSON_AddStringToObject(queue, "name", dest->name);
+        cJSON_AddNumberToObject(queue, "queued-buffers", (double)dest->buffers);
+        cJSON_AddNumberToObject(queue, "queued-bytes", (double)dest->bytes);
+        cJSON_AddNumberToObject(queue, "high-water-buffers", (double)dest->high_buffers);
+        cJSON_AddNumberToObject(queue, "high-water-bytes", (double)dest->high_bytes);
+        cJSON_AddNumberToObject(queue, "fill-percent", dest->max_bytes ? 100.0 * dest->bytes / dest->max_bytes : 0.0);
+        dest->high_buffers = dest->buffers;
+        dest->high_bytes = dest->bytes;
+        cJSON_AddNumberToObject(queue, "dropped-buffers", (double)dest->dropped);
+        cJSON_AddNumberToObject(queue, "pushed-buffers", (double)dest->pushed);
+        cJSON_AddNumberToObject(queue, "push-errors", (double)dest->push_errors);
+        cJSON_AddBoolToObject(queue, "dedicated-thread", g_atomic_int_get(&dest->dedicated));
+        pthread_mutex_unlock(&dest->lock);
+
+        cJSON_AddItemToArray(queues, queue);
+    }
+}
+
+void output_pool_free(OutputPool *pool)
+{
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->idle_lock);
+    g_atomic_int_set(&pool->stopping, TRUE);
+    pthread_cond_broadcast(&pool->idle_cond);
+    pthread_mutex_unlock(&pool->idle_lock);
+    for (guint i = 0; i < pool->n_dests; i++) {
+        pthread_mutex_lock(&pool->dests[i]->lock);
+        pthread_cond_broadcast(&pool->dests[i]->cond);
+        pthread_mutex_unlock(&pool->dests[i]->lock);
+    }
+
+    // Workers still running steal from the run queues of those already joined
+    for (guint i = 0; i < (guint)pool->n_workers; i++) pthread_join(pool->workers[i].thread, NULL);
+    for (guint i = 0; i < (guint)pool->n_workers; i++) pthread_mutex_destroy(&pool->workers[i].lock);
+
+    for (guint i = 0; i < pool->n_dests; i++) {
+        OutputDest *dest = pool->dests[i];
+        while (dest->len > 0) {
+            gst_mini_object_unref(dest->ring[dest->head]);
+            dest->head = (dest->head + 1) % dest->capacity;
+            dest->len--;
+        }
+
+        GstPad *peer = gst_pad_get_peer(dest->pad);
+        if (peer) {
+            gst_pad_unlink(dest->pad, peer);
+            gst_object_unref(peer);
+        }
+        gst_pad_set_active(dest->pad, FALSE);
+        gst_object_unref(dest->pad);
+
+        g_free(dest->ring);
+        pthread_cond_destroy(&dest->cond);
+        pthread_mutex_destroy(&dest->lock);
+        g_free(dest);
+    }
+
+    pthread_cond_destroy(&pool->idle_cond);
+    pthread_mutex_destroy(&pool->idle_lock);
+    g_free(pool);
+}
@@ -0,0 +1,265 @@
+#include "pacer.h"
+
+#include "ts_pacer.h"
+
+struct _BgPacer {
+    GstElement parent;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+
+    // Protects everything below; `cond` is signalled when packets are scheduled or sent and on flush
+    GMutex lock;
+    GCond cond;
+    TsPacer *pacer;
+    gboolean flushing;
+    GstFlowReturn srcresult;
+};
+
+G_DEFINE_TYPE(BgPacer, bg_pacer, GST_TYPE_ELEMENT)
+
+static GstStaticPadTemplate sink_template =
+    GST_STATIC_PAD_TEMPLATE("sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate src_template =
+    GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+// =============================================================================
+// Streaming
+// =============================================================================
+
+// Schedule one buffer; called with the lock held
+static void schedule_buffer(BgPacer *self, GstBuffer *buffer, gint64 now)
+{
+    GstMapInfo map;
+    if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) return;
+    ts_pacer_push(self->pacer, map.data, map.size, now);
+    gst_buffer_unmap(buffer, &map);
+}
+
+// Errors from the source pad task are reported upstream; a missing sink link is not an error
+static GstFlowReturn upstream_result(BgPacer *self)
+{
+    GstFlowReturn ret = self->flushing ? GST_FLOW_FLUSHING : self->srcresult;
+    return ret == GST_FLOW_NOT_LINKED ? GST_FLOW_OK : ret;
+}
+
+static GstFlowReturn bg_pacer_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    (void)pad;
+    BgPacer *self = BG_PACER(parent);
+    if (!self->pacer) return gst_pad_push(self->srcpad, buffer);
+
+    g_mutex_lock(&self->lock);
+    GstFlowReturn ret = upstream_result(self);
+    if (ret == GST_FLOW_OK) {
+        schedule_buffer(self, buffer, g_get_monotonic_time());
+        g_cond_broadcast(&self->cond);
+    }
+    g_mutex_unlock(&self->lock);
+
+    gst_buffer_unref(buffer);
+    return ret;
+}
+
+static GstFlowReturn bg_pacer_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+    (void)pad;
+    BgPacer *self = BG_PACER(parent);
+    if (!self->pacer) return gst_pad_push_list(self->srcpad, list);
+
+    g_mutex_lock(&self->lock);
+    GstFlowReturn ret = upstream_result(self);
+    if (ret == GST_FLOW_OK) {
+        gint64 now = g_get_monotonic_time();
+        guint n = gst_buffer_list_length(list);
+        for (guint i = 0; i < n; i++) schedule_buffer(self, gst_buffer_list_get(list, i), now);
+        g_cond_broadcast(&self->cond);
+    }
+    g_mutex_unlock(&self->lock);
+
+    gst_buffer_list_unref(list);
+    return ret;
+}
+
+// Source pad task: sleep until the next departure, then push the packets that are due
+static void bg_pacer_loop(gpointer user_data)
+{
+    BgPacer *self = BG_PACER(user_data);
+    gint64 now = 0;
+
+    g_mutex_lock(&self->lock);
+    while (!self->flushing) {
+        gint64 due = self->pacer ? ts_pacer_next_departure(self->pacer) : -1;
+        now = g_get_monotonic_time();
+        if (due < 0) {
+            g_cond_wait(&self->cond, &self->lock);
+        } else if (due > now) {
+            g_cond_wait_until(&self->cond, &self->lock, due);
+        } else {
+            break;
+        }
+    }
+    if (self->flushing) {
+        g_mutex_unlock(&self->lock);
+        gst_pad_pause_task(self->srcpad);
+        return;
+    }
+
+    GByteArray *out = g_byte_array_sized_new(64 * TS_PACKET_SIZE);
+    ts_pacer_pop(self->pacer, out, now);
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    if (out->len == 0) {
+        g_byte_array_free(out, TRUE);
+        return;
+    }
+    gsize len = out->len;
+    GstBuffer *buffer = gst_buffer_new_wrapped(g_byte_array_free(out, FALSE), len);
+    GstFlowReturn ret = gst_pad_push(self->srcpad, buffer);
+    if (ret != GST_FLOW_OK && ret != GST_FLOW_NOT_LINKED) {
+        g_mutex_lock(&self->lock);
+        self->srcresult = ret;
+        g_mutex_unlock(&self->lock);
+        gst_pad_pause_task(self->srcpad);
+    }
+}
+
+static gboolean bg_pacer_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
+{
+    BgPacer *self = BG_PACER(parent);
+
+    switch (GST_EVENT_TYPE(event)) {
+        case GST_EVENT_FLUSH_START: {
+            g_mutex_lock(&self->lock);
+            self->flushing = TRUE;
+            g_cond_broadcast(&self->cond);
+            g_mutex_unlock(&self->lock);
+            gboolean res = gst_pad_push_event(self->srcpad, event);
+            gst_pad_pause_task(self->srcpad);
+            return res;
+        }
+        case GST_EVENT_FLUSH_STOP: {
+            g_mutex_lock(&self->lock);
+            if (self->pacer) ts_pacer_reset(self->pacer);
+            self->flushing = FALSE;
+            self->srcresult = GST_FLOW_OK;
+            g_mutex_unlock(&self->lock);
+            gboolean res = gst_pad_push_event(self->srcpad, event);
+            gst_pad_start_task(self->srcpad, bg_pacer_loop, self, NULL);
+            return res;
+        }
+        default:
+            break;
+    }
+
+    // Other serialized events (EOS, segment) must not overtake the packets still scheduled
+    if (GST_EVENT_IS_SERIALIZED(event) && self->pacer) {
+        g_mutex_lock(&self->lock);
+        while (!self->flushing && self->srcresult == GST_FLOW_OK && ts_pacer_next_departure(self->pacer) >= 0) {
+            g_cond_wait(&self->cond, &self->lock);
+        }
+        g_mutex_unlock(&self->lock);
+    }
+    return gst_pad_event_default(pad, parent, event);
+}
+
+static gboolean bg_pacer_src_activate_mode(GstPad *pad, GstObject *parent, GstPadMode mode, gboolean active)
+{
+    BgPacer *self = BG_PACER(parent);
+    if (mode != GST_PAD_MODE_PUSH) return FALSE;
+
+    g_mutex_lock(&self->lock);
+    self->flushing = !active;
+    self->srcresult = active ? GST_FLOW_OK : GST_FLOW_FLUSHING;
+    if (!active && self->pacer) ts_pacer_reset(self->pacer);
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+
+    return active ? gst_pad_start_task(pad, bg_pacer_loop, self, NULL) : gst_pad_stop_task(pad);
+}
+
+// =============================================================================
+// GObject
+// =============================================================================
+
+static void bg_pacer_finalize(GObject *object)
+{
+    BgPacer *self = BG_PACER(object);
+
+    ts_pacer_free(self->pacer);
+    g_cond_clear(&self->cond);
+    g_mutex_clear(&self->lock);
+
+    G_OBJECT_CLASS(bg_pacer_parent_class)->finalize(object);
+}
+
+static void bg_pacer_class_init(BgPacerClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+
+    gobject_class->finalize = bg_pacer_finalize;
+
+    gst_element_class_set_static_metadata(element_class, "TS PCR pacer", "Filter/Network",
+                                          "Sends MPEG-TS packets at the rate given by their PCRs", "Blackgate");
+    gst_element_class_add_static_pad_template(element_class, &sink_template);
+    gst_element_class_add_static_pad_template(element_class, &src_template);
+}
+
+static void bg_pacer_init(BgPacer *self)
+{
+    g_mutex_init(&self->lock);
+    g_cond_init(&self->cond);
+    self->flushing = TRUE;
+    self->srcresult = GST_FLOW_FLUSHING;
+
+    self->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+    gst_pad_set_chain_function(self->sinkpad, bg_pacer_chain);
+    gst_pad_set_chain_list_function(self->sinkpad, bg_pacer_chain_list);
+    gst_pad_set_event_function(self->sinkpad, bg_pacer_sink_event);
+    GST_PAD_SET_PROXY_CAPS(self->sinkpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->sinkpad);
+
+    self->srcpad = gst_pad_new_from_static_template(&src_template, "src");
+    gst_pad_set_activatemode_function(self->srcpad, bg_pacer_src_activate_mode);
+    GST_PAD_SET_PROXY_CAPS(self->srcpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->srcpad);
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+gboolean pacer_register(void)
+{
+    return gst_element_register(NULL, "bgpacer", GST_RANK_NONE, BG_TYPE_PACER);
+}
+
+gboolean pacer_configure(GstElement *pacer, cJSON *config)
+{
+    BgPacer *self = BG_PACER(pacer);
+    TsPacer *ts_pacer = ts_pacer_new(config);
+    if (!ts_pacer) return FALSE;
+
+    g_mutex_lock(&self->lock);
+    TsPacer *old = self->pacer;
+    self->pacer = ts_pacer;
+    g_cond_broadcast(&self->cond);
+    g_mutex_unlock(&self->lock);
+    ts_pacer_free(old);
+    return TRUE;
+}
+
+void pacer_add_stats(GstElement *pacer, cJSON *parent)
+{
+    BgPacer *self = BG_PACER(pacer);
+    TsPacerStats stats;
+
+    g_mutex_lock(&self->lock);
+    gboolean have = self->pacer != NULL;
+    if (have) ts_pacer_get_stats(self->pacer, &stats);
+    g_mutex_unlock(&self->lock);
+
+    if (have) ts_pacer_stats_to_json(&stats, parent);
+}
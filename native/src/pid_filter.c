@@ -0,0 +1,154 @@
+#include "pid_filter.h"
+
+#include "ts_filter.h"
+
+struct _BgPidFilter {
+    GstElement parent;
+
+    GstPad *sinkpad;
+    GstPad *srcpad;
+
+    // Held while a buffer is filtered and while the stats thread reads the counters
+    GMutex lock;
+    TsFilter *filter;
+};
+
+G_DEFINE_TYPE(BgPidFilter, bg_pid_filter, GST_TYPE_ELEMENT)
+
+static GstStaticPadTemplate sink_template =
+    GST_STATIC_PAD_TEMPLATE("sink", GST_PAD_SINK, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+static GstStaticPadTemplate src_template =
+    GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS, GST_STATIC_CAPS_ANY);
+
+// The kept packets of `in` as a new buffer, or NULL if nothing was kept
+static GstBuffer *filter_buffer(BgPidFilter *self, GstBuffer *in)
+{
+    GstMapInfo map;
+    if (!gst_buffer_map(in, &map, GST_MAP_READ)) return NULL;
+
+    GByteArray *out = g_byte_array_sized_new((guint)map.size + TS_PACKET_SIZE);
+    g_mutex_lock(&self->lock);
+    ts_filter_process(self->filter, map.data, map.size, out);
+    g_mutex_unlock(&self->lock);
+    gst_buffer_unmap(in, &map);
+
+    if (out->len == 0) {
+        g_byte_array_free(out, TRUE);
+        return NULL;
+    }
+
+    gsize len = out->len;
+    GstBuffer *buffer = gst_buffer_new_wrapped(g_byte_array_free(out, FALSE), len);
+    GST_BUFFER_PTS(buffer) = GST_BUFFER_PTS(in);
+    GST_BUFFER_DTS(buffer) = GST_BUFFER_DTS(in);
+    return buffer;
+}
+
+static GstFlowReturn bg_pid_filter_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    (void)pad;
+    BgPidFilter *self = BG_PID_FILTER(parent);
+
+    GstBuffer *out = self->filter ? filter_buffer(self, buffer) : gst_buffer_ref(buffer);
+    gst_buffer_unref(buffer);
+    return out ? gst_pad_push(self->srcpad, out) : GST_FLOW_OK;
+}
+
+static GstFlowReturn bg_pid_filter_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+    (void)pad;
+    BgPidFilter *self = BG_PID_FILTER(parent);
+    if (!self->filter) return gst_pad_push_list(self->srcpad, list);
+
+    guint n = gst_buffer_list_length(list);
+    GstBufferList *out = gst_buffer_list_new_sized(n);
+    for (guint i = 0; i < n; i++) {
+        GstBuffer *buffer = filter_buffer(self, gst_buffer_list_get(list, i));
+        if (buffer) gst_buffer_list_add(out, buffer);
+    }
+    gst_buffer_list_unref(list);
+
+    if (gst_buffer_list_length(out) == 0) {
+        gst_buffer_list_unref(out);
+        return GST_FLOW_OK;
+    }
+    return gst_pad_push_list(self->srcpad, out);
+}
+
+static void bg_pid_filter_finalize(GObject *object)
+{
+    BgPidFilter *self = BG_PID_FILTER(object);
+
+    ts_filter_free(self->filter);
+    g_mutex_clear(&self->lock);
+
+    G_OBJECT_CLASS(bg_pid_filter_parent_class)->finalize(object);
+}
+
+static void bg_pid_filter_class_init(BgPidFilterClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS(klass);
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+
+    gobject_class->finalize = bg_pid_filter_finalize;
+
+    gst_element_class_set_static_metadata(element_class, "TS program/PID filter", "Filter/Network",
+                                          "Keeps selected MPEG-TS programs or PIDs and rewrites the PAT/PMT",
+                                          "Blackgate");
+    gst_element_class_add_static_pad_template(element_class, &sink_template);
+    gst_element_class_add_static_pad_template(element_class, &src_template);
+}
+
+static void bg_pid_filter_init(BgPidFilter *self)
+{
+    g_mutex_init(&self->lock);
+
+    self->sinkpad = gst_pad_new_from_static_template(&sink_template, "sink");
+    gst_pad_set_chain_function(self->sinkpad, bg_pid_filter_chain);
+    gst_pad_set_chain_list_function(self->sinkpad, bg_pid_filter_chain_list);
+    GST_PAD_SET_PROXY_CAPS(self->sinkpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->sinkpad);
+
+    self->srcpad = gst_pad_new_from_static_template(&src_template, "src");
+    GST_PAD_SET_PROXY_CAPS(self->srcpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->srcpad);
+}
+
+gboolean pid_filter_register(void)
+{
+    return gst_element_register(NULL, "bgpidfilter", GST_RANK_NONE, BG_TYPE_PID_FILTER);
+}
+
+gboolean pid_filter_configure(GstElement *filter, cJSON *config)
+{
+    BgPidFilter *self = BG_PID_FILTER(filter);
+    TsFilter *ts_filter = ts_filter_new(config);
+    if (!ts_filter) return FALSE;
+
+    g_mutex_lock(&self->lock);
+    TsFilter *old = self->filter;
+    self->filter = ts_filter;
+    g_mutex_unlock(&self->lock);
+    ts_filter_free(old);
+    return TRUE;
+}
+
+void pid_filter_add_stats(GstElement *filter, int sink_index, cJSON *array)
+{
+    BgPidFilter *self = BG_PID_FILTER(filter);
+    TsFilterStats stats = {0};
+
+    g_mutex_lock(&self->lock);
+    if (self->filter) ts_filter_get_stats(self->filter, &stats);
+    g_mutex_unlock(&self->lock);
+
+    cJSON *entry = cJSON_CreateObject();
+    cJSON_AddNumberToObject(entry, "sink", sink_index);
+    cJSON_AddNumberToObject(entry, "programs", stats.programs);
+    cJSON_AddNumberToObject(entry, "pids", stats.pids);
+    cJSON_AddNumberToObject(entry, "packets-in", (double)stats.packets_in);
+    cJSON_AddNumberToObject(entry, "packets-out", (double)stats.packets_out);
+    cJSON_AddNumberToObject(entry, "psi-rewrites", (double)stats.psi_rewrites);
+    cJSON_AddNumberToObject(entry, "crc-errors", (double)stats.crc_errors);
+    cJSON_AddItemToArray(array, entry);
+}
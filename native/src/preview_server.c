@@ -0,0 +1,345 @@
+#define _GNU_SOURCE
+#include "preview_server.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "thread_policy.h"
+
+#define POLL_TIMEOUT_MS 500
+
+typedef struct {
+    int fd;
+    GBytes *frame; // Part being sent, NULL when idle
+    gsize offset;
+    guint64 seq; // Of the last frame taken
+} Viewer;
+
+struct PreviewServer {
+    char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+    guint fps;
+    gint quality;
+    guint max_viewers;
+
+    int listen_fd;
+    int wake_fds[2]; // publish → server thread
+    pthread_t thread;
+    volatile gboolean running;
+
+    // Server thread only
+    Viewer *viewers;
+    guint viewer_count;
+    struct pollfd *pfds;
+
+    pthread_mutex_t lock;
+    GBytes *part; // Newest frame as a complete multipart part
+    gsize jpeg_offset;
+    gsize jpeg_len;
+    guint64 seq; // Frames published
+    gint64 published_us;
+    PreviewServerStats stats;
+};
+
+static gboolean parse_config(PreviewServer *server, cJSON *config)
+{
+    server->fps = PREVIEW_SERVER_DEFAULT_FPS;
+    server->quality = PREVIEW_SERVER_DEFAULT_QUALITY;
+    server->max_viewers = PREVIEW_SERVER_DEFAULT_MAX_VIEWERS;
+    if (!config || cJSON_IsTrue(config)) return TRUE;
+    if (!cJSON_IsObject(config)) return FALSE;
+
+    cJSON *fps = cJSON_GetObjectItem(config, "fps");
+    cJSON *quality = cJSON_GetObjectItem(config, "quality");
+    cJSON *max_viewers = cJSON_GetObjectItem(config, "max-viewers");
+    if (fps) {
+        if (!cJSON_IsNumber(fps) || fps->valueint < 1 || fps->valueint > PREVIEW_SERVER_MAX_FPS) return FALSE;
+        server->fps = (guint)fps->valueint;
+    }
+    if (quality) {
+        if (!cJSON_IsNumber(quality) || quality->valueint < 1 || quality->valueint > 100) return FALSE;
+        server->quality = quality->valueint;
+    }
+    if (max_viewers) {
+        if (!cJSON_IsNumber(max_viewers) || max_viewers->valueint < 1 ||
+            max_viewers->valueint > PREVIEW_SERVER_MAX_VIEWERS) {
+            return FALSE;
+        }
+        server->max_viewers = (guint)max_viewers->valueint;
+    }
+    return TRUE;
+}
+
+static void drop_viewer(PreviewServer *server, guint i)
+{
+    close(server->viewers[i].fd);
+    if (server->viewers[i].frame) g_bytes_unref(server->viewers[i].frame);
+    server->viewers[i] = server->viewers[--server->viewer_count];
+}
+
+static void accept_viewers(PreviewServer *server, PreviewServerStats *delta)
+{
+    for (;;) {
+        int fd = accept4(server->listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return;
+        if (server->viewer_count >= server->max_viewers) {
+            close(fd);
+            delta->viewers_refused++;
+            continue;
+        }
+        server->viewers[server->viewer_count++] = (Viewer){.fd = fd};
+        delta->viewers_total++;
+    }
+}
+
+// Viewers only ever send to hang up; anything they send is discarded. FALSE once the viewer is gone.
+static gboolean drain_viewer(int fd)
+{
+    char buf[256];
+    for (;;) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n > 0) continue;
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+}
+
+// Send as much of the viewer's frames as the socket takes, moving on to the newest frame after each
+// one; FALSE if the viewer is gone
+static gboolean serve_viewer(Viewer *viewer, GBytes *latest, guint64 latest_seq, PreviewServerStats *delta)
+{
+    for (;;) {
+        if (!viewer->frame) {
+            if (!latest || viewer->seq >= latest_seq) return TRUE;
+            if (viewer->seq > 0) delta->frames_skipped += latest_seq - viewer->seq - 1;
+            viewer->frame = g_bytes_ref(latest);
+            viewer->offset = 0;
+            viewer->seq = latest_seq;
+        }
+
+        gsize size = 0;
+        const guint8 *data = g_bytes_get_data(viewer->frame, &size);
+        ssize_t n = send(viewer->fd, data + viewer->offset, size - viewer->offset, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+        viewer->offset += (gsize)n;
+        delta->bytes_sent += (guint64)n;
+        if (viewer->offset < size) return TRUE;
+
+        g_bytes_unref(viewer->frame);
+        viewer->frame = NULL;
+        delta->frames_sent++;
+    }
+}
+
+static void *server_thread(void *arg)
+{
+    PreviewServer *server = arg;
+    thread_policy_apply_self(THREAD_ROLE_ANALYSIS, "preview");
+
+    while (server->running) {
+        // [0] wake-up, [1] listener, then one per viewer; write interest only while a frame is pending
+        server->pfds[0] = (struct pollfd){.fd = server->wake_fds[0], .events = POLLIN};
+        server->pfds[1] = (struct pollfd){.fd = server->listen_fd, .events = POLLIN};
+        for (guint i = 0; i < server->viewer_count; i++) {
+            short events = POLLIN | (server->viewers[i].frame ? POLLOUT : 0);
+            server->pfds[2 + i] = (struct pollfd){.fd = server->viewers[i].fd, .events = events};
+        }
+        guint polled = server->viewer_count;
+        if (poll(server->pfds, 2 + polled, POLL_TIMEOUT_MS) < 0 && errno != EINTR) break;
+
+        if (server->pfds[0].revents & POLLIN) {
+            char buf[64];
+            while (read(server->wake_fds[0], buf, sizeof(buf)) > 0) {
+            }
+        }
+
+        pthread_mutex_lock(&server->lock);
+        GBytes *latest = server->part ? g_bytes_ref(server->part) : NULL;
+        guint64 latest_seq = server->seq;
+        pthread_mutex_unlock(&server->lock);
+
+        PreviewServerStats delta = {0};
+        // Backwards, so dropping a viewer (moving the last one into its slot) leaves the rest in place
+        for (guint i = polled; i-- > 0;) {
+            short revents = server->pfds[2 + i].revents;
+            gboolean alive = !(revents & (POLLERR | POLLNVAL));
+            if (alive && (revents & (POLLIN | POLLHUP))) alive = drain_viewer(server->viewers[i].fd);
+            if (alive) alive = serve_viewer(&server->viewers[i], latest, latest_seq, &delta);
+            if (!alive) drop_viewer(server, i);
+        }
+        if (server->pfds[1].revents & POLLIN) {
+            guint first = server->viewer_count;
+            accept_viewers(server, &delta);
+            // New viewers start with the newest frame straight away
+            for (guint i = server->viewer_count; i-- > first;) {
+                if (!serve_viewer(&server->viewers[i], latest, latest_seq, &delta)) drop_viewer(server, i);
+            }
+        }
+        if (latest) g_bytes_unref(latest);
+
+        pthread_mutex_lock(&server->lock);
+        server->stats.viewers = server->viewer_count;
+        server->stats.viewers_total += delta.viewers_total;
+        server->stats.viewers_refused += delta.viewers_refused;
+        server->stats.frames_sent += delta.frames_sent;
+        server->stats.frames_skipped += delta.frames_skipped;
+        server->stats.bytes_sent += delta.bytes_sent;
+        pthread_mutex_unlock(&server->lock);
+    }
+
+    while (server->viewer_count > 0) drop_viewer(server, server->viewer_count - 1);
+    thread_policy_forget_self();
+    return NULL;
+}
+
+static int listen_on(const char *path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    unlink(path); // A socket left behind by a pipeline that did not exit cleanly
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+PreviewServer *preview_server_new(cJSON *config, const char *path)
+{
+    PreviewServer *server = g_new0(PreviewServer, 1);
+    if (!parse_config(server, config)) {
+        g_printerr("Preview: invalid 'preview' config\n");
+        g_free(server);
+        return NULL;
+    }
+
+    server->listen_fd = listen_on(path);
+    if (server->listen_fd < 0) {
+        g_printerr("Preview: cannot listen on %s: %s\n", path, strerror(errno));
+        g_free(server);
+        return NULL;
+    }
+    if (pipe2(server->wake_fds, O_NONBLOCK | O_CLOEXEC) < 0) {
+        g_printerr("Preview: cannot create wake-up pipe: %s\n", strerror(errno));
+        close(server->listen_fd);
+        unlink(path);
+        g_free(server);
+        return NULL;
+    }
+    g_strlcpy(server->path, path, sizeof(server->path));
+    server->viewers = g_new0(Viewer, server->max_viewers);
+    server->pfds = g_new0(struct pollfd, server->max_viewers + 2);
+    server->stats.frame_age_ms = -1;
+    pthread_mutex_init(&server->lock, NULL);
+
+    server->running = TRUE;
+    if (pthread_create(&server->thread, NULL, server_thread, server) != 0) {
+        g_printerr("Preview: cannot start server thread\n");
+        server->running = FALSE;
+        preview_server_free(server);
+        return NULL;
+    }
+    g_print("Preview: serving MJPEG at %u fps on %s (up to %u viewers)\n", server->fps, path, server->max_viewers);
+    return server;
+}
+
+void preview_server_free(PreviewServer *server)
+{
+    if (!server) return;
+    if (server->running) {
+        server->running = FALSE;
+        if (write(server->wake_fds[1], "x", 1) < 0) {
+            // Full pipe: the thread is woken anyway
+        }
+        pthread_join(server->thread, NULL);
+    }
+    close(server->listen_fd);
+    close(server->wake_fds[0]);
+    close(server->wake_fds[1]);
+    unlink(server->path);
+    if (server->part) g_bytes_unref(server->part);
+    pthread_mutex_destroy(&server->lock);
+    g_free(server->viewers);
+    g_free(server->pfds);
+    g_free(server);
+}
+
+guint preview_server_fps(const PreviewServer *server)
+{
+    return server->fps;
+}
+
+gint preview_server_quality(const PreviewServer *server)
+{
+    return server->quality;
+}
+
+void preview_server_publish(PreviewServer *server, const guint8 *jpeg, gsize len)
+{
+    char header[128];
+    int header_len = snprintf(header, sizeof(header),
+                              "--" PREVIEW_SERVER_BOUNDARY "\r\n"
+                              "Content-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n",
+                              len);
+    gsize size = (gsize)header_len + len + 2;
+    guint8 *part = g_malloc(size);
+    memcpy(part, header, (gsize)header_len);
+    memcpy(part + header_len, jpeg, len);
+    memcpy(part + header_len + len, "\r\n", 2);
+    GBytes *bytes = g_bytes_new_take(part, size);
+
+    pthread_mutex_lock(&server->lock);
+    GBytes *old = server->part;
+    server->part = bytes;
+    server->jpeg_offset = (gsize)header_len;
+    server->jpeg_len = len;
+    server->seq++;
+    server->stats.frames++;
+    server->published_us = g_get_monotonic_time();
+    pthread_mutex_unlock(&server->lock);
+
+    // Viewers still sending it hold their own reference
+    if (old) g_bytes_unref(old);
+    if (write(server->wake_fds[1], "x", 1) < 0) {
+        // Full pipe: a wake-up is already pending
+    }
+}
+
+GBytes *preview_server_latest(PreviewServer *server)
+{
+    pthread_mutex_lock(&server->lock);
+    GBytes *jpeg = server->part ? g_bytes_new_from_bytes(server->part, server->jpeg_offset, server->jpeg_len) : NULL;
+    pthread_mutex_unlock(&server->lock);
+    return jpeg;
+}
+
+void preview_server_get_stats(PreviewServer *server, PreviewServerStats *stats)
+{
+    pthread_mutex_lock(&server->lock);
+    *stats = server->stats;
+    stats->frame_age_ms = server->seq > 0 ? (g_get_monotonic_time() - server->published_us) / 1000 : -1;
+    pthread_mutex_unlock(&server->lock);
+}
+
+void preview_server_stats_to_json(const PreviewServer *server, const PreviewServerStats *stats, cJSON *root)
+{
+    cJSON *obj = cJSON_AddObjectToObject(root, "preview");
+    cJSON_AddNumberToObject(obj, "fps", server->fps);
+    cJSON_AddNumberToObject(obj, "viewers", stats->viewers);
+    cJSON_AddNumberToObject(obj, "viewers-total", (double)stats->viewers_total);
+    cJSON_AddNumberToObject(obj, "viewers-refused", (double)stats->viewers_refused);
+    cJSON_AddNumberToObject(obj, "frames", (double)stats->frames);
+    cJSON_AddNumberToObject(obj, "frames-sent", (double)stats->frames_sent);
+    cJSON_AddNumberToObject(obj, "frames-skipped", (double)stats->frames_skipped);
+    cJSON_AddNumberToObject(obj, "bytes-sent", (double)stats->bytes_sent);
+    cJSON_AddNumberToObject(obj, "frame-age-ms", (double)stats->frame_age_ms);
+}
@@ -0,0 +1,79 @@
+#include "queue_telemetry.h"
+
+#include <string.h>
+
+static void level_max(QueueLevel *acc, const QueueLevel *level)
+{
+    acc->bytes = MAX(acc->bytes, level->bytes);
+    acc->buffers = MAX(acc->buffers, level->buffers);
+    acc->time_ns = MAX(acc->time_ns, level->time_ns);
+}
+
+// Fill of the most constrained limited dimension, 0 if the queue is unlimited
+static gdouble level_percent(const QueueLevel *level, const QueueLevel *limit)
+{
+    gdouble percent = 0.0;
+    if (limit->bytes) percent = MAX(percent, 100.0 * (gdouble)level->bytes / (gdouble)limit->bytes);
+    if (limit->buffers) percent = MAX(percent, 100.0 * (gdouble)level->buffers / (gdouble)limit->buffers);
+    if (limit->time_ns) percent = MAX(percent, 100.0 * (gdouble)level->time_ns / (gdouble)limit->time_ns);
+    return MIN(percent, 100.0);
+}
+
+void queue_telemetry_init(QueueTelemetry *t, const QueueLevel *limit, gint64 now_us)
+{
+    memset(t, 0, sizeof(*t));
+    t->limit = *limit;
+    t->window_start_us = now_us;
+}
+
+void queue_telemetry_sample(QueueTelemetry *t, const QueueLevel *level)
+{
+    t->current = *level;
+    level_max(&t->high, level);
+    level_max(&t->peak, level);
+
+    // A sample within one buffer's worth of a limit would not have admitted another
+    gboolean full = level_percent(level, &t->limit) >= 99.0;
+    if (full && !t->full) t->full_events++;
+    t->full = full;
+}
+
+void queue_telemetry_drop(QueueTelemetry *t)
+{
+    __atomic_fetch_add(&t->drops, 1, __ATOMIC_RELAXED);
+}
+
+void queue_telemetry_end_window(QueueTelemetry *t, gint64 now_us)
+{
+    gdouble seconds = (gdouble)(now_us - t->window_start_us) / G_USEC_PER_SEC;
+    guint64 drops = __atomic_load_n(&t->drops, __ATOMIC_RELAXED);
+
+    if (seconds > 0) {
+        t->fill_rate = ((gdouble)t->current.bytes - (gdouble)t->window_start_level.bytes) / seconds;
+        t->drop_rate = (gdouble)(drops - t->drops_at_window_start) / seconds;
+    }
+
+    t->window_high = t->high;
+    t->high = t->current;
+    t->window_start_level = t->current;
+    t->drops_at_window_start = drops;
+    t->window_start_us = now_us;
+}
+
+void queue_telemetry_to_json(const QueueTelemetry *t, cJSON *obj)
+{
+    cJSON_AddNumberToObject(obj, "level-bytes", (double)t->current.bytes);
+    cJSON_AddNumberToObject(obj, "level-buffers", (double)t->current.buffers);
+    cJSON_AddNumberToObject(obj, "level-ms", (double)(t->current.time_ns / 1000000));
+    cJSON_AddNumberToObject(obj, "high-water-bytes", (double)t->window_high.bytes);
+    cJSON_AddNumberToObject(obj, "high-water-buffers", (double)t->window_high.buffers);
+    cJSON_AddNumberToObject(obj, "high-water-ms", (double)(t->window_high.time_ns / 1000000));
+    cJSON_AddNumberToObject(obj, "peak-bytes", (double)t->peak.bytes);
+    cJSON_AddNumberToObject(obj, "peak-ms", (double)(t->peak.time_ns / 1000000));
+    cJSON_AddNumberToObject(obj, "fill-percent", level_percent(&t->current, &t->limit));
+    cJSON_AddNumberToObject(obj, "high-water-percent", level_percent(&t->window_high, &t->limit));
+    cJSON_AddNumberToObject(obj, "fill-rate-bytes-per-sec", t->fill_rate);
+    cJSON_AddNumberToObject(obj, "full-events", (double)t->full_events);
+    cJSON_AddNumberToObject(obj, "drops", (double)__atomic_load_n(&t->drops, __ATOMIC_RELAXED));
+    cJSON_AddNumberToObject(obj, "drops-per-sec", t->drop_rate);
+}
@@ -0,0 +1,207 @@
+#include "rtp_reorder.h"
+
+#include <string.h>
+
+// Further back than this is a restarted sender straight away; closer, only once `window` late packets
+// in a row show the stream is not coming back to where it was
+#define RESYNC_DISTANCE 0x4000
+
+typedef struct {
+    gboolean held;
+    guint16 seq;
+    gsize len;
+    gint64 arrival_us;
+} Slot;
+
+struct RtpReorder {
+    guint window;
+    guint mask;
+    gsize max_payload;
+    gint64 max_delay_us;
+
+    Slot *slots;       // Indexed by seq & mask, for sequence numbers in [next, next + window)
+    guint8 *payloads;  // max_payload bytes per slot
+    guint64 seen[65536 / 64]; // One bit per sequence number in the half of the space behind and ahead of next
+
+    gboolean started;
+    guint16 next;    // Next sequence number to release
+    guint16 highest; // Highest sequence number seen
+    guint late_run;  // Late packets in a row
+    RtpReorderStats stats;
+};
+
+static inline gboolean seen_test(const RtpReorder *r, guint16 seq)
+{
+    return (r->seen[seq >> 6] >> (seq & 63)) & 1;
+}
+
+static inline void seen_set(RtpReorder *r, guint16 seq, gboolean on)
+{
+    if (on) {
+        r->seen[seq >> 6] |= G_GUINT64_CONSTANT(1) << (seq & 63);
+    } else {
+        r->seen[seq >> 6] &= ~(G_GUINT64_CONSTANT(1) << (seq & 63));
+    }
+}
+
+// Move past `next`; the sequence number half the space away becomes "ahead" and must be forgotten
+static inline void advance(RtpReorder *r)
+{
+    r->next++;
+    seen_set(r, (guint16)(r->next + 0x8000), FALSE);
+}
+
+static void drain(RtpReorder *r, RtpReorderEmitFunc emit, gpointer user_data)
+{
+    for (;;) {
+        Slot *slot = &r->slots[r->next & r->mask];
+        if (!slot->held || slot->seq != r->next) return;
+        emit(r->payloads + (gsize)(r->next & r->mask) * r->max_payload, slot->len, user_data);
+        slot->held = FALSE;
+        r->stats.held--;
+        r->stats.packets++;
+        advance(r);
+    }
+}
+
+// Give up on everything before `seq`, releasing what is held on the way
+static void skip_to(RtpReorder *r, guint16 seq, RtpReorderEmitFunc emit, gpointer user_data)
+{
+    while (r->next != seq) {
+        Slot *slot = &r->slots[r->next & r->mask];
+        if (slot->held && slot->seq == r->next) {
+            emit(r->payloads + (gsize)(r->next & r->mask) * r->max_payload, slot->len, user_data);
+            slot->held = FALSE;
+            r->stats.held--;
+            r->stats.packets++;
+        } else {
+            r->stats.lost++;
+        }
+        advance(r);
+    }
+}
+
+RtpReorder *rtp_reorder_new(guint window, gsize max_payload, gint64 max_delay_us)
+{
+    if (window < RTP_REORDER_MIN_WINDOW || window > RTP_REORDER_MAX_WINDOW || (window & (window - 1))) {
+        g_printerr("RtpReorder: window must be a power of two between %d and %d\n", RTP_REORDER_MIN_WINDOW,
+                   RTP_REORDER_MAX_WINDOW);
+        return NULL;
+    }
+    RtpReorder *r = g_new0(RtpReorder, 1);
+    r->window = window;
+    r->mask = window - 1;
+    r->max_payload = max_payload;
+    r->max_delay_us = max_delay_us;
+    r->slots = g_new0(Slot, window);
+    r->payloads = g_malloc((gsize)window * max_payload);
+    return r;
+}
+
+void rtp_reorder_free(RtpReorder *r)
+{
+    if (!r) return;
+    g_free(r->slots);
+    g_free(r->payloads);
+    g_free(r);
+}
+
+void rtp_reorder_push(RtpReorder *r, guint16 seq, const guint8 *payload, gsize len, gint64 now_us,
+                      RtpReorderEmitFunc emit, gpointer user_data)
+{
+    if (!r->started) {
+        r->started = TRUE;
+        r->next = seq;
+        r->highest = seq;
+    }
+
+    gint distance = (gint16)(seq - r->next);
+    if (distance < 0) {
+        if (seen_test(r, seq)) {
+            r->stats.duplicates++;
+            return;
+        }
+        if (-distance <= RESYNC_DISTANCE && ++r->late_run < r->window) {
+            r->stats.late++;
+            return;
+        }
+        // Far behind anything we released, or nothing but late packets: the sender started over
+        rtp_reorder_reset(r, emit, user_data);
+        rtp_reorder_push(r, seq, payload, len, now_us, emit, user_data);
+        return;
+    }
+    if (seen_test(r, seq)) {
+        r->stats.duplicates++;
+        return;
+    }
+    r->late_run = 0;
+
+    if ((gint16)(seq - r->highest) < 0) {
+        r->stats.reordered++;
+    } else {
+        r->highest = seq;
+    }
+    // Ahead of the window: give up on the oldest sequence numbers to make room
+    if (distance >= (gint)r->window) {
+        skip_to(r, (guint16)(seq - r->window + 1), emit, user_data);
+        drain(r, emit, user_data);
+    }
+    seen_set(r, seq, TRUE);
+
+    if (seq == r->next) {
+        emit(payload, len, user_data);
+        r->stats.packets++;
+        advance(r);
+        if (r->stats.held) drain(r, emit, user_data);
+        return;
+    }
+
+    Slot *slot = &r->slots[seq & r->mask];
+    slot->held = TRUE;
+    slot->seq = seq;
+    slot->len = MIN(len, r->max_payload);
+    slot->arrival_us = now_us;
+    memcpy(r->payloads + (gsize)(seq & r->mask) * r->max_payload, payload, slot->len);
+    r->stats.held++;
+}
+
+void rtp_reorder_expire(RtpReorder *r, gint64 now_us, RtpReorderEmitFunc emit, gpointer user_data)
+{
+    while (r->stats.held) {
+        guint16 seq = r->next;
+        const Slot *slot = NULL;
+        for (guint i = 1; i < r->window; i++) {
+            seq = (guint16)(r->next + i);
+            const Slot *candidate = &r->slots[seq & r->mask];
+            if (candidate->held && candidate->seq == seq) {
+                slot = candidate;
+                break;
+            }
+        }
+        if (!slot || now_us - slot->arrival_us < r->max_delay_us) return;
+        skip_to(r, seq, emit, user_data);
+        drain(r, emit, user_data);
+    }
+}
+
+void rtp_reorder_reset(RtpReorder *r, RtpReorderEmitFunc emit, gpointer user_data)
+{
+    if (r->started) r->stats.resyncs++;
+    for (guint i = 0; i < r->window && r->stats.held; i++) {
+        guint16 seq = (guint16)(r->next + i);
+        Slot *slot = &r->slots[seq & r->mask];
+        if (!slot->held || slot->seq != seq) continue;
+        emit(r->payloads + (gsize)(seq & r->mask) * r->max_payload, slot->len, user_data);
+        slot->held = FALSE;
+        r->stats.held--;
+        r->stats.packets++;
+    }
+    memset(r->seen, 0, sizeof(r->seen));
+    r->started = FALSE;
+    r->late_run = 0;
+}
+
+void rtp_reorder_get_stats(const RtpReorder *r, RtpReorderStats *stats)
+{
+    *stats = r->stats;
+}
@@ -0,0 +1,304 @@
+#define _GNU_SOURCE
+#include "shared_source.h"
+
+#include <errno.h>
+#include <gst/app/gstappsrc.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "admission.h"
+#include "shm_ring.h"
+#include "thread_policy.h"
+#include "unix_socket.h"
+
+typedef struct RingRef RingRef;
+
+typedef struct {
+    RingRef *owner;
+    guint index;
+} SlotRef;
+
+// A mapped ring, kept alive by the worker and by every buffer still wrapping one of its slots
+struct RingRef {
+    ShmRing *ring;
+    gint refs;
+    SlotRef *slots;
+};
+
+struct SharedSource {
+    GstElement *appsrc;
+    char control_path[108];
+    char stream_id[512];
+    char passphrase[80];
+
+    pthread_t thread;
+    volatile gboolean running;
+
+    pthread_mutex_t lock; // Protects current (read by the stats thread)
+    RingRef *current;
+    guint64 callers_reported;
+};
+
+static RingRef *ring_ref_new(ShmRing *ring)
+{
+    RingRef *ref = g_new0(RingRef, 1);
+    ref->ring = ring;
+    ref->refs = 1;
+    ref->slots = g_new0(SlotRef, shm_ring_slot_count(ring));
+    for (guint i = 0; i < shm_ring_slot_count(ring); i++) {
+        ref->slots[i].owner = ref;
+        ref->slots[i].index = i;
+    }
+    return ref;
+}
+
+static void ring_ref_unref(RingRef *ref)
+{
+    if (!g_atomic_int_dec_and_test(&ref->refs)) return;
+    shm_ring_free(ref->ring);
+    g_free(ref->slots);
+    g_free(ref);
+}
+
+// GstMemory destroy notify: the last reference to the buffer is gone, the slot can be refilled
+static void release_slot(gpointer data)
+{
+    SlotRef *slot = data;
+    RingRef *owner = slot->owner;
+    shm_ring_release(owner->ring, slot->index);
+    ring_ref_unref(owner);
+}
+
+// =============================================================================
+// Registration
+// =============================================================================
+
+static ShmRing *register_route(SharedSource *src, int *control_fd)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return NULL;
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", src->control_path);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    char line[640];
+    int len = src->passphrase[0] ? snprintf(line, sizeof(line), "register %s %s\n", src->stream_id, src->passphrase)
+                                 : snprintf(line, sizeof(line), "register %s\n", src->stream_id);
+    if (send(fd, line, (size_t)len, MSG_NOSIGNAL) != len) {
+        close(fd);
+        return NULL;
+    }
+
+    char reply[256] = {0};
+    struct iovec iov = {.iov_base = reply, .iov_len = sizeof(reply) - 1};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    struct cmsghdr *cmsg = n > 0 ? CMSG_FIRSTHDR(&msg) : NULL;
+    if (n <= 0 || strncmp(reply, "ok", 2) != 0 || !cmsg || cmsg->cmsg_type != SCM_RIGHTS ||
+        cmsg->cmsg_len != CMSG_LEN(2 * sizeof(int))) {
+        g_printerr("SharedSource: listener refused '%s': %s", src->stream_id, n > 0 ? reply : "no reply\n");
+        close(fd);
+        return NULL;
+    }
+
+    int fds[2];
+    memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+    ShmRing *ring = shm_ring_attach(fds[0], fds[1]);
+    if (!ring) {
+        close(fd);
+        return NULL;
+    }
+
+    *control_fd = fd;
+    g_print("SharedSource: registered '%s' with %s\n", src->stream_id, src->control_path);
+    return ring;
+}
+
+// =============================================================================
+// Worker
+// =============================================================================
+
+// Feed the route until the listener goes away
+static void pump(SharedSource *src, RingRef *ref, int control_fd)
+{
+    guint slot_size = shm_ring_slot_size(ref->ring);
+
+    while (src->running) {
+        struct pollfd fds[2] = {
+            {.fd = shm_ring_eventfd(ref->ring), .events = POLLIN},
+            {.fd = control_fd, .events = POLLIN},
+        };
+        if (poll(fds, 2, 100) <= 0) continue;
+
+        if (fds[1].revents) {
+            char buf[256];
+            ssize_t n = recv(control_fd, buf, sizeof(buf), MSG_DONTWAIT);
+            if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+                g_printerr("SharedSource: listener closed the control connection\n");
+                return;
+            }
+        }
+
+        if (!(fds[0].revents & POLLIN) || !shm_ring_wait(ref->ring, 0)) continue;
+
+        guint8 *data;
+        guint len, slot;
+        while ((data = shm_ring_next(ref->ring, &len, &slot)) != NULL) {
+            g_atomic_int_inc(&ref->refs);
+            GstBuffer *buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, data, slot_size, 0, len,
+                                                            &ref->slots[slot], release_slot);
+            gst_app_src_push_buffer(GST_APP_SRC(src->appsrc), buffer);
+        }
+    }
+}
+
+static void *shared_source_worker(void *arg)
+{
+    SharedSource *src = arg;
+    thread_policy_apply_self(THREAD_ROLE_SOURCE, "shared-source");
+
+    while (src->running) {
+        int control_fd = -1;
+        ShmRing *ring = register_route(src, &control_fd);
+        if (!ring) {
+            for (int i = 0; i < 10 && src->running; i++) usleep(100 * 1000); // Listener not up yet
+            continue;
+        }
+
+        RingRef *ref = ring_ref_new(ring);
+        g_atomic_int_inc(&ref->refs); // Held by `current` for the stats thread
+        pthread_mutex_lock(&src->lock);
+        src->current = ref;
+        pthread_mutex_unlock(&src->lock);
+
+        pump(src, ref, control_fd);
+
+        pthread_mutex_lock(&src->lock);
+        src->current = NULL;
+        pthread_mutex_unlock(&src->lock);
+        ring_ref_unref(ref);
+        ring_ref_unref(ref);
+        close(control_fd);
+    }
+    thread_policy_forget_self();
+    return NULL;
+}
+
+// =============================================================================
+// Lifecycle and Stats
+// =============================================================================
+
+SharedSource *shared_source_new(GstElement *appsrc, cJSON *config)
+{
+    cJSON *control = cJSON_GetObjectItem(config, "control");
+    cJSON *stream_id = cJSON_GetObjectItem(config, "streamid");
+    cJSON *passphrase = cJSON_GetObjectItem(config, "passphrase");
+    if (!cJSON_IsString(control) || !cJSON_IsString(stream_id) || !stream_id->valuestring[0] ||
+        strchr(stream_id->valuestring, ' ') || strchr(stream_id->valuestring, '\n')) {
+        g_printerr("SharedSource: 'control' and a 'streamid' without spaces are required\n");
+        return NULL;
+    }
+
+    SharedSource *src = g_new0(SharedSource, 1);
+    src->appsrc = appsrc;
+    snprintf(src->control_path, sizeof(src->control_path), "%s", control->valuestring);
+    snprintf(src->stream_id, sizeof(src->stream_id), "%s", stream_id->valuestring);
+    if (cJSON_IsString(passphrase)) snprintf(src->passphrase, sizeof(src->passphrase), "%s", passphrase->valuestring);
+    pthread_mutex_init(&src->lock, NULL);
+
+    // Live byte stream; the ring bounds how much is queued, so appsrc itself does not
+    g_object_set(appsrc, "is-live", TRUE, "format", GST_FORMAT_BYTES, "max-bytes", (guint64)0, NULL);
+
+    src->running = TRUE;
+    if (pthread_create(&src->thread, NULL, shared_source_worker, src) != 0) {
+        g_printerr("SharedSource: failed to start worker\n");
+        pthread_mutex_destroy(&src->lock);
+        g_free(src);
+        return NULL;
+    }
+    return src;
+}
+
+void shared_source_free(SharedSource *src)
+{
+    if (!src) return;
+    src->running = FALSE;
+    pthread_join(src->thread, NULL);
+    pthread_mutex_destroy(&src->lock);
+    g_free(src);
+}
+
+void shared_source_get_stats(SharedSource *src, SrtSocketStats *stats)
+{
+    ShmRingStats ring = {0};
+    pthread_mutex_lock(&src->lock);
+    if (src->current) ring = *shm_ring_stats(src->current->ring);
+    pthread_mutex_unlock(&src->lock);
+
+    *stats = (SrtSocketStats){
+        .packets_received = (gint64)ring.packets_received,
+        .packets_received_lost = ring.packets_lost,
+        .packets_received_dropped = ring.packets_dropped,
+        .bytes_received = ring.bytes_received,
+        .receive_rate_mbps = ring.receive_rate_mbps,
+        .rtt_ms = ring.rtt_ms,
+        .bandwidth_mbps = ring.bandwidth_mbps,
+        .receive_latency_ms = ring.negotiated_latency_ms,
+    };
+}
+
+void shared_source_add_stats(SharedSource *src, cJSON *root)
+{
+    ShmRingStats stats = {0};
+    guint64 overruns = 0;
+    gboolean registered = FALSE;
+
+    pthread_mutex_lock(&src->lock);
+    if (src->current) {
+        stats = *shm_ring_stats(src->current->ring);
+        overruns = shm_ring_overruns(src->current->ring);
+        registered = TRUE;
+    }
+    pthread_mutex_unlock(&src->lock);
+    stats.peer[sizeof(stats.peer) - 1] = '\0';
+    stats.stream_id[sizeof(stats.stream_id) - 1] = '\0';
+
+    cJSON_ReplaceItemInObject(root, "connected-callers", cJSON_CreateNumber(stats.connected ? 1 : 0));
+
+    cJSON *shared = cJSON_AddObjectToObject(root, "shared-listener");
+    cJSON_AddStringToObject(shared, "control", src->control_path);
+    cJSON_AddBoolToObject(shared, "registered", registered);
+    cJSON_AddBoolToObject(shared, "connected", stats.connected != 0);
+    cJSON_AddStringToObject(shared, "peer", stats.connected ? stats.peer : "");
+    cJSON_AddNumberToObject(shared, "callers-accepted", (double)stats.callers_accepted);
+    cJSON_AddNumberToObject(shared, "ring-overruns", (double)overruns);
+    admission_stats_to_json(&stats.admission, shared);
+
+    // Report each new caller's stream ID the way on_caller_connecting does for srtsrc
+    // The ID comes from the caller through the ring: only one that cannot break the message framing
+    if (stats.callers_accepted != src->callers_reported && stats.stream_id[0] &&
+        admission_stream_id_is_safe(stats.stream_id)) {
+        src->callers_reported = stats.callers_accepted;
+        gchar *message = g_strdup_printf("stats_source_stream_id:%s\n", stats.stream_id);
+        send_message_to_unix_socket(message);
+        g_free(message);
+    }
+}
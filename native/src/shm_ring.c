@@ -0,0 +1,237 @@
+#define _GNU_SOURCE
+#include "shm_ring.h"
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SHM_RING_MAGIC 0x42475352 // "BGSR"
+#define SLOT_ALIGN 64
+
+enum {
+    SLOT_FREE = 0,
+    SLOT_READY = 1, // Filled by the producer, not yet taken
+    SLOT_HELD = 2,  // Taken by the consumer, possibly still referenced downstream
+};
+
+typedef struct {
+    gint state;
+    guint32 len;
+} SlotHeader;
+
+typedef struct {
+    guint32 magic;
+    guint32 slot_count;
+    guint32 slot_size;
+    guint32 slot_stride;
+    guint64 write_seq; // Producer only
+    guint64 read_seq;  // Consumer only
+    guint64 overruns;  // Producer only
+    ShmRingStats stats;
+} RingHeader;
+
+struct ShmRing {
+    RingHeader *header;
+    guint8 *slots;
+    gsize map_size;
+    int memfd;
+    int eventfd;
+};
+
+static gsize header_size(void)
+{
+    return (sizeof(RingHeader) + SLOT_ALIGN - 1) & ~(gsize)(SLOT_ALIGN - 1);
+}
+
+static SlotHeader *slot_at(ShmRing *ring, guint index)
+{
+    return (SlotHeader *)(ring->slots + (gsize)index * ring->header->slot_stride);
+}
+
+static ShmRing *map_ring(int memfd, int efd, gsize size)
+{
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (mem == MAP_FAILED) {
+        g_printerr("SharedListener: mmap failed: %s\n", strerror(errno));
+        return NULL;
+    }
+
+    ShmRing *ring = g_new0(ShmRing, 1);
+    ring->header = mem;
+    ring->slots = (guint8 *)mem + header_size();
+    ring->map_size = size;
+    ring->memfd = memfd;
+    ring->eventfd = efd;
+    return ring;
+}
+
+ShmRing *shm_ring_create(guint slot_count, guint slot_size)
+{
+    if (slot_count == 0 || slot_size == 0) return NULL;
+
+    guint stride = (guint)((sizeof(SlotHeader) + slot_size + SLOT_ALIGN - 1) & ~(gsize)(SLOT_ALIGN - 1));
+    gsize size = header_size() + (gsize)slot_count * stride;
+
+    int memfd = memfd_create("blackgate-ring", MFD_CLOEXEC);
+    if (memfd < 0 || ftruncate(memfd, (off_t)size) != 0) {
+        g_printerr("SharedListener: failed to create ring memory: %s\n", strerror(errno));
+        if (memfd >= 0) close(memfd);
+        return NULL;
+    }
+
+    int efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (efd < 0) {
+        close(memfd);
+        return NULL;
+    }
+
+    ShmRing *ring = map_ring(memfd, efd, size);
+    if (!ring) {
+        close(memfd);
+        close(efd);
+        return NULL;
+    }
+
+    // ftruncate zero-fills, so every slot starts SLOT_FREE
+    ring->header->slot_count = slot_count;
+    ring->header->slot_size = slot_size;
+    ring->header->slot_stride = stride;
+    g_atomic_int_set((gint *)&ring->header->magic, SHM_RING_MAGIC);
+    return ring;
+}
+
+ShmRing *shm_ring_attach(int memfd, int efd)
+{
+    struct stat st;
+    if (fstat(memfd, &st) != 0 || (gsize)st.st_size < header_size()) {
+        close(memfd);
+        close(efd);
+        return NULL;
+    }
+
+    ShmRing *ring = map_ring(memfd, efd, (gsize)st.st_size);
+    if (!ring || ring->header->magic != SHM_RING_MAGIC ||
+        header_size() + (gsize)ring->header->slot_count * ring->header->slot_stride > ring->map_size) {
+        g_printerr("SharedListener: invalid ring received\n");
+        if (ring) {
+            shm_ring_free(ring);
+        } else {
+            close(memfd);
+            close(efd);
+        }
+        return NULL;
+    }
+    return ring;
+}
+
+void shm_ring_free(ShmRing *ring)
+{
+    if (!ring) return;
+    munmap(ring->header, ring->map_size);
+    close(ring->memfd);
+    close(ring->eventfd);
+    g_free(ring);
+}
+
+int shm_ring_memfd(ShmRing *ring)
+{
+    return ring->memfd;
+}
+
+int shm_ring_eventfd(ShmRing *ring)
+{
+    return ring->eventfd;
+}
+
+guint shm_ring_slot_count(ShmRing *ring)
+{
+    return ring->header->slot_count;
+}
+
+guint shm_ring_slot_size(ShmRing *ring)
+{
+    return ring->header->slot_size;
+}
+
+ShmRingStats *shm_ring_stats(ShmRing *ring)
+{
+    return &ring->header->stats;
+}
+
+guint64 shm_ring_overruns(ShmRing *ring)
+{
+    return __atomic_load_n(&ring->header->overruns, __ATOMIC_RELAXED);
+}
+
+// =============================================================================
+// Producer
+// =============================================================================
+
+guint8 *shm_ring_reserve(ShmRing *ring)
+{
+    RingHeader *h = ring->header;
+    SlotHeader *slot = slot_at(ring, (guint)(h->write_seq % h->slot_count));
+    if (g_atomic_int_get(&slot->state) != SLOT_FREE) return NULL;
+    return (guint8 *)(slot + 1);
+}
+
+void shm_ring_drop(ShmRing *ring)
+{
+    __atomic_add_fetch(&ring->header->overruns, 1, __ATOMIC_RELAXED);
+}
+
+void shm_ring_commit(ShmRing *ring, guint len)
+{
+    RingHeader *h = ring->header;
+    SlotHeader *slot = slot_at(ring, (guint)(h->write_seq % h->slot_count));
+    slot->len = MIN(len, h->slot_size);
+    g_atomic_int_set(&slot->state, SLOT_READY); // Publishes len and the payload
+    h->write_seq++;
+}
+
+void shm_ring_notify(ShmRing *ring)
+{
+    guint64 one = 1;
+    if (write(ring->eventfd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        g_printerr("SharedListener: eventfd write failed: %s\n", strerror(errno));
+    }
+}
+
+// =============================================================================
+// Consumer
+// =============================================================================
+
+gboolean shm_ring_wait(ShmRing *ring, int timeout_ms)
+{
+    struct pollfd pfd = {.fd = ring->eventfd, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) <= 0) return FALSE;
+
+    // Reset the counter before draining: a commit after this point raises a new notification
+    guint64 count;
+    if (read(ring->eventfd, &count, sizeof(count)) < 0 && errno != EAGAIN) return FALSE;
+    return TRUE;
+}
+
+guint8 *shm_ring_next(ShmRing *ring, guint *len, guint *slot_index)
+{
+    RingHeader *h = ring->header;
+    guint index = (guint)(h->read_seq % h->slot_count);
+    SlotHeader *slot = slot_at(ring, index);
+
+    if (!g_atomic_int_compare_and_exchange(&slot->state, SLOT_READY, SLOT_HELD)) return NULL;
+    h->read_seq++;
+
+    *len = slot->len;
+    *slot_index = index;
+    return (guint8 *)(slot + 1);
+}
+
+void shm_ring_release(ShmRing *ring, guint slot_index)
+{
+    g_atomic_int_set(&slot_at(ring, slot_index)->state, SLOT_FREE);
+}
@@ -0,0 +1,658 @@
+#define _GNU_SOURCE
+#include "srt_group.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <srt/srt.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "thread_policy.h"
+
+#define MAX_EVENTS (SRT_GROUP_MAX_LINKS + 1)
+#define MAX_MEMBERS (2 * SRT_GROUP_MAX_LINKS) // Broken members linger until libsrt removes them
+// Messages read per wakeup before maintenance gets a turn
+#define RECV_BATCH 64
+#define MAINTAIN_INTERVAL_US (100 * 1000)
+#define DEFAULT_STABLE_TIMEOUT_MS 80 // SRTO_GROUPMINSTABLETIMEO; libsrt refuses less than 60 ms
+
+typedef struct {
+    char address[64];
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    guint16 weight;
+
+    SRTSOCKET listener; // Listener role
+    SRTSOCKET member;   // Caller role: the member dialled on this link
+    gint64 last_dial_us;
+    gboolean connected;
+    guint64 connects;
+} Link;
+
+struct SrtGroup {
+    SrtGroupMode mode;
+    gboolean listener;
+    int latency_ms;
+    int stable_timeout_ms;
+    char passphrase[80];
+    char stream_id[512];
+    Link links[SRT_GROUP_MAX_LINKS];
+    guint n_links;
+
+    SrtGroupRecvFunc recv_func;
+    gpointer user_data;
+
+    pthread_t thread;
+    volatile gboolean running;
+    gboolean started;
+    int eid;
+    gint64 last_maintain_us;
+
+    // Only the worker replaces `sock`, under the lock, so senders and the stats thread that hold the
+    // lock never use a closed socket. Also protects the counters.
+    pthread_mutex_t lock;
+    SRTSOCKET sock; // The group, or a single-link caller accepted by a listener
+    int active_link;
+    guint64 packets;
+    guint64 bytes;
+    guint64 send_drops;
+    guint64 switches;
+};
+
+static void format_address(const struct sockaddr_storage *addr, char *out, gsize out_len)
+{
+    char host[INET6_ADDRSTRLEN] = "";
+    guint16 port = 0;
+    if (addr->ss_family == AF_INET) {
+        const struct sockaddr_in *in = (const struct sockaddr_in *)addr;
+        inet_ntop(AF_INET, &in->sin_addr, host, sizeof(host));
+        port = ntohs(in->sin_port);
+    } else if (addr->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)addr;
+        inet_ntop(AF_INET6, &in6->sin6_addr, host, sizeof(host));
+        port = ntohs(in6->sin6_port);
+    }
+    snprintf(out, out_len, "%s:%u", host, port);
+}
+
+// Whether an accepted member's local address belongs to `link`; a wildcard link matches on port
+static gboolean link_has_local_address(const Link *link, const struct sockaddr_storage *local)
+{
+    if (link->addr.ss_family != local->ss_family) return FALSE;
+    if (local->ss_family == AF_INET) {
+        const struct sockaddr_in *a = (const struct sockaddr_in *)&link->addr;
+        const struct sockaddr_in *b = (const struct sockaddr_in *)local;
+        return a->sin_port == b->sin_port &&
+               (a->sin_addr.s_addr == htonl(INADDR_ANY) || a->sin_addr.s_addr == b->sin_addr.s_addr);
+    }
+    const struct sockaddr_in6 *a = (const struct sockaddr_in6 *)&link->addr;
+    const struct sockaddr_in6 *b = (const struct sockaddr_in6 *)local;
+    return a->sin6_port == b->sin6_port &&
+           (IN6_IS_ADDR_UNSPECIFIED(&a->sin6_addr) || IN6_ARE_ADDR_EQUAL(&a->sin6_addr, &b->sin6_addr));
+}
+
+// =============================================================================
+// Members
+// =============================================================================
+
+// Current members of the connection; a plain socket is reported as one running member
+static int get_members(SrtGroup *g, SRT_SOCKGROUPDATA *members)
+{
+    if (g->sock == SRT_INVALID_SOCK) return 0;
+
+    if (!(g->sock & SRTGROUP_MASK)) {
+        memset(members, 0, sizeof(*members));
+        members->id = g->sock;
+        int len = sizeof(members->peeraddr);
+        srt_getpeername(g->sock, (struct sockaddr *)&members->peeraddr, &len);
+        members->sockstate = srt_getsockstate(g->sock);
+        members->memberstate = SRT_GST_RUNNING;
+        return 1;
+    }
+
+    size_t n = MAX_MEMBERS;
+    int count = srt_group_data(g->sock, members, &n);
+    return count < 0 ? 0 : MIN(count, MAX_MEMBERS);
+}
+
+static int link_for_member(SrtGroup *g, const SRT_SOCKGROUPDATA *member)
+{
+    if (!g->listener) {
+        for (guint i = 0; i < g->n_links; i++) {
+            if (g->links[i].member == member->id) return (int)i;
+        }
+        return -1;
+    }
+
+    struct sockaddr_storage local;
+    int len = sizeof(local);
+    if (srt_getsockname(member->id, (struct sockaddr *)&local, &len) == SRT_ERROR) return -1;
+    for (guint i = 0; i < g->n_links; i++) {
+        if (link_has_local_address(&g->links[i], &local)) return (int)i;
+    }
+    return -1;
+}
+
+static SrtLinkState member_link_state(const SRT_SOCKGROUPDATA *member)
+{
+    switch (member->memberstate) {
+        case SRT_GST_PENDING:
+            return SRT_LINK_CONNECTING;
+        case SRT_GST_IDLE:
+            return SRT_LINK_STANDBY;
+        case SRT_GST_RUNNING:
+            return SRT_LINK_ACTIVE;
+        default:
+            return SRT_LINK_BROKEN;
+    }
+}
+
+// =============================================================================
+// Connection Setup
+// =============================================================================
+
+static void apply_options(SrtGroup *g, SRTSOCKET sock)
+{
+    int no = 0;
+    srt_setsockflag(sock, SRTO_RCVSYN, &no, sizeof(no));
+    srt_setsockflag(sock, SRTO_SNDSYN, &no, sizeof(no));
+    if (g->latency_ms > 0) srt_setsockflag(sock, SRTO_LATENCY, &g->latency_ms, sizeof(g->latency_ms));
+    if (g->passphrase[0]) srt_setsockflag(sock, SRTO_PASSPHRASE, g->passphrase, (int)strlen(g->passphrase));
+}
+
+static void set_connection(SrtGroup *g, SRTSOCKET sock)
+{
+    if (sock != SRT_INVALID_SOCK && g->recv_func) {
+        int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+        srt_epoll_add_usock(g->eid, sock, &events);
+    }
+    pthread_mutex_lock(&g->lock);
+    g->sock = sock;
+    g->active_link = -1;
+    pthread_mutex_unlock(&g->lock);
+}
+
+static void close_connection(SrtGroup *g)
+{
+    SRTSOCKET sock = g->sock;
+    if (sock == SRT_INVALID_SOCK) return;
+
+    if (g->recv_func) srt_epoll_remove_usock(g->eid, sock);
+    set_connection(g, SRT_INVALID_SOCK);
+    srt_close(sock);
+    for (guint i = 0; i < g->n_links; i++) {
+        g->links[i].member = SRT_INVALID_SOCK;
+        g->links[i].connected = FALSE;
+    }
+    g_print("SrtGroup: connection closed\n");
+}
+
+static gboolean open_caller_group(SrtGroup *g)
+{
+    SRTSOCKET sock = srt_create_group(g->mode == SRT_GROUP_BACKUP ? SRT_GTYPE_BACKUP : SRT_GTYPE_BROADCAST);
+    if (sock == SRT_INVALID_SOCK) {
+        g_printerr("SrtGroup: cannot create socket group (libsrt without bonding?): %s\n", srt_getlasterror_str());
+        return FALSE;
+    }
+
+    apply_options(g, sock);
+    if (g->stream_id[0]) srt_setsockflag(sock, SRTO_STREAMID, g->stream_id, (int)strlen(g->stream_id));
+    if (g->mode == SRT_GROUP_BACKUP) {
+        srt_setsockflag(sock, SRTO_GROUPMINSTABLETIMEO, &g->stable_timeout_ms, sizeof(g->stable_timeout_ms));
+    }
+    set_connection(g, sock);
+    return TRUE;
+}
+
+// Dial every link that has no live member; each link is retried at most every SRT_GROUP_RECONNECT_MS
+static void dial_links(SrtGroup *g, gint64 now_us)
+{
+    if (g->sock == SRT_INVALID_SOCK && !open_caller_group(g)) return;
+
+    SRT_SOCKGROUPDATA members[MAX_MEMBERS];
+    int n = get_members(g, members);
+
+    for (guint i = 0; i < g->n_links; i++) {
+        Link *link = &g->links[i];
+        gboolean alive = FALSE;
+        for (int m = 0; m < n && !alive; m++) {
+            alive = members[m].id == link->member && members[m].memberstate != SRT_GST_BROKEN;
+        }
+        if (alive || now_us - link->last_dial_us < SRT_GROUP_RECONNECT_MS * 1000) continue;
+
+        link->last_dial_us = now_us;
+        SRT_SOCKGROUPCONFIG endpoint = srt_prepare_endpoint(NULL, (struct sockaddr *)&link->addr, (int)link->addr_len);
+        endpoint.weight = link->weight;
+        // Non-blocking: the member stays pending until its handshake completes or fails
+        srt_connect_group(g->sock, &endpoint, 1);
+        link->member = endpoint.id;
+    }
+}
+
+// Runs inside the handshake: only the configured stream ID may connect
+static int on_listen(void *opaque, SRTSOCKET ns, int hs_version, const struct sockaddr *peer, const char *stream_id)
+{
+    (void)hs_version;
+    (void)peer;
+    SrtGroup *g = opaque;
+    if (!stream_id || strcmp(stream_id, g->stream_id) != 0) {
+        srt_setrejectreason(ns, SRT_REJX_NOTFOUND);
+        g_print("SrtGroup: rejected stream ID '%s'\n", stream_id ? stream_id : "");
+        return -1;
+    }
+    return 0;
+}
+
+static gboolean open_listeners(SrtGroup *g)
+{
+    int yes = 1;
+    for (guint i = 0; i < g->n_links; i++) {
+        Link *link = &g->links[i];
+        SRTSOCKET sock = srt_create_socket();
+        apply_options(g, sock);
+
+        if (srt_setsockflag(sock, SRTO_GROUPCONNECT, &yes, sizeof(yes)) == SRT_ERROR) {
+            g_printerr("SrtGroup: libsrt was built without bonding: %s\n", srt_getlasterror_str());
+            srt_close(sock);
+            return FALSE;
+        }
+        if ((g->stream_id[0] && srt_listen_callback(sock, on_listen, g) == SRT_ERROR) ||
+            srt_bind(sock, (struct sockaddr *)&link->addr, (int)link->addr_len) == SRT_ERROR ||
+            srt_listen(sock, 8) == SRT_ERROR) {
+            g_printerr("SrtGroup: cannot listen on %s: %s\n", link->address, srt_getlasterror_str());
+            srt_close(sock);
+            return FALSE;
+        }
+
+        int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+        srt_epoll_add_usock(g->eid, sock, &events);
+        link->listener = sock;
+        g_print("SrtGroup: listening on %s\n", link->address);
+    }
+    return TRUE;
+}
+
+static void accept_caller(SrtGroup *g, SRTSOCKET listener)
+{
+    struct sockaddr_storage addr;
+    int addr_len = sizeof(addr);
+    SRTSOCKET sock = srt_accept(listener, (struct sockaddr *)&addr, &addr_len);
+    if (sock == SRT_INVALID_SOCK) return;
+
+    char peer[64];
+    format_address(&addr, peer, sizeof(peer));
+    if (g->sock != SRT_INVALID_SOCK) {
+        g_print("SrtGroup: refused %s, a caller is already connected\n", peer);
+        srt_close(sock);
+        return;
+    }
+
+    set_connection(g, sock);
+    g_print("SrtGroup: %s caller connected from %s\n", (sock & SRTGROUP_MASK) ? "bonded" : "single-link", peer);
+}
+
+// =============================================================================
+// Worker
+// =============================================================================
+
+static void read_connection(SrtGroup *g)
+{
+    char buf[1500];
+    guint64 packets = 0, bytes = 0;
+
+    for (int i = 0; i < RECV_BATCH; i++) {
+        int len = srt_recvmsg2(g->sock, buf, (int)sizeof(buf), NULL);
+        if (len == SRT_ERROR) {
+            if (srt_getlasterror(NULL) != SRT_EASYNCRCV) close_connection(g);
+            break;
+        }
+        packets++;
+        bytes += (guint64)len;
+        g->recv_func((const guint8 *)buf, (gsize)len, g->user_data);
+    }
+
+    pthread_mutex_lock(&g->lock);
+    g->packets += packets;
+    g->bytes += bytes;
+    pthread_mutex_unlock(&g->lock);
+}
+
+// Follow link states: count (re)connections per link and, in backup mode, changes of the active link
+static void track_links(SrtGroup *g)
+{
+    SRT_SOCKGROUPDATA members[MAX_MEMBERS];
+    int n = get_members(g, members);
+    gboolean connected[SRT_GROUP_MAX_LINKS] = {FALSE};
+    int active = -1;
+
+    for (int m = 0; m < n; m++) {
+        int idx = link_for_member(g, &members[m]);
+        if (idx < 0) continue;
+        if (members[m].memberstate == SRT_GST_IDLE || members[m].memberstate == SRT_GST_RUNNING) {
+            connected[idx] = TRUE;
+        }
+        if (members[m].memberstate == SRT_GST_RUNNING && active < 0) active = idx;
+    }
+
+    for (guint i = 0; i < g->n_links; i++) {
+        Link *link = &g->links[i];
+        if (connected[i] != link->connected) {
+            if (connected[i]) link->connects++;
+            g_print("SrtGroup: link %s %s\n", link->address, connected[i] ? "up" : "down");
+        }
+        link->connected = connected[i];
+    }
+
+    if (g->mode != SRT_GROUP_BACKUP || active < 0) return;
+    pthread_mutex_lock(&g->lock);
+    if (g->active_link >= 0 && g->active_link != active) {
+        g->switches++;
+        g_print("SrtGroup: switched from %s to %s\n", g->links[g->active_link].address, g->links[active].address);
+    }
+    g->active_link = active;
+    pthread_mutex_unlock(&g->lock);
+}
+
+static void maintain(SrtGroup *g, gint64 now_us)
+{
+    if (g->sock != SRT_INVALID_SOCK && srt_getsockstate(g->sock) >= SRTS_BROKEN) close_connection(g);
+    if (!g->listener) dial_links(g, now_us);
+    track_links(g);
+}
+
+static void *srt_group_worker(void *arg)
+{
+    SrtGroup *g = arg;
+    thread_policy_apply_self(g->recv_func ? THREAD_ROLE_SOURCE : THREAD_ROLE_SINK, "srt-group");
+
+    while (g->running) {
+        SRTSOCKET ready[MAX_EVENTS];
+        int n_ready = MAX_EVENTS;
+        if (srt_epoll_wait(g->eid, ready, &n_ready, NULL, NULL, 100, NULL, NULL, NULL, NULL) < 0) {
+            n_ready = 0;
+            // Nothing to wait on (a sender dialling out): pace the maintenance loop ourselves
+            if (srt_getlasterror(NULL) != SRT_ETIMEOUT) usleep(MAINTAIN_INTERVAL_US);
+        }
+
+        for (int i = 0; i < n_ready; i++) {
+            if (ready[i] == g->sock) {
+                read_connection(g);
+                continue;
+            }
+            for (guint l = 0; l < g->n_links; l++) {
+                if (ready[i] == g->links[l].listener) accept_caller(g, ready[i]);
+            }
+        }
+
+        gint64 now = g_get_monotonic_time();
+        if (now - g->last_maintain_us >= MAINTAIN_INTERVAL_US) {
+            maintain(g, now);
+            g->last_maintain_us = now;
+        }
+    }
+    thread_policy_forget_self();
+    return NULL;
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+static gboolean parse_link(cJSON *item, gboolean listener, Link *link)
+{
+    cJSON *host = cJSON_GetObjectItem(item, "host");
+    cJSON *port = cJSON_GetObjectItem(item, "port");
+    cJSON *weight = cJSON_GetObjectItem(item, "weight");
+    if (!cJSON_IsObject(item) || (!listener && !cJSON_IsString(host)) || (host && !cJSON_IsString(host)) ||
+        !cJSON_IsNumber(port) || port->valueint < 1 || port->valueint > 65535 ||
+        (weight && (!cJSON_IsNumber(weight) || weight->valueint < 0 || weight->valueint > 65535))) {
+        g_printerr("SrtGroup: each link needs a 'host', a 'port' of 1-65535 and an optional 'weight' of 0-65535\n");
+        return FALSE;
+    }
+
+    const char *name = host ? host->valuestring : "0.0.0.0";
+    char service[8];
+    snprintf(service, sizeof(service), "%d", port->valueint);
+    struct addrinfo hints = {.ai_socktype = SOCK_DGRAM, .ai_flags = listener ? AI_PASSIVE : 0};
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(name, service, &hints, &res) != 0 || !res) {
+        g_printerr("SrtGroup: cannot resolve link %s:%s\n", name, service);
+        return FALSE;
+    }
+    memcpy(&link->addr, res->ai_addr, res->ai_addrlen);
+    link->addr_len = res->ai_addrlen;
+    freeaddrinfo(res);
+
+    snprintf(link->address, sizeof(link->address), "%s:%d", name, port->valueint);
+    link->weight = weight ? (guint16)weight->valueint : 0;
+    link->listener = SRT_INVALID_SOCK;
+    link->member = SRT_INVALID_SOCK;
+    return TRUE;
+}
+
+SrtGroup *srt_group_new(cJSON *config, SrtGroupRecvFunc recv_func, gpointer user_data)
+{
+    cJSON *mode = cJSON_GetObjectItem(config, "mode");
+    cJSON *role = cJSON_GetObjectItem(config, "role");
+    cJSON *links = cJSON_GetObjectItem(config, "links");
+    cJSON *latency = cJSON_GetObjectItem(config, "latency");
+    cJSON *passphrase = cJSON_GetObjectItem(config, "passphrase");
+    cJSON *stream_id = cJSON_GetObjectItem(config, "streamid");
+    cJSON *stable = cJSON_GetObjectItem(config, "stable-timeout-ms");
+
+    if (mode && (!cJSON_IsString(mode) ||
+                 (strcmp(mode->valuestring, "broadcast") != 0 && strcmp(mode->valuestring, "backup") != 0))) {
+        g_printerr("SrtGroup: 'mode' must be \"broadcast\" or \"backup\"\n");
+        return NULL;
+    }
+    if (role && (!cJSON_IsString(role) ||
+                 (strcmp(role->valuestring, "caller") != 0 && strcmp(role->valuestring, "listener") != 0))) {
+        g_printerr("SrtGroup: 'role' must be \"caller\" or \"listener\"\n");
+        return NULL;
+    }
+    if (!cJSON_IsArray(links) || cJSON_GetArraySize(links) < 1 || cJSON_GetArraySize(links) > SRT_GROUP_MAX_LINKS) {
+        g_printerr("SrtGroup: 'links' must list 1-%d links\n", SRT_GROUP_MAX_LINKS);
+        return NULL;
+    }
+    if ((latency && (!cJSON_IsNumber(latency) || latency->valueint < 0)) ||
+        (passphrase && (!cJSON_IsString(passphrase) || strlen(passphrase->valuestring) < 10 ||
+                        strlen(passphrase->valuestring) > 79)) ||
+        (stream_id && (!cJSON_IsString(stream_id) || strlen(stream_id->valuestring) >= 512)) ||
+        (stable && (!cJSON_IsNumber(stable) || stable->valueint < 60))) {
+        g_printerr("SrtGroup: invalid 'latency', 'passphrase' (10-79 characters), 'streamid' or "
+                   "'stable-timeout-ms' (at least 60)\n");
+        return NULL;
+    }
+
+    SrtGroup *g = g_new0(SrtGroup, 1);
+    g->mode = mode && strcmp(mode->valuestring, "backup") == 0 ? SRT_GROUP_BACKUP : SRT_GROUP_BROADCAST;
+    g->listener = role && strcmp(role->valuestring, "listener") == 0;
+    g->latency_ms = latency ? latency->valueint : 0;
+    g->stable_timeout_ms = stable ? stable->valueint : DEFAULT_STABLE_TIMEOUT_MS;
+    if (passphrase) snprintf(g->passphrase, sizeof(g->passphrase), "%s", passphrase->valuestring);
+    if (stream_id) snprintf(g->stream_id, sizeof(g->stream_id), "%s", stream_id->valuestring);
+    g->recv_func = recv_func;
+    g->user_data = user_data;
+    g->sock = SRT_INVALID_SOCK;
+    g->active_link = -1;
+    g->eid = -1;
+    pthread_mutex_init(&g->lock, NULL);
+
+    cJSON *item;
+    cJSON_ArrayForEach(item, links)
+    {
+        if (!parse_link(item, g->listener, &g->links[g->n_links])) {
+            srt_group_free(g);
+            return NULL;
+        }
+        g->n_links++;
+    }
+    return g;
+}
+
+void srt_group_free(SrtGroup *group)
+{
+    if (!group) return;
+    srt_group_stop(group);
+    pthread_mutex_destroy(&group->lock);
+    g_free(group);
+}
+
+gboolean srt_group_start(SrtGroup *group)
+{
+    if (group->started) return TRUE;
+
+    srt_startup();
+    group->eid = srt_epoll_create();
+    gboolean ok = group->listener ? open_listeners(group) : open_caller_group(group);
+    if (ok) {
+        group->running = TRUE;
+        ok = pthread_create(&group->thread, NULL, srt_group_worker, group) == 0;
+        if (!ok) g_printerr("SrtGroup: failed to start worker\n");
+    }
+
+    group->started = TRUE;
+    if (!ok) srt_group_stop(group);
+    return ok;
+}
+
+void srt_group_stop(SrtGroup *group)
+{
+    if (!group->started) return;
+
+    if (group->running) {
+        group->running = FALSE;
+        pthread_join(group->thread, NULL);
+    }
+    close_connection(group);
+    for (guint i = 0; i < group->n_links; i++) {
+        if (group->links[i].listener != SRT_INVALID_SOCK) srt_close(group->links[i].listener);
+        group->links[i].listener = SRT_INVALID_SOCK;
+    }
+    srt_epoll_release(group->eid);
+    group->eid = -1;
+    srt_cleanup();
+    group->started = FALSE;
+}
+
+gboolean srt_group_send(SrtGroup *group, const guint8 *data, gsize len)
+{
+    gboolean all_sent = TRUE;
+
+    pthread_mutex_lock(&group->lock);
+    for (gsize offset = 0; offset < len; offset += SRT_GROUP_PAYLOAD_SIZE) {
+        int chunk = (int)MIN(len - offset, (gsize)SRT_GROUP_PAYLOAD_SIZE);
+        if (group->sock == SRT_INVALID_SOCK ||
+            srt_sendmsg2(group->sock, (const char *)data + offset, chunk, NULL) == SRT_ERROR) {
+            group->send_drops++;
+            all_sent = FALSE;
+            continue;
+        }
+        group->packets++;
+        group->bytes += (guint64)chunk;
+    }
+    pthread_mutex_unlock(&group->lock);
+    return all_sent;
+}
+
+void srt_group_get_stats(SrtGroup *group, SrtGroupStats *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+    stats->mode = group->mode;
+    stats->n_links = group->n_links;
+    for (guint i = 0; i < group->n_links; i++) {
+        snprintf(stats->links[i].address, sizeof(stats->links[i].address), "%s", group->links[i].address);
+        stats->links[i].weight = group->links[i].weight;
+        stats->links[i].connects = group->links[i].connects;
+    }
+
+    pthread_mutex_lock(&group->lock);
+    stats->packets = group->packets;
+    stats->bytes = group->bytes;
+    stats->send_drops = group->send_drops;
+    stats->switches = group->switches;
+
+    SRT_SOCKGROUPDATA members[MAX_MEMBERS];
+    int n = get_members(group, members);
+    for (int m = 0; m < n; m++) {
+        int idx = link_for_member(group, &members[m]);
+        if (idx < 0) continue;
+
+        SrtLinkStats *link = &stats->links[idx];
+        SrtLinkState state = member_link_state(&members[m]);
+        // A broken member may linger next to its replacement; report the replacement
+        if (link->state != SRT_LINK_DOWN && state == SRT_LINK_BROKEN) continue;
+        link->state = state;
+        if (state == SRT_LINK_STANDBY || state == SRT_LINK_ACTIVE) stats->connected = TRUE;
+        if (group->listener) link->weight = members[m].weight;
+        format_address(&members[m].peeraddr, link->peer, sizeof(link->peer));
+
+        SRT_TRACEBSTATS perf;
+        if (srt_bstats(members[m].id, &perf, 0) != 0) continue;
+        link->rtt_ms = perf.msRTT;
+        link->bandwidth_mbps = perf.mbpsBandwidth;
+        if (group->recv_func) {
+            link->rate_mbps = perf.mbpsRecvRate;
+            link->packets_lost = perf.pktRcvLossTotal;
+            link->packets_dropped = perf.pktRcvDropTotal;
+            if (state == SRT_LINK_ACTIVE) stats->negotiated_latency_ms = perf.msRcvTsbPdDelay;
+        } else {
+            link->rate_mbps = perf.mbpsSendRate;
+            link->packets_lost = perf.pktSndLossTotal;
+            link->packets_dropped = perf.pktSndDropTotal;
+            if (state == SRT_LINK_ACTIVE) stats->negotiated_latency_ms = perf.msSndTsbPdDelay;
+        }
+        link->packets_retransmitted = perf.pktRetransTotal;
+    }
+    pthread_mutex_unlock(&group->lock);
+}
+
+const char *srt_group_mode_name(SrtGroupMode mode)
+{
+    return mode == SRT_GROUP_BACKUP ? "backup" : "broadcast";
+}
+
+const char *srt_link_state_name(SrtLinkState state)
+{
+    switch (state) {
+        case SRT_LINK_CONNECTING:
+            return "connecting";
+        case SRT_LINK_STANDBY:
+            return "standby";
+        case SRT_LINK_ACTIVE:
+            return "active";
+        case SRT_LINK_BROKEN:
+            return "broken";
+        default:
+            return "down";
+    }
+}
+
+void srt_group_stats_to_json(const SrtGroupStats *stats, cJSON *parent)
+{
+    cJSON *obj = cJSON_AddObjectToObject(parent, "bonding");
+    cJSON_AddStringToObject(obj, "mode", srt_group_mode_name(stats->mode));
+    cJSON_AddBoolToObject(obj, "connected", stats->connected);
+    cJSON_AddNumberToObject(obj, "switches", (double)stats->switches);
+    cJSON_AddNumberToObject(obj, "send-drops", (double)stats->send_drops);
+
+    cJSON *links = cJSON_AddArrayToObject(obj, "links");
+    for (guint i = 0; i < stats->n_links; i++) {
+        const SrtLinkStats *link = &stats->links[i];
+        cJSON *entry = cJSON_CreateObject();
+        cJSON_AddStringToObject(entry, "address", link->address);
+        cJSON_AddStringToObject(entry, "peer", link->peer);
+        cJSON_AddStringToObject(entry, "state", srt_link_state_name(link->state));
+        cJSON_AddNumberToObject(entry, "weight", link->weight);
+        cJSON_AddNumberToObject(entry, "rtt-ms", link->rtt_ms);
+        cJSON_AddNumberToObject(entry, "rate-mbps", link->rate_mbps);
+        cJSON_AddNumberToObject(entry, "bandwidth-mbps", link->bandwidth_mbps);
+        cJSON_AddNumberToObject(entry, "packets-lost", (double)link->packets_lost);
+        cJSON_AddNumberToObject(entry, "packets-retransmitted", (double)link->packets_retransmitted);
+        cJSON_AddNumberToObject(entry, "packets-dropped", (double)link->packets_dropped);
+        cJSON_AddNumberToObject(entry, "connects", (double)link->connects);
+        cJSON_AddItemToArray(links, entry);
+    }
+}
@@ -0,0 +1,582 @@
+#define _GNU_SOURCE
+#include "srt_listener.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <glib.h>
+#include <netdb.h>
+#include <pthread.h>
+#include <signal.h>
+#include <srt/srt.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "admission.h"
+#include "shm_ring.h"
+
+#define MAX_ROUTES 256
+#define MAX_EVENTS 64
+// Messages read from one caller before moving on to the next ready socket
+#define RECV_BATCH 64
+// libsrt accepts passphrases of 10 to 79 characters
+#define MIN_PASSPHRASE 10
+
+typedef struct {
+    gboolean in_use;
+    char stream_id[512];
+    char passphrase[80];
+
+    int control_fd; // Route process; closing it unregisters the route
+    char control_buf[1024];
+    gsize control_len;
+
+    ShmRing *ring;
+    SRTSOCKET caller; // SRT_INVALID_SOCK while no caller is connected
+} Route;
+
+typedef struct {
+    SRTSOCKET socket;
+    int eid;
+    int control_listen_fd;
+    char control_path[108];
+    int latency_ms;
+    guint ring_slots;
+
+    Route routes[MAX_ROUTES];
+    // Stream ID lookups come from libsrt's handshake thread as well as from the event loop
+    pthread_mutex_t lock;
+    GHashTable *by_stream_id;
+
+    Admission *admission; // "listener": {"admission": ...}, checked before the stream ID lookup
+} Listener;
+
+static Listener listener;
+static volatile sig_atomic_t listener_running = 1;
+
+static void on_signal(int sig)
+{
+    (void)sig;
+    listener_running = 0;
+}
+
+static Route *route_for_caller(SRTSOCKET sock)
+{
+    for (int i = 0; i < MAX_ROUTES; i++) {
+        if (listener.routes[i].in_use && listener.routes[i].caller == sock) return &listener.routes[i];
+    }
+    return NULL;
+}
+
+static Route *route_for_control(int fd)
+{
+    for (int i = 0; i < MAX_ROUTES; i++) {
+        if (listener.routes[i].in_use && listener.routes[i].control_fd == fd) return &listener.routes[i];
+    }
+    return NULL;
+}
+
+// =============================================================================
+// Callers
+// =============================================================================
+
+static void format_peer(const struct sockaddr *addr, char *host, gsize host_len, guint16 *port)
+{
+    host[0] = '\0';
+    *port = 0;
+    if (!addr) return;
+    if (addr->sa_family == AF_INET) {
+        const struct sockaddr_in *in = (const struct sockaddr_in *)addr;
+        inet_ntop(AF_INET, &in->sin_addr, host, (socklen_t)host_len);
+        *port = ntohs(in->sin_port);
+    } else if (addr->sa_family == AF_INET6) {
+        const struct sockaddr_in6 *in6 = (const struct sockaddr_in6 *)addr;
+        inet_ntop(AF_INET6, &in6->sin6_addr, host, (socklen_t)host_len);
+        *port = ntohs(in6->sin6_port);
+    }
+}
+
+// Runs inside the handshake on libsrt's receiver thread: apply admission control, then admit only
+// stream IDs with a registered route and no caller yet, and give the new socket that route's passphrase
+static int on_listen(void *opaque, SRTSOCKET ns, int hs_version, const struct sockaddr *peer, const char *stream_id)
+{
+    (void)opaque;
+
+    if (hs_version < 5 || !stream_id || !stream_id[0]) {
+        srt_setrejectreason(ns, SRT_REJX_BAD_REQUEST);
+        g_print("SharedListener: rejected caller without stream ID\n");
+        return -1;
+    }
+
+    char host[INET6_ADDRSTRLEN];
+    guint16 port;
+    format_peer(peer, host, sizeof(host), &port);
+    AdmissionResult admitted = admission_check(listener.admission, host[0] ? host : NULL, stream_id,
+                                               g_get_monotonic_time());
+    if (admitted != ADMISSION_ACCEPT) {
+        gboolean overload = admitted != ADMISSION_REJECT_IP && admitted != ADMISSION_REJECT_STREAM_ID &&
+                            admitted != ADMISSION_REJECT_MALFORMED;
+        srt_setrejectreason(ns, overload ? SRT_REJX_OVERLOAD : SRT_REJX_FORBIDDEN);
+        gchar *printable = g_strescape(stream_id, NULL);
+        g_print("SharedListener: rejected %s:%u for '%s' (%s)\n", host, port, printable,
+                admission_result_name(admitted));
+        g_free(printable);
+        return -1;
+    }
+
+    pthread_mutex_lock(&listener.lock);
+    Route *route = g_hash_table_lookup(listener.by_stream_id, stream_id);
+    int reject = 0;
+    if (!route) {
+        reject = SRT_REJX_NOTFOUND;
+    } else if (route->caller != SRT_INVALID_SOCK) {
+        reject = SRT_REJX_CONFLICT;
+    } else if (route->passphrase[0] &&
+               srt_setsockflag(ns, SRTO_PASSPHRASE, route->passphrase, (int)strlen(route->passphrase)) == SRT_ERROR) {
+        // Never let the caller in unencrypted when the route asked for a passphrase
+        reject = SRT_REJX_BAD_REQUEST;
+    }
+    pthread_mutex_unlock(&listener.lock);
+
+    if (reject) {
+        srt_setrejectreason(ns, reject);
+        g_print("SharedListener: rejected stream ID '%s' (%s)\n", stream_id,
+                reject == SRT_REJX_NOTFOUND   ? "no such route"
+                : reject == SRT_REJX_CONFLICT ? "route already has a caller"
+                                              : "cannot set route passphrase");
+        return -1;
+    }
+    return 0;
+}
+
+static void disconnect_caller(Route *route)
+{
+    if (route->caller == SRT_INVALID_SOCK) return;
+
+    srt_epoll_remove_usock(listener.eid, route->caller);
+    srt_close(route->caller);
+    pthread_mutex_lock(&listener.lock);
+    route->caller = SRT_INVALID_SOCK;
+    pthread_mutex_unlock(&listener.lock);
+    admission_caller_removed(listener.admission);
+    shm_ring_stats(route->ring)->connected = 0;
+    g_print("SharedListener: caller for '%s' disconnected\n", route->stream_id);
+}
+
+static void accept_callers(void)
+{
+    for (;;) {
+        struct sockaddr_storage addr;
+        int addr_len = sizeof(addr);
+        SRTSOCKET sock = srt_accept(listener.socket, (struct sockaddr *)&addr, &addr_len);
+        if (sock == SRT_INVALID_SOCK) return; // Backlog drained
+
+        char stream_id[512] = {0};
+        int id_len = sizeof(stream_id) - 1;
+        srt_getsockflag(sock, SRTO_STREAMID, stream_id, &id_len);
+
+        pthread_mutex_lock(&listener.lock);
+        Route *route = g_hash_table_lookup(listener.by_stream_id, stream_id);
+        gboolean taken = route && route->caller != SRT_INVALID_SOCK;
+        if (route && !taken) route->caller = sock;
+        pthread_mutex_unlock(&listener.lock);
+
+        // The route may have gone, or another caller won the race, since the handshake
+        if (!route || taken) {
+            srt_close(sock);
+            continue;
+        }
+
+        int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+        srt_epoll_add_usock(listener.eid, sock, &events);
+
+        admission_caller_added(listener.admission);
+
+        ShmRingStats *stats = shm_ring_stats(route->ring);
+        char host[INET6_ADDRSTRLEN];
+        guint16 port;
+        format_peer((struct sockaddr *)&addr, host, sizeof(host), &port);
+        snprintf(stats->peer, sizeof(stats->peer), "%s:%u", host, port);
+        snprintf(stats->stream_id, sizeof(stats->stream_id), "%s", stream_id);
+        stats->callers_accepted++;
+        stats->connected = 1;
+
+        g_print("SharedListener: caller %s connected to '%s'\n", stats->peer, stream_id);
+    }
+}
+
+// Receive straight into the route's ring; the ring slot is the only copy of the payload
+static void read_caller(Route *route)
+{
+    ShmRingStats *stats = shm_ring_stats(route->ring);
+    guint slot_size = shm_ring_slot_size(route->ring);
+    char scratch[SHM_RING_DEFAULT_SLOT_SIZE];
+    guint committed = 0;
+
+    for (int i = 0; i < RECV_BATCH; i++) {
+        guint8 *slot = shm_ring_reserve(route->ring);
+        int len = slot ? srt_recvmsg(route->caller, (char *)slot, (int)slot_size)
+                       : srt_recvmsg(route->caller, scratch, (int)sizeof(scratch));
+
+        if (len == SRT_ERROR) {
+            if (srt_getlasterror(NULL) != SRT_EASYNCRCV) disconnect_caller(route);
+            break;
+        }
+
+        stats->packets_received++;
+        stats->bytes_received += (guint64)len;
+        if (slot) {
+            shm_ring_commit(route->ring, (guint)len);
+            committed++;
+        } else {
+            shm_ring_drop(route->ring); // Route still holds the slot downstream
+        }
+    }
+
+    if (committed) shm_ring_notify(route->ring);
+}
+
+static void publish_caller_stats(void)
+{
+    AdmissionStats admission;
+    admission_reload_if_changed(listener.admission);
+    admission_get_stats(listener.admission, &admission);
+
+    for (int i = 0; i < MAX_ROUTES; i++) {
+        Route *route = &listener.routes[i];
+        if (!route->in_use) continue;
+
+        ShmRingStats *stats = shm_ring_stats(route->ring);
+        stats->admission = admission;
+
+        SRT_TRACEBSTATS perf;
+        if (route->caller == SRT_INVALID_SOCK || srt_bstats(route->caller, &perf, 0) != 0) continue;
+
+        stats->packets_lost = perf.pktRcvLossTotal;
+        stats->packets_dropped = perf.pktRcvDropTotal;
+        stats->rtt_ms = perf.msRTT;
+        stats->receive_rate_mbps = perf.mbpsRecvRate;
+        stats->bandwidth_mbps = perf.mbpsBandwidth;
+        stats->negotiated_latency_ms = perf.msRcvTsbPdDelay;
+    }
+}
+
+// =============================================================================
+// Route Registration
+// =============================================================================
+
+static gboolean send_ring(int fd, ShmRing *ring)
+{
+    char reply[] = "ok\n";
+    struct iovec iov = {.iov_base = reply, .iov_len = sizeof(reply) - 1};
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE(2 * sizeof(int))];
+    } control;
+    memset(&control, 0, sizeof(control));
+
+    struct msghdr msg = {0};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof(control.buf);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(2 * sizeof(int));
+    int fds[2] = {shm_ring_memfd(ring), shm_ring_eventfd(ring)};
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+    return sendmsg(fd, &msg, MSG_NOSIGNAL) == (ssize_t)iov.iov_len;
+}
+
+static void send_error(int fd, const char *reason)
+{
+    char line[256];
+    int len = snprintf(line, sizeof(line), "error %s\n", reason);
+    if (send(fd, line, (size_t)len, MSG_NOSIGNAL) < 0) {
+        g_printerr("SharedListener: failed to send error: %s\n", strerror(errno));
+    }
+}
+
+static void unregister_route(Route *route)
+{
+    pthread_mutex_lock(&listener.lock);
+    if (route->stream_id[0]) g_hash_table_remove(listener.by_stream_id, route->stream_id);
+    pthread_mutex_unlock(&listener.lock);
+
+    disconnect_caller(route);
+    srt_epoll_remove_ssock(listener.eid, route->control_fd);
+    close(route->control_fd);
+
+    if (route->stream_id[0]) g_print("SharedListener: route '%s' unregistered\n", route->stream_id);
+    shm_ring_free(route->ring); // The route process keeps its own mapping
+    memset(route, 0, sizeof(*route));
+    route->caller = SRT_INVALID_SOCK;
+}
+
+static void handle_command(Route *route, char *line)
+{
+    if (strncmp(line, "register ", 9) != 0 || route->stream_id[0]) {
+        send_error(route->control_fd, "unexpected command");
+        return;
+    }
+
+    char *stream_id = line + 9;
+    char *passphrase = strchr(stream_id, ' ');
+    if (passphrase) *passphrase++ = '\0';
+    // A passphrase libsrt would refuse is refused here, not on the caller's socket in the handshake
+    gsize passphrase_len = passphrase ? strlen(passphrase) : 0;
+    if (!stream_id[0] || strlen(stream_id) >= sizeof(route->stream_id) ||
+        (passphrase && (passphrase_len < MIN_PASSPHRASE || passphrase_len >= sizeof(route->passphrase)))) {
+        send_error(route->control_fd, "invalid stream id or passphrase");
+        return;
+    }
+
+    ShmRing *ring = shm_ring_create(listener.ring_slots, SHM_RING_DEFAULT_SLOT_SIZE);
+    if (!ring) {
+        send_error(route->control_fd, "out of memory");
+        return;
+    }
+
+    pthread_mutex_lock(&listener.lock);
+    gboolean duplicate = g_hash_table_contains(listener.by_stream_id, stream_id);
+    if (!duplicate) {
+        snprintf(route->stream_id, sizeof(route->stream_id), "%s", stream_id);
+        snprintf(route->passphrase, sizeof(route->passphrase), "%s", passphrase ? passphrase : "");
+        route->ring = ring;
+        g_hash_table_insert(listener.by_stream_id, route->stream_id, route);
+    }
+    pthread_mutex_unlock(&listener.lock);
+
+    if (duplicate) {
+        shm_ring_free(ring);
+        send_error(route->control_fd, "stream id already registered");
+        return;
+    }
+
+    if (!send_ring(route->control_fd, ring)) {
+        g_printerr("SharedListener: failed to hand ring to '%s'\n", stream_id);
+        return;
+    }
+    g_print("SharedListener: route '%s' registered\n", stream_id);
+}
+
+static void read_control(Route *route)
+{
+    ssize_t n = recv(route->control_fd, route->control_buf + route->control_len,
+                     sizeof(route->control_buf) - 1 - route->control_len, 0);
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        unregister_route(route);
+        return;
+    }
+    if (n < 0) return;
+    route->control_len += (gsize)n;
+    route->control_buf[route->control_len] = '\0';
+
+    char *newline;
+    while ((newline = strchr(route->control_buf, '\n')) != NULL) {
+        *newline = '\0';
+        handle_command(route, route->control_buf);
+        gsize consumed = (gsize)(newline + 1 - route->control_buf);
+        route->control_len -= consumed;
+        memmove(route->control_buf, newline + 1, route->control_len + 1);
+    }
+
+    if (route->control_len == sizeof(route->control_buf) - 1) {
+        send_error(route->control_fd, "line too long");
+        unregister_route(route);
+    }
+}
+
+static void accept_route(void)
+{
+    int fd = accept4(listener.control_listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    if (fd < 0) return;
+
+    Route *route = NULL;
+    for (int i = 0; i < MAX_ROUTES && !route; i++) {
+        if (!listener.routes[i].in_use) route = &listener.routes[i];
+    }
+    if (!route) {
+        send_error(fd, "too many routes");
+        close(fd);
+        return;
+    }
+
+    memset(route, 0, sizeof(*route));
+    route->in_use = TRUE;
+    route->control_fd = fd;
+    route->caller = SRT_INVALID_SOCK;
+
+    int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+    srt_epoll_add_ssock(listener.eid, fd, &events);
+}
+
+// =============================================================================
+// Setup and Event Loop
+// =============================================================================
+
+static gboolean open_control_socket(void)
+{
+    listener.control_listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listener.control_listen_fd < 0) return FALSE;
+
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", listener.control_path);
+    unlink(listener.control_path);
+
+    if (bind(listener.control_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+        listen(listener.control_listen_fd, 64) != 0) {
+        g_printerr("SharedListener: cannot listen on %s: %s\n", listener.control_path, strerror(errno));
+        close(listener.control_listen_fd);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static gboolean open_srt_socket(const char *address, int port)
+{
+    char service[16];
+    snprintf(service, sizeof(service), "%d", port);
+    struct addrinfo hints = {.ai_flags = AI_PASSIVE | AI_NUMERICHOST, .ai_socktype = SOCK_DGRAM};
+    struct addrinfo *res = NULL;
+    if (getaddrinfo(address, service, &hints, &res) != 0 || !res) {
+        g_printerr("SharedListener: invalid address %s\n", address);
+        return FALSE;
+    }
+
+    listener.socket = srt_create_socket();
+    int no = 0;
+    srt_setsockflag(listener.socket, SRTO_RCVSYN, &no, sizeof(no));
+    if (listener.latency_ms > 0) {
+        srt_setsockflag(listener.socket, SRTO_LATENCY, &listener.latency_ms, sizeof(listener.latency_ms));
+    }
+
+    gboolean ok = srt_bind(listener.socket, res->ai_addr, (int)res->ai_addrlen) != SRT_ERROR &&
+                  srt_listen_callback(listener.socket, on_listen, NULL) != SRT_ERROR &&
+                  srt_listen(listener.socket, 64) != SRT_ERROR;
+    freeaddrinfo(res);
+
+    if (!ok) {
+        g_printerr("SharedListener: cannot listen on %s:%d: %s\n", address, port, srt_getlasterror_str());
+        srt_close(listener.socket);
+    }
+    return ok;
+}
+
+static void event_loop(void)
+{
+    time_t last_stats = 0;
+
+    while (listener_running) {
+        SRTSOCKET ready[MAX_EVENTS];
+        SYSSOCKET sys_ready[MAX_EVENTS];
+        int n_ready = MAX_EVENTS, n_sys_ready = MAX_EVENTS;
+
+        int ret = srt_epoll_wait(listener.eid, ready, &n_ready, NULL, NULL, 500, sys_ready, &n_sys_ready, NULL, NULL);
+        if (ret < 0) {
+            n_ready = 0;
+            n_sys_ready = 0;
+        }
+
+        for (int i = 0; i < n_ready; i++) {
+            if (ready[i] == listener.socket) {
+                accept_callers();
+                continue;
+            }
+            Route *route = route_for_caller(ready[i]);
+            if (route) {
+                read_caller(route);
+            } else {
+                srt_epoll_remove_usock(listener.eid, ready[i]);
+                srt_close(ready[i]);
+            }
+        }
+
+        for (int i = 0; i < n_sys_ready; i++) {
+            if (sys_ready[i] == listener.control_listen_fd) {
+                accept_route();
+                continue;
+            }
+            Route *route = route_for_control(sys_ready[i]);
+            if (route) read_control(route);
+        }
+
+        time_t now = time(NULL);
+        if (now != last_stats) {
+            publish_caller_stats();
+            last_stats = now;
+        }
+    }
+}
+
+int srt_listener_run(cJSON *config)
+{
+    cJSON *obj = cJSON_GetObjectItem(config, "listener");
+    cJSON *port = cJSON_GetObjectItem(obj, "localport");
+    if (!cJSON_IsObject(obj) || !cJSON_IsNumber(port)) {
+        g_printerr("SharedListener: missing 'listener' object or 'localport'\n");
+        return 1;
+    }
+
+    cJSON *address = cJSON_GetObjectItem(obj, "localaddress");
+    cJSON *latency = cJSON_GetObjectItem(obj, "latency");
+    cJSON *control = cJSON_GetObjectItem(obj, "control");
+    cJSON *ring_slots = cJSON_GetObjectItem(obj, "ring-slots");
+
+    memset(&listener, 0, sizeof(listener));
+    listener.admission = admission_new(cJSON_GetObjectItem(obj, "admission"));
+    if (!listener.admission) return 1;
+    pthread_mutex_init(&listener.lock, NULL);
+    listener.by_stream_id = g_hash_table_new(g_str_hash, g_str_equal);
+    listener.latency_ms = cJSON_IsNumber(latency) ? latency->valueint : 0;
+    listener.ring_slots = cJSON_IsNumber(ring_slots) && ring_slots->valueint > 0 ? (guint)ring_slots->valueint
+                                                                                  : SHM_RING_DEFAULT_SLOTS;
+    if (cJSON_IsString(control)) {
+        snprintf(listener.control_path, sizeof(listener.control_path), "%s", control->valuestring);
+    } else {
+        snprintf(listener.control_path, sizeof(listener.control_path), SRT_LISTENER_CONTROL_FORMAT, port->valueint);
+    }
+    for (int i = 0; i < MAX_ROUTES; i++) listener.routes[i].caller = SRT_INVALID_SOCK;
+
+    signal(SIGTERM, on_signal);
+    signal(SIGINT, on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    srt_startup();
+    const char *host = cJSON_IsString(address) && address->valuestring[0] ? address->valuestring : "0.0.0.0";
+    if (!open_control_socket() || !open_srt_socket(host, port->valueint)) {
+        srt_cleanup();
+        admission_free(listener.admission);
+        return 1;
+    }
+
+    listener.eid = srt_epoll_create();
+    int events = SRT_EPOLL_IN | SRT_EPOLL_ERR;
+    srt_epoll_add_usock(listener.eid, listener.socket, &events);
+    srt_epoll_add_ssock(listener.eid, listener.control_listen_fd, &events);
+
+    g_print("SharedListener: listening on %s:%d, routes register on %s\n", host, port->valueint,
+            listener.control_path);
+    event_loop();
+
+    for (int i = 0; i < MAX_ROUTES; i++) {
+        if (listener.routes[i].in_use) unregister_route(&listener.routes[i]);
+    }
+    srt_epoll_release(listener.eid);
+    srt_close(listener.socket);
+    close(listener.control_listen_fd);
+    unlink(listener.control_path);
+    srt_cleanup();
+
+    g_hash_table_destroy(listener.by_stream_id);
+    pthread_mutex_destroy(&listener.lock);
+    admission_free(listener.admission);
+    return 0;
+}
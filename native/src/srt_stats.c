@@ -0,0 +1,352 @@
+#include "srt_stats.h"
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// libsrt's MAX_SOCKET_VAL: IDs count down from a random start and wrap back to this
+#define SOCKET_ID_MAX ((1 << 30) - 1)
+// More new IDs than this between two refreshes means the index fell behind; only the nearest are scanned
+#define SCAN_LIMIT 65536
+
+typedef struct {
+    SRTSOCKET sock;
+    SRT_SOCKSTATUS state;
+    gboolean have_addresses;
+    guint16 local_port;
+    struct sockaddr_storage peer;
+    const SrtEndpoint *owner; // The endpoint it was first looked up for
+} IndexedSocket;
+
+struct SrtSocketIndex {
+    SRTSOCKET probe; // ID of the previous probe socket; everything newer is below it
+    GArray *sockets; // IndexedSocket, for sockets not yet broken or closed
+};
+
+gboolean srt_socket_stats_read(SRTSOCKET sock, gboolean clear, SrtSocketStats *stats)
+{
+    SRT_TRACEBSTATS perf;
+    if (srt_bstats(sock, &perf, clear) != 0) return FALSE;
+
+    *stats = (SrtSocketStats){
+        .packets_sent = perf.pktSentTotal,
+        .packets_received = perf.pktRecvTotal,
+        .packets_sent_lost = perf.pktSndLossTotal,
+        .packets_received_lost = perf.pktRcvLossTotal,
+        .packets_retransmitted = perf.pktRetransTotal,
+        .packets_sent_dropped = perf.pktSndDropTotal,
+        .packets_received_dropped = perf.pktRcvDropTotal,
+        .packets_belated = perf.pktRcvBelated,
+        .bytes_sent = perf.byteSentTotal,
+        .bytes_received = perf.byteRecvTotal,
+        .bytes_sent_interval = perf.byteSent,
+        .bytes_received_interval = perf.byteRecv,
+        .send_rate_mbps = perf.mbpsSendRate,
+        .receive_rate_mbps = perf.mbpsRecvRate,
+        .rtt_ms = perf.msRTT,
+        .bandwidth_mbps = perf.mbpsBandwidth,
+        .flight_size = perf.pktFlightSize,
+        .congestion_window = perf.pktCongestionWindow,
+        .flow_window = perf.pktFlowWindow,
+        .send_buffer_packets = perf.pktSndBuf,
+        .send_buffer_bytes = perf.byteSndBuf,
+        .send_buffer_ms = perf.msSndBuf,
+        .receive_buffer_packets = perf.pktRcvBuf,
+        .receive_buffer_ms = perf.msRcvBuf,
+        .reorder_distance = perf.pktReorderDistance,
+        .send_latency_ms = perf.msSndTsbPdDelay,
+        .receive_latency_ms = perf.msRcvTsbPdDelay,
+    };
+    return TRUE;
+}
+
+void srt_socket_stats_sender_to_json(const SrtSocketStats *stats, cJSON *obj)
+{
+    cJSON_AddNumberToObject(obj, "packets-sent", (double)stats->packets_sent);
+    cJSON_AddNumberToObject(obj, "packets-sent-lost", (double)stats->packets_sent_lost);
+    cJSON_AddNumberToObject(obj, "packets-sent-dropped", (double)stats->packets_sent_dropped);
+    cJSON_AddNumberToObject(obj, "packets-sent-retransmitted", (double)stats->packets_retransmitted);
+    cJSON_AddNumberToObject(obj, "bytes-sent", (double)stats->bytes_sent);
+    cJSON_AddNumberToObject(obj, "rtt-ms", stats->rtt_ms);
+    cJSON_AddNumberToObject(obj, "send-rate-mbps", stats->send_rate_mbps);
+    cJSON_AddNumberToObject(obj, "bandwidth-mbps", stats->bandwidth_mbps);
+    cJSON_AddNumberToObject(obj, "negotiated-latency-ms", stats->send_latency_ms);
+    cJSON_AddNumberToObject(obj, "flight-size", stats->flight_size);
+    cJSON_AddNumberToObject(obj, "congestion-window", stats->congestion_window);
+    cJSON_AddNumberToObject(obj, "send-buffer-packets", stats->send_buffer_packets);
+    cJSON_AddNumberToObject(obj, "send-buffer-bytes", stats->send_buffer_bytes);
+    cJSON_AddNumberToObject(obj, "send-buffer-ms", stats->send_buffer_ms);
+}
+
+void srt_socket_stats_receiver_to_json(const SrtSocketStats *stats, cJSON *obj)
+{
+    cJSON_AddNumberToObject(obj, "packets-received", (double)stats->packets_received);
+    cJSON_AddNumberToObject(obj, "packets-received-lost", (double)stats->packets_received_lost);
+    cJSON_AddNumberToObject(obj, "packets-received-dropped", (double)stats->packets_received_dropped);
+    cJSON_AddNumberToObject(obj, "packets-received-retransmitted", (double)stats->packets_retransmitted);
+    cJSON_AddNumberToObject(obj, "packets-belated", (double)stats->packets_belated);
+    cJSON_AddNumberToObject(obj, "bytes-received", (double)stats->bytes_received);
+    cJSON_AddNumberToObject(obj, "rtt-ms", stats->rtt_ms);
+    cJSON_AddNumberToObject(obj, "receive-rate-mbps", stats->receive_rate_mbps);
+    cJSON_AddNumberToObject(obj, "bandwidth-mbps", stats->bandwidth_mbps);
+    cJSON_AddNumberToObject(obj, "negotiated-latency-ms", stats->receive_latency_ms);
+    cJSON_AddNumberToObject(obj, "receive-buffer-packets", stats->receive_buffer_packets);
+    cJSON_AddNumberToObject(obj, "receive-buffer-ms", stats->receive_buffer_ms);
+    cJSON_AddNumberToObject(obj, "reorder-distance", stats->reorder_distance);
+}
+
+void srt_socket_stats_accumulate(SrtSocketStats *total, const SrtSocketStats *stats)
+{
+    total->packets_sent += stats->packets_sent;
+    total->packets_received += stats->packets_received;
+    total->packets_sent_lost += stats->packets_sent_lost;
+    total->packets_received_lost += stats->packets_received_lost;
+    total->packets_retransmitted += stats->packets_retransmitted;
+    total->packets_sent_dropped += stats->packets_sent_dropped;
+    total->packets_received_dropped += stats->packets_received_dropped;
+    total->packets_belated += stats->packets_belated;
+    total->bytes_sent += stats->bytes_sent;
+    total->bytes_received += stats->bytes_received;
+    total->bytes_sent_interval += stats->bytes_sent_interval;
+    total->bytes_received_interval += stats->bytes_received_interval;
+    total->send_rate_mbps += stats->send_rate_mbps;
+    total->receive_rate_mbps += stats->receive_rate_mbps;
+    total->bandwidth_mbps += stats->bandwidth_mbps;
+    total->flight_size += stats->flight_size;
+    total->congestion_window += stats->congestion_window;
+    total->flow_window += stats->flow_window;
+    total->send_buffer_packets += stats->send_buffer_packets;
+    total->send_buffer_bytes += stats->send_buffer_bytes;
+    total->receive_buffer_packets += stats->receive_buffer_packets;
+    total->rtt_ms = MAX(total->rtt_ms, stats->rtt_ms);
+    total->send_buffer_ms = MAX(total->send_buffer_ms, stats->send_buffer_ms);
+    total->receive_buffer_ms = MAX(total->receive_buffer_ms, stats->receive_buffer_ms);
+    total->reorder_distance = MAX(total->reorder_distance, stats->reorder_distance);
+    total->send_latency_ms = MAX(total->send_latency_ms, stats->send_latency_ms);
+    total->receive_latency_ms = MAX(total->receive_latency_ms, stats->receive_latency_ms);
+}
+
+gboolean srt_endpoint_from_uri(const char *uri, SrtEndpoint *endpoint)
+{
+    memset(endpoint, 0, sizeof(*endpoint));
+    endpoint->mode = SRT_ENDPOINT_CALLER;
+    if (!uri || strncmp(uri, "srt://", 6) != 0) return FALSE;
+
+    const char *p = uri + 6;
+    const char *host_end;
+    if (*p == '[') { // [IPv6]:port
+        host_end = strchr(p, ']');
+        if (!host_end) return FALSE;
+        g_strlcpy(endpoint->host, p + 1, MIN(sizeof(endpoint->host), (gsize)(host_end - p)));
+        p = host_end + 1;
+    } else {
+        host_end = p + strcspn(p, ":/?");
+        g_strlcpy(endpoint->host, p, MIN(sizeof(endpoint->host), (gsize)(host_end - p) + 1));
+        p = host_end;
+    }
+    if (*p == ':') {
+        long port = strtol(p + 1, (char **)&p, 10);
+        if (port < 0 || port > 65535) return FALSE;
+        endpoint->port = (guint16)port;
+    }
+
+    const char *query = strchr(p, '?');
+    gchar **params = g_strsplit(query ? query + 1 : "", "&", -1);
+    for (gchar **param = params; *param; param++) {
+        if (strcmp(*param, "mode=listener") == 0) {
+            endpoint->mode = SRT_ENDPOINT_LISTENER;
+        } else if (strcmp(*param, "mode=rendezvous") == 0) {
+            endpoint->mode = SRT_ENDPOINT_RENDEZVOUS;
+        } else if (g_str_has_prefix(*param, "localport=")) {
+            endpoint->local_port = (guint16)atoi(*param + 10);
+        }
+    }
+    g_strfreev(params);
+    return endpoint->port != 0;
+}
+
+static guint16 address_port(const struct sockaddr_storage *addr)
+{
+    if (addr->ss_family == AF_INET) return ntohs(((const struct sockaddr_in *)addr)->sin_port);
+    if (addr->ss_family == AF_INET6) return ntohs(((const struct sockaddr_in6 *)addr)->sin6_port);
+    return 0;
+}
+
+gboolean srt_endpoint_resolve(SrtEndpoint *endpoint)
+{
+    endpoint->n_addresses = 0;
+    if (endpoint->mode == SRT_ENDPOINT_LISTENER) return TRUE;
+
+    struct addrinfo hints = {.ai_family = AF_UNSPEC, .ai_socktype = SOCK_DGRAM};
+    struct addrinfo *result = NULL;
+    if (!endpoint->host[0] || getaddrinfo(endpoint->host, NULL, &hints, &result) != 0) return FALSE;
+    for (struct addrinfo *ai = result; ai && endpoint->n_addresses < SRT_ENDPOINT_MAX_ADDRESSES; ai = ai->ai_next) {
+        if (ai->ai_family != AF_INET && ai->ai_family != AF_INET6) continue;
+        struct sockaddr_storage *addr = &endpoint->addresses[endpoint->n_addresses++];
+        memset(addr, 0, sizeof(*addr));
+        memcpy(addr, ai->ai_addr, MIN((gsize)ai->ai_addrlen, sizeof(*addr)));
+    }
+    freeaddrinfo(result);
+    return endpoint->n_addresses > 0;
+}
+
+// The IPv4 address of `addr`, also when an IPv6 socket shows an IPv4 peer as ::ffff:a.b.c.d
+static gboolean address_v4(const struct sockaddr_storage *addr, struct in_addr *v4)
+{
+    if (addr->ss_family == AF_INET) {
+        *v4 = ((const struct sockaddr_in *)addr)->sin_addr;
+        return TRUE;
+    }
+    const struct in6_addr *v6 = &((const struct sockaddr_in6 *)addr)->sin6_addr;
+    if (addr->ss_family != AF_INET6 || !IN6_IS_ADDR_V4MAPPED(v6)) return FALSE;
+    memcpy(v4, &v6->s6_addr[12], sizeof(*v4));
+    return TRUE;
+}
+
+static gboolean address_equal(const struct sockaddr_storage *a, const struct sockaddr_storage *b)
+{
+    struct in_addr a4, b4;
+    gboolean a_is_v4 = address_v4(a, &a4);
+    gboolean b_is_v4 = address_v4(b, &b4);
+    if (a_is_v4 || b_is_v4) return a_is_v4 && b_is_v4 && a4.s_addr == b4.s_addr;
+    return a->ss_family == AF_INET6 && b->ss_family == AF_INET6 &&
+           memcmp(&((const struct sockaddr_in6 *)a)->sin6_addr, &((const struct sockaddr_in6 *)b)->sin6_addr,
+                  sizeof(struct in6_addr)) == 0;
+}
+
+static gboolean address_matches_endpoint(const struct sockaddr_storage *addr, const SrtEndpoint *endpoint)
+{
+    for (guint i = 0; i < endpoint->n_addresses; i++) {
+        if (address_equal(addr, &endpoint->addresses[i])) return TRUE;
+    }
+    return FALSE;
+}
+
+// How far `from` counts down to `to`, wrapping at SOCKET_ID_MAX
+static guint32 id_distance(SRTSOCKET from, SRTSOCKET to)
+{
+    return from > to ? (guint32)(from - to) : (guint32)(from + SOCKET_ID_MAX - to);
+}
+
+SrtSocketIndex *srt_socket_index_new(void)
+{
+    srt_startup();
+    SRTSOCKET first = srt_create_socket();
+    SRTSOCKET second = srt_create_socket();
+    if (first != SRT_INVALID_SOCK) srt_close(first);
+    if (second != SRT_INVALID_SOCK) srt_close(second);
+
+    // Another thread may create sockets in between, but the second probe still has to be below the first
+    if (first == SRT_INVALID_SOCK || second == SRT_INVALID_SOCK || id_distance(first, second) >= SCAN_LIMIT) {
+        g_printerr("SRT stats: libsrt socket IDs are not allocated in descending order, using element stats\n");
+        srt_cleanup();
+        return NULL;
+    }
+
+    SrtSocketIndex *index = g_new0(SrtSocketIndex, 1);
+    index->sockets = g_array_new(FALSE, TRUE, sizeof(IndexedSocket));
+    index->probe = second;
+    return index;
+}
+
+void srt_socket_index_free(SrtSocketIndex *index)
+{
+    if (!index) return;
+    g_array_free(index->sockets, TRUE);
+    g_free(index);
+    srt_cleanup();
+}
+
+// New sockets lie strictly between the previous probe and a fresh one, counting down and possibly wrapping
+static void scan_new_sockets(SrtSocketIndex *index)
+{
+    SRTSOCKET probe = srt_create_socket();
+    if (probe == SRT_INVALID_SOCK) return;
+    srt_close(probe);
+
+    SRTSOCKET id = index->probe == SRT_INVALID_SOCK ? probe : index->probe - 1;
+    for (guint32 count = 0; id != probe && count < SCAN_LIMIT; count++, id--) {
+        if (id <= 0) id = SOCKET_ID_MAX;
+        if (srt_getsockstate(id) >= SRTS_BROKEN) continue;
+        IndexedSocket entry = {.sock = id};
+        g_array_append_val(index->sockets, entry);
+    }
+    index->probe = probe;
+}
+
+void srt_socket_index_refresh(SrtSocketIndex *index)
+{
+    scan_new_sockets(index);
+
+    // Forget sockets that broke or closed; take the addresses of those that have connected or listen
+    for (guint i = 0; i < index->sockets->len;) {
+        IndexedSocket *entry = &g_array_index(index->sockets, IndexedSocket, i);
+        entry->state = srt_getsockstate(entry->sock);
+        if (entry->state >= SRTS_BROKEN) {
+            g_array_remove_index_fast(index->sockets, i);
+            continue;
+        }
+        if (!entry->have_addresses && (entry->state == SRTS_CONNECTED || entry->state == SRTS_LISTENING)) {
+            struct sockaddr_storage local;
+            int len = sizeof(local);
+            if (srt_getsockname(entry->sock, (struct sockaddr *)&local, &len) == 0) {
+                entry->local_port = address_port(&local);
+            }
+            len = sizeof(entry->peer);
+            if (entry->state == SRTS_CONNECTED) srt_getpeername(entry->sock, (struct sockaddr *)&entry->peer, &len);
+            entry->have_addresses = TRUE;
+        }
+        i++;
+    }
+}
+
+gint srt_socket_index_lookup(SrtSocketIndex *index, const SrtEndpoint *endpoint, SRTSOCKET *socks, guint max)
+{
+    if (!index) return -1;
+
+    gboolean found = FALSE;
+    guint n = 0;
+    for (guint i = 0; i < index->sockets->len; i++) {
+        IndexedSocket *entry = &g_array_index(index->sockets, IndexedSocket, i);
+        if (!entry->have_addresses || (entry->owner && entry->owner != endpoint)) continue;
+
+        gboolean match;
+        if (endpoint->mode == SRT_ENDPOINT_LISTENER) {
+            match = entry->local_port == endpoint->port;
+            if (match && entry->state == SRTS_LISTENING) {
+                found = TRUE;
+                continue;
+            }
+        } else {
+            guint16 local_port = endpoint->mode == SRT_ENDPOINT_RENDEZVOUS && !endpoint->local_port
+                                     ? endpoint->port
+                                     : endpoint->local_port;
+            match = entry->state == SRTS_CONNECTED && address_port(&entry->peer) == endpoint->port &&
+                    address_matches_endpoint(&entry->peer, endpoint) &&
+                    (!local_port || entry->local_port == local_port);
+        }
+        if (!match || entry->state != SRTS_CONNECTED) continue;
+        entry->owner = endpoint;
+        found = TRUE;
+        if (n < max) socks[n++] = entry->sock;
+    }
+    return found ? (gint)n : -1;
+}
+
+void srt_socket_peer_to_string(SRTSOCKET sock, char *buf, gsize size)
+{
+    struct sockaddr_storage addr = {0};
+    int len = sizeof(addr);
+    char host[INET6_ADDRSTRLEN] = "";
+    if (srt_getpeername(sock, (struct sockaddr *)&addr, &len) == 0) {
+        if (addr.ss_family == AF_INET) {
+            inet_ntop(AF_INET, &((struct sockaddr_in *)&addr)->sin_addr, host, sizeof(host));
+        } else if (addr.ss_family == AF_INET6) {
+            inet_ntop(AF_INET6, &((struct sockaddr_in6 *)&addr)->sin6_addr, host, sizeof(host));
+        }
+    }
+    snprintf(buf, size, "%s:%u", host, address_port(&addr));
+}
@@ -0,0 +1,400 @@
+#define _GNU_SOURCE
+#include "thread_policy.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#define MAX_PLACEMENTS 64
+
+typedef struct {
+    gboolean configured;
+#ifdef __linux__
+    cpu_set_t media_cpus;
+    cpu_set_t analysis_cpus;
+#endif
+    gboolean has_media_cpus;
+    gboolean has_analysis_cpus;
+    gint sched_policy; // SCHED_OTHER, SCHED_FIFO or SCHED_RR for media threads
+    gint priority;
+    gint media_nice;
+    gint analysis_nice;
+} ThreadPolicy;
+
+typedef struct {
+    char name[32];
+    ThreadRole role;
+    pid_t tid;
+} ThreadPlacement;
+
+static ThreadPolicy thread_policy = {0};
+static ThreadPlacement placements[MAX_PLACEMENTS];
+static int placement_count = 0;
+static pthread_mutex_t placement_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static const char *role_names[] = {"source", "sink", "analysis"};
+static const char *config_keys[] = {"media-cpus", "analysis-cpus", "policy", "priority", "nice", "analysis-nice"};
+
+static const char *policy_name(int policy)
+{
+    return policy == SCHED_FIFO ? "fifo" : policy == SCHED_RR ? "rr" : "other";
+}
+
+static pid_t current_tid(void)
+{
+#ifdef __linux__
+    return (pid_t)syscall(SYS_gettid);
+#else
+    return getpid();
+#endif
+}
+
+#ifdef __linux__
+// Parse a CPU list like "0-3,6" into a cpu_set_t. Only digits, '-' and ',' are accepted: no
+// spaces, signs or empty items, and no CPU beyond what a cpu_set_t holds.
+static gboolean parse_cpu_list(const char *list, cpu_set_t *set)
+{
+    CPU_ZERO(set);
+    const char *p = list;
+
+    for (;;) {
+        char *end;
+        if (!isdigit((unsigned char)*p)) return FALSE;
+        long first = strtol(p, &end, 10);
+        if (first >= CPU_SETSIZE) return FALSE;
+        long last = first;
+        p = end;
+
+        if (*p == '-') {
+            p++;
+            if (!isdigit((unsigned char)*p)) return FALSE;
+            last = strtol(p, &end, 10);
+            if (last < first || last >= CPU_SETSIZE) return FALSE;
+            p = end;
+        }
+
+        for (long cpu = first; cpu <= last; cpu++) CPU_SET(cpu, set);
+        if (*p != ',') break;
+        p++;
+    }
+    return *p == '\0' && CPU_COUNT(set) > 0;
+}
+
+static void format_cpu_list(const cpu_set_t *set, char *buf, gsize size)
+{
+    gsize len = 0;
+    buf[0] = '\0';
+
+    for (int cpu = 0; cpu < CPU_SETSIZE && len < size; cpu++) {
+        if (!CPU_ISSET(cpu, set)) continue;
+        int last = cpu;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, set)) last++;
+
+        if (last == cpu) {
+            len += snprintf(buf + len, size - len, "%s%d", len ? "," : "", cpu);
+        } else {
+            len += snprintf(buf + len, size - len, "%s%d-%d", len ? "," : "", cpu, last);
+        }
+        cpu = last;
+    }
+}
+
+// CPU the thread last ran on (field 39 of /proc/self/task/<tid>/stat), -1 if unknown
+static int last_cpu(pid_t tid)
+{
+    char path[64], line[1024];
+    snprintf(path, sizeof(path), "/proc/self/task/%d/stat", (int)tid);
+
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    gboolean ok = fgets(line, sizeof(line), f) != NULL;
+    fclose(f);
+    if (!ok) return -1;
+
+    // The command name may contain spaces; fields are counted from the closing parenthesis
+    char *p = strrchr(line, ')');
+    if (!p) return -1;
+    for (int field = 2; field < 39 && p; field++) p = strchr(p + 1, ' ');
+    return p ? atoi(p + 1) : -1;
+}
+#endif
+
+gboolean thread_policy_configure(cJSON *config)
+{
+    memset(&thread_policy, 0, sizeof(thread_policy));
+    thread_policy.sched_policy = SCHED_OTHER;
+    thread_policy.analysis_nice = 10;
+
+    if (!config) return TRUE;
+    if (!cJSON_IsObject(config)) {
+        g_printerr("Threads: 'threads' must be an object\n");
+        return FALSE;
+    }
+
+    // A misspelt key (or a role that has no CPU set, like "sink-cpus") would silently leave threads unplaced
+    cJSON *item;
+    cJSON_ArrayForEach(item, config)
+    {
+        gboolean known = FALSE;
+        for (guint i = 0; i < G_N_ELEMENTS(config_keys) && !known; i++) {
+            known = g_strcmp0(item->string, config_keys[i]) == 0;
+        }
+        if (!known) {
+            g_printerr("Threads: unknown key '%s'\n", item->string);
+            return FALSE;
+        }
+    }
+
+#ifdef __linux__
+    cJSON *media_cpus = cJSON_GetObjectItem(config, "media-cpus");
+    if (cJSON_IsString(media_cpus)) {
+        if (!parse_cpu_list(media_cpus->valuestring, &thread_policy.media_cpus)) {
+            g_printerr("Threads: invalid media-cpus '%s'\n", media_cpus->valuestring);
+            return FALSE;
+        }
+        thread_policy.has_media_cpus = TRUE;
+    }
+
+    cJSON *analysis_cpus = cJSON_GetObjectItem(config, "analysis-cpus");
+    if (cJSON_IsString(analysis_cpus)) {
+        if (!parse_cpu_list(analysis_cpus->valuestring, &thread_policy.analysis_cpus)) {
+            g_printerr("Threads: invalid analysis-cpus '%s'\n", analysis_cpus->valuestring);
+            return FALSE;
+        }
+        thread_policy.has_analysis_cpus = TRUE;
+    }
+#endif
+
+    cJSON *policy = cJSON_GetObjectItem(config, "policy");
+    if (cJSON_IsString(policy)) {
+        if (strcmp(policy->valuestring, "fifo") == 0) {
+            thread_policy.sched_policy = SCHED_FIFO;
+        } else if (strcmp(policy->valuestring, "rr") == 0) {
+            thread_policy.sched_policy = SCHED_RR;
+        } else if (strcmp(policy->valuestring, "other") != 0) {
+            g_printerr("Threads: unknown policy '%s' (expected fifo, rr or other)\n", policy->valuestring);
+            return FALSE;
+        }
+    }
+
+    cJSON *priority = cJSON_GetObjectItem(config, "priority");
+    thread_policy.priority = cJSON_IsNumber(priority) ? priority->valueint : 10;
+    if (thread_policy.sched_policy != SCHED_OTHER) {
+        int min = sched_get_priority_min(thread_policy.sched_policy);
+        int max = sched_get_priority_max(thread_policy.sched_policy);
+        thread_policy.priority = CLAMP(thread_policy.priority, min, max);
+    }
+
+    cJSON *nice_value = cJSON_GetObjectItem(config, "nice");
+    if (cJSON_IsNumber(nice_value)) thread_policy.media_nice = CLAMP(nice_value->valueint, -20, 19);
+
+    cJSON *analysis_nice = cJSON_GetObjectItem(config, "analysis-nice");
+    if (cJSON_IsNumber(analysis_nice)) thread_policy.analysis_nice = CLAMP(analysis_nice->valueint, -20, 19);
+
+    thread_policy.configured = TRUE;
+    g_print("Threads: policy=%s priority=%d nice=%d analysis-nice=%d\n", policy_name(thread_policy.sched_policy),
+            thread_policy.priority, thread_policy.media_nice, thread_policy.analysis_nice);
+    return TRUE;
+}
+
+// Caller holds placement_mutex. The entry in `slot` is replaced by the last one.
+static void remove_placement(int slot)
+{
+    placements[slot] = placements[--placement_count];
+}
+
+static gboolean thread_alive(pid_t tid)
+{
+#ifdef __linux__
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/self/task/%d", (int)tid);
+    return access(path, F_OK) == 0;
+#else
+    return tid == current_tid();
+#endif
+}
+
+// Caller holds placement_mutex. Drops the entries of threads that exited without thread_policy_forget_self()
+static void prune_exited_threads(void)
+{
+    for (int i = placement_count - 1; i >= 0; i--) {
+        if (!thread_alive(placements[i].tid)) remove_placement(i);
+    }
+}
+
+void thread_policy_apply_self(ThreadRole role, const char *name)
+{
+    if ((guint)role >= G_N_ELEMENTS(role_names)) {
+        g_printerr("Threads: %s: unknown role %d, left as it is\n", name, (int)role);
+        return;
+    }
+    pid_t tid = current_tid();
+
+#ifdef __linux__
+    if (thread_policy.configured) {
+        gboolean media = role != THREAD_ROLE_ANALYSIS;
+        gboolean realtime = FALSE;
+
+        const cpu_set_t *cpus = NULL;
+        if (media && thread_policy.has_media_cpus) cpus = &thread_policy.media_cpus;
+        if (!media && thread_policy.has_analysis_cpus) cpus = &thread_policy.analysis_cpus;
+        if (cpus) {
+            int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), cpus);
+            if (err != 0) g_printerr("Threads: %s: failed to set CPU affinity: %s\n", name, strerror(err));
+        }
+
+        if (media && thread_policy.sched_policy != SCHED_OTHER) {
+            struct sched_param param = {.sched_priority = thread_policy.priority};
+            int err = pthread_setschedparam(pthread_self(), thread_policy.sched_policy, &param);
+            if (err == 0) {
+                realtime = TRUE;
+            } else {
+                g_printerr("Threads: %s: real-time scheduling not permitted (%s), using nice %d\n", name,
+                           strerror(err), thread_policy.media_nice);
+            }
+        }
+
+        // On Linux the nice value is per thread when addressed by tid
+        if (!realtime) {
+            int nice_value = media ? thread_policy.media_nice : thread_policy.analysis_nice;
+            if (setpriority(PRIO_PROCESS, tid, nice_value) != 0) {
+                g_printerr("Threads: %s: failed to set nice %d: %s\n", name, nice_value, strerror(errno));
+            }
+        }
+    }
+#endif
+
+    pthread_mutex_lock(&placement_mutex);
+    int slot = 0;
+    while (slot < placement_count && placements[slot].tid != tid) slot++;
+    if (slot == MAX_PLACEMENTS) {
+        prune_exited_threads();
+        slot = placement_count;
+    }
+    if (slot < MAX_PLACEMENTS) {
+        if (slot == placement_count) placement_count++;
+        snprintf(placements[slot].name, sizeof(placements[slot].name), "%s", name);
+        placements[slot].role = role;
+        placements[slot].tid = tid;
+    }
+    pthread_mutex_unlock(&placement_mutex);
+}
+
+// Whole-process totals, so the effect of thread placement and pooling shows up in the stats
+static void add_process_stats(cJSON *root)
+{
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+        cJSON_AddNumberToObject(root, "context-switches-voluntary", (double)usage.ru_nvcsw);
+        cJSON_AddNumberToObject(root, "context-switches-involuntary", (double)usage.ru_nivcsw);
+    }
+
+#ifdef __linux__
+    FILE *f = fopen("/proc/self/status", "r");
+    if (!f) return;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        if (strncmp(line, "Threads:", 8) == 0) {
+            cJSON_AddNumberToObject(root, "process-threads", atoi(line + 8));
+            break;
+        }
+    }
+    fclose(f);
+#endif
+}
+
+// What the route asked for, next to what each thread got
+static void add_policy_stats(cJSON *root)
+{
+    if (!thread_policy.configured) return;
+    cJSON *policy = cJSON_AddObjectToObject(root, "thread-policy");
+#ifdef __linux__
+    char cpus[256];
+    if (thread_policy.has_media_cpus) {
+        format_cpu_list(&thread_policy.media_cpus, cpus, sizeof(cpus));
+        cJSON_AddStringToObject(policy, "media-cpus", cpus);
+    }
+    if (thread_policy.has_analysis_cpus) {
+        format_cpu_list(&thread_policy.analysis_cpus, cpus, sizeof(cpus));
+        cJSON_AddStringToObject(policy, "analysis-cpus", cpus);
+    }
+#endif
+    cJSON_AddStringToObject(policy, "policy", policy_name(thread_policy.sched_policy));
+    cJSON_AddNumberToObject(policy, "priority", thread_policy.priority);
+    cJSON_AddNumberToObject(policy, "nice", thread_policy.media_nice);
+    cJSON_AddNumberToObject(policy, "analysis-nice", thread_policy.analysis_nice);
+}
+
+void thread_policy_add_stats(cJSON *root)
+{
+    add_process_stats(root);
+    add_policy_stats(root);
+
+    cJSON *threads = cJSON_AddArrayToObject(root, "threads");
+
+    pthread_mutex_lock(&placement_mutex);
+    prune_exited_threads();
+    for (int i = 0; i < placement_count; i++) {
+        ThreadPlacement *p = &placements[i];
+        cJSON *thread = cJSON_CreateObject();
+        cJSON_AddStringToObject(thread, "name", p->name);
+        cJSON_AddStringToObject(thread, "role", role_names[p->role]);
+        cJSON_AddNumberToObject(thread, "tid", p->tid);
+
+#ifdef __linux__
+        // Read the placement back from the kernel rather than reporting what was requested
+        cpu_set_t set;
+        if (sched_getaffinity(p->tid, sizeof(set), &set) != 0) {
+            cJSON_Delete(thread); // Exited since the prune above
+            continue;
+        }
+        char cpus[256];
+        format_cpu_list(&set, cpus, sizeof(cpus));
+        cJSON_AddStringToObject(thread, "cpus", cpus);
+
+        int policy = sched_getscheduler(p->tid);
+        struct sched_param param = {0};
+        sched_getparam(p->tid, &param);
+        cJSON_AddStringToObject(thread, "policy", policy_name(policy));
+        cJSON_AddNumberToObject(thread, "priority", param.sched_priority);
+
+        errno = 0;
+        int nice_value = getpriority(PRIO_PROCESS, p->tid);
+        if (errno == 0) cJSON_AddNumberToObject(thread, "nice", nice_value);
+        cJSON_AddNumberToObject(thread, "last-cpu", last_cpu(p->tid));
+#endif
+
+        cJSON_AddItemToArray(threads, thread);
+    }
+    pthread_mutex_unlock(&placement_mutex);
+}
+
+void thread_policy_forget_self(void)
+{
+    pid_t tid = current_tid();
+    pthread_mutex_lock(&placement_mutex);
+    for (int i = 0; i < placement_count; i++) {
+        if (placements[i].tid == tid) {
+            remove_placement(i);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&placement_mutex);
+}
+
+void thread_policy_reset(void)
+{
+    pthread_mutex_lock(&placement_mutex);
+    placement_count = 0;
+    pthread_mutex_unlock(&placement_mutex);
+}
@@ -0,0 +1,10 @@
+#include "trace.h"
+
+#ifdef BG_HAVE_SDT
+
+// One semaphore per probe in the ".probes" section, where tracers look for them (as dtrace -G emits)
+#define BG_TRACE_DEFINE_SEMAPHORE(name)                                                                               \
+    __extension__ unsigned short blackgate_##name##_semaphore __attribute__((unused, section(".probes")));
+BG_TRACE_PROBES(BG_TRACE_DEFINE_SEMAPHORE)
+
+#endif
@@ -0,0 +1,563 @@
+#include "ts_filter.h"
+
+#include <string.h>
+
+#define PAT_PID 0x0000
+#define TABLE_ID_PAT 0x00
+#define TABLE_ID_PMT 0x02
+#define MAX_PROGRAMS 256
+#define MAX_PROGRAM_PIDS 64
+// A section of TS_PSI_MAX_SECTION bytes plus the pointer field, in 184-byte payloads
+#define MAX_SECTION_PACKETS ((TS_PSI_MAX_SECTION + 1 + TS_PACKET_SIZE - 5) / (TS_PACKET_SIZE - 4))
+
+enum {
+    ROLE_DROP,
+    ROLE_PASS,
+    ROLE_PAT,
+    ROLE_PMT,
+    ROLE_PCR_ONLY, // PCR PID of a kept program whose payload is not kept
+};
+
+// One PSI section being reassembled from the packets of its PID
+typedef struct {
+    guint8 data[TS_PSI_MAX_SECTION + 3];
+    guint len;
+    guint need; // 3 + section_length, once the header is in
+} SectionBuffer;
+
+// Packets of the last section we generated, re-emitted as long as the input section is unchanged
+typedef struct {
+    guint32 input_crc;
+    gboolean valid;
+    guint8 packets[MAX_SECTION_PACKETS * TS_PACKET_SIZE];
+    guint count;
+} PsiOutput;
+
+typedef struct {
+    guint16 number;
+    guint16 pmt_pid;
+    gboolean candidate; // Selected by "programs", or no "programs" given
+    gboolean pmt_seen;
+    gboolean kept;
+    guint16 pcr_pid;
+    guint16 pids[MAX_PROGRAM_PIDS]; // Elementary PIDs left in the rewritten PMT
+    guint pid_count;
+    PsiOutput out;
+} Program;
+
+struct TsFilter {
+    TsSync sync;
+    guint8 role[TS_PID_COUNT];
+    guint8 out_cc[TS_PID_COUNT];
+
+    guint64 programs_filter[65536 / 64];
+    guint64 pids_filter[TS_PID_COUNT / 64];
+    guint64 keep_filter[TS_PID_COUNT / 64];
+    gboolean has_programs, has_pids;
+
+    SectionBuffer pat_section;
+    PsiOutput pat_out;
+    gboolean pat_dirty; // Kept programs changed since pat_out was built
+    guint8 pat_header[8];
+    Program *programs[MAX_PROGRAMS];
+    guint program_count;
+    GHashTable *pmt_sections; // PMT PID -> SectionBuffer (programs may share a PMT PID)
+
+    GByteArray *out; // Only set during ts_filter_process
+    guint appended;
+    TsFilterStats stats;
+};
+
+static inline gboolean bit_has(const guint64 *bits, guint n)
+{
+    return (bits[n >> 6] >> (n & 63)) & 1;
+}
+
+static inline void bit_set(guint64 *bits, guint n)
+{
+    bits[n >> 6] |= G_GUINT64_CONSTANT(1) << (n & 63);
+}
+
+// =============================================================================
+// CRC32
+// =============================================================================
+
+static guint32 crc_table[256];
+
+static void crc_table_init(void)
+{
+    static gsize ready = 0;
+    if (!g_once_init_enter(&ready)) return;
+    for (guint32 i = 0; i < 256; i++) {
+        guint32 crc = i << 24;
+        for (int bit = 0; bit < 8; bit++) crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04C11DB7u : crc << 1;
+        crc_table[i] = crc;
+    }
+    g_once_init_leave(&ready, 1);
+}
+
+guint32 ts_crc32(const guint8 *data, gsize len)
+{
+    crc_table_init();
+    guint32 crc = 0xFFFFFFFFu;
+    for (gsize i = 0; i < len; i++) crc = (crc << 8) ^ crc_table[(crc >> 24) ^ data[i]];
+    return crc;
+}
+
+// =============================================================================
+// Output
+// =============================================================================
+
+static inline void append_packet(TsFilter *f, const guint8 *pkt)
+{
+    guint len = f->out->len;
+    g_byte_array_set_size(f->out, len + TS_PACKET_SIZE);
+    memcpy(f->out->data + len, pkt, TS_PACKET_SIZE);
+    f->appended++;
+}
+
+// Emit a generated section's packets with this PID's own continuity counter
+static void emit_psi(TsFilter *f, PsiOutput *psi)
+{
+    for (guint i = 0; i < psi->count; i++) {
+        guint8 *pkt = psi->packets + i * TS_PACKET_SIZE;
+        guint16 pid = TS_PID(pkt);
+        pkt[3] = (pkt[3] & 0xF0) | (f->out_cc[pid] & 0x0F);
+        f->out_cc[pid]++;
+        append_packet(f, pkt);
+    }
+}
+
+// Split a complete section (CRC included) into packets: pointer field 0, stuffed with 0xFF
+static void packetize(PsiOutput *psi, guint16 pid, const guint8 *section, guint len)
+{
+    psi->count = 0;
+    guint pos = 0;
+    while (pos < len && psi->count < MAX_SECTION_PACKETS) {
+        guint8 *pkt = psi->packets + psi->count * TS_PACKET_SIZE;
+        gboolean first = pos == 0;
+        pkt[0] = TS_SYNC_BYTE;
+        pkt[1] = (first ? 0x40 : 0x00) | (pid >> 8);
+        pkt[2] = pid & 0xFF;
+        pkt[3] = 0x10; // Payload only; the continuity counter is set on emit
+
+        guint off = 4;
+        if (first) pkt[off++] = 0; // Pointer field
+        guint take = MIN(len - pos, (guint)TS_PACKET_SIZE - off);
+        memcpy(pkt + off, section + pos, take);
+        memset(pkt + off + take, 0xFF, TS_PACKET_SIZE - off - take);
+        pos += take;
+        psi->count++;
+    }
+}
+
+// Finish a rewritten section: fix section_length, append the CRC and packetize it
+static void finish_section(PsiOutput *psi, guint16 pid, guint8 *section, guint body_len, guint32 input_crc)
+{
+    guint section_length = body_len - 3 + 4;
+    section[1] = (section[1] & 0xF0) | ((section_length >> 8) & 0x0F);
+    section[2] = section_length & 0xFF;
+
+    guint32 crc = ts_crc32(section, body_len);
+    section[body_len] = crc >> 24;
+    section[body_len + 1] = (crc >> 16) & 0xFF;
+    section[body_len + 2] = (crc >> 8) & 0xFF;
+    section[body_len + 3] = crc & 0xFF;
+
+    packetize(psi, pid, section, body_len + 4);
+    psi->input_crc = input_crc;
+    psi->valid = TRUE;
+}
+
+// PCR packets of a PID whose payload is dropped: keep the PCR, drop everything after it
+static void append_pcr_only(TsFilter *f, const guint8 *pkt)
+{
+    if (!(pkt[3] & 0x20) || pkt[4] < 7 || !(pkt[5] & 0x10)) return;
+
+    guint8 out[TS_PACKET_SIZE];
+    out[0] = TS_SYNC_BYTE;
+    out[1] = pkt[1] & 0x1F; // Clear PUSI and the error/priority bits
+    out[2] = pkt[2];
+    out[3] = (pkt[3] & 0xC0) | 0x20 | (f->out_cc[TS_PID(pkt)] & 0x0F); // Adaptation field only
+    out[4] = TS_PACKET_SIZE - 5;
+    out[5] = pkt[5] & 0x90; // Discontinuity and PCR flags
+    memcpy(out + 6, pkt + 6, 6);
+    memset(out + 12, 0xFF, TS_PACKET_SIZE - 12);
+    append_packet(f, out);
+}
+
+// =============================================================================
+// PID Roles
+// =============================================================================
+
+static void update_roles(TsFilter *f)
+{
+    memset(f->role, ROLE_DROP, sizeof(f->role));
+    f->role[PAT_PID] = ROLE_PAT;
+    for (guint pid = 0; pid < TS_PID_COUNT; pid++) {
+        if (bit_has(f->keep_filter, pid)) f->role[pid] = ROLE_PASS;
+    }
+
+    guint kept = 0;
+    for (guint i = 0; i < f->program_count; i++) {
+        Program *p = f->programs[i];
+        if (!p->candidate) continue;
+        f->role[p->pmt_pid] = ROLE_PMT;
+        if (!p->kept) continue;
+        kept++;
+        for (guint k = 0; k < p->pid_count; k++) {
+            if (f->role[p->pids[k]] == ROLE_DROP) f->role[p->pids[k]] = ROLE_PASS;
+        }
+    }
+
+    // PCRs last, so a PCR PID that is also a kept elementary stream passes in full
+    for (guint i = 0; i < f->program_count; i++) {
+        Program *p = f->programs[i];
+        if (p->kept && p->pmt_seen && p->pcr_pid != TS_NULL_PID && f->role[p->pcr_pid] == ROLE_DROP) {
+            f->role[p->pcr_pid] = ROLE_PCR_ONLY;
+        }
+    }
+
+    // Let the sync stage skip dropped PIDs before they reach us
+    ts_sync_filter_clear(&f->sync);
+    guint pids = 0;
+    for (guint pid = 0; pid < TS_PID_COUNT; pid++) {
+        if (f->role[pid] == ROLE_DROP) continue;
+        ts_sync_filter_add(&f->sync, (guint16)pid);
+        pids++;
+    }
+    f->stats.programs = kept;
+    f->stats.pids = pids;
+}
+
+static gboolean program_keeps_pid(TsFilter *f, guint16 pid)
+{
+    return !f->has_pids || bit_has(f->pids_filter, pid);
+}
+
+// =============================================================================
+// PAT and PMT
+// =============================================================================
+
+static gboolean section_valid(TsFilter *f, const guint8 *section, guint len, guint8 table_id, guint min_len)
+{
+    if (len < min_len || section[0] != table_id || !(section[1] & 0x80)) return FALSE;
+    if (!(section[5] & 0x01)) return FALSE; // Not yet applicable (current_next_indicator = 0)
+    if (ts_crc32(section, len) != 0) {
+        f->stats.crc_errors++;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static guint32 section_crc(const guint8 *section, guint len)
+{
+    const guint8 *crc = section + len - 4;
+    return ((guint32)crc[0] << 24) | ((guint32)crc[1] << 16) | ((guint32)crc[2] << 8) | crc[3];
+}
+
+static void build_pat(TsFilter *f)
+{
+    guint8 section[TS_PSI_MAX_SECTION + 3];
+    memcpy(section, f->pat_header, sizeof(f->pat_header));
+
+    guint len = sizeof(f->pat_header);
+    for (guint i = 0; i < f->program_count && len + 4 + 4 <= TS_PSI_MAX_SECTION; i++) {
+        Program *p = f->programs[i];
+        if (!p->kept) continue;
+        section[len++] = p->number >> 8;
+        section[len++] = p->number & 0xFF;
+        section[len++] = 0xE0 | (p->pmt_pid >> 8);
+        section[len++] = p->pmt_pid & 0xFF;
+    }
+    finish_section(&f->pat_out, PAT_PID, section, len, f->pat_out.input_crc);
+    f->pat_dirty = FALSE;
+    f->stats.psi_rewrites++;
+}
+
+static Program *find_program(TsFilter *f, guint16 number)
+{
+    for (guint i = 0; i < f->program_count; i++) {
+        if (f->programs[i]->number == number) return f->programs[i];
+    }
+    return NULL;
+}
+
+static void handle_pat(TsFilter *f, const guint8 *section, guint len)
+{
+    if (!section_valid(f, section, len, TABLE_ID_PAT, 12)) return;
+
+    guint32 crc = section_crc(section, len);
+    if (f->pat_out.valid && f->pat_out.input_crc == crc) {
+        if (f->pat_dirty) build_pat(f);
+        emit_psi(f, &f->pat_out);
+        return;
+    }
+
+    // New or changed PAT: keep the state of programs that are still there with the same PMT PID
+    Program *programs[MAX_PROGRAMS];
+    guint count = 0;
+    for (guint pos = 8; pos + 4 <= len - 4 && count < MAX_PROGRAMS; pos += 4) {
+        guint16 number = (section[pos] << 8) | section[pos + 1];
+        guint16 pmt_pid = ((section[pos + 2] & 0x1F) << 8) | section[pos + 3];
+        if (number == 0) continue; // Network PID; the NIT is not carried
+
+        Program *p = find_program(f, number);
+        if (p && p->pmt_pid == pmt_pid) {
+            programs[count++] = p;
+            continue;
+        }
+        p = g_new0(Program, 1);
+        p->number = number;
+        p->pmt_pid = pmt_pid;
+        p->candidate = !f->has_programs || bit_has(f->programs_filter, number);
+        p->kept = f->has_programs && p->candidate; // Otherwise kept once its PMT shows a selected PID
+        programs[count++] = p;
+    }
+
+    for (guint i = 0; i < f->program_count; i++) {
+        gboolean still_listed = FALSE;
+        for (guint k = 0; k < count; k++) still_listed |= programs[k] == f->programs[i];
+        if (!still_listed) g_free(f->programs[i]);
+    }
+    memcpy(f->programs, programs, count * sizeof(Program *));
+    f->program_count = count;
+
+    for (guint i = 0; i < count; i++) {
+        Program *p = programs[i];
+        if (p->candidate && !g_hash_table_contains(f->pmt_sections, GUINT_TO_POINTER(p->pmt_pid))) {
+            g_hash_table_insert(f->pmt_sections, GUINT_TO_POINTER(p->pmt_pid), g_new0(SectionBuffer, 1));
+        }
+    }
+
+    memcpy(f->pat_header, section, sizeof(f->pat_header));
+    f->pat_out.input_crc = crc;
+    build_pat(f);
+    update_roles(f);
+    emit_psi(f, &f->pat_out);
+}
+
+static void handle_pmt(TsFilter *f, guint16 pid, const guint8 *section, guint len)
+{
+    if (!section_valid(f, section, len, TABLE_ID_PMT, 16)) return;
+
+    guint16 number = (section[3] << 8) | section[4];
+    Program *p = find_program(f, number);
+    if (!p || !p->candidate || p->pmt_pid != pid) return;
+
+    guint32 crc = section_crc(section, len);
+    if (!p->out.valid || p->out.input_crc != crc) {
+        guint8 out[TS_PSI_MAX_SECTION + 3];
+        guint program_info_length = ((section[10] & 0x0F) << 8) | section[11];
+        guint pos = 12 + program_info_length;
+        if (pos > len - 4) return;
+
+        memcpy(out, section, pos);
+        guint out_len = pos;
+        p->pcr_pid = ((section[8] & 0x1F) << 8) | section[9];
+        p->pid_count = 0;
+
+        while (pos + 5 <= len - 4) {
+            guint16 es_pid = ((section[pos + 1] & 0x1F) << 8) | section[pos + 2];
+            guint entry_len = 5 + (((section[pos + 3] & 0x0F) << 8) | section[pos + 4]);
+            if (pos + entry_len > len - 4) break;
+
+            if (program_keeps_pid(f, es_pid) && p->pid_count < MAX_PROGRAM_PIDS) {
+                memcpy(out + out_len, section + pos, entry_len);
+                out_len += entry_len;
+                p->pids[p->pid_count++] = es_pid;
+            }
+            pos += entry_len;
+        }
+
+        gboolean was_kept = p->kept;
+        p->pmt_seen = TRUE;
+        p->kept = f->has_programs || p->pid_count > 0;
+        if (p->kept != was_kept) f->pat_dirty = TRUE;
+
+        finish_section(&p->out, pid, out, out_len, crc);
+        f->stats.psi_rewrites++;
+        update_roles(f);
+    }
+
+    if (p->kept) emit_psi(f, &p->out);
+}
+
+// =============================================================================
+// Section Reassembly
+// =============================================================================
+
+static void section_complete(TsFilter *f, guint16 pid, SectionBuffer *sec)
+{
+    if (pid == PAT_PID) {
+        handle_pat(f, sec->data, sec->need);
+    } else {
+        handle_pmt(f, pid, sec->data, sec->need);
+    }
+    sec->len = 0;
+}
+
+// Append payload bytes to the section; returns how many bytes belonged to it
+static guint section_append(TsFilter *f, guint16 pid, SectionBuffer *sec, const guint8 *p, guint avail)
+{
+    guint used = 0;
+    if (sec->len < 3) {
+        guint take = MIN(3 - sec->len, avail);
+        memcpy(sec->data + sec->len, p, take);
+        sec->len += take;
+        used = take;
+        if (sec->len < 3) return used;
+
+        sec->need = 3 + (((sec->data[1] & 0x0F) << 8) | sec->data[2]);
+        if (sec->need > sizeof(sec->data)) {
+            sec->len = 0;
+            return avail;
+        }
+    }
+
+    guint take = MIN(sec->need - sec->len, avail - used);
+    memcpy(sec->data + sec->len, p + used, take);
+    sec->len += take;
+    used += take;
+    if (sec->len == sec->need) section_complete(f, pid, sec);
+    return used;
+}
+
+static void feed_section(TsFilter *f, guint16 pid, SectionBuffer *sec, const guint8 *pkt)
+{
+    if (!(pkt[3] & 0x10) || (pkt[1] & 0x80)) return; // No payload, or transport error
+
+    guint off = 4;
+    if (pkt[3] & 0x20) off += 1 + pkt[4];
+    if (off >= TS_PACKET_SIZE) return;
+
+    const guint8 *p = pkt + off;
+    guint avail = TS_PACKET_SIZE - off;
+
+    if (!(pkt[1] & 0x40)) {
+        if (sec->len > 0) section_append(f, pid, sec, p, avail);
+        return;
+    }
+
+    // The pointer field skips the tail of the previous section, which may complete it
+    guint pointer = p[0];
+    p++;
+    avail--;
+    if (pointer > avail) {
+        sec->len = 0;
+        return;
+    }
+    if (sec->len > 0 && pointer > 0) section_append(f, pid, sec, p, pointer);
+    p += pointer;
+    avail -= pointer;
+
+    // Further sections may follow each other in the same packet until the 0xFF stuffing
+    sec->len = 0;
+    while (avail > 0 && p[0] != 0xFF) {
+        guint used = section_append(f, pid, sec, p, avail);
+        p += used;
+        avail -= used;
+        if (sec->len > 0) break; // Continues in the next packet
+    }
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+static void on_packet(const guint8 *pkt, guint16 pid, gpointer user_data)
+{
+    TsFilter *f = user_data;
+
+    switch (f->role[pid]) {
+        case ROLE_PASS:
+            append_packet(f, pkt);
+            break;
+        case ROLE_PCR_ONLY:
+            append_pcr_only(f, pkt);
+            break;
+        case ROLE_PAT:
+            feed_section(f, pid, &f->pat_section, pkt);
+            break;
+        case ROLE_PMT:
+            feed_section(f, pid, g_hash_table_lookup(f->pmt_sections, GUINT_TO_POINTER(pid)), pkt);
+            break;
+        default:
+            break;
+    }
+}
+
+static gboolean read_numbers(cJSON *config, const char *key, guint max, guint64 *bits, gboolean *present)
+{
+    cJSON *array = cJSON_GetObjectItem(config, key);
+    if (!array) return TRUE;
+    if (!cJSON_IsArray(array)) {
+        g_printerr("TsFilter: '%s' must be an array\n", key);
+        return FALSE;
+    }
+
+    cJSON *item;
+    cJSON_ArrayForEach(item, array)
+    {
+        if (!cJSON_IsNumber(item) || item->valueint < 0 || (guint)item->valueint >= max) {
+            g_printerr("TsFilter: invalid entry in '%s'\n", key);
+            return FALSE;
+        }
+        bit_set(bits, (guint)item->valueint);
+    }
+    if (present) *present = cJSON_GetArraySize(array) > 0;
+    return TRUE;
+}
+
+TsFilter *ts_filter_new(cJSON *config)
+{
+    if (!cJSON_IsObject(config)) {
+        g_printerr("TsFilter: filter config must be an object\n");
+        return NULL;
+    }
+
+    TsFilter *f = g_new0(TsFilter, 1);
+    if (!read_numbers(config, "programs", 65536, f->programs_filter, &f->has_programs) ||
+        !read_numbers(config, "pids", TS_PID_COUNT, f->pids_filter, &f->has_pids) ||
+        !read_numbers(config, "keep-pids", TS_PID_COUNT, f->keep_filter, NULL)) {
+        g_free(f);
+        return NULL;
+    }
+    if (!f->has_programs && !f->has_pids) {
+        g_printerr("TsFilter: select at least one entry in 'programs' or 'pids'\n");
+        g_free(f);
+        return NULL;
+    }
+
+    crc_table_init();
+    ts_sync_init(&f->sync);
+    f->pmt_sections = g_hash_table_new_full(g_direct_hash, g_direct_equal, NULL, g_free);
+    update_roles(f);
+    return f;
+}
+
+void ts_filter_free(TsFilter *filter)
+{
+    if (!filter) return;
+    for (guint i = 0; i < filter->program_count; i++) g_free(filter->programs[i]);
+    g_hash_table_destroy(filter->pmt_sections);
+    g_free(filter);
+}
+
+guint ts_filter_process(TsFilter *filter, const guint8 *data, gsize size, GByteArray *out)
+{
+    guint64 seen = filter->sync.packets;
+    filter->out = out;
+    filter->appended = 0;
+    ts_sync_feed(&filter->sync, data, size, on_packet, filter);
+    filter->out = NULL;
+
+    filter->stats.packets_in += filter->sync.packets - seen;
+    filter->stats.packets_out += filter->appended;
+    return filter->appended;
+}
+
+void ts_filter_get_stats(TsFilter *filter, TsFilterStats *stats)
+{
+    *stats = filter->stats;
+}
@@ -0,0 +1,545 @@
+#include "ts_metadata.h"
+
+#include "trace.h"
+
+#define PAT_PID 0x0000
+#define PAT_TABLE_ID 0x00
+#define PMT_TABLE_ID 0x02
+#define PSI_MIN_SECTION 12 // Header through last_section_number, plus CRC_32
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+struct TsMetadata {
+    GMutex lock; // Guards format and stats; the rest belongs to the feeding thread
+    TsSync sync;
+    TsFormatChangeFunc on_change;
+    gpointer user_data;
+
+    gint64 pat_key;    // version_number << 32 | CRC_32 of the last PAT parsed, -1 before the first
+    guint16 pmt_pid;   // 0 until the PAT names one
+    gint64 pmt_key;
+    guint16 video_pid; // 0 until the PMT names one
+    guint8 stream_type;
+    guint32 fingerprint; // FNV-1a over the parameter sets last parsed
+    gboolean have_fingerprint;
+
+    TsVideoFormat format;
+    TsMetadataStats stats;
+};
+
+typedef enum {
+    UNIT_OTHER,
+    UNIT_PARAM,  // Fingerprinted only (HEVC VPS, MPEG-2 extensions)
+    UNIT_HEADER, // Fingerprinted and parsed
+    UNIT_PICTURE // Slice data: no parameter sets follow
+} UnitKind;
+
+const char *ts_metadata_codec_name(guint8 stream_type)
+{
+    switch (stream_type) {
+    case TS_STREAM_TYPE_H264:
+        return "h264";
+    case TS_STREAM_TYPE_HEVC:
+        return "hevc";
+    case TS_STREAM_TYPE_MPEG2_VIDEO:
+        return "mpeg2";
+    default:
+        return "unknown";
+    }
+}
+
+// =============================================================================
+// Parameter Set Parsing
+// =============================================================================
+
+// Bit reader helper for SPS parsing
+typedef struct {
+    const guint8 *data;
+    gsize size;
+    gsize byte_offset;
+    gint bit_offset;
+} BitReader;
+
+static guint32 read_bits(BitReader *br, gint n)
+{
+    guint32 result = 0;
+    for (gint i = 0; i < n; i++) {
+        if (br->byte_offset >= br->size) return result;
+        result <<= 1;
+        result |= (br->data[br->byte_offset] >> (7 - br->bit_offset)) & 1;
+        br->bit_offset++;
+        if (br->bit_offset >= 8) {
+            br->bit_offset = 0;
+            br->byte_offset++;
+        }
+    }
+    return result;
+}
+
+static guint32 read_ue(BitReader *br) // Exp-Golomb unsigned
+{
+    gint leading_zeros = 0;
+    while (read_bits(br, 1) == 0 && leading_zeros < 32) leading_zeros++;
+    return (1 << leading_zeros) - 1 + read_bits(br, leading_zeros);
+}
+
+// H.264 SPS NAL unit (from its header byte) to resolution and framerate
+static gboolean parse_h264_sps(const guint8 *data, gsize size, TsVideoFormat *format)
+{
+    if (size < 5) return FALSE;
+
+    // Skip NAL header (1 byte)
+    BitReader br = {data + 1, size - 1, 0, 0};
+
+    guint8 profile_idc = read_bits(&br, 8);
+    read_bits(&br, 8); // constraint_set flags + reserved
+    read_bits(&br, 8); // level_idc
+    read_ue(&br);      // seq_parameter_set_id
+
+    // Handle high profiles
+    if (profile_idc == 100 || profile_idc == 110 || profile_idc == 122 || profile_idc == 244 || profile_idc == 44 ||
+        profile_idc == 83 || profile_idc == 86 || profile_idc == 118 || profile_idc == 128 || profile_idc == 138 ||
+        profile_idc == 139 || profile_idc == 134) {
+        guint32 chroma_format_idc = read_ue(&br);
+        if (chroma_format_idc == 3) read_bits(&br, 1); // separate_colour_plane_flag
+        read_ue(&br);                                  // bit_depth_luma_minus8
+        read_ue(&br);                                  // bit_depth_chroma_minus8
+        read_bits(&br, 1);                             // qpprime_y_zero_transform_bypass_flag
+        if (read_bits(&br, 1)) {                       // seq_scaling_matrix_present_flag
+            for (int i = 0; i < ((chroma_format_idc != 3) ? 8 : 12); i++) {
+                if (read_bits(&br, 1)) { // seq_scaling_list_present_flag
+                    gint size_list = (i < 6) ? 16 : 64;
+                    gint last_scale = 8, next_scale = 8;
+                    for (int j = 0; j < size_list; j++) {
+                        if (next_scale != 0) {
+                            gint delta = read_ue(&br);
+                            next_scale = (last_scale + delta) % 256;
+                        }
+                        last_scale = (next_scale == 0) ? last_scale : next_scale;
+                    }
+                }
+            }
+        }
+    }
+
+    read_ue(&br); // log2_max_frame_num_minus4
+    guint32 pic_order_cnt_type = read_ue(&br);
+    if (pic_order_cnt_type == 0) {
+        read_ue(&br); // log2_max_pic_order_cnt_lsb_minus4
+    } else if (pic_order_cnt_type == 1) {
+        read_bits(&br, 1); // delta_pic_order_always_zero_flag
+        read_ue(&br);      // offset_for_non_ref_pic
+        read_ue(&br);      // offset_for_top_to_bottom_field
+        guint32 num_ref_frames_in_pic_order_cnt_cycle = read_ue(&br);
+        for (guint32 i = 0; i < num_ref_frames_in_pic_order_cnt_cycle; i++) read_ue(&br);
+    }
+
+    read_ue(&br);      // max_num_ref_frames
+    read_bits(&br, 1); // gaps_in_frame_num_value_allowed_flag
+
+    guint32 pic_width_in_mbs_minus1 = read_ue(&br);
+    guint32 pic_height_in_map_units_minus1 = read_ue(&br);
+    guint32 frame_mbs_only_flag = read_bits(&br, 1);
+
+    gint width = (pic_width_in_mbs_minus1 + 1) * 16;
+    gint height = (pic_height_in_map_units_minus1 + 1) * 16 * (frame_mbs_only_flag ? 1 : 2);
+    gboolean interlaced = !frame_mbs_only_flag;
+
+    // Crop dimensions if needed
+    if (!frame_mbs_only_flag) read_bits(&br, 1); // mb_adaptive_frame_field_flag
+    read_bits(&br, 1);                           // direct_8x8_inference_flag
+
+    if (read_bits(&br, 1)) { // frame_cropping_flag
+        guint32 crop_left = read_ue(&br);
+        guint32 crop_right = read_ue(&br);
+        guint32 crop_top = read_ue(&br);
+        guint32 crop_bottom = read_ue(&br);
+        width -= (crop_left + crop_right) * 2;
+        height -= (crop_top + crop_bottom) * 2 * (frame_mbs_only_flag ? 1 : 2);
+    }
+
+    // Infer framerate from resolution and interlace mode (common broadcast standards)
+    // Note: VUI timing_info parsing is unreliable due to H.264 emulation prevention bytes
+    // Default to 25fps (PAL standard, common for Indonesian/European content), 25i or 25p alike
+    format->width = width;
+    format->height = height;
+    format->interlaced = interlaced;
+    format->fps_num = 25;
+    format->fps_den = 1;
+    format->fps_inferred = TRUE; // All H.264 framerates are inferred (VUI unreliable)
+    return TRUE;
+}
+
+// MPEG-2 sequence header (after its start code) for resolution/framerate
+static gboolean parse_mpeg2_sequence(const guint8 *data, gsize size, TsVideoFormat *format)
+{
+    if (size < 8) return FALSE;
+
+    // Sequence header: horizontal_size(12) + vertical_size(12) + aspect_ratio(4) + frame_rate_code(4)
+    guint8 frame_rate_code = data[3] & 0x0F;
+
+    // Frame rate lookup table (frame_rate_code)
+    static const gint fps_num_table[] = {0, 24000, 24, 25, 30000, 30, 50, 60000, 60};
+    static const gint fps_den_table[] = {1, 1001, 1, 1, 1001, 1, 1, 1001, 1};
+
+    format->width = (data[0] << 4) | (data[1] >> 4);
+    format->height = ((data[1] & 0x0F) << 8) | data[2];
+    format->fps_num = (frame_rate_code < 9) ? fps_num_table[frame_rate_code] : 0;
+    format->fps_den = (frame_rate_code < 9) ? fps_den_table[frame_rate_code] : 1;
+    format->fps_inferred = FALSE; // MPEG-2 framerate is detected from stream header
+    return TRUE;
+}
+
+// HEVC (H.265) SPS NAL unit (from its header) for resolution/framerate
+static gboolean parse_hevc_sps(const guint8 *data, gsize size, TsVideoFormat *format)
+{
+    // HEVC NAL unit header is 2 bytes, SPS starts after that
+    if (size < 20) return FALSE;
+
+    // Skip NAL unit header (2 bytes) for HEVC
+    BitReader br = {data + 2, size - 2, 0, 0};
+
+    read_bits(&br, 4);                             // sps_video_parameter_set_id
+    guint8 max_sub_layers = read_bits(&br, 3) + 1; // sps_max_sub_layers_minus1 + 1
+    read_bits(&br, 1);                             // sps_temporal_id_nesting_flag
+
+    // Skip profile_tier_level - simplified approach
+    // This is complex in full spec, but we can skip fixed bits for common profiles
+    read_bits(&br, 2);  // general_profile_space
+    read_bits(&br, 1);  // general_tier_flag
+    read_bits(&br, 5);  // general_profile_idc
+    read_bits(&br, 32); // general_profile_compatibility_flags (32 bits)
+    read_bits(&br, 1);  // general_progressive_source_flag
+    read_bits(&br, 1);  // general_interlaced_source_flag
+    read_bits(&br, 1);  // general_non_packed_constraint_flag
+    read_bits(&br, 1);  // general_frame_only_constraint_flag
+    // Skip remaining constraint flags (44 bits)
+    read_bits(&br, 32);
+    read_bits(&br, 12);
+    read_bits(&br, 8); // general_level_idc
+
+    // Skip sub_layer_profile/level for each sub-layer
+    if (max_sub_layers > 1) {
+        for (int i = 0; i < max_sub_layers - 1; i++) {
+            read_bits(&br, 2); // sub_layer_profile/level_present_flag
+        }
+        // Padding if max_sub_layers < 8
+        for (int i = max_sub_layers - 1; i < 8; i++) {
+            read_bits(&br, 2); // reserved
+        }
+    }
+
+    read_ue(&br); // sps_seq_parameter_set_id
+    guint32 chroma_format_idc = read_ue(&br);
+    if (chroma_format_idc == 3) {
+        read_bits(&br, 1); // separate_colour_plane_flag
+    }
+
+    // The key info we need!
+    guint32 pic_width = read_ue(&br);  // pic_width_in_luma_samples
+    guint32 pic_height = read_ue(&br); // pic_height_in_luma_samples
+
+    // Check for conformance_window_flag
+    if (read_bits(&br, 1)) { // conformance_window_flag
+        guint32 left = read_ue(&br);
+        guint32 right = read_ue(&br);
+        guint32 top = read_ue(&br);
+        guint32 bottom = read_ue(&br);
+        // Adjust for cropping (simplified)
+        pic_width -= (left + right) * 2;
+        pic_height -= (top + bottom) * 2;
+    }
+
+    // Infer framerate based on resolution
+    // All HEVC framerates are inferred since we don't parse VUI
+    format->width = pic_width;
+    format->height = pic_height;
+    format->fps_num = pic_height >= 2160 ? 50 : 25; // 4K typically 50fps in Europe, 60fps in US
+    format->fps_den = 1;
+    format->fps_inferred = TRUE;
+    format->interlaced = FALSE; // HEVC is progressive by design for UHD
+    return TRUE;
+}
+
+// =============================================================================
+// PSI Tracking
+// =============================================================================
+
+// The section of table `table_id` starting in `pkt`, or NULL if there is none that is current and
+// fits in the packet (sections spanning packets are not followed; PATs and PMTs rarely do)
+static const guint8 *packet_section(const guint8 *pkt, guint8 table_id, gsize *section_size)
+{
+    if (!(pkt[1] & 0x40) || !(pkt[3] & 0x10)) return NULL; // payload_unit_start_indicator, payload
+    gsize offset = 4;
+    if (pkt[3] & 0x20) offset += 1 + pkt[4];
+    if (offset >= TS_PACKET_SIZE) return NULL;
+    offset += 1 + pkt[offset]; // pointer_field
+    if (offset + PSI_MIN_SECTION > TS_PACKET_SIZE || pkt[offset] != table_id) return NULL;
+
+    gsize size = 3 + (((pkt[offset + 1] & 0x0F) << 8) | pkt[offset + 2]);
+    if (size < PSI_MIN_SECTION || offset + size > TS_PACKET_SIZE) return NULL;
+    if (!(pkt[offset + 5] & 0x01)) return NULL; // current_next_indicator: not in force yet
+    *section_size = size;
+    return pkt + offset;
+}
+
+// version_number and CRC_32 together: a restarted encoder may reuse the version with other content
+static gint64 section_key(const guint8 *section, gsize size)
+{
+    const guint8 *crc = section + size - 4;
+    guint32 crc32 = ((guint32)crc[0] << 24) | ((guint32)crc[1] << 16) | ((guint32)crc[2] << 8) | crc[3];
+    return ((gint64)((section[5] >> 1) & 0x1F) << 32) | crc32;
+}
+
+// Point `slot` (the PMT or video PID) at `pid`, keeping the filter to the PIDs still in use
+static void watch_pid(TsMetadata *m, guint16 *slot, guint16 pid)
+{
+    guint16 old = *slot;
+    *slot = pid;
+    if (old && old != m->pmt_pid && old != m->video_pid) ts_sync_filter_remove(&m->sync, old);
+    if (pid) ts_sync_filter_add(&m->sync, pid);
+}
+
+static void handle_pat(TsMetadata *m, const guint8 *pkt)
+{
+    gsize size;
+    const guint8 *section = packet_section(pkt, PAT_TABLE_ID, &size);
+    if (!section) return;
+    gint64 key = section_key(section, size);
+    if (key == m->pat_key) return;
+    m->pat_key = key;
+    g_mutex_lock(&m->lock);
+    m->stats.pat_changes++;
+    g_mutex_unlock(&m->lock);
+
+    // Program entries: program_number(16) + reserved(3) + PID(13); program 0 is the network PID
+    for (gsize i = 8; i + 4 <= size - 4; i += 4) {
+        guint16 program_number = (section[i] << 8) | section[i + 1];
+        if (program_number == 0) continue;
+        guint16 pmt_pid = ((section[i + 2] & 0x1F) << 8) | section[i + 3];
+        if (pmt_pid != m->pmt_pid) {
+            watch_pid(m, &m->pmt_pid, pmt_pid);
+            g_print("MPEG-TS: Found PMT PID: %d (program %d)\n", pmt_pid, program_number);
+            BG_TRACE2(pat_parsed, program_number, pmt_pid);
+        }
+        // A new PAT may come with a new PMT on the same PID and version
+        m->pmt_key = -1;
+        return;
+    }
+}
+
+static gboolean is_video_stream_type(guint8 stream_type)
+{
+    return stream_type == TS_STREAM_TYPE_MPEG2_VIDEO || stream_type == TS_STREAM_TYPE_H264 ||
+           stream_type == TS_STREAM_TYPE_HEVC;
+}
+
+static void handle_pmt(TsMetadata *m, const guint8 *pkt)
+{
+    gsize size;
+    const guint8 *section = packet_section(pkt, PMT_TABLE_ID, &size);
+    if (!section || size < PSI_MIN_SECTION + 4) return;
+    gint64 key = section_key(section, size);
+    if (key == m->pmt_key) return;
+    m->pmt_key = key;
+    g_mutex_lock(&m->lock);
+    m->stats.pmt_changes++;
+    g_mutex_unlock(&m->lock);
+
+    // After PCR_PID and program_info_length: stream_type(8) + PID(13) + ES_info_length(12) per stream
+    guint16 video_pid = 0;
+    guint8 stream_type = 0;
+    gsize i = 12 + (((section[10] & 0x0F) << 8) | section[11]);
+    while (i + 5 <= size - 4) {
+        if (is_video_stream_type(section[i])) {
+            stream_type = section[i];
+            video_pid = ((section[i + 1] & 0x1F) << 8) | section[i + 2];
+            break;
+        }
+        i += 5 + (((section[i + 3] & 0x0F) << 8) | section[i + 4]);
+    }
+    if (video_pid == m->video_pid && stream_type == m->stream_type) return;
+
+    watch_pid(m, &m->video_pid, video_pid);
+    m->stream_type = stream_type;
+    m->have_fingerprint = FALSE;
+    if (video_pid) {
+        g_print("MPEG-TS: Found video stream PID: %d (type: %s)\n", video_pid, ts_metadata_codec_name(stream_type));
+        BG_TRACE2(pmt_parsed, video_pid, stream_type);
+    } else {
+        g_print("MPEG-TS: PMT lists no video stream\n");
+    }
+}
+
+// =============================================================================
+// Video Parameter Sets
+// =============================================================================
+
+static guint32 fnv1a(guint32 hash, const guint8 *data, gsize size)
+{
+    for (gsize i = 0; i < size; i++) hash = (hash ^ data[i]) * FNV_PRIME;
+    return hash;
+}
+
+// Offset of the next 00 00 01 at or after `from` with a byte after it, or `size`
+static gsize next_start_code(const guint8 *data, gsize size, gsize from)
+{
+    for (gsize i = from; i + 3 < size; i++) {
+        if (data[i + 2] > 1) {
+            i += 2; // No start code can end before i + 3
+        } else if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+            return i;
+        }
+    }
+    return size;
+}
+
+static UnitKind unit_kind(guint8 stream_type, guint8 header)
+{
+    if (stream_type == TS_STREAM_TYPE_H264) {
+        guint8 nal_type = header & 0x1F;
+        if (nal_type == 7) return UNIT_HEADER;                   // SPS
+        if (nal_type >= 1 && nal_type <= 5) return UNIT_PICTURE; // Slices
+    } else if (stream_type == TS_STREAM_TYPE_HEVC) {
+        guint8 nal_type = (header >> 1) & 0x3F;
+        if (nal_type == 32) return UNIT_PARAM;  // VPS
+        if (nal_type == 33) return UNIT_HEADER; // SPS
+        if (nal_type < 32) return UNIT_PICTURE; // VCL NAL units
+    } else if (stream_type == TS_STREAM_TYPE_MPEG2_VIDEO) {
+        if (header == 0xB3) return UNIT_HEADER;  // Sequence header
+        if (header == 0xB5) return UNIT_PARAM;   // Sequence (and display) extension
+        if (header <= 0xAF) return UNIT_PICTURE; // Picture start and slices
+    }
+    return UNIT_OTHER;
+}
+
+static gboolean formats_equal(const TsVideoFormat *a, const TsVideoFormat *b)
+{
+    return a->valid == b->valid && a->stream_type == b->stream_type && a->width == b->width &&
+           a->height == b->height && a->fps_num == b->fps_num && a->fps_den == b->fps_den &&
+           a->interlaced == b->interlaced && a->fps_inferred == b->fps_inferred;
+}
+
+static void update_format(TsMetadata *m, const TsVideoFormat *format)
+{
+    g_mutex_lock(&m->lock);
+    m->stats.header_parses++;
+    TsVideoFormat old = m->format;
+    gboolean changed = !formats_equal(&old, format);
+    if (changed) {
+        m->format = *format;
+        m->stats.format_changes++;
+    }
+    g_mutex_unlock(&m->lock);
+    if (!changed) return;
+
+    BG_TRACE5(video_info, format->stream_type, format->width, format->height, format->fps_num, format->fps_den);
+    g_print("MPEG-TS: Video format: %s %dx%d%s, FPS: %d/%d%s\n", ts_metadata_codec_name(format->stream_type),
+            format->width, format->height, format->interlaced ? " interlaced" : "", format->fps_num, format->fps_den,
+            format->fps_inferred ? " (inferred)" : "");
+    if (m->on_change) m->on_change(&old, format, m->user_data);
+}
+
+static void handle_video(TsMetadata *m, const guint8 *pkt)
+{
+    // Parameter sets lead the access unit, so only the packet that starts a PES can hold them
+    if (!(pkt[1] & 0x40) || !(pkt[3] & 0x10)) return;
+    gsize offset = 4;
+    if (pkt[3] & 0x20) offset += 1 + pkt[4];
+    if (offset + 9 > TS_PACKET_SIZE || pkt[offset] != 0 || pkt[offset + 1] != 0 || pkt[offset + 2] != 1) return;
+    offset += 9 + pkt[offset + 8]; // PES header
+    if (offset >= TS_PACKET_SIZE) return;
+    const guint8 *es = pkt + offset;
+    gsize size = TS_PACKET_SIZE - offset;
+
+    // Fingerprint every parameter set up to the first picture data; a unit cut off by the end of the
+    // packet is fingerprinted (and parsed) as far as it goes, the same way each time it repeats
+    guint32 hash = FNV_OFFSET;
+    gsize header = 0, header_size = 0;
+    gsize pos = next_start_code(es, size, 0);
+    while (pos < size) {
+        gsize unit = pos + 3;
+        gsize next = next_start_code(es, size, unit);
+        UnitKind kind = unit_kind(m->stream_type, es[unit]);
+        if (kind == UNIT_PICTURE) break;
+        if (kind != UNIT_OTHER) hash = fnv1a(hash, es + unit, next - unit);
+        if (kind == UNIT_HEADER && !header_size) {
+            header = unit;
+            header_size = next - unit;
+        }
+        pos = next;
+    }
+    if (!header_size || (m->have_fingerprint && hash == m->fingerprint)) return;
+    m->fingerprint = hash;
+    m->have_fingerprint = TRUE;
+
+    TsVideoFormat format = {TRUE, m->stream_type, 0, 0, 0, 1, FALSE, FALSE};
+    gboolean parsed = FALSE;
+    if (m->stream_type == TS_STREAM_TYPE_H264) {
+        parsed = parse_h264_sps(es + header, header_size, &format);
+    } else if (m->stream_type == TS_STREAM_TYPE_HEVC) {
+        parsed = parse_hevc_sps(es + header, header_size, &format);
+    } else {
+        parsed = parse_mpeg2_sequence(es + header + 1, header_size - 1, &format);
+    }
+    if (parsed) update_format(m, &format);
+}
+
+static void on_packet(const guint8 *pkt, guint16 pid, gpointer user_data)
+{
+    TsMetadata *m = user_data;
+    if (pid == PAT_PID) {
+        handle_pat(m, pkt);
+    } else if (pid == m->pmt_pid) {
+        handle_pmt(m, pkt);
+    } else if (pid == m->video_pid) {
+        handle_video(m, pkt);
+    }
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+TsMetadata *ts_metadata_new(TsFormatChangeFunc on_change, gpointer user_data)
+{
+    TsMetadata *m = g_new0(TsMetadata, 1);
+    g_mutex_init(&m->lock);
+    m->on_change = on_change;
+    m->user_data = user_data;
+    m->pat_key = -1;
+    m->pmt_key = -1;
+    m->format.fps_den = 1;
+    ts_sync_init(&m->sync);
+    ts_sync_filter_add(&m->sync, PAT_PID);
+    return m;
+}
+
+void ts_metadata_free(TsMetadata *meta)
+{
+    if (!meta) return;
+    g_mutex_clear(&meta->lock);
+    g_free(meta);
+}
+
+void ts_metadata_feed(TsMetadata *meta, const guint8 *data, gsize size)
+{
+    // Buffers need not start on a packet boundary: ts_sync locks onto the 188/192/204-byte
+    // cadence and carries partial packets over to the next buffer
+    ts_sync_feed(&meta->sync, data, size, on_packet, meta);
+}
+
+void ts_metadata_get_format(TsMetadata *meta, TsVideoFormat *format)
+{
+    g_mutex_lock(&meta->lock);
+    *format = meta->format;
+    g_mutex_unlock(&meta->lock);
+}
+
+void ts_metadata_get_stats(TsMetadata *meta, TsMetadataStats *stats)
+{
+    g_mutex_lock(&meta->lock);
+    *stats = meta->stats;
+    g_mutex_unlock(&meta->lock);
+}
@@ -0,0 +1,234 @@
+#include "ts_nulls.h"
+
+#include <string.h>
+
+#define MAX_PCR_GAP (TS_PCR_HZ / 2) // Longer gaps (spec: 100 ms) are treated as a discontinuity
+#define MAX_BITRATE G_GUINT64_CONSTANT(10000000000)
+#define PACKET_BITS (TS_PACKET_SIZE * 8)
+
+struct TsNulls {
+    TsSync sync;
+    TsNullsMode mode;
+    guint64 bitrate;
+    gint pcr_pid; // -1 until a PCR is seen, unless configured
+
+    // Pad mode: the packets of the current PCR interval, starting with its PCR packet
+    GByteArray *hold;
+    gboolean have_pcr;
+    guint64 last_pcr;
+    guint64 remainder; // Fraction of a packet carried to the next interval, in bits * TS_PCR_HZ
+
+    GByteArray *out; // Only set during ts_nulls_process
+    guint appended;
+    TsNullsStats stats;
+};
+
+// =============================================================================
+// Output
+// =============================================================================
+
+static inline void append_packet(TsNulls *n, const guint8 *pkt)
+{
+    guint len = n->out->len;
+    g_byte_array_set_size(n->out, len + TS_PACKET_SIZE);
+    memcpy(n->out->data + len, pkt, TS_PACKET_SIZE);
+    n->appended++;
+}
+
+static void append_nulls(TsNulls *n, guint count)
+{
+    if (count == 0) return;
+    guint len = n->out->len;
+    g_byte_array_set_size(n->out, len + count * TS_PACKET_SIZE);
+    guint8 *pkt = n->out->data + len;
+    memset(pkt, 0xFF, count * TS_PACKET_SIZE);
+    for (guint i = 0; i < count; i++, pkt += TS_PACKET_SIZE) {
+        pkt[0] = TS_SYNC_BYTE;
+        pkt[1] = 0x1F;
+        pkt[3] = 0x10; // Payload only; decoders ignore the null PID's continuity counter
+    }
+    n->appended += count;
+    n->stats.nulls_inserted += count;
+}
+
+// Emit the held interval with `nulls` null packets spread evenly after its packets, so the PCR
+// packet that opens the interval keeps its exact position at the output bitrate
+static void flush_hold(TsNulls *n, guint nulls)
+{
+    guint count = n->hold->len / TS_PACKET_SIZE;
+    guint emitted = 0;
+    for (guint i = 0; i < count; i++) {
+        append_packet(n, n->hold->data + i * TS_PACKET_SIZE);
+        guint due = (guint)((guint64)nulls * (i + 1) / count);
+        append_nulls(n, due - emitted);
+        emitted = due;
+    }
+    g_byte_array_set_size(n->hold, 0);
+}
+
+// =============================================================================
+// PCR pacing
+// =============================================================================
+
+static void interval_unpadded(TsNulls *n)
+{
+    flush_hold(n, 0);
+    n->remainder = 0;
+}
+
+static void on_pcr(TsNulls *n, const guint8 *pkt, guint64 pcr)
+{
+    if (n->have_pcr) {
+        guint64 delta = (pcr + TS_PCR_WRAP - n->last_pcr) % TS_PCR_WRAP;
+        guint held = n->hold->len / TS_PACKET_SIZE;
+
+        if (delta == 0 || delta > MAX_PCR_GAP) {
+            n->stats.discontinuities++;
+            interval_unpadded(n);
+        } else {
+            guint64 bits = n->bitrate * delta + n->remainder;
+            guint64 target = bits / (TS_PCR_HZ * PACKET_BITS);
+            if (target < held) {
+                n->stats.overflows++;
+                interval_unpadded(n);
+            } else {
+                n->remainder = bits % (TS_PCR_HZ * PACKET_BITS);
+                flush_hold(n, (guint)(target - held));
+            }
+        }
+    }
+
+    g_byte_array_append(n->hold, pkt, TS_PACKET_SIZE);
+    n->last_pcr = pcr;
+    n->have_pcr = TRUE;
+}
+
+static void on_packet(const guint8 *pkt, guint16 pid, gpointer user_data)
+{
+    TsNulls *n = user_data;
+
+    if (pid == TS_NULL_PID) {
+        n->stats.nulls_stripped++;
+        return;
+    }
+    if (n->mode == TS_NULLS_STRIP) {
+        append_packet(n, pkt);
+        return;
+    }
+
+    guint64 pcr;
+    if ((n->pcr_pid < 0 || pid == n->pcr_pid) && ts_packet_pcr(pkt, &pcr)) {
+        n->pcr_pid = pid;
+        on_pcr(n, pkt, pcr);
+        return;
+    }
+
+    if (!n->have_pcr) {
+        append_packet(n, pkt); // No timing yet: pass through unpadded
+        return;
+    }
+
+    g_byte_array_append(n->hold, pkt, TS_PACKET_SIZE);
+    if (n->hold->len / TS_PACKET_SIZE >= TS_NULLS_MAX_HOLD) {
+        // The PCR PID went quiet; release what we hold and wait for the next PCR
+        n->stats.discontinuities++;
+        interval_unpadded(n);
+        n->have_pcr = FALSE;
+    }
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+TsNulls *ts_nulls_new(cJSON *config)
+{
+    cJSON *mode = cJSON_GetObjectItem(config, "mode");
+    if (!cJSON_IsObject(config) || !cJSON_IsString(mode)) {
+        g_printerr("TsNulls: nulls config must be an object with a 'mode'\n");
+        return NULL;
+    }
+
+    TsNulls *n = g_new0(TsNulls, 1);
+    n->pcr_pid = -1;
+
+    if (strcmp(mode->valuestring, "strip") == 0) {
+        n->mode = TS_NULLS_STRIP;
+    } else if (strcmp(mode->valuestring, "pad") == 0) {
+        n->mode = TS_NULLS_PAD;
+        cJSON *bitrate = cJSON_GetObjectItem(config, "bitrate");
+        if (!cJSON_IsNumber(bitrate) || bitrate->valuedouble < PACKET_BITS ||
+            bitrate->valuedouble > (double)MAX_BITRATE) {
+            g_printerr("TsNulls: 'pad' needs a 'bitrate' in bits per second\n");
+            g_free(n);
+            return NULL;
+        }
+        n->bitrate = (guint64)bitrate->valuedouble;
+
+        cJSON *pcr_pid = cJSON_GetObjectItem(config, "pcr-pid");
+        if (pcr_pid) {
+            if (!cJSON_IsNumber(pcr_pid) || pcr_pid->valueint < 0 || pcr_pid->valueint >= TS_NULL_PID) {
+                g_printerr("TsNulls: invalid 'pcr-pid'\n");
+                g_free(n);
+                return NULL;
+            }
+            n->pcr_pid = pcr_pid->valueint;
+        }
+    } else {
+        g_printerr("TsNulls: unknown mode '%s' (expected 'strip' or 'pad')\n", mode->valuestring);
+        g_free(n);
+        return NULL;
+    }
+
+    ts_sync_init(&n->sync);
+    ts_sync_filter_all(&n->sync);
+    n->hold = g_byte_array_new();
+    return n;
+}
+
+void ts_nulls_free(TsNulls *nulls)
+{
+    if (!nulls) return;
+    g_byte_array_free(nulls->hold, TRUE);
+    g_free(nulls);
+}
+
+TsNullsMode ts_nulls_get_mode(TsNulls *nulls)
+{
+    return nulls->mode;
+}
+
+guint ts_nulls_process(TsNulls *nulls, const guint8 *data, gsize size, GByteArray *out)
+{
+    guint64 seen = nulls->sync.packets;
+    nulls->out = out;
+    nulls->appended = 0;
+    ts_sync_feed(&nulls->sync, data, size, on_packet, nulls);
+    nulls->out = NULL;
+
+    nulls->stats.packets_in += nulls->sync.packets - seen;
+    nulls->stats.packets_out += nulls->appended;
+    return nulls->appended;
+}
+
+void ts_nulls_get_stats(TsNulls *nulls, TsNullsStats *stats)
+{
+    *stats = nulls->stats;
+}
+
+void ts_nulls_stats_to_json(TsNulls *nulls, const TsNullsStats *stats, cJSON *parent)
+{
+    cJSON *obj = cJSON_AddObjectToObject(parent, "nulls");
+    cJSON_AddStringToObject(obj, "mode", nulls->mode == TS_NULLS_PAD ? "pad" : "strip");
+    if (nulls->mode == TS_NULLS_PAD) cJSON_AddNumberToObject(obj, "bitrate", (double)nulls->bitrate);
+    cJSON_AddNumberToObject(obj, "packets-in", (double)stats->packets_in);
+    cJSON_AddNumberToObject(obj, "packets-out", (double)stats->packets_out);
+    cJSON_AddNumberToObject(obj, "nulls-stripped", (double)stats->nulls_stripped);
+    cJSON_AddNumberToObject(obj, "nulls-inserted", (double)stats->nulls_inserted);
+    cJSON_AddNumberToObject(obj, "bytes-saved", (double)(stats->nulls_stripped * TS_PACKET_SIZE));
+    cJSON_AddNumberToObject(obj, "bytes-padded", (double)(stats->nulls_inserted * TS_PACKET_SIZE));
+    if (nulls->mode == TS_NULLS_PAD) {
+        cJSON_AddNumberToObject(obj, "overflows", (double)stats->overflows);
+        cJSON_AddNumberToObject(obj, "discontinuities", (double)stats->discontinuities);
+    }
+}
@@ -0,0 +1,293 @@
+#include "ts_pacer.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define DEFAULT_DELAY_MS 100
+#define DEFAULT_MAX_BURST 7
+#define MAX_BURST_LIMIT 64
+#define MAX_PCR_GAP (TS_PCR_HZ / 2) // Longer gaps (spec: 100 ms) or a PCR going backwards: resync
+#define SLEW_PPM 200                // How fast the offset may follow a sender clock slower than ours
+#define MIN_RESYNC_US G_USEC_PER_SEC
+
+struct TsPacer {
+    TsSync sync;
+    gint64 delay_us;
+    guint max_burst;
+    gint pcr_pid; // -1 until a PCR is seen, unless configured
+
+    // Packets since the last PCR, starting with its packet, waiting for the next PCR
+    GByteArray *hold;
+    gboolean have_pcr;
+    guint64 last_pcr; // Unwrapped, 27 MHz
+    gint64 offset_us; // Local time minus PCR time of the earliest arrival, slewed
+
+    // Scheduled packets, in departure order
+    guint8 *ring;
+    gint64 *due;
+    guint head;
+    guint count;
+    gint64 not_before; // Catch-up pacing once packets are overdue
+
+    gint64 now_us; // Only valid during ts_pacer_push
+
+    gboolean sent_any;
+    gint64 last_sent_at, last_sent_due;
+    gdouble jitter_sum;
+    guint64 jitter_count;
+    gint64 jitter_max;
+
+    TsPacerStats stats;
+};
+
+// =============================================================================
+// Queue
+// =============================================================================
+
+static void enqueue(TsPacer *p, const guint8 *pkt, gint64 due)
+{
+    if (p->count == TS_PACER_MAX_QUEUE) {
+        p->stats.dropped++;
+        return;
+    }
+    guint slot = (p->head + p->count) % TS_PACER_MAX_QUEUE;
+    memcpy(p->ring + (gsize)slot * TS_PACKET_SIZE, pkt, TS_PACKET_SIZE);
+    p->due[slot] = due;
+    p->count++;
+}
+
+// Send the held packets as soon as possible, without a clock
+static void release_unpaced(TsPacer *p)
+{
+    guint n = p->hold->len / TS_PACKET_SIZE;
+    for (guint i = 0; i < n; i++) enqueue(p, p->hold->data + i * TS_PACKET_SIZE, p->now_us);
+    p->stats.unpaced += n;
+    g_byte_array_set_size(p->hold, 0);
+}
+
+// =============================================================================
+// Clock Recovery
+// =============================================================================
+
+static void start_clock(TsPacer *p, const guint8 *pkt, guint64 pcr)
+{
+    p->last_pcr = pcr;
+    p->have_pcr = TRUE;
+    p->offset_us = p->now_us - (gint64)(pcr / 27);
+    g_byte_array_append(p->hold, pkt, TS_PACKET_SIZE);
+}
+
+// Give the held interval [last_pcr, pcr) departure times by interpolating between its PCRs
+static void schedule_hold(TsPacer *p, guint64 pcr)
+{
+    guint n = p->hold->len / TS_PACKET_SIZE;
+    guint64 span = pcr - p->last_pcr;
+    for (guint i = 0; i < n; i++) {
+        guint64 at = p->last_pcr + span * i / n;
+        gint64 due = (gint64)(at / 27) + p->offset_us + p->delay_us;
+        if (due < p->now_us) p->stats.late_packets++;
+        enqueue(p, p->hold->data + i * TS_PACKET_SIZE, due);
+    }
+    g_byte_array_set_size(p->hold, 0);
+}
+
+static void on_pcr(TsPacer *p, const guint8 *pkt, guint64 raw)
+{
+    if (!p->have_pcr) {
+        start_clock(p, pkt, raw);
+        return;
+    }
+
+    guint64 delta = (raw + TS_PCR_WRAP - p->last_pcr % TS_PCR_WRAP) % TS_PCR_WRAP;
+    if (delta == 0 || delta > MAX_PCR_GAP) {
+        p->stats.resyncs++;
+        release_unpaced(p);
+        start_clock(p, pkt, raw);
+        return;
+    }
+
+    guint64 pcr = p->last_pcr + delta;
+    gint64 measured = p->now_us - (gint64)(pcr / 27);
+    if (measured < p->offset_us) {
+        p->offset_us = measured;
+    } else if (measured - p->offset_us > MAX(4 * p->delay_us, MIN_RESYNC_US)) {
+        // Arrivals are far behind the clock for good (sender restarted its clock, long stall)
+        p->stats.resyncs++;
+        p->offset_us = measured;
+    } else {
+        p->offset_us = MIN(measured, p->offset_us + (gint64)(delta / 27) * SLEW_PPM / 1000000);
+    }
+
+    schedule_hold(p, pcr);
+    p->last_pcr = pcr;
+    g_byte_array_append(p->hold, pkt, TS_PACKET_SIZE);
+}
+
+static void on_packet(const guint8 *pkt, guint16 pid, gpointer user_data)
+{
+    TsPacer *p = user_data;
+
+    guint64 pcr;
+    if ((p->pcr_pid < 0 || pid == p->pcr_pid) && ts_packet_pcr(pkt, &pcr)) {
+        p->pcr_pid = pid;
+        on_pcr(p, pkt, pcr);
+        return;
+    }
+
+    if (!p->have_pcr) {
+        enqueue(p, pkt, p->now_us);
+        p->stats.unpaced++;
+        return;
+    }
+
+    g_byte_array_append(p->hold, pkt, TS_PACKET_SIZE);
+    if (p->hold->len / TS_PACKET_SIZE >= TS_PACER_MAX_HOLD) {
+        // The PCR PID went quiet; send what we hold and start over at the next PCR
+        release_unpaced(p);
+        p->have_pcr = FALSE;
+    }
+}
+
+// =============================================================================
+// Public API
+// =============================================================================
+
+TsPacer *ts_pacer_new(cJSON *config)
+{
+    if (!cJSON_IsObject(config)) {
+        g_printerr("TsPacer: pacing config must be an object\n");
+        return NULL;
+    }
+
+    gint64 delay_ms = DEFAULT_DELAY_MS;
+    guint max_burst = DEFAULT_MAX_BURST;
+    gint pcr_pid = -1;
+
+    cJSON *item = cJSON_GetObjectItem(config, "delay-ms");
+    if (item) {
+        if (!cJSON_IsNumber(item) || item->valueint < 1 || item->valueint > 10000) {
+            g_printerr("TsPacer: 'delay-ms' must be 1-10000\n");
+            return NULL;
+        }
+        delay_ms = item->valueint;
+    }
+    item = cJSON_GetObjectItem(config, "max-burst");
+    if (item) {
+        if (!cJSON_IsNumber(item) || item->valueint < 1 || item->valueint > MAX_BURST_LIMIT) {
+            g_printerr("TsPacer: 'max-burst' must be 1-%d packets\n", MAX_BURST_LIMIT);
+            return NULL;
+        }
+        max_burst = (guint)item->valueint;
+    }
+    item = cJSON_GetObjectItem(config, "pcr-pid");
+    if (item) {
+        if (!cJSON_IsNumber(item) || item->valueint < 0 || item->valueint >= TS_NULL_PID) {
+            g_printerr("TsPacer: invalid 'pcr-pid'\n");
+            return NULL;
+        }
+        pcr_pid = item->valueint;
+    }
+
+    TsPacer *p = g_new0(TsPacer, 1);
+    p->delay_us = delay_ms * 1000;
+    p->max_burst = max_burst;
+    p->pcr_pid = pcr_pid;
+    ts_sync_init(&p->sync);
+    ts_sync_filter_all(&p->sync);
+    p->hold = g_byte_array_new();
+    p->ring = g_malloc((gsize)TS_PACER_MAX_QUEUE * TS_PACKET_SIZE);
+    p->due = g_new(gint64, TS_PACER_MAX_QUEUE);
+    return p;
+}
+
+void ts_pacer_free(TsPacer *pacer)
+{
+    if (!pacer) return;
+    g_byte_array_free(pacer->hold, TRUE);
+    g_free(pacer->ring);
+    g_free(pacer->due);
+    g_free(pacer);
+}
+
+void ts_pacer_push(TsPacer *pacer, const guint8 *data, gsize size, gint64 now_us)
+{
+    guint64 seen = pacer->sync.packets;
+    pacer->now_us = now_us;
+    ts_sync_feed(&pacer->sync, data, size, on_packet, pacer);
+    pacer->stats.packets_in += pacer->sync.packets - seen;
+}
+
+gint64 ts_pacer_next_departure(TsPacer *pacer)
+{
+    if (pacer->count == 0) return -1;
+    return MAX(pacer->due[pacer->head], pacer->not_before);
+}
+
+guint ts_pacer_pop(TsPacer *pacer, GByteArray *out, gint64 now_us)
+{
+    if (pacer->count == 0 || ts_pacer_next_departure(pacer) > now_us) return 0;
+
+    gint64 first_due = pacer->due[pacer->head];
+    guint n = 0;
+    while (n < pacer->max_burst && pacer->count > 0 && pacer->due[pacer->head] <= now_us) {
+        g_byte_array_append(out, pacer->ring + (gsize)pacer->head * TS_PACKET_SIZE, TS_PACKET_SIZE);
+        pacer->head = (pacer->head + 1) % TS_PACER_MAX_QUEUE;
+        pacer->count--;
+        n++;
+    }
+    pacer->stats.packets_out += n;
+
+    // Overdue packets are caught up at twice their scheduled rate rather than in one burst
+    pacer->not_before = 0;
+    if (pacer->count > 0 && pacer->due[pacer->head] < now_us) {
+        pacer->not_before = now_us + (pacer->due[pacer->head] - first_due) / 2;
+    }
+
+    if (pacer->sent_any) {
+        gint64 jitter = llabs((now_us - pacer->last_sent_at) - (first_due - pacer->last_sent_due));
+        pacer->jitter_sum += (gdouble)jitter;
+        pacer->jitter_count++;
+        pacer->jitter_max = MAX(pacer->jitter_max, jitter);
+    }
+    pacer->sent_any = TRUE;
+    pacer->last_sent_at = now_us;
+    pacer->last_sent_due = first_due;
+    return n;
+}
+
+void ts_pacer_reset(TsPacer *pacer)
+{
+    ts_sync_reset(&pacer->sync);
+    g_byte_array_set_size(pacer->hold, 0);
+    pacer->have_pcr = FALSE;
+    pacer->head = 0;
+    pacer->count = 0;
+    pacer->not_before = 0;
+    pacer->sent_any = FALSE;
+}
+
+void ts_pacer_get_stats(TsPacer *pacer, TsPacerStats *stats)
+{
+    pacer->stats.queued = pacer->count;
+    pacer->stats.gap_jitter_avg_us = pacer->jitter_count ? pacer->jitter_sum / (gdouble)pacer->jitter_count : 0;
+    pacer->stats.gap_jitter_max_us = pacer->jitter_max;
+    *stats = pacer->stats;
+
+    pacer->jitter_sum = 0;
+    pacer->jitter_count = 0;
+    pacer->jitter_max = 0;
+}
+
+void ts_pacer_stats_to_json(const TsPacerStats *stats, cJSON *parent)
+{
+    cJSON *obj = cJSON_AddObjectToObject(parent, "pacing");
+    cJSON_AddNumberToObject(obj, "packets-in", (double)stats->packets_in);
+    cJSON_AddNumberToObject(obj, "packets-out", (double)stats->packets_out);
+    cJSON_AddNumberToObject(obj, "queued", stats->queued);
+    cJSON_AddNumberToObject(obj, "late-packets", (double)stats->late_packets);
+    cJSON_AddNumberToObject(obj, "unpaced-packets", (double)stats->unpaced);
+    cJSON_AddNumberToObject(obj, "dropped-packets", (double)stats->dropped);
+    cJSON_AddNumberToObject(obj, "resyncs", (double)stats->resyncs);
+    cJSON_AddNumberToObject(obj, "gap-jitter-avg-us", stats->gap_jitter_avg_us);
+    cJSON_AddNumberToObject(obj, "gap-jitter-max-us", (double)stats->gap_jitter_max_us);
+}
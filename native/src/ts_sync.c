@@ -0,0 +1,284 @@
+#include "ts_sync.h"
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define TS_SYNC_X86 1
+#endif
+
+// Sync bytes that must line up (including the candidate) before we trust a packet size
+#define TS_LOCK_DEPTH 3
+
+static const guint candidate_sizes[] = {TS_PACKET_SIZE, TS_M2TS_PACKET_SIZE, TS_RS_PACKET_SIZE};
+
+// =============================================================================
+// Sync Byte Search
+// =============================================================================
+
+static gsize find_sync_scalar(const guint8 *data, gsize size)
+{
+    for (gsize i = 0; i < size; i++) {
+        if (data[i] == TS_SYNC_BYTE) return i;
+    }
+    return size;
+}
+
+#ifdef TS_SYNC_X86
+__attribute__((target("sse2"))) static gsize find_sync_sse2(const guint8 *data, gsize size)
+{
+    const __m128i sync = _mm_set1_epi8(TS_SYNC_BYTE);
+    gsize i = 0;
+
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        guint mask = (guint)_mm_movemask_epi8(_mm_cmpeq_epi8(v, sync));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + find_sync_scalar(data + i, size - i);
+}
+
+__attribute__((target("avx2"))) static gsize find_sync_avx2(const guint8 *data, gsize size)
+{
+    const __m256i sync = _mm256_set1_epi8(TS_SYNC_BYTE);
+    gsize i = 0;
+
+    // Two vectors per iteration: one OR of the compare results decides whether to look closer
+    for (; i + 64 <= size; i += 64) {
+        __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i)), sync);
+        __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(data + i + 32)), sync);
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), _mm256_or_si256(a, b))) {
+            guint mask_a = (guint)_mm256_movemask_epi8(a);
+            if (mask_a) return i + __builtin_ctz(mask_a);
+            return i + 32 + __builtin_ctz((guint)_mm256_movemask_epi8(b));
+        }
+    }
+    for (; i + 32 <= size; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        guint mask = (guint)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, sync));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + find_sync_scalar(data + i, size - i);
+}
+#endif
+
+static gsize (*find_sync_impl)(const guint8 *data, gsize size) = find_sync_scalar;
+static TsSimdLevel simd_level = TS_SIMD_SCALAR;
+static pthread_once_t simd_once = PTHREAD_ONCE_INIT;
+
+static gboolean apply_simd_level(TsSimdLevel level)
+{
+    switch (level) {
+        case TS_SIMD_SCALAR:
+            find_sync_impl = find_sync_scalar;
+            break;
+#ifdef TS_SYNC_X86
+        case TS_SIMD_SSE2:
+            if (!__builtin_cpu_supports("sse2")) return FALSE;
+            find_sync_impl = find_sync_sse2;
+            break;
+        case TS_SIMD_AVX2:
+            if (!__builtin_cpu_supports("avx2")) return FALSE;
+            find_sync_impl = find_sync_avx2;
+            break;
+#endif
+        default:
+            return FALSE;
+    }
+    simd_level = level;
+    return TRUE;
+}
+
+static void select_simd_level(void)
+{
+#ifdef TS_SYNC_X86
+    __builtin_cpu_init();
+    if (!apply_simd_level(TS_SIMD_AVX2)) apply_simd_level(TS_SIMD_SSE2);
+#endif
+}
+
+gboolean ts_sync_set_simd_level(TsSimdLevel level)
+{
+    pthread_once(&simd_once, select_simd_level);
+    return apply_simd_level(level);
+}
+
+const char *ts_sync_simd_name(void)
+{
+    pthread_once(&simd_once, select_simd_level);
+    switch (simd_level) {
+        case TS_SIMD_AVX2:
+            return "avx2";
+        case TS_SIMD_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+gsize ts_sync_find(const guint8 *data, gsize size)
+{
+    pthread_once(&simd_once, select_simd_level);
+    return find_sync_impl(data, size);
+}
+
+// =============================================================================
+// PID Filter
+// =============================================================================
+
+void ts_sync_filter_add(TsSync *ts, guint16 pid)
+{
+    pid &= 0x1FFF;
+    ts->pid_filter[pid >> 6] |= G_GUINT64_CONSTANT(1) << (pid & 63);
+}
+
+void ts_sync_filter_remove(TsSync *ts, guint16 pid)
+{
+    pid &= 0x1FFF;
+    ts->pid_filter[pid >> 6] &= ~(G_GUINT64_CONSTANT(1) << (pid & 63));
+}
+
+void ts_sync_filter_clear(TsSync *ts)
+{
+    memset(ts->pid_filter, 0, sizeof(ts->pid_filter));
+}
+
+void ts_sync_filter_all(TsSync *ts)
+{
+    memset(ts->pid_filter, 0xFF, sizeof(ts->pid_filter));
+}
+
+// =============================================================================
+// Packet Cadence Tracking
+// =============================================================================
+
+void ts_sync_init(TsSync *ts)
+{
+    memset(ts, 0, sizeof(*ts));
+    pthread_once(&simd_once, select_simd_level);
+}
+
+void ts_sync_reset(TsSync *ts)
+{
+    ts->packet_size = 0;
+    ts->carry_len = 0;
+}
+
+static void lose_lock(TsSync *ts)
+{
+    ts->sync_losses++;
+    ts->last_packet_size = ts->packet_size;
+    ts->packet_size = 0;
+    ts->carry_len = 0;
+}
+
+// TRUE if the sync bytes after `at` follow `stride`; at least one follower must be inside the buffer
+static gboolean check_cadence(const guint8 *data, gsize size, gsize at, guint stride)
+{
+    guint confirmed = 0;
+    for (guint k = 1; k < TS_LOCK_DEPTH; k++) {
+        gsize next = at + k * stride;
+        if (next >= size) break;
+        if (data[next] != TS_SYNC_BYTE) return FALSE;
+        confirmed++;
+    }
+    return confirmed > 0;
+}
+
+// Scan forward from *pos for a sync byte with a valid cadence. On success *pos is the sync byte.
+static gboolean acquire_lock(TsSync *ts, const guint8 *data, gsize size, gsize *pos)
+{
+    gsize at = *pos;
+
+    while (at < size) {
+        at += ts_sync_find(data + at, size - at);
+        if (at >= size) break;
+
+        // Re-acquire with the previous packet size first; it is almost always still right
+        guint stride = 0;
+        if (ts->last_packet_size && check_cadence(data, size, at, ts->last_packet_size)) {
+            stride = ts->last_packet_size;
+        } else {
+            for (gsize i = 0; i < G_N_ELEMENTS(candidate_sizes); i++) {
+                if (check_cadence(data, size, at, candidate_sizes[i])) {
+                    stride = candidate_sizes[i];
+                    break;
+                }
+            }
+        }
+
+        if (stride) {
+            ts->bytes_skipped += at - *pos;
+            ts->packet_size = stride;
+            ts->last_packet_size = stride;
+            *pos = at;
+            return TRUE;
+        }
+        at++;
+    }
+
+    ts->bytes_skipped += size - *pos;
+    *pos = size;
+    return FALSE;
+}
+
+static inline gsize deliver(TsSync *ts, const guint8 *pkt, TsPacketFunc func, gpointer user_data)
+{
+    guint16 pid = TS_PID(pkt);
+    ts->packets++;
+    if (!ts_sync_filter_has(ts, pid)) return 0;
+    func(pkt, pid, user_data);
+    return 1;
+}
+
+gsize ts_sync_feed(TsSync *ts, const guint8 *data, gsize size, TsPacketFunc func, gpointer user_data)
+{
+    gsize pos = 0;
+    gsize delivered = 0;
+
+    // Complete the packet that straddled the previous buffer boundary
+    if (ts->carry_len > 0) {
+        gsize take = MIN(ts->packet_size - ts->carry_len, size);
+        memcpy(ts->carry + ts->carry_len, data, take);
+        ts->carry_len += take;
+        pos = take;
+
+        if (ts->carry_len < ts->packet_size) return 0;
+
+        ts->carry_len = 0;
+        delivered += deliver(ts, ts->carry, func, user_data);
+
+        if (pos < size && data[pos] != TS_SYNC_BYTE) lose_lock(ts);
+    }
+
+    while (pos < size) {
+        if (!ts->packet_size && !acquire_lock(ts, data, size, &pos)) break;
+
+        const guint stride = ts->packet_size;
+
+        // Verify the sync bytes of the whole aligned run first, then filter the run in one pass
+        gsize run_end = pos;
+        while (run_end + stride <= size && data[run_end] == TS_SYNC_BYTE) {
+            run_end += stride;
+        }
+
+        for (; pos < run_end; pos += stride) {
+            delivered += deliver(ts, data + pos, func, user_data);
+        }
+
+        if (pos >= size) break;
+
+        if (data[pos] != TS_SYNC_BYTE) {
+            lose_lock(ts);
+            continue;
+        }
+
+        // Partial packet at the end of the buffer: keep it for the next one
+        ts->carry_len = size - pos;
+        memcpy(ts->carry, data + pos, ts->carry_len);
+        pos = size;
+    }
+
+    return delivered;
+}
@@ -0,0 +1,399 @@
+#define _GNU_SOURCE
+#include "udp_source.h"
+
+#include <errno.h>
+#include <net/if.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "thread_policy.h"
+
+#define TS_SYNC_BYTE 0x47
+#define RTP_HEADER_SIZE 12
+#define POLL_TIMEOUT_MS 100 // Also how often a stalled reorder gap is checked without traffic
+
+struct UdpSource {
+    char address[INET6_ADDRSTRLEN];
+    char source_address[INET6_ADDRSTRLEN];
+    char interface[IF_NAMESIZE];
+    int port;
+    int buffer_size;
+    gsize mtu;
+    guint reorder_window;
+    gint64 reorder_delay_us;
+    UdpSourceRecvFunc recv_func;
+    gpointer user_data;
+
+    int fd;
+    pthread_t thread;
+    volatile gboolean running;
+    gboolean started;
+
+    // Receiver thread only
+    struct mmsghdr msgs[UDP_SOURCE_BATCH];
+    struct iovec iov[UDP_SOURCE_BATCH];
+    guint8 *buffers; // UDP_SOURCE_BATCH datagrams of mtu bytes
+    char control[UDP_SOURCE_BATCH][CMSG_SPACE(sizeof(guint32))];
+    GByteArray *out; // TS bytes of the current batch
+    RtpReorder *reorder;
+    guint32 ssrc;
+    gboolean have_ssrc;
+
+    pthread_mutex_t lock;
+    UdpSourceStats stats;
+    guint64 rate_bytes;
+    gint64 rate_time_us;
+};
+
+static void append_out(const guint8 *payload, gsize len, gpointer user_data)
+{
+    UdpSource *src = user_data;
+    g_byte_array_append(src->out, payload, len);
+}
+
+// Strip the RTP header (CSRCs, extension, padding); FALSE if the datagram is not RTP version 2
+static gboolean rtp_payload(const guint8 *data, gsize len, const guint8 **payload, gsize *payload_len)
+{
+    if (len < RTP_HEADER_SIZE || (data[0] & 0xc0) != 0x80) return FALSE;
+    gsize offset = RTP_HEADER_SIZE + 4 * (data[0] & 0x0f);
+    if (data[0] & 0x10) {
+        if (offset + 4 > len) return FALSE;
+        offset += 4 + 4 * (((gsize)data[offset + 2] << 8) | data[offset + 3]);
+    }
+    gsize padding = (data[0] & 0x20) ? data[len - 1] : 0;
+    if (offset + padding > len) return FALSE;
+    *payload = data + offset;
+    *payload_len = len - offset - padding;
+    return TRUE;
+}
+
+static void handle_datagram(UdpSource *src, const guint8 *data, gsize len, gint64 now_us, UdpSourceStats *delta)
+{
+    if (len > 0 && data[0] == TS_SYNC_BYTE) {
+        g_byte_array_append(src->out, data, len);
+        delta->rtp = FALSE;
+        return;
+    }
+
+    const guint8 *payload;
+    gsize payload_len;
+    if (!rtp_payload(data, len, &payload, &payload_len)) {
+        delta->invalid++;
+        return;
+    }
+    delta->rtp = TRUE;
+
+    guint32 ssrc = ((guint32)data[8] << 24) | ((guint32)data[9] << 16) | ((guint32)data[10] << 8) | data[11];
+    if (src->have_ssrc && ssrc != src->ssrc) {
+        rtp_reorder_reset(src->reorder, append_out, src);
+        delta->ssrc_changes++;
+    }
+    src->ssrc = ssrc;
+    src->have_ssrc = TRUE;
+
+    guint16 seq = (guint16)((data[2] << 8) | data[3]);
+    rtp_reorder_push(src->reorder, seq, payload, payload_len, now_us, append_out, src);
+}
+
+// Hand over what the batch produced and fold its counters into the shared stats
+static void finish_batch(UdpSource *src, const UdpSourceStats *delta, guint32 drops, gboolean have_drops)
+{
+    if (src->out->len) {
+        src->recv_func(src->out->data, src->out->len, src->user_data);
+    }
+
+    pthread_mutex_lock(&src->lock);
+    UdpSourceStats *st = &src->stats;
+    if (delta->datagrams) st->rtp = delta->rtp;
+    st->datagrams += delta->datagrams;
+    st->reads += delta->reads;
+    st->bytes += src->out->len;
+    st->truncated += delta->truncated;
+    st->invalid += delta->invalid;
+    st->ssrc_changes += delta->ssrc_changes;
+    if (have_drops) st->socket_drops = drops; // The kernel keeps a running total
+    rtp_reorder_get_stats(src->reorder, &st->rtp_stats);
+    pthread_mutex_unlock(&src->lock);
+
+    g_byte_array_set_size(src->out, 0);
+}
+
+static void *udp_source_worker(void *arg)
+{
+    UdpSource *src = arg;
+    thread_policy_apply_self(THREAD_ROLE_SOURCE, "udp-source");
+
+    while (src->running) {
+        struct pollfd pfd = {.fd = src->fd, .events = POLLIN};
+        int ready = poll(&pfd, 1, POLL_TIMEOUT_MS);
+
+        UdpSourceStats delta = {0};
+        guint32 drops = 0;
+        gboolean have_drops = FALSE;
+        gint64 now_us = g_get_monotonic_time();
+        // Drain the socket; a short batch means it is empty
+        for (int n = UDP_SOURCE_BATCH; ready > 0 && n == UDP_SOURCE_BATCH;) {
+            for (int i = 0; i < UDP_SOURCE_BATCH; i++) {
+                src->msgs[i].msg_hdr.msg_controllen = sizeof(src->control[i]);
+                src->msgs[i].msg_hdr.msg_flags = 0;
+            }
+            n = recvmmsg(src->fd, src->msgs, UDP_SOURCE_BATCH, MSG_DONTWAIT, NULL);
+            if (n <= 0) break;
+            delta.reads++;
+            delta.datagrams += (guint64)n;
+
+            for (int i = 0; i < n; i++) {
+                struct msghdr *hdr = &src->msgs[i].msg_hdr;
+                if (hdr->msg_flags & MSG_TRUNC) {
+                    delta.truncated++;
+                    continue;
+                }
+                handle_datagram(src, hdr->msg_iov->iov_base, src->msgs[i].msg_len, now_us, &delta);
+                for (struct cmsghdr *c = CMSG_FIRSTHDR(hdr); c; c = CMSG_NXTHDR(hdr, c)) {
+                    if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SO_RXQ_OVFL) {
+                        memcpy(&drops, CMSG_DATA(c), sizeof(drops));
+                        have_drops = TRUE;
+                    }
+                }
+            }
+            // One push per batch, so downstream sees data at the rate it arrives
+            finish_batch(src, &delta, drops, have_drops);
+            memset(&delta, 0, sizeof(delta));
+        }
+
+        rtp_reorder_expire(src->reorder, g_get_monotonic_time(), append_out, src);
+        finish_batch(src, &delta, drops, have_drops);
+    }
+    thread_policy_forget_self();
+    return NULL;
+}
+
+UdpSource *udp_source_new(cJSON *config, UdpSourceRecvFunc recv_func, gpointer user_data)
+{
+    cJSON *address = cJSON_GetObjectItem(config, "address");
+    cJSON *port = cJSON_GetObjectItem(config, "port");
+    cJSON *source_address = cJSON_GetObjectItem(config, "source-address");
+    cJSON *iface = cJSON_GetObjectItem(config, "multicast-iface");
+    cJSON *buffer_size = cJSON_GetObjectItem(config, "buffer-size");
+    cJSON *mtu = cJSON_GetObjectItem(config, "mtu");
+    cJSON *window = cJSON_GetObjectItem(config, "reorder-window");
+    cJSON *reorder_ms = cJSON_GetObjectItem(config, "reorder-ms");
+
+    if (!cJSON_IsNumber(port) || port->valueint < 1 || port->valueint > 65535 ||
+        (address && !cJSON_IsString(address)) || (source_address && !cJSON_IsString(source_address)) ||
+        (iface && !cJSON_IsString(iface)) ||
+        (buffer_size && (!cJSON_IsNumber(buffer_size) || buffer_size->valueint < 0)) ||
+        (mtu && (!cJSON_IsNumber(mtu) || mtu->valueint < 188 || mtu->valueint > 65507)) ||
+        (window && !cJSON_IsNumber(window)) ||
+        (reorder_ms && (!cJSON_IsNumber(reorder_ms) || reorder_ms->valueint < 0 || reorder_ms->valueint > 1000))) {
+        g_printerr("UdpSource: invalid config (port 1..65535, mtu 188..65507, reorder-ms 0..1000)\n");
+        return NULL;
+    }
+
+    UdpSource *src = g_new0(UdpSource, 1);
+    g_strlcpy(src->address, address && address->valuestring[0] ? address->valuestring : "0.0.0.0",
+              sizeof(src->address));
+    if (source_address) g_strlcpy(src->source_address, source_address->valuestring, sizeof(src->source_address));
+    if (iface) g_strlcpy(src->interface, iface->valuestring, sizeof(src->interface));
+    src->port = port->valueint;
+    src->buffer_size = buffer_size && buffer_size->valueint > 0 ? buffer_size->valueint
+                                                                : UDP_SOURCE_DEFAULT_BUFFER_SIZE;
+    src->mtu = mtu ? (gsize)mtu->valueint : UDP_SOURCE_DEFAULT_MTU;
+    src->reorder_window = window ? (guint)window->valueint : UDP_SOURCE_DEFAULT_REORDER_WINDOW;
+    src->reorder_delay_us = (gint64)(reorder_ms ? reorder_ms->valueint : UDP_SOURCE_DEFAULT_REORDER_MS) * 1000;
+    src->recv_func = recv_func;
+    src->user_data = user_data;
+    src->fd = -1;
+    pthread_mutex_init(&src->lock, NULL);
+
+    src->reorder = rtp_reorder_new(src->reorder_window, src->mtu, src->reorder_delay_us);
+    if (!src->reorder) {
+        udp_source_free(src);
+        return NULL;
+    }
+    src->buffers = g_malloc((gsize)UDP_SOURCE_BATCH * src->mtu);
+    src->out = g_byte_array_sized_new(UDP_SOURCE_BATCH * src->mtu);
+    for (int i = 0; i < UDP_SOURCE_BATCH; i++) {
+        src->iov[i].iov_base = src->buffers + (gsize)i * src->mtu;
+        src->iov[i].iov_len = src->mtu;
+        src->msgs[i].msg_hdr.msg_iov = &src->iov[i];
+        src->msgs[i].msg_hdr.msg_iovlen = 1;
+        src->msgs[i].msg_hdr.msg_control = src->control[i];
+    }
+    return src;
+}
+
+void udp_source_free(UdpSource *src)
+{
+    if (!src) return;
+    udp_source_stop(src);
+    rtp_reorder_free(src->reorder);
+    if (src->out) g_byte_array_free(src->out, TRUE);
+    g_free(src->buffers);
+    pthread_mutex_destroy(&src->lock);
+    g_free(src);
+}
+
+static gboolean is_multicast(const struct sockaddr *sa)
+{
+    if (sa->sa_family == AF_INET) {
+        return IN_MULTICAST(ntohl(((const struct sockaddr_in *)sa)->sin_addr.s_addr));
+    }
+    return sa->sa_family == AF_INET6 && IN6_IS_ADDR_MULTICAST(&((const struct sockaddr_in6 *)sa)->sin6_addr);
+}
+
+// Any-source or source-specific join on the configured interface (or the routing table's choice)
+static gboolean join_group(UdpSource *src, const struct addrinfo *group)
+{
+    int level = group->ai_family == AF_INET ? IPPROTO_IP : IPPROTO_IPV6;
+    unsigned int ifindex = 0;
+    if (src->interface[0] && !(ifindex = if_nametoindex(src->interface))) {
+        g_printerr("UdpSource: unknown interface %s\n", src->interface);
+        return FALSE;
+    }
+
+    if (!src->source_address[0]) {
+        struct group_req req = {.gr_interface = ifindex};
+        memcpy(&req.gr_group, group->ai_addr, group->ai_addrlen);
+        if (setsockopt(src->fd, level, MCAST_JOIN_GROUP, &req, sizeof(req)) == 0) return TRUE;
+        g_printerr("UdpSource: cannot join %s: %s\n", src->address, strerror(errno));
+        return FALSE;
+    }
+
+    struct addrinfo hints = {.ai_family = group->ai_family, .ai_flags = AI_NUMERICHOST}, *source = NULL;
+    if (getaddrinfo(src->source_address, NULL, &hints, &source) != 0) {
+        g_printerr("UdpSource: source-address %s is not an address of the group's family\n", src->source_address);
+        return FALSE;
+    }
+    struct group_source_req req = {.gsr_interface = ifindex};
+    memcpy(&req.gsr_group, group->ai_addr, group->ai_addrlen);
+    memcpy(&req.gsr_source, source->ai_addr, source->ai_addrlen);
+    freeaddrinfo(source);
+    if (setsockopt(src->fd, level, MCAST_JOIN_SOURCE_GROUP, &req, sizeof(req)) == 0) return TRUE;
+    g_printerr("UdpSource: cannot join %s from %s: %s\n", src->address, src->source_address, strerror(errno));
+    return FALSE;
+}
+
+static gboolean open_socket(UdpSource *src)
+{
+    char port[8];
+    snprintf(port, sizeof(port), "%d", src->port);
+    struct addrinfo hints = {.ai_socktype = SOCK_DGRAM, .ai_flags = AI_NUMERICHOST | AI_PASSIVE}, *ai = NULL;
+    if (getaddrinfo(src->address, port, &hints, &ai) != 0) {
+        g_printerr("UdpSource: invalid address %s\n", src->address);
+        return FALSE;
+    }
+
+    gboolean multicast = is_multicast(ai->ai_addr);
+    if (src->source_address[0] && !multicast) {
+        g_printerr("UdpSource: source-address needs a multicast group address\n");
+        freeaddrinfo(ai);
+        return FALSE;
+    }
+
+    src->fd = socket(ai->ai_family, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (src->fd < 0) {
+        g_printerr("UdpSource: cannot create socket: %s\n", strerror(errno));
+        freeaddrinfo(ai);
+        return FALSE;
+    }
+    int one = 1;
+    // Several routes may take the same group and port
+    setsockopt(src->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    setsockopt(src->fd, SOL_SOCKET, SO_RXQ_OVFL, &one, sizeof(one));
+    if (setsockopt(src->fd, SOL_SOCKET, SO_RCVBUFFORCE, &src->buffer_size, sizeof(src->buffer_size)) < 0) {
+        setsockopt(src->fd, SOL_SOCKET, SO_RCVBUF, &src->buffer_size, sizeof(src->buffer_size));
+    }
+    socklen_t optlen = sizeof(src->stats.socket_buffer_bytes);
+    getsockopt(src->fd, SOL_SOCKET, SO_RCVBUF, &src->stats.socket_buffer_bytes, &optlen);
+    if (src->stats.socket_buffer_bytes < src->buffer_size) {
+        g_printerr("UdpSource: receive buffer is %d bytes, not %d (raise net.core.rmem_max or grant CAP_NET_ADMIN)\n",
+                   src->stats.socket_buffer_bytes, src->buffer_size);
+    }
+
+    // Binding the group address keeps other groups on the same port out of this socket
+    gboolean ok = bind(src->fd, ai->ai_addr, ai->ai_addrlen) == 0;
+    if (!ok) g_printerr("UdpSource: cannot bind %s:%d: %s\n", src->address, src->port, strerror(errno));
+    if (ok && multicast) ok = join_group(src, ai);
+    src->stats.multicast = multicast;
+    freeaddrinfo(ai);
+    return ok;
+}
+
+gboolean udp_source_start(UdpSource *src)
+{
+    if (src->started) return TRUE;
+    src->started = TRUE;
+
+    gboolean ok = open_socket(src);
+    if (ok) {
+        src->have_ssrc = FALSE;
+        rtp_reorder_reset(src->reorder, append_out, src);
+        g_byte_array_set_size(src->out, 0); // Nothing to flush into a restarted stream
+        src->running = TRUE;
+        ok = pthread_create(&src->thread, NULL, udp_source_worker, src) == 0;
+        if (!ok) g_printerr("UdpSource: failed to start receiver\n");
+    }
+    if (!ok) {
+        src->running = FALSE;
+        udp_source_stop(src);
+        return FALSE;
+    }
+    g_print("UdpSource: receiving on %s:%d%s%s\n", src->address, src->port,
+            src->source_address[0] ? " from " : "", src->source_address);
+    return TRUE;
+}
+
+void udp_source_stop(UdpSource *src)
+{
+    if (!src->started) return;
+    if (src->running) {
+        src->running = FALSE;
+        pthread_join(src->thread, NULL);
+    }
+    // Closing the socket leaves the group
+    if (src->fd >= 0) close(src->fd);
+    src->fd = -1;
+    src->started = FALSE;
+}
+
+void udp_source_get_stats(UdpSource *src, UdpSourceStats *stats)
+{
+    gint64 now_us = g_get_monotonic_time();
+    pthread_mutex_lock(&src->lock);
+    if (src->rate_time_us && now_us > src->rate_time_us) {
+        src->stats.receive_rate_mbps = (src->stats.bytes - src->rate_bytes) * 8.0 / (now_us - src->rate_time_us);
+    }
+    src->rate_bytes = src->stats.bytes;
+    src->rate_time_us = now_us;
+    *stats = src->stats;
+    pthread_mutex_unlock(&src->lock);
+}
+
+void udp_source_stats_to_json(UdpSource *src, const UdpSourceStats *stats, cJSON *root)
+{
+    cJSON *obj = cJSON_AddObjectToObject(root, "udp-ingest");
+    cJSON_AddStringToObject(obj, "address", src->address);
+    cJSON_AddNumberToObject(obj, "port", src->port);
+    if (src->source_address[0]) cJSON_AddStringToObject(obj, "source-address", src->source_address);
+    cJSON_AddBoolToObject(obj, "multicast", stats->multicast);
+    cJSON_AddBoolToObject(obj, "rtp", stats->rtp);
+    cJSON_AddNumberToObject(obj, "socket-buffer-bytes", stats->socket_buffer_bytes);
+    cJSON_AddNumberToObject(obj, "datagrams", (double)stats->datagrams);
+    cJSON_AddNumberToObject(obj, "datagrams-per-read", stats->reads ? (double)stats->datagrams / stats->reads : 0.0);
+    cJSON_AddNumberToObject(obj, "socket-drops", (double)stats->socket_drops);
+    cJSON_AddNumberToObject(obj, "truncated", (double)stats->truncated);
+    cJSON_AddNumberToObject(obj, "invalid", (double)stats->invalid);
+    cJSON_AddNumberToObject(obj, "rtp-lost", (double)stats->rtp_stats.lost);
+    cJSON_AddNumberToObject(obj, "rtp-reordered", (double)stats->rtp_stats.reordered);
+    cJSON_AddNumberToObject(obj, "rtp-duplicates", (double)stats->rtp_stats.duplicates);
+    cJSON_AddNumberToObject(obj, "rtp-late", (double)stats->rtp_stats.late);
+    cJSON_AddNumberToObject(obj, "rtp-resyncs", (double)stats->rtp_stats.resyncs);
+    cJSON_AddNumberToObject(obj, "ssrc-changes", (double)stats->ssrc_changes);
+}
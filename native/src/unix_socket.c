@@ -1,5 +1,6 @@
 #include "unix_socket.h"
 
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -7,6 +8,10 @@
 
 int sock;
 
+// Stats, events and stream IDs are sent from the stats thread, the main loop and SRT callback threads;
+// each message goes out whole, never interleaved with another thread's
+static pthread_mutex_t send_lock = PTHREAD_MUTEX_INITIALIZER;
+
 void init_unix_socket(const char* socket_path)
 {
     struct sockaddr_un addr;
@@ -31,9 +36,18 @@ void init_unix_socket(const char* socket_path)
 
 void send_message_to_unix_socket(const char* message)
 {
-    if (send(sock, message, strlen(message), 0) < 0) {
-        perror("send");
+    size_t len = strlen(message);
+    pthread_mutex_lock(&send_lock);
+    while (len > 0) {
+        ssize_t n = send(sock, message, len, 0);
+        if (n < 0) {
+            perror("send");
+            break;
+        }
+        message += n;
+        len -= (size_t)n;
     }
+    pthread_mutex_unlock(&send_lock);
 }
 
 void cleanup_socket()
@@ -0,0 +1,326 @@
+#include "video_health.h"
+
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define VIDEO_HEALTH_X86 1
+#endif
+
+// Bytes per 32-bit squared-sum flush; 4096 pixels cannot overflow a lane
+#define SUMS_CHUNK 4096
+
+struct VideoHealth {
+    guint black_luma;
+    gdouble black_max_stddev;
+    gdouble freeze_max_diff;
+    gint64 min_duration_us;
+
+    GMutex lock; // Frames arrive on the streaming thread, stats are read by the stats thread
+    guint8 *previous; // Packed luma of the previous frame
+    guint width;
+    guint height;
+
+    gint64 black_since_us; // First frame of the current black run, 0 if not black
+    gint64 frozen_since_us;
+    gint64 last_frame_us;
+    VideoHealthStats stats;
+};
+
+// =============================================================================
+// Kernels
+// =============================================================================
+
+static void luma_sums_scalar(const guint8 *p, gsize n, guint64 *sum, guint64 *sum_sq)
+{
+    guint64 s = 0, sq = 0;
+    for (gsize i = 0; i < n; i++) {
+        s += p[i];
+        sq += (guint32)p[i] * p[i];
+    }
+    *sum += s;
+    *sum_sq += sq;
+}
+
+static guint64 sad_scalar(const guint8 *a, const guint8 *b, gsize n)
+{
+    guint64 sad = 0;
+    for (gsize i = 0; i < n; i++) sad += (guint)abs((gint)a[i] - (gint)b[i]);
+    return sad;
+}
+
+#ifdef VIDEO_HEALTH_X86
+__attribute__((target("sse2"))) static void luma_sums_sse2(const guint8 *p, gsize n, guint64 *sum, guint64 *sum_sq)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i s = zero;
+    gsize i = 0;
+    while (i + 16 <= n) {
+        __m128i sq = zero;
+        gsize end = MIN(n, i + SUMS_CHUNK);
+        for (; i + 16 <= end; i += 16) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+            s = _mm_add_epi64(s, _mm_sad_epu8(v, zero));
+            __m128i lo = _mm_unpacklo_epi8(v, zero), hi = _mm_unpackhi_epi8(v, zero);
+            sq = _mm_add_epi32(sq, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+        }
+        guint32 lanes[4];
+        _mm_storeu_si128((__m128i *)lanes, sq);
+        *sum_sq += (guint64)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+    guint64 halves[2];
+    _mm_storeu_si128((__m128i *)halves, s);
+    *sum += halves[0] + halves[1];
+    luma_sums_scalar(p + i, n - i, sum, sum_sq);
+}
+
+__attribute__((target("sse2"))) static guint64 sad_sse2(const guint8 *a, const guint8 *b, gsize n)
+{
+    __m128i acc = _mm_setzero_si128();
+    gsize i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    guint64 halves[2];
+    _mm_storeu_si128((__m128i *)halves, acc);
+    return halves[0] + halves[1] + sad_scalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2"))) static void luma_sums_avx2(const guint8 *p, gsize n, guint64 *sum, guint64 *sum_sq)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i s = zero;
+    gsize i = 0;
+    while (i + 32 <= n) {
+        __m256i sq = zero;
+        gsize end = MIN(n, i + SUMS_CHUNK);
+        for (; i + 32 <= end; i += 32) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+            s = _mm256_add_epi64(s, _mm256_sad_epu8(v, zero));
+            __m256i lo = _mm256_unpacklo_epi8(v, zero), hi = _mm256_unpackhi_epi8(v, zero);
+            sq = _mm256_add_epi32(sq, _mm256_add_epi32(_mm256_madd_epi16(lo, lo), _mm256_madd_epi16(hi, hi)));
+        }
+        guint32 lanes[8];
+        _mm256_storeu_si256((__m256i *)lanes, sq);
+        for (int l = 0; l < 8; l++) *sum_sq += lanes[l];
+    }
+    guint64 quarters[4];
+    _mm256_storeu_si256((__m256i *)quarters, s);
+    *sum += quarters[0] + quarters[1] + quarters[2] + quarters[3];
+    luma_sums_scalar(p + i, n - i, sum, sum_sq);
+}
+
+__attribute__((target("avx2"))) static guint64 sad_avx2(const guint8 *a, const guint8 *b, gsize n)
+{
+    __m256i acc = _mm256_setzero_si256();
+    gsize i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(va, vb));
+    }
+    guint64 quarters[4];
+    _mm256_storeu_si256((__m256i *)quarters, acc);
+    return quarters[0] + quarters[1] + quarters[2] + quarters[3] + sad_scalar(a + i, b + i, n - i);
+}
+#endif
+
+static void (*luma_sums_impl)(const guint8 *p, gsize n, guint64 *sum, guint64 *sum_sq) = luma_sums_scalar;
+static guint64 (*sad_impl)(const guint8 *a, const guint8 *b, gsize n) = sad_scalar;
+static TsSimdLevel simd_level = TS_SIMD_SCALAR;
+static pthread_once_t simd_once = PTHREAD_ONCE_INIT;
+
+static gboolean apply_simd_level(TsSimdLevel level)
+{
+    switch (level) {
+        case TS_SIMD_SCALAR:
+            luma_sums_impl = luma_sums_scalar;
+            sad_impl = sad_scalar;
+            break;
+#ifdef VIDEO_HEALTH_X86
+        case TS_SIMD_SSE2:
+            if (!__builtin_cpu_supports("sse2")) return FALSE;
+            luma_sums_impl = luma_sums_sse2;
+            sad_impl = sad_sse2;
+            break;
+        case TS_SIMD_AVX2:
+            if (!__builtin_cpu_supports("avx2")) return FALSE;
+            luma_sums_impl = luma_sums_avx2;
+            sad_impl = sad_avx2;
+            break;
+#endif
+        default:
+            return FALSE;
+    }
+    simd_level = level;
+    return TRUE;
+}
+
+static void select_simd_level(void)
+{
+#ifdef VIDEO_HEALTH_X86
+    __builtin_cpu_init();
+    if (!apply_simd_level(TS_SIMD_AVX2)) apply_simd_level(TS_SIMD_SSE2);
+#endif
+}
+
+gboolean video_health_set_simd_level(TsSimdLevel level)
+{
+    pthread_once(&simd_once, select_simd_level);
+    return apply_simd_level(level);
+}
+
+const char *video_health_simd_name(void)
+{
+    pthread_once(&simd_once, select_simd_level);
+    switch (simd_level) {
+        case TS_SIMD_AVX2:
+            return "avx2";
+        case TS_SIMD_SSE2:
+            return "sse2";
+        default:
+            return "scalar";
+    }
+}
+
+void video_health_luma_sums(const guint8 *p, gsize n, guint64 *sum, guint64 *sum_sq)
+{
+    luma_sums_impl(p, n, sum, sum_sq);
+}
+
+guint64 video_health_sad(const guint8 *a, const guint8 *b, gsize n)
+{
+    return sad_impl(a, b, n);
+}
+
+// =============================================================================
+// Detection
+// =============================================================================
+
+VideoHealth *video_health_new(cJSON *config)
+{
+    if (config && !cJSON_IsObject(config) && !cJSON_IsTrue(config)) {
+        g_printerr("VideoHealth: config must be an object or true\n");
+        return NULL;
+    }
+
+    cJSON *black_luma = cJSON_GetObjectItem(config, "black-luma");
+    cJSON *black_stddev = cJSON_GetObjectItem(config, "black-max-stddev");
+    cJSON *freeze_diff = cJSON_GetObjectItem(config, "freeze-max-diff");
+    cJSON *min_duration = cJSON_GetObjectItem(config, "min-duration-ms");
+    if ((black_luma && (!cJSON_IsNumber(black_luma) || black_luma->valueint < 0 || black_luma->valueint > 255)) ||
+        (black_stddev && (!cJSON_IsNumber(black_stddev) || black_stddev->valuedouble < 0)) ||
+        (freeze_diff && (!cJSON_IsNumber(freeze_diff) || freeze_diff->valuedouble < 0)) ||
+        (min_duration && (!cJSON_IsNumber(min_duration) || min_duration->valueint < 0 ||
+                          min_duration->valueint > VIDEO_HEALTH_MIN_DURATION_MS_MAX))) {
+        g_printerr("VideoHealth: invalid config (black-luma 0..255, min-duration-ms 0..%d)\n",
+                   VIDEO_HEALTH_MIN_DURATION_MS_MAX);
+        return NULL;
+    }
+    pthread_once(&simd_once, select_simd_level);
+
+    VideoHealth *vh = g_new0(VideoHealth, 1);
+    g_mutex_init(&vh->lock);
+    vh->black_luma = black_luma ? (guint)black_luma->valueint : VIDEO_HEALTH_DEFAULT_BLACK_LUMA;
+    vh->black_max_stddev = black_stddev ? black_stddev->valuedouble : VIDEO_HEALTH_DEFAULT_BLACK_MAX_STDDEV;
+    vh->freeze_max_diff = freeze_diff ? freeze_diff->valuedouble : VIDEO_HEALTH_DEFAULT_FREEZE_MAX_DIFF;
+    vh->min_duration_us = (gint64)(min_duration ? min_duration->valueint : VIDEO_HEALTH_DEFAULT_MIN_DURATION_MS) * 1000;
+    return vh;
+}
+
+void video_health_free(VideoHealth *vh)
+{
+    if (!vh) return;
+    g_mutex_clear(&vh->lock);
+    g_free(vh->previous);
+    g_free(vh);
+}
+
+// Advance one run (black or frozen): start or end it, and count an event when it reaches the minimum
+static void update_run(VideoHealth *vh, gboolean condition, gint64 *since_us, gint64 now_us, gboolean *state,
+                       gint64 *run_ms, guint64 *events)
+{
+    if (!condition) {
+        *since_us = 0;
+        *state = FALSE;
+        *run_ms = 0;
+        return;
+    }
+    if (!*since_us) *since_us = now_us;
+    *run_ms = (now_us - *since_us) / 1000;
+    if (!*state && now_us - *since_us >= vh->min_duration_us) {
+        *state = TRUE;
+        (*events)++;
+    }
+}
+
+void video_health_frame(VideoHealth *vh, const guint8 *luma, guint width, guint height, guint stride,
+                        gint64 now_us)
+{
+    if (width == 0 || height == 0) return;
+    gsize pixels = (gsize)width * height;
+    guint64 sum = 0, sum_sq = 0, sad = 0;
+
+    g_mutex_lock(&vh->lock);
+    gboolean comparable = vh->previous && vh->width == width && vh->height == height;
+    if (!comparable) {
+        g_free(vh->previous);
+        vh->previous = g_malloc(pixels);
+        vh->width = width;
+        vh->height = height;
+    }
+
+    for (guint y = 0; y < height; y++) {
+        const guint8 *row = luma + (gsize)y * stride;
+        guint8 *prev = vh->previous + (gsize)y * width;
+        video_health_luma_sums(row, width, &sum, &sum_sq);
+        if (comparable) sad += video_health_sad(row, prev, width);
+        memcpy(prev, row, width);
+    }
+
+    gdouble mean = (gdouble)sum / pixels;
+    gdouble variance = MAX((gdouble)sum_sq / pixels - mean * mean, 0.0);
+    VideoHealthStats *st = &vh->stats;
+    st->luma_mean = mean;
+    st->luma_stddev = sqrt(variance);
+    st->motion = comparable ? (gdouble)sad / pixels : 0.0;
+    st->frames++;
+    vh->last_frame_us = now_us;
+
+    gboolean black = mean <= vh->black_luma && st->luma_stddev <= vh->black_max_stddev;
+    gboolean unchanged = comparable && st->motion <= vh->freeze_max_diff;
+    update_run(vh, black, &vh->black_since_us, now_us, &st->black, &st->black_ms, &st->black_events);
+    // The first frame after a size change starts a new comparison, it does not end a freeze
+    if (comparable) {
+        update_run(vh, unchanged, &vh->frozen_since_us, now_us, &st->frozen, &st->frozen_ms, &st->freeze_events);
+    }
+    g_mutex_unlock(&vh->lock);
+}
+
+void video_health_get_stats(VideoHealth *vh, gint64 now_us, VideoHealthStats *stats)
+{
+    g_mutex_lock(&vh->lock);
+    *stats = vh->stats;
+    stats->frame_age_ms = vh->last_frame_us ? (now_us - vh->last_frame_us) / 1000 : -1;
+    g_mutex_unlock(&vh->lock);
+}
+
+void video_health_stats_to_json(const VideoHealthStats *stats, cJSON *root)
+{
+    cJSON *obj = cJSON_AddObjectToObject(root, "video-health");
+    cJSON_AddStringToObject(obj, "state", stats->black ? "black" : stats->frozen ? "frozen" : "ok");
+    cJSON_AddNumberToObject(obj, "black-ms", (double)stats->black_ms);
+    cJSON_AddNumberToObject(obj, "frozen-ms", (double)stats->frozen_ms);
+    cJSON_AddNumberToObject(obj, "black-events", (double)stats->black_events);
+    cJSON_AddNumberToObject(obj, "freeze-events", (double)stats->freeze_events);
+    cJSON_AddNumberToObject(obj, "luma-mean", round(stats->luma_mean * 10.0) / 10.0);
+    cJSON_AddNumberToObject(obj, "luma-stddev", round(stats->luma_stddev * 10.0) / 10.0);
+    cJSON_AddNumberToObject(obj, "motion", round(stats->motion * 100.0) / 100.0);
+    cJSON_AddNumberToObject(obj, "frames", (double)stats->frames);
+    cJSON_AddNumberToObject(obj, "frame-age-ms", (double)stats->frame_age_ms);
+}
@@ -0,0 +1,192 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/admission.h"
+#include "test_suites.h"
+
+#define SECOND G_USEC_PER_SEC
+
+static Admission *admission_from(const char *json)
+{
+    cJSON *config = cJSON_Parse(json);
+    assert_non_null(config);
+    Admission *adm = admission_new(config);
+    cJSON_Delete(config);
+    return adm;
+}
+
+static void test_admission_without_config_accepts_all(void **state)
+{
+    (void)state;
+    Admission *adm = admission_new(NULL);
+    assert_non_null(adm);
+
+    for (int i = 0; i < 100; i++) {
+        assert_int_equal(admission_check(adm, "198.51.100.1", NULL, i), ADMISSION_ACCEPT);
+    }
+
+    AdmissionStats stats;
+    admission_get_stats(adm, &stats);
+    assert_int_equal(stats.accepted, 100);
+    admission_free(adm);
+}
+
+static void test_admission_allow_lists(void **state)
+{
+    (void)state;
+    Admission *adm = admission_from("{\"allow-stream-ids\": [\"cam1\", \"cam2\"],"
+                                    " \"allow-ips\": [\"10.1.0.0/16\", \"192.0.2.7\", \"2001:db8::/32\"]}");
+    assert_non_null(adm);
+
+    assert_int_equal(admission_check(adm, "10.1.200.3", "cam1", 0), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "::ffff:10.1.0.9", "cam2", 0), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "2001:db8:1::5", "cam1", 0), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "192.0.2.7", "cam1", 0), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "192.0.2.8", "cam1", 0), ADMISSION_REJECT_IP);
+    assert_int_equal(admission_check(adm, "10.2.0.1", "cam1", 0), ADMISSION_REJECT_IP);
+    assert_int_equal(admission_check(adm, "10.1.0.1", "cam3", 0), ADMISSION_REJECT_STREAM_ID);
+    assert_int_equal(admission_check(adm, "10.1.0.1", NULL, 0), ADMISSION_REJECT_STREAM_ID);
+
+    AdmissionStats stats;
+    admission_get_stats(adm, &stats);
+    assert_int_equal(stats.accepted, 4);
+    assert_int_equal(stats.rejected[ADMISSION_REJECT_IP], 2);
+    assert_int_equal(stats.rejected[ADMISSION_REJECT_STREAM_ID], 2);
+    admission_free(adm);
+
+    assert_null(admission_from("{\"allow-ips\": [\"10.0.0.0/33\"]}"));
+    assert_null(admission_from("{\"allow-ips\": [\"not-an-address\"]}"));
+}
+
+static void test_admission_rejects_control_characters(void **state)
+{
+    (void)state;
+    // Even without a config: the stream ID is written into newline-framed control socket messages
+    Admission *adm = admission_new(NULL);
+    assert_int_equal(admission_check(adm, "10.1.0.1", "cam1\nroute_id:other", 0), ADMISSION_REJECT_MALFORMED);
+    assert_int_equal(admission_check(adm, "10.1.0.1", "cam1\revent:{}", 0), ADMISSION_REJECT_MALFORMED);
+    assert_int_equal(admission_check(adm, "10.1.0.1", "cam\x7f", 0), ADMISSION_REJECT_MALFORMED);
+    assert_int_equal(admission_check(adm, "10.1.0.1", "#!::r=cam1,m=publish", 0), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "10.1.0.1", "caméra", 0), ADMISSION_ACCEPT);
+
+    assert_false(admission_stream_id_is_safe("a\tb"));
+    assert_true(admission_stream_id_is_safe(""));
+    assert_true(admission_stream_id_is_safe(NULL));
+
+    AdmissionStats stats;
+    admission_get_stats(adm, &stats);
+    assert_int_equal(stats.rejected[ADMISSION_REJECT_MALFORMED], 3);
+    assert_int_equal(stats.accepted, 2);
+    admission_free(adm);
+}
+
+static void test_admission_per_ip_rate(void **state)
+{
+    (void)state;
+    Admission *adm = admission_from("{\"per-ip-rate\": 1, \"per-ip-burst\": 2}");
+    gint64 now = 10 * SECOND;
+
+    assert_int_equal(admission_check(adm, "198.51.100.1", "a", now), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "198.51.100.1", "a", now), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "198.51.100.1", "a", now), ADMISSION_REJECT_IP_RATE);
+
+    // Another address has its own bucket, and the first one refills at one token per second
+    assert_int_equal(admission_check(adm, "198.51.100.2", "a", now), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "198.51.100.1", "a", now + SECOND), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "198.51.100.1", "a", now + SECOND), ADMISSION_REJECT_IP_RATE);
+    admission_free(adm);
+}
+
+static void test_admission_global_rate_and_max_callers(void **state)
+{
+    (void)state;
+    Admission *adm =
+        admission_from("{\"allow-stream-ids\": [\"cam1\"], \"rate\": 2, \"burst\": 2, \"max-callers\": 1}");
+    gint64 now = 10 * SECOND;
+
+    // Refused callers never use up the global tokens
+    for (int i = 0; i < 10; i++) {
+        assert_int_equal(admission_check(adm, "198.51.100.9", "scanner", now), ADMISSION_REJECT_STREAM_ID);
+    }
+
+    assert_int_equal(admission_check(adm, "198.51.100.1", "cam1", now), ADMISSION_ACCEPT);
+    admission_caller_added(adm);
+    assert_int_equal(admission_check(adm, "198.51.100.1", "cam1", now), ADMISSION_REJECT_MAX_CALLERS);
+    admission_caller_removed(adm);
+
+    assert_int_equal(admission_check(adm, "198.51.100.1", "cam1", now), ADMISSION_ACCEPT);
+    assert_int_equal(admission_check(adm, "198.51.100.1", "cam1", now), ADMISSION_REJECT_RATE);
+    assert_int_equal(admission_check(adm, "198.51.100.1", "cam1", now + SECOND), ADMISSION_ACCEPT);
+
+    AdmissionStats stats;
+    admission_get_stats(adm, &stats);
+    cJSON *root = cJSON_CreateObject();
+    admission_stats_to_json(&stats, root);
+    cJSON *obj = cJSON_GetObjectItem(root, "admission");
+    assert_int_equal(cJSON_GetObjectItem(obj, "accepted")->valueint, 3);
+    assert_int_equal(cJSON_GetObjectItem(obj, "rejected-stream-id")->valueint, 10);
+    assert_int_equal(cJSON_GetObjectItem(obj, "rejected-max-callers")->valueint, 1);
+    assert_int_equal(cJSON_GetObjectItem(obj, "rejected-rate")->valueint, 1);
+    cJSON_Delete(root);
+    admission_free(adm);
+}
+
+static void write_file(const char *path, const char *contents)
+{
+    FILE *f = fopen(path, "w");
+    assert_non_null(f);
+    fputs(contents, f);
+    fclose(f);
+}
+
+static void test_admission_reloads_allow_list_file(void **state)
+{
+    (void)state;
+    char path[] = "/tmp/blackgate_admission_XXXXXX";
+    int fd = mkstemp(path);
+    assert_true(fd >= 0);
+    close(fd);
+    write_file(path, "{\"allow-stream-ids\": [\"cam1\"]}");
+
+    char config[128];
+    snprintf(config, sizeof(config), "{\"allow-list-file\": \"%s\"}", path);
+    Admission *adm = admission_from(config);
+    assert_non_null(adm);
+    assert_int_equal(admission_check(adm, "10.0.0.1", "cam2", 0), ADMISSION_REJECT_STREAM_ID);
+
+    // An invalid file keeps the lists in force
+    usleep(10 * 1000);
+    write_file(path, "{\"allow-stream-ids\": [");
+    admission_reload_if_changed(adm);
+    assert_int_equal(admission_check(adm, "10.0.0.1", "cam1", 0), ADMISSION_ACCEPT);
+
+    usleep(10 * 1000);
+    write_file(path, "{\"allow-stream-ids\": [\"cam1\", \"cam2\"]}");
+    admission_reload_if_changed(adm);
+    assert_int_equal(admission_check(adm, "10.0.0.1", "cam2", 0), ADMISSION_ACCEPT);
+
+    AdmissionStats stats;
+    admission_get_stats(adm, &stats);
+    assert_int_equal(stats.reloads, 1);
+
+    admission_free(adm);
+    unlink(path);
+}
+
+int run_admission_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_admission_without_config_accepts_all),
+        cmocka_unit_test(test_admission_allow_lists),
+        cmocka_unit_test(test_admission_rejects_control_characters),
+        cmocka_unit_test(test_admission_per_ip_rate),
+        cmocka_unit_test(test_admission_global_rate_and_max_callers),
+        cmocka_unit_test(test_admission_reloads_allow_list_file),
+    };
+    return cmocka_run_group_tests_name("admission", tests, NULL, NULL);
+}
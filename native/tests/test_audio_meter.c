@@ -0,0 +1,129 @@
+#include <cmocka.h>
+#include <math.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/audio_meter.h"
+#include "test_suites.h"
+
+// `seconds` of a sine at `dbfs` peak on the channels set in `mask`, the others silent
+static void feed_sine(AudioMeter *m, guint rate, guint channels, guint mask, gdouble freq, gdouble dbfs,
+                      gdouble seconds, guint64 *phase)
+{
+    gfloat buf[1000 * AUDIO_METER_MAX_CHANNELS];
+    gdouble amplitude = pow(10.0, dbfs / 20.0);
+    gsize total = (gsize)(seconds * rate);
+
+    // Odd chunk sizes so blocks and chunks never line up
+    for (gsize done = 0; done < total;) {
+        gsize n = MIN((gsize)997, total - done);
+        for (gsize i = 0; i < n; i++) {
+            gfloat v = (gfloat)(amplitude * sin(2.0 * G_PI * freq * (gdouble)(*phase)++ / rate));
+            for (guint ch = 0; ch < channels; ch++) buf[i * channels + ch] = (mask & (1u << ch)) ? v : 0.0f;
+        }
+        audio_meter_process(m, buf, n);
+        done += n;
+    }
+}
+
+static void test_audio_meter_kernels_agree(void **state)
+{
+    (void)state;
+    gfloat x[1030];
+    for (guint i = 0; i < G_N_ELEMENTS(x); i++) x[i] = (gfloat)sin(i * 0.37) * (gfloat)(i % 17) / 17.0f;
+    x[1027] = -1.5f; // Peak in the scalar tail of every implementation
+
+    for (gsize n = 0; n < G_N_ELEMENTS(x); n += 13) {
+        audio_meter_set_simd_level(TS_SIMD_SCALAR);
+        gfloat peak = audio_meter_peak(x, n);
+        gdouble sum = audio_meter_sum_squares(x, n);
+
+        for (TsSimdLevel level = TS_SIMD_SSE2; level <= TS_SIMD_AVX2; level++) {
+            if (!audio_meter_set_simd_level(level)) continue;
+            assert_true(audio_meter_peak(x, n) == peak);
+            assert_true(fabs(audio_meter_sum_squares(x, n) - sum) <= 1e-9 * (sum + 1.0));
+        }
+    }
+    audio_meter_set_simd_level(TS_SIMD_SCALAR);
+    assert_true(audio_meter_peak(x, G_N_ELEMENTS(x)) == 1.5f);
+    if (!audio_meter_set_simd_level(TS_SIMD_AVX2)) audio_meter_set_simd_level(TS_SIMD_SSE2);
+}
+
+static void test_audio_meter_r128_reference(void **state)
+{
+    (void)state;
+    // EBU Tech 3341: a 1 kHz stereo sine at -23 dBFS reads -23 LUFS, at any sample rate
+    guint rates[] = {48000, 44100};
+    for (guint r = 0; r < G_N_ELEMENTS(rates); r++) {
+        AudioMeter *m = audio_meter_new(rates[r], 2);
+        assert_non_null(m);
+        guint64 phase = 0;
+        feed_sine(m, rates[r], 2, 0x3, 1000.0, -23.0, 3.0, &phase);
+
+        AudioMeterStats stats;
+        audio_meter_get_stats(m, &stats);
+        assert_true(fabs(stats.short_term_lufs + 23.0) < 0.1);
+        assert_true(fabs(stats.momentary_lufs + 23.0) < 0.1);
+        assert_true(fabs(stats.peak_dbfs[0] + 23.0) < 0.05);
+        assert_true(fabs(stats.rms_dbfs[1] + 26.01) < 0.05);
+        assert_int_equal(stats.silent_ms, 0);
+        audio_meter_free(m);
+    }
+
+    // The LFE of 5.1 does not count towards loudness
+    AudioMeter *m = audio_meter_new(48000, 6);
+    guint64 phase = 0;
+    feed_sine(m, 48000, 6, 1u << 3, 60.0, -6.0, 1.0, &phase);
+    AudioMeterStats stats;
+    audio_meter_get_stats(m, &stats);
+    assert_true(stats.short_term_lufs == AUDIO_METER_FLOOR_DB);
+    assert_true(fabs(stats.peak_dbfs[3] + 6.0) < 0.05);
+    audio_meter_free(m);
+
+    assert_null(audio_meter_new(48000, 0));
+    assert_null(audio_meter_new(48000, AUDIO_METER_MAX_CHANNELS + 1));
+}
+
+static void test_audio_meter_silence_and_windows(void **state)
+{
+    (void)state;
+    AudioMeter *m = audio_meter_new(48000, 2);
+    guint64 phase = 0;
+    feed_sine(m, 48000, 2, 0x3, 440.0, -20.0, 1.0, &phase);
+    feed_sine(m, 48000, 2, 0x3, 440.0, -70.0, 2.0, &phase); // Below the silence threshold but not zero
+
+    AudioMeterStats stats;
+    audio_meter_get_stats(m, &stats);
+    assert_int_equal(stats.silent_ms, 2000);
+    assert_true(fabs(stats.peak_dbfs[0] + 20.0) < 0.05); // Peak of the whole window
+    assert_int_equal(stats.frames, 3 * 48000);
+
+    // The next window only sees what came after the report
+    audio_meter_get_stats(m, &stats);
+    assert_true(stats.peak_dbfs[0] == AUDIO_METER_FLOOR_DB);
+    assert_true(stats.rms_dbfs[0] == AUDIO_METER_FLOOR_DB);
+
+    feed_sine(m, 48000, 2, 0x1, 440.0, -30.0, 0.5, &phase);
+    audio_meter_get_stats(m, &stats);
+    assert_int_equal(stats.silent_ms, 0);
+    assert_true(stats.peak_dbfs[1] == AUDIO_METER_FLOOR_DB);
+
+    cJSON *obj = cJSON_CreateObject();
+    audio_meter_stats_to_json(&stats, obj);
+    assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(obj, "peak-dbfs")), 2);
+    assert_int_equal((int)cJSON_GetArrayItem(cJSON_GetObjectItem(obj, "peak-dbfs"), 0)->valuedouble, -30);
+    cJSON_Delete(obj);
+    audio_meter_free(m);
+}
+
+int run_audio_meter_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_audio_meter_kernels_agree),
+        cmocka_unit_test(test_audio_meter_r128_reference),
+        cmocka_unit_test(test_audio_meter_silence_and_windows),
+    };
+    return cmocka_run_group_tests_name("audio_meter", tests, NULL, NULL);
+}
@@ -0,0 +1,194 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/buffer_batch.h"
+#include "test_suites.h"
+
+typedef struct {
+    GMutex lock;
+    guint lists;
+    guint buffers;
+    guint last_list_length;
+    gboolean got_eos;
+    guint buffers_at_eos;
+    GstElement *reach_back; // Read from downstream of each list, as a stats poll would
+    guint reach_back_reads;
+} Captured;
+
+static Captured captured;
+
+static GstFlowReturn capture_chain_list(GstPad *pad, GstObject *parent, GstBufferList *list)
+{
+    (void)pad;
+    (void)parent;
+    if (captured.reach_back) {
+        guint max_buffers = 0;
+        g_object_get(captured.reach_back, "max-buffers", &max_buffers, NULL);
+        g_mutex_lock(&captured.lock);
+        captured.reach_back_reads += max_buffers > 0;
+        g_mutex_unlock(&captured.lock);
+    }
+    g_mutex_lock(&captured.lock);
+    captured.lists++;
+    captured.last_list_length = gst_buffer_list_length(list);
+    captured.buffers += captured.last_list_length;
+    g_mutex_unlock(&captured.lock);
+    gst_buffer_list_unref(list);
+    return GST_FLOW_OK;
+}
+
+static gboolean capture_event(GstPad *pad, GstObject *parent, GstEvent *event)
+{
+    (void)pad;
+    (void)parent;
+    if (GST_EVENT_TYPE(event) == GST_EVENT_EOS) {
+        g_mutex_lock(&captured.lock);
+        captured.got_eos = TRUE;
+        captured.buffers_at_eos = captured.buffers;
+        g_mutex_unlock(&captured.lock);
+    }
+    gst_event_unref(event);
+    return TRUE;
+}
+
+typedef struct {
+    GstElement *batch;
+    GstPad *src;
+    GstPad *capture;
+} Harness;
+
+static void harness_start(Harness *h, guint max_buffers, GstClockTime max_latency)
+{
+    memset(&captured, 0, sizeof(captured));
+    g_mutex_init(&captured.lock);
+
+    assert_true(buffer_batch_register());
+    h->batch = gst_element_factory_make("bgbatch", NULL);
+    assert_non_null(h->batch);
+    g_object_set(h->batch, "max-buffers", max_buffers, "max-latency", max_latency, NULL);
+
+    h->capture = gst_pad_new("capture", GST_PAD_SINK);
+    gst_pad_set_chain_list_function(h->capture, capture_chain_list);
+    gst_pad_set_event_function(h->capture, capture_event);
+    gst_pad_set_active(h->capture, TRUE);
+    GstPad *batch_src = gst_element_get_static_pad(h->batch, "src");
+    assert_int_equal(gst_pad_link(batch_src, h->capture), GST_PAD_LINK_OK);
+    gst_object_unref(batch_src);
+
+    h->src = gst_pad_new("feed", GST_PAD_SRC);
+    gst_pad_set_active(h->src, TRUE);
+    GstPad *batch_sink = gst_element_get_static_pad(h->batch, "sink");
+    assert_int_equal(gst_pad_link(h->src, batch_sink), GST_PAD_LINK_OK);
+    gst_object_unref(batch_sink);
+
+    gst_element_set_state(h->batch, GST_STATE_PLAYING);
+    gst_pad_push_event(h->src, gst_event_new_stream_start("test"));
+    GstSegment segment;
+    gst_segment_init(&segment, GST_FORMAT_BYTES);
+    gst_pad_push_event(h->src, gst_event_new_segment(&segment));
+}
+
+static void harness_stop(Harness *h)
+{
+    gst_element_set_state(h->batch, GST_STATE_NULL);
+    gst_pad_set_active(h->src, FALSE);
+    gst_pad_set_active(h->capture, FALSE);
+    gst_object_unref(h->src);
+    gst_object_unref(h->capture);
+    gst_object_unref(h->batch);
+    g_mutex_clear(&captured.lock);
+}
+
+static void push_buffers(Harness *h, guint count)
+{
+    for (guint i = 0; i < count; i++) {
+        assert_int_equal(gst_pad_push(h->src, gst_buffer_new_allocate(NULL, 1316, NULL)), GST_FLOW_OK);
+    }
+}
+
+static void test_batch_groups_by_count(void **state)
+{
+    (void)state;
+    Harness h;
+    harness_start(&h, 4, GST_SECOND);
+
+    push_buffers(&h, 10);
+    g_mutex_lock(&captured.lock);
+    assert_int_equal(captured.lists, 2);
+    assert_int_equal(captured.buffers, 8);
+    g_mutex_unlock(&captured.lock);
+
+    // EOS must not overtake the two buffers still waiting for a full list
+    gst_pad_push_event(h.src, gst_event_new_eos());
+    g_mutex_lock(&captured.lock);
+    assert_int_equal(captured.lists, 3);
+    assert_int_equal(captured.last_list_length, 2);
+    assert_true(captured.got_eos);
+    assert_int_equal(captured.buffers_at_eos, 10);
+    g_mutex_unlock(&captured.lock);
+
+    harness_stop(&h);
+}
+
+static void test_batch_flushes_on_latency(void **state)
+{
+    (void)state;
+    Harness h;
+    harness_start(&h, 32, 5 * GST_MSECOND);
+
+    push_buffers(&h, 3);
+    g_mutex_lock(&captured.lock);
+    assert_int_equal(captured.lists, 0);
+    g_mutex_unlock(&captured.lock);
+
+    // A partial list leaves once max-latency has passed, without further input
+    guint lists = 0;
+    for (int i = 0; i < 100 && lists == 0; i++) {
+        usleep(2000);
+        g_mutex_lock(&captured.lock);
+        lists = captured.lists;
+        g_mutex_unlock(&captured.lock);
+    }
+    assert_int_equal(lists, 1);
+    assert_int_equal(captured.last_list_length, 3);
+
+    harness_stop(&h);
+}
+
+static void test_batch_pushes_outside_lock(void **state)
+{
+    (void)state;
+    Harness h;
+    harness_start(&h, 4, 5 * GST_MSECOND);
+    captured.reach_back = h.batch;
+
+    // Both the full list from the streaming thread and the timed one from the flush task reach
+    // downstream with the element unlocked: reading a property from there must not deadlock
+    push_buffers(&h, 5);
+    guint lists = 0;
+    for (int i = 0; i < 100 && lists < 2; i++) {
+        usleep(2000);
+        g_mutex_lock(&captured.lock);
+        lists = captured.lists;
+        g_mutex_unlock(&captured.lock);
+    }
+    assert_int_equal(lists, 2);
+    assert_int_equal(captured.reach_back_reads, 2);
+    assert_int_equal(captured.last_list_length, 1);
+
+    harness_stop(&h);
+}
+
+int run_buffer_batch_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_batch_groups_by_count),
+        cmocka_unit_test(test_batch_flushes_on_latency),
+        cmocka_unit_test(test_batch_pushes_outside_lock),
+    };
+    return cmocka_run_group_tests_name("buffer_batch", tests, NULL, NULL);
+}
@@ -0,0 +1,118 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/caller_stats.h"
+#include "test_suites.h"
+
+static int formatted;
+
+static void format_key(gpointer key, char *buf, gsize size)
+{
+    formatted++;
+    snprintf(buf, size, "10.0.0.%d:9000", GPOINTER_TO_INT(key));
+}
+
+static void update(CallerStats *cs, int id, gint64 sent, gint64 lost, gdouble rtt_ms)
+{
+    CallerSample sample = {sent, lost, 0, 0, (guint64)sent * 1316, rtt_ms, 2.0};
+    caller_stats_update(cs, GINT_TO_POINTER(id), &sample);
+}
+
+static const char *address_at(cJSON *root, const char *array, int index)
+{
+    cJSON *item = cJSON_GetArrayItem(cJSON_GetObjectItem(root, array), index);
+    assert_non_null(item);
+    return cJSON_GetObjectItem(item, "caller-address")->valuestring;
+}
+
+static void test_caller_stats_aggregate_and_deltas(void **state)
+{
+    (void)state;
+    formatted = 0;
+    CallerStats *cs = caller_stats_new(NULL, NULL, format_key);
+
+    caller_stats_begin(cs);
+    for (int id = 1; id <= 3; id++) update(cs, id, 1000, 0, 10.0 * id);
+    cJSON *root = cJSON_CreateObject();
+    caller_stats_end(cs, FALSE, root);
+    assert_int_equal(cJSON_GetObjectItem(root, "connected-callers")->valueint, 3);
+    assert_int_equal(cJSON_GetObjectItem(root, "callers-connected")->valueint, 3);
+    assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(root, "callers")), 3);
+    cJSON_Delete(root);
+
+    // Caller 2 leaves, caller 4 joins; known callers are not formatted again
+    caller_stats_begin(cs);
+    update(cs, 1, 2000, 0, 10.0);
+    update(cs, 3, 2000, 0, 30.0);
+    update(cs, 4, 500, 0, 5.0);
+    root = cJSON_CreateObject();
+    caller_stats_end(cs, FALSE, root);
+    assert_int_equal(formatted, 4);
+    assert_int_equal(cJSON_GetObjectItem(root, "connected-callers")->valueint, 3);
+    assert_int_equal(cJSON_GetObjectItem(root, "callers-connected")->valueint, 1);
+    assert_int_equal(cJSON_GetObjectItem(root, "callers-disconnected")->valueint, 1);
+    assert_int_equal(cJSON_GetObjectItem(root, "callers-connected-total")->valueint, 4);
+    assert_int_equal(cJSON_GetObjectItem(root, "callers-disconnected-total")->valueint, 1);
+
+    cJSON *aggregate = cJSON_GetObjectItem(root, "callers-aggregate");
+    assert_int_equal(cJSON_GetObjectItem(aggregate, "packets-sent")->valueint, 4500);
+    assert_int_equal(cJSON_GetObjectItem(aggregate, "rtt-ms-max")->valueint, 30);
+    assert_int_equal(cJSON_GetObjectItem(aggregate, "rtt-ms-avg")->valueint, 15);
+    assert_string_equal(address_at(root, "callers-worst-rtt", 0), "10.0.0.3:9000");
+    assert_string_equal(address_at(root, "callers-worst-rtt", 2), "10.0.0.4:9000");
+    cJSON_Delete(root);
+    caller_stats_free(cs);
+}
+
+static void test_caller_stats_top_k_and_detail(void **state)
+{
+    (void)state;
+    CallerStats *cs = caller_stats_new(NULL, NULL, format_key);
+    int n = CALLER_STATS_DETAIL_LIMIT + 20;
+
+    caller_stats_begin(cs);
+    for (int id = 1; id <= n; id++) update(cs, id, 10000, 0, 20.0);
+    cJSON *root = cJSON_CreateObject();
+    caller_stats_end(cs, FALSE, root);
+    cJSON_Delete(root);
+
+    // Loss ranks by the share lost since the previous report, not by the running total
+    caller_stats_begin(cs);
+    for (int id = 1; id <= n; id++) update(cs, id, 11000, id == 7 ? 50 : id == 9 ? 100 : id == 11 ? 10 : 0, id);
+    root = cJSON_CreateObject();
+    caller_stats_end(cs, FALSE, root);
+
+    cJSON *loss = cJSON_GetObjectItem(root, "callers-worst-loss");
+    assert_int_equal(cJSON_GetArraySize(loss), 3);
+    assert_string_equal(address_at(root, "callers-worst-loss", 0), "10.0.0.9:9000");
+    assert_string_equal(address_at(root, "callers-worst-loss", 1), "10.0.0.7:9000");
+    assert_int_equal(cJSON_GetObjectItem(cJSON_GetArrayItem(loss, 0), "loss-percent")->valueint, 10);
+    assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(root, "callers-worst-rtt")), CALLER_STATS_TOP_K);
+    assert_string_equal(address_at(root, "callers-worst-rtt", 0), "10.0.0.36:9000");
+    assert_string_equal(address_at(root, "callers-worst-rtt", 4), "10.0.0.32:9000");
+    assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(root, "callers")), 0);
+    cJSON_Delete(root);
+
+    // Full detail on request
+    caller_stats_begin(cs);
+    for (int id = 1; id <= n; id++) update(cs, id, 12000, 0, 1.0);
+    root = cJSON_CreateObject();
+    caller_stats_end(cs, TRUE, root);
+    assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(root, "callers")), n);
+    assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(root, "callers-worst-loss")), 0);
+    cJSON_Delete(root);
+    caller_stats_free(cs);
+}
+
+int run_caller_stats_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_caller_stats_aggregate_and_deltas),
+        cmocka_unit_test(test_caller_stats_top_k_and_detail),
+    };
+    return cmocka_run_group_tests_name("caller_stats", tests, NULL, NULL);
+}
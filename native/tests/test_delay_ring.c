@@ -0,0 +1,204 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/delay_ring.h"
+#include "test_suites.h"
+
+#define PACKETS_PER_BUFFER 7
+#define BUFFER_SIZE (PACKETS_PER_BUFFER * TS_PACKET_SIZE)
+
+static DelayRing *ring_from_json(const char *json, gint64 max_delay_us)
+{
+    cJSON *config = json ? cJSON_Parse(json) : NULL;
+    DelayRing *ring =
+        delay_ring_new(config, max_delay_us, (DelayRingRefFunc)g_bytes_ref, (GDestroyNotify)g_bytes_unref);
+    cJSON_Delete(config);
+    return ring;
+}
+
+static gint64 delay_from_json(const char *json)
+{
+    cJSON *config = cJSON_Parse(json);
+    gint64 delay_us = delay_ring_parse_delay(config);
+    cJSON_Delete(config);
+    return delay_us;
+}
+
+// One buffer of seven packets on PID 0x100; the first carries `pcr_us` as its PCR unless it is negative
+static GBytes *make_buffer(gint64 pcr_us, guint8 tag)
+{
+    guint8 *data = g_malloc0(BUFFER_SIZE);
+    for (guint i = 0; i < PACKETS_PER_BUFFER; i++) {
+        guint8 *pkt = data + i * TS_PACKET_SIZE;
+        pkt[0] = TS_SYNC_BYTE;
+        pkt[1] = 0x01;
+        pkt[3] = 0x10;
+        pkt[100] = tag;
+    }
+    if (pcr_us >= 0) put_pcr_packet(data, (guint64)pcr_us * 90 / 1000 * 300);
+    return g_bytes_new_take(data, BUFFER_SIZE);
+}
+
+static void push(DelayRing *ring, GBytes *buffer, gint64 now_us)
+{
+    gsize size;
+    const guint8 *data = g_bytes_get_data(buffer, &size);
+    delay_ring_push(ring, buffer, data, size, now_us);
+    g_bytes_unref(buffer);
+}
+
+static guint8 tag_of(GBytes *buffer)
+{
+    return ((const guint8 *)g_bytes_get_data(buffer, NULL))[100];
+}
+
+static void test_delay_ring_rejects_invalid_config(void **state)
+{
+    (void)state;
+    assert_null(ring_from_json("5", 1000000));
+    assert_null(ring_from_json("{\"max-bitrate\": 10}", 1000000));
+    assert_null(ring_from_json("{\"max-bitrate\": \"50M\"}", 1000000));
+    assert_null(ring_from_json(NULL, (gint64)(DELAY_RING_MAX_DELAY_MS + 1) * 1000));
+
+    assert_int_equal(delay_from_json("{\"delay-ms\": 10000}"), 10000000);
+    assert_int_equal(delay_from_json("250"), 250000);
+    assert_int_equal(delay_from_json("{\"delay-ms\": 0}"), -1);
+    assert_int_equal(delay_from_json("{\"ms\": 100}"), -1);
+    assert_int_equal(delay_from_json("true"), -1);
+
+    // Sized for the longest delay plus one second at max-bitrate
+    DelayRing *ring = ring_from_json("{\"max-bitrate\": 8000000}", 9000000);
+    assert_non_null(ring);
+    DelayRingStats stats;
+    delay_ring_get_stats(ring, &stats);
+    assert_int_equal(stats.max_bytes, 10000000);
+    assert_int_equal(stats.capacity, 10000000 / DELAY_RING_BYTES_PER_ENTRY);
+    delay_ring_free(ring);
+}
+
+static void test_delay_ring_readers_share_buffers(void **state)
+{
+    (void)state;
+    DelayRing *ring = ring_from_json(NULL, 300000);
+    assert_non_null(ring);
+    gint fast = delay_ring_add_reader(ring, 100000);
+    gint slow = delay_ring_add_reader(ring, 300000);
+    assert_int_equal(delay_ring_next_due(ring), -1);
+
+    // No PCR: buffers are due by their arrival time
+    for (guint8 i = 0; i < 3; i++) push(ring, make_buffer(-1, i), 1000000 + i * 10000);
+    assert_int_equal(delay_ring_next_due(ring), 1100000);
+    assert_null(delay_ring_pop(ring, fast, 1099999));
+
+    GBytes *fast_items[3];
+    for (guint8 i = 0; i < 3; i++) {
+        fast_items[i] = delay_ring_pop(ring, fast, 1120000);
+        assert_non_null(fast_items[i]);
+        assert_int_equal(tag_of(fast_items[i]), i);
+    }
+    assert_null(delay_ring_pop(ring, fast, 1120000));
+    assert_int_equal(delay_ring_next_due(ring), 1300000);
+
+    // Stored once: the slow reader gets the very buffers the fast one got, and they are kept until then
+    DelayRingStats stats;
+    delay_ring_get_stats(ring, &stats);
+    assert_int_equal(stats.entries, 3);
+    assert_int_equal(stats.bytes, 3 * BUFFER_SIZE);
+    assert_false(stats.pcr_clock);
+    for (guint i = 0; i < 3; i++) {
+        GBytes *item = delay_ring_pop(ring, slow, 1400000);
+        assert_true(item == fast_items[i]);
+        g_bytes_unref(item);
+        g_bytes_unref(fast_items[i]);
+    }
+    delay_ring_get_stats(ring, &stats);
+    assert_int_equal(stats.entries, 0);
+    assert_int_equal(stats.bytes, 0);
+    assert_int_equal(delay_ring_next_due(ring), -1);
+
+    DelayReaderStats reader;
+    delay_ring_get_reader_stats(ring, slow, &reader);
+    assert_int_equal(reader.buffers, 3);
+    assert_int_equal(reader.bytes, 3 * BUFFER_SIZE);
+    assert_int_equal(reader.delay_ms, 300);
+    assert_int_equal(reader.lateness_max_us, 100000);
+    delay_ring_get_reader_stats(ring, slow, &reader);
+    assert_int_equal(reader.lateness_max_us, 0);
+    delay_ring_free(ring);
+}
+
+static void test_delay_ring_follows_pcr(void **state)
+{
+    (void)state;
+    DelayRing *ring = ring_from_json(NULL, 1000000);
+    gint reader = delay_ring_add_reader(ring, 1000000);
+
+    // A PCR every 40 ms; the second buffer arrives 30 ms late and the third 5 ms late. Each is due
+    // one second after its PCR time (give or take the offset's slew), not after its arrival.
+    push(ring, make_buffer(500000, 0), 2000000);
+    push(ring, make_buffer(540000, 1), 2070000);
+    push(ring, make_buffer(580000, 2), 2085000);
+    // Between PCRs, a buffer keeps the last PCR's correction (-5 ms)
+    push(ring, make_buffer(-1, 3), 2095000);
+
+    gint64 expected[] = {3000000, 3040000, 3080000, 3090000};
+    for (guint i = 0; i < G_N_ELEMENTS(expected); i++) {
+        gint64 due = delay_ring_next_due(ring);
+        assert_in_range(due, expected[i], expected[i] + 100);
+        assert_null(delay_ring_pop(ring, reader, due - 1));
+        GBytes *item = delay_ring_pop(ring, reader, due);
+        assert_non_null(item);
+        assert_int_equal(tag_of(item), i);
+        g_bytes_unref(item);
+    }
+
+    DelayRingStats stats;
+    delay_ring_get_stats(ring, &stats);
+    assert_true(stats.pcr_clock);
+    assert_int_equal(stats.resyncs, 0);
+
+    // A PCR jump restarts the clock at the arrival time
+    push(ring, make_buffer(9000000, 4), 2120000);
+    assert_int_equal(delay_ring_next_due(ring), 3120000);
+    delay_ring_get_stats(ring, &stats);
+    assert_int_equal(stats.resyncs, 1);
+    delay_ring_free(ring);
+}
+
+static void test_delay_ring_bounds_memory(void **state)
+{
+    (void)state;
+    // 100 kbit/s for 1 ms + 1 s: 12512 bytes, so 9 buffers of 1316 bytes
+    DelayRing *ring = ring_from_json("{\"max-bitrate\": 100000}", 1000);
+    gint reader = delay_ring_add_reader(ring, 1000);
+    for (guint8 i = 0; i < 20; i++) push(ring, make_buffer(-1, i), 1000000 + i);
+
+    DelayRingStats stats;
+    delay_ring_get_stats(ring, &stats);
+    assert_int_equal(stats.entries, 9);
+    assert_true(stats.bytes <= stats.max_bytes);
+    assert_int_equal(stats.overruns, 11);
+
+    // The reader lost the oldest buffers and carries on with the first one still stored
+    GBytes *item = delay_ring_pop(ring, reader, 2000000);
+    assert_int_equal(tag_of(item), 11);
+    g_bytes_unref(item);
+    DelayReaderStats reader_stats;
+    delay_ring_get_reader_stats(ring, reader, &reader_stats);
+    assert_int_equal(reader_stats.overruns, 11);
+    delay_ring_free(ring);
+}
+
+int run_delay_ring_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_delay_ring_rejects_invalid_config),
+        cmocka_unit_test(test_delay_ring_readers_share_buffers),
+        cmocka_unit_test(test_delay_ring_follows_pcr),
+        cmocka_unit_test(test_delay_ring_bounds_memory),
+    };
+    return cmocka_run_group_tests_name("delay_ring", tests, NULL, NULL);
+}
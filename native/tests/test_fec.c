@@ -0,0 +1,182 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/fec.h"
+#include "test_suites.h"
+
+#define LOOP_PACKETS 600
+
+// In-process lossy link: the encoder's packets go straight to a decoder, minus the ones we drop
+typedef struct {
+    FecDecoder *dec;
+    guint media_index;
+    guint column_index;
+    guint row_index;
+    const guint *drop_media; // Sorted indices of media packets to lose, ended by G_MAXUINT
+    guint drop_column;       // Index of a column FEC packet to lose, or G_MAXUINT
+    guint8 *last_fec;        // Copy of the last FEC packet, for header checks
+    gsize last_fec_len;
+} Link;
+
+static void link_packet(FecStream stream, const guint8 *packet, gsize len, gpointer user_data)
+{
+    Link *link = user_data;
+    gboolean drop = FALSE;
+
+    switch (stream) {
+        case FEC_STREAM_MEDIA:
+            if (link->drop_media && *link->drop_media == link->media_index) {
+                drop = TRUE;
+                link->drop_media++;
+            }
+            link->media_index++;
+            break;
+        case FEC_STREAM_COLUMN:
+            drop = link->column_index++ == link->drop_column;
+            break;
+        case FEC_STREAM_ROW:
+            link->row_index++;
+            break;
+    }
+    if (stream != FEC_STREAM_MEDIA) {
+        g_free(link->last_fec);
+        link->last_fec = g_malloc(len);
+        memcpy(link->last_fec, packet, len);
+        link->last_fec_len = len;
+    }
+    if (!drop && link->dec) fec_decoder_push(link->dec, stream, packet, len);
+}
+
+static void make_payload(guint8 *payload, guint index, gsize *len)
+{
+    // Mostly full 7-packet payloads, with some shorter ones as at the end of a buffer
+    guint ts_packets = index % 13 == 5 ? 1 + index % 6 : FEC_TS_PER_PACKET;
+    *len = ts_packets * TS_PACKET_SIZE;
+    for (gsize i = 0; i < *len; i++) payload[i] = (guint8)(index * 31 + i * 7);
+    for (guint p = 0; p < ts_packets; p++) payload[p * TS_PACKET_SIZE] = TS_SYNC_BYTE;
+}
+
+static void test_fec_xor_kernels_agree(void **state)
+{
+    (void)state;
+    guint8 src[1400], expected[1400], dst[1400];
+    for (guint i = 0; i < sizeof(src); i++) {
+        src[i] = (guint8)(i * 13 + 5);
+        expected[i] = (guint8)(i * 7 + 1);
+    }
+
+    for (gsize len = 0; len < 200; len += 7) {
+        for (TsSimdLevel level = TS_SIMD_SCALAR; level <= TS_SIMD_AVX2; level++) {
+            if (!fec_set_simd_level(level)) continue;
+            for (gsize i = 0; i < sizeof(dst); i++) dst[i] = (guint8)(i * 7 + 1);
+            fec_xor(dst, src, 1316 + len % 64);
+            fec_xor(dst, src, 1316 + len % 64); // XOR twice is the identity
+            assert_memory_equal(dst, expected, sizeof(dst));
+
+            fec_xor(dst, src, len);
+            for (gsize i = 0; i < len; i++) assert_int_equal(dst[i], expected[i] ^ src[i]);
+            assert_memory_equal(dst + len, expected + len, sizeof(dst) - len);
+        }
+    }
+    if (!fec_set_simd_level(TS_SIMD_AVX2)) fec_set_simd_level(TS_SIMD_SSE2);
+}
+
+static void test_fec_matrix_layout(void **state)
+{
+    (void)state;
+    FecEncoder *enc = fec_encoder_new(5, 4, TRUE, 0x1234);
+    assert_non_null(enc);
+
+    Link link = {.drop_column = G_MAXUINT};
+    guint8 payload[FEC_MAX_PAYLOAD];
+    gsize len;
+    for (guint i = 0; i < 20; i++) {
+        make_payload(payload, i, &len);
+        fec_encoder_push(enc, payload, len, i * 3000, link_packet, &link);
+        if (i == 18) {
+            // Column 3 (seq 3, 8, 13, 18) just completed
+            const guint8 *h = link.last_fec + FEC_RTP_HEADER_SIZE;
+            assert_int_equal(link.last_fec[1], FEC_PT);
+            assert_int_equal((h[0] << 8) | h[1], 3);
+            assert_int_equal(h[12] & 0x40, 0);
+            assert_int_equal(h[13], 5); // Offset L
+            assert_int_equal(h[14], 4); // NA D
+        }
+    }
+
+    // The last row (seq 15-19)
+    const guint8 *h = link.last_fec + FEC_RTP_HEADER_SIZE;
+    assert_int_equal((h[0] << 8) | h[1], 15);
+    assert_int_equal(h[12] & 0x40, 0x40);
+    assert_int_equal(h[13], 1);
+    assert_int_equal(h[14], 5);
+
+    FecEncoderStats stats;
+    fec_encoder_get_stats(enc, &stats);
+    assert_int_equal(stats.media_packets, 20);
+    assert_int_equal(stats.column_packets, 5);
+    assert_int_equal(stats.row_packets, 4);
+
+    g_free(link.last_fec);
+    fec_encoder_free(enc);
+
+    assert_null(fec_encoder_new(5, 3, FALSE, 0));   // D < 4
+    assert_null(fec_encoder_new(21, 4, FALSE, 0));  // L > 20
+    assert_null(fec_encoder_new(20, 10, FALSE, 0)); // L x D > 100
+}
+
+static void test_fec_loopback_recovers_losses(void **state)
+{
+    (void)state;
+    // 10 x 10 matrices of 100 packets. Matrix 0: a burst of 10 (one per column). Matrix 1: singles
+    // here and there. Matrix 2: a loss whose column FEC is lost too, so only the row FEC helps.
+    // Matrix 3: a 2 x 2 square, which row/column FEC cannot rebuild.
+    static const guint drops[] = {20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  103, 147, 181,
+                                  199, 255, 333, 334, 343, 344, G_MAXUINT};
+    FecEncoder *enc = fec_encoder_new(10, 10, TRUE, 0xCAFE);
+    Link link = {.dec = fec_decoder_new(), .drop_media = drops, .drop_column = 25};
+
+    guint8 payloads[LOOP_PACKETS][FEC_MAX_PAYLOAD];
+    gsize lens[LOOP_PACKETS];
+    for (guint i = 0; i < LOOP_PACKETS; i++) {
+        make_payload(payloads[i], i, &lens[i]);
+        fec_encoder_push(enc, payloads[i], lens[i], 90000 + i * 900, link_packet, &link);
+    }
+
+    guint missing = 0;
+    for (guint i = 0; i < LOOP_PACKETS; i++) {
+        gsize len;
+        const guint8 *pkt = fec_decoder_get(link.dec, (guint16)i, &len);
+        if (!pkt) {
+            missing++;
+            continue;
+        }
+        assert_int_equal(len, FEC_RTP_HEADER_SIZE + lens[i]);
+        assert_int_equal(pkt[1], FEC_MEDIA_PT);
+        assert_int_equal((pkt[4] << 24) | (pkt[5] << 16) | (pkt[6] << 8) | pkt[7], 90000 + i * 900);
+        assert_memory_equal(pkt + FEC_RTP_HEADER_SIZE, payloads[i], lens[i]);
+    }
+    assert_int_equal(missing, 4); // The square
+
+    FecDecoderStats stats;
+    fec_decoder_get_stats(link.dec, &stats);
+    assert_int_equal(stats.recovered, 15);
+    assert_int_equal(stats.media_packets, LOOP_PACKETS - 19);
+
+    g_free(link.last_fec);
+    fec_decoder_free(link.dec);
+    fec_encoder_free(enc);
+}
+
+int run_fec_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_fec_xor_kernels_agree),
+        cmocka_unit_test(test_fec_matrix_layout),
+        cmocka_unit_test(test_fec_loopback_recovers_losses),
+    };
+    return cmocka_run_group_tests_name("fec", tests, NULL, NULL);
+}
@@ -0,0 +1,126 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/input_watchdog.h"
+#include "test_suites.h"
+
+#define MS 1000
+
+static InputWatchdog *watchdog_from(const char *json)
+{
+    cJSON *config = cJSON_Parse(json);
+    assert_non_null(config);
+    InputWatchdog *wd = input_watchdog_new(config);
+    cJSON_Delete(config);
+    return wd;
+}
+
+static void test_input_watchdog_config(void **state)
+{
+    (void)state;
+    assert_null(watchdog_from("{\"stall-ms\": 10}"));
+    assert_null(watchdog_from("{\"stall-ms\": \"500\"}"));
+    assert_null(watchdog_from("{\"restart\": 1}"));
+    assert_null(watchdog_from("false"));
+
+    InputWatchdog *wd = watchdog_from("true");
+    assert_non_null(wd);
+    InputWatchdogStats stats;
+    input_watchdog_get_stats(wd, &stats);
+    assert_int_equal(stats.stall_ms, INPUT_WATCHDOG_DEFAULT_STALL_MS);
+    assert_true(input_watchdog_restart_enabled(wd));
+    input_watchdog_free(wd);
+
+    wd = watchdog_from("{\"stall-ms\": 200, \"restart\": false}");
+    assert_non_null(wd);
+    assert_false(input_watchdog_restart_enabled(wd));
+    assert_int_equal(input_watchdog_poll_interval_ms(wd), 50);
+    input_watchdog_free(wd);
+}
+
+static void test_input_watchdog_arms_on_first_data(void **state)
+{
+    (void)state;
+    InputWatchdog *wd = watchdog_from("{\"stall-ms\": 500}");
+    gint64 elapsed = -1;
+
+    // A source that never delivered anything is not a stall
+    assert_int_equal(input_watchdog_poll(wd, 10000 * MS, &elapsed), INPUT_WATCHDOG_NONE);
+
+    input_watchdog_feed(wd, 10100 * MS);
+    assert_int_equal(input_watchdog_poll(wd, 10200 * MS, &elapsed), INPUT_WATCHDOG_NONE);
+    input_watchdog_feed(wd, 10400 * MS);
+    assert_int_equal(input_watchdog_poll(wd, 10899 * MS, &elapsed), INPUT_WATCHDOG_NONE);
+    assert_int_equal(input_watchdog_poll(wd, 10900 * MS, &elapsed), INPUT_WATCHDOG_STALLED);
+    assert_int_equal(elapsed, 500);
+
+    // Reported once, then quiet until data flows again
+    assert_int_equal(input_watchdog_poll(wd, 20000 * MS, &elapsed), INPUT_WATCHDOG_NONE);
+
+    InputWatchdogStats stats;
+    input_watchdog_get_stats(wd, &stats);
+    assert_true(stats.stalled);
+    assert_int_equal(stats.stalls, 1);
+    assert_int_equal(stats.last_outage_ms, -1);
+    input_watchdog_free(wd);
+}
+
+static void test_input_watchdog_restart_and_resume(void **state)
+{
+    (void)state;
+    InputWatchdog *wd = watchdog_from("{\"stall-ms\": 100}");
+    gint64 elapsed = -1;
+
+    input_watchdog_feed(wd, 1000 * MS);
+    assert_int_equal(input_watchdog_poll(wd, 1010 * MS, &elapsed), INPUT_WATCHDOG_NONE);
+    assert_int_equal(input_watchdog_poll(wd, 1150 * MS, &elapsed), INPUT_WATCHDOG_STALLED);
+
+    // A buffer still in flight while the source restarts does not count as recovery
+    input_watchdog_feed(wd, 1151 * MS);
+    input_watchdog_restarted(wd, 30 * MS, TRUE);
+    assert_int_equal(input_watchdog_poll(wd, 1200 * MS, &elapsed), INPUT_WATCHDOG_NONE);
+
+    input_watchdog_feed(wd, 1300 * MS);
+    input_watchdog_feed(wd, 1310 * MS);
+    assert_int_equal(input_watchdog_poll(wd, 1320 * MS, &elapsed), INPUT_WATCHDOG_RESUMED);
+    assert_int_equal(elapsed, 300);
+    assert_int_equal(input_watchdog_poll(wd, 1330 * MS, &elapsed), INPUT_WATCHDOG_NONE);
+
+    InputWatchdogStats stats;
+    input_watchdog_get_stats(wd, &stats);
+    assert_false(stats.stalled);
+    assert_int_equal(stats.stalls, 1);
+    assert_int_equal(stats.restarts, 1);
+    assert_int_equal(stats.restart_failures, 0);
+    assert_int_equal(stats.last_restart_ms, 30);
+    assert_int_equal(stats.last_outage_ms, 300);
+
+    // Re-armed: the next silence is a new stall
+    assert_int_equal(input_watchdog_poll(wd, 1410 * MS, &elapsed), INPUT_WATCHDOG_STALLED);
+    input_watchdog_restarted(wd, 5 * MS, FALSE);
+    input_watchdog_get_stats(wd, &stats);
+    assert_int_equal(stats.stalls, 2);
+    assert_int_equal(stats.restart_failures, 1);
+
+    cJSON *root = cJSON_CreateObject();
+    input_watchdog_stats_to_json(&stats, root);
+    cJSON *obj = cJSON_GetObjectItem(root, "watchdog");
+    assert_non_null(obj);
+    assert_int_equal(cJSON_GetObjectItem(obj, "stalls")->valueint, 2);
+    assert_true(cJSON_IsTrue(cJSON_GetObjectItem(obj, "stalled")));
+    cJSON_Delete(root);
+    input_watchdog_free(wd);
+}
+
+int run_input_watchdog_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_input_watchdog_config),
+        cmocka_unit_test(test_input_watchdog_arms_on_first_data),
+        cmocka_unit_test(test_input_watchdog_restart_and_resume),
+    };
+    return cmocka_run_group_tests_name("input_watchdog", tests, NULL, NULL);
+}
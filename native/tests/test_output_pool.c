@@ -0,0 +1,303 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/output_pool.h"
+#include "test_suites.h"
+
+#define SEQUENCE_NONE G_MAXUINT64
+
+// One destination's sink: records what arrives and, while `blocked`, holds the worker in the push
+typedef struct {
+    GMutex lock;
+    GCond cond;
+    GstPad *pad;
+    guint received;
+    guint64 last_offset;
+    gboolean out_of_order;
+    gboolean blocked;
+    gboolean in_push;
+} Sink;
+
+static GstFlowReturn sink_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    (void)parent;
+    Sink *sink = gst_pad_get_element_private(pad);
+    g_mutex_lock(&sink->lock);
+    sink->in_push = TRUE;
+    g_cond_broadcast(&sink->cond);
+    while (sink->blocked) g_cond_wait(&sink->cond, &sink->lock);
+    sink->in_push = FALSE;
+    if (sink->last_offset != SEQUENCE_NONE && GST_BUFFER_OFFSET(buffer) <= sink->last_offset) {
+        sink->out_of_order = TRUE;
+    }
+    sink->last_offset = GST_BUFFER_OFFSET(buffer);
+    sink->received++;
+    g_mutex_unlock(&sink->lock);
+    gst_buffer_unref(buffer);
+    return GST_FLOW_OK;
+}
+
+static gboolean sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
+{
+    (void)pad;
+    (void)parent;
+    gst_event_unref(event);
+    return TRUE;
+}
+
+static void sink_init(Sink *sink, guint index)
+{
+    memset(sink, 0, sizeof(*sink));
+    g_mutex_init(&sink->lock);
+    g_cond_init(&sink->cond);
+    sink->last_offset = SEQUENCE_NONE;
+    char name[16];
+    snprintf(name, sizeof(name), "sink-%u", index);
+    sink->pad = gst_pad_new(name, GST_PAD_SINK);
+    gst_pad_set_element_private(sink->pad, sink);
+    gst_pad_set_chain_function(sink->pad, sink_chain);
+    gst_pad_set_event_function(sink->pad, sink_event);
+    gst_pad_set_active(sink->pad, TRUE);
+}
+
+static void sink_clear(Sink *sink)
+{
+    gst_pad_set_active(sink->pad, FALSE);
+    gst_object_unref(sink->pad);
+    g_cond_clear(&sink->cond);
+    g_mutex_clear(&sink->lock);
+}
+
+static void sink_set_blocked(Sink *sink, gboolean blocked)
+{
+    g_mutex_lock(&sink->lock);
+    sink->blocked = blocked;
+    g_cond_broadcast(&sink->cond);
+    g_mutex_unlock(&sink->lock);
+}
+
+// Until the worker is inside the sink's push, so whatever is queued after this stays queued
+static void sink_wait_in_push(Sink *sink)
+{
+    g_mutex_lock(&sink->lock);
+    while (!sink->in_push) g_cond_wait(&sink->cond, &sink->lock);
+    g_mutex_unlock(&sink->lock);
+}
+
+static guint sink_wait_received(Sink *sink, guint count)
+{
+    guint received = 0;
+    for (int i = 0; i < 500; i++) {
+        g_mutex_lock(&sink->lock);
+        received = sink->received;
+        g_mutex_unlock(&sink->lock);
+        if (received >= count) break;
+        usleep(2000);
+    }
+    return received;
+}
+
+static void push_sequence(OutputPool *pool, guint64 first, guint count)
+{
+    for (guint i = 0; i < count; i++) {
+        GstBuffer *buffer = gst_buffer_new_allocate(NULL, 1316, NULL);
+        GST_BUFFER_OFFSET(buffer) = first + i;
+        output_pool_push(pool, buffer);
+        gst_buffer_unref(buffer);
+    }
+}
+
+static cJSON *pool_stats(OutputPool *pool)
+{
+    cJSON *root = cJSON_CreateObject();
+    output_pool_add_stats(pool, root);
+    return root;
+}
+
+static double queue_stat(cJSON *root, guint dest, const char *field)
+{
+    cJSON *queue = cJSON_GetArrayItem(cJSON_GetObjectItem(root, "output-queues"), (int)dest);
+    return cJSON_GetObjectItem(queue, field)->valuedouble;
+}
+
+static void test_output_pool_workers_follow_destinations(void **state)
+{
+    (void)state;
+    Sink sinks[6];
+    OutputPool *pool = output_pool_new(0);
+    assert_non_null(pool);
+
+    // No thread before the first destination, then one per destination up to the default cap of 4
+    cJSON *root = pool_stats(pool);
+    assert_int_equal(cJSON_GetObjectItem(root, "output-workers")->valueint, 0);
+    cJSON_Delete(root);
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    for (guint i = 0; i < G_N_ELEMENTS(sinks); i++) {
+        sink_init(&sinks[i], i);
+        char name[16];
+        snprintf(name, sizeof(name), "dest-%u", i);
+        assert_non_null(output_pool_add_dest(pool, sinks[i].pad, name, 64, 0));
+
+        root = pool_stats(pool);
+        long expected = MIN(MIN((long)i + 1, cpus > 0 ? cpus : 1), 4);
+        assert_int_equal(cJSON_GetObjectItem(root, "output-workers")->valueint, expected);
+        cJSON_Delete(root);
+    }
+
+    output_pool_free(pool);
+    for (guint i = 0; i < G_N_ELEMENTS(sinks); i++) sink_clear(&sinks[i]);
+}
+
+static void test_output_pool_keeps_order_per_destination(void **state)
+{
+    (void)state;
+    Sink sinks[3];
+    OutputPool *pool = output_pool_new(3);
+    for (guint i = 0; i < G_N_ELEMENTS(sinks); i++) {
+        sink_init(&sinks[i], i);
+        assert_non_null(output_pool_add_dest(pool, sinks[i].pad, "dest", 4096, 0));
+    }
+
+    // Destinations move between workers by stealing, but one is never serviced by two at once
+    push_sequence(pool, 0, 2000);
+    for (guint i = 0; i < G_N_ELEMENTS(sinks); i++) {
+        assert_int_equal(sink_wait_received(&sinks[i], 2000), 2000);
+        assert_false(sinks[i].out_of_order);
+        assert_int_equal(sinks[i].last_offset, 1999);
+    }
+
+    output_pool_free(pool);
+    for (guint i = 0; i < G_N_ELEMENTS(sinks); i++) sink_clear(&sinks[i]);
+}
+
+static void test_output_pool_drops_oldest_when_full(void **state)
+{
+    (void)state;
+    Sink sink;
+    sink_init(&sink, 0);
+    OutputPool *pool = output_pool_new(1);
+    assert_non_null(output_pool_add_dest(pool, sink.pad, "dest", 4, 0));
+
+    // Buffer 0 is held in the push; 1..19 overflow a 4-buffer queue, which keeps the newest
+    sink_set_blocked(&sink, TRUE);
+    push_sequence(pool, 0, 1);
+    sink_wait_in_push(&sink);
+    push_sequence(pool, 1, 19);
+
+    cJSON *root = pool_stats(pool);
+    assert_int_equal((int)queue_stat(root, 0, "queued-buffers"), 4);
+    assert_int_equal((int)queue_stat(root, 0, "dropped-buffers"), 15);
+    cJSON_Delete(root);
+
+    sink_set_blocked(&sink, FALSE);
+    assert_int_equal(sink_wait_received(&sink, 5), 5);
+    assert_false(sink.out_of_order);
+    assert_int_equal(sink.last_offset, 19);
+
+    output_pool_free(pool);
+    sink_clear(&sink);
+}
+
+static void test_output_pool_slow_destination_does_not_stall_fast(void **state)
+{
+    (void)state;
+    Sink slow, fast;
+    sink_init(&slow, 0);
+    sink_init(&fast, 1);
+    OutputPool *pool = output_pool_new(0);
+    assert_non_null(output_pool_add_dest(pool, slow.pad, "slow", 8, 0));
+    assert_non_null(output_pool_add_dest(pool, fast.pad, "fast", 1024, 0));
+
+    // The slow sink holds one worker; once that push is slow, the next buffers wake another (if there
+    // is one) to take the fast destination, which otherwise waits only for that push, never for the
+    // slow destination's backlog
+    sink_set_blocked(&slow, TRUE);
+    push_sequence(pool, 0, 1);
+    sink_wait_in_push(&slow);
+    usleep(5000);
+    push_sequence(pool, 1, 499);
+
+    cJSON *root = pool_stats(pool);
+    gboolean one_worker = cJSON_GetObjectItem(root, "output-workers")->valueint == 1;
+    cJSON_Delete(root);
+    if (!one_worker) {
+        assert_int_equal(sink_wait_received(&fast, 500), 500);
+        assert_false(fast.out_of_order);
+    }
+
+    sink_set_blocked(&slow, FALSE);
+    assert_int_equal(sink_wait_received(&fast, 500), 500);
+    sink_wait_received(&slow, 9);
+
+    // The slow destination lost its own oldest data; the fast one lost nothing
+    root = pool_stats(pool);
+    assert_int_equal((int)queue_stat(root, 0, "dropped-buffers"), 499 - 8);
+    assert_int_equal((int)queue_stat(root, 1, "dropped-buffers"), 0);
+    cJSON_Delete(root);
+    assert_int_equal(slow.received, 9);
+    assert_int_equal(slow.last_offset, 499);
+
+    output_pool_free(pool);
+    sink_clear(&slow);
+    sink_clear(&fast);
+}
+
+static void test_output_pool_blocked_destination_gets_own_thread(void **state)
+{
+    (void)state;
+    Sink blocked, fast;
+    sink_init(&blocked, 0);
+    sink_init(&fast, 1);
+    OutputPool *pool = output_pool_new(1);
+    assert_non_null(output_pool_add_dest(pool, blocked.pad, "blocked", 8, 0));
+    assert_non_null(output_pool_add_dest(pool, fast.pad, "fast", 1024, 0));
+
+    // The only worker is stuck in the blocked sink; the next buffer after 100 ms leaves it there
+    // and starts a new worker, which keeps the fast destination going
+    sink_set_blocked(&blocked, TRUE);
+    push_sequence(pool, 0, 1);
+    sink_wait_in_push(&blocked);
+    usleep(150000);
+    push_sequence(pool, 1, 99);
+    assert_int_equal(sink_wait_received(&fast, 100), 100);
+    assert_false(fast.out_of_order);
+
+    cJSON *root = pool_stats(pool);
+    assert_int_equal(cJSON_GetObjectItem(root, "output-workers")->valueint, 1);
+    assert_int_equal(cJSON_GetObjectItem(root, "output-dedicated-threads")->valueint, 1);
+    cJSON *queues = cJSON_GetObjectItem(root, "output-queues");
+    assert_true(cJSON_IsTrue(cJSON_GetObjectItem(cJSON_GetArrayItem(queues, 0), "dedicated-thread")));
+    assert_true(cJSON_IsFalse(cJSON_GetObjectItem(cJSON_GetArrayItem(queues, 1), "dedicated-thread")));
+    cJSON_Delete(root);
+
+    // Unblocked, its own thread delivers what its queue kept, in order
+    sink_set_blocked(&blocked, FALSE);
+    assert_int_equal(sink_wait_received(&blocked, 9), 9);
+    assert_false(blocked.out_of_order);
+    assert_int_equal(blocked.last_offset, 99);
+    push_sequence(pool, 100, 8);
+    assert_int_equal(sink_wait_received(&blocked, 17), 17);
+    assert_false(blocked.out_of_order);
+    assert_int_equal(sink_wait_received(&fast, 108), 108);
+
+    output_pool_free(pool);
+    sink_clear(&blocked);
+    sink_clear(&fast);
+}
+
+int run_output_pool_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_output_pool_workers_follow_destinations),
+        cmocka_unit_test(test_output_pool_keeps_order_per_destination),
+        cmocka_unit_test(test_output_pool_drops_oldest_when_full),
+        cmocka_unit_test(test_output_pool_slow_destination_does_not_stall_fast),
+        cmocka_unit_test(test_output_pool_blocked_destination_gets_own_thread),
+    };
+    return cmocka_run_group_tests_name("output_pool", tests, NULL, NULL);
+}
@@ -0,0 +1,157 @@
+#include <cmocka.h>
+#include <poll.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "../include/preview_server.h"
+#include "test_suites.h"
+
+static PreviewServer *server_from_json(const char *json, const char *path)
+{
+    cJSON *config = json ? cJSON_Parse(json) : NULL;
+    PreviewServer *server = preview_server_new(config, path);
+    cJSON_Delete(config);
+    return server;
+}
+
+static void test_path(char *path, gsize size)
+{
+    snprintf(path, size, "/tmp/blackgate_preview_test_%d.sock", (int)getpid());
+}
+
+static void test_preview_server_rejects_invalid_config(void **state)
+{
+    (void)state;
+    char path[108];
+    test_path(path, sizeof(path));
+    const char *invalid[] = {
+        "{\"fps\": 0}", "{\"fps\": 60}", "{\"quality\": 101}", "{\"max-viewers\": 0}", "{\"fps\": \"5\"}", "5",
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(invalid); i++) assert_null(server_from_json(invalid[i], path));
+
+    PreviewServer *server = server_from_json("{\"fps\": 10, \"quality\": 50}", path);
+    assert_non_null(server);
+    assert_int_equal(preview_server_fps(server), 10);
+    assert_int_equal(preview_server_quality(server), 50);
+    preview_server_free(server);
+    assert_int_not_equal(access(path, F_OK), 0);
+}
+
+static int connect_viewer(const char *path)
+{
+    struct sockaddr_un addr = {.sun_family = AF_UNIX};
+    g_strlcpy(addr.sun_path, path, sizeof(addr.sun_path));
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert_int_equal(connect(fd, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    return fd;
+}
+
+// Read one multipart part and return its JPEG bytes
+static GByteArray *read_part(int fd)
+{
+    GByteArray *data = g_byte_array_new();
+    guint8 buf[4096];
+    while (TRUE) {
+        struct pollfd pfd = {.fd = fd, .events = POLLIN};
+        assert_int_equal(poll(&pfd, 1, 2000), 1);
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        assert_true(n > 0);
+        g_byte_array_append(data, buf, (guint)n);
+
+        const char *header_end = g_strstr_len((const char *)data->data, data->len, "\r\n\r\n");
+        if (!header_end) continue;
+        const char *length = g_strstr_len((const char *)data->data, data->len, "Content-Length: ");
+        assert_non_null(length);
+        gsize body = (gsize)(header_end + 4 - (const char *)data->data);
+        gsize jpeg_len = (gsize)g_ascii_strtoull(length + 16, NULL, 10);
+        if (data->len < body + jpeg_len + 2) continue;
+
+        assert_true(g_str_has_prefix((const char *)data->data, "--" PREVIEW_SERVER_BOUNDARY "\r\n"));
+        assert_memory_equal(data->data + body + jpeg_len, "\r\n", 2);
+        GByteArray *jpeg = g_byte_array_new();
+        g_byte_array_append(jpeg, data->data + body, (guint)jpeg_len);
+        g_byte_array_free(data, TRUE);
+        return jpeg;
+    }
+}
+
+static void wait_viewers(PreviewServer *server, guint viewers)
+{
+    PreviewServerStats stats = {0};
+    for (int i = 0; i < 200; i++) {
+        preview_server_get_stats(server, &stats);
+        if (stats.viewers == viewers) break;
+        g_usleep(5000);
+    }
+    assert_int_equal(stats.viewers, viewers);
+}
+
+static void test_preview_server_fans_out_frames(void **state)
+{
+    (void)state;
+    char path[108];
+    test_path(path, sizeof(path));
+    PreviewServer *server = server_from_json("{\"max-viewers\": 2}", path);
+    assert_non_null(server);
+    assert_null(preview_server_latest(server));
+
+    int a = connect_viewer(path);
+    int b = connect_viewer(path);
+    wait_viewers(server, 2);
+
+    const guint8 frame1[] = {0xff, 0xd8, 1, 2, 3, 0xff, 0xd9};
+    preview_server_publish(server, frame1, sizeof(frame1));
+    for (int i = 0; i < 2; i++) {
+        GByteArray *jpeg = read_part(i == 0 ? a : b);
+        assert_int_equal(jpeg->len, sizeof(frame1));
+        assert_memory_equal(jpeg->data, frame1, sizeof(frame1));
+        g_byte_array_free(jpeg, TRUE);
+    }
+
+    // A third viewer is over the limit; once one detaches, a new viewer gets the newest frame at once
+    int c = connect_viewer(path);
+    char byte;
+    struct pollfd pfd = {.fd = c, .events = POLLIN};
+    assert_int_equal(poll(&pfd, 1, 2000), 1);
+    assert_int_equal(recv(c, &byte, 1, 0), 0);
+    close(c);
+
+    close(b);
+    wait_viewers(server, 1);
+    int d = connect_viewer(path);
+    GByteArray *jpeg = read_part(d);
+    assert_memory_equal(jpeg->data, frame1, sizeof(frame1));
+    g_byte_array_free(jpeg, TRUE);
+    wait_viewers(server, 2); // Counted along with the frame sent to it
+
+    GBytes *latest = preview_server_latest(server);
+    assert_non_null(latest);
+    assert_int_equal(g_bytes_get_size(latest), sizeof(frame1));
+    g_bytes_unref(latest);
+
+    PreviewServerStats stats;
+    preview_server_get_stats(server, &stats);
+    assert_int_equal(stats.frames, 1);
+    assert_int_equal(stats.frames_sent, 3);
+    assert_int_equal(stats.viewers_total, 3);
+    assert_int_equal(stats.viewers_refused, 1);
+
+    close(a);
+    close(d);
+    preview_server_free(server);
+}
+
+int run_preview_server_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_preview_server_rejects_invalid_config),
+        cmocka_unit_test(test_preview_server_fans_out_frames),
+    };
+    return cmocka_run_group_tests_name("preview_server", tests, NULL, NULL);
+}
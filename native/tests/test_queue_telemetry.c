@@ -0,0 +1,93 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/queue_telemetry.h"
+#include "test_suites.h"
+
+#define MB (1024 * 1024)
+#define SECOND_NS G_GUINT64_CONSTANT(1000000000)
+
+static double json_number(cJSON *obj, const char *key)
+{
+    cJSON *item = cJSON_GetObjectItem(obj, key);
+    assert_non_null(item);
+    return item->valuedouble;
+}
+
+static void test_queue_telemetry_high_water_per_window(void **state)
+{
+    (void)state;
+    QueueLevel limit = {50 * MB, 0, 3 * SECOND_NS};
+    QueueTelemetry t;
+    queue_telemetry_init(&t, &limit, 0);
+
+    QueueLevel samples[] = {{1 * MB, 10, 100000000}, {6 * MB, 60, 600000000}, {2 * MB, 20, 200000000}};
+    for (guint i = 0; i < G_N_ELEMENTS(samples); i++) queue_telemetry_sample(&t, &samples[i]);
+    queue_telemetry_end_window(&t, G_USEC_PER_SEC);
+
+    cJSON *obj = cJSON_CreateObject();
+    queue_telemetry_to_json(&t, obj);
+    assert_int_equal((gint64)json_number(obj, "level-bytes"), 2 * MB);
+    assert_int_equal((gint64)json_number(obj, "high-water-bytes"), 6 * MB);
+    assert_int_equal((gint64)json_number(obj, "high-water-ms"), 600);
+    assert_int_equal((gint64)json_number(obj, "fill-rate-bytes-per-sec"), 2 * MB);
+    assert_int_equal((gint64)json_number(obj, "high-water-percent"), 20); // 600 of 3000 ms
+    assert_int_equal((gint64)json_number(obj, "full-events"), 0);
+    cJSON_Delete(obj);
+
+    // The next window starts from the current level; the peak is kept across windows
+    QueueLevel drained = {0, 0, 0};
+    queue_telemetry_sample(&t, &drained);
+    queue_telemetry_end_window(&t, 3 * G_USEC_PER_SEC);
+
+    obj = cJSON_CreateObject();
+    queue_telemetry_to_json(&t, obj);
+    assert_int_equal((gint64)json_number(obj, "high-water-bytes"), 2 * MB);
+    assert_int_equal((gint64)json_number(obj, "peak-bytes"), 6 * MB);
+    assert_int_equal((gint64)json_number(obj, "fill-rate-bytes-per-sec"), -1 * MB);
+    cJSON_Delete(obj);
+}
+
+static void test_queue_telemetry_full_events_and_drops(void **state)
+{
+    (void)state;
+    QueueLevel limit = {0, 10, 0};
+    QueueTelemetry t;
+    queue_telemetry_init(&t, &limit, 0);
+
+    QueueLevel half = {0, 5, 0}, full = {0, 10, 0};
+    queue_telemetry_sample(&t, &half);
+    queue_telemetry_sample(&t, &full);
+    queue_telemetry_sample(&t, &full); // Still the same episode
+    queue_telemetry_sample(&t, &half);
+    queue_telemetry_sample(&t, &full);
+    for (int i = 0; i < 25; i++) queue_telemetry_drop(&t);
+    queue_telemetry_end_window(&t, G_USEC_PER_SEC / 2);
+
+    cJSON *obj = cJSON_CreateObject();
+    queue_telemetry_to_json(&t, obj);
+    assert_int_equal((gint64)json_number(obj, "full-events"), 2);
+    assert_int_equal((gint64)json_number(obj, "fill-percent"), 100);
+    assert_int_equal((gint64)json_number(obj, "drops"), 25);
+    assert_int_equal((gint64)json_number(obj, "drops-per-sec"), 50);
+    cJSON_Delete(obj);
+
+    // Unlimited queues never count as full
+    QueueLevel unlimited = {0, 0, 0};
+    queue_telemetry_init(&t, &unlimited, 0);
+    QueueLevel big = {100 * MB, 100000, 10 * SECOND_NS};
+    queue_telemetry_sample(&t, &big);
+    assert_int_equal(t.full_events, 0);
+}
+
+int run_queue_telemetry_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_queue_telemetry_high_water_per_window),
+        cmocka_unit_test(test_queue_telemetry_full_events_and_drops),
+    };
+    return cmocka_run_group_tests_name("queue_telemetry", tests, NULL, NULL);
+}
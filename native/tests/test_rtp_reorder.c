@@ -0,0 +1,123 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/rtp_reorder.h"
+#include "test_suites.h"
+
+// Each payload is its sequence number, so the output order can be checked
+typedef struct {
+    guint16 seqs[256];
+    guint n;
+} Emitted;
+
+static void collect(const guint8 *payload, gsize len, gpointer user_data)
+{
+    Emitted *out = user_data;
+    assert_int_equal(len, sizeof(guint16));
+    memcpy(&out->seqs[out->n++], payload, sizeof(guint16));
+}
+
+static void push(RtpReorder *r, guint16 seq, gint64 now_us, Emitted *out)
+{
+    rtp_reorder_push(r, seq, (const guint8 *)&seq, sizeof(seq), now_us, collect, out);
+}
+
+static void test_rtp_reorder_in_order_reorder_duplicates(void **state)
+{
+    (void)state;
+    RtpReorder *r = rtp_reorder_new(16, 64, 20000);
+    assert_non_null(r);
+    Emitted out = {0};
+    RtpReorderStats stats;
+
+    // Across the 16-bit wrap: 65534 65535 2 0 1 1 3
+    guint16 arrivals[] = {65534, 65535, 2, 0, 1, 1, 3, 65535};
+    for (guint i = 0; i < G_N_ELEMENTS(arrivals); i++) push(r, arrivals[i], 0, &out);
+
+    guint16 expected[] = {65534, 65535, 0, 1, 2, 3};
+    assert_int_equal(out.n, G_N_ELEMENTS(expected));
+    for (guint i = 0; i < out.n; i++) assert_int_equal(out.seqs[i], expected[i]);
+
+    rtp_reorder_get_stats(r, &stats);
+    assert_int_equal(stats.packets, 6);
+    assert_int_equal(stats.reordered, 2); // 0 and 1 arrived after 2
+    assert_int_equal(stats.duplicates, 2);
+    assert_int_equal(stats.lost, 0);
+    assert_int_equal(stats.held, 0);
+    rtp_reorder_free(r);
+
+    assert_null(rtp_reorder_new(24, 64, 0));
+    assert_null(rtp_reorder_new(8, 64, 0));
+}
+
+static void test_rtp_reorder_loss_and_late(void **state)
+{
+    (void)state;
+    RtpReorder *r = rtp_reorder_new(16, 64, 20000);
+    Emitted out = {0};
+    RtpReorderStats stats;
+
+    // 101 never arrives: its successors wait until the window overflows
+    push(r, 100, 0, &out);
+    for (guint16 seq = 102; seq < 102 + 15; seq++) push(r, seq, 0, &out);
+    assert_int_equal(out.n, 1);
+    push(r, 117, 0, &out); // 117 - 101 == window
+    assert_int_equal(out.n, 17);
+    assert_int_equal(out.seqs[1], 102);
+    assert_int_equal(out.seqs[16], 117);
+
+    push(r, 101, 0, &out); // Too late now
+    rtp_reorder_get_stats(r, &stats);
+    assert_int_equal(stats.lost, 1);
+    assert_int_equal(stats.late, 1);
+    assert_int_equal(out.n, 17);
+
+    // A gap times out on its own when traffic is too slow to overflow the window
+    push(r, 120, 1000000, &out);
+    rtp_reorder_expire(r, 1010000, collect, &out);
+    assert_int_equal(out.n, 17);
+    rtp_reorder_expire(r, 1020000, collect, &out);
+    assert_int_equal(out.n, 18);
+    assert_int_equal(out.seqs[17], 120);
+    rtp_reorder_get_stats(r, &stats);
+    assert_int_equal(stats.lost, 3);
+    assert_int_equal(stats.held, 0);
+
+    // A sender restarting just behind: late packets until there are `window` in a row
+    for (guint16 seq = 50; seq < 50 + 15; seq++) push(r, seq, 1030000, &out);
+    rtp_reorder_get_stats(r, &stats);
+    assert_int_equal(stats.late, 16);
+    assert_int_equal(stats.resyncs, 0);
+    push(r, 65, 1030000, &out);
+    assert_int_equal(out.n, 19);
+    assert_int_equal(out.seqs[18], 65);
+
+    // A jump far back is a restart straight away
+    push(r, 40000, 1030000, &out);
+    push(r, 40001, 1030000, &out);
+    rtp_reorder_get_stats(r, &stats);
+    assert_int_equal(stats.resyncs, 2);
+    assert_int_equal(out.n, 21);
+    assert_int_equal(out.seqs[20], 40001);
+
+    // Reset releases what is held, in order
+    push(r, 40004, 1040000, &out);
+    push(r, 40003, 1040000, &out);
+    rtp_reorder_reset(r, collect, &out);
+    assert_int_equal(out.n, 23);
+    assert_int_equal(out.seqs[21], 40003);
+    assert_int_equal(out.seqs[22], 40004);
+    rtp_reorder_free(r);
+}
+
+int run_rtp_reorder_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_rtp_reorder_in_order_reorder_duplicates),
+        cmocka_unit_test(test_rtp_reorder_loss_and_late),
+    };
+    return cmocka_run_group_tests_name("rtp_reorder", tests, NULL, NULL);
+}
@@ -0,0 +1,119 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/shm_ring.h"
+#include "test_suites.h"
+
+static void produce(ShmRing *ring, guint8 value, guint len)
+{
+    guint8 *slot = shm_ring_reserve(ring);
+    assert_non_null(slot);
+    memset(slot, value, len);
+    shm_ring_commit(ring, len);
+}
+
+// A second mapping of the same descriptors stands in for the route process
+static ShmRing *attach_copy(ShmRing *ring)
+{
+    ShmRing *peer = shm_ring_attach(dup(shm_ring_memfd(ring)), dup(shm_ring_eventfd(ring)));
+    assert_non_null(peer);
+    return peer;
+}
+
+static void test_shm_ring_in_order(void **state)
+{
+    (void)state;
+    ShmRing *producer = shm_ring_create(4, 1500);
+    assert_non_null(producer);
+    ShmRing *consumer = attach_copy(producer);
+
+    assert_false(shm_ring_wait(consumer, 0));
+    produce(producer, 0x47, 188);
+    produce(producer, 0x48, 1316);
+    shm_ring_notify(producer);
+    assert_true(shm_ring_wait(consumer, 100));
+
+    guint len, slot;
+    guint8 *data = shm_ring_next(consumer, &len, &slot);
+    assert_non_null(data);
+    assert_int_equal(len, 188);
+    assert_int_equal(data[187], 0x47);
+    shm_ring_release(consumer, slot);
+
+    data = shm_ring_next(consumer, &len, &slot);
+    assert_non_null(data);
+    assert_int_equal(len, 1316);
+    assert_int_equal(data[0], 0x48);
+    shm_ring_release(consumer, slot);
+
+    assert_null(shm_ring_next(consumer, &len, &slot));
+    assert_false(shm_ring_wait(consumer, 0)); // Notification already consumed
+
+    shm_ring_free(consumer);
+    shm_ring_free(producer);
+}
+
+static void test_shm_ring_held_slot_is_not_overwritten(void **state)
+{
+    (void)state;
+    ShmRing *producer = shm_ring_create(2, 1500);
+    ShmRing *consumer = attach_copy(producer);
+
+    produce(producer, 1, 100);
+    produce(producer, 2, 100);
+
+    guint len, first, second;
+    guint8 *held = shm_ring_next(consumer, &len, &first);
+    assert_non_null(shm_ring_next(consumer, &len, &second));
+    shm_ring_release(consumer, second);
+
+    // The next slot to fill is the one still held downstream: the producer must drop, not overwrite
+    assert_null(shm_ring_reserve(producer));
+    shm_ring_drop(producer);
+    assert_int_equal(shm_ring_overruns(consumer), 1);
+    assert_int_equal(held[0], 1);
+
+    shm_ring_release(consumer, first);
+    produce(producer, 3, 100);
+    guint8 *data = shm_ring_next(consumer, &len, &first);
+    assert_non_null(data);
+    assert_int_equal(data[0], 3);
+    shm_ring_release(consumer, first);
+
+    shm_ring_free(consumer);
+    shm_ring_free(producer);
+}
+
+static void test_shm_ring_shared_stats(void **state)
+{
+    (void)state;
+    ShmRing *producer = shm_ring_create(8, 1500);
+    ShmRing *consumer = attach_copy(producer);
+
+    ShmRingStats *stats = shm_ring_stats(producer);
+    stats->connected = 1;
+    stats->packets_received = 42;
+    snprintf(stats->peer, sizeof(stats->peer), "10.0.0.1:4000");
+
+    assert_int_equal(shm_ring_stats(consumer)->connected, 1);
+    assert_int_equal(shm_ring_stats(consumer)->packets_received, 42);
+    assert_string_equal(shm_ring_stats(consumer)->peer, "10.0.0.1:4000");
+    assert_int_equal(shm_ring_slot_count(consumer), 8);
+
+    shm_ring_free(consumer);
+    shm_ring_free(producer);
+}
+
+int run_shm_ring_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_shm_ring_in_order),
+        cmocka_unit_test(test_shm_ring_held_slot_is_not_overwritten),
+        cmocka_unit_test(test_shm_ring_shared_stats),
+    };
+    return cmocka_run_group_tests_name("shm_ring", tests, NULL, NULL);
+}
@@ -0,0 +1,181 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/srt_group.h"
+#include "test_suites.h"
+
+#define LOOPBACK_MESSAGES 200
+
+static SrtGroup *group_from(const char *json, SrtGroupRecvFunc func, gpointer user_data)
+{
+    cJSON *config = cJSON_Parse(json);
+    assert_non_null(config);
+    SrtGroup *group = srt_group_new(config, func, user_data);
+    cJSON_Delete(config);
+    return group;
+}
+
+static void test_srt_group_rejects_invalid_config(void **state)
+{
+    (void)state;
+    const char *invalid[] = {
+        "{}",
+        "{\"links\": []}",
+        "{\"mode\": \"balancing\", \"links\": [{\"host\": \"127.0.0.1\", \"port\": 9000}]}",
+        "{\"role\": \"rendezvous\", \"links\": [{\"host\": \"127.0.0.1\", \"port\": 9000}]}",
+        "{\"links\": [{\"port\": 9000}]}",
+        "{\"links\": [{\"host\": \"127.0.0.1\", \"port\": 70000}]}",
+        "{\"links\": [{\"host\": \"127.0.0.1\", \"port\": 9000, \"weight\": -1}]}",
+        "{\"passphrase\": \"short\", \"links\": [{\"host\": \"127.0.0.1\", \"port\": 9000}]}",
+        "{\"mode\": \"backup\", \"stable-timeout-ms\": 20, \"links\": [{\"host\": \"127.0.0.1\", \"port\": 9000}]}",
+    };
+    for (gsize i = 0; i < G_N_ELEMENTS(invalid); i++) assert_null(group_from(invalid[i], NULL, NULL));
+
+    // More links than a group takes
+    GString *json = g_string_new("{\"links\": [");
+    for (int i = 0; i <= SRT_GROUP_MAX_LINKS; i++) {
+        g_string_append_printf(json, "%s{\"host\": \"127.0.0.1\", \"port\": %d}", i ? "," : "", 9000 + i);
+    }
+    g_string_append(json, "]}");
+    assert_null(group_from(json->str, NULL, NULL));
+    g_string_free(json, TRUE);
+}
+
+static void test_srt_group_stats_before_start(void **state)
+{
+    (void)state;
+    // A listener may leave out the host and listen on every address
+    SrtGroup *group = group_from("{\"mode\": \"backup\", \"role\": \"listener\", \"links\": "
+                                 "[{\"port\": 9000, \"weight\": 10}, {\"host\": \"127.0.0.1\", \"port\": 9001}]}",
+                                 NULL, NULL);
+    assert_non_null(group);
+
+    // Nothing is connected: every message is dropped, split at the live payload size
+    guint8 data[3 * SRT_GROUP_PAYLOAD_SIZE] = {0};
+    assert_false(srt_group_send(group, data, sizeof(data)));
+
+    SrtGroupStats stats;
+    srt_group_get_stats(group, &stats);
+    assert_int_equal(stats.mode, SRT_GROUP_BACKUP);
+    assert_false(stats.connected);
+    assert_int_equal(stats.send_drops, 3);
+    assert_int_equal(stats.packets, 0);
+    assert_int_equal(stats.n_links, 2);
+    assert_string_equal(stats.links[0].address, "0.0.0.0:9000");
+    assert_int_equal(stats.links[0].weight, 10);
+    assert_int_equal(stats.links[1].state, SRT_LINK_DOWN);
+
+    cJSON *root = cJSON_CreateObject();
+    srt_group_stats_to_json(&stats, root);
+    cJSON *bonding = cJSON_GetObjectItem(root, "bonding");
+    assert_string_equal(cJSON_GetObjectItem(bonding, "mode")->valuestring, "backup");
+    assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(bonding, "links")), 2);
+    cJSON_Delete(root);
+
+    srt_group_free(group);
+}
+
+typedef struct {
+    gint messages;
+    gint out_of_order;
+    guint32 next;
+} Received;
+
+static void on_message(const guint8 *data, gsize len, gpointer user_data)
+{
+    Received *received = user_data;
+    guint32 seq;
+    if (len < sizeof(seq)) return;
+    memcpy(&seq, data, sizeof(seq));
+    if (seq != received->next) g_atomic_int_inc(&received->out_of_order);
+    received->next = seq + 1;
+    g_atomic_int_inc(&received->messages);
+}
+
+static gboolean wait_for_links(SrtGroup *group, guint links)
+{
+    for (int i = 0; i < 100; i++) {
+        SrtGroupStats stats;
+        srt_group_get_stats(group, &stats);
+        guint up = 0;
+        for (guint l = 0; l < stats.n_links; l++) {
+            // Broadcast members stay idle until the first message goes out on them
+            up += stats.links[l].state == SRT_LINK_ACTIVE || stats.links[l].state == SRT_LINK_STANDBY;
+        }
+        if (up == links) return TRUE;
+        usleep(50 * 1000);
+    }
+    return FALSE;
+}
+
+// Two links over two loopback addresses: every message is sent on both, the receiver keeps one copy
+static void test_srt_group_broadcast_loopback(void **state)
+{
+    (void)state;
+    int port = 20000 + (int)(getpid() % 20000);
+    char json[512];
+    Received received = {0};
+
+    snprintf(json, sizeof(json),
+             "{\"role\": \"listener\", \"latency\": 120, \"streamid\": \"bonded\", "
+             "\"links\": [{\"host\": \"127.0.0.1\", \"port\": %d}, {\"host\": \"127.0.0.2\", \"port\": %d}]}",
+             port, port);
+    SrtGroup *receiver = group_from(json, on_message, &received);
+    assert_non_null(receiver);
+    if (!srt_group_start(receiver)) {
+        srt_group_free(receiver);
+        skip(); // libsrt without bonding
+    }
+
+    snprintf(json, sizeof(json),
+             "{\"mode\": \"broadcast\", \"latency\": 120, \"streamid\": \"bonded\", "
+             "\"links\": [{\"host\": \"127.0.0.1\", \"port\": %d}, {\"host\": \"127.0.0.2\", \"port\": %d}]}",
+             port, port);
+    SrtGroup *sender = group_from(json, NULL, NULL);
+    assert_non_null(sender);
+    assert_true(srt_group_start(sender));
+    assert_true(wait_for_links(sender, 2));
+
+    guint8 message[SRT_GROUP_PAYLOAD_SIZE] = {0};
+    for (guint32 seq = 0; seq < LOOPBACK_MESSAGES; seq++) {
+        memcpy(message, &seq, sizeof(seq));
+        assert_true(srt_group_send(sender, message, sizeof(message)));
+        usleep(500);
+    }
+    for (int i = 0; i < 100 && g_atomic_int_get(&received.messages) < LOOPBACK_MESSAGES; i++) usleep(50 * 1000);
+
+    // Duplicates from the second link are dropped by libsrt, so exactly one copy of each arrives
+    usleep(200 * 1000);
+    assert_int_equal(g_atomic_int_get(&received.messages), LOOPBACK_MESSAGES);
+    assert_int_equal(g_atomic_int_get(&received.out_of_order), 0);
+
+    SrtGroupStats stats;
+    srt_group_get_stats(sender, &stats);
+    assert_true(stats.connected);
+    assert_int_equal(stats.packets, LOOPBACK_MESSAGES);
+    assert_int_equal(stats.send_drops, 0);
+    assert_int_equal(stats.links[0].connects, 1);
+    assert_int_equal(stats.links[1].connects, 1);
+
+    srt_group_get_stats(receiver, &stats);
+    assert_true(stats.connected);
+    assert_int_equal(stats.packets, LOOPBACK_MESSAGES);
+
+    srt_group_free(sender);
+    srt_group_free(receiver);
+}
+
+int run_srt_group_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_srt_group_rejects_invalid_config),
+        cmocka_unit_test(test_srt_group_stats_before_start),
+        cmocka_unit_test(test_srt_group_broadcast_loopback),
+    };
+    return cmocka_run_group_tests_name("srt_group", tests, NULL, NULL);
+}
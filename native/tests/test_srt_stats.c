@@ -0,0 +1,152 @@
+#include <arpa/inet.h>
+#include <cmocka.h>
+#include <netinet/in.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "../include/srt_stats.h"
+#include "test_suites.h"
+
+static void test_srt_endpoint_from_uri(void **state)
+{
+    (void)state;
+    SrtEndpoint ep;
+
+    assert_true(srt_endpoint_from_uri("srt://:8001?mode=listener", &ep));
+    assert_int_equal(ep.mode, SRT_ENDPOINT_LISTENER);
+    assert_int_equal(ep.port, 8001);
+    assert_string_equal(ep.host, "");
+
+    assert_true(srt_endpoint_from_uri("srt://203.0.113.5:9000?latency=200", &ep));
+    assert_int_equal(ep.mode, SRT_ENDPOINT_CALLER);
+    assert_string_equal(ep.host, "203.0.113.5");
+    assert_int_equal(ep.port, 9000);
+
+    assert_true(srt_endpoint_from_uri("srt://[2001:db8::1]:9000?mode=rendezvous&localport=9100", &ep));
+    assert_int_equal(ep.mode, SRT_ENDPOINT_RENDEZVOUS);
+    assert_string_equal(ep.host, "2001:db8::1");
+    assert_int_equal(ep.local_port, 9100);
+
+    assert_false(srt_endpoint_from_uri("srt://example.com", &ep));
+    assert_false(srt_endpoint_from_uri("udp://127.0.0.1:9000", &ep));
+    assert_false(srt_endpoint_from_uri(NULL, &ep));
+}
+
+static void test_srt_endpoint_resolve(void **state)
+{
+    (void)state;
+    SrtEndpoint ep;
+
+    assert_true(srt_endpoint_from_uri("srt://203.0.113.5:9000", &ep));
+    assert_true(srt_endpoint_resolve(&ep));
+    assert_int_equal(ep.n_addresses, 1);
+    assert_int_equal(ep.addresses[0].ss_family, AF_INET);
+
+    assert_true(srt_endpoint_from_uri("srt://localhost:9000", &ep));
+    assert_true(srt_endpoint_resolve(&ep));
+    assert_true(ep.n_addresses >= 1);
+
+    // A listener has no peer to compare; a caller name that does not resolve matches nothing
+    assert_true(srt_endpoint_from_uri("srt://:8001?mode=listener", &ep));
+    assert_true(srt_endpoint_resolve(&ep));
+    assert_int_equal(ep.n_addresses, 0);
+    assert_true(srt_endpoint_from_uri("srt://no-such-host.invalid:9000", &ep));
+    assert_false(srt_endpoint_resolve(&ep));
+}
+
+static gboolean wait_connected(SRTSOCKET sock)
+{
+    for (int i = 0; i < 100; i++) {
+        if (srt_getsockstate(sock) == SRTS_CONNECTED) return TRUE;
+        usleep(20 * 1000);
+    }
+    return FALSE;
+}
+
+// Sockets opened after the index are found by address, whichever side they are on
+static void test_srt_socket_index_loopback(void **state)
+{
+    (void)state;
+    int port = 20000 + (int)((getpid() + 7919) % 20000);
+    SrtSocketIndex *index = srt_socket_index_new();
+    assert_non_null(index);
+
+    SrtEndpoint listener_ep = {.mode = SRT_ENDPOINT_LISTENER, .port = (guint16)port};
+    SrtEndpoint caller_ep = {.mode = SRT_ENDPOINT_CALLER, .port = (guint16)port};
+    g_strlcpy(caller_ep.host, "127.0.0.1", sizeof(caller_ep.host));
+    assert_true(srt_endpoint_resolve(&caller_ep));
+    SrtEndpoint twin_ep = caller_ep;
+    SrtEndpoint other_host_ep = {.mode = SRT_ENDPOINT_CALLER, .port = (guint16)port};
+    g_strlcpy(other_host_ep.host, "127.0.0.2", sizeof(other_host_ep.host));
+    assert_true(srt_endpoint_resolve(&other_host_ep));
+    SRTSOCKET socks[4];
+    srt_socket_index_refresh(index);
+    assert_int_equal(srt_socket_index_lookup(index, &listener_ep, socks, 4), -1);
+
+    struct sockaddr_in addr = {.sin_family = AF_INET, .sin_port = htons(port)};
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    SRTSOCKET listener = srt_create_socket();
+    assert_int_equal(srt_bind(listener, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    assert_int_equal(srt_listen(listener, 4), 0);
+    srt_socket_index_refresh(index);
+    assert_int_equal(srt_socket_index_lookup(index, &listener_ep, socks, 4), 0);
+
+    SRTSOCKET caller = srt_create_socket();
+    assert_int_equal(srt_connect(caller, (struct sockaddr *)&addr, sizeof(addr)), 0);
+    assert_true(wait_connected(caller));
+    struct sockaddr_storage peer;
+    int peer_len = sizeof(peer);
+    SRTSOCKET accepted = srt_accept(listener, (struct sockaddr *)&peer, &peer_len);
+    assert_true(accepted != SRT_INVALID_SOCK);
+
+    char payload[1316] = {0};
+    for (int i = 0; i < 10; i++) assert_int_equal(srt_sendmsg(caller, payload, sizeof(payload), -1, 1), 1316);
+    usleep(100 * 1000);
+
+    srt_socket_index_refresh(index);
+    assert_int_equal(srt_socket_index_lookup(index, &listener_ep, socks, 4), 1);
+    assert_int_equal(socks[0], accepted);
+    assert_int_equal(srt_socket_index_lookup(index, &caller_ep, socks, 4), 1);
+    assert_int_equal(socks[0], caller);
+
+    // Same port, another address: not this socket. Same address twice: only the first endpoint has it.
+    assert_int_equal(srt_socket_index_lookup(index, &other_host_ep, socks, 4), -1);
+    assert_int_equal(srt_socket_index_lookup(index, &twin_ep, socks, 4), -1);
+    assert_int_equal(srt_socket_index_lookup(index, &caller_ep, socks, 4), 1);
+    assert_int_equal(srt_socket_index_lookup(NULL, &caller_ep, socks, 4), -1);
+
+    SrtSocketStats stats;
+    assert_true(srt_socket_stats_read(caller, TRUE, &stats));
+    assert_int_equal(stats.packets_sent, 10);
+    assert_true(stats.bytes_sent_interval > 0);
+    assert_true(srt_socket_stats_read(caller, FALSE, &stats));
+    assert_int_equal(stats.bytes_sent_interval, 0);
+    assert_int_equal(stats.packets_sent, 10);
+
+    char peer_str[64];
+    srt_socket_peer_to_string(accepted, peer_str, sizeof(peer_str));
+    assert_true(g_str_has_prefix(peer_str, "127.0.0.1:"));
+
+    // Closed sockets drop out, and the listener has no callers left
+    srt_close(caller);
+    srt_close(accepted);
+    srt_socket_index_refresh(index);
+    assert_int_equal(srt_socket_index_lookup(index, &caller_ep, socks, 4), -1);
+    assert_int_equal(srt_socket_index_lookup(index, &listener_ep, socks, 4), 0);
+
+    srt_close(listener);
+    srt_socket_index_free(index);
+}
+
+int run_srt_stats_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_srt_endpoint_from_uri),
+        cmocka_unit_test(test_srt_endpoint_resolve),
+        cmocka_unit_test(test_srt_socket_index_loopback),
+    };
+    return cmocka_run_group_tests_name("srt_stats", tests, NULL, NULL);
+}
@@ -0,0 +1,46 @@
+#ifndef TEST_SUITES_H
+#define TEST_SUITES_H
+
+#include <glib.h>
+
+// Test groups living in their own files; each returns the number of failed tests
+int run_ts_sync_tests(void);
+int run_buffer_batch_tests(void);
+int run_shm_ring_tests(void);
+int run_admission_tests(void);
+int run_ts_filter_tests(void);
+int run_ts_nulls_tests(void);
+int run_ts_pacer_tests(void);
+int run_fec_tests(void);
+int run_srt_group_tests(void);
+int run_input_watchdog_tests(void);
+int run_queue_telemetry_tests(void);
+int run_caller_stats_tests(void);
+int run_audio_meter_tests(void);
+int run_video_health_tests(void);
+int run_rtp_reorder_tests(void);
+int run_udp_source_tests(void);
+int run_srt_stats_tests(void);
+int run_preview_server_tests(void);
+int run_delay_ring_tests(void);
+int run_ts_metadata_tests(void);
+int run_output_pool_tests(void);
+int run_thread_policy_tests(void);
+
+// Give a TS packet whose 4-byte header is already written an adaptation field carrying only `pcr`
+// (27 MHz ticks, below 2^33 * 300); the payload follows it
+static inline void put_pcr_packet(guint8 *pkt, guint64 pcr)
+{
+    guint64 base = pcr / 300, ext = pcr % 300;
+    pkt[3] |= 0x20;
+    pkt[4] = 7;
+    pkt[5] = 0x10;
+    pkt[6] = base >> 25;
+    pkt[7] = base >> 17;
+    pkt[8] = base >> 9;
+    pkt[9] = base >> 1;
+    pkt[10] = ((base & 1) << 7) | 0x7E | (ext >> 8);
+    pkt[11] = ext & 0xFF;
+}
+
+#endif
@@ -0,0 +1,262 @@
+#include <cmocka.h>
+#include <pthread.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/thread_policy.h"
+#include "test_suites.h"
+
+// A thread that applies the policy for its role and stays alive until released, so the stats can read it back
+typedef struct {
+    ThreadRole role;
+    const char *name;
+    pthread_t thread;
+    GMutex lock;
+    GCond cond;
+    gboolean applied;
+    gboolean release;
+    gboolean forget; // Call thread_policy_forget_self() on the way out, as the gateway's threads do
+} PlacedThread;
+
+static void *placed_thread_main(void *arg)
+{
+    PlacedThread *t = arg;
+    thread_policy_apply_self(t->role, t->name);
+    g_mutex_lock(&t->lock);
+    t->applied = TRUE;
+    g_cond_broadcast(&t->cond);
+    while (!t->release) g_cond_wait(&t->cond, &t->lock);
+    g_mutex_unlock(&t->lock);
+    if (t->forget) thread_policy_forget_self();
+    return NULL;
+}
+
+static void placed_thread_start(PlacedThread *t, ThreadRole role, const char *name)
+{
+    memset(t, 0, sizeof(*t));
+    t->role = role;
+    t->name = name;
+    g_mutex_init(&t->lock);
+    g_cond_init(&t->cond);
+    assert_int_equal(pthread_create(&t->thread, NULL, placed_thread_main, t), 0);
+    g_mutex_lock(&t->lock);
+    while (!t->applied) g_cond_wait(&t->cond, &t->lock);
+    g_mutex_unlock(&t->lock);
+}
+
+static void placed_thread_stop(PlacedThread *t)
+{
+    g_mutex_lock(&t->lock);
+    t->release = TRUE;
+    g_cond_broadcast(&t->cond);
+    g_mutex_unlock(&t->lock);
+    pthread_join(t->thread, NULL);
+    g_cond_clear(&t->cond);
+    g_mutex_clear(&t->lock);
+}
+
+static gboolean configure_json(const char *json)
+{
+    cJSON *config = cJSON_Parse(json);
+    assert_non_null(config);
+    gboolean ok = thread_policy_configure(config);
+    cJSON_Delete(config);
+    return ok;
+}
+
+static cJSON *find_thread(cJSON *root, const char *name)
+{
+    cJSON *thread;
+    cJSON_ArrayForEach(thread, cJSON_GetObjectItem(root, "threads"))
+    {
+        if (g_strcmp0(cJSON_GetObjectItem(thread, "name")->valuestring, name) == 0) return thread;
+    }
+    return NULL;
+}
+
+// Back to no policy and no placements, as a route without "threads" starts
+static void reset_policy(void)
+{
+    thread_policy_reset();
+    thread_policy_configure(NULL);
+}
+
+static void test_thread_policy_cpu_lists(void **state)
+{
+    (void)state;
+    static const struct {
+        const char *list;
+        const char *parsed;
+    } cases[] = {
+        {"0-3,6", "0-3,6"}, {"6,0-3", "0-3,6"}, {"2,0-1", "0-2"}, {"5-5", "5"}, {"0,1,2,3", "0-3"}, {"1023", "1023"},
+    };
+
+    for (guint i = 0; i < G_N_ELEMENTS(cases); i++) {
+        char json[128];
+        snprintf(json, sizeof(json), "{\"media-cpus\": \"%s\", \"analysis-cpus\": \"%s\"}", cases[i].list,
+                 cases[i].list);
+        assert_true(configure_json(json));
+
+        cJSON *root = cJSON_CreateObject();
+        thread_policy_add_stats(root);
+        cJSON *policy = cJSON_GetObjectItem(root, "thread-policy");
+        assert_non_null(policy);
+        assert_string_equal(cJSON_GetObjectItem(policy, "media-cpus")->valuestring, cases[i].parsed);
+        assert_string_equal(cJSON_GetObjectItem(policy, "analysis-cpus")->valuestring, cases[i].parsed);
+        cJSON_Delete(root);
+    }
+
+    // Defaults, and a priority outside the FIFO range is clamped to it
+    assert_true(configure_json("{\"policy\": \"fifo\", \"priority\": 500}"));
+    cJSON *root = cJSON_CreateObject();
+    thread_policy_add_stats(root);
+    cJSON *policy = cJSON_GetObjectItem(root, "thread-policy");
+    assert_string_equal(cJSON_GetObjectItem(policy, "policy")->valuestring, "fifo");
+    assert_int_equal(cJSON_GetObjectItem(policy, "priority")->valueint, 99);
+    assert_int_equal(cJSON_GetObjectItem(policy, "analysis-nice")->valueint, 10);
+    assert_null(cJSON_GetObjectItem(policy, "media-cpus"));
+    cJSON_Delete(root);
+
+    // No config: nothing configured, nothing reported
+    assert_true(thread_policy_configure(NULL));
+    root = cJSON_CreateObject();
+    thread_policy_add_stats(root);
+    assert_null(cJSON_GetObjectItem(root, "thread-policy"));
+    cJSON_Delete(root);
+    reset_policy();
+}
+
+static void test_thread_policy_rejects_malformed(void **state)
+{
+    (void)state;
+    static const char *lists[] = {
+        "", "a", "3-1", "1,", ",1", "1-", "0,,1", " 1", "+1", "-1", "1 2", "1-2-3", "0x1",
+        // Beyond what a cpu_set_t holds
+        "1024", "0-1024", "99999999999999999999",
+    };
+
+    for (guint i = 0; i < G_N_ELEMENTS(lists); i++) {
+        char json[128];
+        snprintf(json, sizeof(json), "{\"media-cpus\": \"%s\"}", lists[i]);
+        assert_false(configure_json(json));
+        snprintf(json, sizeof(json), "{\"analysis-cpus\": \"%s\"}", lists[i]);
+        assert_false(configure_json(json));
+    }
+
+    assert_false(configure_json("[\"0-3\"]"));
+    assert_false(configure_json("{\"policy\": \"deadline\"}"));
+    reset_policy();
+}
+
+static void test_thread_policy_rejects_unknown_roles(void **state)
+{
+    (void)state;
+    // Only media and analysis threads have a CPU set; a key for any other role is an error, not a no-op
+    assert_false(configure_json("{\"sink-cpus\": \"0\"}"));
+    assert_false(configure_json("{\"media-cpus\": \"0\", \"decode-nice\": 5}"));
+    assert_true(configure_json("{\"media-cpus\": \"0\", \"analysis-cpus\": \"0\"}"));
+
+    // A thread registering with a role outside the enum is left alone and not reported
+    thread_policy_reset();
+    PlacedThread known, unknown;
+    placed_thread_start(&known, THREAD_ROLE_SINK, "known");
+    placed_thread_start(&unknown, (ThreadRole)7, "unknown");
+
+    cJSON *root = cJSON_CreateObject();
+    thread_policy_add_stats(root);
+    cJSON *thread = find_thread(root, "known");
+    assert_non_null(thread);
+    assert_string_equal(cJSON_GetObjectItem(thread, "role")->valuestring, "sink");
+    assert_null(find_thread(root, "unknown"));
+    cJSON_Delete(root);
+
+    placed_thread_stop(&known);
+    placed_thread_stop(&unknown);
+    reset_policy();
+}
+
+static void test_thread_policy_falls_back(void **state)
+{
+    (void)state;
+    // CPU 1000 is valid in a cpu_set_t but not online here; SCHED_FIFO may or may not be permitted
+    assert_true(configure_json("{\"media-cpus\": \"1000\", \"policy\": \"fifo\", \"priority\": 40, \"nice\": 5}"));
+    thread_policy_reset();
+
+    PlacedThread media, analysis;
+    placed_thread_start(&media, THREAD_ROLE_SOURCE, "media");
+    placed_thread_start(&analysis, THREAD_ROLE_ANALYSIS, "analysis");
+
+    cJSON *root = cJSON_CreateObject();
+    thread_policy_add_stats(root);
+    cJSON *media_stats = find_thread(root, "media");
+    cJSON *analysis_stats = find_thread(root, "analysis");
+    assert_non_null(media_stats);
+    assert_non_null(analysis_stats);
+
+    // The affinity that could not be applied is left as inherited, like the unpinned analysis thread's
+    assert_string_equal(cJSON_GetObjectItem(media_stats, "cpus")->valuestring,
+                        cJSON_GetObjectItem(analysis_stats, "cpus")->valuestring);
+
+    // What the kernel reports: FIFO at the configured priority, or the nice fallback when not permitted
+    const char *policy = cJSON_GetObjectItem(media_stats, "policy")->valuestring;
+    if (strcmp(policy, "fifo") == 0) {
+        assert_int_equal(cJSON_GetObjectItem(media_stats, "priority")->valueint, 40);
+    } else {
+        assert_string_equal(policy, "other");
+        assert_int_equal(cJSON_GetObjectItem(media_stats, "nice")->valueint, 5);
+    }
+    assert_string_equal(cJSON_GetObjectItem(analysis_stats, "policy")->valuestring, "other");
+    assert_int_equal(cJSON_GetObjectItem(analysis_stats, "nice")->valueint, 10);
+    cJSON_Delete(root);
+
+    placed_thread_stop(&media);
+    placed_thread_stop(&analysis);
+    reset_policy();
+}
+
+static void test_thread_policy_forgets_exited_threads(void **state)
+{
+    (void)state;
+    thread_policy_reset();
+
+    // Removed on the way out, before its tid can be reused
+    PlacedThread forgotten;
+    placed_thread_start(&forgotten, THREAD_ROLE_SINK, "forgotten");
+    forgotten.forget = TRUE;
+    placed_thread_stop(&forgotten);
+
+    // More restarts than there are slots, none of them removing its entry: the exited ones are dropped once
+    // the table is full, so a thread placed after them still gets a slot
+    for (int i = 0; i < 100; i++) {
+        PlacedThread restarted;
+        placed_thread_start(&restarted, THREAD_ROLE_SOURCE, "restarted");
+        placed_thread_stop(&restarted);
+    }
+    PlacedThread last;
+    placed_thread_start(&last, THREAD_ROLE_ANALYSIS, "last");
+
+    cJSON *root = cJSON_CreateObject();
+    thread_policy_add_stats(root);
+    assert_int_equal(cJSON_GetArraySize(cJSON_GetObjectItem(root, "threads")), 1);
+    cJSON *thread = find_thread(root, "last");
+    assert_non_null(thread);
+    assert_string_equal(cJSON_GetObjectItem(thread, "role")->valuestring, "analysis");
+    cJSON_Delete(root);
+
+    placed_thread_stop(&last);
+    reset_policy();
+}
+
+int run_thread_policy_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_thread_policy_cpu_lists),
+        cmocka_unit_test(test_thread_policy_rejects_malformed),
+        cmocka_unit_test(test_thread_policy_rejects_unknown_roles),
+        cmocka_unit_test(test_thread_policy_falls_back),
+        cmocka_unit_test(test_thread_policy_forgets_exited_threads),
+    };
+    return cmocka_run_group_tests_name("thread_policy", tests, NULL, NULL);
+}
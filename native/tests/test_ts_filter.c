@@ -0,0 +1,260 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/ts_filter.h"
+#include "test_suites.h"
+
+// Two-program MPTS: program 1 (PMT 0x100, video 0x101 carrying the PCR, audio 0x102)
+// and program 2 (PMT 0x200, video 0x201, audio 0x202)
+#define MAX_TEST_PACKETS 64
+
+typedef struct {
+    guint8 data[MAX_TEST_PACKETS * TS_PACKET_SIZE];
+    guint count;
+} Stream;
+
+static void add_packet(Stream *s, guint16 pid, gboolean pusi, gboolean pcr, guint8 fill)
+{
+    guint8 *pkt = s->data + s->count++ * TS_PACKET_SIZE;
+    memset(pkt, fill, TS_PACKET_SIZE);
+    pkt[0] = TS_SYNC_BYTE;
+    pkt[1] = (pusi ? 0x40 : 0) | (pid >> 8);
+    pkt[2] = pid & 0xFF;
+    pkt[3] = 0x10;
+    if (pcr) {
+        pkt[3] = 0x30;
+        pkt[4] = 7;
+        pkt[5] = 0x10;
+        memset(pkt + 6, 0xAB, 6);
+    }
+}
+
+static void add_section(Stream *s, guint16 pid, guint8 *section, guint body_len)
+{
+    guint section_length = body_len - 3 + 4;
+    section[1] = 0xB0 | (section_length >> 8);
+    section[2] = section_length & 0xFF;
+    guint32 crc = ts_crc32(section, body_len);
+    section[body_len] = crc >> 24;
+    section[body_len + 1] = crc >> 16;
+    section[body_len + 2] = crc >> 8;
+    section[body_len + 3] = crc;
+
+    guint8 *pkt = s->data + s->count * TS_PACKET_SIZE;
+    add_packet(s, pid, TRUE, FALSE, 0xFF);
+    pkt[4] = 0; // Pointer field
+    memcpy(pkt + 5, section, body_len + 4);
+}
+
+static void add_pat(Stream *s)
+{
+    guint8 pat[64] = {0x00, 0, 0, 0x00, 0x01, 0xC1, 0x00, 0x00,
+                      0x00, 0x01, 0xE1, 0x00,  // Program 1 -> PMT 0x100
+                      0x00, 0x02, 0xE2, 0x00}; // Program 2 -> PMT 0x200
+    add_section(s, 0x0000, pat, 16);
+}
+
+static void add_pmt(Stream *s, guint16 program, guint16 base)
+{
+    guint8 pmt[64] = {0x02, 0, 0, program >> 8, program & 0xFF, 0xC1, 0x00, 0x00,
+                      0xE0 | (base + 1) >> 8, (base + 1) & 0xFF, 0xF0, 0x00,
+                      0x1B, 0xE0 | (base + 1) >> 8, (base + 1) & 0xFF, 0xF0, 0x00,
+                      0x0F, 0xE0 | (base + 2) >> 8, (base + 2) & 0xFF, 0xF0, 0x00};
+    add_section(s, base, pmt, 22);
+}
+
+static void add_mpts(Stream *s)
+{
+    add_pat(s);
+    add_pmt(s, 1, 0x100);
+    add_pmt(s, 2, 0x200);
+    for (int i = 0; i < 2; i++) {
+        add_packet(s, 0x101, FALSE, TRUE, 0x11);
+        add_packet(s, 0x102, FALSE, FALSE, 0x12);
+        add_packet(s, 0x201, FALSE, TRUE, 0x21);
+        add_packet(s, 0x202, FALSE, FALSE, 0x22);
+        add_packet(s, TS_NULL_PID, FALSE, FALSE, 0xFF);
+    }
+}
+
+static guint count_pid(GByteArray *out, guint16 pid)
+{
+    guint n = 0;
+    for (guint off = 0; off + TS_PACKET_SIZE <= out->len; off += TS_PACKET_SIZE) {
+        if (TS_PID(out->data + off) == pid) n++;
+    }
+    return n;
+}
+
+// The last section carried on `pid`, checked for a valid CRC; returns its length
+static guint last_section(GByteArray *out, guint16 pid, const guint8 **section)
+{
+    guint len = 0;
+    for (guint off = 0; off + TS_PACKET_SIZE <= out->len; off += TS_PACKET_SIZE) {
+        const guint8 *pkt = out->data + off;
+        if (TS_PID(pkt) != pid || !(pkt[1] & 0x40)) continue;
+        *section = pkt + 5 + pkt[4];
+        len = 3 + ((((*section)[1] & 0x0F) << 8) | (*section)[2]);
+    }
+    assert_true(len > 0);
+    assert_int_equal(ts_crc32(*section, len), 0);
+    return len;
+}
+
+static TsFilter *filter_from(const char *json)
+{
+    cJSON *config = cJSON_Parse(json);
+    TsFilter *filter = ts_filter_new(config);
+    cJSON_Delete(config);
+    return filter;
+}
+
+static void test_ts_crc32_check_value(void **state)
+{
+    (void)state;
+    assert_int_equal(ts_crc32((const guint8 *)"123456789", 9), 0x0376E6E7);
+}
+
+static void test_ts_filter_keeps_one_program(void **state)
+{
+    (void)state;
+    TsFilter *filter = filter_from("{\"programs\": [1]}");
+    assert_non_null(filter);
+
+    Stream *s = calloc(1, sizeof(Stream));
+    add_mpts(s);
+    GByteArray *out = g_byte_array_new();
+    ts_filter_process(filter, s->data, s->count * TS_PACKET_SIZE, out);
+
+    const guint8 *pat;
+    guint len = last_section(out, 0x0000, &pat);
+    assert_int_equal(len, 16); // One program entry left
+    assert_int_equal((pat[8] << 8) | pat[9], 1);
+
+    assert_int_equal(count_pid(out, 0x100), 1);
+    assert_int_equal(count_pid(out, 0x101), 2);
+    assert_int_equal(count_pid(out, 0x102), 2);
+    assert_int_equal(count_pid(out, 0x200), 0);
+    assert_int_equal(count_pid(out, 0x201), 0);
+    assert_int_equal(count_pid(out, TS_NULL_PID), 0);
+
+    // Passed packets are untouched
+    for (guint off = 0; off < out->len; off += TS_PACKET_SIZE) {
+        if (TS_PID(out->data + off) == 0x102) assert_int_equal(out->data[off + 100], 0x12);
+    }
+
+    TsFilterStats stats;
+    ts_filter_get_stats(filter, &stats);
+    assert_int_equal(stats.packets_in, s->count);
+    assert_int_equal(stats.packets_out, out->len / TS_PACKET_SIZE);
+    assert_int_equal(stats.programs, 1);
+
+    g_byte_array_free(out, TRUE);
+    free(s);
+    ts_filter_free(filter);
+}
+
+static void test_ts_filter_rewrites_pmt_for_selected_pids(void **state)
+{
+    (void)state;
+    TsFilter *filter = filter_from("{\"pids\": [513]}"); // 0x201, video of program 2
+
+    Stream *s = calloc(1, sizeof(Stream));
+    add_mpts(s);
+    add_mpts(s); // The second PAT lists the program found through its PMT
+    GByteArray *out = g_byte_array_new();
+    ts_filter_process(filter, s->data, s->count * TS_PACKET_SIZE, out);
+
+    const guint8 *pmt;
+    guint len = last_section(out, 0x200, &pmt);
+    assert_int_equal(len, 17 + 4); // Header plus one 5-byte stream entry and the CRC
+    assert_int_equal(((pmt[13] & 0x1F) << 8) | pmt[14], 0x201);
+
+    const guint8 *pat;
+    len = last_section(out, 0x0000, &pat);
+    assert_int_equal(len, 16);
+    assert_int_equal((pat[8] << 8) | pat[9], 2);
+
+    assert_int_equal(count_pid(out, 0x100), 0);
+    assert_int_equal(count_pid(out, 0x101), 0);
+    assert_int_equal(count_pid(out, 0x202), 0);
+    assert_true(count_pid(out, 0x201) > 0);
+
+    g_byte_array_free(out, TRUE);
+    free(s);
+    ts_filter_free(filter);
+}
+
+static void test_ts_filter_keeps_pcr_of_dropped_pid(void **state)
+{
+    (void)state;
+    TsFilter *filter = filter_from("{\"programs\": [1], \"pids\": [258]}"); // Audio only; PCR is on 0x101
+
+    Stream *s = calloc(1, sizeof(Stream));
+    add_mpts(s);
+    add_mpts(s);
+    GByteArray *out = g_byte_array_new();
+    ts_filter_process(filter, s->data, s->count * TS_PACKET_SIZE, out);
+
+    // The video PID only contributes its PCRs
+    guint pcr_packets = 0;
+    for (guint off = 0; off < out->len; off += TS_PACKET_SIZE) {
+        const guint8 *pkt = out->data + off;
+        if (TS_PID(pkt) != 0x101) continue;
+        assert_int_equal(pkt[3] & 0x30, 0x20); // Adaptation field only
+        assert_int_equal(pkt[4], 183);
+        assert_int_equal(pkt[5] & 0x10, 0x10);
+        assert_int_equal(pkt[6], 0xAB);
+        pcr_packets++;
+    }
+    assert_int_equal(pcr_packets, 4);
+    assert_int_equal(count_pid(out, 0x102), 4);
+
+    g_byte_array_free(out, TRUE);
+    free(s);
+    ts_filter_free(filter);
+}
+
+static void test_ts_filter_drops_corrupt_psi(void **state)
+{
+    (void)state;
+    TsFilter *filter = filter_from("{\"programs\": [1]}");
+
+    Stream *s = calloc(1, sizeof(Stream));
+    add_mpts(s);
+    s->data[5 + 9] ^= 0x01; // Program number in the PAT, CRC now wrong
+    GByteArray *out = g_byte_array_new();
+    ts_filter_process(filter, s->data, s->count * TS_PACKET_SIZE, out);
+
+    assert_int_equal(out->len, 0);
+    TsFilterStats stats;
+    ts_filter_get_stats(filter, &stats);
+    assert_int_equal(stats.crc_errors, 1);
+
+    g_byte_array_free(out, TRUE);
+    free(s);
+    ts_filter_free(filter);
+}
+
+static void test_ts_filter_rejects_empty_selection(void **state)
+{
+    (void)state;
+    assert_null(filter_from("{\"keep-pids\": [17]}"));
+    assert_null(filter_from("{\"pids\": [9000]}"));
+}
+
+int run_ts_filter_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_ts_crc32_check_value),
+        cmocka_unit_test(test_ts_filter_keeps_one_program),
+        cmocka_unit_test(test_ts_filter_rewrites_pmt_for_selected_pids),
+        cmocka_unit_test(test_ts_filter_keeps_pcr_of_dropped_pid),
+        cmocka_unit_test(test_ts_filter_drops_corrupt_psi),
+        cmocka_unit_test(test_ts_filter_rejects_empty_selection),
+    };
+    return cmocka_run_group_tests_name("ts_filter", tests, NULL, NULL);
+}
@@ -0,0 +1,281 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/ts_metadata.h"
+#include "test_suites.h"
+
+#define PMT_PID 0x100
+#define VIDEO_PID 0x101
+
+typedef struct {
+    guint calls;
+    TsVideoFormat old_format;
+    TsVideoFormat new_format;
+} FormatChanges;
+
+static void record_change(const TsVideoFormat *old_format, const TsVideoFormat *new_format, gpointer user_data)
+{
+    FormatChanges *changes = user_data;
+    changes->calls++;
+    changes->old_format = *old_format;
+    changes->new_format = *new_format;
+}
+
+typedef struct {
+    guint8 *data;
+    gsize bit;
+} BitWriter;
+
+static void put_bits(BitWriter *bw, guint32 value, gint n)
+{
+    for (gint i = n - 1; i >= 0; i--, bw->bit++) {
+        if ((value >> i) & 1) bw->data[bw->bit / 8] |= 0x80 >> (bw->bit % 8);
+    }
+}
+
+static void put_ue(BitWriter *bw, guint32 value)
+{
+    gint bits = 1;
+    while ((value + 1) >> bits) bits++;
+    put_bits(bw, 0, bits - 1);
+    put_bits(bw, value + 1, bits);
+}
+
+// Baseline-profile SPS NAL unit (header included) for a progressive picture of whole macroblocks
+static gsize make_h264_sps(guint8 *out, gint width, gint height)
+{
+    memset(out, 0, 32);
+    BitWriter bw = {out, 0};
+    put_bits(&bw, 0x67, 8); // NAL header: SPS
+    put_bits(&bw, 66, 8);   // profile_idc
+    put_bits(&bw, 0xC0, 8); // constraint flags
+    put_bits(&bw, 40, 8);   // level_idc
+    put_ue(&bw, 0);         // seq_parameter_set_id
+    put_ue(&bw, 0);         // log2_max_frame_num_minus4
+    put_ue(&bw, 2);         // pic_order_cnt_type
+    put_ue(&bw, 1);         // max_num_ref_frames
+    put_bits(&bw, 0, 1);    // gaps_in_frame_num_value_allowed_flag
+    put_ue(&bw, width / 16 - 1);
+    put_ue(&bw, height / 16 - 1);
+    put_bits(&bw, 1, 1); // frame_mbs_only_flag
+    put_bits(&bw, 1, 1); // direct_8x8_inference_flag
+    put_bits(&bw, 0, 1); // frame_cropping_flag
+    put_bits(&bw, 0, 1); // vui_parameters_present_flag
+    put_bits(&bw, 1, 1); // rbsp_stop_one_bit
+    return (bw.bit + 7) / 8;
+}
+
+static void put_crc(guint8 *p, guint32 crc)
+{
+    p[0] = crc >> 24;
+    p[1] = crc >> 16;
+    p[2] = crc >> 8;
+    p[3] = crc;
+}
+
+// A packet starting a section or PES on `pid`, stuffed with 0xFF
+static guint8 *start_packet(guint8 *pkt, guint16 pid)
+{
+    memset(pkt, 0xFF, TS_PACKET_SIZE);
+    pkt[0] = TS_SYNC_BYTE;
+    pkt[1] = 0x40 | (pid >> 8);
+    pkt[2] = pid & 0xFF;
+    pkt[3] = 0x10;
+    return pkt + 4;
+}
+
+// Followed by a null packet, which lets ts_sync lock on from a single packet
+static void feed_packet(TsMetadata *meta, const guint8 *pkt)
+{
+    guint8 data[2 * TS_PACKET_SIZE];
+    memcpy(data, pkt, TS_PACKET_SIZE);
+    memset(data + TS_PACKET_SIZE, 0xFF, TS_PACKET_SIZE);
+    data[TS_PACKET_SIZE] = TS_SYNC_BYTE;
+    data[TS_PACKET_SIZE + 1] = TS_NULL_PID >> 8;
+    data[TS_PACKET_SIZE + 2] = TS_NULL_PID & 0xFF;
+    data[TS_PACKET_SIZE + 3] = 0x10;
+    ts_metadata_feed(meta, data, sizeof(data));
+}
+
+// The CRC is not checked, so tests pick one to tell sections of the same version apart
+static void feed_pat(TsMetadata *meta, guint8 version, guint16 pmt_pid, guint32 crc)
+{
+    guint8 pkt[TS_PACKET_SIZE];
+    guint8 *s = start_packet(pkt, 0x0000);
+    *s++ = 0; // pointer_field
+    const guint8 header[] = {0x00, 0xB0, 17, 0x00, 0x01, 0xC1 | (version << 1), 0, 0};
+    memcpy(s, header, sizeof(header));
+    const guint8 programs[] = {0x00, 0x00, 0xE0, 0x10, 0x00, 0x01, 0xE0 | (pmt_pid >> 8), pmt_pid & 0xFF};
+    memcpy(s + 8, programs, sizeof(programs));
+    put_crc(s + 16, crc);
+    feed_packet(meta, pkt);
+}
+
+static void feed_pmt(TsMetadata *meta, guint8 version, guint8 stream_type, guint16 video_pid)
+{
+    guint8 pkt[TS_PACKET_SIZE];
+    guint8 *s = start_packet(pkt, PMT_PID);
+    *s++ = 0;
+    // An audio stream with a descriptor ahead of the video one
+    const guint8 section[] = {0x02, 0xB0, 25, 0x00, 0x01, 0xC1 | (version << 1), 0, 0, 0xE0 | (video_pid >> 8),
+                              video_pid & 0xFF, 0xF0, 0x00, 0x0F, 0xE1, 0x02, 0xF0, 0x02, 0x0A, 0x00,
+                              stream_type, 0xE0 | (video_pid >> 8), video_pid & 0xFF, 0xF0, 0x00};
+    memcpy(s, section, sizeof(section));
+    put_crc(s + sizeof(section), version);
+    feed_packet(meta, pkt);
+}
+
+// One video packet with a PES header and `es`; `unit_start` FALSE makes it a PES continuation
+static void feed_video(TsMetadata *meta, guint16 pid, const guint8 *es, gsize size, gboolean unit_start)
+{
+    guint8 pkt[TS_PACKET_SIZE];
+    guint8 *p = start_packet(pkt, pid);
+    if (!unit_start) pkt[1] &= ~0x40;
+    const guint8 pes[] = {0x00, 0x00, 0x01, 0xE0, 0x00, 0x00, 0x80, 0x80, 0x05, 0x21, 0x00, 0x01, 0x00, 0x01};
+    memcpy(p, pes, sizeof(pes));
+    memcpy(p + sizeof(pes), es, size);
+    feed_packet(meta, pkt);
+}
+
+// Access unit delimiter, SPS and the start of an IDR slice
+static void feed_h264_access_unit(TsMetadata *meta, gint width, gint height)
+{
+    guint8 es[64] = {0x00, 0x00, 0x00, 0x01, 0x09, 0xF0, 0x00, 0x00, 0x00, 0x01};
+    gsize size = 10 + make_h264_sps(es + 10, width, height);
+    const guint8 idr[] = {0x00, 0x00, 0x01, 0x65, 0x88, 0x84};
+    memcpy(es + size, idr, sizeof(idr));
+    feed_video(meta, VIDEO_PID, es, size + sizeof(idr), TRUE);
+}
+
+static void test_ts_metadata_detects_format_once(void **state)
+{
+    (void)state;
+    FormatChanges changes = {0};
+    TsMetadata *meta = ts_metadata_new(record_change, &changes);
+
+    // Nothing is looked at before the PAT and PMT name the video PID
+    feed_h264_access_unit(meta, 1920, 1088);
+    TsVideoFormat format;
+    ts_metadata_get_format(meta, &format);
+    assert_false(format.valid);
+
+    for (guint i = 0; i < 10; i++) {
+        feed_pat(meta, 0, PMT_PID, 0x1234);
+        feed_pmt(meta, 0, TS_STREAM_TYPE_H264, VIDEO_PID);
+        feed_h264_access_unit(meta, 1920, 1088);
+    }
+
+    assert_int_equal(changes.calls, 1);
+    assert_false(changes.old_format.valid);
+    assert_true(changes.new_format.valid);
+    assert_int_equal(changes.new_format.stream_type, TS_STREAM_TYPE_H264);
+    assert_int_equal(changes.new_format.width, 1920);
+    assert_int_equal(changes.new_format.height, 1088);
+    assert_int_equal(changes.new_format.fps_num, 25);
+    assert_false(changes.new_format.interlaced);
+
+    // Repeats of the same PAT, PMT and SPS are recognised without being parsed again
+    TsMetadataStats stats;
+    ts_metadata_get_stats(meta, &stats);
+    assert_int_equal(stats.pat_changes, 1);
+    assert_int_equal(stats.pmt_changes, 1);
+    assert_int_equal(stats.header_parses, 1);
+    assert_int_equal(stats.format_changes, 1);
+    ts_metadata_get_format(meta, &format);
+    assert_int_equal(format.width, 1920);
+    ts_metadata_free(meta);
+}
+
+static void test_ts_metadata_follows_resolution_change(void **state)
+{
+    (void)state;
+    FormatChanges changes = {0};
+    TsMetadata *meta = ts_metadata_new(record_change, &changes);
+    feed_pat(meta, 0, PMT_PID, 0x1234);
+    feed_pmt(meta, 0, TS_STREAM_TYPE_H264, VIDEO_PID);
+    feed_h264_access_unit(meta, 1920, 1088);
+
+    // An SPS in the middle of a PES is not where parameter sets live, and is not looked at
+    guint8 sps[40];
+    gsize size = make_h264_sps(sps + 3, 640, 480);
+    sps[0] = sps[1] = 0;
+    sps[2] = 1;
+    feed_video(meta, VIDEO_PID, sps, size + 3, FALSE);
+    assert_int_equal(changes.calls, 1);
+
+    feed_h264_access_unit(meta, 1280, 720);
+    feed_h264_access_unit(meta, 1280, 720);
+    assert_int_equal(changes.calls, 2);
+    assert_true(changes.old_format.valid);
+    assert_int_equal(changes.old_format.width, 1920);
+    assert_int_equal(changes.old_format.height, 1088);
+    assert_int_equal(changes.new_format.width, 1280);
+    assert_int_equal(changes.new_format.height, 720);
+
+    TsMetadataStats stats;
+    ts_metadata_get_stats(meta, &stats);
+    assert_int_equal(stats.header_parses, 2);
+    assert_int_equal(stats.format_changes, 2);
+    ts_metadata_free(meta);
+}
+
+static void test_ts_metadata_follows_pmt_change(void **state)
+{
+    (void)state;
+    FormatChanges changes = {0};
+    TsMetadata *meta = ts_metadata_new(record_change, &changes);
+    feed_pat(meta, 0, PMT_PID, 0x1234);
+    feed_pmt(meta, 0, TS_STREAM_TYPE_H264, VIDEO_PID);
+    feed_h264_access_unit(meta, 1920, 1088);
+
+    // The failover encoder sends MPEG-2 on another PID under PMT version 1
+    feed_pmt(meta, 1, TS_STREAM_TYPE_MPEG2_VIDEO, 0x200);
+    const guint8 sequence[] = {0x00, 0x00, 0x01, 0xB3, 0x2D, 0x02, 0x40, 0x33, 0xFF, 0xFF, 0xE0, 0x18,
+                               0x00, 0x00, 0x01, 0xB8, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00};
+    feed_video(meta, 0x200, sequence, sizeof(sequence), TRUE);
+    assert_int_equal(changes.calls, 2);
+    assert_int_equal(changes.old_format.stream_type, TS_STREAM_TYPE_H264);
+    assert_int_equal(changes.new_format.stream_type, TS_STREAM_TYPE_MPEG2_VIDEO);
+    assert_int_equal(changes.new_format.width, 720);
+    assert_int_equal(changes.new_format.height, 576);
+    assert_int_equal(changes.new_format.fps_num, 25);
+    assert_int_equal(changes.new_format.fps_den, 1);
+    assert_false(changes.new_format.fps_inferred);
+
+    // The old PID is no longer watched
+    feed_h264_access_unit(meta, 1280, 720);
+    assert_int_equal(changes.calls, 2);
+
+    // A restarted encoder reuses version 0 for a PAT pointing elsewhere: the CRC gives it away
+    feed_pat(meta, 0, 0x300, 0x5678);
+    guint8 pkt[TS_PACKET_SIZE];
+    guint8 *s = start_packet(pkt, 0x300);
+    *s++ = 0;
+    const guint8 section[] = {0x02, 0xB0, 18, 0x00, 0x01, 0xC1, 0, 0, 0xE1, 0x01, 0xF0, 0x00,
+                              TS_STREAM_TYPE_H264, 0xE1, 0x01, 0xF0, 0x00, 0, 0, 0, 0};
+    memcpy(s, section, sizeof(section));
+    feed_packet(meta, pkt);
+    feed_h264_access_unit(meta, 1280, 720);
+    assert_int_equal(changes.calls, 3);
+    assert_int_equal(changes.old_format.stream_type, TS_STREAM_TYPE_MPEG2_VIDEO);
+    assert_int_equal(changes.new_format.width, 1280);
+
+    TsMetadataStats stats;
+    ts_metadata_get_stats(meta, &stats);
+    assert_int_equal(stats.pat_changes, 2);
+    assert_int_equal(stats.pmt_changes, 3);
+    ts_metadata_free(meta);
+}
+
+int run_ts_metadata_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_ts_metadata_detects_format_once),
+        cmocka_unit_test(test_ts_metadata_follows_resolution_change),
+        cmocka_unit_test(test_ts_metadata_follows_pmt_change),
+    };
+    return cmocka_run_group_tests_name("ts_metadata", tests, NULL, NULL);
+}
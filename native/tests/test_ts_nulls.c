@@ -0,0 +1,172 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/ts_nulls.h"
+#include "test_suites.h"
+
+#define PCR_PID 0x100
+#define ES_PID 0x101
+#define PCR_INTERVAL 1080000 // 40 ms at 27 MHz
+#define PCR_WRAP ((G_GUINT64_CONSTANT(1) << 33) * 300)
+
+static void put_packet(GByteArray *s, guint16 pid, gint64 pcr)
+{
+    guint8 pkt[TS_PACKET_SIZE];
+    memset(pkt, 0x55, sizeof(pkt));
+    pkt[0] = TS_SYNC_BYTE;
+    pkt[1] = pid >> 8;
+    pkt[2] = pid & 0xFF;
+    pkt[3] = 0x10;
+    if (pcr >= 0) put_pcr_packet(pkt, (guint64)pcr % PCR_WRAP);
+    g_byte_array_append(s, pkt, TS_PACKET_SIZE);
+}
+
+// `intervals` PCR intervals of 40 ms, each with a PCR packet, `payload` ES packets and 5 nulls
+static GByteArray *make_stream(guint intervals, guint payload, gint64 first_pcr)
+{
+    GByteArray *s = g_byte_array_new();
+    for (guint i = 0; i < intervals; i++) {
+        put_packet(s, PCR_PID, first_pcr + (gint64)i * PCR_INTERVAL);
+        for (guint j = 0; j < payload; j++) {
+            put_packet(s, ES_PID, -1);
+            if (j % 2 == 0 && j < 10) put_packet(s, TS_NULL_PID, -1);
+        }
+    }
+    return s;
+}
+
+static TsNulls *nulls_from(const char *json)
+{
+    cJSON *config = cJSON_Parse(json);
+    TsNulls *nulls = ts_nulls_new(config);
+    cJSON_Delete(config);
+    return nulls;
+}
+
+static guint count_pid(GByteArray *out, guint16 pid)
+{
+    guint n = 0;
+    for (guint off = 0; off + TS_PACKET_SIZE <= out->len; off += TS_PACKET_SIZE) {
+        if (TS_PID(out->data + off) == pid) n++;
+    }
+    return n;
+}
+
+static void test_ts_nulls_strip(void **state)
+{
+    (void)state;
+    TsNulls *nulls = nulls_from("{\"mode\": \"strip\"}");
+    assert_non_null(nulls);
+
+    GByteArray *in = make_stream(4, 20, 0);
+    GByteArray *out = g_byte_array_new();
+    // Odd split: the second call starts mid-packet
+    ts_nulls_process(nulls, in->data, 1000, out);
+    ts_nulls_process(nulls, in->data + 1000, in->len - 1000, out);
+
+    assert_int_equal(count_pid(out, TS_NULL_PID), 0);
+    assert_int_equal(count_pid(out, ES_PID), 80);
+    assert_int_equal(count_pid(out, PCR_PID), 4);
+
+    TsNullsStats stats;
+    ts_nulls_get_stats(nulls, &stats);
+    assert_int_equal(stats.nulls_stripped, 20);
+    assert_int_equal(stats.packets_in, in->len / TS_PACKET_SIZE);
+    assert_int_equal(stats.packets_out, out->len / TS_PACKET_SIZE);
+
+    cJSON *root = cJSON_CreateObject();
+    ts_nulls_stats_to_json(nulls, &stats, root);
+    cJSON *obj = cJSON_GetObjectItem(root, "nulls");
+    assert_string_equal(cJSON_GetObjectItem(obj, "mode")->valuestring, "strip");
+    assert_int_equal(cJSON_GetObjectItem(obj, "bytes-saved")->valueint, 20 * TS_PACKET_SIZE);
+    cJSON_Delete(root);
+
+    g_byte_array_free(in, TRUE);
+    g_byte_array_free(out, TRUE);
+    ts_nulls_free(nulls);
+}
+
+static void test_ts_nulls_pad_to_cbr(void **state)
+{
+    (void)state;
+    // 100 packets per 40 ms interval: 100 * 188 * 8 / 0.04 = 3760000 bit/s
+    TsNulls *nulls = nulls_from("{\"mode\": \"pad\", \"bitrate\": 3760000}");
+    assert_non_null(nulls);
+
+    // Starts just below the 33-bit PCR wrap
+    GByteArray *in = make_stream(6, 30, (gint64)PCR_WRAP - 2 * PCR_INTERVAL);
+    GByteArray *out = g_byte_array_new();
+    ts_nulls_process(nulls, in->data, in->len, out);
+
+    // Five complete intervals are out (the sixth is held); every one is exactly 100 packets
+    guint pcr_positions[8], found = 0;
+    for (guint off = 0, i = 0; off < out->len; off += TS_PACKET_SIZE, i++) {
+        if (TS_PID(out->data + off) == PCR_PID) pcr_positions[found++] = i;
+    }
+    assert_int_equal(found, 5);
+    for (guint i = 1; i < found; i++) assert_int_equal(pcr_positions[i] - pcr_positions[i - 1], 100);
+    assert_int_equal(out->len / TS_PACKET_SIZE, 5 * 100);
+    assert_int_equal(count_pid(out, ES_PID), 5 * 30);
+
+    // Inserted nulls are spread through the interval, not bunched at its end
+    assert_int_equal(TS_PID(out->data + 2 * TS_PACKET_SIZE), TS_NULL_PID);
+
+    TsNullsStats stats;
+    ts_nulls_get_stats(nulls, &stats);
+    assert_int_equal(stats.nulls_stripped, 6 * 5);
+    assert_int_equal(stats.nulls_inserted, 5 * (100 - 31));
+    assert_int_equal(stats.overflows, 0);
+    assert_int_equal(stats.discontinuities, 0);
+
+    g_byte_array_free(in, TRUE);
+    g_byte_array_free(out, TRUE);
+    ts_nulls_free(nulls);
+}
+
+static void test_ts_nulls_pad_overflow_and_discontinuity(void **state)
+{
+    (void)state;
+    // 10 packets per interval, but the input carries 41
+    TsNulls *nulls = nulls_from("{\"mode\": \"pad\", \"bitrate\": 376000, \"pcr-pid\": 256}");
+    assert_non_null(nulls);
+
+    GByteArray *in = make_stream(3, 40, 0);
+    put_packet(in, PCR_PID, 27000000 * 5LL); // Jump of several seconds
+    GByteArray *out = g_byte_array_new();
+    ts_nulls_process(nulls, in->data, in->len, out);
+
+    assert_int_equal(count_pid(out, TS_NULL_PID), 0);
+    assert_int_equal(count_pid(out, ES_PID), 3 * 40);
+
+    TsNullsStats stats;
+    ts_nulls_get_stats(nulls, &stats);
+    assert_int_equal(stats.overflows, 2);
+    assert_int_equal(stats.discontinuities, 1);
+
+    g_byte_array_free(in, TRUE);
+    g_byte_array_free(out, TRUE);
+    ts_nulls_free(nulls);
+}
+
+static void test_ts_nulls_rejects_invalid_config(void **state)
+{
+    (void)state;
+    assert_null(nulls_from("{}"));
+    assert_null(nulls_from("{\"mode\": \"squash\"}"));
+    assert_null(nulls_from("{\"mode\": \"pad\"}"));
+    assert_null(nulls_from("{\"mode\": \"pad\", \"bitrate\": 8000000, \"pcr-pid\": 8191}"));
+}
+
+int run_ts_nulls_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_ts_nulls_strip),
+        cmocka_unit_test(test_ts_nulls_pad_to_cbr),
+        cmocka_unit_test(test_ts_nulls_pad_overflow_and_discontinuity),
+        cmocka_unit_test(test_ts_nulls_rejects_invalid_config),
+    };
+    return cmocka_run_group_tests_name("ts_nulls", tests, NULL, NULL);
+}
@@ -0,0 +1,200 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/ts_pacer.h"
+#include "test_suites.h"
+
+// 20 packets per 40 ms PCR interval (2 ms apart at the encoded rate) on PID 0x100
+#define PER_INTERVAL 20
+#define INTERVAL_US 40000
+#define PACKET_US (INTERVAL_US / PER_INTERVAL)
+#define STEP_US 100
+#define PER_DATAGRAM 4 // Packets arrive 4 at a time, as the sender's datagrams
+
+typedef struct {
+    gint64 nominal[512]; // Arrival time at the encoded rate
+    gint64 arrival[512];
+    gint64 departure[512];
+    guint packets;
+    guint out;
+    guint max_pop;
+    guint same_time_pops;
+} Sim;
+
+static void make_packet(guint8 *pkt, guint index)
+{
+    memset(pkt, 0, TS_PACKET_SIZE);
+    pkt[0] = TS_SYNC_BYTE;
+    pkt[1] = 0x01;
+    pkt[3] = 0x10;
+    pkt[100] = index & 0xFF; // Lets the test match departures to packets
+    pkt[101] = index >> 8;
+    if (index % PER_INTERVAL == 0) {
+        guint64 base = (guint64)(index / PER_INTERVAL) * INTERVAL_US * 90 / 1000 + 900000;
+        put_pcr_packet(pkt, base * 300);
+    }
+}
+
+// Feed packets as they arrive and pop everything due, in STEP_US ticks
+static void run(TsPacer *pacer, Sim *sim, gint64 until_us)
+{
+    guint next = 0;
+    for (gint64 now = 0; now <= until_us; now += STEP_US) {
+        guint8 data[PER_INTERVAL * 4 * TS_PACKET_SIZE];
+        guint n = 0;
+        while (next < sim->packets && sim->arrival[next] <= now) make_packet(data + n++ * TS_PACKET_SIZE, next++);
+        if (n > 0) ts_pacer_push(pacer, data, n * TS_PACKET_SIZE, now);
+
+        guint pops = 0;
+        GByteArray *out = g_byte_array_new();
+        while ((n = ts_pacer_pop(pacer, out, now)) > 0) {
+            sim->max_pop = MAX(sim->max_pop, n);
+            if (++pops > 1) sim->same_time_pops++;
+        }
+        for (guint off = 0; off < out->len; off += TS_PACKET_SIZE) {
+            guint index = out->data[off + 100] | (out->data[off + 101] << 8);
+            sim->departure[index] = now;
+            sim->out++;
+        }
+        g_byte_array_free(out, TRUE);
+    }
+}
+
+static void sim_init(Sim *sim, guint intervals, guint stall_from, guint stall_to)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->packets = intervals * PER_INTERVAL;
+    for (guint i = 0; i < sim->packets; i++) {
+        guint interval = i / PER_INTERVAL;
+        sim->nominal[i] = (gint64)i * PACKET_US;
+        sim->arrival[i] = (gint64)(i - i % PER_DATAGRAM) * PACKET_US;
+        // Intervals [stall_from, stall_to) arrive in one burst together with interval stall_to
+        if (interval >= stall_from && interval < stall_to) sim->arrival[i] = (gint64)stall_to * INTERVAL_US;
+    }
+}
+
+static TsPacer *pacer_from(const char *json)
+{
+    cJSON *config = cJSON_Parse(json);
+    TsPacer *pacer = ts_pacer_new(config);
+    cJSON_Delete(config);
+    return pacer;
+}
+
+static void test_ts_pacer_steady_stream(void **state)
+{
+    (void)state;
+    TsPacer *pacer = pacer_from("{\"delay-ms\": 100}");
+    assert_non_null(pacer);
+
+    Sim sim;
+    sim_init(&sim, 10, 0, 0);
+    run(pacer, &sim, 500000);
+
+    // Datagrams are spread back out to the encoded rate; the last interval waits for a PCR that never comes
+    assert_int_equal(sim.out, 9 * PER_INTERVAL);
+    assert_int_equal(sim.max_pop, 1);
+    for (guint i = 0; i < sim.out; i++) assert_int_equal(sim.departure[i] - sim.nominal[i], 100000);
+
+    TsPacerStats stats;
+    ts_pacer_get_stats(pacer, &stats);
+    assert_int_equal(stats.late_packets, 0);
+    assert_int_equal(stats.queued, 0);
+    assert_true(stats.gap_jitter_max_us < STEP_US);
+    ts_pacer_free(pacer);
+}
+
+static void test_ts_pacer_smooths_burst(void **state)
+{
+    (void)state;
+    TsPacer *pacer = pacer_from("{\"delay-ms\": 200}");
+
+    // Intervals 3-5 are stalled and arrive at once 120 ms late, within the delay budget
+    Sim sim;
+    sim_init(&sim, 10, 3, 6);
+    run(pacer, &sim, 600000);
+
+    assert_int_equal(sim.out, 9 * PER_INTERVAL);
+    // Only the slow clock slew (following what looks like sender drift) shows, within one tick
+    for (guint i = 1; i < sim.out; i++) {
+        assert_true(llabs(sim.departure[i] - sim.departure[i - 1] - PACKET_US) <= STEP_US);
+    }
+    assert_int_equal(sim.same_time_pops, 0);
+
+    TsPacerStats stats;
+    ts_pacer_get_stats(pacer, &stats);
+    assert_int_equal(stats.late_packets, 0);
+    assert_true(stats.gap_jitter_avg_us < 10.0);
+    ts_pacer_free(pacer);
+}
+
+static void test_ts_pacer_limits_catch_up_bursts(void **state)
+{
+    (void)state;
+    TsPacer *pacer = pacer_from("{\"delay-ms\": 10, \"max-burst\": 4}");
+
+    // 120 ms of stall against a 10 ms budget: the backlog is late
+    Sim sim;
+    sim_init(&sim, 10, 3, 6);
+    run(pacer, &sim, 600000);
+
+    assert_int_equal(sim.out, 9 * PER_INTERVAL);
+    assert_true(sim.max_pop <= 4);
+    assert_int_equal(sim.same_time_pops, 0);
+
+    TsPacerStats stats;
+    ts_pacer_get_stats(pacer, &stats);
+    assert_true(stats.late_packets > 0);
+    assert_true(stats.gap_jitter_max_us > 0);
+
+    // The window restarts on every read
+    ts_pacer_get_stats(pacer, &stats);
+    assert_int_equal(stats.gap_jitter_max_us, 0);
+    ts_pacer_free(pacer);
+}
+
+static void test_ts_pacer_without_pcr_is_unpaced(void **state)
+{
+    (void)state;
+    TsPacer *pacer = pacer_from("{\"pcr-pid\": 4000}");
+
+    guint8 data[2 * TS_PACKET_SIZE];
+    make_packet(data, 0); // Carries a PCR, but not on the configured PID
+    make_packet(data + TS_PACKET_SIZE, 1);
+    ts_pacer_push(pacer, data, sizeof(data), 5000);
+    assert_int_equal(ts_pacer_next_departure(pacer), 5000);
+
+    GByteArray *out = g_byte_array_new();
+    assert_int_equal(ts_pacer_pop(pacer, out, 5000), 2);
+    assert_int_equal(ts_pacer_next_departure(pacer), -1);
+
+    TsPacerStats stats;
+    ts_pacer_get_stats(pacer, &stats);
+    assert_int_equal(stats.unpaced, 2);
+
+    cJSON *root = cJSON_CreateObject();
+    ts_pacer_stats_to_json(&stats, root);
+    assert_int_equal(cJSON_GetObjectItem(cJSON_GetObjectItem(root, "pacing"), "unpaced-packets")->valueint, 2);
+    cJSON_Delete(root);
+
+    g_byte_array_free(out, TRUE);
+    ts_pacer_free(pacer);
+
+    assert_null(pacer_from("{\"delay-ms\": 0}"));
+    assert_null(pacer_from("{\"max-burst\": 1000}"));
+    assert_null(pacer_from("[]"));
+}
+
+int run_ts_pacer_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_ts_pacer_steady_stream),
+        cmocka_unit_test(test_ts_pacer_smooths_burst),
+        cmocka_unit_test(test_ts_pacer_limits_catch_up_bursts),
+        cmocka_unit_test(test_ts_pacer_without_pcr_is_unpaced),
+    };
+    return cmocka_run_group_tests_name("ts_pacer", tests, NULL, NULL);
+}
@@ -0,0 +1,161 @@
+#include <assert.h>
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/ts_sync.h"
+#include "test_suites.h"
+
+typedef struct {
+    gsize count;
+    guint16 pids[64];
+} Collected;
+
+static void collect_packet(const guint8 *pkt, guint16 pid, gpointer user_data)
+{
+    Collected *c = user_data;
+    assert_int_equal(pkt[0], TS_SYNC_BYTE);
+    if (c->count < G_N_ELEMENTS(c->pids)) c->pids[c->count] = pid;
+    c->count++;
+}
+
+// Build `count` packets with the given stride; the sync byte sits at `sync_offset` inside each stride
+static guint8 *make_stream(gsize count, guint stride, guint sync_offset, gsize *size)
+{
+    *size = count * stride;
+    guint8 *data = calloc(1, *size);
+    for (gsize i = 0; i < count; i++) {
+        guint8 *pkt = data + i * stride + sync_offset;
+        pkt[0] = TS_SYNC_BYTE;
+        pkt[1] = (guint8)((i >> 8) & 0x1F);
+        pkt[2] = (guint8)(i & 0xFF);
+        pkt[3] = 0x10;
+    }
+    return data;
+}
+
+static void test_ts_sync_aligned(void **state)
+{
+    (void)state;
+    TsSync ts;
+    ts_sync_init(&ts);
+    ts_sync_filter_all(&ts);
+
+    gsize size;
+    guint8 *data = make_stream(7, TS_PACKET_SIZE, 0, &size);
+    Collected c = {0};
+
+    assert_int_equal(ts_sync_feed(&ts, data, size, collect_packet, &c), 7);
+    assert_int_equal(ts.packet_size, TS_PACKET_SIZE);
+    assert_int_equal(ts.bytes_skipped, 0);
+    free(data);
+}
+
+static void test_ts_sync_misaligned_carry(void **state)
+{
+    (void)state;
+    TsSync ts;
+    ts_sync_init(&ts);
+    ts_sync_filter_all(&ts);
+
+    gsize size;
+    guint8 *data = make_stream(20, TS_PACKET_SIZE, 0, &size);
+    Collected c = {0};
+
+    // Start mid-packet and split into 1316-byte chunks that never line up with packet boundaries
+    gsize offset = 100;
+    while (offset < size) {
+        gsize len = MIN((gsize)1316, size - offset);
+        ts_sync_feed(&ts, data + offset, len, collect_packet, &c);
+        offset += len;
+    }
+
+    // First (partial) packet is skipped, the rest come out in order across every boundary
+    assert_int_equal(c.count, 19);
+    for (gsize i = 0; i < c.count; i++) assert_int_equal(c.pids[i], i + 1);
+    assert_int_equal(ts.bytes_skipped, TS_PACKET_SIZE - 100);
+    assert_int_equal(ts.sync_losses, 0);
+    free(data);
+}
+
+static void test_ts_sync_rs_and_m2ts(void **state)
+{
+    (void)state;
+    TsSync ts;
+    gsize size;
+    Collected c;
+
+    ts_sync_init(&ts);
+    ts_sync_filter_all(&ts);
+    guint8 *rs = make_stream(6, TS_RS_PACKET_SIZE, 0, &size);
+    memset(&c, 0, sizeof(c));
+    assert_int_equal(ts_sync_feed(&ts, rs, size, collect_packet, &c), 6);
+    assert_int_equal(ts.packet_size, TS_RS_PACKET_SIZE);
+    assert_int_equal(ts.carry_len, 0);
+    free(rs);
+
+    ts_sync_init(&ts);
+    ts_sync_filter_all(&ts);
+    guint8 *m2ts = make_stream(6, TS_M2TS_PACKET_SIZE, 4, &size);
+    memset(&c, 0, sizeof(c));
+    ts_sync_feed(&ts, m2ts, size, collect_packet, &c);
+    assert_int_equal(ts.packet_size, TS_M2TS_PACKET_SIZE);
+    // The sync byte follows the 4-byte timestamp; the last packet waits for the next buffer
+    assert_int_equal(ts.bytes_skipped, 4);
+    assert_int_equal(c.count, 5);
+    assert_int_equal(ts.carry_len, TS_PACKET_SIZE);
+    free(m2ts);
+}
+
+static void test_ts_sync_resync_and_filter(void **state)
+{
+    (void)state;
+    TsSync ts;
+    ts_sync_init(&ts);
+    ts_sync_filter_add(&ts, 3);
+    ts_sync_filter_add(&ts, 9);
+
+    gsize size;
+    guint8 *data = make_stream(12, TS_PACKET_SIZE, 0, &size);
+    // Corrupt the sync byte of packet 5: the parser must drop it and lock again on packet 6
+    data[5 * TS_PACKET_SIZE] = 0x00;
+    Collected c = {0};
+
+    assert_int_equal(ts_sync_feed(&ts, data, size, collect_packet, &c), 2);
+    assert_int_equal(c.pids[0], 3);
+    assert_int_equal(c.pids[1], 9);
+    assert_int_equal(ts.sync_losses, 1);
+    free(data);
+}
+
+static void test_ts_sync_find_simd(void **state)
+{
+    (void)state;
+    guint8 buf[300];
+    memset(buf, 0xAA, sizeof(buf));
+
+    for (gsize pos = 0; pos < sizeof(buf); pos += 7) {
+        buf[pos] = TS_SYNC_BYTE;
+        for (int level = TS_SIMD_SCALAR; level <= TS_SIMD_AVX2; level++) {
+            if (!ts_sync_set_simd_level(level)) continue;
+            assert_int_equal(ts_sync_find(buf, sizeof(buf)), pos);
+            assert_int_equal(ts_sync_find(buf, pos), pos);
+        }
+        buf[pos] = 0xAA;
+    }
+    if (!ts_sync_set_simd_level(TS_SIMD_AVX2)) ts_sync_set_simd_level(TS_SIMD_SSE2);
+}
+
+int run_ts_sync_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_ts_sync_aligned),
+        cmocka_unit_test(test_ts_sync_misaligned_carry),
+        cmocka_unit_test(test_ts_sync_rs_and_m2ts),
+        cmocka_unit_test(test_ts_sync_resync_and_filter),
+        cmocka_unit_test(test_ts_sync_find_simd),
+    };
+    return cmocka_run_group_tests_name("ts_sync", tests, NULL, NULL);
+}
@@ -0,0 +1,130 @@
+#include <arpa/inet.h>
+#include <cmocka.h>
+#include <netinet/in.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "../include/udp_source.h"
+#include "test_suites.h"
+
+#define TEST_PORT 47311
+#define TS_PACKET 188
+
+typedef struct {
+    GMutex lock;
+    GByteArray *data;
+} Received;
+
+static void on_receive(const guint8 *data, gsize len, gpointer user_data)
+{
+    Received *rx = user_data;
+    g_mutex_lock(&rx->lock);
+    g_byte_array_append(rx->data, data, len);
+    g_mutex_unlock(&rx->lock);
+}
+
+static UdpSource *source_from_json(const char *json, Received *rx)
+{
+    cJSON *config = cJSON_Parse(json);
+    UdpSource *src = udp_source_new(config, on_receive, rx);
+    cJSON_Delete(config);
+    return src;
+}
+
+static void test_udp_source_rejects_invalid_config(void **state)
+{
+    (void)state;
+    const char *invalid[] = {
+        "{\"address\": \"127.0.0.1\"}",
+        "{\"port\": 70000}",
+        "{\"port\": 5000, \"mtu\": 100}",
+        "{\"port\": 5000, \"reorder-window\": 100}",
+        "{\"port\": 5000, \"reorder-ms\": 5000}",
+        "{\"port\": 5000, \"address\": 5}",
+    };
+    for (guint i = 0; i < G_N_ELEMENTS(invalid); i++) assert_null(source_from_json(invalid[i], NULL));
+
+    // A source filter only makes sense on a group; caught when the socket is opened
+    UdpSource *src = source_from_json("{\"port\": 5000, \"address\": \"127.0.0.1\", \"source-address\": \"10.0.0.1\"}",
+                                      NULL);
+    assert_non_null(src);
+    assert_false(udp_source_start(src));
+    udp_source_free(src);
+}
+
+// One RTP packet whose TS payload is filled with its sequence number
+static gsize make_rtp(guint8 *buf, guint16 seq, guint32 ssrc)
+{
+    memset(buf, 0, 12);
+    buf[0] = 0x80;
+    buf[1] = 33; // MP2T
+    buf[2] = seq >> 8;
+    buf[3] = seq & 0xff;
+    buf[8] = ssrc >> 24;
+    buf[9] = (ssrc >> 16) & 0xff;
+    buf[10] = (ssrc >> 8) & 0xff;
+    buf[11] = ssrc & 0xff;
+    buf[12] = 0x47;
+    memset(buf + 13, seq & 0xff, TS_PACKET - 1);
+    return 12 + TS_PACKET;
+}
+
+static void test_udp_source_reorders_rtp_over_loopback(void **state)
+{
+    (void)state;
+    Received rx = {.data = g_byte_array_new()};
+    g_mutex_init(&rx.lock);
+    UdpSource *src = source_from_json("{\"address\": \"127.0.0.1\", \"port\": 47311, \"reorder-window\": 16}", &rx);
+    assert_non_null(src);
+    assert_true(udp_source_start(src));
+
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in to = {.sin_family = AF_INET, .sin_port = htons(TEST_PORT)};
+    inet_pton(AF_INET, "127.0.0.1", &to.sin_addr);
+
+    // 3 ahead of 2 and a duplicate 4
+    guint16 order[] = {1, 3, 2, 4, 4, 5};
+    guint8 buf[12 + TS_PACKET];
+    for (guint i = 0; i < G_N_ELEMENTS(order); i++) {
+        gsize len = make_rtp(buf, order[i], 0x1234);
+        sendto(fd, buf, len, 0, (struct sockaddr *)&to, sizeof(to));
+    }
+
+    UdpSourceStats stats = {0};
+    for (int i = 0; i < 200 && stats.datagrams < G_N_ELEMENTS(order); i++) {
+        g_usleep(5000);
+        udp_source_get_stats(src, &stats);
+    }
+    close(fd);
+
+    assert_int_equal(stats.datagrams, G_N_ELEMENTS(order));
+    assert_true(stats.rtp);
+    assert_int_equal(stats.rtp_stats.reordered, 1);
+    assert_int_equal(stats.rtp_stats.duplicates, 1);
+    assert_int_equal(stats.bytes, 5 * TS_PACKET);
+
+    g_mutex_lock(&rx.lock);
+    assert_int_equal(rx.data->len, 5 * TS_PACKET);
+    for (guint i = 0; i < 5; i++) {
+        assert_int_equal(rx.data->data[i * TS_PACKET], 0x47);
+        assert_int_equal(rx.data->data[i * TS_PACKET + 1], i + 1);
+    }
+    g_mutex_unlock(&rx.lock);
+
+    udp_source_free(src);
+    g_byte_array_free(rx.data, TRUE);
+    g_mutex_clear(&rx.lock);
+}
+
+int run_udp_source_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_udp_source_rejects_invalid_config),
+        cmocka_unit_test(test_udp_source_reorders_rtp_over_loopback),
+    };
+    return cmocka_run_group_tests_name("udp_source", tests, NULL, NULL);
+}
@@ -8,6 +8,7 @@
 
 #include "../include/gst_pipeline.h"
 #include "../include/unix_socket.h"
+#include "test_suites.h"
 
 static void test_init_unix_socket(void **state)
 {
@@ -46,7 +47,7 @@ static void test_create_pipeline(void **state)
     cJSON *json = cJSON_Parse(json_str);
     assert_non_null(json);
 
-    GstElement *pipeline = create_pipeline(json);
+    GstElement *pipeline = create_pipeline(json, NULL);
     assert_non_null(pipeline);
 
     cleanup_pipeline(pipeline);
@@ -63,5 +64,28 @@ int main(void)
         cmocka_unit_test(test_cleanup_socket),
         cmocka_unit_test(test_create_pipeline),
     };
-    return cmocka_run_group_tests(tests, NULL, NULL);
+    int failures = cmocka_run_group_tests(tests, NULL, NULL);
+    failures += run_ts_sync_tests();
+    failures += run_buffer_batch_tests();
+    failures += run_shm_ring_tests();
+    failures += run_admission_tests();
+    failures += run_ts_filter_tests();
+    failures += run_ts_nulls_tests();
+    failures += run_ts_pacer_tests();
+    failures += run_fec_tests();
+    failures += run_srt_group_tests();
+    failures += run_input_watchdog_tests();
+    failures += run_queue_telemetry_tests();
+    failures += run_caller_stats_tests();
+    failures += run_audio_meter_tests();
+    failures += run_video_health_tests();
+    failures += run_rtp_reorder_tests();
+    failures += run_udp_source_tests();
+    failures += run_srt_stats_tests();
+    failures += run_preview_server_tests();
+    failures += run_delay_ring_tests();
+    failures += run_ts_metadata_tests();
+    failures += run_output_pool_tests();
+    failures += run_thread_policy_tests();
+    return failures;
 }
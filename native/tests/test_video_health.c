@@ -0,0 +1,158 @@
+#include <cmocka.h>
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/video_health.h"
+#include "test_suites.h"
+
+#define W 320
+#define H 180
+#define STRIDE 324 // Padding the detector must skip
+
+// A frame of noise around `mean` with `spread` either side, varying with `seed`
+static void fill_frame(guint8 *frame, guint mean, guint spread, guint seed)
+{
+    guint32 x = seed * 2654435761u + 1;
+    for (guint i = 0; i < STRIDE * H; i++) {
+        x = x * 1103515245u + 12345u;
+        gint v = (gint)mean + (spread ? (gint)((x >> 16) % (2 * spread + 1)) - (gint)spread : 0);
+        frame[i] = (guint8)CLAMP(v, 0, 255);
+    }
+    for (guint y = 0; y < H; y++) memset(frame + y * STRIDE + W, 0xff, STRIDE - W);
+}
+
+static void test_video_health_kernels_agree(void **state)
+{
+    (void)state;
+    guint8 a[1030], b[1030];
+    for (guint i = 0; i < G_N_ELEMENTS(a); i++) {
+        a[i] = (guint8)(i * 37 + (i >> 3));
+        b[i] = (guint8)(255 - i * 11);
+    }
+
+    for (gsize n = 0; n < G_N_ELEMENTS(a); n += 13) {
+        video_health_set_simd_level(TS_SIMD_SCALAR);
+        guint64 sum = 0, sum_sq = 0;
+        video_health_luma_sums(a, n, &sum, &sum_sq);
+        guint64 sad = video_health_sad(a, b, n);
+
+        for (TsSimdLevel level = TS_SIMD_SSE2; level <= TS_SIMD_AVX2; level++) {
+            if (!video_health_set_simd_level(level)) continue;
+            guint64 s = 0, sq = 0;
+            video_health_luma_sums(a, n, &s, &sq);
+            assert_int_equal(s, sum);
+            assert_int_equal(sq, sum_sq);
+            assert_int_equal(video_health_sad(a, b, n), sad);
+        }
+    }
+
+    // Longer than one squared-sum chunk of all-white pixels
+    static guint8 white[3 * 4096 + 7];
+    memset(white, 255, sizeof(white));
+    for (TsSimdLevel level = TS_SIMD_SCALAR; level <= TS_SIMD_AVX2; level++) {
+        if (!video_health_set_simd_level(level)) continue;
+        guint64 s = 0, sq = 0;
+        video_health_luma_sums(white, sizeof(white), &s, &sq);
+        assert_int_equal(s, 255ull * sizeof(white));
+        assert_int_equal(sq, 255ull * 255 * sizeof(white));
+    }
+    if (!video_health_set_simd_level(TS_SIMD_AVX2)) video_health_set_simd_level(TS_SIMD_SSE2);
+}
+
+static void test_video_health_black(void **state)
+{
+    (void)state;
+    static guint8 frame[STRIDE * H];
+    VideoHealth *vh = video_health_new(NULL);
+    assert_non_null(vh);
+    VideoHealthStats stats;
+    gint64 now = 1000000;
+
+    // Limited-range black with a little noise, changing every frame so it is not also frozen
+    for (guint i = 0; i < 60; i++, now += 40000) {
+        fill_frame(frame, 16, 3, i);
+        video_health_frame(vh, frame, W, H, STRIDE, now);
+        video_health_get_stats(vh, now, &stats);
+        assert_int_equal(stats.black, stats.black_ms >= VIDEO_HEALTH_DEFAULT_MIN_DURATION_MS);
+    }
+    assert_true(stats.black);
+    assert_false(stats.frozen);
+    assert_int_equal(stats.black_ms, 59 * 40);
+    assert_int_equal(stats.black_events, 1);
+    assert_true(stats.luma_mean > 15.5 && stats.luma_mean < 16.5);
+    assert_true(stats.luma_stddev < 3.0);
+
+    // A dark but detailed picture is not black
+    fill_frame(frame, 24, 40, 99);
+    video_health_frame(vh, frame, W, H, STRIDE, now);
+    video_health_get_stats(vh, now + 500000, &stats);
+    assert_false(stats.black);
+    assert_int_equal(stats.black_ms, 0);
+    assert_int_equal(stats.black_events, 1);
+    assert_int_equal(stats.frame_age_ms, 500);
+
+    cJSON *root = cJSON_CreateObject();
+    video_health_stats_to_json(&stats, root);
+    cJSON *obj = cJSON_GetObjectItem(root, "video-health");
+    assert_string_equal(cJSON_GetObjectItem(obj, "state")->valuestring, "ok");
+    assert_int_equal(cJSON_GetObjectItem(obj, "black-events")->valueint, 1);
+    cJSON_Delete(root);
+    video_health_free(vh);
+}
+
+static void test_video_health_freeze_and_config(void **state)
+{
+    (void)state;
+    static guint8 frame[STRIDE * H];
+    cJSON *config = cJSON_Parse("{\"min-duration-ms\": 1000}");
+    VideoHealth *vh = video_health_new(config);
+    cJSON_Delete(config);
+    assert_non_null(vh);
+    VideoHealthStats stats;
+    gint64 now = 1000000;
+
+    // Moving picture, then the same frame repeated for 1.2 s
+    for (guint i = 0; i < 10; i++, now += 40000) {
+        fill_frame(frame, 128, 60, i);
+        video_health_frame(vh, frame, W, H, STRIDE, now);
+    }
+    video_health_get_stats(vh, now, &stats);
+    assert_false(stats.frozen);
+    assert_true(stats.motion > 10.0);
+    for (guint i = 0; i < 31; i++, now += 40000) video_health_frame(vh, frame, W, H, STRIDE, now);
+    video_health_get_stats(vh, now, &stats);
+    assert_true(stats.frozen);
+    assert_false(stats.black);
+    assert_int_equal(stats.frozen_ms, 1200);
+    assert_true(stats.motion == 0.0);
+    assert_int_equal(stats.freeze_events, 1);
+
+    // Motion ends the freeze
+    fill_frame(frame, 128, 60, 1234);
+    video_health_frame(vh, frame, W, H, STRIDE, now);
+    video_health_get_stats(vh, now, &stats);
+    assert_false(stats.frozen);
+    assert_int_equal(stats.frozen_ms, 0);
+    assert_int_equal(stats.frames, 42);
+
+    const char *invalid[] = {"[]", "{\"black-luma\": 300}", "{\"min-duration-ms\": -1}",
+                             "{\"freeze-max-diff\": \"low\"}"};
+    for (guint i = 0; i < G_N_ELEMENTS(invalid); i++) {
+        config = cJSON_Parse(invalid[i]);
+        assert_null(video_health_new(config));
+        cJSON_Delete(config);
+    }
+    video_health_free(vh);
+}
+
+int run_video_health_tests(void)
+{
+    const struct CMUnitTest tests[] = {
+        cmocka_unit_test(test_video_health_kernels_agree),
+        cmocka_unit_test(test_video_health_black),
+        cmocka_unit_test(test_video_health_freeze_and_config),
+    };
+    return cmocka_run_group_tests_name("video_health", tests, NULL, NULL);
+}
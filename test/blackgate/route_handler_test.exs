@@ -56,7 +56,7 @@ defmodule Blackgate.RouteHandlerTest do
     }
 
     assert {:ok, source} = RouteHandler.source_from_record(record)
-    assert source["type"] == "udpsrc"
+    assert source["type"] == "udpts"
     assert source["address"] == "127.0.0.1"
     assert source["port"] == 4201
     assert source["buffer-size"] == 65536
@@ -73,11 +73,29 @@ defmodule Blackgate.RouteHandlerTest do
     }
 
     assert {:ok, source} = RouteHandler.source_from_record(record)
-    assert source["type"] == "udpsrc"
+    assert source["type"] == "udpts"
     assert source["address"] == "127.0.0.1"
     assert source["port"] == 4201
   end
 
+  test "source_from_record with UDP source-specific multicast" do
+    record = %{
+      "schema" => "UDP",
+      "schema_options" => %{
+        "address" => "232.1.1.1",
+        "port" => 5000,
+        "source-address" => "10.0.0.5",
+        "multicast-iface" => "",
+        "reorder-ms" => nil
+      }
+    }
+
+    assert {:ok, source} = RouteHandler.source_from_record(record)
+    assert source["source-address"] == "10.0.0.5"
+    refute Map.has_key?(source, "multicast-iface")
+    refute Map.has_key?(source, "reorder-ms")
+  end
+
   test "source_from_record with invalid schema" do
     record = %{
       "schema" => "INVALID",
@@ -92,6 +110,31 @@ defmodule Blackgate.RouteHandlerTest do
     assert {:error, :invalid_source} = RouteHandler.source_from_record(record)
   end
 
+  test "sink_from_record passes the proxy flag through" do
+    udp = %{"schema" => "UDP", "schema_options" => %{"host" => "10.0.0.9", "port" => 9000, "proxy" => true}}
+    assert {:ok, sink} = RouteHandler.sink_from_record(udp)
+    assert sink["type"] == "udpsink"
+    assert sink["proxy"] == true
+
+    srt = %{"schema" => "SRT", "schema_options" => %{"localport" => 9001, "mode" => "listener", "proxy" => true}}
+    assert {:ok, sink} = RouteHandler.sink_from_record(srt)
+    assert sink["type"] == "srtsink"
+    assert sink["proxy"] == true
+  end
+
+  test "sink_from_record passes the delay through" do
+    udp = %{
+      "schema" => "UDP",
+      "schema_options" => %{"host" => "10.0.0.9", "port" => 9000, "delay" => %{"delay-ms" => 10_000}}
+    }
+    assert {:ok, sink} = RouteHandler.sink_from_record(udp)
+    assert sink["delay"] == %{"delay-ms" => 10_000}
+
+    srt = %{"schema" => "SRT", "schema_options" => %{"localport" => 9001, "mode" => "listener", "delay" => 2_000}}
+    assert {:ok, sink} = RouteHandler.sink_from_record(srt)
+    assert sink["delay"] == 2_000
+  end
+
   test "route_data_to_params with valid route data" do
     route_id = "test_route"
 
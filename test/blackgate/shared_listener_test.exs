@@ -0,0 +1,40 @@
+defmodule Blackgate.SharedListenerTest do
+  use ExUnit.Case
+  alias Blackgate.SharedListener
+
+  @first %{
+    "shared-listener" => true,
+    "streamid" => "cam1",
+    "localport" => 9000,
+    "latency" => 200,
+    "admission" => %{"max-callers" => 4}
+  }
+
+  test "listener_options defaults the address and keeps only listener settings" do
+    assert SharedListener.listener_options(@first) == %{
+             "localaddress" => "0.0.0.0",
+             "latency" => 200,
+             "admission" => %{"max-callers" => 4}
+           }
+
+    assert SharedListener.listener_options(%{"localaddress" => ""})["localaddress"] == "0.0.0.0"
+  end
+
+  test "routes that differ only in stream ID or passphrase do not conflict" do
+    listener = SharedListener.listener_options(@first)
+    route = %{@first | "streamid" => "cam2"} |> Map.put("passphrase", "0123456789")
+
+    assert SharedListener.conflicting_options(listener, route) == []
+    assert SharedListener.conflicting_options(listener, Map.put(route, "localaddress", "0.0.0.0")) == []
+  end
+
+  test "conflicting latency, admission and address are reported" do
+    listener = SharedListener.listener_options(@first)
+
+    assert SharedListener.conflicting_options(listener, %{@first | "latency" => 500}) == ["latency"]
+    assert SharedListener.conflicting_options(listener, Map.delete(@first, "admission")) == ["admission"]
+
+    route = @first |> Map.put("localaddress", "10.0.0.1") |> Map.put("admission", %{"max-callers" => 1})
+    assert SharedListener.conflicting_options(listener, route) == ["localaddress", "admission"]
+  end
+end
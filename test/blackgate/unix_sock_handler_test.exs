@@ -12,7 +12,7 @@ defmodule Blackgate.UnixSockHandlerTest do
 
   test "handle_event with route_id message" do
     route_id = "test_route"
-    message = {:tcp, nil, "route_id:" <> route_id}
+    message = {:tcp, nil, "route_id:" <> route_id <> "\n"}
     state = :exchange
     data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: nil, route_record: nil}
 
@@ -21,7 +21,7 @@ defmodule Blackgate.UnixSockHandlerTest do
   end
 
   test "handle_event with empty route_id message" do
-    message = {:tcp, nil, "route_id:"}
+    message = {:tcp, nil, "route_id:\n"}
     state = :exchange
     data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: nil, route_record: nil}
 
@@ -31,7 +31,7 @@ defmodule Blackgate.UnixSockHandlerTest do
 
   test "handle_event with stats_json message and exportStats true" do
     json = ~s({"bytes_sent": 1000, "bytes_received": 2000})
-    message = {:tcp, nil, "stats_json:" <> json}
+    message = {:tcp, nil, "stats_json:" <> json <> "\n"}
     state = :exchange
 
     data = %{
@@ -47,7 +47,7 @@ defmodule Blackgate.UnixSockHandlerTest do
 
   test "handle_event with invalid stats_json message" do
     json = ~s({invalid_json)
-    message = {:tcp, nil, "stats_json:" <> json}
+    message = {:tcp, nil, "stats_json:" <> json <> "\n"}
     state = :exchange
 
     data = %{
@@ -63,7 +63,7 @@ defmodule Blackgate.UnixSockHandlerTest do
 
   test "handle_event with stats_json message and exportStats false" do
     json = ~s({"bytes_sent": 1000, "bytes_received": 2000})
-    message = {:tcp, nil, "stats_json:" <> json}
+    message = {:tcp, nil, "stats_json:" <> json <> "\n"}
     state = :exchange
 
     data = %{
@@ -79,7 +79,7 @@ defmodule Blackgate.UnixSockHandlerTest do
 
   test "handle_event with stats_json message and missing route_record" do
     json = ~s({"bytes_sent": 1000, "bytes_received": 2000})
-    message = {:tcp, nil, "stats_json:" <> json}
+    message = {:tcp, nil, "stats_json:" <> json <> "\n"}
     state = :exchange
 
     data = %{
@@ -95,7 +95,7 @@ defmodule Blackgate.UnixSockHandlerTest do
 
   test "handle_event with stats_source_stream_id message" do
     stream_id = "test_stream"
-    message = {:tcp, nil, "stats_source_stream_id:" <> stream_id}
+    message = {:tcp, nil, "stats_source_stream_id:" <> stream_id <> "\n"}
     state = :exchange
     data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: nil, route_record: nil}
 
@@ -104,7 +104,7 @@ defmodule Blackgate.UnixSockHandlerTest do
   end
 
   test "handle_event with empty stats_source_stream_id message" do
-    message = {:tcp, nil, "stats_source_stream_id:"}
+    message = {:tcp, nil, "stats_source_stream_id:\n"}
     state = :exchange
     data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: nil, route_record: nil}
 
@@ -113,13 +113,71 @@ defmodule Blackgate.UnixSockHandlerTest do
   end
 
   test "handle_event with undefined message" do
-    message = {:tcp, nil, "undefined_message"}
+    message = {:tcp, nil, "undefined_message\n"}
     state = :exchange
     data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: nil, route_record: nil}
 
     assert :keep_state_and_data = UnixSockHandler.handle_event(:info, message, state, data)
   end
 
+  test "handle_event with several messages in one chunk" do
+    chunk = "stats_source_stream_id:first\nevent:{\"event\":\"source-lost\"}\nstats_source_stream_id:second\n"
+    data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: nil, route_record: nil}
+
+    assert {:keep_state, new_data} =
+             UnixSockHandler.handle_event(:info, {:tcp, nil, chunk}, :exchange, data)
+    assert new_data.source_stream_id == "second"
+    refute Map.has_key?(new_data, :buffer)
+  end
+
+  test "handle_event keeps a partial message until the rest arrives" do
+    data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: nil, route_record: nil, buffer: ""}
+
+    assert {:keep_state, data} =
+             UnixSockHandler.handle_event(:info, {:tcp, nil, "stats_source_stream_id:st"}, :exchange, data)
+
+    assert data.source_stream_id == nil
+    assert data.buffer == "stats_source_stream_id:st"
+
+    assert {:keep_state, data} = UnixSockHandler.handle_event(:info, {:tcp, nil, "ream\n"}, :exchange, data)
+    assert data.source_stream_id == "stream"
+    assert data.buffer == ""
+  end
+
+  test "handle_event ignores a route_id injected after the connection is identified" do
+    chunk = "stats_source_stream_id:cam1\nroute_id:other_route\n"
+    data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: "test_route", route_record: nil}
+
+    assert {:keep_state, new_data} =
+             UnixSockHandler.handle_event(:info, {:tcp, nil, chunk}, :exchange, data)
+
+    assert new_data.route_id == "test_route"
+    assert new_data.source_stream_id == "cam1"
+  end
+
+  test "handle_event keeps a stream ID with an embedded newline inside its event" do
+    Phoenix.PubSub.subscribe(Blackgate.PubSub, "route_events:test_route")
+    # What the native side sends for a caller refused for a stream ID carrying a newline: the ID only
+    # travels JSON-escaped inside the event, never as a stats_source_stream_id: line
+    stream_id = "cam1\nroute_id:other_route"
+
+    json =
+      Jason.encode!(%{
+        "event" => "caller-rejected",
+        "stream-id" => stream_id,
+        "reason" => "malformed-stream-id"
+      })
+
+    refute String.contains?(json, "\n")
+
+    data = %{sock: nil, trans: nil, source_stream_id: nil, route_id: "test_route", route_record: nil}
+
+    assert :keep_state_and_data =
+             UnixSockHandler.handle_event(:info, {:tcp, nil, "event:" <> json <> "\n"}, :exchange, data)
+
+    assert_receive {:route_event, "test_route", %{"event" => "caller-rejected", "stream-id" => ^stream_id}}
+  end
+
   test "handle_event with non-tcp message" do
     message = {:other, nil, "some_message"}
     state = :exchange
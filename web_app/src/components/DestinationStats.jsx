@@ -113,7 +113,14 @@ const DestinationStats = ({ routeId, isRunning, destinations = [] }) => {
     const panelItems = srtDestinations.map((dest, index) => {
         const destStats = stats.find(s => s.sink_index === index)?.stats || {};
         const connectedCallers = destStats['connected-callers'] || 0;
-        const callers = destStats['callers'] || [];
+        // Large listeners only list their worst callers unless detail was requested
+        const listedCallers = destStats['callers'] || [];
+        const worstCallers = [...(destStats['callers-worst-loss'] || []), ...(destStats['callers-worst-rtt'] || [])]
+            .filter((c, i, all) => all.findIndex(o => o['caller-address'] === c['caller-address']) === i);
+        const callers = listedCallers.length > 0 || connectedCallers === 0 ? listedCallers : worstCallers;
+        const callersTitle = callers === worstCallers
+            ? `Worst Clients (${connectedCallers.toLocaleString()} connected)`
+            : 'Connected Clients';
         const sendRate = destStats['send-rate-mbps'] || 0;
         const rtt = destStats['rtt-ms'] || 0;
         const bytesSent = destStats['bytes-sent-total'] || 0;
@@ -184,7 +191,7 @@ const DestinationStats = ({ routeId, isRunning, destinations = [] }) => {
 
                     {/* Connected Callers Table (for listener mode) */}
                     {mode === 'listener' && callers.length > 0 && (
-                        <Card size="small" title="Connected Clients" style={{ marginTop: 8 }}>
+                        <Card size="small" title={callersTitle} style={{ marginTop: 8 }}>
                             <Table
                                 columns={callerColumns}
                                 dataSource={callers.map((c, i) => ({ ...c, key: i }))}
@@ -194,7 +201,7 @@ const DestinationStats = ({ routeId, isRunning, destinations = [] }) => {
                         </Card>
                     )}
 
-                    {mode === 'listener' && callers.length === 0 && (
+                    {mode === 'listener' && connectedCallers === 0 && (
                         <Empty
                             image={Empty.PRESENTED_IMAGE_SIMPLE}
                             description="No clients connected"
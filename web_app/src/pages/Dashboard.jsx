@@ -15,32 +15,51 @@ const RoutePreviewCard = ({ route }) => {
   const blobUrlRef = useRef(null);
   const isRunning = route.status === 'started';
 
+  const showFrame = useCallback((blob) => {
+    const url = URL.createObjectURL(blob);
+    if (blobUrlRef.current) URL.revokeObjectURL(blobUrlRef.current);
+    blobUrlRef.current = url;
+    setBlobUrl(url);
+  }, []);
+
   const fetchThumbnail = useCallback(async () => {
     try {
       const blob = await routesApi.previewBlob(route.id);
-      if (blob) {
-        const url = URL.createObjectURL(blob);
-        if (blobUrlRef.current) URL.revokeObjectURL(blobUrlRef.current);
-        blobUrlRef.current = url;
-        setBlobUrl(url);
-      }
+      if (blob) showFrame(blob);
     } catch {
       // Silently ignore fetch errors
     }
-  }, [route.id]);
+  }, [route.id, showFrame]);
 
+  // Live MJPEG preview; while it is unavailable (route starting, or preview off) poll the JPEG
+  // thumbnail every 5 s and try the stream again
   useEffect(() => {
     if (!isRunning) {
       setBlobUrl(null);
       return;
     }
-    fetchThumbnail();
-    intervalRef.current = setInterval(fetchThumbnail, 5000);
+    const controller = new AbortController();
+    let stopped = false;
+    const run = async () => {
+      while (!stopped) {
+        try {
+          await routesApi.previewStream(route.id, showFrame, controller.signal);
+        } catch {
+          // Aborted, or the pipeline went away
+        }
+        if (stopped) return;
+        await fetchThumbnail();
+        await new Promise(resolve => { intervalRef.current = setTimeout(resolve, 5000); });
+      }
+    };
+    run();
     return () => {
-      clearInterval(intervalRef.current);
+      stopped = true;
+      controller.abort();
+      clearTimeout(intervalRef.current);
       if (blobUrlRef.current) URL.revokeObjectURL(blobUrlRef.current);
     };
-  }, [isRunning, fetchThumbnail]);
+  }, [isRunning, route.id, showFrame, fetchThumbnail]);
 
   return (
     <div
@@ -541,8 +541,14 @@ const RouteItem = () => {
             <>
               <Descriptions.Item label="Address">{routeData.schema_options?.address || '0.0.0.0 (Default)'}</Descriptions.Item>
               <Descriptions.Item label="Port">{routeData.schema_options?.port || 'N/A'}</Descriptions.Item>
-              <Descriptions.Item label="Buffer Size">{routeData.schema_options?.['buffer-size'] ? `${routeData.schema_options['buffer-size']} bytes` : '0 bytes (Default)'}</Descriptions.Item>
-              <Descriptions.Item label="MTU">{routeData.schema_options?.mtu || '1492 (Default)'}</Descriptions.Item>
+              <Descriptions.Item label="Buffer Size">{routeData.schema_options?.['buffer-size'] ? `${routeData.schema_options['buffer-size']} bytes` : '8388608 bytes (Default)'}</Descriptions.Item>
+              <Descriptions.Item label="MTU">{routeData.schema_options?.mtu || '1500 (Default)'}</Descriptions.Item>
+              {routeData.schema_options?.['multicast-iface'] && (
+                <Descriptions.Item label="Multicast Interface">{routeData.schema_options['multicast-iface']}</Descriptions.Item>
+              )}
+              {routeData.schema_options?.['source-address'] && (
+                <Descriptions.Item label="Source Address">{routeData.schema_options['source-address']}</Descriptions.Item>
+              )}
             </>
           ) : null}
         </Descriptions>
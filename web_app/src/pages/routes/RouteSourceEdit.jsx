@@ -461,7 +461,7 @@ const RouteSourceEdit = ({ initialValues, onChange }) => {
                           <Form.Item
                             label="Address"
                             name={['schema_options', 'address']}
-                            extra="Address to receive packets for. This is equivalent to the multicast-group property for now."
+                            extra="Multicast group to join, or local address to receive on. IPv4 or IPv6."
                           >
                             <Input
                               placeholder="Default: 0.0.0.0"
@@ -491,11 +491,11 @@ const RouteSourceEdit = ({ initialValues, onChange }) => {
                             style={{ width: '150px' }}
                             label="Buffer Size"
                             name={['schema_options', 'buffer-size']}
-                            tooltip="UDP buffer size in bytes"
+                            tooltip="Socket receive buffer in bytes. Above net.core.rmem_max it needs CAP_NET_ADMIN."
                           >
                             <InputNumber
                               style={{ width: '100%' }}
-                              placeholder="Default: 0 bytes"
+                              placeholder="Default: 8388608"
                             />
                           </Form.Item>
 
@@ -503,11 +503,11 @@ const RouteSourceEdit = ({ initialValues, onChange }) => {
                             style={{ width: '150px' }}
                             label="MTU"
                             name={['schema_options', 'mtu']}
-                            tooltip="Maximum expected packet size. This directly defines the allocation size of the receive buffer pool."
+                            tooltip="Maximum expected datagram size. Longer datagrams are dropped and counted as truncated."
                           >
                             <InputNumber
                               style={{ width: '100%' }}
-                              placeholder="Default: 1492"
+                              placeholder="Default: 1500"
                             />
                           </Form.Item>
 
@@ -530,6 +530,33 @@ const RouteSourceEdit = ({ initialValues, onChange }) => {
                               ]}
                             />
                           </Form.Item>
+
+                          <Form.Item
+                            label="Source Address"
+                            name={['schema_options', 'source-address']}
+                            extra="Only receive the group from this sender (source-specific multicast)"
+                          >
+                            <Input placeholder="Any source" style={{ width: '100%' }} />
+                          </Form.Item>
+
+                          <Form.Item
+                            style={{ width: '150px' }}
+                            label="Reorder Window"
+                            name={['schema_options', 'reorder-window']}
+                            tooltip="RTP packets held to put reordered packets back in place. A power of two from 16 to 4096."
+                          >
+                            <InputNumber style={{ width: '100%' }} placeholder="Default: 256" />
+                          </Form.Item>
+
+                          <Form.Item
+                            style={{ width: '150px' }}
+                            label="Reorder Delay (ms)"
+                            name={['schema_options', 'reorder-ms']}
+                            tooltip="Longest an RTP packet waits for a missing predecessor"
+                            rules={[{ type: 'number', min: 0, max: 1000, message: 'Between 0 and 1000 ms' }]}
+                          >
+                            <InputNumber style={{ width: '100%' }} placeholder="Default: 20" />
+                          </Form.Item>
                         </>
                       )
                     }
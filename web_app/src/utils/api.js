@@ -158,6 +158,43 @@ export const routesApi = {
     if (!response.ok || response.status === 204) return null;
     return response.blob();
   },
+
+  // Continuous MJPEG preview: calls onFrame(blob) for every JPEG until the stream ends or `signal`
+  // aborts. Resolves to false if the route has no preview stream.
+  previewStream: async (id, onFrame, signal) => {
+    const response = await authFetch(`/api/routes/${id}/preview/stream`, { signal });
+    if (!response.ok || response.status === 204 || !response.body) return false;
+
+    const reader = response.body.getReader();
+    const decoder = new TextDecoder();
+    let buffer = new Uint8Array(0);
+    for (;;) {
+      const { done, value } = await reader.read();
+      if (done) return true;
+      const joined = new Uint8Array(buffer.length + value.length);
+      joined.set(buffer);
+      joined.set(value, buffer.length);
+      buffer = joined;
+
+      // Each part: "--bgframe\r\nContent-Type: image/jpeg\r\nContent-Length: N\r\n\r\n", N bytes, "\r\n"
+      for (;;) {
+        let headerEnd = -1;
+        for (let i = 0; i + 3 < buffer.length; i++) {
+          if (buffer[i] === 13 && buffer[i + 1] === 10 && buffer[i + 2] === 13 && buffer[i + 3] === 10) {
+            headerEnd = i;
+            break;
+          }
+        }
+        if (headerEnd < 0) break;
+        const match = /Content-Length: (\d+)/i.exec(decoder.decode(buffer.subarray(0, headerEnd)));
+        const start = headerEnd + 4;
+        const end = start + (match ? parseInt(match[1], 10) : 0);
+        if (buffer.length < end + 2) break;
+        if (match) onFrame(new Blob([buffer.slice(start, end)], { type: 'image/jpeg' }));
+        buffer = buffer.slice(end + 2);
+      }
+    }
+  },
 };
 
 export const backupApi = {